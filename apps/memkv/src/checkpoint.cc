@@ -0,0 +1,252 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "checkpoint.h"
+#include "logging.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <consensus/base/coding.h>
+#include <consensus/base/crc32c.h>
+
+namespace memkv {
+
+static const uint32_t kCheckpointMagic = 0x4d4b4350;  // "MKCP"
+static const size_t kHeaderSize = 4 + 8;
+static const size_t kFooterSize = 8 + 4;
+static const size_t kFlushBytes = 1024 * 1024;
+
+static const char kSuffix[] = ".ckpt";
+static const size_t kSuffixLen = sizeof(kSuffix) - 1;
+
+static Status fromConsensus(const consensus::Status &s) {
+  return Status::Make(Error::IOError, s.ToString());
+}
+
+static std::string checkpointName(const std::string &dir, uint64_t index) {
+  return fmt::format("{}/{:020}{}", dir, index, kSuffix);
+}
+
+// Returns the indexes of the checkpoints in `dir`, in ascending order. The other files,
+// e.g. the unfinished checkpoints, are appended to `others` if it's not null.
+static Status listCheckpoints(const std::string &dir, std::vector<uint64_t> *indexes,
+                              std::vector<std::string> *others) {
+  std::vector<std::string> children;
+  consensus::Status s = consensus::Env::Default()->GetChildren(dir, &children);
+  if (!s.IsOK()) {
+    return fromConsensus(s);
+  }
+  for (const std::string &name : children) {
+    if (name == "." || name == "..") {
+      continue;
+    }
+    bool isCheckpoint = name.size() == 20 + kSuffixLen &&
+                        name.compare(20, kSuffixLen, kSuffix) == 0 &&
+                        std::all_of(name.begin(), name.begin() + 20, ::isdigit);
+    if (isCheckpoint) {
+      indexes->push_back(std::stoull(name.substr(0, 20)));
+    } else if (others) {
+      others->push_back(dir + "/" + name);
+    }
+  }
+  std::sort(indexes->begin(), indexes->end());
+  return Status::OK();
+}
+
+CheckpointBuilder::CheckpointBuilder(const std::string &dir, uint64_t index)
+    : dir_(dir), index_(index) {}
+
+Status CheckpointBuilder::Begin(const std::string &dir, uint64_t index,
+                                std::unique_ptr<CheckpointBuilder> *builder) {
+  std::unique_ptr<CheckpointBuilder> b(new CheckpointBuilder(dir, index));
+  auto wf = consensus::Env::Default()->NewWritableFile(checkpointName(dir, index) + ".tmp");
+  if (!wf.IsOK()) {
+    return fromConsensus(wf.GetStatus());
+  }
+  b->file_.reset(wf.GetValue());
+
+  consensus::PutFixed32(&b->buf_, kCheckpointMagic);
+  consensus::PutFixed64(&b->buf_, index);
+  *builder = std::move(b);
+  return Status::OK();
+}
+
+CheckpointBuilder::~CheckpointBuilder() {
+  if (file_ && !finished_) {
+    WARN_NOT_OK(file_->Close(), "CheckpointBuilder: close " + file_->filename());
+    WARN_NOT_OK(consensus::Env::Default()->DeleteFile(file_->filename()),
+                "CheckpointBuilder: delete " + file_->filename());
+  }
+}
+
+Status CheckpointBuilder::Add(const Slice &path, const Slice &value) {
+  size_t shared = 0;
+  size_t limit = std::min(lastPath_.size(), path.size());
+  while (shared < limit && lastPath_[shared] == path[shared]) {
+    shared++;
+  }
+  consensus::PutVarint32(&buf_, static_cast<uint32_t>(shared));
+  consensus::PutVarint32(&buf_, static_cast<uint32_t>(path.size() - shared));
+  buf_.append(path.data() + shared, path.size() - shared);
+  consensus::PutLengthPrefixedSlice(&buf_, value);
+
+  lastPath_.assign(path.data(), path.size());
+  count_++;
+  if (buf_.size() >= kFlushBytes) {
+    return flush();
+  }
+  return Status::OK();
+}
+
+Status CheckpointBuilder::flush() {
+  crc_ = consensus::crc32c::Extend(crc_, buf_.data(), buf_.size());
+  consensus::Status s = file_->Append(buf_);
+  buf_.clear();
+  return s.IsOK() ? Status::OK() : fromConsensus(s);
+}
+
+Status CheckpointBuilder::Finish() {
+  consensus::PutFixed64(&buf_, count_);
+  RETURN_NOT_OK(flush());
+  consensus::PutFixed32(&buf_, crc_);
+  consensus::Status s = file_->Append(buf_);
+  if (s.IsOK()) {
+    s = file_->Sync();
+  }
+  if (s.IsOK()) {
+    s = file_->Close();
+  }
+  if (!s.IsOK()) {
+    return fromConsensus(s);
+  }
+
+  consensus::Env *env = consensus::Env::Default();
+  s = env->RenameFile(file_->filename(), checkpointName(dir_, index_));
+  if (!s.IsOK()) {
+    return fromConsensus(s);
+  }
+  finished_ = true;
+
+  std::vector<uint64_t> indexes;
+  std::vector<std::string> others;
+  RETURN_NOT_OK(listCheckpoints(dir_, &indexes, &others));
+  for (size_t i = 0; i + 2 < indexes.size(); i++) {
+    others.push_back(checkpointName(dir_, indexes[i]));
+  }
+  for (const std::string &fname : others) {
+    WARN_NOT_OK(env->DeleteFile(fname), "CheckpointBuilder: delete " + fname);
+  }
+  return Status::OK();
+}
+
+Status CheckpointReader::OpenLatest(const std::string &dir,
+                                    std::unique_ptr<CheckpointReader> *reader) {
+  std::vector<uint64_t> indexes;
+  RETURN_NOT_OK(listCheckpoints(dir, &indexes, nullptr));
+  reader->reset();
+  for (auto it = indexes.rbegin(); it != indexes.rend(); ++it) {
+    std::unique_ptr<CheckpointReader> r(new CheckpointReader);
+    Status s = r->open(checkpointName(dir, *it));
+    if (s.IsOK()) {
+      *reader = std::move(r);
+      break;
+    }
+    FMT_LOG(WARNING, "skipping checkpoint {}: {}", checkpointName(dir, *it), s.ToString());
+  }
+  return Status::OK();
+}
+
+CheckpointReader::~CheckpointReader() {
+  if (data_) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+}
+
+Status CheckpointReader::open(const std::string &fname) {
+  int fd = ::open(fname.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return FMT_Status(IOError, "open {}: {}", fname, strerror(errno));
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int err = errno;
+    close(fd);
+    return FMT_Status(IOError, "stat {}: {}", fname, strerror(err));
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ < kHeaderSize + kFooterSize) {
+    close(fd);
+    return FMT_Status(IOError, "checkpoint {} is truncated [size: {}]", fname, size_);
+  }
+
+  // the pages are read once in order, and dropped after the load.
+  void *p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  int err = errno;
+  close(fd);
+  if (p == MAP_FAILED) {
+    return FMT_Status(IOError, "mmap {}: {}", fname, strerror(err));
+  }
+  data_ = static_cast<const char *>(p);
+  madvise(p, size_, MADV_SEQUENTIAL);
+
+  uint32_t crc = consensus::crc32c::Value(data_, size_ - 4);
+  if (consensus::DecodeFixed32(data_) != kCheckpointMagic ||
+      consensus::DecodeFixed32(data_ + size_ - 4) != crc) {
+    return FMT_Status(IOError, "checkpoint {} is corrupted", fname);
+  }
+  index_ = consensus::DecodeFixed64(data_ + 4);
+  count_ = consensus::DecodeFixed64(data_ + size_ - kFooterSize);
+  return Status::OK();
+}
+
+Status CheckpointReader::ForEach(
+    const std::function<Status(const Slice &path, const Slice &value)> &f) const {
+  const char *p = data_ + kHeaderSize;
+  const char *limit = data_ + size_ - kFooterSize;
+  std::string path;
+  for (uint64_t i = 0; i < count_; i++) {
+    uint32_t shared, unshared, valueLen;
+    p = consensus::GetVarint32Ptr(p, limit, &shared);
+    if (p) {
+      p = consensus::GetVarint32Ptr(p, limit, &unshared);
+    }
+    if (!p || shared > path.size() || unshared > static_cast<size_t>(limit - p)) {
+      return FMT_Status(IOError, "bad checkpoint node {} [index: {}]", i, index_);
+    }
+    path.resize(shared);
+    path.append(p, unshared);
+    p = consensus::GetVarint32Ptr(p + unshared, limit, &valueLen);
+    if (!p || valueLen > static_cast<size_t>(limit - p)) {
+      return FMT_Status(IOError, "bad checkpoint node {} [index: {}]", i, index_);
+    }
+    RETURN_NOT_OK(f(path, Slice(p, valueLen)));
+    p += valueLen;
+  }
+  if (p != limit) {
+    return FMT_Status(IOError, "bad checkpoint [index: {}]: {} bytes left", index_, limit - p);
+  }
+  return Status::OK();
+}
+
+}  // namespace memkv
@@ -0,0 +1,110 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "slice.h"
+#include "status.h"
+
+#include <consensus/base/env.h>
+
+namespace memkv {
+
+// A checkpoint is the content of a MemKvStore as of a log index, written to a file
+// named by the index in the checkpoint directory of a shard, so that a restart loads
+// it and replays only the log after it, see DBOptions::checkpoint_interval.
+//
+// Checkpoint format:
+//   header: magic index
+//           magic = fixed32, index = fixed64
+//   node:   shared unshared suffix value
+//           shared, unshared = varint32, the path shares its first `shared` bytes with
+//                                        the path of the previous node
+//           suffix = the other `unshared` bytes of the path
+//           value = varstring
+//   footer: count crc
+//           count = fixed64, the number of nodes
+//           crc = fixed32, crc32c of all the bytes before it
+//
+// The nodes are in the order of MemKvStore::Collect, a parent before its children.
+
+// CheckpointBuilder writes a checkpoint into a temporary file, which replaces the
+// older checkpoints once it's finished.
+class CheckpointBuilder {
+ public:
+  static Status Begin(const std::string &dir, uint64_t index,
+                      std::unique_ptr<CheckpointBuilder> *builder);
+
+  // Removes the temporary file unless it's finished.
+  ~CheckpointBuilder();
+
+  Status Add(const Slice &path, const Slice &value);
+
+  // Syncs the file and renames it into place. The checkpoint before it is kept, in case
+  // the new one is found corrupted, the others are deleted.
+  Status Finish();
+
+ private:
+  CheckpointBuilder(const std::string &dir, uint64_t index);
+
+  Status flush();
+
+ private:
+  const std::string dir_;
+  const uint64_t index_;
+
+  std::unique_ptr<consensus::WritableFile> file_;
+  bool finished_{false};
+
+  // the bytes not yet appended to the file.
+  std::string buf_;
+  std::string lastPath_;
+  uint64_t count_{0};
+  uint32_t crc_{0};
+};
+
+// CheckpointReader maps the latest valid checkpoint of a directory into memory.
+class CheckpointReader {
+ public:
+  // `*reader` is null if there's no checkpoint. The corrupted checkpoints are skipped.
+  static Status OpenLatest(const std::string &dir, std::unique_ptr<CheckpointReader> *reader);
+
+  ~CheckpointReader();
+
+  uint64_t Index() const {
+    return index_;
+  }
+
+  // Calls `f` on the nodes in order, until it fails.
+  Status ForEach(const std::function<Status(const Slice &path, const Slice &value)> &f) const;
+
+ private:
+  CheckpointReader() = default;
+
+  // Maps and verifies the file.
+  Status open(const std::string &fname);
+
+ private:
+  const char *data_{nullptr};
+  size_t size_{0};
+  uint64_t index_{0};
+  uint64_t count_{0};
+};
+
+}  // namespace memkv
@@ -0,0 +1,100 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <map>
+
+#include "checkpoint.h"
+#include "testing.h"
+
+using namespace memkv;
+
+class CheckpointTest : public testing::Test {
+ public:
+  CheckpointTest() : dir_("/tmp/memkv.CheckpointTest") {
+    consensus::Env::Default()->DeleteRecursively(dir_);
+    FATAL_NOT_OK(consensus::Env::Default()->CreateDirIfMissing(dir_), "create " + dir_);
+  }
+
+  ~CheckpointTest() override {
+    consensus::Env::Default()->DeleteRecursively(dir_);
+  }
+
+  void write(uint64_t index, const std::map<std::string, std::string> &nodes) {
+    std::unique_ptr<CheckpointBuilder> builder;
+    ASSERT_OK(CheckpointBuilder::Begin(dir_, index, &builder));
+    for (const auto &n : nodes) {
+      ASSERT_OK(builder->Add(n.first, n.second));
+    }
+    ASSERT_OK(builder->Finish());
+  }
+
+  void read(uint64_t *index, std::map<std::string, std::string> *nodes) {
+    std::unique_ptr<CheckpointReader> reader;
+    ASSERT_OK(CheckpointReader::OpenLatest(dir_, &reader));
+    ASSERT_TRUE(reader != nullptr);
+    *index = reader->Index();
+    ASSERT_OK(reader->ForEach([nodes](const Slice &path, const Slice &value) -> Status {
+      (*nodes)[std::string(path.data(), path.size())] = std::string(value.data(), value.size());
+      return Status::OK();
+    }));
+  }
+
+ protected:
+  std::string dir_;
+};
+
+TEST_F(CheckpointTest, WriteAndLoad) {
+  std::unique_ptr<CheckpointReader> reader;
+  ASSERT_OK(CheckpointReader::OpenLatest(dir_, &reader));
+  ASSERT_TRUE(reader == nullptr);
+
+  std::map<std::string, std::string> nodes = {
+      {"/a", ""}, {"/a/b", "1"}, {"/a/bc", std::string(1000, 'x')}, {"/b", "2"}};
+  write(10, nodes);
+
+  uint64_t index;
+  std::map<std::string, std::string> loaded;
+  read(&index, &loaded);
+  ASSERT_EQ(index, 10u);
+  ASSERT_EQ(loaded, nodes);
+}
+
+TEST_F(CheckpointTest, KeepPreviousOne) {
+  write(10, {{"/a", "1"}});
+  write(20, {{"/a", "2"}});
+  write(30, {{"/a", "3"}});
+
+  std::vector<std::string> children;
+  ASSERT_OK(consensus::Env::Default()->GetChildren(dir_, &children));
+  size_t files = 0;
+  for (const std::string &name : children) {
+    files += name != "." && name != "..";
+  }
+  ASSERT_EQ(files, 2u);
+
+  // the corrupted latest one is skipped.
+  std::unique_ptr<consensus::WritableFile> file;
+  auto wf = consensus::Env::Default()->NewWritableFile(dir_ + "/00000000000000000040.ckpt");
+  ASSERT_OK(wf);
+  file.reset(wf.GetValue());
+  ASSERT_OK(file->Append("garbage garbage garbage"));
+  ASSERT_OK(file->Close());
+
+  uint64_t index;
+  std::map<std::string, std::string> loaded;
+  read(&index, &loaded);
+  ASSERT_EQ(index, 30u);
+  ASSERT_EQ(loaded["/a"], "3");
+}
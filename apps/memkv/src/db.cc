@@ -13,18 +13,34 @@
 // limitations under the License.
 
 #include "db.h"
+#include "checkpoint.h"
 #include "logging.h"
 #include "memkv_service.h"
+#include "value_log.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <thread>
+
+#include <boost/thread/latch.hpp>
 #include <consensus/base/coding.h>
+#include <consensus/base/env.h>
+#include <consensus/base/executor_pool.h>
+#include <consensus/base/task_queue.h>
 #include <consensus/raft_task_executor.h>
+#include <consensus/raft_timer.h>
+#include <consensus/ready_flusher.h>
 #include <consensus/replicated_log.h>
+#include <consensus/state_machine.h>
 
 namespace memkv {
 
 enum OpType {
   kWrite = 1,
   kDelete = 2,
+  kBatch = 3,
 };
 
 // Log format:
@@ -32,76 +48,670 @@ enum OpType {
 //            type = 1 byte
 //            path, value = varstring
 //   - DELETE: type path
+//   - BATCH: type count op...
+//            count = fixed32
+//            op = WRITE | DELETE
 //
-static std::string LogEncode(OpType type, const Slice &path, const Slice &value) {
+static size_t opSize(OpType type, const Slice &path, const Slice &value) {
   using consensus::VarintLength;
-  using consensus::PutLengthPrefixedSlice;
 
-  std::string result;
-  result.push_back(static_cast<unsigned char>(type));
+  size_t size = 1 + VarintLength(path.size()) + path.size();
+  if (type == kWrite) {
+    size += VarintLength(value.size()) + value.size();
+  }
+  return size;
+}
+
+// Encodes the op into the opSize(type, path, value) bytes at `dst`.
+static void encodeOp(char *dst, OpType type, const Slice &path, const Slice &value) {
+  using consensus::EncodeVarint32;
+
+  *dst++ = static_cast<char>(type);
 
-  PutLengthPrefixedSlice(&result, path);
+  dst = EncodeVarint32(dst, static_cast<uint32_t>(path.size()));
+  memcpy(dst, path.data(), path.size());
   if (type == kWrite) {
-    PutLengthPrefixedSlice(&result, value);
+    dst = EncodeVarint32(dst + path.size(), static_cast<uint32_t>(value.size()));
+    memcpy(dst, value.data(), value.size());
   }
+}
+
+static void appendOp(std::string *result, OpType type, const Slice &path, const Slice &value) {
+  size_t offset = result->size();
+  result->resize(offset + opSize(type, path, value));
+  encodeOp(&(*result)[offset], type, path, value);
+}
+
+// The log is sized exactly, then moved into the proposed entry, see
+// ReplicatedLog::WriteOwned.
+static std::string LogEncode(OpType type, const Slice &path, const Slice &value) {
+  std::string result(opSize(type, path, value), '\0');
+  encodeOp(&result[0], type, path, value);
   return result;
 }
 
-class DB::Impl {
+// Returns false if `input` doesn't start with a valid WRITE or DELETE.
+static bool decodeOp(Slice *input, OpType *type, Slice *path, Slice *value) {
+  if (input->empty()) {
+    return false;
+  }
+  *type = static_cast<OpType>((*input)[0]);
+  input->remove_prefix(1);
+  if (*type != kWrite && *type != kDelete) {
+    return false;
+  }
+  return consensus::GetLengthPrefixedSlice(input, path) &&
+         (*type == kDelete || consensus::GetLengthPrefixedSlice(input, value));
+}
+
+static const size_t kBatchHeaderSize = 5;
+
+WriteBatch::WriteBatch() : rep_(kBatchHeaderSize, '\0') {
+  rep_[0] = static_cast<char>(kBatch);
+}
+
+void WriteBatch::Put(const Slice &path, const Slice &value) {
+  appendOp(&rep_, kWrite, path, value);
+  consensus::EncodeFixed32(&rep_[1], ++count_);
+}
+
+void WriteBatch::Delete(const Slice &path) {
+  appendOp(&rep_, kDelete, path, nullptr);
+  consensus::EncodeFixed32(&rep_[1], ++count_);
+}
+
+// The values in the MemKvStore are tagged, those kept in the ValueLog are replaced by
+// their pointers:
+//   - inline: tag value
+//   - pointer: tag offset size
+//              offset = fixed64, size = fixed32
+enum ValueTag {
+  kInlineValue = 0,
+  kValuePointer = 1,
+};
+
+static const size_t kValuePointerSize = 1 + 8 + 4;
+
+// Shard is a raft group serving a part of the keyspace, see DB::Impl. It applies the
+// committed logs to its MemKvStore, on every member of the cluster.
+class Shard : public consensus::StateMachine {
  public:
-  explicit Impl(consensus::ReplicatedLog *replicatedLog)
-      : kv_(new MemKvStore), log_(replicatedLog) {}
+  Shard(size_t watchEvents, size_t watchBytes)
+      : kv_(new MemKvStore), hub_(watchEvents, watchBytes) {}
+
+  // The apply thread, which takes the checkpoints, is stopped before the checkpoint
+  // thread.
+  ~Shard() {
+    log_.reset();
+  }
+
+  Status Get(const Slice &path, bool stale, butil::IOBuf *data) {
+    if (!stale) {
+      RETURN_NOT_OK(waitReadIndex());
+    }
+    RETURN_NOT_OK(readConsistent([&]() {
+      data->clear();
+      return kv_->Get(path, data);
+    }));
+
+    char tag = kInlineValue;
+    data->cut1(&tag);
+    if (tag == kInlineValue) {
+      return Status::OK();
+    }
+    std::string value;
+    RETURN_NOT_OK(readPointer(data->to_string(), &value));
+    data->clear();
+    data->append(value);
+    return Status::OK();
+  }
 
   Status Get(const Slice &path, bool stale, std::string *data) {
-    bool allowed = false;
-
-    // TODO: use read/write lock to protect `leader`, it's more efficient than using task queue.
-    uint64_t currentLeader = 0;
-    consensus::Barrier barrier;
-    log_->RaftTaskExecutorInstance()->Submit([&](yaraft::RawNode *node) {
-      currentLeader = node->LeaderHint();
-      barrier.Signal();
-    });
-    barrier.Wait();
+    butil::IOBuf buf;
+    RETURN_NOT_OK(Get(path, stale, &buf));
+    buf.copy_to(data);
+    return Status::OK();
+  }
 
-    uint64_t id = log_->Id();
-    if (currentLeader != id && !stale) {
-      return FMT_Status(ConsensusError,
-                        "read from a non-leader node, stale read not allowed [id: {}, leader: {}]",
-                        id, currentLeader);
+  Status List(const Slice &path, const ListOptions &options, bool stale,
+              std::vector<ListEntry> *entries, bool *more) {
+    if (!stale) {
+      RETURN_NOT_OK(waitReadIndex());
     }
-    return kv_->Get(path, data);
+    size_t first = entries->size();
+    RETURN_NOT_OK(readConsistent([&]() {
+      entries->resize(first);
+      return kv_->List(path, options, entries, more);
+    }));
+    if (!options.values) {
+      return Status::OK();
+    }
+    for (size_t i = first; i < entries->size(); i++) {
+      std::string &value = (*entries)[i].value;
+      if (value.empty() || value[0] == kInlineValue) {
+        value.erase(0, 1);
+        continue;
+      }
+      std::string pointer(value, 1);
+      RETURN_NOT_OK(readPointer(pointer, &value));
+    }
+    return Status::OK();
   }
 
   Status Delete(const Slice &path) {
-    std::string log = LogEncode(OpType::kDelete, path, nullptr);
+    // the errors of applying are not reported back, a missing node is detected ahead.
+    std::string data;
+    RETURN_NOT_OK(kv_->Get(path, &data));
 
-    consensus::Status s = log_->Write(log);
+    // returns once the log is applied.
+    consensus::Status s = log_->WriteOwned(LogEncode(OpType::kDelete, path, nullptr));
     if (!s.IsOK()) {
       return Status::Make(Error::ConsensusError, s.ToString());
     }
-
-    RETURN_NOT_OK(kv_->Delete(path));
     return Status::OK();
   }
 
   Status Write(const Slice &path, const Slice &value) {
-    std::string log = LogEncode(OpType::kWrite, path, value);
+    consensus::Status s = log_->WriteOwned(LogEncode(OpType::kWrite, path, value));
+    if (!s.IsOK()) {
+      return Status::Make(Error::ConsensusError, s.ToString());
+    }
+    return Status::OK();
+  }
 
-    consensus::Status s = log_->Write(log);
+  void AsyncWrite(const Slice &path, const Slice &value, std::function<void(const Status &)> done) {
+    asyncPropose(LogEncode(OpType::kWrite, path, value), std::move(done));
+  }
+
+  Status CommitBatch(std::string &&batch) {
+    consensus::Status s = log_->WriteOwned(std::move(batch));
     if (!s.IsOK()) {
       return Status::Make(Error::ConsensusError, s.ToString());
     }
+    return Status::OK();
+  }
+
+  void AsyncCommitBatch(std::string &&batch, std::function<void(const Status &)> done) {
+    asyncPropose(std::move(batch), std::move(done));
+  }
+
+  void asyncPropose(std::string &&entry, std::function<void(const Status &)> done) {
+    if (core_) {
+      // proposed in the core owning the shard, where its completion runs as well.
+      auto e = std::make_shared<std::string>(std::move(entry));
+      core_->Enqueue([this, e, done]() { propose(std::move(*e), done); });
+      return;
+    }
+    propose(std::move(entry), std::move(done));
+  }
 
-    RETURN_NOT_OK(kv_->Write(path, value));
+  void propose(std::string &&entry, std::function<void(const Status &)> done) {
+    log_->AsyncWriteOwned(std::move(entry), [done](const consensus::Status &s, uint64_t) {
+      if (!s.IsOK()) {
+        done(Status::Make(Error::ConsensusError, s.ToString()));
+        return;
+      }
+      done(Status::OK());
+    });
+  }
+
+  // Makes the following read linearizable, the store has applied the writes committed
+  // before the read once it returns.
+  Status waitReadIndex() {
+    uint64_t readIndex;
+    consensus::Status s = log_->ReadIndex(&readIndex);
+    if (!s.IsOK()) {
+      return FMT_Status(ConsensusError, "read index failed [id: {}, leader: {}]: {}", log_->Id(),
+                        log_->GetRaftState().leader, s.ToString());
+    }
     return Status::OK();
   }
 
+  consensus::Status Apply(const std::vector<yaraft::pb::Entry> &entries) override {
+    // all the ops are decoded ahead, a bad entry fails the batch before it's applied.
+    std::vector<PendingOp> ops;
+    for (const auto &e : entries) {
+      // the empty entries appended by new leaders
+      if (e.data().empty()) {
+        continue;
+      }
+
+      Slice input(e.data());
+      uint32_t count = 1;
+      if (static_cast<OpType>(input[0]) == kBatch) {
+        if (input.size() < kBatchHeaderSize) {
+          return badLog(e);
+        }
+        count = consensus::DecodeFixed32(input.data() + 1);
+        input.remove_prefix(kBatchHeaderSize);
+      }
+
+      // an entry without ops still has its index published to the watchers.
+      ops.emplace_back(&e, kBatch);
+      for (uint32_t i = 0; i < count; i++) {
+        PendingOp op(&e, kWrite);
+        if (!decodeOp(&input, &op.type, &op.path, &op.value)) {
+          return badLog(e);
+        }
+        ops.push_back(op);
+      }
+    }
+
+    // all the ops of an entry are applied before any read that waits for it, and the
+    // reads running along see the entries of multiple ops whole, see readConsistent.
+    bool multiOps = false;
+    for (size_t i = 1; i < ops.size() && !multiOps; i++) {
+      multiOps = ops[i].type != kBatch && ops[i - 1].type != kBatch;
+    }
+    if (multiOps) {
+      batchSeq_.fetch_add(1);
+    }
+    applyOps(&ops);
+    if (multiOps) {
+      batchSeq_.fetch_add(1);
+    }
+
+    std::vector<WatchEvent> events;
+    for (size_t i = 0; i < ops.size(); i++) {
+      const PendingOp &op = ops[i];
+      if (op.type != kBatch) {
+        // The same error occurs on every member, it's not retried. Except for the local
+        // failure of the value log, which can't be skipped.
+        if (op.result.Code() == Error::IOError) {
+          return consensus::Status::Make(consensus::Error::IOError, op.result.ToString());
+        }
+        if (!op.result.IsOK()) {
+          FMT_LOG(WARNING, "failed to apply log [index: {}]: {}", op.entry->index(),
+                  op.result.ToString());
+        } else {
+          WatchEvent event;
+          event.type = op.type == kWrite ? WatchEvent::kPut : WatchEvent::kDelete;
+          event.path = WatchHub::NormalizePath(op.path);
+          if (op.type == kWrite) {
+            event.value.assign(op.value.data(), op.value.size());
+          }
+          events.push_back(std::move(event));
+        }
+      }
+      if (i + 1 == ops.size() || ops[i + 1].type == kBatch) {
+        hub_.Append(op.entry->index(), std::move(events));
+        events.clear();
+      }
+    }
+    if (!entries.empty()) {
+      maybeCompact();
+      maybeCheckpoint(entries.back().index());
+    }
+    return consensus::Status::OK();
+  }
+
+  // The ops of a batch of entries are split into `partitions` by MemKvStore::PartitionOf,
+  // and applied in parallel, one partition in the apply thread and the others on the
+  // strands of `pool`. The order of the ops is kept within each partition, the ops of
+  // different partitions touch disjoint subtrees.
+  void EnableParallelApply(consensus::ExecutorPool *pool, size_t partitions) {
+    for (size_t i = 1; i < partitions; i++) {
+      applyStrands_.emplace_back(pool->NewStrand());
+    }
+  }
+
+  // Checkpoints the store into `dir` every `interval` entries.
+  void EnableCheckpoints(const std::string &dir, uint64_t interval) {
+    checkpointDir_ = dir;
+    checkpointInterval_ = interval;
+    checkpointQueue_.reset(new consensus::TaskQueue);
+  }
+
+  // Loads the latest checkpoint into the empty store, `*index` is set to the index it
+  // covers, or 0 if there's none. It's called after SetValueLog, the large values are
+  // appended to the value log rewritten on restart.
+  Status LoadCheckpoint(uint64_t *index) {
+    std::unique_ptr<CheckpointReader> reader;
+    RETURN_NOT_OK(CheckpointReader::OpenLatest(checkpointDir_, &reader));
+    *index = 0;
+    if (!reader) {
+      return Status::OK();
+    }
+    RETURN_NOT_OK(reader->ForEach(
+        [this](const Slice &path, const Slice &value) { return applyWrite(path, value); }));
+    *index = reader->Index();
+    checkpointIndex_ = *index;
+    hub_.SkipTo(*index);
+    FMT_LOG(INFO, "loaded checkpoint [dir: {}, index: {}]", checkpointDir_, *index);
+    return Status::OK();
+  }
+
+  // The values no less than `threshold` are kept in `vlog`.
+  void SetValueLog(std::unique_ptr<ValueLog> vlog, size_t threshold) {
+    vlog_ = std::move(vlog);
+    vlogThreshold_ = threshold;
+  }
+
+  static consensus::Status badLog(const yaraft::pb::Entry &e) {
+    return consensus::Status::Make(consensus::Error::Corruption,
+                                   fmt::format("bad log [index: {}]", e.index()));
+  }
+
+ private:
+  // The view of the store is collected in the apply thread, between two entries, so it
+  // covers exactly the entries up to `index`. The values are shared with the store, the
+  // checkpoint is written in the background.
+  void maybeCheckpoint(uint64_t index) {
+    if (checkpointInterval_ == 0 || index < checkpointIndex_ + checkpointInterval_ ||
+        checkpointing_.load(std::memory_order_acquire)) {
+      return;
+    }
+    checkpointing_.store(true, std::memory_order_release);
+    uint64_t previous = checkpointIndex_;
+    checkpointIndex_ = index;
+
+    auto nodes = std::make_shared<std::vector<std::pair<std::string, butil::IOBuf>>>();
+    kv_->Collect(nodes.get());
+    checkpointQueue_->Enqueue([this, nodes, index, previous]() {
+      Status s = writeCheckpoint(*nodes, index);
+      if (s.IsOK()) {
+        // the log since the previous checkpoint is kept for the lagging followers.
+        compactIndex_.store(previous, std::memory_order_release);
+      } else {
+        FMT_LOG(WARNING, "failed to checkpoint [index: {}]: {}", index, s.ToString());
+      }
+      checkpointing_.store(false, std::memory_order_release);
+    });
+  }
+
+  // The log is compacted from the apply thread, which the log outlives, rather than
+  // from the checkpoint thread.
+  void maybeCompact() {
+    uint64_t index = compactIndex_.load(std::memory_order_acquire);
+    if (index <= compactedIndex_) {
+      return;
+    }
+    compactedIndex_ = index;
+    log_->AsyncCompact(index, [index](const consensus::Status &s) {
+      WARN_NOT_OK(s, fmt::format("compact log up to {}", index));
+    });
+  }
+
+  // The values are read from the value log, the checkpoint never refers to it, so it
+  // outlives the value log rewritten on restart.
+  Status writeCheckpoint(const std::vector<std::pair<std::string, butil::IOBuf>> &nodes,
+                         uint64_t index) {
+    std::unique_ptr<CheckpointBuilder> builder;
+    RETURN_NOT_OK(CheckpointBuilder::Begin(checkpointDir_, index, &builder));
+    std::string value;
+    for (const auto &n : nodes) {
+      RETURN_NOT_OK(storedValue(n.second, &value));
+      RETURN_NOT_OK(builder->Add(n.first, value));
+    }
+    return builder->Finish();
+  }
+
+  // The value of the tagged `data`, read from the value log if it's a pointer.
+  Status storedValue(const butil::IOBuf &data, std::string *value) {
+    value->clear();
+    if (data.empty()) {
+      return Status::OK();
+    }
+    data.copy_to(value);
+    if ((*value)[0] == kInlineValue) {
+      value->erase(0, 1);
+      return Status::OK();
+    }
+    std::string pointer(*value, 1);
+    return readPointer(pointer, value);
+  }
+
+  // Runs `read` of the store until it doesn't overlap the apply of any entry of
+  // multiple ops, so that it observes all the ops of the entry or none. The readers
+  // don't block each other, nor the entries of a single op.
+  template <class Read>
+  Status readConsistent(Read read) {
+    while (true) {
+      uint64_t seq = batchSeq_.load();
+      if (seq & 1) {
+        std::this_thread::yield();
+        continue;
+      }
+      Status s = read();
+      if (batchSeq_.load() == seq) {
+        return s;
+      }
+    }
+  }
+
+  // An op decoded from an entry, or the mark of the start of an entry, whose type is
+  // kBatch.
+  struct PendingOp {
+    PendingOp(const yaraft::pb::Entry *e, OpType t) : entry(e), type(t) {}
+
+    const yaraft::pb::Entry *entry;
+    OpType type;
+    Slice path;
+    Slice value;
+    Status result;
+  };
+
+  // The batches smaller than this are applied in the apply thread alone, they don't
+  // make up for the handoff to the strands.
+  static const size_t kParallelApplyMinOps = 64;
+
+  // The applied index is published by the caller once the whole batch is applied, a
+  // linearizable read observes all of it or none. The value log is appended in order,
+  // it's applied in the apply thread alone.
+  void applyOps(std::vector<PendingOp> *ops) {
+    if (applyStrands_.empty() || vlog_ || ops->size() < kParallelApplyMinOps) {
+      for (PendingOp &op : *ops) {
+        applyOp(&op);
+        if (op.result.Code() == Error::IOError) {
+          return;
+        }
+      }
+      return;
+    }
+
+    std::vector<std::vector<PendingOp *>> parts(applyStrands_.size() + 1);
+    for (PendingOp &op : *ops) {
+      if (op.type != kBatch) {
+        parts[MemKvStore::PartitionOf(op.path, parts.size())].push_back(&op);
+      }
+    }
+    size_t pending = 0;
+    for (size_t i = 1; i < parts.size(); i++) {
+      pending += parts[i].empty() ? 0 : 1;
+    }
+    boost::latch done(pending);
+    for (size_t i = 1; i < parts.size(); i++) {
+      if (parts[i].empty()) {
+        continue;
+      }
+      std::vector<PendingOp *> *part = &parts[i];
+      applyStrands_[i - 1]->Enqueue([this, part, &done]() {
+        for (PendingOp *op : *part) {
+          applyOp(op);
+        }
+        done.count_down();
+      });
+    }
+    for (PendingOp *op : parts[0]) {
+      applyOp(op);
+    }
+    done.wait();
+  }
+
+  void applyOp(PendingOp *op) {
+    if (op->type == kWrite) {
+      op->result = applyWrite(op->path, op->value);
+    } else if (op->type == kDelete) {
+      op->result = kv_->Delete(op->path);
+    }
+  }
+
+  Status applyWrite(const Slice &path, const Slice &value) {
+    butil::IOBuf data;
+    if (vlog_ && value.size() >= vlogThreshold_) {
+      ValuePointer ptr;
+      RETURN_NOT_OK(vlog_->Append(value, &ptr));
+      char buf[kValuePointerSize];
+      buf[0] = kValuePointer;
+      consensus::EncodeFixed64(buf + 1, ptr.offset);
+      consensus::EncodeFixed32(buf + 9, ptr.size);
+      data.append(buf, sizeof(buf));
+    } else {
+      data.push_back(kInlineValue);
+      data.append(value.data(), value.size());
+    }
+    return kv_->Write(path, std::move(data));
+  }
+
+  // `pointer` is the stored value without the tag.
+  Status readPointer(const std::string &pointer, std::string *value) {
+    if (!vlog_ || pointer.size() != kValuePointerSize - 1) {
+      return Status::Make(Error::IOError, "bad value pointer");
+    }
+    ValuePointer ptr;
+    ptr.offset = consensus::DecodeFixed64(pointer.data());
+    ptr.size = consensus::DecodeFixed32(pointer.data() + 8);
+    return vlog_->Read(ptr, value);
+  }
+
  private:
   friend class DB;
 
-  std::unique_ptr<consensus::ReplicatedLog> log_;
   std::unique_ptr<MemKvStore> kv_;
+  std::unique_ptr<consensus::ReplicatedLog> log_;
+  // the strand of the core owning the shard, null unless DBOptions::cores is set.
+  consensus::TaskQueue *core_{nullptr};
+
+  std::unique_ptr<ValueLog> vlog_;
+  size_t vlogThreshold_{0};
+
+  WatchHub hub_;
+
+  std::string checkpointDir_;
+  uint64_t checkpointInterval_{0};
+  // index of the latest checkpoint taken, only accessed in the apply thread.
+  uint64_t checkpointIndex_{0};
+  std::atomic<bool> checkpointing_{false};
+  // the log can be dropped up to compactIndex_ once the checkpoint after it is taken,
+  // it's dropped up to compactedIndex_ in the apply thread.
+  std::atomic<uint64_t> compactIndex_{0};
+  uint64_t compactedIndex_{0};
+  // the strands applying the partitions other than the first, see EnableParallelApply.
+  std::vector<std::unique_ptr<consensus::TaskQueue>> applyStrands_;
+  // odd while the ops of a batch including entries of multiple ops are being applied,
+  // see readConsistent.
+  std::atomic<uint64_t> batchSeq_{0};
+
+  // null if the checkpoints are disabled. Declared last, it's stopped before the
+  // members its tasks use are destroyed.
+  std::unique_ptr<consensus::TaskQueue> checkpointQueue_;
+};
+
+// The paths are routed to the shards by their first segments, so that a directory
+// other than the root is always in one shard, see DB::Bootstrap.
+static uint32_t shardOf(const Slice &path, uint32_t shards) {
+  if (shards == 1) {
+    return 0;
+  }
+  size_t begin = 0;
+  while (begin < path.size() && (path[begin] == '/' || isspace(path[begin]))) {
+    begin++;
+  }
+  size_t end = begin;
+  while (end < path.size() && path[end] != '/' && !isspace(path[end])) {
+    end++;
+  }
+  // FNV-1a, stable across the members and the restarts.
+  uint32_t h = 2166136261u;
+  for (size_t i = begin; i < end; i++) {
+    h = (h ^ static_cast<unsigned char>(path[i])) * 16777619u;
+  }
+  return h % shards;
+}
+
+static bool isRoot(const Slice &path) {
+  for (size_t i = 0; i < path.size(); i++) {
+    if (path[i] != '/' && !isspace(path[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The threads and the wal stream of a core, shared by the shards it owns, see
+// DBOptions::cores.
+struct Core {
+  consensus::ThreadAffinity affinity;
+  std::unique_ptr<consensus::ExecutorPool> pool;
+  std::unique_ptr<consensus::RaftTimer> timer;
+  std::unique_ptr<consensus::ReadyFlusher> flusher;
+  consensus::wal::SharedWriteAheadLogUPtr walEngine;
+  // runs the proposals and the completions of the shards, it's a strand of `pool`,
+  // declared after it.
+  std::unique_ptr<consensus::TaskQueue> strand;
+};
+
+// DB::Impl routes the requests to the shards. The shards of a member share the raft
+// threads, the timer, the flusher and the wal, so that more shards don't cost more
+// threads or syncs. Unless they're split over the cores, each of which has its own.
+class DB::Impl {
+ public:
+  Shard *Route(const Slice &path) {
+    return shards_[shardOf(path, shards_.size())].get();
+  }
+
+  // The batch is rejected as a whole rather than partly failing to apply, it must be
+  // in one shard to be applied atomically.
+  Status RouteBatch(const std::string &batch, Shard **shard) {
+    Slice input(batch);
+    input.remove_prefix(kBatchHeaderSize);
+    OpType type;
+    Slice path, value;
+    int first = -1;
+    while (decodeOp(&input, &type, &path, &value)) {
+      RETURN_NOT_OK(MemKvStore::ValidatePath(path));
+      int i = static_cast<int>(shardOf(path, shards_.size()));
+      if (first >= 0 && i != first) {
+        return FMT_Status(InvalidArgument, "batch spans shards {} and {}", first, i);
+      }
+      first = i;
+    }
+    *shard = shards_[first < 0 ? 0 : first].get();
+    return Status::OK();
+  }
+
+  // The first level of the tree is spread over all shards, the pages of each are
+  // merged by name.
+  Status ListRoot(const Slice &path, const ListOptions &options, bool stale,
+                  std::vector<ListEntry> *entries, bool *more) {
+    *more = false;
+    for (auto &shard : shards_) {
+      bool shardMore = false;
+      RETURN_NOT_OK(shard->List(path, options, stale, entries, &shardMore));
+      *more = *more || shardMore;
+    }
+    std::sort(entries->begin(), entries->end(),
+              [](const ListEntry &a, const ListEntry &b) { return a.name < b.name; });
+    if (options.limit != 0 && entries->size() > options.limit) {
+      entries->resize(options.limit);
+      *more = true;
+    }
+    return Status::OK();
+  }
+
+ private:
+  friend class DB;
+
+  // declared ahead of the shards, which run on them, so that the shards are destroyed
+  // first, unregistering their logs from the timers and the flushers still alive.
+  std::unique_ptr<consensus::ExecutorPool> pool_;
+  std::unique_ptr<consensus::RaftTimer> timer_;
+  std::unique_ptr<consensus::ReadyFlusher> flusher_;
+  consensus::wal::SharedWriteAheadLogUPtr walEngine_;
+  std::vector<std::unique_ptr<Core>> cores_;
+  std::unique_ptr<consensus::ExecutorPool> applyPool_;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
 };
 
 StatusWith<DB *> DB::Bootstrap(const DBOptions &options) {
@@ -109,45 +719,260 @@ StatusWith<DB *> DB::Bootstrap(const DBOptions &options) {
   using consensus::ReplicatedLog;
   using namespace consensus::wal;
 
-  ReplicatedLogOptions rlogOptions;
-  rlogOptions.id = options.member_id;
-  rlogOptions.heartbeat_interval = 100;
-  rlogOptions.election_timeout = 1000;
-  rlogOptions.initial_cluster = options.initial_cluster;
+  if (options.shards == 0) {
+    return Status::Make(Error::InvalidArgument, "DBOptions::shards must be positive");
+  }
+  if (options.cores > options.shards) {
+    return FMT_Status(InvalidArgument, "DBOptions::cores {} exceeds the {} shards",
+                      options.cores, options.shards);
+  }
+
+  std::unique_ptr<DB::Impl> impl(new DB::Impl);
+  if (options.shards > 1 && options.cores == 0) {
+    impl->pool_.reset(new consensus::ExecutorPool(options.shards < 4 ? options.shards : 4));
+    impl->timer_.reset(new consensus::RaftTimer);
+    impl->flusher_.reset(new consensus::ReadyFlusher);
+  }
 
   WriteAheadLogOptions walOptions;
   walOptions.log_dir = options.wal_dir;
+  if (options.shards > 1 && options.cores == 0) {
+    consensus::Status s = SharedWriteAheadLog::Open(walOptions, &impl->walEngine_);
+    if (!s.IsOK()) {
+      return Status::Make(Error::ConsensusError, s.ToString()) << " [SharedWriteAheadLog::Open]";
+    }
+  }
 
-  WriteAheadLogUPtr wal;
-  yaraft::MemStoreUptr memstore;
-  consensus::Status s = WriteAheadLog::Default(walOptions, &wal, &memstore);
-  if (!s.IsOK()) {
-    return Status::Make(Error::ConsensusError, s.ToString()) << " [WriteAheadLog::Default]";
+  if (options.cores > 0) {
+    consensus::Status s = consensus::Env::Default()->CreateDirIfMissing(options.wal_dir);
+    if (!s.IsOK()) {
+      return Status::Make(Error::IOError, s.ToString()) << " [create " << options.wal_dir << "]";
+    }
+  }
+  for (uint32_t c = 0; c < options.cores; c++) {
+    consensus::ThreadAffinity affinity;
+    affinity.cpus.push_back(static_cast<int>(c));
+
+    std::unique_ptr<Core> core(new Core);
+    core->affinity = affinity;
+    core->pool.reset(new consensus::ExecutorPool(1, affinity));
+    core->timer.reset(new consensus::RaftTimer(affinity));
+    consensus::ReadyFlusherOptions flusherOptions;
+    flusherOptions.workers = 1;
+    flusherOptions.affinity = affinity;
+    core->flusher.reset(new consensus::ReadyFlusher(flusherOptions));
+
+    WriteAheadLogOptions coreWalOptions = walOptions;
+    coreWalOptions.log_dir = fmt::format("{}/core-{}", options.wal_dir, c);
+    consensus::Status s = SharedWriteAheadLog::Open(coreWalOptions, &core->walEngine);
+    if (!s.IsOK()) {
+      return Status::Make(Error::ConsensusError, s.ToString())
+             << " [SharedWriteAheadLog::Open core " << c << "]";
+    }
+    core->strand.reset(core->pool->NewStrand());
+    impl->cores_.push_back(std::move(core));
+  }
+  if (options.apply_threads > 1) {
+    impl->applyPool_.reset(new consensus::ExecutorPool(options.apply_threads - 1));
   }
-  rlogOptions.wal = wal.release();
-  rlogOptions.memstore = memstore.release();
 
-  consensus::StatusWith<ReplicatedLog *> sw = ReplicatedLog::New(rlogOptions);
-  if (!sw.IsOK()) {
-    return Status::Make(Error::ConsensusError, sw.ToString()) << " [ReplicatedLog::New]";
+  std::string vlogDir = options.wal_dir + ".vlog";
+  std::string checkpointDir = options.wal_dir + ".checkpoint";
+  if (options.value_log_threshold > 0) {
+    consensus::Status s = consensus::Env::Default()->CreateDirIfMissing(vlogDir);
+    if (!s.IsOK()) {
+      return Status::Make(Error::IOError, s.ToString()) << " [create " << vlogDir << "]";
+    }
+  }
+
+  for (uint32_t i = 0; i < options.shards; i++) {
+    ReplicatedLogOptions rlogOptions;
+    rlogOptions.id = options.member_id;
+    rlogOptions.group_id = i;
+    rlogOptions.heartbeat_interval = 100;
+    rlogOptions.election_timeout = 1000;
+    rlogOptions.lease_read = options.lease_read;
+    rlogOptions.lease_clock_drift = 200;
+    rlogOptions.initial_cluster = options.initial_cluster;
+    rlogOptions.learners = options.learners;
+
+    if (options.shards > 1) {
+      // The leaders are spread over the members by giving each shard a preferred
+      // member, whose shorter election timeout wins the elections most of the time.
+      // The leases stay as long as the shortest timeout of the group allows.
+      uint64_t preferred = std::next(options.initial_cluster.begin(),
+                                     i % options.initial_cluster.size())->first;
+      if (options.member_id != preferred) {
+        rlogOptions.election_timeout += 500;
+        rlogOptions.lease_clock_drift += 500;
+      }
+    }
+    Core *core = options.cores > 0 ? impl->cores_[i % options.cores].get() : nullptr;
+    if (core) {
+      rlogOptions.executor_pool = core->pool.get();
+      rlogOptions.timer = core->timer.get();
+      rlogOptions.flusher = core->flusher.get();
+      rlogOptions.completion_executor = core->strand.get();
+      rlogOptions.apply_affinity = core->affinity;
+    } else if (options.shards > 1) {
+      rlogOptions.executor_pool = impl->pool_.get();
+      rlogOptions.timer = impl->timer_.get();
+      rlogOptions.flusher = impl->flusher_.get();
+    }
+
+    WriteAheadLog *wal;
+    yaraft::MemStoreUptr memstore;
+    consensus::Status s;
+    if (core) {
+      s = core->walEngine->OpenGroup(i, &wal, &memstore);
+    } else if (options.shards > 1) {
+      s = impl->walEngine_->OpenGroup(i, &wal, &memstore);
+    } else {
+      WriteAheadLogUPtr walPtr;
+      s = WriteAheadLog::Default(walOptions, &walPtr, &memstore);
+      wal = walPtr.release();
+    }
+    if (!s.IsOK()) {
+      return Status::Make(Error::ConsensusError, s.ToString()) << " [open wal]";
+    }
+    rlogOptions.wal = wal;
+    rlogOptions.memstore = memstore.release();
+
+    // the store is built from scratch on restart.
+    std::unique_ptr<Shard> shard(new Shard(options.watch_history_events,
+                                           options.watch_history_bytes));
+    rlogOptions.state_machine = shard.get();
+    if (options.value_log_threshold > 0) {
+      std::unique_ptr<ValueLog> vlog;
+      RETURN_NOT_OK(ValueLog::Open(fmt::format("{}/shard-{}", vlogDir, i),
+                                   options.value_cache_bytes, &vlog));
+      shard->SetValueLog(std::move(vlog), options.value_log_threshold);
+    }
+    if (impl->applyPool_) {
+      shard->EnableParallelApply(impl->applyPool_.get(), options.apply_threads);
+    }
+
+    // the entries covered by the checkpoint are skipped by the applier.
+    if (options.checkpoint_interval > 0) {
+      std::string dir = fmt::format("{}/shard-{}", checkpointDir, i);
+      for (const std::string &d : {checkpointDir, dir}) {
+        consensus::Status cs = consensus::Env::Default()->CreateDirIfMissing(d);
+        if (!cs.IsOK()) {
+          return Status::Make(Error::IOError, cs.ToString()) << " [create " << d << "]";
+        }
+      }
+      shard->EnableCheckpoints(dir, options.checkpoint_interval);
+      RETURN_NOT_OK(shard->LoadCheckpoint(&rlogOptions.applied_index));
+    }
+
+    consensus::StatusWith<ReplicatedLog *> sw = ReplicatedLog::New(rlogOptions);
+    if (!sw.IsOK()) {
+      return Status::Make(Error::ConsensusError, sw.ToString()) << " [ReplicatedLog::New]";
+    }
+    shard->log_.reset(sw.GetValue());
+    shard->core_ = core ? core->strand.get() : nullptr;
+    impl->shards_.push_back(std::move(shard));
   }
 
-  ReplicatedLog *rlog = sw.GetValue();
   auto db = new DB();
-  db->impl_.reset(new DB::Impl(rlog));
+  db->impl_ = std::move(impl);
   return db;
 }
 
+void DB::AsyncWrite(const Slice &path, const Slice &value,
+                    std::function<void(const Status &)> done) {
+  impl_->Route(path)->AsyncWrite(path, value, std::move(done));
+}
+
 Status DB::Get(const Slice &path, bool stale, std::string *data) {
-  return impl_->Get(path, stale, data);
+  return impl_->Route(path)->Get(path, stale, data);
+}
+
+Status DB::Get(const Slice &path, bool stale, butil::IOBuf *data) {
+  return impl_->Route(path)->Get(path, stale, data);
+}
+
+Status DB::List(const Slice &path, const ListOptions &options, bool stale,
+                std::vector<ListEntry> *entries, bool *more) {
+  if (impl_->shards_.size() > 1 && isRoot(path)) {
+    return impl_->ListRoot(path, options, stale, entries, more);
+  }
+  return impl_->Route(path)->List(path, options, stale, entries, more);
+}
+
+void DB::AsyncWrite(WriteBatch &&batch, std::function<void(const Status &)> done) {
+  Shard *shard;
+  Status s = impl_->RouteBatch(batch.rep_, &shard);
+  if (!s.IsOK()) {
+    done(s);
+    return;
+  }
+  shard->AsyncCommitBatch(std::move(batch.rep_), std::move(done));
+}
+
+Status DB::Write(WriteBatch &&batch) {
+  Shard *shard;
+  RETURN_NOT_OK(impl_->RouteBatch(batch.rep_, &shard));
+  return shard->CommitBatch(std::move(batch.rep_));
 }
 
 Status DB::Delete(const Slice &path) {
-  return impl_->Delete(path);
+  return impl_->Route(path)->Delete(path);
 }
 
 Status DB::Write(const Slice &path, const Slice &value) {
-  return impl_->Write(path, value);
+  return impl_->Route(path)->Write(path, value);
+}
+
+// The ids of the watchers of the shards are interleaved, so that Unwatch finds the shard.
+Status DB::Watch(const Slice &path, bool recursive, uint64_t *fromIndex, WatchSink sink,
+                 uint64_t *id) {
+  size_t shards = impl_->shards_.size();
+  if (shards > 1 && isRoot(path)) {
+    return Status::Make(Error::InvalidArgument, "the root can't be watched across shards");
+  }
+  RETURN_NOT_OK(MemKvStore::ValidatePath(path));
+  uint32_t i = shardOf(path, shards);
+  WatchHub &hub = impl_->shards_[i]->hub_;
+
+  // the events applied meanwhile are replayed from the history.
+  if (*fromIndex == 0) {
+    *fromIndex = hub.AppliedIndex() + 1;
+  }
+  uint64_t hubId;
+  RETURN_NOT_OK(hub.Watch(path, recursive, *fromIndex, std::move(sink), &hubId));
+  *id = hubId == 0 ? 0 : hubId * shards + i;
+  return Status::OK();
+}
+
+void DB::Unwatch(uint64_t id) {
+  size_t shards = impl_->shards_.size();
+  impl_->shards_[id % shards]->hub_.Unwatch(id / shards);
+}
+
+uint32_t DB::ShardCount() const {
+  return static_cast<uint32_t>(impl_->shards_.size());
+}
+
+Status DB::HandOffLeadership(uint32_t timeoutMs) {
+  // the shards are handed over in parallel, so the wait doesn't add up.
+  std::vector<consensus::Status> results(impl_->shards_.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < impl_->shards_.size(); i++) {
+    consensus::ReplicatedLog *log = impl_->shards_[i]->log_.get();
+    consensus::Status *result = &results[i];
+    threads.emplace_back(
+        [log, result, timeoutMs]() { *result = log->HandOffLeadership(timeoutMs); });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  for (size_t i = 0; i < results.size(); i++) {
+    if (!results[i].IsOK()) {
+      return Status::Make(Error::ConsensusError, results[i].ToString()) << " [shard " << i << "]";
+    }
+  }
+  return Status::OK();
 }
 
 DB::DB() {}
@@ -155,7 +980,11 @@ DB::DB() {}
 DB::~DB() = default;
 
 consensus::pb::RaftService *DB::CreateRaftServiceInstance() const {
-  return new consensus::RaftServiceImpl(impl_->log_->RaftTaskExecutorInstance());
+  auto service = new consensus::RaftServiceImpl;
+  for (const auto &shard : impl_->shards_) {
+    service->AddGroup(shard->log_.get());
+  }
+  return service;
 }
 
-}  // namespace memkv
\ No newline at end of file
+}  // namespace memkv
@@ -14,10 +14,13 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 
+#include "memkv_store.h"
 #include "slice.h"
 #include "status.h"
+#include "watch_hub.h"
 
 #include <brpc/server.h>
 #include <consensus/raft_service.h>
@@ -38,6 +41,73 @@ class DBOptions {
   uint64_t member_id;
   std::string wal_dir;
   std::map<uint64_t, std::string> initial_cluster;
+
+  // members replicating every shard without voting, which serve the stale reads and the
+  // linearizable reads forwarded to the leaders, see
+  // consensus::ReplicatedLogOptions::learners. A member is a learner if its member_id
+  // is among them.
+  std::map<uint64_t, std::string> learners;
+
+  // serve the linearizable reads locally while the leader holds its lease,
+  // see consensus::ReplicatedLogOptions::lease_read.
+  bool lease_read{false};
+
+  // The keyspace is split into `shards` raft groups by the first segments of the paths.
+  // Shard i is the raft group i, all the shards of a member are reached at its url in
+  // initial_cluster, see DB::CreateRaftServiceInstance.
+  uint32_t shards{1};
+
+  // If positive, the values of at least this many bytes are kept in a value log, in
+  // <wal_dir>.vlog, rather than in memory, see ValueLog. Up to value_cache_bytes of
+  // them are cached. The log entries still carry the values.
+  size_t value_log_threshold{0};
+  size_t value_cache_bytes{64 * 1024 * 1024};
+
+  // If positive, each shard checkpoints its store every this many log entries, into
+  // <wal_dir>.checkpoint/shard-<i>, see CheckpointBuilder. A restart loads the latest
+  // checkpoint and replays the log after it. The log is dropped up to the checkpoint
+  // before the latest one, a follower lagging behind it can't catch up.
+  uint64_t checkpoint_interval{0};
+
+  // Each shard keeps the latest events of at most this many changes and bytes for the
+  // watchers catching up after a reconnect, see WatchHub.
+  size_t watch_history_events{10000};
+  size_t watch_history_bytes{16 * 1024 * 1024};
+
+  // If positive, the shards are split over cores 0 to cores - 1, shard i is owned by
+  // core i % cores. Each core has its own raft thread, timer, flusher and wal stream,
+  // in <wal_dir>/core-<c>, all pinned to it, and the proposals and completions of its
+  // shards are run there, so that a write doesn't hop across the cores after it's
+  // routed. It mustn't exceed `shards`, nor change across restarts.
+  uint32_t cores{0};
+
+  // If more than 1, each shard applies the committed entries with this many threads,
+  // the apply thread and apply_threads - 1 workers shared by the shards. The ops are
+  // split by the first segments of their paths, see MemKvStore::PartitionOf. Ignored
+  // with the value log.
+  uint32_t apply_threads{1};
+};
+
+// WriteBatch collects the writes and deletes that are applied together, in order, by
+// a single log entry, so that they share one round of replication.
+class WriteBatch {
+ public:
+  WriteBatch();
+
+  void Put(const Slice &path, const Slice &value);
+
+  void Delete(const Slice &path);
+
+  uint32_t Count() const {
+    return count_;
+  }
+
+ private:
+  friend class DB;
+
+  // the encoded log entry.
+  std::string rep_;
+  uint32_t count_{0};
 };
 
 class DB {
@@ -46,12 +116,51 @@ class DB {
 
   Status Write(const Slice &path, const Slice &value);
 
+  // The callback is called once the write is applied or failed. path and value must be
+  // kept alive until then.
+  void AsyncWrite(const Slice &path, const Slice &value, std::function<void(const Status &)> done);
+
   Status Delete(const Slice &path);
 
+  // The batch is rejected as a whole if any path of it is invalid, or if its paths are
+  // in different shards. Otherwise all of its ops are applied before the batch
+  // completes, and a read, stale or not, observes all of them or none.
+  Status Write(WriteBatch &&batch);
+
+  void AsyncWrite(WriteBatch &&batch, std::function<void(const Status &)> done);
+
   Status Get(const Slice &path, bool stale, std::string *data);
 
+  // Same as above, except that the value is shared with the store rather than copied,
+  // see MemKvStore::Get.
+  Status Get(const Slice &path, bool stale, butil::IOBuf *data);
+
+  // Lists a page of the children of `path`, see MemKvStore::List. Like Get, it's
+  // linearizable unless `stale` is set. Listing the root visits all shards.
+  Status List(const Slice &path, const ListOptions &options, bool stale,
+              std::vector<ListEntry> *entries, bool *more);
+
+  // Pushes the changes of `path`, or of its subtree if `recursive`, to `sink` as they're
+  // applied on this member, see WatchHub::Watch. `fromIndex` 0 is set to the index the
+  // watch starts from. A path is watched in its shard, the root can only be watched if
+  // there's one shard.
+  Status Watch(const Slice &path, bool recursive, uint64_t *fromIndex, WatchSink sink,
+               uint64_t *id);
+
+  void Unwatch(uint64_t id);
+
+  // The RaftService of all the shards, routing the calls by their group ids, see
+  // DBOptions::shards. The DB must outlive the server serving it.
   consensus::pb::RaftService *CreateRaftServiceInstance() const;
 
+  uint32_t ShardCount() const;
+
+  // Hands the leadership of every shard led by this member over to a follower, and
+  // waits up to `timeoutMs` for the successors, see
+  // consensus::ReplicatedLog::HandOffLeadership. It's called before a planned shutdown,
+  // while the raft services are still serving.
+  Status HandOffLeadership(uint32_t timeoutMs);
+
   DB();
 
   ~DB();
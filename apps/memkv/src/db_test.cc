@@ -0,0 +1,123 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <map>
+#include <thread>
+
+#include "checkpoint.h"
+#include "db.h"
+#include "testing.h"
+
+using namespace memkv;
+
+// A single member DB, which elects itself without any RaftService served.
+class DBTest : public testing::Test {
+ public:
+  DBTest() : dir_("/tmp/memkv.DBTest") {
+    consensus::Env::Default()->DeleteRecursively(dir_);
+    FATAL_NOT_OK(consensus::Env::Default()->CreateDirIfMissing(dir_), "create " + dir_);
+
+    options_.member_id = 1;
+    options_.wal_dir = dir_ + "/wal";
+    options_.initial_cluster[1] = "127.0.0.1:12421";
+  }
+
+  ~DBTest() override {
+    consensus::Env::Default()->DeleteRecursively(dir_);
+  }
+
+  // Bootstraps the DB and waits until it's elected, the entries committed before
+  // are applied then.
+  void open() {
+    DB *db = nullptr;
+    ASSIGN_IF_ASSERT_OK(DB::Bootstrap(options_), db);
+    db_.reset(db);
+
+    Status s;
+    for (int i = 0; i < 100; i++) {
+      s = db_->Write("/probe", "");
+      if (s.IsOK()) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    ASSERT_OK(s);
+  }
+
+  // Waits until the checkpoint covering `index` is written.
+  void waitCheckpoint(uint64_t index, std::unique_ptr<CheckpointReader> *reader) {
+    std::string dir = options_.wal_dir + ".checkpoint/shard-0";
+    for (int i = 0; i < 100; i++) {
+      ASSERT_OK(CheckpointReader::OpenLatest(dir, reader));
+      if (*reader && (*reader)->Index() >= index) {
+        return;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    FAIL() << "no checkpoint covers index " << index;
+  }
+
+ protected:
+  std::string dir_;
+  DBOptions options_;
+  std::unique_ptr<DB> db_;
+};
+
+// The value log is rewritten on restart, the values it held come back from the
+// checkpoint, which keeps the values rather than their pointers.
+TEST_F(DBTest, RestartThroughCheckpointWithValueLog) {
+  options_.value_log_threshold = 64;
+  options_.value_cache_bytes = 0;
+  options_.checkpoint_interval = 8;
+  ASSERT_NO_FATAL_FAILURE(open());
+
+  std::map<std::string, std::string> expected;
+  for (int i = 0; i < 20; i++) {
+    std::string path = fmt::format("/dir/k{:02d}", i);
+    // every other value is kept in the value log.
+    expected[path] = std::string(i % 2 ? 200 + i : 10 + i, static_cast<char>('a' + i));
+    ASSERT_OK(db_->Write(path, expected[path]));
+  }
+
+  // the log up to the checkpoint before the latest one is dropped.
+  std::unique_ptr<CheckpointReader> reader;
+  ASSERT_NO_FATAL_FAILURE(waitCheckpoint(16, &reader));
+  size_t checked = 0;
+  ASSERT_OK(reader->ForEach([&](const Slice &path, const Slice &value) -> Status {
+    auto it = expected.find(std::string(path.data(), path.size()));
+    if (it != expected.end()) {
+      EXPECT_EQ(std::string(value.data(), value.size()), it->second);
+      checked++;
+    }
+    return Status::OK();
+  }));
+  ASSERT_GT(checked, 0u);
+
+  db_.reset();
+  ASSERT_NO_FATAL_FAILURE(open());
+  for (const auto &e : expected) {
+    std::string value;
+    ASSERT_OK(db_->Get(e.first, true, &value));
+    ASSERT_EQ(value, e.second);
+  }
+
+  // the values appended after the restart don't clobber the ones reloaded.
+  std::string value(300, 'z');
+  ASSERT_OK(db_->Write("/dir/k01", value));
+  ASSERT_OK(db_->Get("/dir/k01", true, &value));
+  ASSERT_EQ(value, std::string(300, 'z'));
+  ASSERT_OK(db_->Get("/dir/k03", true, &value));
+  ASSERT_EQ(value, expected["/dir/k03"]);
+}
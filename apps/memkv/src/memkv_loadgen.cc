@@ -0,0 +1,503 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// memkv_loadgen drives a memkv cluster with a YCSB-style workload: a mix of reads and
+// writes over a fixed set of records, picked uniformly or by a zipfian distribution,
+// from many client threads. It reports the throughput of every second, the latency
+// histogram of each operation, and the longest stall in which no operation succeeded.
+//
+// With --server_binary, the cluster is started by the load generator, so that it can
+// kill the leader at --kill_leader_at_sec and restart it --restart_after_sec later, to
+// measure the failover stall.
+//
+//   memkv_loadgen --server_binary=../output/bin/memkv_server --duration_sec=60
+//                 --read_ratio=0.95 --key_dist=zipfian --kill_leader_at_sec=20
+
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include <brpc/channel.h>
+#include <brpc/controller.h>
+#include <consensus/pb/raft_server.pb.h>
+#include <fmt/format.h>
+#include <gflags/gflags.h>
+
+#include "pb/memkv.pb.h"
+
+DEFINE_string(servers, "127.0.0.1:12321,127.0.0.1:12322,127.0.0.1:12323",
+              "comma-separated addresses of the memkv servers, ignored with --server_binary");
+DEFINE_int32(threads, 16, "number of client threads, each with one request in flight");
+DEFINE_int32(duration_sec, 30, "how long the workload runs");
+DEFINE_int64(record_count, 100000, "number of distinct keys");
+DEFINE_double(read_ratio, 0.5, "fraction of the operations that are reads, e.g YCSB A 0.5, B 0.95");
+DEFINE_string(key_dist, "zipfian", "distribution of the keys, uniform or zipfian");
+DEFINE_double(zipf_theta, 0.99, "skew of the zipfian distribution");
+DEFINE_int32(value_size, 100, "size of the values written");
+DEFINE_int32(value_size_max, 0, "if greater than value_size, the sizes are uniform in between");
+DEFINE_bool(stale_reads, false, "read from any server rather than the leader");
+DEFINE_bool(preload, true, "write every record before the workload, so that no read misses");
+DEFINE_int32(timeout_ms, 1000, "timeout of every request");
+
+DEFINE_string(server_binary, "", "if set, the cluster is started from this memkv_server binary");
+DEFINE_int32(server_count, 3, "number of servers started with --server_binary");
+DEFINE_string(work_dir, "./loadgen.consensus", "where the started servers keep their data");
+DEFINE_int32(kill_leader_at_sec, 0, "if positive, the leader is killed after this many seconds");
+DEFINE_int32(restart_after_sec, 5, "the killed leader is restarted after this many seconds");
+
+using Clock = std::chrono::steady_clock;
+
+static int64_t sinceUs(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+}
+
+// Zipfian over [0, n) as in YCSB, after Gray et al, "Quickly Generating Billion-Record
+// Synthetic Databases". The item ranks are scattered by hashing, so that the popular
+// keys don't cluster in one directory of the tree.
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(uint64_t n, double theta) : n_(n), theta_(theta) {
+    double zeta2 = zeta(2);
+    zetan_ = zeta(n);
+    alpha_ = 1.0 / (1.0 - theta);
+    eta_ = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta2 / zetan_);
+  }
+
+  uint64_t Next(std::mt19937_64* rng) const {
+    double u = std::uniform_real_distribution<double>(0, 1)(*rng);
+    double uz = u * zetan_;
+    uint64_t rank;
+    if (uz < 1.0) {
+      rank = 0;
+    } else if (uz < 1.0 + std::pow(0.5, theta_)) {
+      rank = 1;
+    } else {
+      rank = static_cast<uint64_t>(n_ * std::pow(eta_ * u - eta_ + 1, alpha_));
+    }
+    return fnv1a(std::min(rank, n_ - 1)) % n_;
+  }
+
+ private:
+  double zeta(uint64_t n) const {
+    double sum = 0;
+    for (uint64_t i = 1; i <= n; i++) {
+      sum += 1.0 / std::pow(i, theta_);
+    }
+    return sum;
+  }
+
+  static uint64_t fnv1a(uint64_t v) {
+    uint64_t h = 14695981039346656037ULL;
+    for (int i = 0; i < 8; i++) {
+      h ^= (v >> (i * 8)) & 0xff;
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+
+  uint64_t n_;
+  double theta_;
+  double zetan_, alpha_, eta_;
+};
+
+// Latencies in power-of-two buckets of microseconds, with the exact samples kept for the
+// percentiles.
+class Histogram {
+ public:
+  void Add(int64_t us) {
+    samples_.push_back(us);
+  }
+
+  void Merge(const Histogram& other) {
+    samples_.insert(samples_.end(), other.samples_.begin(), other.samples_.end());
+  }
+
+  void Print(const std::string& name) {
+    if (samples_.empty()) {
+      return;
+    }
+    std::sort(samples_.begin(), samples_.end());
+    auto pct = [this](double p) {
+      return samples_[std::min(samples_.size() - 1, static_cast<size_t>(samples_.size() * p))];
+    };
+    std::cout << fmt::format("{}: count {}, p50 {}us, p90 {}us, p99 {}us, p999 {}us, max {}us\n",
+                             name, samples_.size(), pct(0.5), pct(0.9), pct(0.99), pct(0.999),
+                             samples_.back());
+
+    size_t i = 0;
+    for (int64_t upper = 1; i < samples_.size(); upper *= 2) {
+      size_t count = 0;
+      while (i < samples_.size() && samples_[i] < upper) {
+        count++;
+        i++;
+      }
+      if (count > 0) {
+        std::cout << fmt::format("  < {:>9}us {:>10} {:>6.2f}%\n", upper, count,
+                                 count * 100.0 / samples_.size());
+      }
+    }
+  }
+
+ private:
+  std::vector<int64_t> samples_;
+};
+
+// The cluster under load, and which of its servers is believed to be the leader.
+class Cluster {
+ public:
+  explicit Cluster(const std::vector<std::string>& servers) : servers_(servers) {
+    brpc::ChannelOptions options;
+    options.timeout_ms = FLAGS_timeout_ms;
+    options.max_retry = 0;
+    for (const auto& s : servers) {
+      channels_.emplace_back(new brpc::Channel);
+      if (channels_.back()->Init(s.c_str(), &options) != 0) {
+        std::cerr << "failed to connect to " << s << std::endl;
+        exit(1);
+      }
+    }
+  }
+
+  size_t Size() const {
+    return servers_.size();
+  }
+
+  brpc::Channel* Channel(size_t i) const {
+    return channels_[i].get();
+  }
+
+  size_t Leader() const {
+    return leader_.load();
+  }
+
+  // Asks the servers for the leader, after a request to the presumed one failed.
+  void RefreshLeader(size_t failed) {
+    std::lock_guard<std::mutex> g(mu_);
+    if (leader_.load() != failed) {
+      // refreshed by another thread.
+      return;
+    }
+    for (size_t i = 0; i < channels_.size(); i++) {
+      consensus::pb::RaftService_Stub stub(channels_[i].get());
+      brpc::Controller cntl;
+      consensus::pb::StatusRequest request;
+      consensus::pb::StatusResponse response;
+      stub.Status(&cntl, &request, &response, nullptr);
+      // the servers are numbered from 1 in the order they're listed.
+      if (!cntl.Failed() && response.leader() >= 1 && response.leader() <= channels_.size()) {
+        leader_ = response.leader() - 1;
+        return;
+      }
+    }
+    leader_ = (failed + 1) % channels_.size();
+  }
+
+ private:
+  std::vector<std::string> servers_;
+  std::vector<std::unique_ptr<brpc::Channel>> channels_;
+  std::atomic<size_t> leader_{0};
+  std::mutex mu_;
+};
+
+// The servers started with --server_binary, numbered from 1.
+class ServerProcesses {
+ public:
+  ServerProcesses() {
+    mkdir(FLAGS_work_dir.c_str(), 0755);
+    for (int id = 1; id <= FLAGS_server_count; id++) {
+      std::string dir = fmt::format("{}/server{}", FLAGS_work_dir, id);
+      mkdir(dir.c_str(), 0755);
+      mkdir((dir + "/log").c_str(), 0755);
+      pids_.push_back(0);
+      Start(id);
+    }
+  }
+
+  ~ServerProcesses() {
+    for (int id = 1; id <= FLAGS_server_count; id++) {
+      Kill(id);
+    }
+  }
+
+  static std::vector<std::string> Addresses() {
+    std::vector<std::string> addresses;
+    for (int id = 1; id <= FLAGS_server_count; id++) {
+      addresses.push_back(fmt::format("127.0.0.1:{}", 12320 + id));
+    }
+    return addresses;
+  }
+
+  void Start(int id) {
+    std::string dir = fmt::format("{}/server{}", FLAGS_work_dir, id);
+    std::vector<std::string> args = {FLAGS_server_binary,
+                                     fmt::format("--id={}", id),
+                                     fmt::format("--wal_dir={}/wal", dir),
+                                     fmt::format("--server_count={}", FLAGS_server_count),
+                                     fmt::format("--memkv_log_dir={}/log", dir)};
+    pid_t pid = fork();
+    if (pid == 0) {
+      std::vector<char*> argv;
+      for (auto& a : args) {
+        argv.push_back(&a[0]);
+      }
+      argv.push_back(nullptr);
+      execv(argv[0], argv.data());
+      _exit(127);
+    }
+    pids_[id - 1] = pid;
+  }
+
+  void Kill(int id) {
+    pid_t pid = pids_[id - 1];
+    if (pid > 0) {
+      kill(pid, SIGKILL);
+      waitpid(pid, nullptr, 0);
+      pids_[id - 1] = 0;
+    }
+  }
+
+ private:
+  std::vector<pid_t> pids_;
+};
+
+struct Stats {
+  explicit Stats(int seconds) : okPerSec(seconds + 1), errorsPerSec(seconds + 1) {}
+
+  // Records a completion at `us` since the start, tracking the longest stall between
+  // successful operations.
+  void Done(int64_t us, bool ok) {
+    size_t sec = std::min<size_t>(us / 1000000, okPerSec.size() - 1);
+    if (!ok) {
+      errorsPerSec[sec]++;
+      return;
+    }
+    okPerSec[sec]++;
+    int64_t last = lastOkUs.exchange(us);
+    int64_t gap = us - last;
+    int64_t stall = maxStallUs.load();
+    while (gap > stall && !maxStallUs.compare_exchange_weak(stall, gap)) {
+    }
+  }
+
+  std::vector<std::atomic<uint64_t>> okPerSec;
+  std::vector<std::atomic<uint64_t>> errorsPerSec;
+  std::atomic<int64_t> lastOkUs{0};
+  std::atomic<int64_t> maxStallUs{0};
+  std::atomic<uint64_t> readMisses{0};
+};
+
+static std::string keyOf(uint64_t i) {
+  return fmt::format("/ycsb/user{:012d}", i);
+}
+
+// Returns true on success, sets `retry` if the server isn't the leader or can't be
+// reached, so that the request is to be sent to another one.
+static bool write(Cluster* cluster, size_t server, const std::string& key,
+                  const std::string& value, bool* retry) {
+  memkv::pb::MemKVService_Stub stub(cluster->Channel(server));
+  brpc::Controller cntl;
+  memkv::pb::WriteRequest request;
+  memkv::pb::WriteResult response;
+  request.set_path(key);
+  request.set_value(value);
+  stub.Write(&cntl, &request, &response, nullptr);
+  *retry = cntl.Failed() || response.errorcode() == memkv::pb::ConsensusError;
+  return !cntl.Failed() && response.errorcode() == memkv::pb::OK;
+}
+
+static bool read(Cluster* cluster, size_t server, const std::string& key, bool* retry,
+                 bool* miss) {
+  memkv::pb::MemKVService_Stub stub(cluster->Channel(server));
+  brpc::Controller cntl;
+  memkv::pb::ReadRequest request;
+  memkv::pb::ReadResult response;
+  request.set_path(key);
+  request.set_stale(FLAGS_stale_reads);
+  request.set_valueinattachment(true);
+  stub.Read(&cntl, &request, &response, nullptr);
+  *retry = cntl.Failed() || response.errorcode() == memkv::pb::ConsensusError;
+  *miss = !cntl.Failed() && response.errorcode() == memkv::pb::NodeNotExist;
+  return !cntl.Failed() && (response.errorcode() == memkv::pb::OK || *miss);
+}
+
+static void runClient(int seed, Cluster* cluster, const ZipfianGenerator* zipf,
+                      Clock::time_point start, Stats* stats, Histogram* reads,
+                      Histogram* writes) {
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> coin(0, 1);
+  std::uniform_int_distribution<uint64_t> uniformKey(0, FLAGS_record_count - 1);
+  std::uniform_int_distribution<int> valueSize(
+      FLAGS_value_size, std::max(FLAGS_value_size, FLAGS_value_size_max));
+  std::string values(std::max(FLAGS_value_size, FLAGS_value_size_max), 'v');
+
+  int64_t endUs = FLAGS_duration_sec * 1000000LL;
+  for (int64_t now = sinceUs(start); now < endUs; now = sinceUs(start)) {
+    uint64_t k = zipf ? zipf->Next(&rng) : uniformKey(rng);
+    std::string key = keyOf(k);
+    bool isRead = coin(rng) < FLAGS_read_ratio;
+
+    size_t server = isRead && FLAGS_stale_reads ? rng() % cluster->Size() : cluster->Leader();
+    bool retry = false, miss = false, ok;
+    Clock::time_point begin = Clock::now();
+    if (isRead) {
+      ok = read(cluster, server, key, &retry, &miss);
+    } else {
+      ok = write(cluster, server, key, values.substr(0, valueSize(rng)), &retry);
+    }
+    int64_t latency = sinceUs(begin);
+    stats->Done(sinceUs(start), ok);
+    if (ok) {
+      (isRead ? reads : writes)->Add(latency);
+      stats->readMisses += miss;
+    } else if (retry && !(isRead && FLAGS_stale_reads)) {
+      cluster->RefreshLeader(server);
+    }
+  }
+}
+
+static void preload(Cluster* cluster) {
+  std::cout << fmt::format("preloading {} records\n", FLAGS_record_count);
+  std::atomic<uint64_t> next(0);
+  std::vector<std::thread> threads;
+  std::string value(FLAGS_value_size, 'v');
+  for (int t = 0; t < FLAGS_threads; t++) {
+    threads.emplace_back([&]() {
+      for (uint64_t i = next++; i < static_cast<uint64_t>(FLAGS_record_count); i = next++) {
+        bool retry;
+        size_t server;
+        while (!write(cluster, server = cluster->Leader(), keyOf(i), value, &retry)) {
+          if (retry) {
+            cluster->RefreshLeader(server);
+          }
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+static std::vector<std::string> split(const std::string& s) {
+  std::vector<std::string> parts;
+  size_t begin = 0;
+  while (begin <= s.size()) {
+    size_t end = s.find(',', begin);
+    if (end == std::string::npos) {
+      end = s.size();
+    }
+    if (end > begin) {
+      parts.push_back(s.substr(begin, end - begin));
+    }
+    begin = end + 1;
+  }
+  return parts;
+}
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_record_count <= 0 || FLAGS_threads <= 0 || FLAGS_duration_sec <= 0) {
+    std::cerr << "--record_count, --threads and --duration_sec must be positive" << std::endl;
+    return 1;
+  }
+  if (FLAGS_key_dist != "uniform" && FLAGS_key_dist != "zipfian") {
+    std::cerr << "unknown --key_dist " << FLAGS_key_dist << std::endl;
+    return 1;
+  }
+  if (FLAGS_kill_leader_at_sec > 0 && FLAGS_server_binary.empty()) {
+    std::cerr << "--kill_leader_at_sec requires --server_binary" << std::endl;
+    return 1;
+  }
+
+  std::unique_ptr<ServerProcesses> processes;
+  std::vector<std::string> servers = split(FLAGS_servers);
+  if (!FLAGS_server_binary.empty()) {
+    processes.reset(new ServerProcesses);
+    servers = ServerProcesses::Addresses();
+  }
+  Cluster cluster(servers);
+
+  // wait for the cluster to elect a leader.
+  cluster.RefreshLeader(cluster.Leader());
+  if (FLAGS_preload) {
+    preload(&cluster);
+  }
+
+  std::unique_ptr<ZipfianGenerator> zipf;
+  if (FLAGS_key_dist == "zipfian") {
+    zipf.reset(new ZipfianGenerator(FLAGS_record_count, FLAGS_zipf_theta));
+  }
+
+  std::cout << fmt::format(
+      "running {} threads for {}s, {:.0f}% reads, {} keys, values of {}-{} bytes\n",
+      FLAGS_threads, FLAGS_duration_sec, FLAGS_read_ratio * 100, FLAGS_key_dist,
+      FLAGS_value_size, std::max(FLAGS_value_size, FLAGS_value_size_max));
+
+  Stats stats(FLAGS_duration_sec);
+  std::vector<Histogram> reads(FLAGS_threads), writes(FLAGS_threads);
+  Clock::time_point start = Clock::now();
+  std::vector<std::thread> clients;
+  for (int t = 0; t < FLAGS_threads; t++) {
+    clients.emplace_back(runClient, t + 1, &cluster, zipf.get(), start, &stats, &reads[t],
+                         &writes[t]);
+  }
+
+  if (FLAGS_kill_leader_at_sec > 0) {
+    std::this_thread::sleep_until(start + std::chrono::seconds(FLAGS_kill_leader_at_sec));
+    int leader = static_cast<int>(cluster.Leader()) + 1;
+    std::cout << fmt::format("killing the leader {} at {}s\n", leader, FLAGS_kill_leader_at_sec);
+    processes->Kill(leader);
+    std::this_thread::sleep_for(std::chrono::seconds(FLAGS_restart_after_sec));
+    std::cout << fmt::format("restarting server {}\n", leader);
+    processes->Start(leader);
+  }
+  for (auto& t : clients) {
+    t.join();
+  }
+  double elapsed = sinceUs(start) / 1e6;
+
+  uint64_t ok = 0, errors = 0;
+  std::cout << "second        ok    errors\n";
+  for (int s = 0; s < FLAGS_duration_sec; s++) {
+    std::cout << fmt::format("{:>6} {:>9} {:>9}\n", s, stats.okPerSec[s].load(),
+                             stats.errorsPerSec[s].load());
+  }
+  for (size_t s = 0; s < stats.okPerSec.size(); s++) {
+    ok += stats.okPerSec[s];
+    errors += stats.errorsPerSec[s];
+  }
+  std::cout << fmt::format("throughput: {:.0f} ops/s, errors: {}, read misses: {}\n",
+                           ok / elapsed, errors, stats.readMisses.load());
+  std::cout << fmt::format("longest stall: {:.1f}ms\n", stats.maxStallUs.load() / 1000.0);
+
+  Histogram readHist, writeHist;
+  for (int t = 0; t < FLAGS_threads; t++) {
+    readHist.Merge(reads[t]);
+    writeHist.Merge(writes[t]);
+  }
+  readHist.Print("read");
+  writeHist.Print("write");
+  return 0;
+}
@@ -16,15 +16,51 @@
 #include "logging.h"
 #include "memkv_service.h"
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
 #include <boost/make_unique.hpp>
+#include <bthread/mutex.h>
+#include <butil/gperftools_profiler.h>
 #include <consensus/base/env.h>
 #include <consensus/base/glog_logger.h>
+#include <consensus/base/memory_tracker.h>
 
 using namespace memkv;
 
 DEFINE_uint64(id, 1, "one of the values in {1, 2, 3}");
 DEFINE_string(wal_dir, "", "directory to store wal");
 DEFINE_int32(server_count, 3, "number of servers in the cluster");
+DEFINE_int32(learner_count, 0,
+             "number of learners following the servers, whose ids come after those of the "
+             "servers");
+DEFINE_bool(lease_read, false, "serve the reads on the leader locally while it holds the lease");
+DEFINE_int32(shards, 1, "number of raft groups the keyspace is split into");
+DEFINE_int32(cores, 0,
+             "split the shards over this many cores, each running its own raft thread, "
+             "flusher and wal, 0 shares them between all shards");
+DEFINE_int32(apply_threads, 1,
+             "apply the committed entries of each shard with this many threads, split by "
+             "the first segments of the paths");
+DEFINE_int32(value_log_threshold, 0,
+             "values of at least this many bytes are kept on disk, 0 keeps all in memory");
+DEFINE_uint64(checkpoint_interval, 0,
+              "checkpoint the store every this many log entries, so that a restart only "
+              "replays the log after the latest checkpoint, 0 disables the checkpoints");
+DEFINE_int32(handoff_timeout_ms, 3000,
+             "on SIGTERM, wait up to this long for the shards led by this server to elect "
+             "a follower, 0 quits without handing the leadership over");
+DEFINE_uint64(memory_soft_limit_mb, 0,
+              "past this much memory held by the logs and the store, the writes are pushed "
+              "back until it's released, 0 means no limit");
+DEFINE_int32(internal_port, -1,
+             "serve the builtin services of brpc, e.g. /hotspots and /vars, only on this "
+             "port, -1 serves them on the port of the server");
+DEFINE_string(profile_dir, "",
+              "If specified, the cpu and the lock contention of the first --profile_seconds "
+              "after the start are profiled into this directory.");
+DEFINE_int32(profile_seconds, 60, "how long the startup is profiled, see --profile_dir");
 DEFINE_string(memkv_log_dir, "",
               "If specified, logfiles are written into this directory instead "
               "of the default logging directory.");
@@ -41,9 +77,44 @@ void InitLogging(const char* argv0) {
   yaraft::SetLogger(boost::make_unique<consensus::GLogLogger>());
 }
 
+// The profiles of the startup, e.g. the replay of the log, are written as
+// <profile_dir>/memkv.<id>.{cpu,contention} in the pprof format. The cpu profiler is
+// only available when memkv_server is linked with gperftools.
+void StartProfilers() {
+  if (FLAGS_profile_dir.empty()) {
+    return;
+  }
+  FATAL_NOT_OK(consensus::Env::Default()->CreateDirIfMissing(FLAGS_profile_dir),
+               FLAGS_profile_dir);
+  std::string prefix = fmt::format("{}/memkv.{}.", FLAGS_profile_dir, FLAGS_id);
+
+  bool cpu = false;
+  if (ProfilerStart != nullptr) {
+    cpu = ProfilerStart((prefix + "cpu").c_str()) != 0;
+  } else {
+    FMT_LOG(WARNING, "memkv_server is built without gperftools, the cpu is not profiled");
+  }
+  bool contention = bthread::ContentionProfilerStart((prefix + "contention").c_str());
+  FMT_LOG(INFO, "profiling into {}*, cpu: {}, contention: {}", prefix, cpu, contention);
+
+  std::thread([cpu, contention]() {
+    std::this_thread::sleep_for(std::chrono::seconds(FLAGS_profile_seconds));
+    if (cpu) {
+      ProfilerStop();
+    }
+    if (contention) {
+      bthread::ContentionProfilerStop();
+    }
+    FMT_LOG(INFO, "profiling stopped after {}s", FLAGS_profile_seconds);
+  }).detach();
+}
+
 int main(int argc, char* argv[]) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
   InitLogging(argv[0]);
+  StartProfilers();
+  consensus::MemoryTracker::Instance().SetSoftLimit(
+      static_cast<int64_t>(FLAGS_memory_soft_limit_mb << 20));
 
   //
   // -- create DB instance --
@@ -51,10 +122,21 @@ int main(int argc, char* argv[]) {
   DBOptions options;
   options.member_id = FLAGS_id;
   options.wal_dir = FLAGS_wal_dir;
+  options.lease_read = FLAGS_lease_read;
+  options.shards = static_cast<uint32_t>(FLAGS_shards);
+  options.cores = static_cast<uint32_t>(std::max(FLAGS_cores, 0));
+  options.apply_threads = static_cast<uint32_t>(std::max(FLAGS_apply_threads, 1));
+  options.value_log_threshold = static_cast<size_t>(std::max(FLAGS_value_log_threshold, 0));
+  options.checkpoint_interval = FLAGS_checkpoint_interval;
   for (int i = 1; i <= FLAGS_server_count; i++) {
     // TODO: initial_cluster should be configured by user
     options.initial_cluster[i] = fmt::format("127.0.0.1:{}", 12320 + i);
   }
+  for (int i = FLAGS_server_count + 1; i <= FLAGS_server_count + FLAGS_learner_count; i++) {
+    options.learners[i] = fmt::format("127.0.0.1:{}", 12320 + i);
+  }
+  bool learner = options.learners.count(FLAGS_id) > 0;
+  std::string url = learner ? options.learners[FLAGS_id] : options.initial_cluster[FLAGS_id];
   auto sw = DB::Bootstrap(options);
   if (!sw.IsOK()) {
     LOG(FATAL) << sw.GetStatus();
@@ -64,15 +146,31 @@ int main(int argc, char* argv[]) {
   //
   // -- start memkv server --
   //
-  FMT_LOG(INFO, "Starting memkv server {} at {}", FLAGS_id, options.initial_cluster[FLAGS_id]);
+  FMT_LOG(INFO, "Starting memkv {} {} at {}", learner ? "learner" : "server", FLAGS_id, url);
   FMT_LOG(INFO, "--wal_dir: {}", FLAGS_wal_dir);
   brpc::ServerOptions opts;
   opts.num_threads = 1;
+  opts.internal_port = FLAGS_internal_port;
   brpc::Server server;
   server.AddService(new MemKVServiceImpl(db), brpc::SERVER_OWNS_SERVICE);
+  // the raft groups of all the shards are served here.
   server.AddService(db->CreateRaftServiceInstance(), brpc::SERVER_OWNS_SERVICE);
-  server.Start(options.initial_cluster[FLAGS_id].c_str(), &opts);
-  server.RunUntilAskedToQuit();
+  server.Start(url.c_str(), &opts);
+
+  // the raft services keep serving during the handoff, the successors are elected
+  // through them.
+  while (!brpc::IsAskedToQuit()) {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+  }
+  if (FLAGS_handoff_timeout_ms > 0) {
+    Status s = db->HandOffLeadership(static_cast<uint32_t>(FLAGS_handoff_timeout_ms));
+    if (!s.IsOK()) {
+      FMT_LOG(WARNING, "failed to hand the leadership over: {}", s.ToString());
+    }
+  }
+  FMT_LOG(INFO, "Stopping memkv server {}", FLAGS_id);
+  server.Stop(0);
+  server.Join();
 
   return 0;
 }
\ No newline at end of file
@@ -15,6 +15,11 @@
 #include "memkv_service.h"
 #include "logging.h"
 
+#include <atomic>
+
+#include <brpc/closure_guard.h>
+#include <brpc/stream.h>
+
 namespace memkv {
 
 static inline pb::ErrCode memkvErrorToRpcErrno(Error::ErrorCodes code) {
@@ -27,6 +32,10 @@ static inline pb::ErrCode memkvErrorToRpcErrno(Error::ErrorCodes code) {
       return pb::NodeNotExist;
     case Error::ConsensusError:
       return pb::ConsensusError;
+    case Error::IOError:
+      return pb::IOError;
+    case Error::Compacted:
+      return pb::Compacted;
     default:
       LOG(FATAL) << "Unexpected error code: " << Error::toString(code);
       return pb::OK;
@@ -41,26 +50,40 @@ void MemKVServiceImpl::Write(::google::protobuf::RpcController *controller,
                              ::memkv::pb::WriteResult *response,
                              ::google::protobuf::Closure *done) {
   auto cntl = static_cast<brpc::Controller *>(controller);
-  Status s;
+
+  // the RPC is finished in the completion callback, no thread waits for the commit.
+  auto onWritten = [response, done](const Status &s) {
+    response->set_errorcode(memkvErrorToRpcErrno(s.Code()));
+    if (!s.IsOK()) {
+      response->set_errormessage(s.ToString());
+    }
+    done->Run();
+  };
+
   if (cntl->has_http_request()) {
     Slice path(cntl->http_request().unresolved_path());
     Slice value(*cntl->http_request().uri().GetQuery("value"));
-    s = db_->Write(path, value);
+    db_->AsyncWrite(path, value, onWritten);
   } else {
-    s = db_->Write(request->path(), request->value());
-  }
-
-  response->set_errorcode(memkvErrorToRpcErrno(s.Code()));
-  if (!s.IsOK()) {
-    response->set_errormessage(s.ToString());
+    db_->AsyncWrite(request->path(), request->value(), onWritten);
   }
-  done->Run();
 }
 
 void MemKVServiceImpl::Read(::google::protobuf::RpcController *controller,
                             const ::memkv::pb::ReadRequest *request,
                             ::memkv::pb::ReadResult *response, ::google::protobuf::Closure *done) {
   auto cntl = static_cast<brpc::Controller *>(controller);
+  if (!cntl->has_http_request() && request->valueinattachment()) {
+    // the blocks of the value are referenced by the attachment, no copy is made.
+    Status s = db_->Get(request->path(), request->stale(), &cntl->response_attachment());
+    response->set_errorcode(memkvErrorToRpcErrno(s.Code()));
+    if (!s.IsOK()) {
+      response->set_errormessage(s.ToString());
+    }
+    done->Run();
+    return;
+  }
+
   auto result = new std::string;
   Status s;
   if (cntl->has_http_request()) {
@@ -86,11 +109,188 @@ void MemKVServiceImpl::Read(::google::protobuf::RpcController *controller,
   done->Run();
 }
 
+static const uint32_t kMaxListLimit = 1000;
+
+void MemKVServiceImpl::List(::google::protobuf::RpcController *controller,
+                            const ::memkv::pb::ListRequest *request,
+                            ::memkv::pb::ListResult *response, ::google::protobuf::Closure *done) {
+  brpc::ClosureGuard doneGuard(done);
+  auto cntl = static_cast<brpc::Controller *>(controller);
+
+  ListOptions options;
+  uint32_t limit = 0;
+  Slice path;
+  bool stale = false;
+  if (cntl->has_http_request()) {
+    cntl->set_pb_bytes_to_base64(false);
+
+    const brpc::URI &uri = cntl->http_request().uri();
+    path = cntl->http_request().unresolved_path();
+    if (uri.GetQuery("prefix")) {
+      options.prefix = *uri.GetQuery("prefix");
+    }
+    if (uri.GetQuery("cursor")) {
+      options.cursor = *uri.GetQuery("cursor");
+    }
+    if (uri.GetQuery("limit")) {
+      limit = static_cast<uint32_t>(strtoul(uri.GetQuery("limit")->c_str(), nullptr, 10));
+    }
+    options.values = uri.GetQuery("values") != nullptr;
+    stale = uri.GetQuery("stale") != nullptr;
+  } else {
+    path = request->path();
+    options.prefix = request->prefix();
+    options.cursor = request->cursor();
+    limit = request->limit();
+    options.values = request->withvalues();
+    stale = request->stale();
+  }
+  options.limit = (limit == 0 || limit > kMaxListLimit) ? kMaxListLimit : limit;
+
+  std::vector<ListEntry> entries;
+  bool more = false;
+  Status s = db_->List(path, options, stale, &entries, &more);
+  response->set_errorcode(memkvErrorToRpcErrno(s.Code()));
+  if (!s.IsOK()) {
+    response->set_errormessage(s.ToString());
+    return;
+  }
+
+  for (auto &e : entries) {
+    pb::ListEntry *entry = response->add_entries();
+    entry->mutable_name()->swap(e.name);
+    if (options.values) {
+      entry->mutable_value()->swap(e.value);
+    }
+  }
+  if (more) {
+    response->set_nextcursor(response->entries(response->entries_size() - 1).name());
+  }
+}
+
+void MemKVServiceImpl::Batch(::google::protobuf::RpcController *controller,
+                             const ::memkv::pb::BatchRequest *request,
+                             ::memkv::pb::BatchResult *response,
+                             ::google::protobuf::Closure *done) {
+  WriteBatch batch;
+  for (const pb::BatchOp &op : request->ops()) {
+    if (op.type() == pb::OpDelete) {
+      batch.Delete(op.path());
+    } else {
+      batch.Put(op.path(), op.value());
+    }
+  }
+
+  db_->AsyncWrite(std::move(batch), [response, done](const Status &s) {
+    response->set_errorcode(memkvErrorToRpcErrno(s.Code()));
+    if (!s.IsOK()) {
+      response->set_errormessage(s.ToString());
+    }
+    done->Run();
+  });
+}
+
 void MemKVServiceImpl::Delete(::google::protobuf::RpcController *controller,
                               const ::memkv::pb::DeleteRequest *request,
                               ::memkv::pb::DeleteResult *response,
                               ::google::protobuf::Closure *done) {}
 
+// WatchStream removes the watcher once its stream is closed, by either side. It's
+// released in on_closed, which may run before Watch is done with it.
+class WatchStream : public brpc::StreamInputHandler {
+ public:
+  static std::shared_ptr<WatchStream> New(DB *db) {
+    std::shared_ptr<WatchStream> handler(new WatchStream(db));
+    handler->self_ = handler;
+    return handler;
+  }
+
+  // nothing is expected from the client.
+  int on_received_messages(brpc::StreamId id, butil::IOBuf *const messages[],
+                           size_t size) override {
+    return 0;
+  }
+
+  void on_idle_timeout(brpc::StreamId id) override {}
+
+  void on_closed(brpc::StreamId id) override {
+    uint64_t watchId = watchId_.load();
+    if (watchId != 0) {
+      db_->Unwatch(watchId);
+    }
+    std::shared_ptr<WatchStream> self = std::move(self_);
+  }
+
+  // It's set before the response is sent, so the client can't close the stream before
+  // that. If the server closes it earlier, the watcher is already removed.
+  void SetWatchId(uint64_t id) {
+    watchId_.store(id);
+  }
+
+ private:
+  explicit WatchStream(DB *db) : db_(db) {}
+
+ private:
+  DB *db_;
+  std::atomic<uint64_t> watchId_{0};
+  std::shared_ptr<WatchStream> self_;
+};
+
+void MemKVServiceImpl::Watch(::google::protobuf::RpcController *controller,
+                             const ::memkv::pb::WatchRequest *request,
+                             ::memkv::pb::WatchResult *response,
+                             ::google::protobuf::Closure *done) {
+  brpc::ClosureGuard doneGuard(done);
+  auto cntl = static_cast<brpc::Controller *>(controller);
+  if (!cntl->has_remote_stream()) {
+    response->set_errorcode(pb::InvalidArgument);
+    response->set_errormessage("Watch requires a stream");
+    return;
+  }
+
+  std::shared_ptr<WatchStream> handler = WatchStream::New(db_.get());
+  brpc::StreamId stream;
+  brpc::StreamOptions options;
+  options.handler = handler.get();
+  if (brpc::StreamAccept(&stream, *cntl, &options) != 0) {
+    handler->on_closed(brpc::INVALID_STREAM_ID);
+    cntl->SetFailed("failed to accept stream");
+    return;
+  }
+
+  // It's called in the apply thread, the events are only queued in the stream. If the
+  // stream is full or closed, the watcher is dropped.
+  auto sink = [stream](const std::vector<const WatchEvent *> &events) -> bool {
+    pb::WatchEvents msg;
+    for (const WatchEvent *e : events) {
+      pb::WatchEvent *event = msg.add_events();
+      event->set_type(e->type == WatchEvent::kPut ? pb::OpWrite : pb::OpDelete);
+      event->set_path(e->path);
+      event->set_value(e->value);
+      event->set_index(e->index);
+    }
+    butil::IOBuf buf;
+    butil::IOBufAsZeroCopyOutputStream out(&buf);
+    if (!msg.SerializeToZeroCopyStream(&out) || brpc::StreamWrite(stream, buf) != 0) {
+      brpc::StreamClose(stream);
+      return false;
+    }
+    return true;
+  };
+
+  uint64_t fromIndex = request->fromindex();
+  uint64_t id = 0;
+  Status s = db_->Watch(request->path(), request->recursive(), &fromIndex, sink, &id);
+  response->set_errorcode(memkvErrorToRpcErrno(s.Code()));
+  if (!s.IsOK()) {
+    response->set_errormessage(s.ToString());
+    brpc::StreamClose(stream);
+    return;
+  }
+  handler->SetWatchId(id);
+  response->set_fromindex(fromIndex);
+}
+
 MemKVServiceImpl::MemKVServiceImpl(DB *db) : db_(db) {}
 
 MemKVServiceImpl::~MemKVServiceImpl() = default;
@@ -35,6 +35,25 @@ class MemKVServiceImpl : public pb::MemKVService {
               const ::memkv::pb::DeleteRequest* request, ::memkv::pb::DeleteResult* response,
               ::google::protobuf::Closure* done) override;
 
+  // Lists the children of a directory page by page, a page is limited to
+  // kMaxListLimit children.
+  // Via http: 'URL:PORT/List/abc?prefix=a&cursor=ab&limit=100&values&stale'
+  void List(::google::protobuf::RpcController* controller, const ::memkv::pb::ListRequest* request,
+            ::memkv::pb::ListResult* response, ::google::protobuf::Closure* done) override;
+
+  // Writes and deletes many paths at once, see DB::Write(WriteBatch&&).
+  void Batch(::google::protobuf::RpcController* controller,
+             const ::memkv::pb::BatchRequest* request, ::memkv::pb::BatchResult* response,
+             ::google::protobuf::Closure* done) override;
+
+  // Pushes the changes of a path to the stream created by the client with the request,
+  // see DB::Watch. Each message of the stream is a pb::WatchEvents. A slow client whose
+  // stream is full is disconnected, it resumes by watching again from the index of the
+  // last event received plus 1.
+  void Watch(::google::protobuf::RpcController* controller,
+             const ::memkv::pb::WatchRequest* request, ::memkv::pb::WatchResult* response,
+             ::google::protobuf::Closure* done) override;
+
   explicit MemKVServiceImpl(DB* db);
 
   ~MemKVServiceImpl() override;
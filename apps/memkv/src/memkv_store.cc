@@ -12,149 +12,505 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cstring>
+#include <map>
 #include <mutex>
-#include <unordered_map>
+#include <type_traits>
+#include <vector>
 
 #include "logging.h"
 #include "memkv_store.h"
 
-#include <boost/algorithm/string/split.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <butil/iobuf.h>
+#include <consensus/base/memory_tracker.h>
 
-namespace boost {
-template <>
-struct range_iterator<memkv::Slice> {
-  typedef memkv::Slice::const_iterator type;
+namespace memkv {
+
+static int compareName(const Slice &a, const Slice &b) {
+  int r = memcmp(a.data(), b.data(), std::min(a.size(), b.size()));
+  if (r != 0) {
+    return r;
+  }
+  return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
+struct SliceLess {
+  bool operator()(const Slice &a, const Slice &b) const {
+    return compareName(a, b) < 0;
+  }
 };
-}  // namespace boost
 
-namespace memkv {
+struct Node;
+
+// Children are looked up by the Slice of a path segment, keyed by the names the child
+// nodes own, so that no string is built for a lookup. They're ordered by name for
+// listing. Most nodes have a few children, they're kept in a sorted vector, which moves
+// to a tree once it grows beyond kMaxSorted.
+class Children {
+ public:
+  Node *Find(const Slice &name) const;
+
+  // The name of `child` must not change while it's a child.
+  void Insert(Node *child);
+
+  void Remove(Node *child);
+
+  template <class Function>
+  void ForEach(Function f) const {
+    if (tree_) {
+      for (auto &e : *tree_) {
+        f(e.second);
+      }
+      return;
+    }
+    for (Node *n : sorted_) {
+      f(n);
+    }
+  }
+
+  // Calls `f` on the children in the order of their names, from the first one not less
+  // than `from`, until `f` returns false.
+  template <class Function>
+  void Scan(const Slice &from, Function f) const;
 
+ private:
+  static const size_t kMaxSorted = 8;
+
+  std::vector<Node *> sorted_;
+
+  using Tree = std::map<Slice, Node *, SliceLess>;
+  std::unique_ptr<Tree> tree_;
+};
+
+// The children and data of a node are modified under the exclusive lock of `mu`, and
+// read under the shared lock, except by the writer of its stripe, which is the only one
+// mutating them. The root is mutated by the writers of every stripe, see
+// MemKvStore::Impl::find.
 struct Node {
-  using ChildrenTable = std::unordered_map<std::string, Node *>;
+  std::string name;
+  // shared with the readers rather than copied out, it's replaced rather than modified.
+  butil::IOBuf data;
+  Children children;
+
+  boost::shared_mutex mu;
+};
+
+static bool nameLess(const Node *n, const Slice &name) {
+  return compareName(n->name, name) < 0;
+}
+
+template <class Function>
+void Children::Scan(const Slice &from, Function f) const {
+  if (tree_) {
+    for (auto it = tree_->lower_bound(from); it != tree_->end(); ++it) {
+      if (!f(it->second)) {
+        return;
+      }
+    }
+    return;
+  }
+  for (auto it = std::lower_bound(sorted_.begin(), sorted_.end(), from, nameLess);
+       it != sorted_.end(); ++it) {
+    if (!f(*it)) {
+      return;
+    }
+  }
+}
+
+Node *Children::Find(const Slice &name) const {
+  if (tree_) {
+    auto it = tree_->find(name);
+    return it == tree_->end() ? nullptr : it->second;
+  }
+  auto it = std::lower_bound(sorted_.begin(), sorted_.end(), name, nameLess);
+  if (it == sorted_.end() || compareName((*it)->name, name) != 0) {
+    return nullptr;
+  }
+  return *it;
+}
+
+void Children::Insert(Node *child) {
+  if (!tree_ && sorted_.size() == kMaxSorted) {
+    tree_.reset(new Tree);
+    for (Node *n : sorted_) {
+      tree_->emplace(Slice(n->name), n);
+    }
+    std::vector<Node *>().swap(sorted_);
+  }
+  if (tree_) {
+    tree_->emplace(Slice(child->name), child);
+    return;
+  }
+  auto it = std::lower_bound(sorted_.begin(), sorted_.end(), Slice(child->name), nameLess);
+  sorted_.insert(it, child);
+}
+
+void Children::Remove(Node *child) {
+  if (tree_) {
+    tree_->erase(Slice(child->name));
+    return;
+  }
+  auto it = std::lower_bound(sorted_.begin(), sorted_.end(), Slice(child->name), nameLess);
+  if (it != sorted_.end() && *it == child) {
+    sorted_.erase(it);
+  }
+}
+
+// NodeArena allocates the nodes in blocks and recycles the freed ones, so that a write
+// doesn't go to the heap for each node it creates. It's only used by the writer of its
+// stripe.
+class NodeArena {
+ public:
+  Node *New(const Slice &name) {
+    if (!free_) {
+      grow();
+    }
+    void *p = free_;
+    free_ = *static_cast<void **>(p);
+
+    Node *n = new (p) Node;
+    n->name.assign(name.data(), name.size());
+    return n;
+  }
+
+  void Free(Node *n) {
+    n->~Node();
+    *reinterpret_cast<void **>(n) = free_;
+    free_ = n;
+  }
+
+ private:
+  void grow() {
+    blocks_.emplace_back(new Storage[kBlockNodes]);
+    Storage *block = blocks_.back().get();
+    for (size_t i = 0; i < kBlockNodes; i++) {
+      *reinterpret_cast<void **>(&block[i]) = free_;
+      free_ = &block[i];
+    }
+  }
+
+ private:
+  static const size_t kBlockNodes = 256;
+
+  using Storage = std::aligned_storage<sizeof(Node), alignof(Node)>::type;
+  std::vector<std::unique_ptr<Storage[]>> blocks_;
+
+  // the freed nodes linked through their first word.
+  void *free_{nullptr};
+};
+
+typedef boost::shared_lock<boost::shared_mutex> ReadLock;
+typedef boost::unique_lock<boost::shared_mutex> WriteLock;
+
+// Waits for the readers inside the subtree of `n`, which is already unlinked, to leave.
+// The readers only move downwards, holding the lock of a node until they have locked
+// its child, so after `n` is locked once, none of them can be in `n` any more.
+static void drainReaders(Node *n) {
+  { WriteLock lock(n->mu); }
+  n->children.ForEach(drainReaders);
+}
+
+// `*path` is the trimmed `p`.
+static Status validatePath(const Slice &p, Slice *path) {
+  *path = p;
+  path->TrimSpace();
+  if (UNLIKELY(path->Len() == 0)) {
+    return Status::Make(Error::InvalidArgument, "path is empty");
+  }
+
+  auto nul = static_cast<const char *>(memchr(path->data(), '\0', path->size()));
+  if (UNLIKELY(nul != nullptr)) {
+    return FMT_Status(InvalidArgument, "path contains NUL at index {}", nul - path->data());
+  }
+  return Status::OK();
+}
 
-  ~Node() {
-    for (auto &child : children) {
-      delete child.second;
+// PathSegments walks through the non-empty segments of a path in place.
+class PathSegments {
+ public:
+  explicit PathSegments(const Slice &path)
+      : p_(path.data()), end_(path.data() + path.size()) {}
+
+  // Returns false if there's no segment left.
+  bool Next(Slice *seg) {
+    while (p_ != end_ && *p_ == '/') {
+      p_++;
+    }
+    if (p_ == end_) {
+      return false;
     }
+    const char *begin = p_;
+    while (p_ != end_ && *p_ != '/') {
+      p_++;
+    }
+    *seg = Slice(begin, static_cast<size_t>(p_ - begin));
+    return true;
   }
 
-  ChildrenTable children;
-  std::string data;
+ private:
+  const char *p_;
+  const char *end_;
 };
 
+// `path` is trimmed.
+static size_t partitionOf(const Slice &path, size_t partitions) {
+  PathSegments segs(path);
+  Slice seg;
+  segs.Next(&seg);
+  // FNV-1a, mixed so that the partitions don't follow the shards, which are routed by
+  // the same hash.
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < seg.size(); i++) {
+    h = (h ^ static_cast<unsigned char>(seg[i])) * 1099511628211ULL;
+  }
+  h *= 11400714819323198485ULL;
+  return static_cast<size_t>((h >> 32) % partitions);
+}
+
+// The writes and deletes are serialized by the stripe of the first segment of their
+// paths, those of different stripes run concurrently as they touch disjoint subtrees.
 class MemKvStore::Impl {
  public:
-  Status Write(const Slice &path, const Slice &value) {
-    std::lock_guard<std::mutex> d(mu_);
+  ~Impl() {
+    root_.children.ForEach([this](Node *n) { freeTree(n, &stripeOf(n->name).arena); });
+  }
+
+  Status Write(const Slice &p, butil::IOBuf *value) {
+    Slice path;
+    RETURN_NOT_OK(validatePath(p, &path));
+
+    Stripe &stripe = stripeOf(path);
+    std::lock_guard<std::mutex> d(stripe.mu);
 
-    std::vector<Slice> pathVec;
-    ASSIGN_IF_OK(validatePath(path), pathVec);
+    butil::IOBuf &data = *value;
 
     Node *n = &root_;
-    for (const Slice &seg : pathVec) {
-      // ignore empty segment
-      if (seg.Len() == 0) {
-        continue;
+    PathSegments segs(path);
+    Slice seg;
+    bool missing = false;
+    while (segs.Next(&seg)) {
+      Node *child = find(n, seg);
+      if (!child) {
+        missing = true;
+        break;
       }
+      n = child;
+    }
 
-      auto result = n->children.emplace(std::make_pair(seg.ToString(), nullptr));
-      bool nodeNotExist = result.second;
-
-      Node **pNode = &result.first->second;
-      if (nodeNotExist) {
-        *pNode = new Node();
+    if (!missing) {
+      {
+        WriteLock lock(n->mu);
+        n->data.swap(data);
       }
+      // `data` holds the old value now.
+      consumeBytes(static_cast<int64_t>(n->data.size()) - static_cast<int64_t>(data.size()));
+      return Status::OK();
+    }
 
-      n = *pNode;
+    // the missing nodes are built before they're linked to the tree, so that the
+    // readers never see the new node without its data.
+    Node *head = stripe.arena.New(seg);
+    Node *tail = head;
+    int64_t bytes = nodeBytes(head);
+    while (segs.Next(&seg)) {
+      Node *child = stripe.arena.New(seg);
+      tail->children.Insert(child);
+      tail = child;
+      bytes += nodeBytes(child);
     }
+    tail->data.swap(data);
+    consumeBytes(bytes + static_cast<int64_t>(tail->data.size()));
 
-    n->data = value.ToString();
+    WriteLock lock(n->mu);
+    n->children.Insert(head);
     return Status::OK();
   }
 
-  Status Delete(const Slice &path) {
-    std::lock_guard<std::mutex> d(mu_);
+  Status Delete(const Slice &p) {
+    Slice path;
+    RETURN_NOT_OK(validatePath(p, &path));
 
-    std::vector<Slice> pathVec;
-    ASSIGN_IF_OK(validatePath(path), pathVec);
+    Stripe &stripe = stripeOf(path);
+    std::lock_guard<std::mutex> d(stripe.mu);
 
-    Node *n = &root_;
-    for (auto segIt = pathVec.begin(); segIt != pathVec.end(); segIt++) {
-      Slice seg = *segIt;
+    PathSegments segs(path);
+    Slice seg;
+    if (!segs.Next(&seg)) {
+      return Status::Make(Error::InvalidArgument, "cannot delete root directory");
+    }
 
-      if (seg.Len() == 0) {
-        continue;
-      }
+    Node *parent = &root_;
+    Node *n = find(parent, seg);
+    while (n && segs.Next(&seg)) {
+      parent = n;
+      n = n->children.Find(seg);
+    }
+    if (!n) {
+      // the given path is deleted
+      return Status::OK();
+    }
+
+    {
+      WriteLock lock(parent->mu);
+      parent->children.Remove(n);
+    }
+    drainReaders(n);
+    freeTree(n, &stripe.arena);
+    return Status::OK();
+  }
+
+  // Only the references to the blocks of the data are copied.
+  Status Get(const Slice &path, butil::IOBuf *data) {
+    Node *n;
+    ReadLock lock;
+    RETURN_NOT_OK(lockPath(path, &n, &lock));
 
-      auto it = n->children.find(seg.ToString());
-      if (it == n->children.end()) {
-        // the given path is deleted
-        return Status::OK();
+    *data = n->data;
+    return Status::OK();
+  }
+
+  Status List(const Slice &path, const ListOptions &options, std::vector<ListEntry> *entries,
+              bool *more) {
+    Node *n;
+    ReadLock lock;
+    RETURN_NOT_OK(lockPath(path, &n, &lock));
+
+    // continues after the cursor, unless it's before the prefix.
+    bool afterCursor = !options.cursor.empty() && compareName(options.cursor, options.prefix) >= 0;
+    Slice from = afterCursor ? options.cursor : options.prefix;
+
+    *more = false;
+    n->children.Scan(from, [&](Node *child) -> bool {
+      if (afterCursor && compareName(child->name, options.cursor) == 0) {
+        return true;
+      }
+      if (child->name.compare(0, options.prefix.size(), options.prefix.data(),
+                              options.prefix.size()) != 0) {
+        return false;
+      }
+      if (options.limit != 0 && entries->size() == options.limit) {
+        *more = true;
+        return false;
       }
 
-      // we have found the matched node, delete it now.
-      if (std::next(segIt) == pathVec.end()) {
-        n->children.erase(it);
-        return Status::OK();
+      ListEntry e;
+      e.name = child->name;
+      if (options.values) {
+        ReadLock childLock(child->mu);
+        child->data.copy_to(&e.value);
       }
+      entries->push_back(std::move(e));
+      return true;
+    });
+    return Status::OK();
+  }
 
-      n = it->second;
+  // The writers are the only ones mutating the tree, no node is locked once they're all
+  // excluded.
+  void Collect(std::vector<std::pair<std::string, butil::IOBuf>> *nodes) {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (Stripe &stripe : stripes_) {
+      locks.emplace_back(stripe.mu);
     }
-
-    return Status::Make(Error::InvalidArgument, "cannot delete root directory");
+    std::string path;
+    collect(&root_, &path, nodes);
   }
 
-  Status Get(const Slice &path, std::string *data) {
-    std::lock_guard<std::mutex> d(mu_);
+ private:
+  void collect(Node *n, std::string *path,
+               std::vector<std::pair<std::string, butil::IOBuf>> *nodes) {
+    size_t len = path->size();
+    n->children.ForEach([&](Node *child) {
+      path->push_back('/');
+      path->append(child->name);
+      nodes->emplace_back(*path, child->data);
+      collect(child, path, nodes);
+      path->resize(len);
+    });
+  }
 
-    std::vector<Slice> pathVec;
-    ASSIGN_IF_OK(validatePath(path), pathVec);
+  // The readers lock the nodes hand over hand along the path, they're only blocked by
+  // the writer modifying the same node, never by each other. `*lock` holds the shared
+  // lock of the node at `p` on success.
+  Status lockPath(const Slice &p, Node **node, ReadLock *lock) {
+    Slice path;
+    RETURN_NOT_OK(validatePath(p, &path));
 
     Node *n = &root_;
-    for (const Slice &seg : pathVec) {
-      if (seg.Len() == 0) {
-        continue;
+    ReadLock rootLock(n->mu);
+    lock->swap(rootLock);
+    PathSegments segs(path);
+    Slice seg;
+    while (segs.Next(&seg)) {
+      n = n->children.Find(seg);
+      if (!n) {
+        return FMT_Status(NodeNotExist, "node does not exist on path {}", p.data());
       }
 
-      auto it = n->children.find(seg.ToString());
-      if (it == n->children.end()) {
-        return FMT_Status(NodeNotExist, "node does not exist on path {}", path.data());
-      }
-
-      n = it->second;
+      ReadLock childLock(n->mu);
+      lock->swap(childLock);
     }
 
-    *data = n->data;
+    *node = n;
     return Status::OK();
   }
 
- private:
-  StatusWith<std::vector<Slice>> validatePath(const Slice &p) {
-    Slice path = p;
-    path.TrimSpace();
-    if (UNLIKELY(path.Len() == 0)) {
-      return Status::Make(Error::InvalidArgument, "path is empty");
-    }
+  void freeTree(Node *n, NodeArena *arena) {
+    n->children.ForEach([this, arena](Node *c) { freeTree(c, arena); });
+    consumeBytes(-(nodeBytes(n) + static_cast<int64_t>(n->data.size())));
+    arena->Free(n);
+  }
 
-    for (size_t i = 0; i < path.size(); i++) {
-      if (path[i] == '\0') {
-        return FMT_Status(InvalidArgument, "path contains NUL at index {}", i);
-      }
+  // The children of the root are inserted and removed by the writers of all stripes,
+  // they're looked up under its shared lock. Those of the other nodes are only mutated
+  // by the calling writer.
+  Node *find(Node *n, const Slice &name) {
+    if (n != &root_) {
+      return n->children.Find(name);
     }
+    ReadLock lock(root_.mu);
+    return n->children.Find(name);
+  }
 
-    std::vector<Slice> result;
-    boost::split(result, path, [](char c) { return c == '/'; });
-    return result;
+  // The nodes and their data are accounted to MemoryTracker::kApplication.
+  static int64_t nodeBytes(const Node *n) {
+    return static_cast<int64_t>(sizeof(Node) + n->name.size());
+  }
+
+  static void consumeBytes(int64_t bytes) {
+    consensus::MemoryTracker::Instance().Consume(consensus::MemoryTracker::kApplication,
+                                                 bytes);
   }
 
  private:
-  Node root_;
+  static const size_t kStripes = 16;
+
+  struct Stripe {
+    // serializes the Write-s and Delete-s of the stripe.
+    std::mutex mu;
+    // the nodes of the subtrees in the stripe.
+    NodeArena arena;
+  };
 
-  mutable std::mutex mu_;
+  Stripe &stripeOf(const Slice &path) {
+    return stripes_[partitionOf(path, kStripes)];
+  }
+
+  Stripe stripes_[kStripes];
+
+  Node root_;
 };
 
 Status MemKvStore::Write(const Slice &path, const Slice &value) {
-  return impl_->Write(path, value);
+  butil::IOBuf data;
+  data.append(value.data(), value.size());
+  return impl_->Write(path, &data);
+}
+
+Status MemKvStore::Write(const Slice &path, butil::IOBuf &&value) {
+  return impl_->Write(path, &value);
 }
 
 Status MemKvStore::Delete(const Slice &path) {
@@ -162,9 +518,38 @@ Status MemKvStore::Delete(const Slice &path) {
 }
 
 Status MemKvStore::Get(const Slice &path, std::string *data) {
+  butil::IOBuf buf;
+  RETURN_NOT_OK(impl_->Get(path, &buf));
+  buf.copy_to(data);
+  return Status::OK();
+}
+
+Status MemKvStore::Get(const Slice &path, butil::IOBuf *data) {
   return impl_->Get(path, data);
 }
 
+Status MemKvStore::List(const Slice &path, const ListOptions &options,
+                        std::vector<ListEntry> *entries, bool *more) {
+  return impl_->List(path, options, entries, more);
+}
+
+void MemKvStore::Collect(std::vector<std::pair<std::string, butil::IOBuf>> *nodes) {
+  impl_->Collect(nodes);
+}
+
+Status MemKvStore::ValidatePath(const Slice &path) {
+  Slice trimmed;
+  return validatePath(path, &trimmed);
+}
+
+size_t MemKvStore::PartitionOf(const Slice &path, size_t partitions) {
+  Slice trimmed;
+  if (partitions <= 1 || !validatePath(path, &trimmed).IsOK()) {
+    return 0;
+  }
+  return partitionOf(trimmed, partitions);
+}
+
 MemKvStore::MemKvStore() : impl_(new Impl) {}
 
 MemKvStore::~MemKvStore() = default;
@@ -14,22 +14,80 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "slice.h"
 #include "status.h"
 
+namespace butil {
+class IOBuf;
+}  // namespace butil
+
 namespace memkv {
 
+struct ListOptions {
+  // only the children whose names start with `prefix` are listed.
+  Slice prefix;
+
+  // the listing continues after the child named `cursor`, if it's not empty.
+  Slice cursor;
+
+  // at most `limit` children are listed, 0 means no limit.
+  size_t limit{0};
+
+  // whether the data of the children are listed as well.
+  bool values{false};
+};
+
+struct ListEntry {
+  std::string name;
+  std::string value;
+};
+
 // MemKvStore is the internal in-memory storage of memkv. It's thread-safe.
 // A request will first go through DB, after WAL committed, it finally applies
 // in MemKvStore.
+// The writes to the paths of the same first segment are serialized, the others run
+// concurrently. The reads run concurrently with each other and with the writes to other
+// nodes, see MemKvStore::Impl::Get.
 class MemKvStore {
  public:
   Status Write(const Slice &path, const Slice &value);
 
+  // Same as above, except that the value is taken over without being copied.
+  Status Write(const Slice &path, butil::IOBuf &&value);
+
   Status Delete(const Slice &path);
 
   Status Get(const Slice &path, std::string *data);
 
+  // The value is shared with the store, none of it is copied. It stays valid and
+  // unchanged after it's overwritten or deleted.
+  Status Get(const Slice &path, butil::IOBuf *data);
+
+  // Lists the children of the node at `path` in the order of their names. `*more` is set
+  // if some are left beyond the limit, the next page starts after the last entry.
+  Status List(const Slice &path, const ListOptions &options, std::vector<ListEntry> *entries,
+              bool *more);
+
+  // Collects the paths and data of all the nodes but the root, in the order of the tree:
+  // a parent before its children, the children in the order of their names. The data
+  // are shared rather than copied, and they're replaced rather than modified by the
+  // later writes, so the nodes collected are a consistent view of the store at the time
+  // of the call, which only blocks the writes while the tree is walked.
+  void Collect(std::vector<std::pair<std::string, butil::IOBuf>> *nodes);
+
+  // Checks if `path` is accepted by Write and Delete.
+  static Status ValidatePath(const Slice &path);
+
+  // The paths are partitioned by their first segments. The Write-s and Delete-s of the
+  // paths in different partitions touch disjoint subtrees, the order between them
+  // doesn't matter. An invalid path is in partition 0.
+  static size_t PartitionOf(const Slice &path, size_t partitions);
+
   MemKvStore();
 
   ~MemKvStore();
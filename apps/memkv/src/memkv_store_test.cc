@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
+#include <thread>
 #include <unordered_map>
 
 #include "memkv_store.h"
@@ -112,4 +114,109 @@ TEST_F(TestMemKV, DeleteRecursively) {
   ASSERT_OK(kv.Delete("/tmp/xiaomi/ads/pegasus-1"));
   ASSERT_OK(kv.Get("/tmp/xiaomi/ads", &actual));
   ASSERT_ERROR(kv.Get("/tmp/xiaomi/ads/pegasus-1", &actual), Error::NodeNotExist);
-}
\ No newline at end of file
+}
+// The readers see either the value or no node while the writer keeps replacing and
+// deleting the subtree under them.
+TEST_F(TestMemKV, ConcurrentReadWrite) {
+  MemKvStore kv;
+  std::atomic<bool> stop(false);
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&]() {
+      while (!stop.load()) {
+        std::string actual;
+        Status s = kv.Get("/tmp/a/b/c", &actual);
+        if (s.IsOK()) {
+          ASSERT_EQ(actual, "1");
+        } else {
+          ASSERT_ERROR(s, Error::NodeNotExist);
+        }
+      }
+    });
+  }
+
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_OK(kv.Write("/tmp/a/b/c", "1"));
+    ASSERT_OK(kv.Delete("/tmp/a"));
+  }
+  stop.store(true);
+  for (auto &t : readers) {
+    t.join();
+  }
+}
+
+TEST_F(TestMemKV, List) {
+  MemKvStore kv;
+  // beyond the children kept in the sorted vector.
+  for (int i = 19; i >= 0; i--) {
+    ASSERT_OK(kv.Write(fmt::format("/dir/k{:02d}", i), std::to_string(i)));
+  }
+  ASSERT_OK(kv.Write("/dir/other", "x"));
+  ASSERT_OK(kv.Write("/dir/k05/child", "y"));
+
+  ListOptions options;
+  options.prefix = "k";
+  options.limit = 8;
+  options.values = true;
+
+  std::vector<ListEntry> entries;
+  std::string cursor;
+  bool more = true;
+  while (more) {
+    std::vector<ListEntry> page;
+    options.cursor = cursor;
+    ASSERT_OK(kv.List("/dir", options, &page, &more));
+    ASSERT_LE(page.size(), options.limit);
+    ASSERT_FALSE(page.empty());
+    cursor = page.back().name;
+    entries.insert(entries.end(), page.begin(), page.end());
+  }
+
+  ASSERT_EQ(entries.size(), 20);
+  for (int i = 0; i < 20; i++) {
+    ASSERT_EQ(entries[i].name, fmt::format("k{:02d}", i));
+    ASSERT_EQ(entries[i].value, std::to_string(i));
+  }
+
+  std::vector<ListEntry> page;
+  ASSERT_ERROR(kv.List("/none", ListOptions(), &page, &more), Error::NodeNotExist);
+}
+
+// The writers of different first segments run concurrently, each sees its own subtree
+// as if it were alone.
+TEST_F(TestMemKV, ConcurrentWriters) {
+  MemKvStore kv;
+
+  std::vector<std::thread> writers;
+  for (int w = 0; w < 8; w++) {
+    writers.emplace_back([&kv, w]() {
+      std::string dir = "/w" + std::to_string(w);
+      for (int i = 0; i < 1000; i++) {
+        std::string path = dir + "/d" + std::to_string(i % 3) + "/k" + std::to_string(i % 10);
+        ASSERT_OK(kv.Write(path, std::to_string(i)));
+        std::string actual;
+        ASSERT_OK(kv.Get(path, &actual));
+        ASSERT_EQ(actual, std::to_string(i));
+        if (i % 100 == 99) {
+          ASSERT_OK(kv.Delete(dir + "/d" + std::to_string(i % 3)));
+        }
+      }
+    });
+  }
+  for (auto &t : writers) {
+    t.join();
+  }
+
+  std::vector<ListEntry> entries;
+  bool more;
+  ASSERT_OK(kv.List("/", ListOptions(), &entries, &more));
+  ASSERT_EQ(entries.size(), 8);
+}
+
+TEST_F(TestMemKV, PartitionOf) {
+  ASSERT_EQ(MemKvStore::PartitionOf("/a/b", 1), 0);
+  ASSERT_EQ(MemKvStore::PartitionOf("/a/b", 8), MemKvStore::PartitionOf("a", 8));
+  ASSERT_EQ(MemKvStore::PartitionOf("/a/b", 8), MemKvStore::PartitionOf("//a/c/d", 8));
+  ASSERT_LT(MemKvStore::PartitionOf("/b", 8), 8);
+}
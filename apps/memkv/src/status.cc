@@ -29,6 +29,8 @@ std::string Error::toString(unsigned int c) {
     ERROR_TO_STRING(InvalidArgument);
     ERROR_TO_STRING(NodeNotExist);
     ERROR_TO_STRING(ConsensusError);
+    ERROR_TO_STRING(IOError);
+    ERROR_TO_STRING(Compacted);
     default:
       LOG(FATAL) << "invalid error code: " << c;
       assert(false);
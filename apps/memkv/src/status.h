@@ -26,6 +26,8 @@ class Error {
     InvalidArgument,
     NodeNotExist,
     ConsensusError,
+    IOError,
+    Compacted,
   };
 
   static std::string toString(unsigned int code);
@@ -0,0 +1,119 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "value_log.h"
+#include "logging.h"
+
+#include <consensus/base/coding.h>
+#include <consensus/base/crc32c.h>
+#include <consensus/base/env_util.h>
+
+namespace memkv {
+
+// Fixed32 crc32c of the value.
+constexpr static size_t kRecordHeaderSize = 4;
+
+static Status fromConsensus(const consensus::Status &s) {
+  return Status::Make(Error::IOError, s.ToString());
+}
+
+Status ValueLog::Open(const std::string &fname, size_t cacheBytes,
+                      std::unique_ptr<ValueLog> *log) {
+  consensus::Env *env = consensus::Env::Default();
+  std::unique_ptr<ValueLog> vlog(new ValueLog(cacheBytes));
+
+  auto wf = env->NewWritableFile(fname);
+  if (!wf.IsOK()) {
+    return fromConsensus(wf.GetStatus());
+  }
+  vlog->writer_.reset(wf.GetValue());
+
+  auto rf = env->NewRandomAccessFile(fname);
+  if (!rf.IsOK()) {
+    return fromConsensus(rf.GetStatus());
+  }
+  vlog->reader_.reset(rf.GetValue());
+
+  *log = std::move(vlog);
+  return Status::OK();
+}
+
+ValueLog::~ValueLog() {
+  if (writer_) {
+    WARN_NOT_OK(writer_->Close(), "ValueLog: close " + writer_->filename());
+  }
+}
+
+Status ValueLog::Append(const Slice &value, ValuePointer *ptr) {
+  char header[kRecordHeaderSize];
+  consensus::EncodeFixed32(header, consensus::crc32c::Value(value.data(), value.size()));
+  consensus::Slice record[] = {consensus::Slice(header, sizeof(header)), value};
+  consensus::Status s = writer_->AppendV(record, 2);
+  if (!s.IsOK()) {
+    return fromConsensus(s);
+  }
+  ptr->offset = size_;
+  ptr->size = static_cast<uint32_t>(value.size());
+  size_ += kRecordHeaderSize + value.size();
+  return Status::OK();
+}
+
+Status ValueLog::Read(const ValuePointer &ptr, std::string *value) {
+  {
+    std::lock_guard<std::mutex> g(mu_);
+    auto it = cached_.find(ptr.offset);
+    if (it != cached_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      *value = it->second->second;
+      return Status::OK();
+    }
+  }
+
+  // a short read is an error of ReadFully.
+  std::string record(kRecordHeaderSize + ptr.size, '\0');
+  consensus::Slice result;
+  consensus::Status s =
+      consensus::env_util::ReadFully(reader_.get(), ptr.offset, record.size(), &result, &record[0]);
+  if (!s.IsOK()) {
+    return fromConsensus(s) << " [value log: " << reader_->filename() << "]";
+  }
+  const char *data = result.data() + kRecordHeaderSize;
+  if (consensus::DecodeFixed32(result.data()) != consensus::crc32c::Value(data, ptr.size)) {
+    return FMT_Status(IOError, "value of {} bytes at offset {} of {} is corrupted", ptr.size,
+                      ptr.offset, reader_->filename());
+  }
+  value->assign(data, ptr.size);
+  cache(ptr.offset, *value);
+  return Status::OK();
+}
+
+void ValueLog::cache(uint64_t offset, const std::string &value) {
+  if (value.size() > cacheBytes_) {
+    return;
+  }
+  std::lock_guard<std::mutex> g(mu_);
+  if (cached_.find(offset) != cached_.end()) {
+    return;
+  }
+  lru_.emplace_front(offset, value);
+  cached_[offset] = lru_.begin();
+  cachedBytes_ += value.size();
+  while (cachedBytes_ > cacheBytes_) {
+    cachedBytes_ -= lru_.back().second.size();
+    cached_.erase(lru_.back().first);
+    lru_.pop_back();
+  }
+}
+
+}  // namespace memkv
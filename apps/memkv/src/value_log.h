@@ -0,0 +1,81 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "slice.h"
+#include "status.h"
+
+#include <consensus/base/env.h>
+
+namespace memkv {
+
+// Location of a value in the ValueLog.
+struct ValuePointer {
+  uint64_t offset;
+  uint32_t size;
+};
+
+// ValueLog keeps the large values of a MemKvStore in an append-only file rather than
+// in memory, the store holds their ValuePointer-s instead. The recently read values
+// are cached up to a number of bytes.
+//
+// It keeps the values out of memory only, the raft entries still carry them, so that
+// the followers apply them from the entries replicated, and the file is local to the
+// member. The entries are not shrunk to pointers, which would be valid on the leader
+// alone.
+//
+// The file is rewritten from scratch on Open, like the store that's rebuilt by
+// replaying the wal, or by loading a checkpoint, which holds the values rather than
+// their pointers, and appends them again. The overwritten and deleted values are not
+// reclaimed until then.
+// A record is the Fixed32 crc32c of the value followed by the value, a ValuePointer
+// locates the record. A value that's cut short or fails the checksum is IOError.
+//
+// Append is called by one thread at a time, Read is thread-safe.
+class ValueLog {
+ public:
+  static Status Open(const std::string &fname, size_t cacheBytes, std::unique_ptr<ValueLog> *log);
+
+  ~ValueLog();
+
+  Status Append(const Slice &value, ValuePointer *ptr);
+
+  Status Read(const ValuePointer &ptr, std::string *value);
+
+ private:
+  ValueLog(size_t cacheBytes) : cacheBytes_(cacheBytes) {}
+
+  void cache(uint64_t offset, const std::string &value);
+
+ private:
+  std::unique_ptr<consensus::WritableFile> writer_;
+  std::unique_ptr<consensus::RandomAccessFile> reader_;
+  uint64_t size_{0};
+
+  // LRU cache of the values by their offsets.
+  const size_t cacheBytes_;
+  std::mutex mu_;
+  size_t cachedBytes_{0};
+  std::list<std::pair<uint64_t, std::string>> lru_;
+  std::unordered_map<uint64_t, std::list<std::pair<uint64_t, std::string>>::iterator> cached_;
+};
+
+}  // namespace memkv
@@ -0,0 +1,107 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <string>
+#include <vector>
+
+#include "testing.h"
+#include "value_log.h"
+
+#include <consensus/base/env_util.h>
+
+using namespace memkv;
+
+class ValueLogTest : public testing::Test {
+ public:
+  ValueLogTest() : dir_("/tmp/memkv.ValueLogTest"), fname_(dir_ + "/values") {
+    consensus::Env::Default()->DeleteRecursively(dir_);
+    FATAL_NOT_OK(consensus::Env::Default()->CreateDirIfMissing(dir_), "create " + dir_);
+  }
+
+  ~ValueLogTest() override {
+    consensus::Env::Default()->DeleteRecursively(dir_);
+  }
+
+  // Rewrites the file with `data`, while the log keeps it open.
+  void rewrite(const std::string &data) {
+    consensus::WritableFile *wf;
+    ASSIGN_IF_ASSERT_OK(consensus::Env::Default()->NewWritableFile(fname_), wf);
+    std::unique_ptr<consensus::WritableFile> f(wf);
+    ASSERT_OK(f->Append(data));
+    ASSERT_OK(f->Close());
+  }
+
+  std::string content() {
+    auto sw = consensus::Env::Default()->NewRandomAccessFile(fname_);
+    FATAL_NOT_OK(sw.GetStatus(), "open " + fname_);
+    consensus::RandomAccessFile *rf = sw.GetValue();
+    std::unique_ptr<consensus::RandomAccessFile> f(rf);
+    std::string data(f->Size().GetValue(), '\0');
+    consensus::Slice s;
+    FATAL_NOT_OK(consensus::env_util::ReadFully(rf, 0, data.size(), &s, &data[0]), "read");
+    return s.ToString();
+  }
+
+ protected:
+  std::string dir_;
+  std::string fname_;
+};
+
+TEST_F(ValueLogTest, AppendAndRead) {
+  for (size_t cacheBytes : {size_t(0), size_t(1 << 20)}) {
+    std::unique_ptr<ValueLog> log;
+    ASSERT_OK(ValueLog::Open(fname_, cacheBytes, &log));
+
+    std::vector<std::string> values;
+    std::vector<ValuePointer> ptrs;
+    for (int i = 0; i < 100; i++) {
+      values.push_back(std::string(i * 37, static_cast<char>('a' + i % 26)));
+      ValuePointer ptr;
+      ASSERT_OK(log->Append(values.back(), &ptr));
+      ASSERT_EQ(ptr.size, values.back().size());
+      ptrs.push_back(ptr);
+    }
+    // twice, from the file and the cache.
+    for (int round = 0; round < 2; round++) {
+      for (size_t i = 0; i < values.size(); i++) {
+        std::string value;
+        ASSERT_OK(log->Read(ptrs[i], &value));
+        ASSERT_EQ(value, values[i]);
+      }
+    }
+  }
+}
+
+// This test verifies that a value cut short by the end of file, or failing the
+// checksum, is an error rather than returned.
+TEST_F(ValueLogTest, TruncatedOrCorrupted) {
+  std::unique_ptr<ValueLog> log;
+  ASSERT_OK(ValueLog::Open(fname_, 0, &log));
+  ValuePointer first, second;
+  ASSERT_OK(log->Append(std::string(100, 'x'), &first));
+  ASSERT_OK(log->Append(std::string(100, 'y'), &second));
+  std::string data = content();
+
+  rewrite(data.substr(0, data.size() - 10));
+  std::string value;
+  ASSERT_OK(log->Read(first, &value));
+  ASSERT_EQ(value, std::string(100, 'x'));
+  ASSERT_ERROR(log->Read(second, &value), Error::IOError);
+
+  data[second.offset + 50] ^= 1;
+  rewrite(data);
+  ASSERT_OK(log->Read(first, &value));
+  ASSERT_ERROR(log->Read(second, &value), Error::IOError);
+}
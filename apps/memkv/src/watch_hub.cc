@@ -0,0 +1,196 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "watch_hub.h"
+#include "logging.h"
+
+#include <algorithm>
+
+namespace memkv {
+
+WatchHub::WatchHub(size_t maxEvents, size_t maxBytes)
+    : maxEvents_(maxEvents), maxBytes_(maxBytes) {}
+
+// The same as the paths of MemKvStore: the spaces around are trimmed, and the empty
+// segments are skipped.
+std::string WatchHub::NormalizePath(const Slice &p) {
+  Slice path = p;
+  path.TrimSpace();
+
+  std::string result;
+  size_t i = 0;
+  while (i < path.size()) {
+    while (i < path.size() && path[i] == '/') {
+      i++;
+    }
+    size_t begin = i;
+    while (i < path.size() && path[i] != '/') {
+      i++;
+    }
+    if (i > begin) {
+      result.push_back('/');
+      result.append(path.data() + begin, i - begin);
+    }
+  }
+  return result.empty() ? "/" : result;
+}
+
+static bool isUnder(const std::string &path, const std::string &dir) {
+  if (dir == "/") {
+    return path != "/";
+  }
+  return path.size() > dir.size() && path[dir.size()] == '/' &&
+         path.compare(0, dir.size(), dir) == 0;
+}
+
+bool WatchHub::covers(const Watcher &w, const WatchEvent &e) {
+  return w.path == e.path || (w.recursive && isUnder(e.path, w.path)) ||
+         (e.type == WatchEvent::kDelete && isUnder(w.path, e.path));
+}
+
+void WatchHub::match(const WatchEvent &e, Matches *matches) {
+  // the watchers of the path and of its ancestors, from the root down.
+  size_t end = 0;
+  while (true) {
+    std::string dir = end == 0 ? "/" : e.path.substr(0, end);
+    auto range = byPath_.equal_range(dir);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second->recursive || dir == e.path) {
+        (*matches)[it->second].push_back(&e);
+      }
+    }
+    if (end == e.path.size() || e.path == "/") {
+      break;
+    }
+    end = e.path.find('/', end + 1);
+    if (end == std::string::npos) {
+      end = e.path.size();
+    }
+  }
+
+  // the watchers in the deleted subtree.
+  if (e.type == WatchEvent::kDelete && e.path != "/") {
+    std::string prefix = e.path + "/";
+    for (auto it = byPath_.lower_bound(prefix);
+         it != byPath_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+      (*matches)[it->second].push_back(&e);
+    }
+  }
+}
+
+void WatchHub::Append(uint64_t index, std::vector<WatchEvent> &&events) {
+  std::lock_guard<std::mutex> g(mu_);
+  appliedIndex_ = index;
+  if (events.empty()) {
+    return;
+  }
+
+  size_t first = history_.size(), added = events.size();
+  for (auto &e : events) {
+    e.index = index;
+    historyBytes_ += e.path.size() + e.value.size();
+    history_.push_back(std::move(e));
+  }
+
+  Matches matches;
+  for (size_t i = first; i < history_.size(); i++) {
+    match(history_[i], &matches);
+  }
+  for (auto &m : matches) {
+    if (!m.first->sink(m.second)) {
+      remove(m.first);
+    }
+  }
+
+  // the new events are kept even if they alone exceed the limits.
+  while (history_.size() > added &&
+         (history_.size() > maxEvents_ || historyBytes_ > maxBytes_)) {
+    const WatchEvent &e = history_.front();
+    compactedIndex_ = e.index;
+    historyBytes_ -= e.path.size() + e.value.size();
+    history_.pop_front();
+  }
+}
+
+void WatchHub::SkipTo(uint64_t index) {
+  std::lock_guard<std::mutex> g(mu_);
+  appliedIndex_ = std::max(appliedIndex_, index);
+  compactedIndex_ = std::max(compactedIndex_, index);
+}
+
+Status WatchHub::Watch(const Slice &path, bool recursive, uint64_t fromIndex, WatchSink sink,
+                       uint64_t *id) {
+  std::unique_ptr<Watcher> w(new Watcher);
+  w->path = NormalizePath(path);
+  w->recursive = recursive;
+  w->sink = std::move(sink);
+
+  std::lock_guard<std::mutex> g(mu_);
+  if (fromIndex == 0) {
+    fromIndex = appliedIndex_ + 1;
+  }
+  if (fromIndex <= compactedIndex_) {
+    return FMT_Status(Compacted, "events from index {} are compacted, history starts after {}",
+                      fromIndex, compactedIndex_);
+  }
+
+  auto it = std::lower_bound(
+      history_.begin(), history_.end(), fromIndex,
+      [](const WatchEvent &e, uint64_t index) { return e.index < index; });
+  std::vector<const WatchEvent *> missed;
+  for (; it != history_.end(); ++it) {
+    if (covers(*w, *it)) {
+      missed.push_back(&*it);
+    }
+  }
+  if (!missed.empty() && !w->sink(missed)) {
+    *id = 0;
+    return Status::OK();
+  }
+
+  w->id = nextId_++;
+  *id = w->id;
+  byPath_.emplace(w->path, w.get());
+  watchers_[w->id] = std::move(w);
+  return Status::OK();
+}
+
+void WatchHub::remove(Watcher *w) {
+  auto range = byPath_.equal_range(w->path);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == w) {
+      byPath_.erase(it);
+      break;
+    }
+  }
+  watchers_.erase(w->id);
+}
+
+bool WatchHub::Unwatch(uint64_t id) {
+  std::lock_guard<std::mutex> g(mu_);
+  auto it = watchers_.find(id);
+  if (it == watchers_.end()) {
+    return false;
+  }
+  remove(it->second.get());
+  return true;
+}
+
+uint64_t WatchHub::AppliedIndex() const {
+  std::lock_guard<std::mutex> g(mu_);
+  return appliedIndex_;
+}
+
+}  // namespace memkv
@@ -0,0 +1,125 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "slice.h"
+#include "status.h"
+
+namespace memkv {
+
+struct WatchEvent {
+  enum Type {
+    kPut = 1,
+    kDelete = 2,
+  };
+
+  Type type;
+  // normalized as "/a/b", see WatchHub::NormalizePath.
+  std::string path;
+  // empty for kDelete.
+  std::string value;
+  // index of the log entry that made the change.
+  uint64_t index;
+};
+
+// Called with the events matching a watch, in the order of their indexes. It returns
+// false if the watcher is gone, which is removed then. It's called with the lock of
+// the hub held, it must not block.
+typedef std::function<bool(const std::vector<const WatchEvent *> &)> WatchSink;
+
+// WatchHub pushes the changes applied to a shard to the watchers of their paths, so that
+// the clients watching a path cost nothing until it changes, rather than polling it.
+// The latest events are kept in a bounded history, from which a reconnecting watcher
+// catches up with the events it missed.
+//
+// A watch on a path sees the puts and deletes of it, a recursive watch sees those of its
+// descendants as well. Deleting a node notifies the watchers of its subtree too.
+//
+// Thread-Safe
+class WatchHub {
+ public:
+  // The history holds at most `maxEvents` events of `maxBytes` in total.
+  WatchHub(size_t maxEvents, size_t maxBytes);
+
+  // Records the changes made by the log entry at `index`, and pushes them to the
+  // watchers. Called in the apply thread, in the order of the indexes.
+  void Append(uint64_t index, std::vector<WatchEvent> &&events);
+
+  // The changes up to `index` are not recorded, e.g. they're loaded from a checkpoint.
+  // Watching from before `index` fails with `Compacted`.
+  void SkipTo(uint64_t index);
+
+  // Watches `path` from `fromIndex` on, the events already applied are replayed from
+  // the history to `sink` right away. `fromIndex` 0 watches from the next change on.
+  // Returns error `Compacted` if the events from `fromIndex` on have been dropped from
+  // the history, the client should read the path again and watch from the next change.
+  // `id` is set to 0 if `sink` fails during the replay.
+  Status Watch(const Slice &path, bool recursive, uint64_t fromIndex, WatchSink sink,
+               uint64_t *id);
+
+  // Returns false if the watcher `id` doesn't exist or has been removed.
+  bool Unwatch(uint64_t id);
+
+  // Index of the last entry whose events are appended.
+  uint64_t AppliedIndex() const;
+
+  // "/a/b" for "a//b/", "/" for the root.
+  static std::string NormalizePath(const Slice &path);
+
+ private:
+  struct Watcher {
+    uint64_t id;
+    std::string path;
+    bool recursive;
+    WatchSink sink;
+  };
+
+  typedef std::map<Watcher *, std::vector<const WatchEvent *>> Matches;
+
+  // Adds `e` to the matches of the watchers to be notified of it.
+  void match(const WatchEvent &e, Matches *matches);
+
+  static bool covers(const Watcher &w, const WatchEvent &e);
+
+  void remove(Watcher *w);
+
+ private:
+  const size_t maxEvents_;
+  const size_t maxBytes_;
+
+  mutable std::mutex mu_;
+
+  std::deque<WatchEvent> history_;
+  size_t historyBytes_{0};
+  // the events up to this index may have been dropped from the history.
+  uint64_t compactedIndex_{0};
+  uint64_t appliedIndex_{0};
+
+  uint64_t nextId_{1};
+  std::map<uint64_t, std::unique_ptr<Watcher>> watchers_;
+  // watchers by their paths
+  std::multimap<std::string, Watcher *> byPath_;
+};
+
+}  // namespace memkv
@@ -0,0 +1,116 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "watch_hub.h"
+#include "testing.h"
+
+using namespace memkv;
+
+class WatchHubTest : public testing::Test {
+ public:
+  static WatchEvent put(const std::string &path, const std::string &value) {
+    WatchEvent e;
+    e.type = WatchEvent::kPut;
+    e.path = path;
+    e.value = value;
+    return e;
+  }
+
+  static WatchEvent del(const std::string &path) {
+    WatchEvent e;
+    e.type = WatchEvent::kDelete;
+    e.path = path;
+    return e;
+  }
+
+  static void append(WatchHub *hub, uint64_t index, const WatchEvent &e) {
+    std::vector<WatchEvent> events;
+    events.push_back(e);
+    hub->Append(index, std::move(events));
+  }
+
+  // records the paths and indexes of the events it's called with.
+  static WatchSink recorder(std::vector<std::string> *seen) {
+    return [seen](const std::vector<const WatchEvent *> &events) -> bool {
+      for (const WatchEvent *e : events) {
+        seen->push_back(e->path + "@" + std::to_string(e->index));
+      }
+      return true;
+    };
+  }
+};
+
+TEST_F(WatchHubTest, NormalizePath) {
+  ASSERT_EQ(WatchHub::NormalizePath(" a//b/ "), "/a/b");
+  ASSERT_EQ(WatchHub::NormalizePath("/a"), "/a");
+  ASSERT_EQ(WatchHub::NormalizePath("//"), "/");
+}
+
+TEST_F(WatchHubTest, Match) {
+  WatchHub hub(100, 1 << 20);
+  std::vector<std::string> exact, recursive, child;
+  uint64_t id;
+  ASSERT_OK(hub.Watch("/a", false, 0, recorder(&exact), &id));
+  ASSERT_OK(hub.Watch("/a", true, 0, recorder(&recursive), &id));
+  ASSERT_OK(hub.Watch("/a/b/c", false, 0, recorder(&child), &id));
+
+  append(&hub, 1, put("/a", "1"));
+  append(&hub, 2, put("/a/b", "2"));
+  append(&hub, 3, put("/ab", "3"));
+  append(&hub, 4, del("/a/b"));
+
+  ASSERT_EQ(exact, std::vector<std::string>({"/a@1"}));
+  ASSERT_EQ(recursive, std::vector<std::string>({"/a@1", "/a/b@2", "/a/b@4"}));
+  // deleting an ancestor notifies the watchers under it.
+  ASSERT_EQ(child, std::vector<std::string>({"/a/b@4"}));
+
+  ASSERT_TRUE(hub.Unwatch(id));
+  ASSERT_FALSE(hub.Unwatch(id));
+  ASSERT_EQ(hub.AppliedIndex(), 4u);
+}
+
+TEST_F(WatchHubTest, ReplayAndCompact) {
+  WatchHub hub(3, 1 << 20);
+  for (uint64_t i = 1; i <= 5; i++) {
+    append(&hub, i, put("/a", std::to_string(i)));
+  }
+
+  // the history holds the events 3 to 5.
+  std::vector<std::string> seen;
+  uint64_t id;
+  ASSERT_OK(hub.Watch("/a", false, 4, recorder(&seen), &id));
+  ASSERT_EQ(seen, std::vector<std::string>({"/a@4", "/a@5"}));
+  append(&hub, 6, put("/a", "6"));
+  ASSERT_EQ(seen.back(), "/a@6");
+
+  ASSERT_ERROR(hub.Watch("/a", false, 2, recorder(&seen), &id), Error::Compacted);
+  ASSERT_OK(hub.Watch("/a", false, 5, recorder(&seen), &id));
+}
+
+TEST_F(WatchHubTest, DropFailedSink) {
+  WatchHub hub(100, 1 << 20);
+  int calls = 0;
+  uint64_t id;
+  ASSERT_OK(hub.Watch("/a", false, 0,
+                      [&calls](const std::vector<const WatchEvent *> &) -> bool {
+                        calls++;
+                        return false;
+                      },
+                      &id));
+  append(&hub, 1, put("/a", "1"));
+  append(&hub, 2, put("/a", "2"));
+  ASSERT_EQ(calls, 1);
+  ASSERT_FALSE(hub.Unwatch(id));
+}
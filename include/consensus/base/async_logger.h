@@ -0,0 +1,101 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "consensus/base/background_worker.h"
+
+#include <silly/disallow_copying.h>
+#include <yaraft/logger.h>
+
+namespace consensus {
+
+struct AsyncLoggerOptions {
+  // Number of the lines buffered for the writer thread, rounded up to a power of 2.
+  // The lines logged while the buffer is full are dropped.
+  // Default: 8192
+  size_t capacity;
+
+  // Lines logged from the same site beyond this number in a second are suppressed,
+  // and their count is appended to the next line let through from the site. The
+  // sites are hashed into a fixed number of slots, which colliding sites share.
+  // 0 means no limit.
+  // Default: 100
+  uint32_t max_lines_per_site_per_sec;
+
+  using Writer = std::function<void(yaraft::LogLevel level, int line, const char* file,
+                                    const std::string& msg)>;
+
+  // Writes out a line in the writer thread.
+  // Default: GLogLogger::Write
+  Writer writer;
+
+  // Affinity of the writer thread.
+  // Default: none
+  ThreadAffinity affinity;
+
+  AsyncLoggerOptions();
+};
+
+// AsyncLogger takes the log lines off the threads logging them, e.g the raft threads,
+// into a bounded lock-free ring, from which a background thread writes them out, so
+// that the logging threads never stall on file I/O. Repeated lines are rate limited
+// per site, and the lines that don't fit into the ring are dropped and counted, the
+// count is reported by the writer thread once there's room again.
+//
+// FMT_LOG, FMT_SLOG, WARN_NOT_OK and GLogLogger log through the installed logger,
+// except that the FATAL lines are written synchronously, after the ones queued.
+//
+// Thread-Safe
+class AsyncLogger {
+  __DISALLOW_COPYING__(AsyncLogger);
+
+ public:
+  explicit AsyncLogger(const AsyncLoggerOptions& options);
+
+  // The lines queued are written before the writer thread exits.
+  ~AsyncLogger();
+
+  // Queues the line without blocking. `file` must outlive the logger, e.g __FILE__.
+  // Returns false if the line is suppressed or dropped.
+  bool Log(yaraft::LogLevel level, int line, const char* file, std::string msg);
+
+  // Waits until the lines queued so far are written.
+  void Flush();
+
+  // the number of lines dropped since the ring was full.
+  uint64_t Dropped() const;
+
+  // the number of lines suppressed by the rate limit.
+  uint64_t Suppressed() const;
+
+  // Routes the logging macros through `logger`, null to uninstall. The logger must
+  // stay alive until it's uninstalled.
+  static void Install(AsyncLogger* logger);
+
+  static AsyncLogger* Installed();
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace consensus
@@ -16,6 +16,7 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "consensus/base/status.h"
 
@@ -23,6 +24,32 @@
 
 namespace consensus {
 
+// ThreadAffinity confines a background thread to a set of cores, and makes it prefer
+// the memory of a NUMA node for the pages it allocates and touches first, e.g the
+// buffers of its tasks, so that the consensus threads can be isolated from the
+// others, such as the rpc workers.
+struct ThreadAffinity {
+  // Ids of the cores the thread may run on. If it's empty, the thread runs on the
+  // cores of numa_node if that's set, or on any core.
+  // Default: empty
+  std::vector<int> cpus;
+
+  // The NUMA node whose memory is preferred by the thread, the other nodes are only
+  // used once it's full. -1 means no preference.
+  // Default: -1
+  int numa_node;
+
+  ThreadAffinity() : numa_node(-1) {}
+
+  bool Empty() const {
+    return cpus.empty() && numa_node < 0;
+  }
+
+  // Applies the affinity to the calling thread.
+  // Returns NotSupported on the platforms other than Linux, unless it's empty.
+  Status Apply() const;
+};
+
 class BackgroundWorker {
   __DISALLOW_COPYING__(BackgroundWorker);
 
@@ -32,7 +59,9 @@ class BackgroundWorker {
   ~BackgroundWorker();
 
   // Start looping on the given recurring task infinitely, until users call Stop().
-  Status StartLoop(std::function<void()> recurringTask);
+  // The thread is started with `affinity`, the error of applying it is returned.
+  Status StartLoop(std::function<void()> recurringTask,
+                   const ThreadAffinity& affinity = ThreadAffinity());
 
   // Stop looping. The function returns error status when the background thread
   // is already stopped.
@@ -0,0 +1,92 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "consensus/base/slice.h"
+
+namespace consensus {
+
+// Buffer is a chain of read-only, reference-counted blocks. Copying a Buffer or
+// appending one to another shares the blocks rather than the bytes, so a payload is
+// allocated once and passed by reference through the layers, down to a writev of its
+// slices.
+//
+// Not Thread Safe, though the blocks shared by several Buffers are never modified.
+class Buffer {
+ public:
+  Buffer() = default;
+
+  // Takes over the memory of `data` as a block.
+  explicit Buffer(std::string &&data);
+
+  // Copies `data` into a new block.
+  void Append(const Slice &data);
+
+  void Append(std::string &&data);
+
+  // Shares the blocks of `other`.
+  void Append(const Buffer &other);
+
+  // Drops the first `n` bytes.
+  // REQUIRES: n <= size()
+  void RemovePrefix(size_t n);
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_t BlockCount() const {
+    return refs_.size();
+  }
+
+  Slice Block(size_t i) const {
+    const Ref &r = refs_[i];
+    return Slice(r.block->data() + r.offset, r.length);
+  }
+
+  // Appends a slice per block to `slices`, which stay valid as long as this Buffer.
+  void AppendSlices(std::vector<Slice> *slices) const;
+
+  // Moves the content into `dst`, and leaves this Buffer empty. A Buffer made of one
+  // whole block, not shared with others, hands over the block without copying.
+  void MoveTo(std::string *dst);
+
+  std::string ToString() const;
+
+  void Clear() {
+    refs_.clear();
+    size_ = 0;
+  }
+
+ private:
+  struct Ref {
+    std::shared_ptr<std::string> block;
+    size_t offset;
+    size_t length;
+  };
+
+  std::vector<Ref> refs_;
+  size_t size_{0};
+};
+
+}  // namespace consensus
@@ -38,6 +38,26 @@ extern bool GetLengthPrefixedSlice(Slice* input, Slice* result);
 extern const char* GetVarint32Ptr(const char* p, const char* limit, uint32_t* v);
 extern const char* GetVarint64Ptr(const char* p, const char* limit, uint64_t* v);
 
+// Bulk variants over a run of consecutive varints. GetVarint{32,64}Bulk decode `n`
+// varints from [p..limit-1] into `values`, and return a pointer just past the last
+// one, or NULL on error. The input is scanned 16 bytes at a time, the varint
+// boundaries of a chunk are found at once from the continuation bits (SSE2 on x86_64,
+// NEON on ARMv8), and a chunk of single-byte varints is widened in one go.
+extern const char* GetVarint32Bulk(const char* p, const char* limit, uint32_t* values, size_t n);
+extern const char* GetVarint64Bulk(const char* p, const char* limit, uint64_t* values, size_t n);
+
+// Encodes the `n` values back to back, and returns a pointer just past the last byte
+// written.
+// REQUIRES: dst has room for 5 * n bytes
+extern char* EncodeVarint32Bulk(char* dst, const uint32_t* values, size_t n);
+
+// Whether the bulk routines use the SIMD kernels.
+extern bool IsVarintBulkAccelerated();
+
+// The portable implementation of GetVarint32Bulk, exposed for testing.
+extern const char* GetVarint32BulkPortable(const char* p, const char* limit, uint32_t* values,
+                                           size_t n);
+
 // Returns the length of the varint32 or varint64 encoding of "v"
 extern int VarintLength(uint64_t v);
 
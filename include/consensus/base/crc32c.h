@@ -0,0 +1,43 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace consensus {
+namespace crc32c {
+
+// Return the crc32c of concat(A, data[0,n-1]) where crc is the
+// crc32c of some string A.  Extend() is often used to maintain the
+// crc32c of a stream of data.
+//
+// The hardware instructions (SSE4.2 on x86_64, CRC32 extension on ARMv8)
+// are used if the cpu supports them, which is detected at runtime.
+extern uint32_t Extend(uint32_t crc, const char* data, size_t n);
+
+// Return the crc32c of data[0,n-1]
+inline uint32_t Value(const char* data, size_t n) {
+  return Extend(0, data, n);
+}
+
+// Whether the hardware accelerated implementation is used.
+extern bool IsHardwareAccelerated();
+
+// The portable implementation, exposed for testing.
+extern uint32_t ExtendPortable(uint32_t crc, const char* data, size_t n);
+
+}  // namespace crc32c
+}  // namespace consensus
@@ -30,6 +30,8 @@
 
 namespace consensus {
 
+static constexpr size_t kDefaultPageSize = 4 * 1024;
+
 // A file abstraction for sequential writing.  The implementation
 // must provide buffering since callers may append small fragments
 // at a time to the file.
@@ -42,6 +44,23 @@ class WritableFile {
 
   virtual Status Append(const Slice &data) = 0;
 
+  // Append the `cnt` slices starting at `data` in order, as if they were concatenated
+  // into one buffer. Implementations may write them via a single gathered write
+  // (writev) instead of copying them into a contiguous buffer.
+  virtual Status AppendV(const Slice *data, size_t cnt) {
+    for (size_t i = 0; i < cnt; i++) {
+      RETURN_NOT_OK(Append(data[i]));
+    }
+    return Status::OK();
+  }
+
+  // AppendV followed by Sync. Implementations may submit both at once, with
+  // the sync ordered after the writes.
+  virtual Status AppendVAndSync(const Slice *data, size_t cnt) {
+    RETURN_NOT_OK(AppendV(data, cnt));
+    return Sync();
+  }
+
   // PositionedAppend data to the specified offset. The new EOF after append
   // must be larger than the previous EOF. This is to be used when writes are
   // not backed by OS buffers and hence has to always start from the start of
@@ -66,6 +85,17 @@ class WritableFile {
     return Status::Make(Error::NotSupported);
   }
 
+  // Indicates whether the file bypasses the OS buffers (O_DIRECT), in which
+  // case PositionedAppend must be used.
+  virtual bool UseDirectIO() const {
+    return false;
+  }
+
+  // Alignment of the buffer, offset and length required by PositionedAppend.
+  virtual size_t GetRequiredBufferAlignment() const {
+    return kDefaultPageSize;
+  }
+
   // Pre-allocates 'size' bytes for the file in the underlying filesystem.
   // size bytes are added to the current pre-allocated size or to the current
   // offset, whichever is bigger. In no case is the file truncated by this
@@ -88,14 +118,17 @@ class WritableFile {
   // return a meaningful status.
   virtual Status Flush(FlushMode mode) = 0;
 
+  // Sync data (not metadata) to disk.
+  // It's safe to call concurrently with a write, in which case at least the data
+  // appended before the call is synced.
   virtual Status Sync() = 0;
 
   virtual uint64_t Size() const = 0;
 
   // Truncate is necessary to trim the file to the correct size
   // before closing. It is not always possible to keep track of the file
-  // size due to whole pages writes. The behavior is undefined if called
-  // with other writes to follow.
+  // size due to whole pages writes. Appends following it continue from the
+  // new end of file, which is not supported with direct I/O.
   virtual Status Truncate(uint64_t size) {
     return Status::Make(Error::NotSupported);
   }
@@ -126,13 +159,67 @@ class RandomAccessFile {
   // Safe for concurrent use by multiple threads.
   virtual Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const = 0;
 
-  // Returns the size of the file
+  // Returns the size of the file. Implementations may take it once the file is
+  // opened, so the data appended afterwards isn't seen.
   virtual StatusWith<uint64_t> Size() const = 0;
 
+  enum AccessPattern { NORMAL, SEQUENTIAL, WILL_NEED, DONT_NEED };
+
+  // Advise how the `len` bytes from `offset` on will be accessed, where `len` of 0
+  // extends to the end of file: SEQUENTIAL enlarges the readahead, WILL_NEED starts
+  // reading the range into the page cache in background, DONT_NEED drops it from the
+  // cache once consumed. It's only a hint, which is ignored by default.
+  virtual Status Advise(AccessPattern pattern, uint64_t offset = 0, uint64_t len = 0) const {
+    return Status::OK();
+  }
+
   // Returns the filename provided when the RandomAccessFile was constructed.
   virtual const std::string &filename() const = 0;
 };
 
+// A read of RandomAccessFile, for issuing multiple reads at once.
+struct ReadRequest {
+  RandomAccessFile *file;
+  uint64_t offset;
+  size_t len;
+  char *scratch;
+
+  // output, same as RandomAccessFile::Read
+  Slice result;
+  Status status;
+};
+
+// The latency a simulated device spends in an operation, see Env::NewMemory.
+struct LatencyDistribution {
+  enum Kind {
+    // no latency.
+    kNone,
+    // always `a` microseconds.
+    kFixed,
+    // uniform in [a, b] microseconds.
+    kUniform,
+    // log-normal with a median of `a` microseconds, and `b` the standard deviation of
+    // the underlying normal, e.g 0.5 for a moderate tail, 1.5 for a heavy one.
+    kLogNormal,
+  };
+
+  Kind kind{kNone};
+  double a{0};
+  double b{0};
+};
+
+struct MemoryEnvOptions {
+  // spent in each Append, or AppendV of many slices.
+  LatencyDistribution append_latency;
+
+  // spent in each Sync.
+  LatencyDistribution sync_latency;
+
+  // seeds the latencies, so that a single-threaded run is reproducible.
+  // Default: 0
+  uint64_t seed{0};
+};
+
 class Env {
  public:
   // Governs if/how the file is created.
@@ -154,6 +241,28 @@ class Env {
   // The result of Default() belongs to kudu and must never be deleted.
   static Env *Default();
 
+  // Return an environment that does file I/O via io_uring, which batches the
+  // submission of writes and syncs, and keeps many reads in flight.
+  // Returns NotSupported if io_uring is unavailable on this system.
+  //
+  // The result belongs to consensus and must never be deleted.
+  static StatusWith<Env *> IoUring();
+
+  // Return an environment that keeps the files in memory, so that the tests and
+  // benchmarks can exclude the disk. Syncs are no-ops, and the files are lost when
+  // the process exits.
+  //
+  // The result belongs to consensus and must never be deleted.
+  static Env *Memory();
+
+  // Return a new environment that keeps the files in memory like Memory(), and
+  // spends the latencies of `options` in the writes and the syncs, to simulate a
+  // device, e.g a disk with a long tail of slow syncs. Its files are its own, they're
+  // not shared with Memory() or the other environments.
+  //
+  // The caller owns the result.
+  static Env *NewMemory(const MemoryEnvOptions &options);
+
   // Create an object that writes to a new file with the specified
   // name.  Deletes any existing file with the same name and creates a
   // new file.  On success, stores a pointer to the new file in
@@ -161,9 +270,20 @@ class Env {
   // returns non-OK.
   //
   // The returned file will only be accessed by one thread at a time.
+  //
+  // If use_direct_io is true, the file is opened with O_DIRECT, which can only
+  // be written via PositionedAppend.
   virtual StatusWith<WritableFile *> NewWritableFile(
       const Slice &fname, CreateMode mode = CREATE_IF_NON_EXISTING_TRUNCATE,
-      bool sync_on_close = false) = 0;
+      bool sync_on_close = false, bool use_direct_io = false) = 0;
+
+  // Reuse an existing file by renaming it to `fname` and opening it for writing.
+  // Writes start from the beginning of the file, overwriting the original
+  // content, and the file is truncated to the size actually written on Close.
+  //
+  // The returned file will only be accessed by one thread at a time.
+  virtual StatusWith<WritableFile *> ReuseWritableFile(const Slice &fname, const Slice &oldFname,
+                                                       bool use_direct_io = false) = 0;
 
   // Create a brand new random access read-only file with the
   // specified name.  On success, stores a pointer to the new file in
@@ -174,6 +294,16 @@ class Env {
   // The returned file may be concurrently accessed by multiple threads.
   virtual StatusWith<RandomAccessFile *> NewRandomAccessFile(const Slice &fname) = 0;
 
+  // Issue the reads in `reqs`, the status of each read is stored in reqs[i].status.
+  // The default implementation reads one after another.
+  virtual Status MultiRead(ReadRequest *reqs, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      reqs[i].status = reqs[i].file->Read(reqs[i].offset, reqs[i].len, &reqs[i].result,
+                                          reqs[i].scratch);
+    }
+    return Status::OK();
+  }
+
   // Return the logical size of fname.
   virtual StatusWith<uint64_t> GetFileSize(const Slice &fname) = 0;
 
@@ -190,6 +320,12 @@ class Env {
   // Delete the named file.
   virtual Status DeleteFile(const Slice &fname) = 0;
 
+  // Rename file src to target.
+  virtual Status RenameFile(const Slice &src, const Slice &target) = 0;
+
+  // Syncs the directory, making the files created, renamed or deleted in it durable.
+  virtual Status SyncDir(const Slice &dirname) = 0;
+
   // Store in *result the names of the children of the specified directory.
   // The names are relative to "dir".
   // Original contents of *results are dropped.
@@ -22,6 +22,7 @@
 
 namespace consensus {
 
+class Env;
 class RandomAccessFile;
 
 namespace env_util {
@@ -29,8 +30,12 @@ namespace env_util {
 // Read the full content of `file` into `scratch`.
 Status ReadFully(RandomAccessFile *file, uint64_t offset, size_t n, Slice *result, char *scratch);
 
-// Read data into an unallocated buffer.
+// Read data into an unallocated buffer, which is owned by the caller afterwards.
 Status ReadFullyToBuffer(const Slice &fname, Slice *result, char **scratch);
 
+// Replace the content of `fname` with `data` atomically, by writing it into a
+// temporary file, which is renamed to `fname` once synced.
+Status ReplaceFile(Env *env, const Slice &fname, const Slice &data);
+
 }  // namespace env_util
 }  // namespace consensus
\ No newline at end of file
@@ -0,0 +1,53 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+
+#include "consensus/base/background_worker.h"
+#include "consensus/base/task_queue.h"
+
+#include <silly/disallow_copying.h>
+
+namespace consensus {
+
+// ExecutorPool runs many serial strands on a fixed number of worker threads.
+// Each strand is a TaskQueue whose tasks never run concurrently, though they may run
+// on different workers over time. A runnable strand stays on the worker that last ran
+// it, while idle workers steal whole strands from the busy ones.
+//
+// The pool must outlive its strands.
+//
+// Thread-Safe
+class ExecutorPool {
+  __DISALLOW_COPYING__(ExecutorPool);
+
+ public:
+  // The worker threads are started with `affinity`.
+  explicit ExecutorPool(size_t workers, const ThreadAffinity& affinity = ThreadAffinity());
+
+  ~ExecutorPool();
+
+  // Creates a strand running on the pool, it's owned by the caller.
+  TaskQueue* NewStrand();
+
+ private:
+  class Strand;
+  class StrandQueue;
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace consensus
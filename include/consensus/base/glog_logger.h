@@ -14,13 +14,20 @@
 
 #pragma once
 
+#include <string>
+
 #include <yaraft/logger.h>
 
 namespace consensus {
 
+// GLogLogger writes the logs of yaraft into glog. They're queued to the AsyncLogger
+// installed, if there's one, see AsyncLogger::Install.
 class GLogLogger : public yaraft::Logger {
  public:
   void Log(yaraft::LogLevel level, int line, const char* file, const yaraft::Slice& log) override;
+
+  // Writes the line into glog synchronously.
+  static void Write(yaraft::LogLevel level, int line, const char* file, const std::string& msg);
 };
 
 }  // namespace consensus
\ No newline at end of file
@@ -17,24 +17,43 @@
 #include <butil/logging.h>
 #include <fmt/format.h>
 
+#include "consensus/base/async_logger.h"
+
+/// @brief Log the string @c str at @c level, through the installed AsyncLogger if
+/// there's one, see AsyncLogger::Install. FATAL is logged synchronously.
+#define CONSENSUS_LOG_STRING(level, str)                                       \
+  do {                                                                         \
+    ::consensus::AsyncLogger* _logger = ::consensus::AsyncLogger::Installed(); \
+    if (_logger && ::yaraft::level != ::yaraft::FATAL) {                       \
+      _logger->Log(::yaraft::level, __LINE__, __FILE__, (str));                \
+    } else {                                                                   \
+      if (_logger) {                                                           \
+        _logger->Flush();                                                      \
+      }                                                                        \
+      LOG(level) << (str);                                                     \
+    }                                                                          \
+  } while (0)
+
 /// @brief Emit a warning if @c to_call returns a bad status.
-#define WARN_NOT_OK(to_call, warning_prefix)                     \
-  do {                                                           \
-    const auto& _s = (to_call);                                  \
-    if (UNLIKELY(!_s.IsOK())) {                                  \
-      LOG(WARNING) << (warning_prefix) << ": " << _s.ToString(); \
-    }                                                            \
+#define WARN_NOT_OK(to_call, warning_prefix)                                                  \
+  do {                                                                                        \
+    const auto& _s = (to_call);                                                               \
+    if (UNLIKELY(!_s.IsOK())) {                                                               \
+      CONSENSUS_LOG_STRING(WARNING, fmt::format("{}: {}", (warning_prefix), _s.ToString())); \
+    }                                                                                         \
   } while (0);
 
 /// @brief Emit a fatal error if @c to_call returns a bad status.
-#define FATAL_NOT_OK(to_call, fatal_prefix)                  \
-  do {                                                       \
-    const auto& _s = (to_call);                              \
-    if (UNLIKELY(!_s.IsOK())) {                              \
-      LOG(FATAL) << (fatal_prefix) << ": " << _s.ToString(); \
-    }                                                        \
+#define FATAL_NOT_OK(to_call, fatal_prefix)                                                \
+  do {                                                                                     \
+    const auto& _s = (to_call);                                                            \
+    if (UNLIKELY(!_s.IsOK())) {                                                            \
+      CONSENSUS_LOG_STRING(FATAL, fmt::format("{}: {}", (fatal_prefix), _s.ToString())); \
+    }                                                                                      \
   } while (0);
 
-#define FMT_LOG(level, formatStr, args...) LOG(level) << fmt::format(formatStr, ##args)
+#define FMT_LOG(level, formatStr, args...) \
+  CONSENSUS_LOG_STRING(level, fmt::format(formatStr, ##args))
 
-#define FMT_SLOG(level, formatStr, args...) LOG(level) << fmt::sprintf(formatStr, ##args)
\ No newline at end of file
+#define FMT_SLOG(level, formatStr, args...) \
+  CONSENSUS_LOG_STRING(level, fmt::sprintf(formatStr, ##args))
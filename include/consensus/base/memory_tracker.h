@@ -0,0 +1,92 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include <silly/disallow_copying.h>
+
+namespace consensus {
+
+// MemoryTracker accounts the bytes held by the components of the process, so that
+// the usage can be told apart, see RaftService::Status and the consensus_memory_*
+// bvars. Once the total exceeds the soft limit, the logs push back on the writers,
+// see ReplicatedLogOptions::admission_timeout_ms, and the bounded memstores evict
+// every entry they can, see ReplicatedLogOptions::memstore_max_bytes.
+//
+// Thread-Safe
+class MemoryTracker {
+  __DISALLOW_COPYING__(MemoryTracker);
+
+ public:
+  enum Component {
+    // the entries in the bounded memstores.
+    kMemStore = 0,
+    // the Ready-s taken from raft but not yet persisted.
+    kUnpersistedReadies,
+    // the committed entries queued to the apply threads.
+    kUnappliedEntries,
+    // the unary requests sent to the peers but not yet responded.
+    kPendingSends,
+    // the data of the application, e.g. the memkv nodes.
+    kApplication,
+
+    kComponentCount,
+  };
+
+  static MemoryTracker &Instance();
+
+  void Consume(Component c, int64_t bytes) {
+    usage_[c].fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  void Release(Component c, int64_t bytes) {
+    usage_[c].fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  int64_t Usage(Component c) const {
+    return usage_[c].load(std::memory_order_relaxed);
+  }
+
+  int64_t TotalUsage() const;
+
+  // 0 means no limit.
+  // Default: 0
+  void SetSoftLimit(int64_t bytes) {
+    softLimit_.store(bytes, std::memory_order_relaxed);
+  }
+
+  int64_t SoftLimit() const {
+    return softLimit_.load(std::memory_order_relaxed);
+  }
+
+  bool OverSoftLimit() const {
+    int64_t limit = SoftLimit();
+    return limit > 0 && TotalUsage() > limit;
+  }
+
+  // e.g. "memstore" for kMemStore.
+  static const char *ComponentName(Component c);
+
+ private:
+  MemoryTracker();
+
+ private:
+  std::atomic<int64_t> usage_[kComponentCount];
+  std::atomic<int64_t> softLimit_{0};
+};
+
+}  // namespace consensus
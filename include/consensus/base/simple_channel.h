@@ -1,6 +1,8 @@
 #pragma once
 
+#include <functional>
 #include <future>
+#include <memory>
 
 #include <silly/disallow_copying.h>
 
@@ -26,19 +28,19 @@ class SimpleChannel {
   __DISALLOW_COPYING__(SimpleChannel);
 
  public:
-  SimpleChannel() {
-    future_ = promise_.get_future();
+  SimpleChannel() : promise_(new std::promise<V>) {
+    future_ = promise_->get_future();
   }
 
   SimpleChannel(SimpleChannel &&chan)
       : promise_(std::move(chan.promise_)), future_(std::move(chan.future_)) {}
 
   void operator<<=(const V &value) {
-    promise_.set_value(value);
+    promise_->set_value(value);
   }
 
   void operator<<=(V &&value) {
-    promise_.set_value(value);
+    promise_->set_value(value);
   }
 
   void operator>>=(V &value) {
@@ -46,8 +48,14 @@ class SimpleChannel {
     value = future_.get();
   }
 
+  // Returns a function sending to this channel, it remains valid after the channel is moved.
+  std::function<void(const V &)> Sender() {
+    std::shared_ptr<std::promise<V>> p = promise_;
+    return [p](const V &value) { p->set_value(value); };
+  }
+
  private:
-  std::promise<V> promise_;
+  std::shared_ptr<std::promise<V>> promise_;
   std::future<V> future_;
 };
 
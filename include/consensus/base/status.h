@@ -37,6 +37,8 @@ class Error {
     RuntimeError,
     InvalidArgument,
     WalWriteToNonLeader,
+    NotFound,
+    Busy,
   };
 
   static std::string toString(unsigned int errorCode);
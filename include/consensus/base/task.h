@@ -0,0 +1,152 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace consensus {
+
+// Task is a move-only void() callable. Unlike std::function, it accepts move-only
+// callables, and stores the callables of up to kInlineSize bytes in place, without
+// a heap allocation.
+class Task {
+ public:
+  static const size_t kInlineSize = 48;
+
+  Task() : ops_(nullptr) {}
+
+  template <typename F, typename = typename std::enable_if<
+                            !std::is_same<typename std::decay<F>::type, Task>::value>::type>
+  Task(F&& f) : ops_(nullptr) {
+    typedef typename std::decay<F>::type Fn;
+    construct<Fn>(std::forward<F>(f), std::integral_constant<bool, fitsInline<Fn>()>());
+  }
+
+  Task(Task&& other) : ops_(other.ops_) {
+    if (ops_) {
+      ops_->move(&buf_, &other.buf_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  Task& operator=(Task&& other) {
+    if (this != &other) {
+      reset();
+      ops_ = other.ops_;
+      if (ops_) {
+        ops_->move(&buf_, &other.buf_);
+        other.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  ~Task() {
+    reset();
+  }
+
+  void operator()() {
+    ops_->invoke(&buf_);
+  }
+
+  explicit operator bool() const {
+    return ops_ != nullptr;
+  }
+
+ private:
+  struct Ops {
+    void (*invoke)(void* buf);
+    // move-constructs into dst, and destroys src.
+    void (*move)(void* dst, void* src);
+    void (*destroy)(void* buf);
+  };
+
+  typedef typename std::aligned_storage<kInlineSize>::type Storage;
+
+  template <typename Fn>
+  static constexpr bool fitsInline() {
+    return sizeof(Fn) <= sizeof(Storage) && alignof(Storage) % alignof(Fn) == 0 &&
+           std::is_nothrow_move_constructible<Fn>::value;
+  }
+
+  template <typename Fn>
+  struct InlineOps {
+    static void invoke(void* buf) {
+      (*static_cast<Fn*>(buf))();
+    }
+    static void move(void* dst, void* src) {
+      new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+      static_cast<Fn*>(src)->~Fn();
+    }
+    static void destroy(void* buf) {
+      static_cast<Fn*>(buf)->~Fn();
+    }
+    static const Ops ops;
+  };
+
+  // the callable is on the heap, only its pointer is stored in place.
+  template <typename Fn>
+  struct HeapOps {
+    static void invoke(void* buf) {
+      (**static_cast<Fn**>(buf))();
+    }
+    static void move(void* dst, void* src) {
+      *static_cast<Fn**>(dst) = *static_cast<Fn**>(src);
+    }
+    static void destroy(void* buf) {
+      delete *static_cast<Fn**>(buf);
+    }
+    static const Ops ops;
+  };
+
+  template <typename Fn, typename F>
+  void construct(F&& f, std::true_type) {
+    new (&buf_) Fn(std::forward<F>(f));
+    ops_ = &InlineOps<Fn>::ops;
+  }
+
+  template <typename Fn, typename F>
+  void construct(F&& f, std::false_type) {
+    *reinterpret_cast<Fn**>(&buf_) = new Fn(std::forward<F>(f));
+    ops_ = &HeapOps<Fn>::ops;
+  }
+
+  void reset() {
+    if (ops_) {
+      ops_->destroy(&buf_);
+      ops_ = nullptr;
+    }
+  }
+
+ private:
+  Storage buf_;
+  const Ops* ops_;
+};
+
+template <typename Fn>
+const Task::Ops Task::InlineOps<Fn>::ops = {&InlineOps<Fn>::invoke, &InlineOps<Fn>::move,
+                                            &InlineOps<Fn>::destroy};
+
+template <typename Fn>
+const Task::Ops Task::HeapOps<Fn>::ops = {&HeapOps<Fn>::invoke, &HeapOps<Fn>::move,
+                                          &HeapOps<Fn>::destroy};
+
+}  // namespace consensus
@@ -16,20 +16,44 @@
 
 #include <memory>
 
+#include "consensus/base/background_worker.h"
+#include "consensus/base/task.h"
+
 namespace consensus {
 
 // TaskQueue is a Multi-Producer-Single-Consumer queue running in the background thread,
 // waiting to consume tasks.
+// A TaskQueue can also be a strand of an ExecutorPool, see ExecutorPool::NewStrand.
 class TaskQueue {
  public:
   TaskQueue();
 
+  // The background thread is started with `affinity`.
+  explicit TaskQueue(const ThreadAffinity& affinity);
+
   ~TaskQueue();
 
-  void Enqueue(std::function<void()> task);
+  void Enqueue(Task task);
+
+  // The urgent tasks are run ahead of the normal ones queued before them. The normal
+  // tasks are still run in batches between the urgent ones, so they won't starve.
+  void EnqueueUrgent(Task task);
 
  private:
-  class Impl;
+  friend class ExecutorPool;
+
+  class Impl {
+   public:
+    virtual ~Impl() = default;
+
+    virtual void Enqueue(Task task) = 0;
+
+    virtual void EnqueueUrgent(Task task) = 0;
+  };
+
+  explicit TaskQueue(Impl* impl);
+
+  class ThreadImpl;
   std::unique_ptr<Impl> impl_;
 };
 
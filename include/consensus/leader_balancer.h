@@ -0,0 +1,91 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "consensus/base/status.h"
+
+#include <silly/disallow_copying.h>
+
+namespace consensus {
+
+class ReplicatedLog;
+
+struct LeaderBalancerOptions {
+  // time (in milliseconds) between two rounds of balancing.
+  // Default: 10000
+  uint32_t interval_ms;
+
+  // Number of leaderships handed over by this node in a round at most, so that the
+  // groups settle before the counts are looked at again.
+  // Default: 1
+  size_t max_transfers_per_round;
+
+  LeaderBalancerOptions();
+};
+
+// LeaderBalancer spreads the leaders of the raft groups evenly across the nodes, so
+// that no node takes all the writes, syncs and replication of the groups it happened
+// to win the early elections of. Every node runs its own balancer over its logs: in
+// each round it counts the leaders per node among them, and hands the leadership of
+// its groups over to the least loaded peers, while they lead at least two fewer
+// groups than this node does. A node only gives away the leaderships it holds, so the
+// balancers of different nodes never act on the same group at once.
+// The logs of a node share its id, and the counts only cover the groups it's in.
+//
+// Thread-Safe
+class LeaderBalancer {
+  __DISALLOW_COPYING__(LeaderBalancer);
+
+ public:
+  explicit LeaderBalancer(const LeaderBalancerOptions& options);
+
+  // Stops the rounds, the logs must outlive the balancer or be removed before.
+  ~LeaderBalancer();
+
+  void Add(ReplicatedLog* log);
+
+  void Remove(ReplicatedLog* log);
+
+  // Starts running the rounds in background.
+  Status Start();
+
+  // Runs a round right away, returns the number of transfers started.
+  size_t Balance();
+
+  // The view of a group in a round.
+  struct Group {
+    // 0 if the leader is unknown.
+    uint64_t leader;
+    std::vector<uint64_t> peers;
+  };
+
+  // Plans the transfers of a round for node `self`, as pairs of the group's position
+  // in `groups` and the target of its leadership.
+  static std::vector<std::pair<size_t, uint64_t>> Plan(uint64_t self,
+                                                       const std::vector<Group>& groups,
+                                                       size_t maxTransfers);
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace consensus
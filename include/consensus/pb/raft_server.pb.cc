@@ -33,6 +33,33 @@ const ::google::protobuf::internal::GeneratedMessageReflection*
 const ::google::protobuf::Descriptor* StatusResponse_descriptor_ = NULL;
 const ::google::protobuf::internal::GeneratedMessageReflection*
   StatusResponse_reflection_ = NULL;
+const ::google::protobuf::Descriptor* StepBatchRequest_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  StepBatchRequest_reflection_ = NULL;
+const ::google::protobuf::Descriptor* StepBatchResponse_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  StepBatchResponse_reflection_ = NULL;
+const ::google::protobuf::Descriptor* HeartbeatBatchRequest_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  HeartbeatBatchRequest_reflection_ = NULL;
+const ::google::protobuf::Descriptor* HeartbeatBatchResponse_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  HeartbeatBatchResponse_reflection_ = NULL;
+const ::google::protobuf::Descriptor* InstallSnapshotRequest_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  InstallSnapshotRequest_reflection_ = NULL;
+const ::google::protobuf::Descriptor* InstallSnapshotResponse_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  InstallSnapshotResponse_reflection_ = NULL;
+const ::google::protobuf::Descriptor* ReadIndexRequest_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  ReadIndexRequest_reflection_ = NULL;
+const ::google::protobuf::Descriptor* ReadIndexResponse_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  ReadIndexResponse_reflection_ = NULL;
+const ::google::protobuf::Descriptor* MemoryUsage_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  MemoryUsage_reflection_ = NULL;
 const ::google::protobuf::EnumDescriptor* StatusCode_descriptor_ = NULL;
 const ::google::protobuf::ServiceDescriptor* RaftService_descriptor_ = NULL;
 
@@ -46,8 +73,9 @@ void protobuf_AssignDesc_raft_5fserver_2eproto() {
       "raft_server.proto");
   GOOGLE_CHECK(file != NULL);
   StepRequest_descriptor_ = file->message_type(0);
-  static const int StepRequest_offsets_[1] = {
+  static const int StepRequest_offsets_[2] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StepRequest, message_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StepRequest, group_id_),
   };
   StepRequest_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -77,6 +105,7 @@ void protobuf_AssignDesc_raft_5fserver_2eproto() {
       sizeof(StepResponse));
   StatusRequest_descriptor_ = file->message_type(2);
   static const int StatusRequest_offsets_[1] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StatusRequest, group_id_),
   };
   StatusRequest_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -90,11 +119,17 @@ void protobuf_AssignDesc_raft_5fserver_2eproto() {
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(StatusRequest));
   StatusResponse_descriptor_ = file->message_type(3);
-  static const int StatusResponse_offsets_[4] = {
+  static const int StatusResponse_offsets_[10] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StatusResponse, leader_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StatusResponse, raftindex_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StatusResponse, raftterm_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StatusResponse, raftcommit_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StatusResponse, walappendbytes_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StatusResponse, walsynclatencyus_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StatusResponse, commitlatencyus_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StatusResponse, proposalsinflight_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StatusResponse, memory_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StatusResponse, memorysoftlimit_),
   };
   StatusResponse_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -107,6 +142,147 @@ void protobuf_AssignDesc_raft_5fserver_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(StatusResponse));
+  StepBatchRequest_descriptor_ = file->message_type(4);
+  static const int StepBatchRequest_offsets_[4] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StepBatchRequest, messages_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StepBatchRequest, payloadcompression_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StepBatchRequest, payloadlength_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StepBatchRequest, group_id_),
+  };
+  StepBatchRequest_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      StepBatchRequest_descriptor_,
+      StepBatchRequest::default_instance_,
+      StepBatchRequest_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StepBatchRequest, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StepBatchRequest, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(StepBatchRequest));
+  StepBatchResponse_descriptor_ = file->message_type(5);
+  static const int StepBatchResponse_offsets_[1] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StepBatchResponse, codes_),
+  };
+  StepBatchResponse_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      StepBatchResponse_descriptor_,
+      StepBatchResponse::default_instance_,
+      StepBatchResponse_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StepBatchResponse, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StepBatchResponse, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(StepBatchResponse));
+  HeartbeatBatchRequest_descriptor_ = file->message_type(6);
+  static const int HeartbeatBatchRequest_offsets_[2] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(HeartbeatBatchRequest, group_ids_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(HeartbeatBatchRequest, messages_),
+  };
+  HeartbeatBatchRequest_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      HeartbeatBatchRequest_descriptor_,
+      HeartbeatBatchRequest::default_instance_,
+      HeartbeatBatchRequest_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(HeartbeatBatchRequest, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(HeartbeatBatchRequest, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(HeartbeatBatchRequest));
+  HeartbeatBatchResponse_descriptor_ = file->message_type(7);
+  static const int HeartbeatBatchResponse_offsets_[1] = {
+  };
+  HeartbeatBatchResponse_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      HeartbeatBatchResponse_descriptor_,
+      HeartbeatBatchResponse::default_instance_,
+      HeartbeatBatchResponse_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(HeartbeatBatchResponse, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(HeartbeatBatchResponse, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(HeartbeatBatchResponse));
+  InstallSnapshotRequest_descriptor_ = file->message_type(8);
+  static const int InstallSnapshotRequest_offsets_[4] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(InstallSnapshotRequest, message_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(InstallSnapshotRequest, offset_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(InstallSnapshotRequest, done_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(InstallSnapshotRequest, group_id_),
+  };
+  InstallSnapshotRequest_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      InstallSnapshotRequest_descriptor_,
+      InstallSnapshotRequest::default_instance_,
+      InstallSnapshotRequest_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(InstallSnapshotRequest, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(InstallSnapshotRequest, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(InstallSnapshotRequest));
+  InstallSnapshotResponse_descriptor_ = file->message_type(9);
+  static const int InstallSnapshotResponse_offsets_[1] = {
+  };
+  InstallSnapshotResponse_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      InstallSnapshotResponse_descriptor_,
+      InstallSnapshotResponse::default_instance_,
+      InstallSnapshotResponse_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(InstallSnapshotResponse, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(InstallSnapshotResponse, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(InstallSnapshotResponse));
+  ReadIndexRequest_descriptor_ = file->message_type(10);
+  static const int ReadIndexRequest_offsets_[1] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(ReadIndexRequest, group_id_),
+  };
+  ReadIndexRequest_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      ReadIndexRequest_descriptor_,
+      ReadIndexRequest::default_instance_,
+      ReadIndexRequest_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(ReadIndexRequest, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(ReadIndexRequest, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(ReadIndexRequest));
+  ReadIndexResponse_descriptor_ = file->message_type(11);
+  static const int ReadIndexResponse_offsets_[1] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(ReadIndexResponse, index_),
+  };
+  ReadIndexResponse_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      ReadIndexResponse_descriptor_,
+      ReadIndexResponse::default_instance_,
+      ReadIndexResponse_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(ReadIndexResponse, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(ReadIndexResponse, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(ReadIndexResponse));
+  MemoryUsage_descriptor_ = file->message_type(12);
+  static const int MemoryUsage_offsets_[2] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(MemoryUsage, component_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(MemoryUsage, bytes_),
+  };
+  MemoryUsage_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      MemoryUsage_descriptor_,
+      MemoryUsage::default_instance_,
+      MemoryUsage_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(MemoryUsage, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(MemoryUsage, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(MemoryUsage));
   StatusCode_descriptor_ = file->enum_type(0);
   RaftService_descriptor_ = file->service(0);
 }
@@ -129,6 +305,24 @@ void protobuf_RegisterTypes(const ::std::string&) {
     StatusRequest_descriptor_, &StatusRequest::default_instance());
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
     StatusResponse_descriptor_, &StatusResponse::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    StepBatchRequest_descriptor_, &StepBatchRequest::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    StepBatchResponse_descriptor_, &StepBatchResponse::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    HeartbeatBatchRequest_descriptor_, &HeartbeatBatchRequest::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    HeartbeatBatchResponse_descriptor_, &HeartbeatBatchResponse::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    InstallSnapshotRequest_descriptor_, &InstallSnapshotRequest::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    InstallSnapshotResponse_descriptor_, &InstallSnapshotResponse::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    ReadIndexRequest_descriptor_, &ReadIndexRequest::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    ReadIndexResponse_descriptor_, &ReadIndexResponse::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    MemoryUsage_descriptor_, &MemoryUsage::default_instance());
 }
 
 }  // namespace
@@ -142,6 +336,24 @@ void protobuf_ShutdownFile_raft_5fserver_2eproto() {
   delete StatusRequest_reflection_;
   delete StatusResponse::default_instance_;
   delete StatusResponse_reflection_;
+  delete StepBatchRequest::default_instance_;
+  delete StepBatchRequest_reflection_;
+  delete StepBatchResponse::default_instance_;
+  delete StepBatchResponse_reflection_;
+  delete HeartbeatBatchRequest::default_instance_;
+  delete HeartbeatBatchRequest_reflection_;
+  delete HeartbeatBatchResponse::default_instance_;
+  delete HeartbeatBatchResponse_reflection_;
+  delete InstallSnapshotRequest::default_instance_;
+  delete InstallSnapshotRequest_reflection_;
+  delete InstallSnapshotResponse::default_instance_;
+  delete InstallSnapshotResponse_reflection_;
+  delete ReadIndexRequest::default_instance_;
+  delete ReadIndexRequest_reflection_;
+  delete ReadIndexResponse::default_instance_;
+  delete ReadIndexResponse_reflection_;
+  delete MemoryUsage::default_instance_;
+  delete MemoryUsage_reflection_;
 }
 
 void protobuf_AddDesc_raft_5fserver_2eproto() {
@@ -153,28 +365,74 @@ void protobuf_AddDesc_raft_5fserver_2eproto() {
   ::yaraft::pb::protobuf_AddDesc_yaraft_2fpb_2fraftpb_2eproto();
   ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
     "\n\021raft_server.proto\022\014consensus.pb\032\026yaraf"
-    "t/pb/raftpb.proto\"2\n\013StepRequest\022#\n\007mess"
-    "age\030\001 \002(\0132\022.yaraft.pb.Message\"6\n\014StepRes"
-    "ponse\022&\n\004code\030\001 \002(\0162\030.consensus.pb.Statu"
-    "sCode\"\017\n\rStatusRequest\"Y\n\016StatusResponse"
-    "\022\016\n\006leader\030\001 \001(\004\022\021\n\traftIndex\030\002 \001(\004\022\020\n\010r"
-    "aftTerm\030\003 \001(\004\022\022\n\nraftCommit\030\004 \001(\004*<\n\nSta"
-    "tusCode\022\006\n\002OK\020\000\022\020\n\014StepLocalMsg\020\001\022\024\n\020Ste"
-    "pPeerNotFound\020\0022\221\001\n\013RaftService\022=\n\004Step\022"
-    "\031.consensus.pb.StepRequest\032\032.consensus.p"
-    "b.StepResponse\022C\n\006Status\022\033.consensus.pb."
-    "StatusRequest\032\034.consensus.pb.StatusRespo"
-    "nseB\t\200\001\001\210\001\001\220\001\001", 494);
+    "t/pb/raftpb.proto\"D\n\013StepRequest\022#\n\007mess"
+    "age\030\001 \002(\0132\022.yaraft.pb.Message\022\020\n\010group_i"
+    "d\030\002 \001(\004\"6\n\014StepResponse\022&\n\004code\030\001 \002(\0162\030."
+    "consensus.pb.StatusCode\"!\n\rStatusRequest"
+    "\022\020\n\010group_id\030\001 \001(\004\"\203\002\n\016StatusResponse\022\016\n"
+    "\006leader\030\001 \001(\004\022\021\n\traftIndex\030\002 \001(\004\022\020\n\010raft"
+    "Term\030\003 \001(\004\022\022\n\nraftCommit\030\004 \001(\004\022\026\n\016walApp"
+    "endBytes\030\005 \001(\004\022\030\n\020walSyncLatencyUs\030\006 \001(\004"
+    "\022\027\n\017commitLatencyUs\030\007 \001(\004\022\031\n\021proposalsIn"
+    "flight\030\010 \001(\004\022)\n\006memory\030\t \003(\0132\031.consensus"
+    ".pb.MemoryUsage\022\027\n\017memorySoftLimit\030\n \001(\004"
+    "\"}\n\020StepBatchRequest\022$\n\010messages\030\001 \003(\0132\022"
+    ".yaraft.pb.Message\022\032\n\022payloadCompression"
+    "\030\002 \001(\r\022\025\n\rpayloadLength\030\003 \001(\r\022\020\n\010group_i"
+    "d\030\004 \001(\004\"<\n\021StepBatchResponse\022\'\n\005codes\030\001 "
+    "\003(\0162\030.consensus.pb.StatusCode\"P\n\025Heartbe"
+    "atBatchRequest\022\021\n\tgroup_ids\030\001 \003(\004\022$\n\010mes"
+    "sages\030\002 \003(\0132\022.yaraft.pb.Message\"\030\n\026Heart"
+    "beatBatchResponse\"m\n\026InstallSnapshotRequ"
+    "est\022#\n\007message\030\001 \002(\0132\022.yaraft.pb.Message"
+    "\022\016\n\006offset\030\002 \001(\004\022\014\n\004done\030\003 \001(\010\022\020\n\010group_"
+    "id\030\004 \001(\004\"\031\n\027InstallSnapshotResponse\"$\n\020R"
+    "eadIndexRequest\022\020\n\010group_id\030\001 \001(\004\"\"\n\021Rea"
+    "dIndexResponse\022\r\n\005index\030\001 \001(\004\"/\n\013MemoryU"
+    "sage\022\021\n\tcomponent\030\001 \001(\t\022\r\n\005bytes\030\002 \001(\004*<"
+    "\n\nStatusCode\022\006\n\002OK\020\000\022\020\n\014StepLocalMsg\020\001\022\024"
+    "\n\020StepPeerNotFound\020\0022\352\003\n\013RaftService\022=\n\004"
+    "Step\022\031.consensus.pb.StepRequest\032\032.consen"
+    "sus.pb.StepResponse\022C\n\006Status\022\033.consensu"
+    "s.pb.StatusRequest\032\034.consensus.pb.Status"
+    "Response\022L\n\tStepBatch\022\036.consensus.pb.Ste"
+    "pBatchRequest\032\037.consensus.pb.StepBatchRe"
+    "sponse\022[\n\016HeartbeatBatch\022#.consensus.pb."
+    "HeartbeatBatchRequest\032$.consensus.pb.Hea"
+    "rtbeatBatchResponse\022^\n\017InstallSnapshot\022$"
+    ".consensus.pb.InstallSnapshotRequest\032%.c"
+    "onsensus.pb.InstallSnapshotResponse\022L\n\tR"
+    "eadIndex\022\036.consensus.pb.ReadIndexRequest"
+    "\032\037.consensus.pb.ReadIndexResponseB\t\200\001\001\210\001"
+    "\001\220\001\001", 1604);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "raft_server.proto", &protobuf_RegisterTypes);
   StepRequest::default_instance_ = new StepRequest();
   StepResponse::default_instance_ = new StepResponse();
   StatusRequest::default_instance_ = new StatusRequest();
   StatusResponse::default_instance_ = new StatusResponse();
+  StepBatchRequest::default_instance_ = new StepBatchRequest();
+  StepBatchResponse::default_instance_ = new StepBatchResponse();
+  HeartbeatBatchRequest::default_instance_ = new HeartbeatBatchRequest();
+  HeartbeatBatchResponse::default_instance_ = new HeartbeatBatchResponse();
+  InstallSnapshotRequest::default_instance_ = new InstallSnapshotRequest();
+  InstallSnapshotResponse::default_instance_ = new InstallSnapshotResponse();
+  ReadIndexRequest::default_instance_ = new ReadIndexRequest();
+  ReadIndexResponse::default_instance_ = new ReadIndexResponse();
+  MemoryUsage::default_instance_ = new MemoryUsage();
   StepRequest::default_instance_->InitAsDefaultInstance();
   StepResponse::default_instance_->InitAsDefaultInstance();
   StatusRequest::default_instance_->InitAsDefaultInstance();
   StatusResponse::default_instance_->InitAsDefaultInstance();
+  StepBatchRequest::default_instance_->InitAsDefaultInstance();
+  StepBatchResponse::default_instance_->InitAsDefaultInstance();
+  HeartbeatBatchRequest::default_instance_->InitAsDefaultInstance();
+  HeartbeatBatchResponse::default_instance_->InitAsDefaultInstance();
+  InstallSnapshotRequest::default_instance_->InitAsDefaultInstance();
+  InstallSnapshotResponse::default_instance_->InitAsDefaultInstance();
+  ReadIndexRequest::default_instance_->InitAsDefaultInstance();
+  ReadIndexResponse::default_instance_->InitAsDefaultInstance();
+  MemoryUsage::default_instance_->InitAsDefaultInstance();
   ::google::protobuf::internal::OnShutdown(&protobuf_ShutdownFile_raft_5fserver_2eproto);
 }
 
@@ -204,6 +462,7 @@ bool StatusCode_IsValid(int value) {
 
 #ifndef _MSC_VER
 const int StepRequest::kMessageFieldNumber;
+const int StepRequest::kGroupIdFieldNumber;
 #endif  // !_MSC_VER
 
 StepRequest::StepRequest()
@@ -226,6 +485,7 @@ StepRequest::StepRequest(const StepRequest& from)
 void StepRequest::SharedCtor() {
   _cached_size_ = 0;
   message_ = NULL;
+  group_id_ = GOOGLE_ULONGLONG(0);
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -262,8 +522,11 @@ StepRequest* StepRequest::New() const {
 }
 
 void StepRequest::Clear() {
-  if (has_message()) {
-    if (message_ != NULL) message_->::yaraft::pb::Message::Clear();
+  if (_has_bits_[0 / 32] & 3) {
+    if (has_message()) {
+      if (message_ != NULL) message_->::yaraft::pb::Message::Clear();
+    }
+    group_id_ = GOOGLE_ULONGLONG(0);
   }
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   mutable_unknown_fields()->Clear();
@@ -287,6 +550,21 @@ bool StepRequest::MergePartialFromCodedStream(
         } else {
           goto handle_unusual;
         }
+        if (input->ExpectTag(16)) goto parse_group_id;
+        break;
+      }
+
+      // optional uint64 group_id = 2;
+      case 2: {
+        if (tag == 16) {
+         parse_group_id:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &group_id_)));
+          set_has_group_id();
+        } else {
+          goto handle_unusual;
+        }
         if (input->ExpectAtEnd()) goto success;
         break;
       }
@@ -322,6 +600,11 @@ void StepRequest::SerializeWithCachedSizes(
       1, this->message(), output);
   }
 
+  // optional uint64 group_id = 2;
+  if (has_group_id()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(2, this->group_id(), output);
+  }
+
   if (!unknown_fields().empty()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -339,6 +622,11 @@ void StepRequest::SerializeWithCachedSizes(
         1, this->message(), target);
   }
 
+  // optional uint64 group_id = 2;
+  if (has_group_id()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(2, this->group_id(), target);
+  }
+
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -358,6 +646,13 @@ int StepRequest::ByteSize() const {
           this->message());
     }
 
+    // optional uint64 group_id = 2;
+    if (has_group_id()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->group_id());
+    }
+
   }
   if (!unknown_fields().empty()) {
     total_size +=
@@ -388,6 +683,9 @@ void StepRequest::MergeFrom(const StepRequest& from) {
     if (from.has_message()) {
       mutable_message()->::yaraft::pb::Message::MergeFrom(from.message());
     }
+    if (from.has_group_id()) {
+      set_group_id(from.group_id());
+    }
   }
   mutable_unknown_fields()->MergeFrom(from.unknown_fields());
 }
@@ -413,6 +711,7 @@ bool StepRequest::IsInitialized() const {
 void StepRequest::Swap(StepRequest* other) {
   if (other != this) {
     std::swap(message_, other->message_);
+    std::swap(group_id_, other->group_id_);
     std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
@@ -660,6 +959,7 @@ void StepResponse::Swap(StepResponse* other) {
 // ===================================================================
 
 #ifndef _MSC_VER
+const int StatusRequest::kGroupIdFieldNumber;
 #endif  // !_MSC_VER
 
 StatusRequest::StatusRequest()
@@ -680,6 +980,7 @@ StatusRequest::StatusRequest(const StatusRequest& from)
 
 void StatusRequest::SharedCtor() {
   _cached_size_ = 0;
+  group_id_ = GOOGLE_ULONGLONG(0);
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -715,6 +1016,7 @@ StatusRequest* StatusRequest::New() const {
 }
 
 void StatusRequest::Clear() {
+  group_id_ = GOOGLE_ULONGLONG(0);
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   mutable_unknown_fields()->Clear();
 }
@@ -728,14 +1030,33 @@ bool StatusRequest::MergePartialFromCodedStream(
     ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
     tag = p.first;
     if (!p.second) goto handle_unusual;
-  handle_unusual:
-    if (tag == 0 ||
-        ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
-        ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
-      goto success;
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // optional uint64 group_id = 1;
+      case 1: {
+        if (tag == 8) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &group_id_)));
+          set_has_group_id();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectAtEnd()) goto success;
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0 ||
+            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          goto success;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
     }
-    DO_(::google::protobuf::internal::WireFormat::SkipField(
-          input, tag, mutable_unknown_fields()));
   }
 success:
   // @@protoc_insertion_point(parse_success:consensus.pb.StatusRequest)
@@ -749,6 +1070,11 @@ failure:
 void StatusRequest::SerializeWithCachedSizes(
     ::google::protobuf::io::CodedOutputStream* output) const {
   // @@protoc_insertion_point(serialize_start:consensus.pb.StatusRequest)
+  // optional uint64 group_id = 1;
+  if (has_group_id()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(1, this->group_id(), output);
+  }
+
   if (!unknown_fields().empty()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -759,6 +1085,11 @@ void StatusRequest::SerializeWithCachedSizes(
 ::google::protobuf::uint8* StatusRequest::SerializeWithCachedSizesToArray(
     ::google::protobuf::uint8* target) const {
   // @@protoc_insertion_point(serialize_to_array_start:consensus.pb.StatusRequest)
+  // optional uint64 group_id = 1;
+  if (has_group_id()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(1, this->group_id(), target);
+  }
+
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -770,6 +1101,15 @@ void StatusRequest::SerializeWithCachedSizes(
 int StatusRequest::ByteSize() const {
   int total_size = 0;
 
+  if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    // optional uint64 group_id = 1;
+    if (has_group_id()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->group_id());
+    }
+
+  }
   if (!unknown_fields().empty()) {
     total_size +=
       ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
@@ -795,6 +1135,11 @@ void StatusRequest::MergeFrom(const ::google::protobuf::Message& from) {
 
 void StatusRequest::MergeFrom(const StatusRequest& from) {
   GOOGLE_CHECK_NE(&from, this);
+  if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    if (from.has_group_id()) {
+      set_group_id(from.group_id());
+    }
+  }
   mutable_unknown_fields()->MergeFrom(from.unknown_fields());
 }
 
@@ -817,6 +1162,8 @@ bool StatusRequest::IsInitialized() const {
 
 void StatusRequest::Swap(StatusRequest* other) {
   if (other != this) {
+    std::swap(group_id_, other->group_id_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
   }
@@ -838,6 +1185,12 @@ const int StatusResponse::kLeaderFieldNumber;
 const int StatusResponse::kRaftIndexFieldNumber;
 const int StatusResponse::kRaftTermFieldNumber;
 const int StatusResponse::kRaftCommitFieldNumber;
+const int StatusResponse::kWalAppendBytesFieldNumber;
+const int StatusResponse::kWalSyncLatencyUsFieldNumber;
+const int StatusResponse::kCommitLatencyUsFieldNumber;
+const int StatusResponse::kProposalsInflightFieldNumber;
+const int StatusResponse::kMemoryFieldNumber;
+const int StatusResponse::kMemorySoftLimitFieldNumber;
 #endif  // !_MSC_VER
 
 StatusResponse::StatusResponse()
@@ -862,6 +1215,11 @@ void StatusResponse::SharedCtor() {
   raftindex_ = GOOGLE_ULONGLONG(0);
   raftterm_ = GOOGLE_ULONGLONG(0);
   raftcommit_ = GOOGLE_ULONGLONG(0);
+  walappendbytes_ = GOOGLE_ULONGLONG(0);
+  walsynclatencyus_ = GOOGLE_ULONGLONG(0);
+  commitlatencyus_ = GOOGLE_ULONGLONG(0);
+  proposalsinflight_ = GOOGLE_ULONGLONG(0);
+  memorysoftlimit_ = GOOGLE_ULONGLONG(0);
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -907,11 +1265,15 @@ void StatusResponse::Clear() {
     ::memset(&first, 0, n);                                \
   } while (0)
 
-  ZR_(leader_, raftcommit_);
+  if (_has_bits_[0 / 32] & 255) {
+    ZR_(leader_, proposalsinflight_);
+  }
+  memorysoftlimit_ = GOOGLE_ULONGLONG(0);
 
 #undef OFFSET_OF_FIELD_
 #undef ZR_
 
+  memory_.Clear();
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   mutable_unknown_fields()->Clear();
 }
@@ -981,6 +1343,95 @@ bool StatusResponse::MergePartialFromCodedStream(
         } else {
           goto handle_unusual;
         }
+        if (input->ExpectTag(40)) goto parse_walAppendBytes;
+        break;
+      }
+
+      // optional uint64 walAppendBytes = 5;
+      case 5: {
+        if (tag == 40) {
+         parse_walAppendBytes:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &walappendbytes_)));
+          set_has_walappendbytes();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(48)) goto parse_walSyncLatencyUs;
+        break;
+      }
+
+      // optional uint64 walSyncLatencyUs = 6;
+      case 6: {
+        if (tag == 48) {
+         parse_walSyncLatencyUs:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &walsynclatencyus_)));
+          set_has_walsynclatencyus();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(56)) goto parse_commitLatencyUs;
+        break;
+      }
+
+      // optional uint64 commitLatencyUs = 7;
+      case 7: {
+        if (tag == 56) {
+         parse_commitLatencyUs:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &commitlatencyus_)));
+          set_has_commitlatencyus();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(64)) goto parse_proposalsInflight;
+        break;
+      }
+
+      // optional uint64 proposalsInflight = 8;
+      case 8: {
+        if (tag == 64) {
+         parse_proposalsInflight:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &proposalsinflight_)));
+          set_has_proposalsinflight();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(74)) goto parse_memory;
+        break;
+      }
+
+      // repeated .consensus.pb.MemoryUsage memory = 9;
+      case 9: {
+        if (tag == 74) {
+         parse_memory:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+                input, add_memory()));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(74)) goto parse_memory;
+        if (input->ExpectTag(80)) goto parse_memorySoftLimit;
+        break;
+      }
+
+      // optional uint64 memorySoftLimit = 10;
+      case 10: {
+        if (tag == 80) {
+         parse_memorySoftLimit:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &memorysoftlimit_)));
+          set_has_memorysoftlimit();
+        } else {
+          goto handle_unusual;
+        }
         if (input->ExpectAtEnd()) goto success;
         break;
       }
@@ -1030,6 +1481,37 @@ void StatusResponse::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteUInt64(4, this->raftcommit(), output);
   }
 
+  // optional uint64 walAppendBytes = 5;
+  if (has_walappendbytes()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(5, this->walappendbytes(), output);
+  }
+
+  // optional uint64 walSyncLatencyUs = 6;
+  if (has_walsynclatencyus()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(6, this->walsynclatencyus(), output);
+  }
+
+  // optional uint64 commitLatencyUs = 7;
+  if (has_commitlatencyus()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(7, this->commitlatencyus(), output);
+  }
+
+  // optional uint64 proposalsInflight = 8;
+  if (has_proposalsinflight()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(8, this->proposalsinflight(), output);
+  }
+
+  // repeated .consensus.pb.MemoryUsage memory = 9;
+  for (unsigned int i = 0, n = this->memory_size(); i < n; i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      9, this->memory(i), output);
+  }
+
+  // optional uint64 memorySoftLimit = 10;
+  if (has_memorysoftlimit()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(10, this->memorysoftlimit(), output);
+  }
+
   if (!unknown_fields().empty()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -1060,6 +1542,38 @@ void StatusResponse::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(4, this->raftcommit(), target);
   }
 
+  // optional uint64 walAppendBytes = 5;
+  if (has_walappendbytes()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(5, this->walappendbytes(), target);
+  }
+
+  // optional uint64 walSyncLatencyUs = 6;
+  if (has_walsynclatencyus()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(6, this->walsynclatencyus(), target);
+  }
+
+  // optional uint64 commitLatencyUs = 7;
+  if (has_commitlatencyus()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(7, this->commitlatencyus(), target);
+  }
+
+  // optional uint64 proposalsInflight = 8;
+  if (has_proposalsinflight()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(8, this->proposalsinflight(), target);
+  }
+
+  // repeated .consensus.pb.MemoryUsage memory = 9;
+  for (unsigned int i = 0, n = this->memory_size(); i < n; i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        9, this->memory(i), target);
+  }
+
+  // optional uint64 memorySoftLimit = 10;
+  if (has_memorysoftlimit()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(10, this->memorysoftlimit(), target);
+  }
+
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -1100,7 +1614,52 @@ int StatusResponse::ByteSize() const {
           this->raftcommit());
     }
 
+    // optional uint64 walAppendBytes = 5;
+    if (has_walappendbytes()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->walappendbytes());
+    }
+
+    // optional uint64 walSyncLatencyUs = 6;
+    if (has_walsynclatencyus()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->walsynclatencyus());
+    }
+
+    // optional uint64 commitLatencyUs = 7;
+    if (has_commitlatencyus()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->commitlatencyus());
+    }
+
+    // optional uint64 proposalsInflight = 8;
+    if (has_proposalsinflight()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->proposalsinflight());
+    }
+
+  }
+  if (_has_bits_[9 / 32] & (0xffu << (9 % 32))) {
+    // optional uint64 memorySoftLimit = 10;
+    if (has_memorysoftlimit()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->memorysoftlimit());
+    }
+
+  }
+  // repeated .consensus.pb.MemoryUsage memory = 9;
+  total_size += 1 * this->memory_size();
+  for (int i = 0; i < this->memory_size(); i++) {
+    total_size +=
+      ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+        this->memory(i));
   }
+
   if (!unknown_fields().empty()) {
     total_size +=
       ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
@@ -1126,6 +1685,7 @@ void StatusResponse::MergeFrom(const ::google::protobuf::Message& from) {
 
 void StatusResponse::MergeFrom(const StatusResponse& from) {
   GOOGLE_CHECK_NE(&from, this);
+  memory_.MergeFrom(from.memory_);
   if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
     if (from.has_leader()) {
       set_leader(from.leader());
@@ -1139,6 +1699,23 @@ void StatusResponse::MergeFrom(const StatusResponse& from) {
     if (from.has_raftcommit()) {
       set_raftcommit(from.raftcommit());
     }
+    if (from.has_walappendbytes()) {
+      set_walappendbytes(from.walappendbytes());
+    }
+    if (from.has_walsynclatencyus()) {
+      set_walsynclatencyus(from.walsynclatencyus());
+    }
+    if (from.has_commitlatencyus()) {
+      set_commitlatencyus(from.commitlatencyus());
+    }
+    if (from.has_proposalsinflight()) {
+      set_proposalsinflight(from.proposalsinflight());
+    }
+  }
+  if (from._has_bits_[9 / 32] & (0xffu << (9 % 32))) {
+    if (from.has_memorysoftlimit()) {
+      set_memorysoftlimit(from.memorysoftlimit());
+    }
   }
   mutable_unknown_fields()->MergeFrom(from.unknown_fields());
 }
@@ -1166,6 +1743,12 @@ void StatusResponse::Swap(StatusResponse* other) {
     std::swap(raftindex_, other->raftindex_);
     std::swap(raftterm_, other->raftterm_);
     std::swap(raftcommit_, other->raftcommit_);
+    std::swap(walappendbytes_, other->walappendbytes_);
+    std::swap(walsynclatencyus_, other->walsynclatencyus_);
+    std::swap(commitlatencyus_, other->commitlatencyus_);
+    std::swap(proposalsinflight_, other->proposalsinflight_);
+    memory_.Swap(&other->memory_);
+    std::swap(memorysoftlimit_, other->memorysoftlimit_);
     std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
@@ -1183,34 +1766,2347 @@ void StatusResponse::Swap(StatusResponse* other) {
 
 // ===================================================================
 
-RaftService::~RaftService() {}
+#ifndef _MSC_VER
+const int StepBatchRequest::kMessagesFieldNumber;
+const int StepBatchRequest::kPayloadCompressionFieldNumber;
+const int StepBatchRequest::kPayloadLengthFieldNumber;
+const int StepBatchRequest::kGroupIdFieldNumber;
+#endif  // !_MSC_VER
 
-const ::google::protobuf::ServiceDescriptor* RaftService::descriptor() {
-  protobuf_AssignDescriptorsOnce();
-  return RaftService_descriptor_;
+StepBatchRequest::StepBatchRequest()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:consensus.pb.StepBatchRequest)
 }
 
-const ::google::protobuf::ServiceDescriptor* RaftService::GetDescriptor() {
-  protobuf_AssignDescriptorsOnce();
-  return RaftService_descriptor_;
+void StepBatchRequest::InitAsDefaultInstance() {
 }
 
-void RaftService::Step(::google::protobuf::RpcController* controller,
-                         const ::consensus::pb::StepRequest*,
-                         ::consensus::pb::StepResponse*,
-                         ::google::protobuf::Closure* done) {
-  controller->SetFailed("Method Step() not implemented.");
-  done->Run();
+StepBatchRequest::StepBatchRequest(const StepBatchRequest& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+  // @@protoc_insertion_point(copy_constructor:consensus.pb.StepBatchRequest)
 }
 
-void RaftService::Status(::google::protobuf::RpcController* controller,
-                         const ::consensus::pb::StatusRequest*,
+void StepBatchRequest::SharedCtor() {
+  _cached_size_ = 0;
+  payloadcompression_ = 0u;
+  payloadlength_ = 0u;
+  group_id_ = GOOGLE_ULONGLONG(0);
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+StepBatchRequest::~StepBatchRequest() {
+  // @@protoc_insertion_point(destructor:consensus.pb.StepBatchRequest)
+  SharedDtor();
+}
+
+void StepBatchRequest::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void StepBatchRequest::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* StepBatchRequest::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return StepBatchRequest_descriptor_;
+}
+
+const StepBatchRequest& StepBatchRequest::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_raft_5fserver_2eproto();
+  return *default_instance_;
+}
+
+StepBatchRequest* StepBatchRequest::default_instance_ = NULL;
+
+StepBatchRequest* StepBatchRequest::New() const {
+  return new StepBatchRequest;
+}
+
+void StepBatchRequest::Clear() {
+#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
+  &reinterpret_cast<StepBatchRequest*>(16)->f) - \
+   reinterpret_cast<char*>(16))
+
+#define ZR_(first, last) do {                              \
+    size_t f = OFFSET_OF_FIELD_(first);                    \
+    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
+    ::memset(&first, 0, n);                                \
+  } while (0)
+
+  ZR_(payloadcompression_, group_id_);
+
+#undef OFFSET_OF_FIELD_
+#undef ZR_
+
+  messages_.Clear();
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool StepBatchRequest::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
+  ::google::protobuf::uint32 tag;
+  // @@protoc_insertion_point(parse_start:consensus.pb.StepBatchRequest)
+  for (;;) {
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // repeated .yaraft.pb.Message messages = 1;
+      case 1: {
+        if (tag == 10) {
+         parse_messages:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+                input, add_messages()));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(10)) goto parse_messages;
+        if (input->ExpectTag(16)) goto parse_payloadCompression;
+        break;
+      }
+
+      // optional uint32 payloadCompression = 2;
+      case 2: {
+        if (tag == 16) {
+         parse_payloadCompression:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &payloadcompression_)));
+          set_has_payloadcompression();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(24)) goto parse_payloadLength;
+        break;
+      }
+
+      // optional uint32 payloadLength = 3;
+      case 3: {
+        if (tag == 24) {
+         parse_payloadLength:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &payloadlength_)));
+          set_has_payloadlength();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(32)) goto parse_group_id;
+        break;
+      }
+
+      // optional uint64 group_id = 4;
+      case 4: {
+        if (tag == 32) {
+         parse_group_id:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &group_id_)));
+          set_has_group_id();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectAtEnd()) goto success;
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0 ||
+            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          goto success;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+success:
+  // @@protoc_insertion_point(parse_success:consensus.pb.StepBatchRequest)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:consensus.pb.StepBatchRequest)
+  return false;
+#undef DO_
+}
+
+void StepBatchRequest::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:consensus.pb.StepBatchRequest)
+  // repeated .yaraft.pb.Message messages = 1;
+  for (unsigned int i = 0, n = this->messages_size(); i < n; i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      1, this->messages(i), output);
+  }
+
+  // optional uint32 payloadCompression = 2;
+  if (has_payloadcompression()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(2, this->payloadcompression(), output);
+  }
+
+  // optional uint32 payloadLength = 3;
+  if (has_payloadlength()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(3, this->payloadlength(), output);
+  }
+
+  // optional uint64 group_id = 4;
+  if (has_group_id()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(4, this->group_id(), output);
+  }
+
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:consensus.pb.StepBatchRequest)
+}
+
+::google::protobuf::uint8* StepBatchRequest::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:consensus.pb.StepBatchRequest)
+  // repeated .yaraft.pb.Message messages = 1;
+  for (unsigned int i = 0, n = this->messages_size(); i < n; i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        1, this->messages(i), target);
+  }
+
+  // optional uint32 payloadCompression = 2;
+  if (has_payloadcompression()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(2, this->payloadcompression(), target);
+  }
+
+  // optional uint32 payloadLength = 3;
+  if (has_payloadlength()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(3, this->payloadlength(), target);
+  }
+
+  // optional uint64 group_id = 4;
+  if (has_group_id()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(4, this->group_id(), target);
+  }
+
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:consensus.pb.StepBatchRequest)
+  return target;
+}
+
+int StepBatchRequest::ByteSize() const {
+  int total_size = 0;
+
+  if (_has_bits_[1 / 32] & (0xffu << (1 % 32))) {
+    // optional uint32 payloadCompression = 2;
+    if (has_payloadcompression()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->payloadcompression());
+    }
+
+    // optional uint32 payloadLength = 3;
+    if (has_payloadlength()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->payloadlength());
+    }
+
+    // optional uint64 group_id = 4;
+    if (has_group_id()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->group_id());
+    }
+
+  }
+  // repeated .yaraft.pb.Message messages = 1;
+  total_size += 1 * this->messages_size();
+  for (int i = 0; i < this->messages_size(); i++) {
+    total_size +=
+      ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+        this->messages(i));
+  }
+
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void StepBatchRequest::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const StepBatchRequest* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const StepBatchRequest*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void StepBatchRequest::MergeFrom(const StepBatchRequest& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  messages_.MergeFrom(from.messages_);
+  if (from._has_bits_[1 / 32] & (0xffu << (1 % 32))) {
+    if (from.has_payloadcompression()) {
+      set_payloadcompression(from.payloadcompression());
+    }
+    if (from.has_payloadlength()) {
+      set_payloadlength(from.payloadlength());
+    }
+    if (from.has_group_id()) {
+      set_group_id(from.group_id());
+    }
+  }
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void StepBatchRequest::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void StepBatchRequest::CopyFrom(const StepBatchRequest& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool StepBatchRequest::IsInitialized() const {
+
+  return true;
+}
+
+void StepBatchRequest::Swap(StepBatchRequest* other) {
+  if (other != this) {
+    messages_.Swap(&other->messages_);
+    std::swap(payloadcompression_, other->payloadcompression_);
+    std::swap(payloadlength_, other->payloadlength_);
+    std::swap(group_id_, other->group_id_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata StepBatchRequest::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = StepBatchRequest_descriptor_;
+  metadata.reflection = StepBatchRequest_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+#ifndef _MSC_VER
+const int StepBatchResponse::kCodesFieldNumber;
+#endif  // !_MSC_VER
+
+StepBatchResponse::StepBatchResponse()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:consensus.pb.StepBatchResponse)
+}
+
+void StepBatchResponse::InitAsDefaultInstance() {
+}
+
+StepBatchResponse::StepBatchResponse(const StepBatchResponse& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+  // @@protoc_insertion_point(copy_constructor:consensus.pb.StepBatchResponse)
+}
+
+void StepBatchResponse::SharedCtor() {
+  _cached_size_ = 0;
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+StepBatchResponse::~StepBatchResponse() {
+  // @@protoc_insertion_point(destructor:consensus.pb.StepBatchResponse)
+  SharedDtor();
+}
+
+void StepBatchResponse::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void StepBatchResponse::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* StepBatchResponse::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return StepBatchResponse_descriptor_;
+}
+
+const StepBatchResponse& StepBatchResponse::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_raft_5fserver_2eproto();
+  return *default_instance_;
+}
+
+StepBatchResponse* StepBatchResponse::default_instance_ = NULL;
+
+StepBatchResponse* StepBatchResponse::New() const {
+  return new StepBatchResponse;
+}
+
+void StepBatchResponse::Clear() {
+  codes_.Clear();
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool StepBatchResponse::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
+  ::google::protobuf::uint32 tag;
+  // @@protoc_insertion_point(parse_start:consensus.pb.StepBatchResponse)
+  for (;;) {
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // repeated .consensus.pb.StatusCode codes = 1;
+      case 1: {
+        if (tag == 8) {
+         parse_codes:
+          int value;
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   int, ::google::protobuf::internal::WireFormatLite::TYPE_ENUM>(
+                 input, &value)));
+          if (::consensus::pb::StatusCode_IsValid(value)) {
+            add_codes(static_cast< ::consensus::pb::StatusCode >(value));
+          } else {
+            mutable_unknown_fields()->AddVarint(1, value);
+          }
+        } else if (tag == 10) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedEnumNoInline(
+                 input,
+                 &::consensus::pb::StatusCode_IsValid,
+                 this->mutable_codes())));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(8)) goto parse_codes;
+        if (input->ExpectAtEnd()) goto success;
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0 ||
+            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          goto success;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+success:
+  // @@protoc_insertion_point(parse_success:consensus.pb.StepBatchResponse)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:consensus.pb.StepBatchResponse)
+  return false;
+#undef DO_
+}
+
+void StepBatchResponse::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:consensus.pb.StepBatchResponse)
+  // repeated .consensus.pb.StatusCode codes = 1;
+  for (int i = 0; i < this->codes_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteEnum(
+      1, this->codes(i), output);
+  }
+
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:consensus.pb.StepBatchResponse)
+}
+
+::google::protobuf::uint8* StepBatchResponse::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:consensus.pb.StepBatchResponse)
+  // repeated .consensus.pb.StatusCode codes = 1;
+  for (int i = 0; i < this->codes_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteEnumToArray(
+      1, this->codes(i), target);
+  }
+
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:consensus.pb.StepBatchResponse)
+  return target;
+}
+
+int StepBatchResponse::ByteSize() const {
+  int total_size = 0;
+
+  // repeated .consensus.pb.StatusCode codes = 1;
+  {
+    int data_size = 0;
+    for (int i = 0; i < this->codes_size(); i++) {
+      data_size += ::google::protobuf::internal::WireFormatLite::EnumSize(
+        this->codes(i));
+    }
+    total_size += 1 * this->codes_size() + data_size;
+  }
+
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void StepBatchResponse::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const StepBatchResponse* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const StepBatchResponse*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void StepBatchResponse::MergeFrom(const StepBatchResponse& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  codes_.MergeFrom(from.codes_);
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void StepBatchResponse::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void StepBatchResponse::CopyFrom(const StepBatchResponse& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool StepBatchResponse::IsInitialized() const {
+
+  return true;
+}
+
+void StepBatchResponse::Swap(StepBatchResponse* other) {
+  if (other != this) {
+    codes_.Swap(&other->codes_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata StepBatchResponse::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = StepBatchResponse_descriptor_;
+  metadata.reflection = StepBatchResponse_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+#ifndef _MSC_VER
+const int HeartbeatBatchRequest::kGroupIdsFieldNumber;
+const int HeartbeatBatchRequest::kMessagesFieldNumber;
+#endif  // !_MSC_VER
+
+HeartbeatBatchRequest::HeartbeatBatchRequest()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:consensus.pb.HeartbeatBatchRequest)
+}
+
+void HeartbeatBatchRequest::InitAsDefaultInstance() {
+}
+
+HeartbeatBatchRequest::HeartbeatBatchRequest(const HeartbeatBatchRequest& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+  // @@protoc_insertion_point(copy_constructor:consensus.pb.HeartbeatBatchRequest)
+}
+
+void HeartbeatBatchRequest::SharedCtor() {
+  _cached_size_ = 0;
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+HeartbeatBatchRequest::~HeartbeatBatchRequest() {
+  // @@protoc_insertion_point(destructor:consensus.pb.HeartbeatBatchRequest)
+  SharedDtor();
+}
+
+void HeartbeatBatchRequest::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void HeartbeatBatchRequest::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* HeartbeatBatchRequest::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return HeartbeatBatchRequest_descriptor_;
+}
+
+const HeartbeatBatchRequest& HeartbeatBatchRequest::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_raft_5fserver_2eproto();
+  return *default_instance_;
+}
+
+HeartbeatBatchRequest* HeartbeatBatchRequest::default_instance_ = NULL;
+
+HeartbeatBatchRequest* HeartbeatBatchRequest::New() const {
+  return new HeartbeatBatchRequest;
+}
+
+void HeartbeatBatchRequest::Clear() {
+  group_ids_.Clear();
+  messages_.Clear();
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool HeartbeatBatchRequest::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
+  ::google::protobuf::uint32 tag;
+  // @@protoc_insertion_point(parse_start:consensus.pb.HeartbeatBatchRequest)
+  for (;;) {
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // repeated uint64 group_ids = 1;
+      case 1: {
+        if (tag == 8) {
+         parse_group_ids:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 1, 8, input, this->mutable_group_ids())));
+        } else if (tag == 10) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitiveNoInline<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, this->mutable_group_ids())));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(8)) goto parse_group_ids;
+        if (input->ExpectTag(18)) goto parse_messages;
+        break;
+      }
+
+      // repeated .yaraft.pb.Message messages = 2;
+      case 2: {
+        if (tag == 18) {
+         parse_messages:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+                input, add_messages()));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(18)) goto parse_messages;
+        if (input->ExpectAtEnd()) goto success;
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0 ||
+            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          goto success;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+success:
+  // @@protoc_insertion_point(parse_success:consensus.pb.HeartbeatBatchRequest)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:consensus.pb.HeartbeatBatchRequest)
+  return false;
+#undef DO_
+}
+
+void HeartbeatBatchRequest::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:consensus.pb.HeartbeatBatchRequest)
+  // repeated uint64 group_ids = 1;
+  for (int i = 0; i < this->group_ids_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(
+      1, this->group_ids(i), output);
+  }
+
+  // repeated .yaraft.pb.Message messages = 2;
+  for (unsigned int i = 0, n = this->messages_size(); i < n; i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      2, this->messages(i), output);
+  }
+
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:consensus.pb.HeartbeatBatchRequest)
+}
+
+::google::protobuf::uint8* HeartbeatBatchRequest::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:consensus.pb.HeartbeatBatchRequest)
+  // repeated uint64 group_ids = 1;
+  for (int i = 0; i < this->group_ids_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteUInt64ToArray(1, this->group_ids(i), target);
+  }
+
+  // repeated .yaraft.pb.Message messages = 2;
+  for (unsigned int i = 0, n = this->messages_size(); i < n; i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        2, this->messages(i), target);
+  }
+
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:consensus.pb.HeartbeatBatchRequest)
+  return target;
+}
+
+int HeartbeatBatchRequest::ByteSize() const {
+  int total_size = 0;
+
+  // repeated uint64 group_ids = 1;
+  {
+    int data_size = 0;
+    for (int i = 0; i < this->group_ids_size(); i++) {
+      data_size += ::google::protobuf::internal::WireFormatLite::
+        UInt64Size(this->group_ids(i));
+    }
+    total_size += 1 * this->group_ids_size() + data_size;
+  }
+
+  // repeated .yaraft.pb.Message messages = 2;
+  total_size += 1 * this->messages_size();
+  for (int i = 0; i < this->messages_size(); i++) {
+    total_size +=
+      ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+        this->messages(i));
+  }
+
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void HeartbeatBatchRequest::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const HeartbeatBatchRequest* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const HeartbeatBatchRequest*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void HeartbeatBatchRequest::MergeFrom(const HeartbeatBatchRequest& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  group_ids_.MergeFrom(from.group_ids_);
+  messages_.MergeFrom(from.messages_);
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void HeartbeatBatchRequest::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void HeartbeatBatchRequest::CopyFrom(const HeartbeatBatchRequest& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool HeartbeatBatchRequest::IsInitialized() const {
+
+  return true;
+}
+
+void HeartbeatBatchRequest::Swap(HeartbeatBatchRequest* other) {
+  if (other != this) {
+    group_ids_.Swap(&other->group_ids_);
+    messages_.Swap(&other->messages_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata HeartbeatBatchRequest::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = HeartbeatBatchRequest_descriptor_;
+  metadata.reflection = HeartbeatBatchRequest_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+#ifndef _MSC_VER
+#endif  // !_MSC_VER
+
+HeartbeatBatchResponse::HeartbeatBatchResponse()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:consensus.pb.HeartbeatBatchResponse)
+}
+
+void HeartbeatBatchResponse::InitAsDefaultInstance() {
+}
+
+HeartbeatBatchResponse::HeartbeatBatchResponse(const HeartbeatBatchResponse& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+  // @@protoc_insertion_point(copy_constructor:consensus.pb.HeartbeatBatchResponse)
+}
+
+void HeartbeatBatchResponse::SharedCtor() {
+  _cached_size_ = 0;
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+HeartbeatBatchResponse::~HeartbeatBatchResponse() {
+  // @@protoc_insertion_point(destructor:consensus.pb.HeartbeatBatchResponse)
+  SharedDtor();
+}
+
+void HeartbeatBatchResponse::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void HeartbeatBatchResponse::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* HeartbeatBatchResponse::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return HeartbeatBatchResponse_descriptor_;
+}
+
+const HeartbeatBatchResponse& HeartbeatBatchResponse::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_raft_5fserver_2eproto();
+  return *default_instance_;
+}
+
+HeartbeatBatchResponse* HeartbeatBatchResponse::default_instance_ = NULL;
+
+HeartbeatBatchResponse* HeartbeatBatchResponse::New() const {
+  return new HeartbeatBatchResponse;
+}
+
+void HeartbeatBatchResponse::Clear() {
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool HeartbeatBatchResponse::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
+  ::google::protobuf::uint32 tag;
+  // @@protoc_insertion_point(parse_start:consensus.pb.HeartbeatBatchResponse)
+  for (;;) {
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+  handle_unusual:
+    if (tag == 0 ||
+        ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+        ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+      goto success;
+    }
+    DO_(::google::protobuf::internal::WireFormat::SkipField(
+          input, tag, mutable_unknown_fields()));
+  }
+success:
+  // @@protoc_insertion_point(parse_success:consensus.pb.HeartbeatBatchResponse)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:consensus.pb.HeartbeatBatchResponse)
+  return false;
+#undef DO_
+}
+
+void HeartbeatBatchResponse::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:consensus.pb.HeartbeatBatchResponse)
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:consensus.pb.HeartbeatBatchResponse)
+}
+
+::google::protobuf::uint8* HeartbeatBatchResponse::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:consensus.pb.HeartbeatBatchResponse)
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:consensus.pb.HeartbeatBatchResponse)
+  return target;
+}
+
+int HeartbeatBatchResponse::ByteSize() const {
+  int total_size = 0;
+
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void HeartbeatBatchResponse::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const HeartbeatBatchResponse* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const HeartbeatBatchResponse*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void HeartbeatBatchResponse::MergeFrom(const HeartbeatBatchResponse& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void HeartbeatBatchResponse::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void HeartbeatBatchResponse::CopyFrom(const HeartbeatBatchResponse& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool HeartbeatBatchResponse::IsInitialized() const {
+
+  return true;
+}
+
+void HeartbeatBatchResponse::Swap(HeartbeatBatchResponse* other) {
+  if (other != this) {
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata HeartbeatBatchResponse::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = HeartbeatBatchResponse_descriptor_;
+  metadata.reflection = HeartbeatBatchResponse_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+#ifndef _MSC_VER
+const int InstallSnapshotRequest::kMessageFieldNumber;
+const int InstallSnapshotRequest::kOffsetFieldNumber;
+const int InstallSnapshotRequest::kDoneFieldNumber;
+const int InstallSnapshotRequest::kGroupIdFieldNumber;
+#endif  // !_MSC_VER
+
+InstallSnapshotRequest::InstallSnapshotRequest()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:consensus.pb.InstallSnapshotRequest)
+}
+
+void InstallSnapshotRequest::InitAsDefaultInstance() {
+  message_ = const_cast< ::yaraft::pb::Message*>(&::yaraft::pb::Message::default_instance());
+}
+
+InstallSnapshotRequest::InstallSnapshotRequest(const InstallSnapshotRequest& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+  // @@protoc_insertion_point(copy_constructor:consensus.pb.InstallSnapshotRequest)
+}
+
+void InstallSnapshotRequest::SharedCtor() {
+  _cached_size_ = 0;
+  message_ = NULL;
+  offset_ = GOOGLE_ULONGLONG(0);
+  done_ = false;
+  group_id_ = GOOGLE_ULONGLONG(0);
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+InstallSnapshotRequest::~InstallSnapshotRequest() {
+  // @@protoc_insertion_point(destructor:consensus.pb.InstallSnapshotRequest)
+  SharedDtor();
+}
+
+void InstallSnapshotRequest::SharedDtor() {
+  if (this != default_instance_) {
+    delete message_;
+  }
+}
+
+void InstallSnapshotRequest::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* InstallSnapshotRequest::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return InstallSnapshotRequest_descriptor_;
+}
+
+const InstallSnapshotRequest& InstallSnapshotRequest::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_raft_5fserver_2eproto();
+  return *default_instance_;
+}
+
+InstallSnapshotRequest* InstallSnapshotRequest::default_instance_ = NULL;
+
+InstallSnapshotRequest* InstallSnapshotRequest::New() const {
+  return new InstallSnapshotRequest;
+}
+
+void InstallSnapshotRequest::Clear() {
+#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
+  &reinterpret_cast<InstallSnapshotRequest*>(16)->f) - \
+   reinterpret_cast<char*>(16))
+
+#define ZR_(first, last) do {                              \
+    size_t f = OFFSET_OF_FIELD_(first);                    \
+    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
+    ::memset(&first, 0, n);                                \
+  } while (0)
+
+  if (_has_bits_[0 / 32] & 15) {
+    ZR_(offset_, done_);
+    if (has_message()) {
+      if (message_ != NULL) message_->::yaraft::pb::Message::Clear();
+    }
+  }
+
+#undef OFFSET_OF_FIELD_
+#undef ZR_
+
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool InstallSnapshotRequest::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
+  ::google::protobuf::uint32 tag;
+  // @@protoc_insertion_point(parse_start:consensus.pb.InstallSnapshotRequest)
+  for (;;) {
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // required .yaraft.pb.Message message = 1;
+      case 1: {
+        if (tag == 10) {
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+               input, mutable_message()));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(16)) goto parse_offset;
+        break;
+      }
+
+      // optional uint64 offset = 2;
+      case 2: {
+        if (tag == 16) {
+         parse_offset:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &offset_)));
+          set_has_offset();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(24)) goto parse_done;
+        break;
+      }
+
+      // optional bool done = 3;
+      case 3: {
+        if (tag == 24) {
+         parse_done:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
+                 input, &done_)));
+          set_has_done();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(32)) goto parse_group_id;
+        break;
+      }
+
+      // optional uint64 group_id = 4;
+      case 4: {
+        if (tag == 32) {
+         parse_group_id:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &group_id_)));
+          set_has_group_id();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectAtEnd()) goto success;
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0 ||
+            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          goto success;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+success:
+  // @@protoc_insertion_point(parse_success:consensus.pb.InstallSnapshotRequest)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:consensus.pb.InstallSnapshotRequest)
+  return false;
+#undef DO_
+}
+
+void InstallSnapshotRequest::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:consensus.pb.InstallSnapshotRequest)
+  // required .yaraft.pb.Message message = 1;
+  if (has_message()) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      1, this->message(), output);
+  }
+
+  // optional uint64 offset = 2;
+  if (has_offset()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(2, this->offset(), output);
+  }
+
+  // optional bool done = 3;
+  if (has_done()) {
+    ::google::protobuf::internal::WireFormatLite::WriteBool(3, this->done(), output);
+  }
+
+  // optional uint64 group_id = 4;
+  if (has_group_id()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(4, this->group_id(), output);
+  }
+
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:consensus.pb.InstallSnapshotRequest)
+}
+
+::google::protobuf::uint8* InstallSnapshotRequest::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:consensus.pb.InstallSnapshotRequest)
+  // required .yaraft.pb.Message message = 1;
+  if (has_message()) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        1, this->message(), target);
+  }
+
+  // optional uint64 offset = 2;
+  if (has_offset()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(2, this->offset(), target);
+  }
+
+  // optional bool done = 3;
+  if (has_done()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(3, this->done(), target);
+  }
+
+  // optional uint64 group_id = 4;
+  if (has_group_id()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(4, this->group_id(), target);
+  }
+
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:consensus.pb.InstallSnapshotRequest)
+  return target;
+}
+
+int InstallSnapshotRequest::ByteSize() const {
+  int total_size = 0;
+
+  if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    // required .yaraft.pb.Message message = 1;
+    if (has_message()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+          this->message());
+    }
+
+    // optional uint64 offset = 2;
+    if (has_offset()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->offset());
+    }
+
+    // optional bool done = 3;
+    if (has_done()) {
+      total_size += 1 + 1;
+    }
+
+    // optional uint64 group_id = 4;
+    if (has_group_id()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->group_id());
+    }
+
+  }
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void InstallSnapshotRequest::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const InstallSnapshotRequest* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const InstallSnapshotRequest*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void InstallSnapshotRequest::MergeFrom(const InstallSnapshotRequest& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    if (from.has_message()) {
+      mutable_message()->::yaraft::pb::Message::MergeFrom(from.message());
+    }
+    if (from.has_offset()) {
+      set_offset(from.offset());
+    }
+    if (from.has_done()) {
+      set_done(from.done());
+    }
+    if (from.has_group_id()) {
+      set_group_id(from.group_id());
+    }
+  }
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void InstallSnapshotRequest::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void InstallSnapshotRequest::CopyFrom(const InstallSnapshotRequest& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool InstallSnapshotRequest::IsInitialized() const {
+  if ((_has_bits_[0] & 0x00000001) != 0x00000001) return false;
+
+  return true;
+}
+
+void InstallSnapshotRequest::Swap(InstallSnapshotRequest* other) {
+  if (other != this) {
+    std::swap(message_, other->message_);
+    std::swap(offset_, other->offset_);
+    std::swap(done_, other->done_);
+    std::swap(group_id_, other->group_id_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata InstallSnapshotRequest::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = InstallSnapshotRequest_descriptor_;
+  metadata.reflection = InstallSnapshotRequest_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+#ifndef _MSC_VER
+#endif  // !_MSC_VER
+
+InstallSnapshotResponse::InstallSnapshotResponse()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:consensus.pb.InstallSnapshotResponse)
+}
+
+void InstallSnapshotResponse::InitAsDefaultInstance() {
+}
+
+InstallSnapshotResponse::InstallSnapshotResponse(const InstallSnapshotResponse& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+  // @@protoc_insertion_point(copy_constructor:consensus.pb.InstallSnapshotResponse)
+}
+
+void InstallSnapshotResponse::SharedCtor() {
+  _cached_size_ = 0;
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+InstallSnapshotResponse::~InstallSnapshotResponse() {
+  // @@protoc_insertion_point(destructor:consensus.pb.InstallSnapshotResponse)
+  SharedDtor();
+}
+
+void InstallSnapshotResponse::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void InstallSnapshotResponse::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* InstallSnapshotResponse::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return InstallSnapshotResponse_descriptor_;
+}
+
+const InstallSnapshotResponse& InstallSnapshotResponse::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_raft_5fserver_2eproto();
+  return *default_instance_;
+}
+
+InstallSnapshotResponse* InstallSnapshotResponse::default_instance_ = NULL;
+
+InstallSnapshotResponse* InstallSnapshotResponse::New() const {
+  return new InstallSnapshotResponse;
+}
+
+void InstallSnapshotResponse::Clear() {
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool InstallSnapshotResponse::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
+  ::google::protobuf::uint32 tag;
+  // @@protoc_insertion_point(parse_start:consensus.pb.InstallSnapshotResponse)
+  for (;;) {
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+  handle_unusual:
+    if (tag == 0 ||
+        ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+        ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+      goto success;
+    }
+    DO_(::google::protobuf::internal::WireFormat::SkipField(
+          input, tag, mutable_unknown_fields()));
+  }
+success:
+  // @@protoc_insertion_point(parse_success:consensus.pb.InstallSnapshotResponse)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:consensus.pb.InstallSnapshotResponse)
+  return false;
+#undef DO_
+}
+
+void InstallSnapshotResponse::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:consensus.pb.InstallSnapshotResponse)
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:consensus.pb.InstallSnapshotResponse)
+}
+
+::google::protobuf::uint8* InstallSnapshotResponse::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:consensus.pb.InstallSnapshotResponse)
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:consensus.pb.InstallSnapshotResponse)
+  return target;
+}
+
+int InstallSnapshotResponse::ByteSize() const {
+  int total_size = 0;
+
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void InstallSnapshotResponse::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const InstallSnapshotResponse* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const InstallSnapshotResponse*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void InstallSnapshotResponse::MergeFrom(const InstallSnapshotResponse& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void InstallSnapshotResponse::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void InstallSnapshotResponse::CopyFrom(const InstallSnapshotResponse& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool InstallSnapshotResponse::IsInitialized() const {
+
+  return true;
+}
+
+void InstallSnapshotResponse::Swap(InstallSnapshotResponse* other) {
+  if (other != this) {
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata InstallSnapshotResponse::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = InstallSnapshotResponse_descriptor_;
+  metadata.reflection = InstallSnapshotResponse_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+#ifndef _MSC_VER
+const int ReadIndexRequest::kGroupIdFieldNumber;
+#endif  // !_MSC_VER
+
+ReadIndexRequest::ReadIndexRequest()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:consensus.pb.ReadIndexRequest)
+}
+
+void ReadIndexRequest::InitAsDefaultInstance() {
+}
+
+ReadIndexRequest::ReadIndexRequest(const ReadIndexRequest& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+  // @@protoc_insertion_point(copy_constructor:consensus.pb.ReadIndexRequest)
+}
+
+void ReadIndexRequest::SharedCtor() {
+  _cached_size_ = 0;
+  group_id_ = GOOGLE_ULONGLONG(0);
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+ReadIndexRequest::~ReadIndexRequest() {
+  // @@protoc_insertion_point(destructor:consensus.pb.ReadIndexRequest)
+  SharedDtor();
+}
+
+void ReadIndexRequest::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void ReadIndexRequest::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* ReadIndexRequest::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return ReadIndexRequest_descriptor_;
+}
+
+const ReadIndexRequest& ReadIndexRequest::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_raft_5fserver_2eproto();
+  return *default_instance_;
+}
+
+ReadIndexRequest* ReadIndexRequest::default_instance_ = NULL;
+
+ReadIndexRequest* ReadIndexRequest::New() const {
+  return new ReadIndexRequest;
+}
+
+void ReadIndexRequest::Clear() {
+  group_id_ = GOOGLE_ULONGLONG(0);
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool ReadIndexRequest::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
+  ::google::protobuf::uint32 tag;
+  // @@protoc_insertion_point(parse_start:consensus.pb.ReadIndexRequest)
+  for (;;) {
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // optional uint64 group_id = 1;
+      case 1: {
+        if (tag == 8) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &group_id_)));
+          set_has_group_id();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectAtEnd()) goto success;
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0 ||
+            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          goto success;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+success:
+  // @@protoc_insertion_point(parse_success:consensus.pb.ReadIndexRequest)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:consensus.pb.ReadIndexRequest)
+  return false;
+#undef DO_
+}
+
+void ReadIndexRequest::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:consensus.pb.ReadIndexRequest)
+  // optional uint64 group_id = 1;
+  if (has_group_id()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(1, this->group_id(), output);
+  }
+
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:consensus.pb.ReadIndexRequest)
+}
+
+::google::protobuf::uint8* ReadIndexRequest::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:consensus.pb.ReadIndexRequest)
+  // optional uint64 group_id = 1;
+  if (has_group_id()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(1, this->group_id(), target);
+  }
+
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:consensus.pb.ReadIndexRequest)
+  return target;
+}
+
+int ReadIndexRequest::ByteSize() const {
+  int total_size = 0;
+
+  if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    // optional uint64 group_id = 1;
+    if (has_group_id()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->group_id());
+    }
+
+  }
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void ReadIndexRequest::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const ReadIndexRequest* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const ReadIndexRequest*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void ReadIndexRequest::MergeFrom(const ReadIndexRequest& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    if (from.has_group_id()) {
+      set_group_id(from.group_id());
+    }
+  }
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void ReadIndexRequest::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void ReadIndexRequest::CopyFrom(const ReadIndexRequest& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool ReadIndexRequest::IsInitialized() const {
+
+  return true;
+}
+
+void ReadIndexRequest::Swap(ReadIndexRequest* other) {
+  if (other != this) {
+    std::swap(group_id_, other->group_id_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata ReadIndexRequest::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = ReadIndexRequest_descriptor_;
+  metadata.reflection = ReadIndexRequest_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+#ifndef _MSC_VER
+const int ReadIndexResponse::kIndexFieldNumber;
+#endif  // !_MSC_VER
+
+ReadIndexResponse::ReadIndexResponse()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:consensus.pb.ReadIndexResponse)
+}
+
+void ReadIndexResponse::InitAsDefaultInstance() {
+}
+
+ReadIndexResponse::ReadIndexResponse(const ReadIndexResponse& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+  // @@protoc_insertion_point(copy_constructor:consensus.pb.ReadIndexResponse)
+}
+
+void ReadIndexResponse::SharedCtor() {
+  _cached_size_ = 0;
+  index_ = GOOGLE_ULONGLONG(0);
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+ReadIndexResponse::~ReadIndexResponse() {
+  // @@protoc_insertion_point(destructor:consensus.pb.ReadIndexResponse)
+  SharedDtor();
+}
+
+void ReadIndexResponse::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void ReadIndexResponse::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* ReadIndexResponse::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return ReadIndexResponse_descriptor_;
+}
+
+const ReadIndexResponse& ReadIndexResponse::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_raft_5fserver_2eproto();
+  return *default_instance_;
+}
+
+ReadIndexResponse* ReadIndexResponse::default_instance_ = NULL;
+
+ReadIndexResponse* ReadIndexResponse::New() const {
+  return new ReadIndexResponse;
+}
+
+void ReadIndexResponse::Clear() {
+  index_ = GOOGLE_ULONGLONG(0);
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool ReadIndexResponse::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
+  ::google::protobuf::uint32 tag;
+  // @@protoc_insertion_point(parse_start:consensus.pb.ReadIndexResponse)
+  for (;;) {
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // optional uint64 index = 1;
+      case 1: {
+        if (tag == 8) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &index_)));
+          set_has_index();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectAtEnd()) goto success;
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0 ||
+            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          goto success;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+success:
+  // @@protoc_insertion_point(parse_success:consensus.pb.ReadIndexResponse)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:consensus.pb.ReadIndexResponse)
+  return false;
+#undef DO_
+}
+
+void ReadIndexResponse::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:consensus.pb.ReadIndexResponse)
+  // optional uint64 index = 1;
+  if (has_index()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(1, this->index(), output);
+  }
+
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:consensus.pb.ReadIndexResponse)
+}
+
+::google::protobuf::uint8* ReadIndexResponse::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:consensus.pb.ReadIndexResponse)
+  // optional uint64 index = 1;
+  if (has_index()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(1, this->index(), target);
+  }
+
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:consensus.pb.ReadIndexResponse)
+  return target;
+}
+
+int ReadIndexResponse::ByteSize() const {
+  int total_size = 0;
+
+  if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    // optional uint64 index = 1;
+    if (has_index()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->index());
+    }
+
+  }
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void ReadIndexResponse::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const ReadIndexResponse* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const ReadIndexResponse*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void ReadIndexResponse::MergeFrom(const ReadIndexResponse& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    if (from.has_index()) {
+      set_index(from.index());
+    }
+  }
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void ReadIndexResponse::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void ReadIndexResponse::CopyFrom(const ReadIndexResponse& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool ReadIndexResponse::IsInitialized() const {
+
+  return true;
+}
+
+void ReadIndexResponse::Swap(ReadIndexResponse* other) {
+  if (other != this) {
+    std::swap(index_, other->index_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata ReadIndexResponse::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = ReadIndexResponse_descriptor_;
+  metadata.reflection = ReadIndexResponse_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+#ifndef _MSC_VER
+const int MemoryUsage::kComponentFieldNumber;
+const int MemoryUsage::kBytesFieldNumber;
+#endif  // !_MSC_VER
+
+MemoryUsage::MemoryUsage()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:consensus.pb.MemoryUsage)
+}
+
+void MemoryUsage::InitAsDefaultInstance() {
+}
+
+MemoryUsage::MemoryUsage(const MemoryUsage& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+  // @@protoc_insertion_point(copy_constructor:consensus.pb.MemoryUsage)
+}
+
+void MemoryUsage::SharedCtor() {
+  ::google::protobuf::internal::GetEmptyString();
+  _cached_size_ = 0;
+  component_ = const_cast< ::std::string*>(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  bytes_ = GOOGLE_ULONGLONG(0);
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+MemoryUsage::~MemoryUsage() {
+  // @@protoc_insertion_point(destructor:consensus.pb.MemoryUsage)
+  SharedDtor();
+}
+
+void MemoryUsage::SharedDtor() {
+  if (component_ != &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    delete component_;
+  }
+  if (this != default_instance_) {
+  }
+}
+
+void MemoryUsage::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* MemoryUsage::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return MemoryUsage_descriptor_;
+}
+
+const MemoryUsage& MemoryUsage::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_raft_5fserver_2eproto();
+  return *default_instance_;
+}
+
+MemoryUsage* MemoryUsage::default_instance_ = NULL;
+
+MemoryUsage* MemoryUsage::New() const {
+  return new MemoryUsage;
+}
+
+void MemoryUsage::Clear() {
+  if (_has_bits_[0 / 32] & 3) {
+    if (has_component()) {
+      if (component_ != &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+        component_->clear();
+      }
+    }
+    bytes_ = GOOGLE_ULONGLONG(0);
+  }
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool MemoryUsage::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
+  ::google::protobuf::uint32 tag;
+  // @@protoc_insertion_point(parse_start:consensus.pb.MemoryUsage)
+  for (;;) {
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // optional string component = 1;
+      case 1: {
+        if (tag == 10) {
+          DO_(::google::protobuf::internal::WireFormatLite::ReadString(
+                input, this->mutable_component()));
+          ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(
+            this->component().data(), this->component().length(),
+            ::google::protobuf::internal::WireFormat::PARSE,
+            "component");
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(16)) goto parse_bytes;
+        break;
+      }
+
+      // optional uint64 bytes = 2;
+      case 2: {
+        if (tag == 16) {
+         parse_bytes:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &bytes_)));
+          set_has_bytes();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectAtEnd()) goto success;
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0 ||
+            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          goto success;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+success:
+  // @@protoc_insertion_point(parse_success:consensus.pb.MemoryUsage)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:consensus.pb.MemoryUsage)
+  return false;
+#undef DO_
+}
+
+void MemoryUsage::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:consensus.pb.MemoryUsage)
+  // optional string component = 1;
+  if (has_component()) {
+    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->component().data(), this->component().length(),
+      ::google::protobuf::internal::WireFormat::SERIALIZE,
+      "component");
+    ::google::protobuf::internal::WireFormatLite::WriteStringMaybeAliased(
+      1, this->component(), output);
+  }
+
+  // optional uint64 bytes = 2;
+  if (has_bytes()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(2, this->bytes(), output);
+  }
+
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:consensus.pb.MemoryUsage)
+}
+
+::google::protobuf::uint8* MemoryUsage::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:consensus.pb.MemoryUsage)
+  // optional string component = 1;
+  if (has_component()) {
+    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->component().data(), this->component().length(),
+      ::google::protobuf::internal::WireFormat::SERIALIZE,
+      "component");
+    target =
+      ::google::protobuf::internal::WireFormatLite::WriteStringToArray(
+        1, this->component(), target);
+  }
+
+  // optional uint64 bytes = 2;
+  if (has_bytes()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(2, this->bytes(), target);
+  }
+
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:consensus.pb.MemoryUsage)
+  return target;
+}
+
+int MemoryUsage::ByteSize() const {
+  int total_size = 0;
+
+  if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    // optional string component = 1;
+    if (has_component()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::StringSize(
+          this->component());
+    }
+
+    // optional uint64 bytes = 2;
+    if (has_bytes()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->bytes());
+    }
+
+  }
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void MemoryUsage::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const MemoryUsage* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const MemoryUsage*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void MemoryUsage::MergeFrom(const MemoryUsage& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    if (from.has_component()) {
+      set_component(from.component());
+    }
+    if (from.has_bytes()) {
+      set_bytes(from.bytes());
+    }
+  }
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void MemoryUsage::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void MemoryUsage::CopyFrom(const MemoryUsage& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool MemoryUsage::IsInitialized() const {
+
+  return true;
+}
+
+void MemoryUsage::Swap(MemoryUsage* other) {
+  if (other != this) {
+    std::swap(component_, other->component_);
+    std::swap(bytes_, other->bytes_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata MemoryUsage::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = MemoryUsage_descriptor_;
+  metadata.reflection = MemoryUsage_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+RaftService::~RaftService() {}
+
+const ::google::protobuf::ServiceDescriptor* RaftService::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return RaftService_descriptor_;
+}
+
+const ::google::protobuf::ServiceDescriptor* RaftService::GetDescriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return RaftService_descriptor_;
+}
+
+void RaftService::Step(::google::protobuf::RpcController* controller,
+                         const ::consensus::pb::StepRequest*,
+                         ::consensus::pb::StepResponse*,
+                         ::google::protobuf::Closure* done) {
+  controller->SetFailed("Method Step() not implemented.");
+  done->Run();
+}
+
+void RaftService::Status(::google::protobuf::RpcController* controller,
+                         const ::consensus::pb::StatusRequest*,
                          ::consensus::pb::StatusResponse*,
                          ::google::protobuf::Closure* done) {
   controller->SetFailed("Method Status() not implemented.");
   done->Run();
 }
 
+void RaftService::StepBatch(::google::protobuf::RpcController* controller,
+                         const ::consensus::pb::StepBatchRequest*,
+                         ::consensus::pb::StepBatchResponse*,
+                         ::google::protobuf::Closure* done) {
+  controller->SetFailed("Method StepBatch() not implemented.");
+  done->Run();
+}
+
+void RaftService::HeartbeatBatch(::google::protobuf::RpcController* controller,
+                         const ::consensus::pb::HeartbeatBatchRequest*,
+                         ::consensus::pb::HeartbeatBatchResponse*,
+                         ::google::protobuf::Closure* done) {
+  controller->SetFailed("Method HeartbeatBatch() not implemented.");
+  done->Run();
+}
+
+void RaftService::InstallSnapshot(::google::protobuf::RpcController* controller,
+                         const ::consensus::pb::InstallSnapshotRequest*,
+                         ::consensus::pb::InstallSnapshotResponse*,
+                         ::google::protobuf::Closure* done) {
+  controller->SetFailed("Method InstallSnapshot() not implemented.");
+  done->Run();
+}
+
+void RaftService::ReadIndex(::google::protobuf::RpcController* controller,
+                         const ::consensus::pb::ReadIndexRequest*,
+                         ::consensus::pb::ReadIndexResponse*,
+                         ::google::protobuf::Closure* done) {
+  controller->SetFailed("Method ReadIndex() not implemented.");
+  done->Run();
+}
+
 void RaftService::CallMethod(const ::google::protobuf::MethodDescriptor* method,
                              ::google::protobuf::RpcController* controller,
                              const ::google::protobuf::Message* request,
@@ -1230,6 +4126,30 @@ void RaftService::CallMethod(const ::google::protobuf::MethodDescriptor* method,
              ::google::protobuf::down_cast< ::consensus::pb::StatusResponse*>(response),
              done);
       break;
+    case 2:
+      StepBatch(controller,
+             ::google::protobuf::down_cast<const ::consensus::pb::StepBatchRequest*>(request),
+             ::google::protobuf::down_cast< ::consensus::pb::StepBatchResponse*>(response),
+             done);
+      break;
+    case 3:
+      HeartbeatBatch(controller,
+             ::google::protobuf::down_cast<const ::consensus::pb::HeartbeatBatchRequest*>(request),
+             ::google::protobuf::down_cast< ::consensus::pb::HeartbeatBatchResponse*>(response),
+             done);
+      break;
+    case 4:
+      InstallSnapshot(controller,
+             ::google::protobuf::down_cast<const ::consensus::pb::InstallSnapshotRequest*>(request),
+             ::google::protobuf::down_cast< ::consensus::pb::InstallSnapshotResponse*>(response),
+             done);
+      break;
+    case 5:
+      ReadIndex(controller,
+             ::google::protobuf::down_cast<const ::consensus::pb::ReadIndexRequest*>(request),
+             ::google::protobuf::down_cast< ::consensus::pb::ReadIndexResponse*>(response),
+             done);
+      break;
     default:
       GOOGLE_LOG(FATAL) << "Bad method index; this should never happen.";
       break;
@@ -1244,6 +4164,14 @@ const ::google::protobuf::Message& RaftService::GetRequestPrototype(
       return ::consensus::pb::StepRequest::default_instance();
     case 1:
       return ::consensus::pb::StatusRequest::default_instance();
+    case 2:
+      return ::consensus::pb::StepBatchRequest::default_instance();
+    case 3:
+      return ::consensus::pb::HeartbeatBatchRequest::default_instance();
+    case 4:
+      return ::consensus::pb::InstallSnapshotRequest::default_instance();
+    case 5:
+      return ::consensus::pb::ReadIndexRequest::default_instance();
     default:
       GOOGLE_LOG(FATAL) << "Bad method index; this should never happen.";
       return *reinterpret_cast< ::google::protobuf::Message*>(NULL);
@@ -1258,6 +4186,14 @@ const ::google::protobuf::Message& RaftService::GetResponsePrototype(
       return ::consensus::pb::StepResponse::default_instance();
     case 1:
       return ::consensus::pb::StatusResponse::default_instance();
+    case 2:
+      return ::consensus::pb::StepBatchResponse::default_instance();
+    case 3:
+      return ::consensus::pb::HeartbeatBatchResponse::default_instance();
+    case 4:
+      return ::consensus::pb::InstallSnapshotResponse::default_instance();
+    case 5:
+      return ::consensus::pb::ReadIndexResponse::default_instance();
     default:
       GOOGLE_LOG(FATAL) << "Bad method index; this should never happen.";
       return *reinterpret_cast< ::google::protobuf::Message*>(NULL);
@@ -1289,6 +4225,34 @@ void RaftService_Stub::Status(::google::protobuf::RpcController* controller,
   channel_->CallMethod(descriptor()->method(1),
                        controller, request, response, done);
 }
+void RaftService_Stub::StepBatch(::google::protobuf::RpcController* controller,
+                              const ::consensus::pb::StepBatchRequest* request,
+                              ::consensus::pb::StepBatchResponse* response,
+                              ::google::protobuf::Closure* done) {
+  channel_->CallMethod(descriptor()->method(2),
+                       controller, request, response, done);
+}
+void RaftService_Stub::HeartbeatBatch(::google::protobuf::RpcController* controller,
+                              const ::consensus::pb::HeartbeatBatchRequest* request,
+                              ::consensus::pb::HeartbeatBatchResponse* response,
+                              ::google::protobuf::Closure* done) {
+  channel_->CallMethod(descriptor()->method(3),
+                       controller, request, response, done);
+}
+void RaftService_Stub::InstallSnapshot(::google::protobuf::RpcController* controller,
+                              const ::consensus::pb::InstallSnapshotRequest* request,
+                              ::consensus::pb::InstallSnapshotResponse* response,
+                              ::google::protobuf::Closure* done) {
+  channel_->CallMethod(descriptor()->method(4),
+                       controller, request, response, done);
+}
+void RaftService_Stub::ReadIndex(::google::protobuf::RpcController* controller,
+                              const ::consensus::pb::ReadIndexRequest* request,
+                              ::consensus::pb::ReadIndexResponse* response,
+                              ::google::protobuf::Closure* done) {
+  channel_->CallMethod(descriptor()->method(5),
+                       controller, request, response, done);
+}
 
 // @@protoc_insertion_point(namespace_scope)
 
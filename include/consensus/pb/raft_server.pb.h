@@ -41,6 +41,15 @@ class StepRequest;
 class StepResponse;
 class StatusRequest;
 class StatusResponse;
+class StepBatchRequest;
+class StepBatchResponse;
+class HeartbeatBatchRequest;
+class HeartbeatBatchResponse;
+class InstallSnapshotRequest;
+class InstallSnapshotResponse;
+class ReadIndexRequest;
+class ReadIndexResponse;
+class MemoryUsage;
 
 enum StatusCode {
   OK = 0,
@@ -126,16 +135,26 @@ class StepRequest : public ::google::protobuf::Message {
   inline ::yaraft::pb::Message* release_message();
   inline void set_allocated_message(::yaraft::pb::Message* message);
 
+  // optional uint64 group_id = 2;
+  inline bool has_group_id() const;
+  inline void clear_group_id();
+  static const int kGroupIdFieldNumber = 2;
+  inline ::google::protobuf::uint64 group_id() const;
+  inline void set_group_id(::google::protobuf::uint64 value);
+
   // @@protoc_insertion_point(class_scope:consensus.pb.StepRequest)
  private:
   inline void set_has_message();
   inline void clear_has_message();
+  inline void set_has_group_id();
+  inline void clear_has_group_id();
 
   ::google::protobuf::UnknownFieldSet _unknown_fields_;
 
   ::google::protobuf::uint32 _has_bits_[1];
   mutable int _cached_size_;
   ::yaraft::pb::Message* message_;
+  ::google::protobuf::uint64 group_id_;
   friend void  protobuf_AddDesc_raft_5fserver_2eproto();
   friend void protobuf_AssignDesc_raft_5fserver_2eproto();
   friend void protobuf_ShutdownFile_raft_5fserver_2eproto();
@@ -277,13 +296,23 @@ class StatusRequest : public ::google::protobuf::Message {
 
   // accessors -------------------------------------------------------
 
+  // optional uint64 group_id = 1;
+  inline bool has_group_id() const;
+  inline void clear_group_id();
+  static const int kGroupIdFieldNumber = 1;
+  inline ::google::protobuf::uint64 group_id() const;
+  inline void set_group_id(::google::protobuf::uint64 value);
+
   // @@protoc_insertion_point(class_scope:consensus.pb.StatusRequest)
  private:
+  inline void set_has_group_id();
+  inline void clear_has_group_id();
 
   ::google::protobuf::UnknownFieldSet _unknown_fields_;
 
   ::google::protobuf::uint32 _has_bits_[1];
   mutable int _cached_size_;
+  ::google::protobuf::uint64 group_id_;
   friend void  protobuf_AddDesc_raft_5fserver_2eproto();
   friend void protobuf_AssignDesc_raft_5fserver_2eproto();
   friend void protobuf_ShutdownFile_raft_5fserver_2eproto();
@@ -374,6 +403,53 @@ class StatusResponse : public ::google::protobuf::Message {
   inline ::google::protobuf::uint64 raftcommit() const;
   inline void set_raftcommit(::google::protobuf::uint64 value);
 
+  // optional uint64 walAppendBytes = 5;
+  inline bool has_walappendbytes() const;
+  inline void clear_walappendbytes();
+  static const int kWalAppendBytesFieldNumber = 5;
+  inline ::google::protobuf::uint64 walappendbytes() const;
+  inline void set_walappendbytes(::google::protobuf::uint64 value);
+
+  // optional uint64 walSyncLatencyUs = 6;
+  inline bool has_walsynclatencyus() const;
+  inline void clear_walsynclatencyus();
+  static const int kWalSyncLatencyUsFieldNumber = 6;
+  inline ::google::protobuf::uint64 walsynclatencyus() const;
+  inline void set_walsynclatencyus(::google::protobuf::uint64 value);
+
+  // optional uint64 commitLatencyUs = 7;
+  inline bool has_commitlatencyus() const;
+  inline void clear_commitlatencyus();
+  static const int kCommitLatencyUsFieldNumber = 7;
+  inline ::google::protobuf::uint64 commitlatencyus() const;
+  inline void set_commitlatencyus(::google::protobuf::uint64 value);
+
+  // optional uint64 proposalsInflight = 8;
+  inline bool has_proposalsinflight() const;
+  inline void clear_proposalsinflight();
+  static const int kProposalsInflightFieldNumber = 8;
+  inline ::google::protobuf::uint64 proposalsinflight() const;
+  inline void set_proposalsinflight(::google::protobuf::uint64 value);
+
+  // repeated .consensus.pb.MemoryUsage memory = 9;
+  inline int memory_size() const;
+  inline void clear_memory();
+  static const int kMemoryFieldNumber = 9;
+  inline const ::consensus::pb::MemoryUsage& memory(int index) const;
+  inline ::consensus::pb::MemoryUsage* mutable_memory(int index);
+  inline ::consensus::pb::MemoryUsage* add_memory();
+  inline const ::google::protobuf::RepeatedPtrField< ::consensus::pb::MemoryUsage >&
+      memory() const;
+  inline ::google::protobuf::RepeatedPtrField< ::consensus::pb::MemoryUsage >*
+      mutable_memory();
+
+  // optional uint64 memorySoftLimit = 10;
+  inline bool has_memorysoftlimit() const;
+  inline void clear_memorysoftlimit();
+  static const int kMemorySoftLimitFieldNumber = 10;
+  inline ::google::protobuf::uint64 memorysoftlimit() const;
+  inline void set_memorysoftlimit(::google::protobuf::uint64 value);
+
   // @@protoc_insertion_point(class_scope:consensus.pb.StatusResponse)
  private:
   inline void set_has_leader();
@@ -384,6 +460,16 @@ class StatusResponse : public ::google::protobuf::Message {
   inline void clear_has_raftterm();
   inline void set_has_raftcommit();
   inline void clear_has_raftcommit();
+  inline void set_has_walappendbytes();
+  inline void clear_has_walappendbytes();
+  inline void set_has_walsynclatencyus();
+  inline void clear_has_walsynclatencyus();
+  inline void set_has_commitlatencyus();
+  inline void clear_has_commitlatencyus();
+  inline void set_has_proposalsinflight();
+  inline void clear_has_proposalsinflight();
+  inline void set_has_memorysoftlimit();
+  inline void clear_has_memorysoftlimit();
 
   ::google::protobuf::UnknownFieldSet _unknown_fields_;
 
@@ -393,6 +479,12 @@ class StatusResponse : public ::google::protobuf::Message {
   ::google::protobuf::uint64 raftindex_;
   ::google::protobuf::uint64 raftterm_;
   ::google::protobuf::uint64 raftcommit_;
+  ::google::protobuf::uint64 walappendbytes_;
+  ::google::protobuf::uint64 walsynclatencyus_;
+  ::google::protobuf::uint64 commitlatencyus_;
+  ::google::protobuf::uint64 proposalsinflight_;
+  ::google::protobuf::RepeatedPtrField< ::consensus::pb::MemoryUsage > memory_;
+  ::google::protobuf::uint64 memorysoftlimit_;
   friend void  protobuf_AddDesc_raft_5fserver_2eproto();
   friend void protobuf_AssignDesc_raft_5fserver_2eproto();
   friend void protobuf_ShutdownFile_raft_5fserver_2eproto();
@@ -400,202 +492,1070 @@ class StatusResponse : public ::google::protobuf::Message {
   void InitAsDefaultInstance();
   static StatusResponse* default_instance_;
 };
-// ===================================================================
-
-class RaftService_Stub;
+// -------------------------------------------------------------------
 
-class RaftService : public ::google::protobuf::Service {
- protected:
-  // This class should be treated as an abstract interface.
-  inline RaftService() {};
+class StepBatchRequest : public ::google::protobuf::Message {
  public:
-  virtual ~RaftService();
+  StepBatchRequest();
+  virtual ~StepBatchRequest();
 
-  typedef RaftService_Stub Stub;
+  StepBatchRequest(const StepBatchRequest& from);
 
-  static const ::google::protobuf::ServiceDescriptor* descriptor();
+  inline StepBatchRequest& operator=(const StepBatchRequest& from) {
+    CopyFrom(from);
+    return *this;
+  }
 
-  virtual void Step(::google::protobuf::RpcController* controller,
-                       const ::consensus::pb::StepRequest* request,
-                       ::consensus::pb::StepResponse* response,
-                       ::google::protobuf::Closure* done);
-  virtual void Status(::google::protobuf::RpcController* controller,
-                       const ::consensus::pb::StatusRequest* request,
-                       ::consensus::pb::StatusResponse* response,
-                       ::google::protobuf::Closure* done);
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
 
-  // implements Service ----------------------------------------------
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
 
-  const ::google::protobuf::ServiceDescriptor* GetDescriptor();
-  void CallMethod(const ::google::protobuf::MethodDescriptor* method,
-                  ::google::protobuf::RpcController* controller,
-                  const ::google::protobuf::Message* request,
-                  ::google::protobuf::Message* response,
-                  ::google::protobuf::Closure* done);
-  const ::google::protobuf::Message& GetRequestPrototype(
-    const ::google::protobuf::MethodDescriptor* method) const;
-  const ::google::protobuf::Message& GetResponsePrototype(
-    const ::google::protobuf::MethodDescriptor* method) const;
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const StepBatchRequest& default_instance();
+
+  void Swap(StepBatchRequest* other);
+
+  // implements Message ----------------------------------------------
+
+  StepBatchRequest* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const StepBatchRequest& from);
+  void MergeFrom(const StepBatchRequest& from);
+  void Clear();
+  bool IsInitialized() const;
+
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  ::google::protobuf::Metadata GetMetadata() const;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
 
+  // repeated .yaraft.pb.Message messages = 1;
+  inline int messages_size() const;
+  inline void clear_messages();
+  static const int kMessagesFieldNumber = 1;
+  inline const ::yaraft::pb::Message& messages(int index) const;
+  inline ::yaraft::pb::Message* mutable_messages(int index);
+  inline ::yaraft::pb::Message* add_messages();
+  inline const ::google::protobuf::RepeatedPtrField< ::yaraft::pb::Message >&
+      messages() const;
+  inline ::google::protobuf::RepeatedPtrField< ::yaraft::pb::Message >*
+      mutable_messages();
+
+  // optional uint32 payloadCompression = 2;
+  inline bool has_payloadcompression() const;
+  inline void clear_payloadcompression();
+  static const int kPayloadCompressionFieldNumber = 2;
+  inline ::google::protobuf::uint32 payloadcompression() const;
+  inline void set_payloadcompression(::google::protobuf::uint32 value);
+
+  // optional uint32 payloadLength = 3;
+  inline bool has_payloadlength() const;
+  inline void clear_payloadlength();
+  static const int kPayloadLengthFieldNumber = 3;
+  inline ::google::protobuf::uint32 payloadlength() const;
+  inline void set_payloadlength(::google::protobuf::uint32 value);
+
+  // optional uint64 group_id = 4;
+  inline bool has_group_id() const;
+  inline void clear_group_id();
+  static const int kGroupIdFieldNumber = 4;
+  inline ::google::protobuf::uint64 group_id() const;
+  inline void set_group_id(::google::protobuf::uint64 value);
+
+  // @@protoc_insertion_point(class_scope:consensus.pb.StepBatchRequest)
  private:
-  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(RaftService);
+  inline void set_has_payloadcompression();
+  inline void clear_has_payloadcompression();
+  inline void set_has_payloadlength();
+  inline void clear_has_payloadlength();
+  inline void set_has_group_id();
+  inline void clear_has_group_id();
+
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+
+  ::google::protobuf::uint32 _has_bits_[1];
+  mutable int _cached_size_;
+  ::google::protobuf::RepeatedPtrField< ::yaraft::pb::Message > messages_;
+  ::google::protobuf::uint32 payloadcompression_;
+  ::google::protobuf::uint32 payloadlength_;
+  ::google::protobuf::uint64 group_id_;
+  friend void  protobuf_AddDesc_raft_5fserver_2eproto();
+  friend void protobuf_AssignDesc_raft_5fserver_2eproto();
+  friend void protobuf_ShutdownFile_raft_5fserver_2eproto();
+
+  void InitAsDefaultInstance();
+  static StepBatchRequest* default_instance_;
 };
+// -------------------------------------------------------------------
 
-class RaftService_Stub : public RaftService {
+class StepBatchResponse : public ::google::protobuf::Message {
  public:
-  RaftService_Stub(::google::protobuf::RpcChannel* channel);
-  RaftService_Stub(::google::protobuf::RpcChannel* channel,
-                   ::google::protobuf::Service::ChannelOwnership ownership);
-  ~RaftService_Stub();
+  StepBatchResponse();
+  virtual ~StepBatchResponse();
 
-  inline ::google::protobuf::RpcChannel* channel() { return channel_; }
+  StepBatchResponse(const StepBatchResponse& from);
 
-  // implements RaftService ------------------------------------------
+  inline StepBatchResponse& operator=(const StepBatchResponse& from) {
+    CopyFrom(from);
+    return *this;
+  }
 
-  void Step(::google::protobuf::RpcController* controller,
-                       const ::consensus::pb::StepRequest* request,
-                       ::consensus::pb::StepResponse* response,
-                       ::google::protobuf::Closure* done);
-  void Status(::google::protobuf::RpcController* controller,
-                       const ::consensus::pb::StatusRequest* request,
-                       ::consensus::pb::StatusResponse* response,
-                       ::google::protobuf::Closure* done);
- private:
-  ::google::protobuf::RpcChannel* channel_;
-  bool owns_channel_;
-  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(RaftService_Stub);
-};
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
 
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
 
-// ===================================================================
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const StepBatchResponse& default_instance();
 
+  void Swap(StepBatchResponse* other);
 
-// ===================================================================
+  // implements Message ----------------------------------------------
 
-// StepRequest
+  StepBatchResponse* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const StepBatchResponse& from);
+  void MergeFrom(const StepBatchResponse& from);
+  void Clear();
+  bool IsInitialized() const;
 
-// required .yaraft.pb.Message message = 1;
-inline bool StepRequest::has_message() const {
-  return (_has_bits_[0] & 0x00000001u) != 0;
-}
-inline void StepRequest::set_has_message() {
-  _has_bits_[0] |= 0x00000001u;
-}
-inline void StepRequest::clear_has_message() {
-  _has_bits_[0] &= ~0x00000001u;
-}
-inline void StepRequest::clear_message() {
-  if (message_ != NULL) message_->::yaraft::pb::Message::Clear();
-  clear_has_message();
-}
-inline const ::yaraft::pb::Message& StepRequest::message() const {
-  // @@protoc_insertion_point(field_get:consensus.pb.StepRequest.message)
-  return message_ != NULL ? *message_ : *default_instance_->message_;
-}
-inline ::yaraft::pb::Message* StepRequest::mutable_message() {
-  set_has_message();
-  if (message_ == NULL) message_ = new ::yaraft::pb::Message;
-  // @@protoc_insertion_point(field_mutable:consensus.pb.StepRequest.message)
-  return message_;
-}
-inline ::yaraft::pb::Message* StepRequest::release_message() {
-  clear_has_message();
-  ::yaraft::pb::Message* temp = message_;
-  message_ = NULL;
-  return temp;
-}
-inline void StepRequest::set_allocated_message(::yaraft::pb::Message* message) {
-  delete message_;
-  message_ = message;
-  if (message) {
-    set_has_message();
-  } else {
-    clear_has_message();
-  }
-  // @@protoc_insertion_point(field_set_allocated:consensus.pb.StepRequest.message)
-}
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  ::google::protobuf::Metadata GetMetadata() const;
 
-// -------------------------------------------------------------------
+  // nested types ----------------------------------------------------
 
-// StepResponse
+  // accessors -------------------------------------------------------
 
-// required .consensus.pb.StatusCode code = 1;
-inline bool StepResponse::has_code() const {
-  return (_has_bits_[0] & 0x00000001u) != 0;
-}
-inline void StepResponse::set_has_code() {
-  _has_bits_[0] |= 0x00000001u;
-}
-inline void StepResponse::clear_has_code() {
-  _has_bits_[0] &= ~0x00000001u;
-}
-inline void StepResponse::clear_code() {
-  code_ = 0;
-  clear_has_code();
-}
-inline ::consensus::pb::StatusCode StepResponse::code() const {
-  // @@protoc_insertion_point(field_get:consensus.pb.StepResponse.code)
-  return static_cast< ::consensus::pb::StatusCode >(code_);
-}
-inline void StepResponse::set_code(::consensus::pb::StatusCode value) {
-  assert(::consensus::pb::StatusCode_IsValid(value));
-  set_has_code();
-  code_ = value;
-  // @@protoc_insertion_point(field_set:consensus.pb.StepResponse.code)
-}
+  // repeated .consensus.pb.StatusCode codes = 1;
+  inline int codes_size() const;
+  inline void clear_codes();
+  static const int kCodesFieldNumber = 1;
+  inline ::consensus::pb::StatusCode codes(int index) const;
+  inline void set_codes(int index, ::consensus::pb::StatusCode value);
+  inline void add_codes(::consensus::pb::StatusCode value);
+  inline const ::google::protobuf::RepeatedField<int>& codes() const;
+  inline ::google::protobuf::RepeatedField<int>* mutable_codes();
+
+  // @@protoc_insertion_point(class_scope:consensus.pb.StepBatchResponse)
+ private:
 
-// -------------------------------------------------------------------
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
 
-// StatusRequest
+  ::google::protobuf::uint32 _has_bits_[1];
+  mutable int _cached_size_;
+  ::google::protobuf::RepeatedField<int> codes_;
+  friend void  protobuf_AddDesc_raft_5fserver_2eproto();
+  friend void protobuf_AssignDesc_raft_5fserver_2eproto();
+  friend void protobuf_ShutdownFile_raft_5fserver_2eproto();
 
+  void InitAsDefaultInstance();
+  static StepBatchResponse* default_instance_;
+};
 // -------------------------------------------------------------------
 
-// StatusResponse
+class HeartbeatBatchRequest : public ::google::protobuf::Message {
+ public:
+  HeartbeatBatchRequest();
+  virtual ~HeartbeatBatchRequest();
 
-// optional uint64 leader = 1;
-inline bool StatusResponse::has_leader() const {
-  return (_has_bits_[0] & 0x00000001u) != 0;
-}
-inline void StatusResponse::set_has_leader() {
-  _has_bits_[0] |= 0x00000001u;
-}
-inline void StatusResponse::clear_has_leader() {
-  _has_bits_[0] &= ~0x00000001u;
-}
-inline void StatusResponse::clear_leader() {
-  leader_ = GOOGLE_ULONGLONG(0);
-  clear_has_leader();
-}
-inline ::google::protobuf::uint64 StatusResponse::leader() const {
-  // @@protoc_insertion_point(field_get:consensus.pb.StatusResponse.leader)
-  return leader_;
-}
-inline void StatusResponse::set_leader(::google::protobuf::uint64 value) {
-  set_has_leader();
-  leader_ = value;
-  // @@protoc_insertion_point(field_set:consensus.pb.StatusResponse.leader)
-}
+  HeartbeatBatchRequest(const HeartbeatBatchRequest& from);
 
-// optional uint64 raftIndex = 2;
-inline bool StatusResponse::has_raftindex() const {
-  return (_has_bits_[0] & 0x00000002u) != 0;
-}
-inline void StatusResponse::set_has_raftindex() {
-  _has_bits_[0] |= 0x00000002u;
-}
-inline void StatusResponse::clear_has_raftindex() {
-  _has_bits_[0] &= ~0x00000002u;
-}
-inline void StatusResponse::clear_raftindex() {
-  raftindex_ = GOOGLE_ULONGLONG(0);
-  clear_has_raftindex();
-}
-inline ::google::protobuf::uint64 StatusResponse::raftindex() const {
-  // @@protoc_insertion_point(field_get:consensus.pb.StatusResponse.raftIndex)
-  return raftindex_;
-}
-inline void StatusResponse::set_raftindex(::google::protobuf::uint64 value) {
-  set_has_raftindex();
+  inline HeartbeatBatchRequest& operator=(const HeartbeatBatchRequest& from) {
+    CopyFrom(from);
+    return *this;
+  }
+
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const HeartbeatBatchRequest& default_instance();
+
+  void Swap(HeartbeatBatchRequest* other);
+
+  // implements Message ----------------------------------------------
+
+  HeartbeatBatchRequest* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const HeartbeatBatchRequest& from);
+  void MergeFrom(const HeartbeatBatchRequest& from);
+  void Clear();
+  bool IsInitialized() const;
+
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  ::google::protobuf::Metadata GetMetadata() const;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  // repeated uint64 group_ids = 1;
+  inline int group_ids_size() const;
+  inline void clear_group_ids();
+  static const int kGroupIdsFieldNumber = 1;
+  inline ::google::protobuf::uint64 group_ids(int index) const;
+  inline void set_group_ids(int index, ::google::protobuf::uint64 value);
+  inline void add_group_ids(::google::protobuf::uint64 value);
+  inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint64 >&
+      group_ids() const;
+  inline ::google::protobuf::RepeatedField< ::google::protobuf::uint64 >*
+      mutable_group_ids();
+
+  // repeated .yaraft.pb.Message messages = 2;
+  inline int messages_size() const;
+  inline void clear_messages();
+  static const int kMessagesFieldNumber = 2;
+  inline const ::yaraft::pb::Message& messages(int index) const;
+  inline ::yaraft::pb::Message* mutable_messages(int index);
+  inline ::yaraft::pb::Message* add_messages();
+  inline const ::google::protobuf::RepeatedPtrField< ::yaraft::pb::Message >&
+      messages() const;
+  inline ::google::protobuf::RepeatedPtrField< ::yaraft::pb::Message >*
+      mutable_messages();
+
+  // @@protoc_insertion_point(class_scope:consensus.pb.HeartbeatBatchRequest)
+ private:
+
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+
+  ::google::protobuf::uint32 _has_bits_[1];
+  mutable int _cached_size_;
+  ::google::protobuf::RepeatedField< ::google::protobuf::uint64 > group_ids_;
+  ::google::protobuf::RepeatedPtrField< ::yaraft::pb::Message > messages_;
+  friend void  protobuf_AddDesc_raft_5fserver_2eproto();
+  friend void protobuf_AssignDesc_raft_5fserver_2eproto();
+  friend void protobuf_ShutdownFile_raft_5fserver_2eproto();
+
+  void InitAsDefaultInstance();
+  static HeartbeatBatchRequest* default_instance_;
+};
+// -------------------------------------------------------------------
+
+class HeartbeatBatchResponse : public ::google::protobuf::Message {
+ public:
+  HeartbeatBatchResponse();
+  virtual ~HeartbeatBatchResponse();
+
+  HeartbeatBatchResponse(const HeartbeatBatchResponse& from);
+
+  inline HeartbeatBatchResponse& operator=(const HeartbeatBatchResponse& from) {
+    CopyFrom(from);
+    return *this;
+  }
+
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const HeartbeatBatchResponse& default_instance();
+
+  void Swap(HeartbeatBatchResponse* other);
+
+  // implements Message ----------------------------------------------
+
+  HeartbeatBatchResponse* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const HeartbeatBatchResponse& from);
+  void MergeFrom(const HeartbeatBatchResponse& from);
+  void Clear();
+  bool IsInitialized() const;
+
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  ::google::protobuf::Metadata GetMetadata() const;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  // @@protoc_insertion_point(class_scope:consensus.pb.HeartbeatBatchResponse)
+ private:
+
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+
+  ::google::protobuf::uint32 _has_bits_[1];
+  mutable int _cached_size_;
+  friend void  protobuf_AddDesc_raft_5fserver_2eproto();
+  friend void protobuf_AssignDesc_raft_5fserver_2eproto();
+  friend void protobuf_ShutdownFile_raft_5fserver_2eproto();
+
+  void InitAsDefaultInstance();
+  static HeartbeatBatchResponse* default_instance_;
+};
+// -------------------------------------------------------------------
+
+class InstallSnapshotRequest : public ::google::protobuf::Message {
+ public:
+  InstallSnapshotRequest();
+  virtual ~InstallSnapshotRequest();
+
+  InstallSnapshotRequest(const InstallSnapshotRequest& from);
+
+  inline InstallSnapshotRequest& operator=(const InstallSnapshotRequest& from) {
+    CopyFrom(from);
+    return *this;
+  }
+
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const InstallSnapshotRequest& default_instance();
+
+  void Swap(InstallSnapshotRequest* other);
+
+  // implements Message ----------------------------------------------
+
+  InstallSnapshotRequest* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const InstallSnapshotRequest& from);
+  void MergeFrom(const InstallSnapshotRequest& from);
+  void Clear();
+  bool IsInitialized() const;
+
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  ::google::protobuf::Metadata GetMetadata() const;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  // required .yaraft.pb.Message message = 1;
+  inline bool has_message() const;
+  inline void clear_message();
+  static const int kMessageFieldNumber = 1;
+  inline const ::yaraft::pb::Message& message() const;
+  inline ::yaraft::pb::Message* mutable_message();
+  inline ::yaraft::pb::Message* release_message();
+  inline void set_allocated_message(::yaraft::pb::Message* message);
+
+  // optional uint64 offset = 2;
+  inline bool has_offset() const;
+  inline void clear_offset();
+  static const int kOffsetFieldNumber = 2;
+  inline ::google::protobuf::uint64 offset() const;
+  inline void set_offset(::google::protobuf::uint64 value);
+
+  // optional bool done = 3;
+  inline bool has_done() const;
+  inline void clear_done();
+  static const int kDoneFieldNumber = 3;
+  inline bool done() const;
+  inline void set_done(bool value);
+
+  // optional uint64 group_id = 4;
+  inline bool has_group_id() const;
+  inline void clear_group_id();
+  static const int kGroupIdFieldNumber = 4;
+  inline ::google::protobuf::uint64 group_id() const;
+  inline void set_group_id(::google::protobuf::uint64 value);
+
+  // @@protoc_insertion_point(class_scope:consensus.pb.InstallSnapshotRequest)
+ private:
+  inline void set_has_message();
+  inline void clear_has_message();
+  inline void set_has_offset();
+  inline void clear_has_offset();
+  inline void set_has_done();
+  inline void clear_has_done();
+  inline void set_has_group_id();
+  inline void clear_has_group_id();
+
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+
+  ::google::protobuf::uint32 _has_bits_[1];
+  mutable int _cached_size_;
+  ::yaraft::pb::Message* message_;
+  ::google::protobuf::uint64 offset_;
+  ::google::protobuf::uint64 group_id_;
+  bool done_;
+  friend void  protobuf_AddDesc_raft_5fserver_2eproto();
+  friend void protobuf_AssignDesc_raft_5fserver_2eproto();
+  friend void protobuf_ShutdownFile_raft_5fserver_2eproto();
+
+  void InitAsDefaultInstance();
+  static InstallSnapshotRequest* default_instance_;
+};
+// -------------------------------------------------------------------
+
+class InstallSnapshotResponse : public ::google::protobuf::Message {
+ public:
+  InstallSnapshotResponse();
+  virtual ~InstallSnapshotResponse();
+
+  InstallSnapshotResponse(const InstallSnapshotResponse& from);
+
+  inline InstallSnapshotResponse& operator=(const InstallSnapshotResponse& from) {
+    CopyFrom(from);
+    return *this;
+  }
+
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const InstallSnapshotResponse& default_instance();
+
+  void Swap(InstallSnapshotResponse* other);
+
+  // implements Message ----------------------------------------------
+
+  InstallSnapshotResponse* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const InstallSnapshotResponse& from);
+  void MergeFrom(const InstallSnapshotResponse& from);
+  void Clear();
+  bool IsInitialized() const;
+
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  ::google::protobuf::Metadata GetMetadata() const;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  // @@protoc_insertion_point(class_scope:consensus.pb.InstallSnapshotResponse)
+ private:
+
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+
+  ::google::protobuf::uint32 _has_bits_[1];
+  mutable int _cached_size_;
+  friend void  protobuf_AddDesc_raft_5fserver_2eproto();
+  friend void protobuf_AssignDesc_raft_5fserver_2eproto();
+  friend void protobuf_ShutdownFile_raft_5fserver_2eproto();
+
+  void InitAsDefaultInstance();
+  static InstallSnapshotResponse* default_instance_;
+};
+// -------------------------------------------------------------------
+
+class ReadIndexRequest : public ::google::protobuf::Message {
+ public:
+  ReadIndexRequest();
+  virtual ~ReadIndexRequest();
+
+  ReadIndexRequest(const ReadIndexRequest& from);
+
+  inline ReadIndexRequest& operator=(const ReadIndexRequest& from) {
+    CopyFrom(from);
+    return *this;
+  }
+
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const ReadIndexRequest& default_instance();
+
+  void Swap(ReadIndexRequest* other);
+
+  // implements Message ----------------------------------------------
+
+  ReadIndexRequest* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const ReadIndexRequest& from);
+  void MergeFrom(const ReadIndexRequest& from);
+  void Clear();
+  bool IsInitialized() const;
+
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  ::google::protobuf::Metadata GetMetadata() const;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  // optional uint64 group_id = 1;
+  inline bool has_group_id() const;
+  inline void clear_group_id();
+  static const int kGroupIdFieldNumber = 1;
+  inline ::google::protobuf::uint64 group_id() const;
+  inline void set_group_id(::google::protobuf::uint64 value);
+
+  // @@protoc_insertion_point(class_scope:consensus.pb.ReadIndexRequest)
+ private:
+  inline void set_has_group_id();
+  inline void clear_has_group_id();
+
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+
+  ::google::protobuf::uint32 _has_bits_[1];
+  mutable int _cached_size_;
+  ::google::protobuf::uint64 group_id_;
+  friend void  protobuf_AddDesc_raft_5fserver_2eproto();
+  friend void protobuf_AssignDesc_raft_5fserver_2eproto();
+  friend void protobuf_ShutdownFile_raft_5fserver_2eproto();
+
+  void InitAsDefaultInstance();
+  static ReadIndexRequest* default_instance_;
+};
+// -------------------------------------------------------------------
+
+class ReadIndexResponse : public ::google::protobuf::Message {
+ public:
+  ReadIndexResponse();
+  virtual ~ReadIndexResponse();
+
+  ReadIndexResponse(const ReadIndexResponse& from);
+
+  inline ReadIndexResponse& operator=(const ReadIndexResponse& from) {
+    CopyFrom(from);
+    return *this;
+  }
+
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const ReadIndexResponse& default_instance();
+
+  void Swap(ReadIndexResponse* other);
+
+  // implements Message ----------------------------------------------
+
+  ReadIndexResponse* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const ReadIndexResponse& from);
+  void MergeFrom(const ReadIndexResponse& from);
+  void Clear();
+  bool IsInitialized() const;
+
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  ::google::protobuf::Metadata GetMetadata() const;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  // optional uint64 index = 1;
+  inline bool has_index() const;
+  inline void clear_index();
+  static const int kIndexFieldNumber = 1;
+  inline ::google::protobuf::uint64 index() const;
+  inline void set_index(::google::protobuf::uint64 value);
+
+  // @@protoc_insertion_point(class_scope:consensus.pb.ReadIndexResponse)
+ private:
+  inline void set_has_index();
+  inline void clear_has_index();
+
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+
+  ::google::protobuf::uint32 _has_bits_[1];
+  mutable int _cached_size_;
+  ::google::protobuf::uint64 index_;
+  friend void  protobuf_AddDesc_raft_5fserver_2eproto();
+  friend void protobuf_AssignDesc_raft_5fserver_2eproto();
+  friend void protobuf_ShutdownFile_raft_5fserver_2eproto();
+
+  void InitAsDefaultInstance();
+  static ReadIndexResponse* default_instance_;
+};
+// -------------------------------------------------------------------
+
+class MemoryUsage : public ::google::protobuf::Message {
+ public:
+  MemoryUsage();
+  virtual ~MemoryUsage();
+
+  MemoryUsage(const MemoryUsage& from);
+
+  inline MemoryUsage& operator=(const MemoryUsage& from) {
+    CopyFrom(from);
+    return *this;
+  }
+
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const MemoryUsage& default_instance();
+
+  void Swap(MemoryUsage* other);
+
+  // implements Message ----------------------------------------------
+
+  MemoryUsage* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const MemoryUsage& from);
+  void MergeFrom(const MemoryUsage& from);
+  void Clear();
+  bool IsInitialized() const;
+
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  ::google::protobuf::Metadata GetMetadata() const;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  // optional string component = 1;
+  inline bool has_component() const;
+  inline void clear_component();
+  static const int kComponentFieldNumber = 1;
+  inline const ::std::string& component() const;
+  inline void set_component(const ::std::string& value);
+  inline void set_component(const char* value);
+  inline void set_component(const char* value, size_t size);
+  inline ::std::string* mutable_component();
+  inline ::std::string* release_component();
+  inline void set_allocated_component(::std::string* component);
+
+  // optional uint64 bytes = 2;
+  inline bool has_bytes() const;
+  inline void clear_bytes();
+  static const int kBytesFieldNumber = 2;
+  inline ::google::protobuf::uint64 bytes() const;
+  inline void set_bytes(::google::protobuf::uint64 value);
+
+  // @@protoc_insertion_point(class_scope:consensus.pb.MemoryUsage)
+ private:
+  inline void set_has_component();
+  inline void clear_has_component();
+  inline void set_has_bytes();
+  inline void clear_has_bytes();
+
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+
+  ::google::protobuf::uint32 _has_bits_[1];
+  mutable int _cached_size_;
+  ::std::string* component_;
+  ::google::protobuf::uint64 bytes_;
+  friend void  protobuf_AddDesc_raft_5fserver_2eproto();
+  friend void protobuf_AssignDesc_raft_5fserver_2eproto();
+  friend void protobuf_ShutdownFile_raft_5fserver_2eproto();
+
+  void InitAsDefaultInstance();
+  static MemoryUsage* default_instance_;
+};
+// ===================================================================
+
+class RaftService_Stub;
+
+class RaftService : public ::google::protobuf::Service {
+ protected:
+  // This class should be treated as an abstract interface.
+  inline RaftService() {};
+ public:
+  virtual ~RaftService();
+
+  typedef RaftService_Stub Stub;
+
+  static const ::google::protobuf::ServiceDescriptor* descriptor();
+
+  virtual void Step(::google::protobuf::RpcController* controller,
+                       const ::consensus::pb::StepRequest* request,
+                       ::consensus::pb::StepResponse* response,
+                       ::google::protobuf::Closure* done);
+  virtual void Status(::google::protobuf::RpcController* controller,
+                       const ::consensus::pb::StatusRequest* request,
+                       ::consensus::pb::StatusResponse* response,
+                       ::google::protobuf::Closure* done);
+  virtual void StepBatch(::google::protobuf::RpcController* controller,
+                       const ::consensus::pb::StepBatchRequest* request,
+                       ::consensus::pb::StepBatchResponse* response,
+                       ::google::protobuf::Closure* done);
+  virtual void HeartbeatBatch(::google::protobuf::RpcController* controller,
+                       const ::consensus::pb::HeartbeatBatchRequest* request,
+                       ::consensus::pb::HeartbeatBatchResponse* response,
+                       ::google::protobuf::Closure* done);
+  virtual void InstallSnapshot(::google::protobuf::RpcController* controller,
+                       const ::consensus::pb::InstallSnapshotRequest* request,
+                       ::consensus::pb::InstallSnapshotResponse* response,
+                       ::google::protobuf::Closure* done);
+  virtual void ReadIndex(::google::protobuf::RpcController* controller,
+                       const ::consensus::pb::ReadIndexRequest* request,
+                       ::consensus::pb::ReadIndexResponse* response,
+                       ::google::protobuf::Closure* done);
+
+  // implements Service ----------------------------------------------
+
+  const ::google::protobuf::ServiceDescriptor* GetDescriptor();
+  void CallMethod(const ::google::protobuf::MethodDescriptor* method,
+                  ::google::protobuf::RpcController* controller,
+                  const ::google::protobuf::Message* request,
+                  ::google::protobuf::Message* response,
+                  ::google::protobuf::Closure* done);
+  const ::google::protobuf::Message& GetRequestPrototype(
+    const ::google::protobuf::MethodDescriptor* method) const;
+  const ::google::protobuf::Message& GetResponsePrototype(
+    const ::google::protobuf::MethodDescriptor* method) const;
+
+ private:
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(RaftService);
+};
+
+class RaftService_Stub : public RaftService {
+ public:
+  RaftService_Stub(::google::protobuf::RpcChannel* channel);
+  RaftService_Stub(::google::protobuf::RpcChannel* channel,
+                   ::google::protobuf::Service::ChannelOwnership ownership);
+  ~RaftService_Stub();
+
+  inline ::google::protobuf::RpcChannel* channel() { return channel_; }
+
+  // implements RaftService ------------------------------------------
+
+  void Step(::google::protobuf::RpcController* controller,
+                       const ::consensus::pb::StepRequest* request,
+                       ::consensus::pb::StepResponse* response,
+                       ::google::protobuf::Closure* done);
+  void Status(::google::protobuf::RpcController* controller,
+                       const ::consensus::pb::StatusRequest* request,
+                       ::consensus::pb::StatusResponse* response,
+                       ::google::protobuf::Closure* done);
+  void StepBatch(::google::protobuf::RpcController* controller,
+                       const ::consensus::pb::StepBatchRequest* request,
+                       ::consensus::pb::StepBatchResponse* response,
+                       ::google::protobuf::Closure* done);
+  void HeartbeatBatch(::google::protobuf::RpcController* controller,
+                       const ::consensus::pb::HeartbeatBatchRequest* request,
+                       ::consensus::pb::HeartbeatBatchResponse* response,
+                       ::google::protobuf::Closure* done);
+  void InstallSnapshot(::google::protobuf::RpcController* controller,
+                       const ::consensus::pb::InstallSnapshotRequest* request,
+                       ::consensus::pb::InstallSnapshotResponse* response,
+                       ::google::protobuf::Closure* done);
+  void ReadIndex(::google::protobuf::RpcController* controller,
+                       const ::consensus::pb::ReadIndexRequest* request,
+                       ::consensus::pb::ReadIndexResponse* response,
+                       ::google::protobuf::Closure* done);
+ private:
+  ::google::protobuf::RpcChannel* channel_;
+  bool owns_channel_;
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(RaftService_Stub);
+};
+
+
+// ===================================================================
+
+
+// ===================================================================
+
+// StepRequest
+
+// required .yaraft.pb.Message message = 1;
+inline bool StepRequest::has_message() const {
+  return (_has_bits_[0] & 0x00000001u) != 0;
+}
+inline void StepRequest::set_has_message() {
+  _has_bits_[0] |= 0x00000001u;
+}
+inline void StepRequest::clear_has_message() {
+  _has_bits_[0] &= ~0x00000001u;
+}
+inline void StepRequest::clear_message() {
+  if (message_ != NULL) message_->::yaraft::pb::Message::Clear();
+  clear_has_message();
+}
+inline const ::yaraft::pb::Message& StepRequest::message() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StepRequest.message)
+  return message_ != NULL ? *message_ : *default_instance_->message_;
+}
+inline ::yaraft::pb::Message* StepRequest::mutable_message() {
+  set_has_message();
+  if (message_ == NULL) message_ = new ::yaraft::pb::Message;
+  // @@protoc_insertion_point(field_mutable:consensus.pb.StepRequest.message)
+  return message_;
+}
+inline ::yaraft::pb::Message* StepRequest::release_message() {
+  clear_has_message();
+  ::yaraft::pb::Message* temp = message_;
+  message_ = NULL;
+  return temp;
+}
+inline void StepRequest::set_allocated_message(::yaraft::pb::Message* message) {
+  delete message_;
+  message_ = message;
+  if (message) {
+    set_has_message();
+  } else {
+    clear_has_message();
+  }
+  // @@protoc_insertion_point(field_set_allocated:consensus.pb.StepRequest.message)
+}
+
+// optional uint64 group_id = 2;
+inline bool StepRequest::has_group_id() const {
+  return (_has_bits_[0] & 0x00000002u) != 0;
+}
+inline void StepRequest::set_has_group_id() {
+  _has_bits_[0] |= 0x00000002u;
+}
+inline void StepRequest::clear_has_group_id() {
+  _has_bits_[0] &= ~0x00000002u;
+}
+inline void StepRequest::clear_group_id() {
+  group_id_ = GOOGLE_ULONGLONG(0);
+  clear_has_group_id();
+}
+inline ::google::protobuf::uint64 StepRequest::group_id() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StepRequest.group_id)
+  return group_id_;
+}
+inline void StepRequest::set_group_id(::google::protobuf::uint64 value) {
+  set_has_group_id();
+  group_id_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.StepRequest.group_id)
+}
+
+// -------------------------------------------------------------------
+
+// StepResponse
+
+// required .consensus.pb.StatusCode code = 1;
+inline bool StepResponse::has_code() const {
+  return (_has_bits_[0] & 0x00000001u) != 0;
+}
+inline void StepResponse::set_has_code() {
+  _has_bits_[0] |= 0x00000001u;
+}
+inline void StepResponse::clear_has_code() {
+  _has_bits_[0] &= ~0x00000001u;
+}
+inline void StepResponse::clear_code() {
+  code_ = 0;
+  clear_has_code();
+}
+inline ::consensus::pb::StatusCode StepResponse::code() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StepResponse.code)
+  return static_cast< ::consensus::pb::StatusCode >(code_);
+}
+inline void StepResponse::set_code(::consensus::pb::StatusCode value) {
+  assert(::consensus::pb::StatusCode_IsValid(value));
+  set_has_code();
+  code_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.StepResponse.code)
+}
+
+// -------------------------------------------------------------------
+
+// StatusRequest
+
+// optional uint64 group_id = 1;
+inline bool StatusRequest::has_group_id() const {
+  return (_has_bits_[0] & 0x00000001u) != 0;
+}
+inline void StatusRequest::set_has_group_id() {
+  _has_bits_[0] |= 0x00000001u;
+}
+inline void StatusRequest::clear_has_group_id() {
+  _has_bits_[0] &= ~0x00000001u;
+}
+inline void StatusRequest::clear_group_id() {
+  group_id_ = GOOGLE_ULONGLONG(0);
+  clear_has_group_id();
+}
+inline ::google::protobuf::uint64 StatusRequest::group_id() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StatusRequest.group_id)
+  return group_id_;
+}
+inline void StatusRequest::set_group_id(::google::protobuf::uint64 value) {
+  set_has_group_id();
+  group_id_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.StatusRequest.group_id)
+}
+
+// -------------------------------------------------------------------
+
+// StatusResponse
+
+// optional uint64 leader = 1;
+inline bool StatusResponse::has_leader() const {
+  return (_has_bits_[0] & 0x00000001u) != 0;
+}
+inline void StatusResponse::set_has_leader() {
+  _has_bits_[0] |= 0x00000001u;
+}
+inline void StatusResponse::clear_has_leader() {
+  _has_bits_[0] &= ~0x00000001u;
+}
+inline void StatusResponse::clear_leader() {
+  leader_ = GOOGLE_ULONGLONG(0);
+  clear_has_leader();
+}
+inline ::google::protobuf::uint64 StatusResponse::leader() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StatusResponse.leader)
+  return leader_;
+}
+inline void StatusResponse::set_leader(::google::protobuf::uint64 value) {
+  set_has_leader();
+  leader_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.StatusResponse.leader)
+}
+
+// optional uint64 raftIndex = 2;
+inline bool StatusResponse::has_raftindex() const {
+  return (_has_bits_[0] & 0x00000002u) != 0;
+}
+inline void StatusResponse::set_has_raftindex() {
+  _has_bits_[0] |= 0x00000002u;
+}
+inline void StatusResponse::clear_has_raftindex() {
+  _has_bits_[0] &= ~0x00000002u;
+}
+inline void StatusResponse::clear_raftindex() {
+  raftindex_ = GOOGLE_ULONGLONG(0);
+  clear_has_raftindex();
+}
+inline ::google::protobuf::uint64 StatusResponse::raftindex() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StatusResponse.raftIndex)
+  return raftindex_;
+}
+inline void StatusResponse::set_raftindex(::google::protobuf::uint64 value) {
+  set_has_raftindex();
   raftindex_ = value;
   // @@protoc_insertion_point(field_set:consensus.pb.StatusResponse.raftIndex)
 }
@@ -648,6 +1608,647 @@ inline void StatusResponse::set_raftcommit(::google::protobuf::uint64 value) {
   // @@protoc_insertion_point(field_set:consensus.pb.StatusResponse.raftCommit)
 }
 
+// optional uint64 walAppendBytes = 5;
+inline bool StatusResponse::has_walappendbytes() const {
+  return (_has_bits_[0] & 0x00000010u) != 0;
+}
+inline void StatusResponse::set_has_walappendbytes() {
+  _has_bits_[0] |= 0x00000010u;
+}
+inline void StatusResponse::clear_has_walappendbytes() {
+  _has_bits_[0] &= ~0x00000010u;
+}
+inline void StatusResponse::clear_walappendbytes() {
+  walappendbytes_ = GOOGLE_ULONGLONG(0);
+  clear_has_walappendbytes();
+}
+inline ::google::protobuf::uint64 StatusResponse::walappendbytes() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StatusResponse.walAppendBytes)
+  return walappendbytes_;
+}
+inline void StatusResponse::set_walappendbytes(::google::protobuf::uint64 value) {
+  set_has_walappendbytes();
+  walappendbytes_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.StatusResponse.walAppendBytes)
+}
+
+// optional uint64 walSyncLatencyUs = 6;
+inline bool StatusResponse::has_walsynclatencyus() const {
+  return (_has_bits_[0] & 0x00000020u) != 0;
+}
+inline void StatusResponse::set_has_walsynclatencyus() {
+  _has_bits_[0] |= 0x00000020u;
+}
+inline void StatusResponse::clear_has_walsynclatencyus() {
+  _has_bits_[0] &= ~0x00000020u;
+}
+inline void StatusResponse::clear_walsynclatencyus() {
+  walsynclatencyus_ = GOOGLE_ULONGLONG(0);
+  clear_has_walsynclatencyus();
+}
+inline ::google::protobuf::uint64 StatusResponse::walsynclatencyus() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StatusResponse.walSyncLatencyUs)
+  return walsynclatencyus_;
+}
+inline void StatusResponse::set_walsynclatencyus(::google::protobuf::uint64 value) {
+  set_has_walsynclatencyus();
+  walsynclatencyus_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.StatusResponse.walSyncLatencyUs)
+}
+
+// optional uint64 commitLatencyUs = 7;
+inline bool StatusResponse::has_commitlatencyus() const {
+  return (_has_bits_[0] & 0x00000040u) != 0;
+}
+inline void StatusResponse::set_has_commitlatencyus() {
+  _has_bits_[0] |= 0x00000040u;
+}
+inline void StatusResponse::clear_has_commitlatencyus() {
+  _has_bits_[0] &= ~0x00000040u;
+}
+inline void StatusResponse::clear_commitlatencyus() {
+  commitlatencyus_ = GOOGLE_ULONGLONG(0);
+  clear_has_commitlatencyus();
+}
+inline ::google::protobuf::uint64 StatusResponse::commitlatencyus() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StatusResponse.commitLatencyUs)
+  return commitlatencyus_;
+}
+inline void StatusResponse::set_commitlatencyus(::google::protobuf::uint64 value) {
+  set_has_commitlatencyus();
+  commitlatencyus_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.StatusResponse.commitLatencyUs)
+}
+
+// optional uint64 proposalsInflight = 8;
+inline bool StatusResponse::has_proposalsinflight() const {
+  return (_has_bits_[0] & 0x00000080u) != 0;
+}
+inline void StatusResponse::set_has_proposalsinflight() {
+  _has_bits_[0] |= 0x00000080u;
+}
+inline void StatusResponse::clear_has_proposalsinflight() {
+  _has_bits_[0] &= ~0x00000080u;
+}
+inline void StatusResponse::clear_proposalsinflight() {
+  proposalsinflight_ = GOOGLE_ULONGLONG(0);
+  clear_has_proposalsinflight();
+}
+inline ::google::protobuf::uint64 StatusResponse::proposalsinflight() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StatusResponse.proposalsInflight)
+  return proposalsinflight_;
+}
+inline void StatusResponse::set_proposalsinflight(::google::protobuf::uint64 value) {
+  set_has_proposalsinflight();
+  proposalsinflight_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.StatusResponse.proposalsInflight)
+}
+
+// repeated .consensus.pb.MemoryUsage memory = 9;
+inline int StatusResponse::memory_size() const {
+  return memory_.size();
+}
+inline void StatusResponse::clear_memory() {
+  memory_.Clear();
+}
+inline const ::consensus::pb::MemoryUsage& StatusResponse::memory(int index) const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StatusResponse.memory)
+  return memory_.Get(index);
+}
+inline ::consensus::pb::MemoryUsage* StatusResponse::mutable_memory(int index) {
+  // @@protoc_insertion_point(field_mutable:consensus.pb.StatusResponse.memory)
+  return memory_.Mutable(index);
+}
+inline ::consensus::pb::MemoryUsage* StatusResponse::add_memory() {
+  // @@protoc_insertion_point(field_add:consensus.pb.StatusResponse.memory)
+  return memory_.Add();
+}
+inline const ::google::protobuf::RepeatedPtrField< ::consensus::pb::MemoryUsage >&
+StatusResponse::memory() const {
+  // @@protoc_insertion_point(field_list:consensus.pb.StatusResponse.memory)
+  return memory_;
+}
+inline ::google::protobuf::RepeatedPtrField< ::consensus::pb::MemoryUsage >*
+StatusResponse::mutable_memory() {
+  // @@protoc_insertion_point(field_mutable_list:consensus.pb.StatusResponse.memory)
+  return &memory_;
+}
+
+// optional uint64 memorySoftLimit = 10;
+inline bool StatusResponse::has_memorysoftlimit() const {
+  return (_has_bits_[0] & 0x00000200u) != 0;
+}
+inline void StatusResponse::set_has_memorysoftlimit() {
+  _has_bits_[0] |= 0x00000200u;
+}
+inline void StatusResponse::clear_has_memorysoftlimit() {
+  _has_bits_[0] &= ~0x00000200u;
+}
+inline void StatusResponse::clear_memorysoftlimit() {
+  memorysoftlimit_ = GOOGLE_ULONGLONG(0);
+  clear_has_memorysoftlimit();
+}
+inline ::google::protobuf::uint64 StatusResponse::memorysoftlimit() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StatusResponse.memorySoftLimit)
+  return memorysoftlimit_;
+}
+inline void StatusResponse::set_memorysoftlimit(::google::protobuf::uint64 value) {
+  set_has_memorysoftlimit();
+  memorysoftlimit_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.StatusResponse.memorySoftLimit)
+}
+
+// -------------------------------------------------------------------
+
+// StepBatchRequest
+
+// repeated .yaraft.pb.Message messages = 1;
+inline int StepBatchRequest::messages_size() const {
+  return messages_.size();
+}
+inline void StepBatchRequest::clear_messages() {
+  messages_.Clear();
+}
+inline const ::yaraft::pb::Message& StepBatchRequest::messages(int index) const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StepBatchRequest.messages)
+  return messages_.Get(index);
+}
+inline ::yaraft::pb::Message* StepBatchRequest::mutable_messages(int index) {
+  // @@protoc_insertion_point(field_mutable:consensus.pb.StepBatchRequest.messages)
+  return messages_.Mutable(index);
+}
+inline ::yaraft::pb::Message* StepBatchRequest::add_messages() {
+  // @@protoc_insertion_point(field_add:consensus.pb.StepBatchRequest.messages)
+  return messages_.Add();
+}
+inline const ::google::protobuf::RepeatedPtrField< ::yaraft::pb::Message >&
+StepBatchRequest::messages() const {
+  // @@protoc_insertion_point(field_list:consensus.pb.StepBatchRequest.messages)
+  return messages_;
+}
+inline ::google::protobuf::RepeatedPtrField< ::yaraft::pb::Message >*
+StepBatchRequest::mutable_messages() {
+  // @@protoc_insertion_point(field_mutable_list:consensus.pb.StepBatchRequest.messages)
+  return &messages_;
+}
+
+// optional uint32 payloadCompression = 2;
+inline bool StepBatchRequest::has_payloadcompression() const {
+  return (_has_bits_[0] & 0x00000002u) != 0;
+}
+inline void StepBatchRequest::set_has_payloadcompression() {
+  _has_bits_[0] |= 0x00000002u;
+}
+inline void StepBatchRequest::clear_has_payloadcompression() {
+  _has_bits_[0] &= ~0x00000002u;
+}
+inline void StepBatchRequest::clear_payloadcompression() {
+  payloadcompression_ = 0u;
+  clear_has_payloadcompression();
+}
+inline ::google::protobuf::uint32 StepBatchRequest::payloadcompression() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StepBatchRequest.payloadCompression)
+  return payloadcompression_;
+}
+inline void StepBatchRequest::set_payloadcompression(::google::protobuf::uint32 value) {
+  set_has_payloadcompression();
+  payloadcompression_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.StepBatchRequest.payloadCompression)
+}
+
+// optional uint32 payloadLength = 3;
+inline bool StepBatchRequest::has_payloadlength() const {
+  return (_has_bits_[0] & 0x00000004u) != 0;
+}
+inline void StepBatchRequest::set_has_payloadlength() {
+  _has_bits_[0] |= 0x00000004u;
+}
+inline void StepBatchRequest::clear_has_payloadlength() {
+  _has_bits_[0] &= ~0x00000004u;
+}
+inline void StepBatchRequest::clear_payloadlength() {
+  payloadlength_ = 0u;
+  clear_has_payloadlength();
+}
+inline ::google::protobuf::uint32 StepBatchRequest::payloadlength() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StepBatchRequest.payloadLength)
+  return payloadlength_;
+}
+inline void StepBatchRequest::set_payloadlength(::google::protobuf::uint32 value) {
+  set_has_payloadlength();
+  payloadlength_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.StepBatchRequest.payloadLength)
+}
+
+// optional uint64 group_id = 4;
+inline bool StepBatchRequest::has_group_id() const {
+  return (_has_bits_[0] & 0x00000008u) != 0;
+}
+inline void StepBatchRequest::set_has_group_id() {
+  _has_bits_[0] |= 0x00000008u;
+}
+inline void StepBatchRequest::clear_has_group_id() {
+  _has_bits_[0] &= ~0x00000008u;
+}
+inline void StepBatchRequest::clear_group_id() {
+  group_id_ = GOOGLE_ULONGLONG(0);
+  clear_has_group_id();
+}
+inline ::google::protobuf::uint64 StepBatchRequest::group_id() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StepBatchRequest.group_id)
+  return group_id_;
+}
+inline void StepBatchRequest::set_group_id(::google::protobuf::uint64 value) {
+  set_has_group_id();
+  group_id_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.StepBatchRequest.group_id)
+}
+
+// -------------------------------------------------------------------
+
+// StepBatchResponse
+
+// repeated .consensus.pb.StatusCode codes = 1;
+inline int StepBatchResponse::codes_size() const {
+  return codes_.size();
+}
+inline void StepBatchResponse::clear_codes() {
+  codes_.Clear();
+}
+inline ::consensus::pb::StatusCode StepBatchResponse::codes(int index) const {
+  // @@protoc_insertion_point(field_get:consensus.pb.StepBatchResponse.codes)
+  return static_cast< ::consensus::pb::StatusCode >(codes_.Get(index));
+}
+inline void StepBatchResponse::set_codes(int index, ::consensus::pb::StatusCode value) {
+  assert(::consensus::pb::StatusCode_IsValid(value));
+  codes_.Set(index, value);
+  // @@protoc_insertion_point(field_set:consensus.pb.StepBatchResponse.codes)
+}
+inline void StepBatchResponse::add_codes(::consensus::pb::StatusCode value) {
+  assert(::consensus::pb::StatusCode_IsValid(value));
+  codes_.Add(value);
+  // @@protoc_insertion_point(field_add:consensus.pb.StepBatchResponse.codes)
+}
+inline const ::google::protobuf::RepeatedField<int>&
+StepBatchResponse::codes() const {
+  // @@protoc_insertion_point(field_list:consensus.pb.StepBatchResponse.codes)
+  return codes_;
+}
+inline ::google::protobuf::RepeatedField<int>*
+StepBatchResponse::mutable_codes() {
+  // @@protoc_insertion_point(field_mutable_list:consensus.pb.StepBatchResponse.codes)
+  return &codes_;
+}
+
+// -------------------------------------------------------------------
+
+// HeartbeatBatchRequest
+
+// repeated uint64 group_ids = 1;
+inline int HeartbeatBatchRequest::group_ids_size() const {
+  return group_ids_.size();
+}
+inline void HeartbeatBatchRequest::clear_group_ids() {
+  group_ids_.Clear();
+}
+inline ::google::protobuf::uint64 HeartbeatBatchRequest::group_ids(int index) const {
+  // @@protoc_insertion_point(field_get:consensus.pb.HeartbeatBatchRequest.group_ids)
+  return group_ids_.Get(index);
+}
+inline void HeartbeatBatchRequest::set_group_ids(int index, ::google::protobuf::uint64 value) {
+  group_ids_.Set(index, value);
+  // @@protoc_insertion_point(field_set:consensus.pb.HeartbeatBatchRequest.group_ids)
+}
+inline void HeartbeatBatchRequest::add_group_ids(::google::protobuf::uint64 value) {
+  group_ids_.Add(value);
+  // @@protoc_insertion_point(field_add:consensus.pb.HeartbeatBatchRequest.group_ids)
+}
+inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint64 >&
+HeartbeatBatchRequest::group_ids() const {
+  // @@protoc_insertion_point(field_list:consensus.pb.HeartbeatBatchRequest.group_ids)
+  return group_ids_;
+}
+inline ::google::protobuf::RepeatedField< ::google::protobuf::uint64 >*
+HeartbeatBatchRequest::mutable_group_ids() {
+  // @@protoc_insertion_point(field_mutable_list:consensus.pb.HeartbeatBatchRequest.group_ids)
+  return &group_ids_;
+}
+
+// repeated .yaraft.pb.Message messages = 2;
+inline int HeartbeatBatchRequest::messages_size() const {
+  return messages_.size();
+}
+inline void HeartbeatBatchRequest::clear_messages() {
+  messages_.Clear();
+}
+inline const ::yaraft::pb::Message& HeartbeatBatchRequest::messages(int index) const {
+  // @@protoc_insertion_point(field_get:consensus.pb.HeartbeatBatchRequest.messages)
+  return messages_.Get(index);
+}
+inline ::yaraft::pb::Message* HeartbeatBatchRequest::mutable_messages(int index) {
+  // @@protoc_insertion_point(field_mutable:consensus.pb.HeartbeatBatchRequest.messages)
+  return messages_.Mutable(index);
+}
+inline ::yaraft::pb::Message* HeartbeatBatchRequest::add_messages() {
+  // @@protoc_insertion_point(field_add:consensus.pb.HeartbeatBatchRequest.messages)
+  return messages_.Add();
+}
+inline const ::google::protobuf::RepeatedPtrField< ::yaraft::pb::Message >&
+HeartbeatBatchRequest::messages() const {
+  // @@protoc_insertion_point(field_list:consensus.pb.HeartbeatBatchRequest.messages)
+  return messages_;
+}
+inline ::google::protobuf::RepeatedPtrField< ::yaraft::pb::Message >*
+HeartbeatBatchRequest::mutable_messages() {
+  // @@protoc_insertion_point(field_mutable_list:consensus.pb.HeartbeatBatchRequest.messages)
+  return &messages_;
+}
+
+// -------------------------------------------------------------------
+
+// HeartbeatBatchResponse
+
+// -------------------------------------------------------------------
+
+// InstallSnapshotRequest
+
+// required .yaraft.pb.Message message = 1;
+inline bool InstallSnapshotRequest::has_message() const {
+  return (_has_bits_[0] & 0x00000001u) != 0;
+}
+inline void InstallSnapshotRequest::set_has_message() {
+  _has_bits_[0] |= 0x00000001u;
+}
+inline void InstallSnapshotRequest::clear_has_message() {
+  _has_bits_[0] &= ~0x00000001u;
+}
+inline void InstallSnapshotRequest::clear_message() {
+  if (message_ != NULL) message_->::yaraft::pb::Message::Clear();
+  clear_has_message();
+}
+inline const ::yaraft::pb::Message& InstallSnapshotRequest::message() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.InstallSnapshotRequest.message)
+  return message_ != NULL ? *message_ : *default_instance_->message_;
+}
+inline ::yaraft::pb::Message* InstallSnapshotRequest::mutable_message() {
+  set_has_message();
+  if (message_ == NULL) message_ = new ::yaraft::pb::Message;
+  // @@protoc_insertion_point(field_mutable:consensus.pb.InstallSnapshotRequest.message)
+  return message_;
+}
+inline ::yaraft::pb::Message* InstallSnapshotRequest::release_message() {
+  clear_has_message();
+  ::yaraft::pb::Message* temp = message_;
+  message_ = NULL;
+  return temp;
+}
+inline void InstallSnapshotRequest::set_allocated_message(::yaraft::pb::Message* message) {
+  delete message_;
+  message_ = message;
+  if (message) {
+    set_has_message();
+  } else {
+    clear_has_message();
+  }
+  // @@protoc_insertion_point(field_set_allocated:consensus.pb.InstallSnapshotRequest.message)
+}
+
+// optional uint64 offset = 2;
+inline bool InstallSnapshotRequest::has_offset() const {
+  return (_has_bits_[0] & 0x00000002u) != 0;
+}
+inline void InstallSnapshotRequest::set_has_offset() {
+  _has_bits_[0] |= 0x00000002u;
+}
+inline void InstallSnapshotRequest::clear_has_offset() {
+  _has_bits_[0] &= ~0x00000002u;
+}
+inline void InstallSnapshotRequest::clear_offset() {
+  offset_ = GOOGLE_ULONGLONG(0);
+  clear_has_offset();
+}
+inline ::google::protobuf::uint64 InstallSnapshotRequest::offset() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.InstallSnapshotRequest.offset)
+  return offset_;
+}
+inline void InstallSnapshotRequest::set_offset(::google::protobuf::uint64 value) {
+  set_has_offset();
+  offset_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.InstallSnapshotRequest.offset)
+}
+
+// optional bool done = 3;
+inline bool InstallSnapshotRequest::has_done() const {
+  return (_has_bits_[0] & 0x00000004u) != 0;
+}
+inline void InstallSnapshotRequest::set_has_done() {
+  _has_bits_[0] |= 0x00000004u;
+}
+inline void InstallSnapshotRequest::clear_has_done() {
+  _has_bits_[0] &= ~0x00000004u;
+}
+inline void InstallSnapshotRequest::clear_done() {
+  done_ = false;
+  clear_has_done();
+}
+inline bool InstallSnapshotRequest::done() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.InstallSnapshotRequest.done)
+  return done_;
+}
+inline void InstallSnapshotRequest::set_done(bool value) {
+  set_has_done();
+  done_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.InstallSnapshotRequest.done)
+}
+
+// optional uint64 group_id = 4;
+inline bool InstallSnapshotRequest::has_group_id() const {
+  return (_has_bits_[0] & 0x00000008u) != 0;
+}
+inline void InstallSnapshotRequest::set_has_group_id() {
+  _has_bits_[0] |= 0x00000008u;
+}
+inline void InstallSnapshotRequest::clear_has_group_id() {
+  _has_bits_[0] &= ~0x00000008u;
+}
+inline void InstallSnapshotRequest::clear_group_id() {
+  group_id_ = GOOGLE_ULONGLONG(0);
+  clear_has_group_id();
+}
+inline ::google::protobuf::uint64 InstallSnapshotRequest::group_id() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.InstallSnapshotRequest.group_id)
+  return group_id_;
+}
+inline void InstallSnapshotRequest::set_group_id(::google::protobuf::uint64 value) {
+  set_has_group_id();
+  group_id_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.InstallSnapshotRequest.group_id)
+}
+
+// -------------------------------------------------------------------
+
+// InstallSnapshotResponse
+
+// -------------------------------------------------------------------
+
+// ReadIndexRequest
+
+// optional uint64 group_id = 1;
+inline bool ReadIndexRequest::has_group_id() const {
+  return (_has_bits_[0] & 0x00000001u) != 0;
+}
+inline void ReadIndexRequest::set_has_group_id() {
+  _has_bits_[0] |= 0x00000001u;
+}
+inline void ReadIndexRequest::clear_has_group_id() {
+  _has_bits_[0] &= ~0x00000001u;
+}
+inline void ReadIndexRequest::clear_group_id() {
+  group_id_ = GOOGLE_ULONGLONG(0);
+  clear_has_group_id();
+}
+inline ::google::protobuf::uint64 ReadIndexRequest::group_id() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.ReadIndexRequest.group_id)
+  return group_id_;
+}
+inline void ReadIndexRequest::set_group_id(::google::protobuf::uint64 value) {
+  set_has_group_id();
+  group_id_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.ReadIndexRequest.group_id)
+}
+
+// -------------------------------------------------------------------
+
+// ReadIndexResponse
+
+// optional uint64 index = 1;
+inline bool ReadIndexResponse::has_index() const {
+  return (_has_bits_[0] & 0x00000001u) != 0;
+}
+inline void ReadIndexResponse::set_has_index() {
+  _has_bits_[0] |= 0x00000001u;
+}
+inline void ReadIndexResponse::clear_has_index() {
+  _has_bits_[0] &= ~0x00000001u;
+}
+inline void ReadIndexResponse::clear_index() {
+  index_ = GOOGLE_ULONGLONG(0);
+  clear_has_index();
+}
+inline ::google::protobuf::uint64 ReadIndexResponse::index() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.ReadIndexResponse.index)
+  return index_;
+}
+inline void ReadIndexResponse::set_index(::google::protobuf::uint64 value) {
+  set_has_index();
+  index_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.ReadIndexResponse.index)
+}
+
+// -------------------------------------------------------------------
+
+// MemoryUsage
+
+// optional string component = 1;
+inline bool MemoryUsage::has_component() const {
+  return (_has_bits_[0] & 0x00000001u) != 0;
+}
+inline void MemoryUsage::set_has_component() {
+  _has_bits_[0] |= 0x00000001u;
+}
+inline void MemoryUsage::clear_has_component() {
+  _has_bits_[0] &= ~0x00000001u;
+}
+inline void MemoryUsage::clear_component() {
+  if (component_ != &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    component_->clear();
+  }
+  clear_has_component();
+}
+inline const ::std::string& MemoryUsage::component() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.MemoryUsage.component)
+  return *component_;
+}
+inline void MemoryUsage::set_component(const ::std::string& value) {
+  set_has_component();
+  if (component_ == &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    component_ = new ::std::string;
+  }
+  component_->assign(value);
+  // @@protoc_insertion_point(field_set:consensus.pb.MemoryUsage.component)
+}
+inline void MemoryUsage::set_component(const char* value) {
+  set_has_component();
+  if (component_ == &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    component_ = new ::std::string;
+  }
+  component_->assign(value);
+  // @@protoc_insertion_point(field_set_char:consensus.pb.MemoryUsage.component)
+}
+inline void MemoryUsage::set_component(const char* value, size_t size) {
+  set_has_component();
+  if (component_ == &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    component_ = new ::std::string;
+  }
+  component_->assign(reinterpret_cast<const char*>(value), size);
+  // @@protoc_insertion_point(field_set_pointer:consensus.pb.MemoryUsage.component)
+}
+inline ::std::string* MemoryUsage::mutable_component() {
+  set_has_component();
+  if (component_ == &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    component_ = new ::std::string;
+  }
+  // @@protoc_insertion_point(field_mutable:consensus.pb.MemoryUsage.component)
+  return component_;
+}
+inline ::std::string* MemoryUsage::release_component() {
+  clear_has_component();
+  if (component_ == &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    return NULL;
+  } else {
+    ::std::string* temp = component_;
+    component_ = const_cast< ::std::string*>(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+    return temp;
+  }
+}
+inline void MemoryUsage::set_allocated_component(::std::string* component) {
+  if (component_ != &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    delete component_;
+  }
+  if (component) {
+    set_has_component();
+    component_ = component;
+  } else {
+    clear_has_component();
+    component_ = const_cast< ::std::string*>(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  }
+  // @@protoc_insertion_point(field_set_allocated:consensus.pb.MemoryUsage.component)
+}
+
+// optional uint64 bytes = 2;
+inline bool MemoryUsage::has_bytes() const {
+  return (_has_bits_[0] & 0x00000002u) != 0;
+}
+inline void MemoryUsage::set_has_bytes() {
+  _has_bits_[0] |= 0x00000002u;
+}
+inline void MemoryUsage::clear_has_bytes() {
+  _has_bits_[0] &= ~0x00000002u;
+}
+inline void MemoryUsage::clear_bytes() {
+  bytes_ = GOOGLE_ULONGLONG(0);
+  clear_has_bytes();
+}
+inline ::google::protobuf::uint64 MemoryUsage::bytes() const {
+  // @@protoc_insertion_point(field_get:consensus.pb.MemoryUsage.bytes)
+  return bytes_;
+}
+inline void MemoryUsage::set_bytes(::google::protobuf::uint64 value) {
+  set_has_bytes();
+  bytes_ = value;
+  // @@protoc_insertion_point(field_set:consensus.pb.MemoryUsage.bytes)
+}
+
 
 // @@protoc_insertion_point(namespace_scope)
 
@@ -16,18 +16,56 @@
 
 #include <consensus/pb/raft_server.pb.h>
 
+#include <functional>
+#include <map>
+#include <memory>
+
+#include <boost/thread/shared_mutex.hpp>
+
 namespace consensus {
 
 class RaftTaskExecutor;
+class ReplicatedLog;
+class SnapshotReceiver;
+
+namespace rpc {
+class HeartbeatCoalescer;
+}  // namespace rpc
 
+// RaftServiceImpl serves either a single raft group, whatever group_id the calls name,
+// or all the groups of a process at one url, routing each call by its group_id.
 class RaftServiceImpl : public pb::RaftService {
  public:
-  explicit RaftServiceImpl(RaftTaskExecutor *executor) : executor_(executor) {}
+  // The inbound HeartbeatBatch-es are fanned out by `coalescer` if it's not null,
+  // otherwise they're all stepped by `executor`.
+  // The InstallSnapshot calls are rejected if `receiver` is null.
+  explicit RaftServiceImpl(RaftTaskExecutor *executor,
+                           rpc::HeartbeatCoalescer *coalescer = nullptr,
+                           SnapshotReceiver *receiver = nullptr);
+
+  // Serves all the calls for `log`, including the ReadIndex-es of its followers.
+  explicit RaftServiceImpl(ReplicatedLog *log, rpc::HeartbeatCoalescer *coalescer = nullptr);
+
+  // Serves the groups added by AddGroup. A call of a group not served here fails with
+  // EREQUEST, the HeartbeatBatch-es are fanned out to the groups by their group_ids.
+  RaftServiceImpl();
 
-  ~RaftServiceImpl() = default;
+  ~RaftServiceImpl();
+
+  // Starts serving the calls of the group of `log`, see ReplicatedLogOptions::group_id.
+  // Thread-Safe
+  void AddGroup(ReplicatedLog *log);
+
+  // Stops serving the calls of the group, it's called before the log is destroyed.
+  // No call is routed to the group once it returns, those routed before may still be
+  // pending in its executor, which the log drains on destruction.
+  // Thread-Safe
+  void RemoveGroup(uint64_t groupId);
 
   // RaftService::Step handles each request by calling RawNode::Step. If the request message
   // is invalid, the RaftService will respond with an error code.
+  // Like all the methods here, it returns without waiting for the executor, `done` is run
+  // by the executor once the response is filled.
   // @param `request` may be mutated after Step.
   void Step(google::protobuf::RpcController *controller, const pb::StepRequest *request,
             pb::StepResponse *response, google::protobuf::Closure *done) override;
@@ -35,8 +73,58 @@ class RaftServiceImpl : public pb::RaftService {
   void Status(::google::protobuf::RpcController *controller, const pb::StatusRequest *request,
               pb::StatusResponse *response, ::google::protobuf::Closure *done) override;
 
+  // RaftService::StepBatch steps the messages in order within one task of the executor.
+  // A StepBatch carrying a brpc stream opens the replication stream of the peer, whose
+  // records are stepped like StepBatch-es, see rpc::AsyncRaftClient.
+  // @param `request` may be mutated after StepBatch.
+  void StepBatch(google::protobuf::RpcController *controller, const pb::StepBatchRequest *request,
+                 pb::StepBatchResponse *response, google::protobuf::Closure *done) override;
+
+  void HeartbeatBatch(google::protobuf::RpcController *controller,
+                      const pb::HeartbeatBatchRequest *request,
+                      pb::HeartbeatBatchResponse *response,
+                      google::protobuf::Closure *done) override;
+
+  // RaftService::InstallSnapshot takes a chunk of the leader's snapshot from the
+  // attachment, see SnapshotReceiver.
+  void InstallSnapshot(google::protobuf::RpcController *controller,
+                       const pb::InstallSnapshotRequest *request,
+                       pb::InstallSnapshotResponse *response,
+                       google::protobuf::Closure *done) override;
+
+  // RaftService::ReadIndex serves the read index to a follower, see
+  // ReplicatedLog::ReadIndex. It fails if this node is not the leader of the group
+  // in the request.
+  void ReadIndex(google::protobuf::RpcController *controller, const pb::ReadIndexRequest *request,
+                 pb::ReadIndexResponse *response, google::protobuf::Closure *done) override;
+
+ private:
+  struct Group {
+    // null unless the group is served for a ReplicatedLog.
+    ReplicatedLog *log;
+    RaftTaskExecutor *executor;
+    SnapshotReceiver *receiver;
+  };
+
+  // Runs `f` with the group `groupId`, under the lock that RemoveGroup waits for.
+  // Returns false if the group is not served here.
+  bool route(uint64_t groupId, const std::function<void(const Group &)> &f);
+
+  // Steps the messages of a batch in the group they name, `done` is run unless it
+  // returns false.
+  bool routeBatch(pb::StepBatchRequest *req, pb::StepBatchResponse *response,
+                  google::protobuf::Closure *done);
+
  private:
-  RaftTaskExecutor *executor_;
+  // set if a single group is served.
+  std::unique_ptr<Group> single_;
+  rpc::HeartbeatCoalescer *coalescer_{nullptr};
+
+  boost::shared_mutex mu_;
+  std::map<uint64_t, Group> groups_;
+
+  class StreamHandler;
+  std::unique_ptr<StreamHandler> streamHandler_;
 };
 
 }  // namespace consensus
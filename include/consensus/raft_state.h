@@ -0,0 +1,34 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+namespace consensus {
+
+// RaftState is a view of the raft node, which can be read from any thread without
+// going through the raft task queue. It may lag behind the node by the running task.
+struct RaftState {
+  // 0 if the leader is unknown.
+  uint64_t leader;
+  uint64_t term;
+  uint64_t lastIndex;
+
+  // the latest committed index that's been persisted, it's published separately
+  // from the others, after the Ready carrying it is flushed.
+  uint64_t commitIndex;
+};
+
+}  // namespace consensus
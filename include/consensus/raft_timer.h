@@ -14,23 +14,40 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 
+#include "consensus/base/background_worker.h"
+
 namespace consensus {
 
 // RaftTimer is the background timer that ticks for every 1ms.
-// In our implementation, it doesn't generate a task every 1ms, instead,
-// it request RaftTaskExecutor to run RawNode::Tick 100 times for every 100ms.
+// In our implementation, it doesn't generate a task every 1ms, instead, it requests
+// RaftTaskExecutor to run RawNode::Tick in batches, 100 ticks for every 100ms by default.
+//
+// The executors are kept in a hashed timing wheel, only the due ones are visited on each
+// turn. Their tick tasks are fired without waiting, and the tasks for the executors
+// sharing a TaskQueue are coalesced into one.
 
 class RaftTaskExecutor;
 class RaftTimer {
  public:
   RaftTimer();
 
+  // The timer thread is started with `affinity`.
+  explicit RaftTimer(const ThreadAffinity& affinity);
+
   ~RaftTimer();
 
+  // Ticks the executor every `intervalMs` milliseconds, with as many ticks as the
+  // milliseconds elapsed since its previous ticking.
+  // Thread-safe
+  void Register(RaftTaskExecutor* executor, uint32_t intervalMs = 100);
+
+  // Stops ticking the executor. No tick is submitted to it once this returns, so that
+  // it can be destroyed while the timer goes on with the others.
   // Thread-safe
-  void Register(RaftTaskExecutor* executor);
+  void Unregister(RaftTaskExecutor* executor);
 
  private:
   class Impl;
@@ -14,22 +14,58 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 
+#include "consensus/base/background_worker.h"
+
 namespace consensus {
 
+struct ReadyFlusherOptions {
+  // Number of the workers persisting the Ready-s.
+  // Default: 4
+  size_t workers;
+
+  // Upper bound (in microseconds) of how long a round waits for more Ready-s, so
+  // that they're committed to the wal together with fewer syncs. The round only
+  // waits while the Ready-s arrive faster than they're persisted, and the wait plus
+  // the persist latency stays within latency_slo_us. 0 delay disables the waiting.
+  // Default: 0, 2000
+  uint32_t max_batch_delay_us;
+  uint32_t latency_slo_us;
+
+  // Affinity of the flusher thread and the workers, e.g to keep them on the cores
+  // and the NUMA node of the wal device.
+  // Default: none
+  ThreadAffinity affinity;
+
+  ReadyFlusherOptions();
+};
+
 // ReadyFlusher is a single background thread for asynchronously flushing the Ready-s,
 // so that the FSM thread can be free from stalls every time when it generates a Ready.
-
+// The Ready-s are persisted by a fixed pool of workers, each log is pinned to one of
+// them so that its Ready-s are flushed in order, while different logs are flushed
+// in parallel.
+// The flusher sleeps until a log is notified by its RaftTaskExecutor to have a Ready,
+// rather than polling every log all the time.
 class ReplicatedLogImpl;
 class ReadyFlusher {
  public:
-  ReadyFlusher();
+  explicit ReadyFlusher(size_t workers = 4);
+
+  explicit ReadyFlusher(const ReadyFlusherOptions& options);
 
   ~ReadyFlusher();
 
   void Register(ReplicatedLogImpl* log);
 
+  // Stops flushing the log, after its Ready being persisted, if any, is advanced. The
+  // log is not touched by the flusher once this returns, the later Ready-s it notifies
+  // are ignored.
+  void Unregister(ReplicatedLogImpl* log);
+
  private:
   class Impl;
   std::unique_ptr<Impl> impl_;
@@ -16,44 +16,173 @@
 
 #include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "consensus/base/buffer.h"
+#include "consensus/base/executor_pool.h"
 #include "consensus/base/simple_channel.h"
 #include "consensus/base/slice.h"
 #include "consensus/base/status.h"
 #include "consensus/base/task_queue.h"
+#include "consensus/raft_state.h"
 #include "consensus/raft_timer.h"
 #include "consensus/ready_flusher.h"
+#include "consensus/rpc/cluster.h"
+#include "consensus/rpc/heartbeat_coalescer.h"
+#include "consensus/snapshot.h"
+#include "consensus/state_machine.h"
 #include "consensus/wal/wal.h"
 
 #include <silly/disallow_copying.h>
 
 namespace consensus {
 
+class SnapshotReceiver;
+
+// Called once the write is committed or failed, index is the last index of the write
+// if it's committed.
+typedef std::function<void(const Status& s, uint64_t index)> WriteCallback;
+
 struct ReplicatedLogOptions {
   // id -> IP
   std::map<uint64_t, std::string> initial_cluster;
 
   uint64_t id;
 
+  // id -> IP of the learners, which receive and apply the log like the followers, but
+  // neither vote nor count toward the quorum, so that they add read capacity, e.g for
+  // the stale reads or the ReadIndex-es forwarded to the leader, without slowing down
+  // the commits. The leader sends them at most learner_max_bytes of entries per message.
+  // A node whose id is among the learners runs as one, it never campaigns.
+  // The voters and the learners must be given the same learners.
+  // Default: empty, 1MB
+  std::map<uint64_t, std::string> learners;
+  uint64_t learner_max_bytes;
+
+  // identifies the raft group among those sharing a heartbeat_coalescer, or a
+  // RaftServiceImpl, see RaftServiceImpl::AddGroup. The messages sent name it.
+  // Default: 0
+  uint64_t group_id;
+
+  // If not null, the heartbeats of this group are merged with those of the other
+  // groups on this node, see rpc::HeartbeatCoalescer.
+  rpc::HeartbeatCoalescer* heartbeat_coalescer;
+
+  // If not null, the messages are passed to the peers through it instead of the RPCs
+  // to initial_cluster, e.g rpc::MemTransport within a process. It's owned by the log.
+  // Default: nullptr
+  rpc::Cluster* cluster;
+
   // time (in milliseconds) of a heartbeat interval.
   uint32_t heartbeat_interval;
 
   // time (in milliseconds) for an election to timeout.
   uint32_t election_timeout;
 
+  // time (in milliseconds) for an idle node to stop ticking, until the next proposal or
+  // inbound message other than heartbeats. 0 disables the quiescence.
+  // Default: 0
+  uint32_t quiesce_timeout;
+
   // dedicated worker of the raft node.
-  // there may have multiple instances sharing the same queue.
-  TaskQueue* taskQueue;
+  // there may have multiple instances sharing the same queue, and its ownership.
+  std::shared_ptr<TaskQueue> taskQueue;
+
+  // If taskQueue is null, the node runs on a strand of this pool instead of a
+  // dedicated thread, so that many nodes can share a few threads.
+  ExecutorPool* executor_pool;
 
-  // the global timer
+  // the global timer, which may be shared by many logs, it's not owned by the log.
+  // If null, the log creates its own.
   RaftTimer* timer;
 
-  // the global ready flusher
+  // the global ready flusher, shared and owned like the timer.
   ReadyFlusher* flusher;
 
+  // where the WriteCallback-s are run, so that they will not block the flusher.
+  // If null, they're run in the thread observing the commit.
+  TaskQueue* completion_executor;
+
   wal::WriteAheadLog* wal;
   yaraft::MemoryStorage* memstore;
 
+  // Limits of the entries kept in memstore, the older entries are evicted once
+  // they are committed and readable from the wal, and read back from the wal
+  // on demand. 0 means no limit. The memstore is unbounded if both are 0.
+  // Default: 0
+  size_t memstore_max_entries;
+  size_t memstore_max_bytes;
+
+  // Limits of the automatic batching of concurrent Write-s. A batch is proposed once
+  // it has been waiting for write_batch_delay_us, or it has grown to write_batch_max_bytes.
+  // 0 delay disables the batching.
+  // Default: 0, 0
+  uint32_t write_batch_delay_us;
+  size_t write_batch_max_bytes;
+
+  // Limits of the proposals that are written but not yet committed. A write beyond
+  // them waits up to admission_timeout_ms for the inflight ones to commit, then fails
+  // with Busy. 0 means no limit, or failing right away for the timeout.
+  // A write is beyond the limits as well while the process exceeds the soft limit of
+  // the MemoryTracker, it fails right away if there's no limit.
+  // Default: 0, 0, 0
+  size_t max_inflight_proposals;
+  size_t max_inflight_proposal_bytes;
+  uint32_t admission_timeout_ms;
+
+  // If true, the leader serves ReadIndex locally while a quorum has responded to its
+  // heartbeats sent within election_timeout minus lease_clock_drift (in milliseconds),
+  // in which no other leader can be elected: the nodes drop the votes for the election
+  // timeout since they last heard from the leader. It relies on the clocks drifting no
+  // more than lease_clock_drift, and on the followers' election_timeout exceeding the
+  // leader's lease by at least that. A leadership transfer then completes only if the
+  // old leader's vote is enough for the target to win, e.g in a group of 3.
+  // Default: false, 500
+  bool lease_read;
+  uint32_t lease_clock_drift;
+
+  // If not null, the committed entries are applied to it in a dedicated thread of this
+  // log, and the writes complete once they're applied rather than committed.
+  // The entries up to applied_index were applied before the restart, they're skipped.
+  // Default: nullptr, 0
+  StateMachine* state_machine;
+  uint64_t applied_index;
+
+  // Affinity of the apply thread, e.g. to keep it on the core of the raft thread.
+  // Default: none
+  ThreadAffinity apply_affinity;
+
+  // If not null, the followers lagging behind the compacted log catch up by installing
+  // the snapshots taken by the application, which are sent in chunks of
+  // snapshot_chunk_size, at no more than snapshot_bytes_per_sec unless it's 0.
+  // Default: nullptr, 1MB, 0
+  Snapshotter* snapshotter;
+  size_t snapshot_chunk_size;
+  uint64_t snapshot_bytes_per_sec;
+
+  // The entry payloads replicated to the peers in another zone than this node, e.g. a
+  // remote availability zone, are compressed with replication_compression once they're
+  // at least replication_compress_min_bytes in a request. The peers missing from
+  // peer_zones are in the same zone as this node. See the consensus_replication_compress*
+  // bvars for the cost and the savings.
+  // Default: empty, empty, NO_COMPRESSION, 4096
+  std::string zone;
+  std::map<uint64_t, std::string> peer_zones;
+  wal::WriteAheadLogOptions::CompressionType replication_compression;
+  size_t replication_compress_min_bytes;
+
+  // If not 0, one in every trace_sample_every proposals is traced through the write path,
+  // see ReplicatedLog::DumpProposalTraces.
+  // Default: 0
+  uint32_t trace_sample_every;
+
+  // If not 0, a leader being destroyed hands its leadership over first, and waits up
+  // to shutdown_handoff_timeout_ms (in milliseconds) for the successor to be elected,
+  // see ReplicatedLog::HandOffLeadership.
+  // Default: 0
+  uint32_t shutdown_handoff_timeout_ms;
+
   ReplicatedLogOptions();
 
   Status Validate() const;
@@ -71,17 +200,107 @@ class ReplicatedLog {
   static StatusWith<ReplicatedLog*> New(const ReplicatedLogOptions&);
 
   // Write a slice of log in synchronous way.
-  // Returns error `WalWriteToNonLeader` if the current node is not leader.
+  // Returns error `WalWriteToNonLeader` if the current node is not leader, or `Busy` if
+  // too many writes are inflight, see ReplicatedLogOptions::max_inflight_proposals.
   Status Write(const Slice& log);
 
   // Asynchronously write a slice of log into storage, the call will returns immediately
   // with a SimpleChannel that's used to wait for the commit of this write.
   SimpleChannel<Status> AsyncWrite(const Slice& log);
 
+  // Asynchronously write the slices as consecutive entries in one proposal. The channel
+  // is notified once all of them are committed.
+  SimpleChannel<Status> AsyncWriteBatch(const std::vector<Slice>& logs);
+
+  // Same as above, except that the callback is called on completion instead, no thread
+  // has to wait for it. The log must be kept alive until the callback is called.
+  void AsyncWrite(const Slice& log, WriteCallback callback);
+
+  void AsyncWriteBatch(const std::vector<Slice>& logs, WriteCallback callback);
+
+  // Same as Write and AsyncWrite, except that the buffer of `log` is moved into the
+  // proposed entry instead of being copied. WriteOwned bypasses the batching of
+  // concurrent Write-s, see ReplicatedLogOptions::write_batch_delay_us.
+  Status WriteOwned(std::string&& log);
+
+  void AsyncWriteOwned(std::string&& log, WriteCallback callback);
+
+  // Writes the content of `log` as one entry. A Buffer of one unshared block is moved
+  // into the entry, otherwise its blocks are gathered into the entry once.
+  void AsyncWrite(Buffer&& log, WriteCallback callback);
+
+  // Returns the read index once the leadership of this node is confirmed by a quorum,
+  // and the entries up to the index are applied, or committed if there's no state
+  // machine. A read of the state machine is linearizable then.
+  // The concurrent calls share one round trip to the quorum, which is saved while the
+  // leader holds the lease, see ReplicatedLogOptions::lease_read.
+  // A follower fetches the read index from the leader instead, through the
+  // RaftService::ReadIndex of the leader, and waits to apply up to there.
+  // Returns error `WalWriteToNonLeader` if there's no leader.
+  Status ReadIndex(uint64_t* index);
+
+  // Same as above, except that the callback is called with the read index instead.
+  void AsyncReadIndex(WriteCallback callback);
+
+  // Hands the leadership of this node over to the peer `target` through raft's
+  // MsgTransferLeader: the target is brought up to date, then told to campaign at once.
+  // It returns once the transfer has started, the new leader is seen by GetRaftState.
+  // Writes may fail while the transfer is in progress. If the target isn't elected
+  // within an election timeout, the transfer is abandoned. The leader stops serving
+  // ReadIndex under its lease for that long, and confirms it with a quorum instead.
+  // Returns error `WalWriteToNonLeader` if the current node is not leader, or
+  // `InvalidArgument` if `target` is not in the group.
+  Status TransferLeadership(uint64_t target);
+
+  // Drops the entries up to `index` from the wal and the memstore, once the application
+  // has persisted their effects, e.g. in a checkpoint it restarts from, see
+  // ReplicatedLogOptions::applied_index. The entries not applied yet are kept.
+  // A follower lagging behind the dropped entries can only catch up by a snapshot, see
+  // ReplicatedLogOptions::snapshotter.
+  Status Compact(uint64_t index);
+
+  // Same as above, except that `done` is called once the log is compacted, in the raft
+  // thread.
+  void AsyncCompact(uint64_t index, std::function<void(const Status&)> done);
+
+  // Ids of the nodes in the group, including this one, excluding the learners.
+  const std::vector<uint64_t>& Peers() const;
+
+  // Whether this node is a learner, see ReplicatedLogOptions::learners.
+  bool IsLearner() const;
+
+  // Transfers the leadership to the follower that has acknowledged the most entries,
+  // and waits up to `timeoutMs` until another node is seen as the leader, so that
+  // a planned shutdown doesn't leave the group leaderless for an election timeout.
+  // Returns OK at once if this node is not the leader, or has no follower.
+  // Returns error `IllegalState` if the leadership isn't handed over in time, the
+  // transfer may still be in progress then, and the lease reads stay off until it's
+  // over, see TransferLeadership.
+  Status HandOffLeadership(uint32_t timeoutMs);
+
   RaftTaskExecutor* RaftTaskExecutorInstance() const;
 
+  // Reads the leader, term and indexes of the node without waiting for the raft thread.
+  RaftState GetRaftState() const;
+
+  // Index of the last entry applied to the state machine, 0 if there's none.
+  uint64_t AppliedIndex() const;
+
+  // Null if ReplicatedLogOptions::snapshotter is not set.
+  SnapshotReceiver* SnapshotReceiverInstance() const;
+
+  // Dumps the latest committed proposals sampled by ReplicatedLogOptions::trace_sample_every,
+  // as the latency of each stage of the write path, from the submission to the raft thread,
+  // through the proposal, the replication and the wal, to the commit. If `chromeTrace` is
+  // true, they're dumped in the Chrome trace-event JSON instead.
+  // Empty if the tracing is disabled.
+  std::string DumpProposalTraces(bool chromeTrace = false) const;
+
   uint64_t Id() const;
 
+  // see ReplicatedLogOptions::group_id.
+  uint64_t GroupId() const;
+
   ~ReplicatedLog();
 
  private:
@@ -0,0 +1,110 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+// Requires C++20, unlike the rest of the library, which is built as C++11. Nothing in
+// the library includes this header.
+#if !defined(__cpp_impl_coroutine)
+#error "replicated_log_awaitable.h requires the C++20 coroutines"
+#endif
+
+#include <coroutine>
+#include <utility>
+
+#include "consensus/base/task.h"
+#include "consensus/base/task_queue.h"
+#include "consensus/replicated_log.h"
+
+namespace consensus {
+
+// Resumes the awaiting coroutine in the thread running the WriteCallback-s of the
+// log, see ReplicatedLogOptions::completion_executor. The coroutine must not block
+// there.
+struct InlineResume {
+  void operator()(Task task) const {
+    task();
+  }
+};
+
+// Resumes the awaiting coroutine in `queue`, e.g. a strand of an ExecutorPool.
+struct TaskQueueResume {
+  TaskQueue* queue;
+
+  void operator()(Task task) const {
+    queue->Enqueue(std::move(task));
+  }
+};
+
+// WriteAwaitable is the awaitable of AsyncWrite below. The result is delivered
+// through the awaitable itself, which lives in the frame of the coroutine, so a write
+// costs no allocation beyond those of ReplicatedLog::AsyncWrite.
+//
+// `Executor` is a callable taking a Task, which it runs to resume the coroutine, e.g.
+// by starting a bthread.
+template <typename Executor>
+class WriteAwaitable {
+ public:
+  WriteAwaitable(ReplicatedLog* log, const Slice& data, Executor executor)
+      : log_(log), data_(data), executor_(std::move(executor)) {}
+
+  bool await_ready() const noexcept {
+    return false;
+  }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    log_->AsyncWrite(data_, [this](const Status& s, uint64_t index) {
+      status_ = s;
+      index_ = index;
+      // the coroutine may finish and free the awaitable once it's resumed, even before
+      // the executor returns, `this` is not touched afterwards.
+      std::coroutine_handle<> handle = handle_;
+      Executor executor = executor_;
+      executor([handle]() { handle.resume(); });
+    });
+  }
+
+  // The index of the entry on success.
+  StatusWith<uint64_t> await_resume() {
+    if (!status_.IsOK()) {
+      return status_;
+    }
+    return index_;
+  }
+
+ private:
+  ReplicatedLog* log_;
+  Slice data_;
+  Executor executor_;
+
+  std::coroutine_handle<> handle_;
+  Status status_;
+  uint64_t index_{0};
+};
+
+// Writes `data` like ReplicatedLog::AsyncWrite, the coroutine is suspended until the
+// write is committed or fails, and then resumed by `executor`. `data` must stay valid
+// until then.
+//
+//    StatusWith<uint64_t> sw = co_await AsyncWrite(log, "abc", TaskQueueResume{strand});
+//
+template <typename Executor = InlineResume>
+WriteAwaitable<Executor> AsyncWrite(ReplicatedLog* log, const Slice& data,
+                                    Executor executor = Executor()) {
+  return WriteAwaitable<Executor>(log, data, std::move(executor));
+}
+
+}  // namespace consensus
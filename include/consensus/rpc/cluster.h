@@ -14,22 +14,60 @@
 
 #pragma once
 
+#include <functional>
+#include <map>
+#include <set>
 #include <vector>
 
 #include "consensus/base/status.h"
+#include "consensus/wal/wal.h"
 
 #include <yaraft/pb/raftpb.pb.h>
 
 namespace consensus {
+
+class Snapshotter;
+
 namespace rpc {
 
+class HeartbeatCoalescer;
+
+typedef std::function<void(const Status& s, uint64_t index)> ReadIndexCallback;
+
 class Cluster {
  public:
   virtual ~Cluster() = default;
 
   virtual Status Pass(std::vector<yaraft::pb::Message>& mails) = 0;
 
-  static Cluster* Default(const std::map<uint64_t, std::string>& initialCluster);
+  // The reporter is called with the id of a peer whose messages were dropped or failed to
+  // deliver, so that raft could probe it rather than keep sending appends.
+  // It may be called in any thread.
+  typedef std::function<void(uint64_t peerId)> UnreachableReporter;
+  virtual void SetUnreachableReporter(UnreachableReporter reporter) {}
+
+  // Once enabled, the MsgSnap-s are sent in chunks of the snapshots read from
+  // `snapshotter`, see SnapshotSender. The reporter is called with the outcome of each
+  // transfer, in any thread.
+  typedef std::function<void(uint64_t peerId, bool failed)> SnapshotReporter;
+  virtual void EnableSnapshots(Snapshotter* snapshotter, size_t chunkSize, uint64_t bytesPerSec,
+                               SnapshotReporter reporter) {}
+
+  // The entry payloads of at least `minBytes` in a request to one of `peers` are
+  // compressed with `type`, see ReplicatedLogOptions::zone.
+  virtual void EnableCompression(const std::set<uint64_t>& peers,
+                                 wal::WriteAheadLogOptions::CompressionType type,
+                                 size_t minBytes) {}
+
+  // Fetches the read index from the leader for a read on this follower, see
+  // ReplicatedLog::ReadIndex. `done` is called in any thread.
+  virtual void AsyncReadIndex(uint64_t leaderId, ReadIndexCallback done) {
+    done(Status::Make(Error::NotSupported, "follower read"), 0);
+  }
+
+  // The heartbeats are sent through `coalescer` if it's not null.
+  static Cluster* Default(const std::map<uint64_t, std::string>& initialCluster,
+                          uint64_t groupId = 0, HeartbeatCoalescer* coalescer = nullptr);
 };
 
 }  // namespace rpc
@@ -0,0 +1,68 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <yaraft/pb/raftpb.pb.h>
+
+namespace consensus {
+
+namespace pb {
+class HeartbeatBatchRequest;
+}  // namespace pb
+
+namespace rpc {
+
+// HeartbeatCoalescer is shared by the raft groups of a node. The heartbeats and the
+// heartbeat responses they send to the same remote node are merged into one
+// HeartbeatBatch request per tick, and the inbound ones are fanned out to the local
+// groups. With many groups on a node this saves thousands of tiny requests per second.
+//
+// Thread-Safe
+class HeartbeatCoalescer {
+ public:
+  // Delivers the messages to a local group, it's called in a brpc thread.
+  typedef std::function<void(std::vector<yaraft::pb::Message>& msgs)> GroupInbox;
+
+  explicit HeartbeatCoalescer(uint32_t intervalMs = 50);
+
+  ~HeartbeatCoalescer();
+
+  // Queues `msg` of group `groupId` to the node at `url`, it's sent on the next tick.
+  void Add(const std::string& url, uint64_t groupId, yaraft::pb::Message* msg);
+
+  void RegisterGroup(uint64_t groupId, GroupInbox inbox);
+
+  void UnregisterGroup(uint64_t groupId);
+
+  // Fans out an inbound HeartbeatBatch to the registered groups. The messages of
+  // unknown groups are dropped.
+  void Deliver(pb::HeartbeatBatchRequest* request);
+
+  static bool IsHeartbeat(const yaraft::pb::Message& msg) {
+    return msg.type() == yaraft::pb::MsgHeartbeat || msg.type() == yaraft::pb::MsgHeartbeatResp;
+  }
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace rpc
+}  // namespace consensus
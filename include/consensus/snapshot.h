@@ -0,0 +1,66 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "consensus/base/slice.h"
+#include "consensus/base/status.h"
+
+namespace consensus {
+
+// SnapshotReader streams a snapshot of the application state out in chunks.
+class SnapshotReader {
+ public:
+  virtual ~SnapshotReader() = default;
+
+  // Reads the next chunk of at most `maxBytes` into `chunk`. `eof` is set once the
+  // chunk is the last one, which may be empty.
+  virtual Status Read(size_t maxBytes, std::string* chunk, bool* eof) = 0;
+};
+
+// SnapshotWriter takes the chunks of a snapshot in order. Nothing is visible to the
+// application until Finish succeeds.
+class SnapshotWriter {
+ public:
+  virtual ~SnapshotWriter() = default;
+
+  virtual Status Write(const Slice& chunk) = 0;
+
+  // Replaces the application state with the written snapshot.
+  virtual Status Finish() = 0;
+
+  // Discards the written chunks, the writer is not used anymore.
+  virtual void Abort() = 0;
+};
+
+// Snapshotter is implemented by the application to produce and install the snapshots
+// shipped to the followers that have fallen behind the compacted log.
+// The methods may be called in any thread.
+class Snapshotter {
+ public:
+  virtual ~Snapshotter() = default;
+
+  // Opens the snapshot of the application state covering the entries up to at
+  // least `index`.
+  virtual Status OpenSnapshot(uint64_t index, std::unique_ptr<SnapshotReader>* reader) = 0;
+
+  // Begins to install the snapshot of the leader, which covers the entries up to `index`.
+  virtual Status BeginInstall(uint64_t index, uint64_t term,
+                              std::unique_ptr<SnapshotWriter>* writer) = 0;
+};
+
+}  // namespace consensus
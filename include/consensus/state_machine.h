@@ -0,0 +1,38 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <vector>
+
+#include "consensus/base/status.h"
+
+#include <yaraft/pb/raftpb.pb.h>
+
+namespace consensus {
+
+// StateMachine is implemented by the application to apply the committed entries, on
+// the leader and the followers alike.
+class StateMachine {
+ public:
+  virtual ~StateMachine() = default;
+
+  // Applies a batch of consecutive committed entries, in the order of their indexes.
+  // The batch may include the empty entries appended by new leaders, which are to be
+  // skipped. It's called in the apply thread of the log, one batch at a time.
+  // An error is fatal, since the entries can't be skipped.
+  virtual Status Apply(const std::vector<yaraft::pb::Entry>& entries) = 0;
+};
+
+}  // namespace consensus
@@ -14,12 +14,19 @@
 
 #pragma once
 
+#include <functional>
+#include <string>
+#include <vector>
+
 #include "consensus/base/status.h"
 
 #include <yaraft/memory_storage.h>
 #include <yaraft/pb/raftpb.pb.h>
 
 namespace consensus {
+
+class Env;
+
 namespace wal {
 
 using PBEntryVec = std::vector<yaraft::pb::Entry>;
@@ -28,6 +35,22 @@ using ConstPBEntriesIterator = PBEntryVec::const_iterator;
 
 class WriteAheadLogOptions {
  public:
+  // Governs when the written data is synced to disk.
+  enum SyncPolicy {
+    // Sync after every write, so that a write is durable once it returns.
+    SYNC_EVERY_WRITE,
+
+    // Sync on write if sync_interval_ms has passed since the last sync.
+    SYNC_INTERVAL,
+
+    // Sync on write if sync_bytes have been written since the last sync.
+    SYNC_BYTES,
+
+    // Never sync except when a segment is finished, relying on the OS to
+    // write back the dirty pages.
+    SYNC_NONE,
+  };
+
   // Approximate size of wal packed per segment.
   // Default: 64MB
   size_t log_segment_size;
@@ -36,14 +59,126 @@ class WriteAheadLogOptions {
   // Default: true
   bool verify_checksum;
 
+  // Whether concurrent writes should be coalesced into groups, each of which
+  // shares a single sync, if one is required by sync_policy. Writes that arrive
+  // while a group is being committed are queued up for the next one.
+  // Default: false
+  bool group_commit;
+
+  // Default: SYNC_EVERY_WRITE
+  SyncPolicy sync_policy;
+
+  // Only used with SYNC_INTERVAL.
+  // Default: 10
+  size_t sync_interval_ms;
+
+  // Only used with SYNC_BYTES.
+  // Default: 1MB
+  size_t sync_bytes;
+
+  // Start writing back the dirty pages asynchronously (sync_file_range) every
+  // time this many bytes are written without a sync, which bounds the amount
+  // of data left for the next sync. 0 disables it.
+  // Default: 1MB
+  size_t bytes_per_flush;
+
+  // Whether to sync in a dedicated thread, so that writes return once the
+  // data is appended, and AsyncWrite callbacks run once the data is synced.
+  // Write still waits for its data to be synced. The background thread syncs
+  // whenever there are pending writes, hence sync_policy is ignored.
+  // Default: false
+  bool background_sync;
+
+  // Number of pre-created, zero-filled segments kept ready to be renamed into
+  // place at rollover. Writing into a fully allocated file leaves the file
+  // metadata unchanged, so that a sync only has to flush data.
+  // Default: 0
+  size_t log_segment_pool_size;
+
+  // Whether to roll over segments in background. A spare segment is created ahead
+  // of time, so that the write rolling over only renames it into place, while the
+  // full segment is sealed (footer, sync, close and manifest) in a background thread.
+  // Sync waits for the segments being sealed, so the durability is unchanged.
+  // Default: false
+  bool background_rollover;
+
+  // Whether to write segments with direct I/O, which bypasses the page cache,
+  // so that the WAL traffic doesn't evict the data cached by the application.
+  // Default: false
+  bool use_direct_io;
+
+  enum CompressionType {
+    NO_COMPRESSION,
+
+    // zlib in its fastest level
+    ZLIB_COMPRESSION,
+  };
+
+  // Compress every batch of at least compression_min_batch_size bytes, unless
+  // it doesn't get smaller. The compressed batches are decompressed transparently
+  // on read, regardless of this option.
+  // Default: NO_COMPRESSION
+  CompressionType compression;
+
+  // Default: 4096
+  size_t compression_min_batch_size;
+
+  // Whether a write overwriting the conflicting entries in the live segment cuts the
+  // segment back to the first batch holding nothing but conflicting entries, and is
+  // written in place there, rather than appended after the overwritten entries. Only
+  // the recent batches can be cut, and never the hard states that changed the term
+  // or vote, otherwise the write falls back to appending. Ignored with use_direct_io.
+  // Default: false
+  bool rewrite_tail_on_conflict;
+
+  // Number of threads reading and decoding segments concurrently during recovery.
+  // Default: 4
+  size_t recovery_threads;
+
+  // If not 0, the recovery only loads into the memstore the newest segments holding
+  // at least this many entries, together with the latest hard state, so that the time
+  // to serve after a restart is set by the tail of the log rather than its total size.
+  // The older entries are left in the sealed segments, to be read back on demand by
+  // ReadEntries, see LazilyRecovered. It takes effect only if the segments are listed
+  // in the manifest, otherwise the whole log is loaded.
+  // Default: 0
+  size_t lazy_recovery_entries;
+
+  // Capacity in bytes of the cache for the blocks of entries decoded by
+  // ReadEntries, which is shared by all segments. 0 disables the cache.
+  // Default: 8MB
+  size_t block_cache_size;
+
+  // Number of sealed segments whose files are kept open for ReadEntries, the least
+  // recently read one is closed first once exceeded.
+  // Default: 64
+  size_t max_open_segments;
+
+  // The environment through which the log files are accessed, e.g Env::IoUring().
+  // Default: Env::Default()
+  Env* env;
+
   std::string log_dir;
 
+  // Directories on other devices, across which the log is striped together with
+  // log_dir, so that the writes and syncs are spread over the devices.
+  // WriteAheadLog places its segments in the directories round-robin and keeps its
+  // metadata in log_dir, the segments are found in any of the directories on
+  // recovery. SharedWriteAheadLog runs an independent stream of segments, with its
+  // own sync, in each directory, where group i is placed in the (i % n)th of log_dir
+  // followed by these, so the list can't be changed once groups are written.
+  // Default: empty
+  std::vector<std::string> extra_log_dirs;
+
   WriteAheadLogOptions();
 };
 
 class WriteAheadLog;
 using WriteAheadLogUPtr = std::unique_ptr<WriteAheadLog>;
 
+class SharedWriteAheadLog;
+using SharedWriteAheadLogUPtr = std::unique_ptr<SharedWriteAheadLog>;
+
 // WriteAheadLog provides an abstraction for writing log entries and raft state
 // into the underlying storage.
 class WriteAheadLog {
@@ -63,20 +198,104 @@ class WriteAheadLog {
     return Write(PBEntryVec(), hs);
   }
 
+  using WriteCallback = std::function<void(const Status&)>;
+
+  // Save log entries and raft state without waiting for them to be durable.
+  // `callback` will be invoked, possibly from another thread, once they are
+  // synced to disk, or with the error if the sync failed. If appending fails,
+  // the error is returned and `callback` is never invoked.
+  //
+  // The default implementation calls Write and then `callback`.
+  virtual Status AsyncWrite(const PBEntryVec& vec, const yaraft::pb::HardState* hs,
+                            WriteCallback callback) {
+    RETURN_NOT_OK(Write(vec, hs));
+    callback(Status::OK());
+    return Status::OK();
+  }
+
+  // Read back the entries in [lo, hi) into `entries`, whose total size is limited
+  // to maxBytes, except that the first entry is always read. Fewer entries are
+  // returned if the rest are not readable from the log.
+  // Returns LogCompacted if `lo` has been compacted, or NotFound if `lo` is not
+  // readable from the log, e.g it's not persisted yet, in which case it should be
+  // read from the memstore.
+  //
+  // The default implementation returns NotSupported.
+  virtual Status ReadEntries(uint64_t lo, uint64_t hi, uint64_t maxBytes, PBEntryVec* entries) {
+    return Status::Make(Error::NotSupported);
+  }
+
+  // Returns true if the recovery left the oldest entries in the log instead of loading
+  // them into the memstore, see WriteAheadLogOptions::lazy_recovery_entries. Then the
+  // log starts after `compactIndex` at `compactTerm`, rather than at the first entry of
+  // the memstore, and the entries in between are to be read by ReadEntries, e.g
+  // through BoundedMemoryStorage, which ReplicatedLog sets up in this case.
+  //
+  // The default implementation returns false.
+  virtual bool LazilyRecovered(uint64_t* compactIndex, uint64_t* compactTerm) const {
+    return false;
+  }
+
+  // Sync the written data to disk, regardless of the sync policy.
   virtual Status Sync() = 0;
 
   virtual Status Close() = 0;
 
-  struct CompactionHint {};
+  struct CompactionHint {
+    // Entries up to and including this index are safe to drop, typically
+    // because they have been applied and covered by a snapshot.
+    uint64_t compactIndex;
 
-  // Abandon the unused logs.
+    // If not null, the entries up to compactIndex are compacted from it as well.
+    yaraft::MemoryStorage* memstore;
+
+    CompactionHint() : compactIndex(0), memstore(nullptr) {}
+  };
+
+  // Abandon the logs that are no longer needed according to `hint`.
   virtual Status GC(CompactionHint* hint) = 0;
 
+  // Returns the engine this log shares with other logs, or null if it's not shared.
+  virtual SharedWriteAheadLog* Engine() {
+    return nullptr;
+  }
+
   // Default implementation of WAL.
   static Status Default(const WriteAheadLogOptions& options, WriteAheadLogUPtr* wal,
                         yaraft::MemStoreUptr* memstore);
 };
 
+// SharedWriteAheadLog is a log engine shared by many raft groups in a process. The
+// records of all groups are interleaved into a single stream of segments, tagged
+// with their group ids, so that the writes of many groups share a single sync.
+//
+// Each group has its own index and compaction point, a segment is deleted once
+// every group in it has compacted the entries it holds.
+//
+// Only log_dir, extra_log_dirs, env, log_segment_size, verify_checksum and sync_policy,
+// which is either SYNC_NONE or syncing every commit, are used among WriteAheadLogOptions.
+class SharedWriteAheadLog {
+ public:
+  virtual ~SharedWriteAheadLog() = default;
+
+  // Open the engine in options.log_dir, recovering the logs of all groups.
+  static Status Open(const WriteAheadLogOptions& options, SharedWriteAheadLogUPtr* engine);
+
+  // Returns the log of group `groupId`, which is owned by the engine. The entries
+  // and hard state recovered for the group are returned in `memstore` when the
+  // group is opened for the first time, which is empty for a new group.
+  virtual Status OpenGroup(uint64_t groupId, WriteAheadLog** wal,
+                           yaraft::MemStoreUptr* memstore) = 0;
+
+  // The writes to any group are held from Hold until the matching Release, and are
+  // then committed together with a single sync. Holds can be nested.
+  virtual void Hold() = 0;
+
+  virtual void Release() = 0;
+
+  virtual Status Close() = 0;
+};
+
 extern WriteAheadLogUPtr TEST_CreateWalStore(const std::string& testDir, yaraft::MemStoreUptr* pMemstore);
 
 inline WriteAheadLogUPtr TEST_CreateWalStore(const std::string& testDir) {
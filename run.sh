@@ -50,11 +50,15 @@ function unit_test()
 function run_test() {
     unit_test env_test
     unit_test coding_test
+    unit_test crc32c_test
     unit_test background_worker_test
     unit_test random_test
 
     unit_test log_writer_test
     unit_test log_manager_test
+    unit_test block_cache_test
+    unit_test bounded_memory_storage_test
+    unit_test shared_wal_test
 
     unit_test raft_service_test
     unit_test raft_timer_test
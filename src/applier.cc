@@ -0,0 +1,82 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "applier.h"
+#include "base/logging.h"
+#include "base/memory_tracker.h"
+
+namespace consensus {
+
+Applier::Applier(StateMachine* stateMachine, uint64_t appliedIndex,
+                 const ThreadAffinity& affinity)
+    : stateMachine_(stateMachine), applied_(appliedIndex), queue_(affinity) {}
+
+void Applier::Submit(std::vector<yaraft::pb::Entry>&& entries) {
+  if (entries.empty()) {
+    return;
+  }
+  int64_t bytes = 0;
+  for (const auto& e : entries) {
+    bytes += e.ByteSize();
+  }
+  MemoryTracker::Instance().Consume(MemoryTracker::kUnappliedEntries, bytes);
+
+  auto batch = std::make_shared<std::vector<yaraft::pb::Entry>>();
+  batch->swap(entries);
+  queue_.Enqueue([this, batch, bytes]() {
+    apply(batch.get());
+    MemoryTracker::Instance().Release(MemoryTracker::kUnappliedEntries, bytes);
+  });
+}
+
+void Applier::apply(std::vector<yaraft::pb::Entry>* batch) {
+  // the entries applied before the restart are committed again.
+  uint64_t applied = applied_.load(std::memory_order_relaxed);
+  if (batch->back().index() <= applied) {
+    return;
+  }
+  if (batch->front().index() <= applied) {
+    batch->erase(batch->begin(), batch->begin() + (applied + 1 - batch->front().index()));
+  }
+  const std::vector<yaraft::pb::Entry>& entries = *batch;
+
+  FATAL_NOT_OK(stateMachine_->Apply(entries), "StateMachine::Apply");
+
+  std::vector<std::function<void()>> callbacks;
+  {
+    std::lock_guard<std::mutex> g(mu_);
+    applied_.store(entries.back().index(), std::memory_order_release);
+    auto end = waiters_.upper_bound(entries.back().index());
+    for (auto it = waiters_.begin(); it != end; ++it) {
+      callbacks.push_back(std::move(it->second));
+    }
+    waiters_.erase(waiters_.begin(), end);
+  }
+  for (auto& cb : callbacks) {
+    cb();
+  }
+}
+
+void Applier::WaitApplied(uint64_t index, std::function<void()> callback) {
+  {
+    std::lock_guard<std::mutex> g(mu_);
+    if (applied_.load(std::memory_order_relaxed) < index) {
+      waiters_.emplace(index, std::move(callback));
+      return;
+    }
+  }
+  callback();
+}
+
+}  // namespace consensus
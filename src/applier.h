@@ -0,0 +1,67 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "base/task_queue.h"
+#include "state_machine.h"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace consensus {
+
+// Applier feeds the committed entries of a log to the StateMachine in a dedicated
+// apply thread, so that applying overlaps with persisting and replicating the next
+// Ready-s, rather than stalling the flusher. The queued entries are accounted to
+// MemoryTracker::kUnappliedEntries.
+//
+// Thread-Safe
+class Applier {
+ public:
+  // The entries up to `appliedIndex` are already applied, they're skipped. The apply
+  // thread is started with `affinity`.
+  Applier(StateMachine* stateMachine, uint64_t appliedIndex,
+          const ThreadAffinity& affinity = ThreadAffinity());
+
+  // Queues the entries handed out by a Ready that has been persisted.
+  void Submit(std::vector<yaraft::pb::Entry>&& entries);
+
+  // Index of the last applied entry.
+  uint64_t AppliedIndex() const {
+    return applied_.load(std::memory_order_acquire);
+  }
+
+  // `callback` is called once the entries up to `index` are applied, right away if
+  // they already are, otherwise in the apply thread.
+  void WaitApplied(uint64_t index, std::function<void()> callback);
+
+ private:
+  void apply(std::vector<yaraft::pb::Entry>* batch);
+
+ private:
+  StateMachine* stateMachine_;
+
+  std::atomic<uint64_t> applied_;
+
+  std::mutex mu_;
+  std::multimap<uint64_t, std::function<void()>> waiters_;
+
+  TaskQueue queue_;
+};
+
+}  // namespace consensus
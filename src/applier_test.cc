@@ -0,0 +1,61 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "applier.h"
+#include "base/simple_channel.h"
+#include "base/testing.h"
+
+using namespace consensus;
+
+class RecordingStateMachine : public StateMachine {
+ public:
+  Status Apply(const std::vector<yaraft::pb::Entry> &entries) override {
+    for (const auto &e : entries) {
+      applied.push_back(e.index());
+    }
+    return Status::OK();
+  }
+
+  std::vector<uint64_t> applied;
+};
+
+static std::vector<yaraft::pb::Entry> makeEntries(uint64_t lo, uint64_t hi) {
+  std::vector<yaraft::pb::Entry> entries;
+  for (uint64_t i = lo; i <= hi; i++) {
+    entries.emplace_back();
+    entries.back().set_index(i);
+  }
+  return entries;
+}
+
+TEST(ApplierTest, Apply) {
+  RecordingStateMachine sm;
+  Applier applier(&sm, 2);
+
+  // the entries up to 2 are applied before.
+  applier.Submit(makeEntries(1, 3));
+  applier.Submit(makeEntries(4, 5));
+
+  Barrier barrier;
+  applier.WaitApplied(5, [&]() { barrier.Signal(); });
+  barrier.Wait();
+
+  ASSERT_EQ(applier.AppliedIndex(), 5);
+  ASSERT_EQ(sm.applied, std::vector<uint64_t>({3, 4, 5}));
+
+  // called right away
+  bool called = false;
+  applier.WaitApplied(4, [&]() { called = true; });
+  ASSERT_TRUE(called);
+}
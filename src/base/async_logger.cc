@@ -0,0 +1,266 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "consensus/base/async_logger.h"
+#include "consensus/base/glog_logger.h"
+
+#include "base/logging.h"
+#include "base/metrics.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace consensus {
+
+// the number of the slots of the sites rate limited.
+static const size_t kRateLimitSlots = 1024;
+
+// how long the writer sleeps when there's nothing to write.
+static const std::chrono::milliseconds kIdleWait(10);
+
+static std::atomic<AsyncLogger *> installedLogger(nullptr);
+
+class AsyncLogger::Impl {
+  struct Record {
+    yaraft::LogLevel level;
+    int line;
+    const char *file;
+    std::string msg;
+  };
+
+  // A cell of the ring is free for the producer claiming position `pos` if its seq
+  // is `pos`, and holds the record at `pos` for the consumer if its seq is `pos + 1`.
+  struct Cell {
+    std::atomic<size_t> seq;
+    Record record;
+  };
+
+  struct Site {
+    std::atomic<int64_t> second{-1};
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint32_t> suppressed{0};
+  };
+
+ public:
+  explicit Impl(const AsyncLoggerOptions &options)
+      : options_(options), sites_(new Site[kRateLimitSlots]) {
+    size_t capacity = 1;
+    while (capacity < options_.capacity) {
+      capacity <<= 1;
+    }
+    mask_ = capacity - 1;
+    ring_.reset(new Cell[capacity]);
+    for (size_t i = 0; i < capacity; i++) {
+      ring_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    FATAL_NOT_OK(worker_.StartLoop(std::bind(&Impl::writeRound, this), options_.affinity),
+                 "AsyncLogger::Start");
+  }
+
+  ~Impl() {
+    {
+      std::lock_guard<std::mutex> g(mu_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    FATAL_NOT_OK(worker_.Stop(), "AsyncLogger::Stop");
+
+    // the writer thread has exited, the rest are written here.
+    while (drain() > 0) {
+    }
+  }
+
+  bool Log(yaraft::LogLevel level, int line, const char *file, std::string msg) {
+    if (options_.max_lines_per_site_per_sec > 0 && !admit(line, file, &msg)) {
+      suppressed_.fetch_add(1, std::memory_order_relaxed);
+      Metrics::Instance().logSuppressed << 1;
+      return false;
+    }
+
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+      cell = &ring_[pos & mask_];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // the ring is full.
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        Metrics::Instance().logDropped << 1;
+        return false;
+      } else {
+        pos = enqueuePos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->record.level = level;
+    cell->record.line = line;
+    cell->record.file = file;
+    cell->record.msg = std::move(msg);
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  void Flush() {
+    std::unique_lock<std::mutex> l(mu_);
+    size_t target = enqueuePos_.load(std::memory_order_relaxed);
+    flushing_++;
+    cv_.notify_all();
+    cv_.wait(l, [&]() { return written_ >= target || stopping_; });
+    flushing_--;
+  }
+
+  uint64_t Dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t Suppressed() const {
+    return suppressed_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // Returns false if the line exceeds the rate limit of its site, otherwise appends
+  // the count of the lines suppressed since the last one let through.
+  bool admit(int line, const char *file, std::string *msg) {
+    size_t h = std::hash<const void *>()(file) ^ (static_cast<size_t>(line) * 0x9e3779b9);
+    Site &site = sites_[h % kRateLimitSlots];
+
+    int64_t now = MonotonicMicros() / 1000000;
+    int64_t second = site.second.load(std::memory_order_relaxed);
+    if (second != now && site.second.compare_exchange_strong(second, now)) {
+      site.count.store(0, std::memory_order_relaxed);
+    }
+    uint32_t count = site.count.fetch_add(1, std::memory_order_relaxed);
+    if (count >= options_.max_lines_per_site_per_sec) {
+      site.suppressed.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    uint32_t suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+    if (suppressed > 0) {
+      *msg += fmt::format(" [{} similar lines suppressed]", suppressed);
+    }
+    return true;
+  }
+
+  // Writes the records published so far, returns the number written.
+  // Only called by a single consumer at a time.
+  size_t drain() {
+    size_t n = 0;
+    while (true) {
+      Cell &cell = ring_[dequeuePos_ & mask_];
+      if (cell.seq.load(std::memory_order_acquire) != dequeuePos_ + 1) {
+        break;
+      }
+      Record &r = cell.record;
+      options_.writer(r.level, r.line, r.file, r.msg);
+      r.msg = std::string();
+      cell.seq.store(dequeuePos_ + mask_ + 1, std::memory_order_release);
+      dequeuePos_++;
+      n++;
+    }
+
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped > reportedDrops_) {
+      options_.writer(yaraft::WARNING, __LINE__, __FILE__,
+                      fmt::format("{} log lines were dropped since the buffer was full",
+                                  dropped - reportedDrops_));
+      reportedDrops_ = dropped;
+    }
+
+    if (n > 0) {
+      std::lock_guard<std::mutex> g(mu_);
+      written_ = dequeuePos_;
+      if (flushing_ > 0) {
+        cv_.notify_all();
+      }
+    }
+    return n;
+  }
+
+  void writeRound() {
+    if (drain() > 0) {
+      return;
+    }
+    std::unique_lock<std::mutex> l(mu_);
+    if (!stopping_ && flushing_ == 0) {
+      cv_.wait_for(l, kIdleWait);
+    }
+  }
+
+ private:
+  AsyncLoggerOptions options_;
+
+  std::unique_ptr<Cell[]> ring_;
+  size_t mask_;
+  std::atomic<size_t> enqueuePos_{0};
+
+  // owned by the consumer.
+  size_t dequeuePos_{0};
+  uint64_t reportedDrops_{0};
+
+  std::unique_ptr<Site[]> sites_;
+
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> suppressed_{0};
+
+  // protects the progress of the writer, waited for by Flush.
+  std::mutex mu_;
+  std::condition_variable cv_;
+  size_t written_{0};
+  size_t flushing_{0};
+  bool stopping_{false};
+
+  BackgroundWorker worker_;
+};
+
+AsyncLoggerOptions::AsyncLoggerOptions()
+    : capacity(8192), max_lines_per_site_per_sec(100), writer(GLogLogger::Write) {}
+
+AsyncLogger::AsyncLogger(const AsyncLoggerOptions &options) : impl_(new Impl(options)) {}
+
+AsyncLogger::~AsyncLogger() = default;
+
+bool AsyncLogger::Log(yaraft::LogLevel level, int line, const char *file, std::string msg) {
+  return impl_->Log(level, line, file, std::move(msg));
+}
+
+void AsyncLogger::Flush() {
+  impl_->Flush();
+}
+
+uint64_t AsyncLogger::Dropped() const {
+  return impl_->Dropped();
+}
+
+uint64_t AsyncLogger::Suppressed() const {
+  return impl_->Suppressed();
+}
+
+void AsyncLogger::Install(AsyncLogger *logger) {
+  installedLogger.store(logger, std::memory_order_release);
+}
+
+AsyncLogger *AsyncLogger::Installed() {
+  return installedLogger.load(std::memory_order_acquire);
+}
+
+}  // namespace consensus
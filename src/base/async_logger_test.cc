@@ -0,0 +1,146 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/async_logger.h"
+#include "base/logging.h"
+#include "base/testing.h"
+
+using namespace consensus;
+
+// Collects the lines written by AsyncLogger.
+class LineCollector {
+ public:
+  AsyncLoggerOptions::Writer Writer() {
+    return [this](yaraft::LogLevel, int, const char*, const std::string& msg) {
+      std::lock_guard<std::mutex> g(mu_);
+      lines_.push_back(msg);
+    };
+  }
+
+  std::vector<std::string> Lines() {
+    std::lock_guard<std::mutex> g(mu_);
+    return lines_;
+  }
+
+  std::mutex& Mutex() {
+    return mu_;
+  }
+
+ private:
+  std::mutex mu_;
+  std::vector<std::string> lines_;
+};
+
+TEST(AsyncLoggerTest, WriteInOrder) {
+  LineCollector collector;
+  AsyncLoggerOptions options;
+  options.max_lines_per_site_per_sec = 0;
+  options.writer = collector.Writer();
+  AsyncLogger logger(options);
+
+  std::vector<std::string> expected;
+  for (int i = 0; i < 1000; i++) {
+    expected.push_back(std::to_string(i));
+    ASSERT_TRUE(logger.Log(yaraft::INFO, __LINE__, __FILE__, expected.back()));
+  }
+  logger.Flush();
+  ASSERT_EQ(collector.Lines(), expected);
+}
+
+// This test verifies that the repeated lines of a site are suppressed beyond the
+// limit, and counted on the next line let through.
+TEST(AsyncLoggerTest, RateLimit) {
+  LineCollector collector;
+  AsyncLoggerOptions options;
+  options.max_lines_per_site_per_sec = 10;
+  options.writer = collector.Writer();
+  AsyncLogger logger(options);
+
+  size_t admitted = 0;
+  for (int i = 0; i < 100; i++) {
+    admitted += logger.Log(yaraft::WARNING, __LINE__, __FILE__, "flapping");
+  }
+  // the window may roll over once in the loop.
+  ASSERT_GE(admitted, 10);
+  ASSERT_LE(admitted, 20);
+  ASSERT_EQ(logger.Suppressed(), 100 - admitted);
+
+  // other sites are not limited.
+  ASSERT_TRUE(logger.Log(yaraft::WARNING, __LINE__, __FILE__, "other"));
+
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  size_t suppressed = 0;
+  for (int i = 0; i < 20; i++) {
+    suppressed += !logger.Log(yaraft::WARNING, 42, __FILE__, "flapping");
+  }
+  ASSERT_GT(suppressed, 0);
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  ASSERT_TRUE(logger.Log(yaraft::WARNING, 42, __FILE__, "again"));
+  logger.Flush();
+  ASSERT_EQ(collector.Lines().back(),
+            "again [" + std::to_string(suppressed) + " similar lines suppressed]");
+}
+
+// This test verifies that the lines are dropped rather than blocking the logging
+// thread once the ring is full, and the drops are reported.
+TEST(AsyncLoggerTest, DropWhenFull) {
+  LineCollector collector;
+  AsyncLoggerOptions options;
+  options.capacity = 4;
+  options.max_lines_per_site_per_sec = 0;
+  options.writer = collector.Writer();
+  AsyncLogger logger(options);
+
+  size_t queued = 0;
+  {
+    // the writer is stalled.
+    std::lock_guard<std::mutex> g(collector.Mutex());
+    for (int i = 0; i < 100; i++) {
+      queued += logger.Log(yaraft::INFO, __LINE__, __FILE__, std::to_string(i));
+    }
+  }
+  ASSERT_LT(queued, 100);
+  ASSERT_EQ(logger.Dropped(), 100 - queued);
+
+  logger.Flush();
+  std::vector<std::string> lines = collector.Lines();
+  ASSERT_EQ(lines.size(), queued + 1);
+  ASSERT_EQ(lines.back(),
+            std::to_string(logger.Dropped()) + " log lines were dropped since the buffer was full");
+}
+
+TEST(AsyncLoggerTest, Install) {
+  LineCollector collector;
+  AsyncLoggerOptions options;
+  options.writer = collector.Writer();
+  AsyncLogger logger(options);
+
+  AsyncLogger::Install(&logger);
+  FMT_LOG(INFO, "installed {}", 1);
+  WARN_NOT_OK(Status::Make(Error::IOError, "disk"), "write");
+  AsyncLogger::Install(nullptr);
+  FMT_LOG(INFO, "uninstalled");
+
+  logger.Flush();
+  std::vector<std::string> lines = collector.Lines();
+  ASSERT_EQ(lines.size(), 2);
+  ASSERT_EQ(lines[0], "installed 1");
+}
@@ -13,17 +13,113 @@
 // limitations under the License.
 
 #include <atomic>
+#include <fstream>
+#include <future>
+#include <sstream>
 #include <thread>
 
 #include "base/background_worker.h"
+#include "base/errno.h"
+
+#include <fmt/format.h>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace consensus {
 
+#if defined(__linux__)
+
+// Parses the cpu list of sysfs, e.g "0-3,8-11".
+static Status parseCpuList(const std::string& list, std::vector<int>* cpus) {
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty()) {
+      continue;
+    }
+    int lo, hi;
+    char dash;
+    std::stringstream rs(range);
+    if (!(rs >> lo)) {
+      return FMT_Status(Corruption, "invalid cpu list: \"{}\"", list);
+    }
+    hi = lo;
+    if (rs >> dash && !(dash == '-' && rs >> hi)) {
+      return FMT_Status(Corruption, "invalid cpu list: \"{}\"", list);
+    }
+    for (int c = lo; c <= hi; c++) {
+      cpus->push_back(c);
+    }
+  }
+  return Status::OK();
+}
+
+static Status numaNodeCpus(int node, std::vector<int>* cpus) {
+  std::string fname = fmt::format("/sys/devices/system/node/node{}/cpulist", node);
+  std::ifstream in(fname);
+  std::string list;
+  if (!in || !std::getline(in, list)) {
+    return FMT_Status(NotFound, "NUMA node {} is not found [file: \"{}\"]", node, fname);
+  }
+  return parseCpuList(list, cpus);
+}
+
+Status ThreadAffinity::Apply() const {
+  std::vector<int> cores = cpus;
+  if (cores.empty() && numa_node >= 0) {
+    RETURN_NOT_OK(numaNodeCpus(numa_node, &cores));
+  }
+
+  if (!cores.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cores) {
+      if (c < 0 || c >= CPU_SETSIZE) {
+        return FMT_Status(InvalidArgument, "invalid cpu id: {}", c);
+      }
+      CPU_SET(c, &set);
+    }
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+      return FMT_Status(InvalidArgument, "pthread_setaffinity_np: {}", ErrnoToString(err));
+    }
+  }
+
+  if (numa_node >= 0) {
+    // the kernel reads one bit less than maxnode.
+    const size_t bits = sizeof(unsigned long) * 8;
+    std::vector<unsigned long> mask(numa_node / bits + 1, 0);
+    mask[numa_node / bits] |= 1UL << (numa_node % bits);
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), mask.size() * bits + 1) != 0) {
+      return FMT_Status(InvalidArgument, "set_mempolicy [node: {}]: {}", numa_node,
+                        ErrnoToString(errno));
+    }
+  }
+  return Status::OK();
+}
+
+#else
+
+Status ThreadAffinity::Apply() const {
+  if (Empty()) {
+    return Status::OK();
+  }
+  return Status::Make(Error::NotSupported, "thread affinity is not supported");
+}
+
+#endif
+
 class BackgroundWorker::Impl {
  public:
   explicit Impl() : stopped_(true) {}
 
-  Status StartLoop(std::function<void()> recurringTask) {
+  Status StartLoop(std::function<void()> recurringTask, const ThreadAffinity& affinity) {
     if (bgWorkerThread_.joinable()) {
       return Status::Make(Error::RuntimeError,
                           "BackgroundWorker::StartLoop: start an already started thread");
@@ -34,13 +130,27 @@ class BackgroundWorker::Impl {
                           "BackgroundWorker::StartLoop: the given task has no target");
     }
 
+    // the affinity is applied in the thread, which exits at once if it fails.
+    auto applied = std::make_shared<std::promise<Status>>();
+    std::future<Status> result = applied->get_future();
     stopped_.store(false);
     bgWorkerThread_ = std::thread([=]() {
+      Status s = affinity.Apply();
+      applied->set_value(s);
+      if (!s.IsOK()) {
+        return;
+      }
       while (!stopped_.load()) {
         recurringTask();
       }
     });
-    return Status::OK();
+
+    Status s = result.get();
+    if (!s.IsOK()) {
+      bgWorkerThread_.join();
+      stopped_.store(true);
+    }
+    return s;
   }
 
   Status Stop() {
@@ -65,8 +175,9 @@ class BackgroundWorker::Impl {
 
 BackgroundWorker::BackgroundWorker() : impl_(new Impl) {}
 
-Status BackgroundWorker::StartLoop(std::function<void()> recurringTask) {
-  return impl_->StartLoop(recurringTask);
+Status BackgroundWorker::StartLoop(std::function<void()> recurringTask,
+                                   const ThreadAffinity& affinity) {
+  return impl_->StartLoop(recurringTask, affinity);
 }
 
 Status BackgroundWorker::Stop() {
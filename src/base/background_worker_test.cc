@@ -15,6 +15,10 @@
 #include "base/background_worker.h"
 #include "base/testing.h"
 
+#include <atomic>
+
+#include <sched.h>
+
 using namespace consensus;
 
 // This test verifies BackgroundWorker::Stop will stop the background thread only when it's
@@ -46,4 +50,44 @@ TEST(BackgroundWorkerTest, Start) {
     ASSERT_EQ(worker.StartLoop(func).Code(), Error::RuntimeError);
     worker.Stop();
   }
-}
\ No newline at end of file
+}
+#if defined(__linux__)
+// This test verifies that the thread runs with the affinity given, and it's not
+// started if the affinity can't be applied.
+TEST(BackgroundWorkerTest, Affinity) {
+  BackgroundWorker worker;
+
+  {
+    ThreadAffinity affinity;
+    affinity.cpus = {0};
+    std::atomic<int> cpu(-1);
+    ASSERT_OK(worker.StartLoop(
+        [&]() {
+          cpu = sched_getcpu();
+          usleep(1000 * 1);
+        },
+        affinity));
+    usleep(1000 * 10);
+    ASSERT_OK(worker.Stop());
+    ASSERT_EQ(cpu.load(), 0);
+  }
+
+  {
+    ThreadAffinity affinity;
+    affinity.numa_node = 0;
+    ASSERT_OK(worker.StartLoop([]() { usleep(1000 * 1); }, affinity));
+    ASSERT_OK(worker.Stop());
+  }
+
+  {
+    ThreadAffinity affinity;
+    affinity.cpus = {-1};
+    ASSERT_EQ(worker.StartLoop([]() {}, affinity).Code(), Error::InvalidArgument);
+    ASSERT_TRUE(worker.Stopped());
+
+    affinity.cpus.clear();
+    affinity.numa_node = 1 << 16;
+    ASSERT_EQ(worker.StartLoop([]() {}, affinity).Code(), Error::NotFound);
+  }
+}
+#endif
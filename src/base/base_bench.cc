@@ -0,0 +1,256 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the primitives that hand the work between threads on the write path, and
+// the encoding of the log records, as a baseline before any of them is replaced:
+// - TaskQueueHandoff: from TaskQueue::Enqueue to the task running, with the
+//   percentiles of the handoff as the counters p50_us, p99_us and p999_us.
+// - ExecutorRoundTrip: RaftTaskExecutor::Submit of a task that signals a Barrier,
+//   until the submitter wakes up, as ReplicatedLog::Write waits on its proposals.
+// - SimpleChannelBench: the promise/future cost of a SimpleChannel, within a thread
+//   and across the TaskQueue.
+// - TaskQueueProducers: the throughput of many threads enqueueing empty tasks.
+// - VarintBench, FixedBench: encode and decode throughput of coding.h.
+// Run with --benchmark_format=json for machine-readable results.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "base/coding.h"
+#include "base/simple_channel.h"
+#include "base/task_queue.h"
+#include "raft_task_executor.h"
+
+#include <benchmark/benchmark.h>
+#include <yaraft/yaraft.h>
+
+using namespace consensus;
+
+static int64_t nowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static void reportPercentiles(benchmark::State& state, std::vector<int64_t>* nanos) {
+  if (nanos->empty()) {
+    return;
+  }
+  std::sort(nanos->begin(), nanos->end());
+  auto pct = [nanos](double p) {
+    return (*nanos)[std::min(nanos->size() - 1, static_cast<size_t>(nanos->size() * p))] /
+           1000.0;
+  };
+  state.counters["p50_us"] = pct(0.5);
+  state.counters["p99_us"] = pct(0.99);
+  state.counters["p999_us"] = pct(0.999);
+}
+
+// One task in flight at a time, the enqueuer spins until it has run, so that the
+// consumer thread is woken up every time, the worst case of a lightly loaded queue.
+// Args: urgent
+void TaskQueueHandoff(benchmark::State& state) {
+  TaskQueue queue;
+  bool urgent = state.range(0);
+  std::vector<int64_t> handoffs;
+  std::atomic<int64_t> ranAt(0);
+
+  while (state.KeepRunning()) {
+    ranAt.store(0, std::memory_order_relaxed);
+    int64_t enqueuedAt = nowNanos();
+    Task task([&ranAt]() { ranAt.store(nowNanos(), std::memory_order_release); });
+    if (urgent) {
+      queue.EnqueueUrgent(std::move(task));
+    } else {
+      queue.Enqueue(std::move(task));
+    }
+    int64_t t;
+    while ((t = ranAt.load(std::memory_order_acquire)) == 0) {
+    }
+    handoffs.push_back(t - enqueuedAt);
+  }
+  reportPercentiles(state, &handoffs);
+}
+
+BENCHMARK(TaskQueueHandoff)->ArgName("urgent")->Arg(0)->Arg(1)->UseRealTime();
+
+// Args: urgent
+void ExecutorRoundTrip(benchmark::State& state) {
+  yaraft::Config* conf = new yaraft::Config;
+  conf->id = 1;
+  conf->peers = {1, 2, 3};
+  conf->electionTick = 1000;
+  conf->heartbeatTick = 100;
+  conf->storage = new yaraft::MemoryStorage;
+  yaraft::RawNode node(conf);
+  TaskQueue queue;
+  RaftTaskExecutor executor(&node, &queue);
+  bool urgent = state.range(0);
+
+  while (state.KeepRunning()) {
+    Barrier barrier;
+    RaftTaskExecutor::RaftTask task = [&barrier](yaraft::RawNode*) { barrier.Signal(); };
+    if (urgent) {
+      executor.SubmitUrgent(std::move(task));
+    } else {
+      executor.Submit(std::move(task));
+    }
+    barrier.Wait();
+  }
+}
+
+BENCHMARK(ExecutorRoundTrip)->ArgName("urgent")->Arg(0)->Arg(1)->UseRealTime();
+
+// Args: across threads
+void SimpleChannelBench(benchmark::State& state) {
+  TaskQueue queue;
+  bool acrossThreads = state.range(0);
+
+  while (state.KeepRunning()) {
+    SimpleChannel<int> chan;
+    if (acrossThreads) {
+      std::function<void(const int&)> send = chan.Sender();
+      queue.Enqueue([send]() { send(1); });
+    } else {
+      chan <<= 1;
+    }
+    int v;
+    chan >>= v;
+    benchmark::DoNotOptimize(v);
+  }
+}
+
+BENCHMARK(SimpleChannelBench)->ArgName("across_threads")->Arg(0)->Arg(1)->UseRealTime();
+
+// Each producer enqueues a run of empty tasks, the iteration ends once the consumer
+// has run them all.
+// Args: producers
+void TaskQueueProducers(benchmark::State& state) {
+  TaskQueue queue;
+  int producers = state.range(0);
+  const int kTasksPerProducer = 10000;
+  std::atomic<int64_t> ran(0);
+
+  int64_t expected = 0;
+  while (state.KeepRunning()) {
+    expected += producers * kTasksPerProducer;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+      threads.emplace_back([&]() {
+        for (int i = 0; i < kTasksPerProducer; i++) {
+          queue.Enqueue([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); });
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    while (ran.load(std::memory_order_relaxed) < expected) {
+      std::this_thread::yield();
+    }
+  }
+  state.SetItemsProcessed(expected);
+}
+
+BENCHMARK(TaskQueueProducers)
+    ->ArgName("producers")
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
+
+// Values of up to the given number of bits, so that their varints are of 1 to 10 bytes.
+static std::vector<uint64_t> randomValues(int bits, size_t n) {
+  std::mt19937_64 rng(bits);
+  uint64_t mask = bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+  std::vector<uint64_t> values(n);
+  for (auto& v : values) {
+    v = rng() & mask;
+  }
+  return values;
+}
+
+static const size_t kCodingBatch = 4096;
+
+// Args: bits, decode
+void VarintBench(benchmark::State& state) {
+  std::vector<uint64_t> values = randomValues(state.range(0), kCodingBatch);
+  bool decode = state.range(1);
+  std::string buf;
+  for (uint64_t v : values) {
+    PutVarint64(&buf, v);
+  }
+
+  while (state.KeepRunning()) {
+    if (decode) {
+      const char* p = buf.data();
+      const char* limit = p + buf.size();
+      uint64_t v;
+      while (p < limit) {
+        p = GetVarint64Ptr(p, limit, &v);
+        benchmark::DoNotOptimize(v);
+      }
+    } else {
+      std::string out;
+      out.reserve(buf.size());
+      for (uint64_t v : values) {
+        PutVarint64(&out, v);
+      }
+      benchmark::DoNotOptimize(out.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kCodingBatch);
+  state.SetBytesProcessed(state.iterations() * buf.size());
+}
+
+static void varintArgs(benchmark::internal::Benchmark* b) {
+  for (int decode = 0; decode <= 1; decode++) {
+    for (int bits : {7, 14, 28, 42, 64}) {
+      b->Args({bits, decode});
+    }
+  }
+}
+
+BENCHMARK(VarintBench)->ArgNames({"bits", "decode"})->Apply(varintArgs);
+
+// Args: decode
+void FixedBench(benchmark::State& state) {
+  std::vector<uint64_t> values = randomValues(64, kCodingBatch);
+  bool decode = state.range(0);
+  std::string buf(kCodingBatch * 8, '\0');
+  for (size_t i = 0; i < kCodingBatch; i++) {
+    EncodeFixed64(&buf[i * 8], values[i]);
+  }
+
+  while (state.KeepRunning()) {
+    if (decode) {
+      for (size_t i = 0; i < kCodingBatch; i++) {
+        benchmark::DoNotOptimize(DecodeFixed64(buf.data() + i * 8));
+      }
+    } else {
+      for (size_t i = 0; i < kCodingBatch; i++) {
+        EncodeFixed64(&buf[i * 8], values[i]);
+      }
+      benchmark::DoNotOptimize(buf.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kCodingBatch);
+  state.SetBytesProcessed(state.iterations() * buf.size());
+}
+
+BENCHMARK(FixedBench)->ArgName("decode")->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
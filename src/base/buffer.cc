@@ -0,0 +1,86 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/buffer.h"
+#include "base/logging.h"
+
+namespace consensus {
+
+Buffer::Buffer(std::string &&data) {
+  Append(std::move(data));
+}
+
+void Buffer::Append(const Slice &data) {
+  Append(std::string(data.data(), data.size()));
+}
+
+void Buffer::Append(std::string &&data) {
+  if (data.empty()) {
+    return;
+  }
+  size_t length = data.size();
+  refs_.push_back(Ref{std::make_shared<std::string>(std::move(data)), 0, length});
+  size_ += length;
+}
+
+void Buffer::Append(const Buffer &other) {
+  refs_.insert(refs_.end(), other.refs_.begin(), other.refs_.end());
+  size_ += other.size_;
+}
+
+void Buffer::RemovePrefix(size_t n) {
+  DCHECK_LE(n, size_);
+  size_ -= n;
+
+  size_t i = 0;
+  while (n > 0 && n >= refs_[i].length) {
+    n -= refs_[i].length;
+    i++;
+  }
+  refs_.erase(refs_.begin(), refs_.begin() + i);
+  if (n > 0) {
+    refs_.front().offset += n;
+    refs_.front().length -= n;
+  }
+}
+
+void Buffer::AppendSlices(std::vector<Slice> *slices) const {
+  for (size_t i = 0; i < refs_.size(); i++) {
+    slices->push_back(Block(i));
+  }
+}
+
+void Buffer::MoveTo(std::string *dst) {
+  if (refs_.size() == 1) {
+    Ref &r = refs_.front();
+    if (r.block.use_count() == 1 && r.offset == 0 && r.length == r.block->size()) {
+      dst->swap(*r.block);
+      Clear();
+      return;
+    }
+  }
+  *dst = ToString();
+  Clear();
+}
+
+std::string Buffer::ToString() const {
+  std::string result;
+  result.reserve(size_);
+  for (const Ref &r : refs_) {
+    result.append(r.block->data() + r.offset, r.length);
+  }
+  return result;
+}
+
+}  // namespace consensus
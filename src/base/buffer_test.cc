@@ -0,0 +1,78 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/buffer.h"
+#include "base/testing.h"
+
+using namespace consensus;
+
+class BufferTest : public BaseTest {};
+
+TEST_F(BufferTest, AppendAndShare) {
+  Buffer a(std::string("hello"));
+  a.Append(Slice(", "));
+
+  Buffer b;
+  b.Append(a);
+  b.Append(std::string("world"));
+  ASSERT_EQ(b.ToString(), "hello, world");
+  ASSERT_EQ(b.size(), 12);
+  ASSERT_EQ(b.BlockCount(), 3);
+
+  // the blocks are shared, not copied.
+  ASSERT_EQ(a.Block(0).data(), b.Block(0).data());
+
+  std::vector<Slice> slices;
+  b.AppendSlices(&slices);
+  ASSERT_EQ(slices.size(), 3);
+  ASSERT_EQ(slices[2].ToString(), "world");
+}
+
+TEST_F(BufferTest, RemovePrefix) {
+  Buffer b(std::string("abc"));
+  b.Append(std::string("def"));
+  b.Append(std::string("gh"));
+
+  b.RemovePrefix(1);
+  ASSERT_EQ(b.ToString(), "bcdefgh");
+  b.RemovePrefix(2);
+  ASSERT_EQ(b.ToString(), "defgh");
+  ASSERT_EQ(b.BlockCount(), 2);
+  b.RemovePrefix(4);
+  ASSERT_EQ(b.ToString(), "h");
+  b.RemovePrefix(1);
+  ASSERT_TRUE(b.empty());
+  ASSERT_EQ(b.BlockCount(), 0);
+}
+
+TEST_F(BufferTest, MoveTo) {
+  std::string data(1024, 'x');
+  const char *p = data.data();
+
+  // a single unshared block is handed over.
+  Buffer b(std::move(data));
+  std::string dst;
+  b.MoveTo(&dst);
+  ASSERT_EQ(dst.data(), p);
+  ASSERT_TRUE(b.empty());
+
+  // a shared block is copied, the other owner still sees it.
+  Buffer c(std::move(dst));
+  Buffer d;
+  d.Append(c);
+  std::string copy;
+  c.MoveTo(&copy);
+  ASSERT_EQ(copy, std::string(1024, 'x'));
+  ASSERT_EQ(d.ToString(), copy);
+}
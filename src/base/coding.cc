@@ -4,6 +4,14 @@
 
 #include "base/coding.h"
 
+#include <silly/likely.h>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace consensus {
 
 void EncodeFixed32(char* buf, uint32_t value) {
@@ -167,6 +175,164 @@ bool GetVarint64(Slice* input, uint64_t* value) {
   }
 }
 
+namespace {
+
+const int kVarintChunk = 16;
+
+#if defined(__x86_64__)
+
+// Bit i is the continuation bit of p[i].
+inline uint32_t continuationMask(const char* p) {
+  __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  return static_cast<uint32_t>(_mm_movemask_epi8(v));
+}
+
+const bool kVarintBulkAccelerated = true;
+
+#elif defined(__aarch64__)
+
+inline uint32_t continuationMask(const char* p) {
+  static const uint8_t kBits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+  uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+  uint8x16_t bits = vandq_u8(vtstq_u8(v, vdupq_n_u8(0x80)), vld1q_u8(kBits));
+  return static_cast<uint32_t>(vaddv_u8(vget_low_u8(bits))) |
+         (static_cast<uint32_t>(vaddv_u8(vget_high_u8(bits))) << 8);
+}
+
+const bool kVarintBulkAccelerated = true;
+
+#else
+
+inline uint32_t continuationMask(const char* p) {
+  uint32_t mask = 0;
+  for (int i = 0; i < kVarintChunk; i++) {
+    mask |= static_cast<uint32_t>((static_cast<unsigned char>(p[i]) >> 7) & 1) << i;
+  }
+  return mask;
+}
+
+const bool kVarintBulkAccelerated = false;
+
+#endif
+
+template <class T>
+inline const char* getVarintPtr(const char* p, const char* limit, T* value);
+
+template <>
+inline const char* getVarintPtr(const char* p, const char* limit, uint32_t* value) {
+  return GetVarint32Ptr(p, limit, value);
+}
+
+template <>
+inline const char* getVarintPtr(const char* p, const char* limit, uint64_t* value) {
+  return GetVarint64Ptr(p, limit, value);
+}
+
+// The varints ending in a chunk are assembled from the bytes between the boundaries
+// given by its mask. A varint crossing the end of the chunk is left to the scalar
+// routine, so are the last bytes of the input.
+template <class T, int kMaxBytes>
+const char* getVarintBulk(const char* p, const char* limit, T* values, size_t n) {
+  while (n > 0 && limit - p >= kVarintChunk) {
+    uint32_t mask = continuationMask(p);
+    if (mask == 0 && n >= static_cast<size_t>(kVarintChunk)) {
+      for (int i = 0; i < kVarintChunk; i++) {
+        values[i] = static_cast<unsigned char>(p[i]);
+      }
+      p += kVarintChunk;
+      values += kVarintChunk;
+      n -= kVarintChunk;
+      continue;
+    }
+
+    // bit i of `ends` is set if p[i] is the last byte of a varint.
+    uint32_t ends = ~mask & ((1u << kVarintChunk) - 1);
+    int pos = 0;
+    while (n > 0 && (ends >> pos) != 0) {
+      int len = __builtin_ctz(ends >> pos) + 1;
+      if (UNLIKELY(len > kMaxBytes)) {
+        return NULL;
+      }
+      T result = 0;
+      for (int i = 0; i < len; i++) {
+        result |= static_cast<T>(static_cast<unsigned char>(p[pos + i]) & 127) << (7 * i);
+      }
+      *values++ = result;
+      n--;
+      pos += len;
+    }
+    if (pos == 0) {
+      // no varint ends in this chunk.
+      p = getVarintPtr(p, limit, values);
+      if (p == NULL) {
+        return NULL;
+      }
+      values++;
+      n--;
+      continue;
+    }
+    p += pos;
+  }
+
+  for (; n > 0; n--) {
+    p = getVarintPtr(p, limit, values++);
+    if (p == NULL) {
+      return NULL;
+    }
+  }
+  return p;
+}
+
+}  // namespace
+
+const char* GetVarint32BulkPortable(const char* p, const char* limit, uint32_t* values,
+                                    size_t n) {
+  for (; n > 0; n--) {
+    p = GetVarint32Ptr(p, limit, values++);
+    if (p == NULL) {
+      return NULL;
+    }
+  }
+  return p;
+}
+
+const char* GetVarint32Bulk(const char* p, const char* limit, uint32_t* values, size_t n) {
+  return getVarintBulk<uint32_t, 5>(p, limit, values, n);
+}
+
+const char* GetVarint64Bulk(const char* p, const char* limit, uint64_t* values, size_t n) {
+  return getVarintBulk<uint64_t, 10>(p, limit, values, n);
+}
+
+char* EncodeVarint32Bulk(char* dst, const uint32_t* values, size_t n) {
+  while (n >= static_cast<size_t>(kVarintChunk)) {
+    uint32_t all = 0;
+    for (int i = 0; i < kVarintChunk; i++) {
+      all |= values[i];
+    }
+    if (all < 128) {
+      for (int i = 0; i < kVarintChunk; i++) {
+        dst[i] = static_cast<char>(values[i]);
+      }
+      dst += kVarintChunk;
+    } else {
+      for (int i = 0; i < kVarintChunk; i++) {
+        dst = EncodeVarint32(dst, values[i]);
+      }
+    }
+    values += kVarintChunk;
+    n -= kVarintChunk;
+  }
+  for (; n > 0; n--) {
+    dst = EncodeVarint32(dst, *values++);
+  }
+  return dst;
+}
+
+bool IsVarintBulkAccelerated() {
+  return kVarintBulkAccelerated;
+}
+
 const char* GetLengthPrefixedSlice(const char* p, const char* limit, Slice* result) {
   uint32_t len;
   p = GetVarint32Ptr(p, limit, &len);
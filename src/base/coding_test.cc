@@ -166,6 +166,63 @@ TEST(Coding, Varint64Truncation) {
   ASSERT_EQ(large_value, result);
 }
 
+// The bulk routines must agree with the scalar ones, on runs mixing single-byte and
+// long varints at every alignment to the 16-byte chunks.
+TEST(Coding, Varint32Bulk) {
+  std::vector<uint32_t> values;
+  for (uint32_t i = 0; i < 4096; i++) {
+    values.push_back(i % 7 == 0 ? (i * 2654435761u) >> (i % 32) : i % 128);
+  }
+
+  for (size_t skip = 0; skip < 32; skip++) {
+    size_t n = values.size() - skip;
+    const uint32_t* input = values.data() + skip;
+
+    std::string expected;
+    for (size_t i = 0; i < n; i++) {
+      PutVarint32(&expected, input[i]);
+    }
+    std::string s(5 * n, '\0');
+    char* end = EncodeVarint32Bulk(&s[0], input, n);
+    s.resize(end - s.data());
+    ASSERT_EQ(expected, s);
+
+    std::vector<uint32_t> bulk(n), portable(n);
+    const char* limit = s.data() + s.size();
+    ASSERT_EQ(limit, GetVarint32Bulk(s.data(), limit, bulk.data(), n));
+    ASSERT_EQ(limit, GetVarint32BulkPortable(s.data(), limit, portable.data(), n));
+    ASSERT_EQ(std::vector<uint32_t>(input, input + n), bulk);
+    ASSERT_EQ(bulk, portable);
+
+    ASSERT_TRUE(GetVarint32Bulk(s.data(), limit - 1, bulk.data(), n) == NULL);
+  }
+}
+
+TEST(Coding, Varint64Bulk) {
+  std::vector<uint64_t> values;
+  for (uint64_t i = 0; i < 1024; i++) {
+    values.push_back(i % 3 == 0 ? (i * 0x9e3779b97f4a7c15ull) >> (i % 64) : i % 128);
+  }
+
+  std::string s;
+  for (uint64_t v : values) {
+    PutVarint64(&s, v);
+  }
+  std::vector<uint64_t> actual(values.size());
+  const char* limit = s.data() + s.size();
+  ASSERT_EQ(limit, GetVarint64Bulk(s.data(), limit, actual.data(), actual.size()));
+  ASSERT_EQ(values, actual);
+}
+
+TEST(Coding, VarintBulkOverflow) {
+  uint32_t result[3];
+  std::string input("\x01\x02\x81\x82\x83\x84\x85\x11");
+  input.append(16, '\0');
+  ASSERT_TRUE(GetVarint32Bulk(input.data(), input.data() + input.size(), result, 3) == NULL);
+  ASSERT_TRUE(GetVarint32BulkPortable(input.data(), input.data() + input.size(), result, 3) ==
+              NULL);
+}
+
 TEST(Coding, Strings) {
   std::string s;
   PutLengthPrefixedSlice(&s, Slice(""));
@@ -0,0 +1,163 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#endif
+
+namespace consensus {
+namespace crc32c {
+
+// Castagnoli polynomial, reversed.
+static constexpr uint32_t kPoly = 0x82f63b78;
+
+namespace {
+
+// Tables for slicing-by-8.
+struct Tables {
+  uint32_t t[8][256];
+
+  Tables() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; j++) {
+        crc = (crc >> 1) ^ ((crc & 1) ? kPoly : 0);
+      }
+      t[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+      for (int k = 1; k < 8; k++) {
+        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+      }
+    }
+  }
+};
+
+inline uint32_t loadLE32(const char* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap32(v);
+#endif
+  return v;
+}
+
+}  // namespace
+
+uint32_t ExtendPortable(uint32_t crc, const char* data, size_t n) {
+  static const Tables tables;
+  const auto& t = tables.t;
+  const char* p = data;
+  uint32_t l = crc ^ 0xffffffffu;
+
+  while (n >= 8) {
+    uint32_t lo = loadLE32(p) ^ l;
+    uint32_t hi = loadLE32(p + 4);
+    l = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+        t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+    p += 8;
+    n -= 8;
+  }
+  while (n > 0) {
+    l = t[0][(l ^ static_cast<uint8_t>(*p)) & 0xff] ^ (l >> 8);
+    p++;
+    n--;
+  }
+  return l ^ 0xffffffffu;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.2"))) static uint32_t extendHardware(uint32_t crc, const char* data,
+                                                                 size_t n) {
+  const char* p = data;
+  uint64_t l = crc ^ 0xffffffffu;
+
+  while (n >= 8) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    l = _mm_crc32_u64(l, v);
+    p += 8;
+    n -= 8;
+  }
+  uint32_t l32 = static_cast<uint32_t>(l);
+  while (n > 0) {
+    l32 = _mm_crc32_u8(l32, static_cast<uint8_t>(*p));
+    p++;
+    n--;
+  }
+  return l32 ^ 0xffffffffu;
+}
+
+static bool hardwareSupported() {
+  return __builtin_cpu_supports("sse4.2");
+}
+
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+
+static uint32_t extendHardware(uint32_t crc, const char* data, size_t n) {
+  const char* p = data;
+  uint32_t l = crc ^ 0xffffffffu;
+
+  while (n >= 8) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    l = __crc32cd(l, v);
+    p += 8;
+    n -= 8;
+  }
+  while (n > 0) {
+    l = __crc32cb(l, static_cast<uint8_t>(*p));
+    p++;
+    n--;
+  }
+  return l ^ 0xffffffffu;
+}
+
+static bool hardwareSupported() {
+  return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+
+#else
+
+static uint32_t extendHardware(uint32_t crc, const char* data, size_t n) {
+  return ExtendPortable(crc, data, n);
+}
+
+static bool hardwareSupported() {
+  return false;
+}
+
+#endif
+
+bool IsHardwareAccelerated() {
+  static const bool supported = hardwareSupported();
+  return supported;
+}
+
+uint32_t Extend(uint32_t crc, const char* data, size_t n) {
+  using ExtendFunc = uint32_t (*)(uint32_t, const char*, size_t);
+  static const ExtendFunc func = IsHardwareAccelerated() ? extendHardware : ExtendPortable;
+  return func(crc, data, n);
+}
+
+}  // namespace crc32c
+}  // namespace consensus
@@ -0,0 +1,61 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/crc32c.h"
+#include "base/random.h"
+#include "base/testing.h"
+
+using namespace consensus;
+
+// Test vectors from RFC 3720 (iSCSI), section B.4.
+TEST(CRC32C, StandardResults) {
+  char buf[32];
+
+  memset(buf, 0, sizeof(buf));
+  ASSERT_EQ(0x8a9136aau, crc32c::Value(buf, sizeof(buf)));
+
+  memset(buf, 0xff, sizeof(buf));
+  ASSERT_EQ(0x62a8ab43u, crc32c::Value(buf, sizeof(buf)));
+
+  for (int i = 0; i < 32; i++) {
+    buf[i] = static_cast<char>(i);
+  }
+  ASSERT_EQ(0x46dd794eu, crc32c::Value(buf, sizeof(buf)));
+
+  for (int i = 0; i < 32; i++) {
+    buf[i] = static_cast<char>(31 - i);
+  }
+  ASSERT_EQ(0x113fdb5cu, crc32c::Value(buf, sizeof(buf)));
+
+  ASSERT_EQ(0xe3069283u, crc32c::Value("123456789", 9));
+}
+
+TEST(CRC32C, Extend) {
+  ASSERT_EQ(crc32c::Value("hello world", 11), crc32c::Extend(crc32c::Value("hello ", 6), "world", 5));
+}
+
+// This test verifies that the hardware implementation, if it's used, agrees with the
+// portable one at any length and alignment.
+TEST(CRC32C, HardwareMatchesPortable) {
+  LOG(INFO) << "hardware accelerated: " << crc32c::IsHardwareAccelerated();
+
+  Random rng(301);
+  std::string data = RandomString(4096, &rng);
+  for (size_t offset = 0; offset < 16; offset++) {
+    for (size_t n = 0; n + offset <= data.size(); n += 1 + n / 4) {
+      ASSERT_EQ(crc32c::ExtendPortable(0, data.data() + offset, n),
+                crc32c::Value(data.data() + offset, n));
+    }
+  }
+}
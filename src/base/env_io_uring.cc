@@ -0,0 +1,734 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/env.h"
+#include "base/errno.h"
+#include "base/logging.h"
+#include "base/port.h"
+
+#if defined(CONSENSUS_HAVE_IO_URING)
+
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <fmt/format.h>
+
+#endif
+
+namespace consensus {
+
+#if defined(CONSENSUS_HAVE_IO_URING)
+
+namespace {
+
+Status IOError(const Slice& fname, int err_number) {
+  return Status::Make(Error::IOError, fname) << ": " << ErrnoToString(err_number);
+}
+
+// A minimal io_uring, set up via raw syscalls. Not-Thread-Safe.
+class Ring {
+ public:
+  Ring() = default;
+
+  ~Ring() {
+    if (sqes_) {
+      munmap(sqes_, sqesSize_);
+    }
+    if (cqPtr_ && cqPtr_ != sqPtr_) {
+      munmap(cqPtr_, cqSize_);
+    }
+    if (sqPtr_) {
+      munmap(sqPtr_, sqSize_);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  Status Init(unsigned entries) {
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+    if (fd_ < 0) {
+      return IOError("io_uring_setup", errno);
+    }
+
+    sqSize_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqSize_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+      sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+    }
+
+    sqPtr_ = mmapRing(sqSize_, IORING_OFF_SQ_RING);
+    if (!sqPtr_) {
+      return IOError("mmap io_uring sq", errno);
+    }
+    cqPtr_ = singleMmap ? sqPtr_ : mmapRing(cqSize_, IORING_OFF_CQ_RING);
+    if (!cqPtr_) {
+      return IOError("mmap io_uring cq", errno);
+    }
+    sqesSize_ = p.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(mmapRing(sqesSize_, IORING_OFF_SQES));
+    if (!sqes_) {
+      return IOError("mmap io_uring sqes", errno);
+    }
+
+    char* sq = static_cast<char*>(sqPtr_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    sqEntries_ = p.sq_entries;
+
+    char* cq = static_cast<char*>(cqPtr_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+    return Status::OK();
+  }
+
+  // Returns a zeroed sqe for the next submission, or nullptr if the queue is full.
+  io_uring_sqe* GetSqe() {
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    if (sqeTail_ - head >= sqEntries_) {
+      return nullptr;
+    }
+    io_uring_sqe* sqe = &sqes_[sqeTail_ & sqMask_];
+    sqeTail_++;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+  }
+
+  unsigned Capacity() const {
+    return sqEntries_;
+  }
+
+  // Submit the sqes retrieved so far, and wait for `n` completions, which are
+  // passed to `fn(user_data, res)`.
+  template <typename Fn>
+  Status SubmitAndWait(unsigned n, Fn&& fn) {
+    unsigned tail = *sqTail_;
+    unsigned toSubmit = sqeTail_ - sqeHead_;
+    for (; sqeHead_ != sqeTail_; sqeHead_++, tail++) {
+      sqArray_[tail & sqMask_] = sqeHead_ & sqMask_;
+    }
+    __atomic_store_n(sqTail_, tail, __ATOMIC_RELEASE);
+
+    unsigned completed = 0;
+    while (completed < n) {
+      int ret = static_cast<int>(syscall(__NR_io_uring_enter, fd_, toSubmit, n - completed,
+                                         IORING_ENTER_GETEVENTS, nullptr, 0));
+      if (ret < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return IOError("io_uring_enter", errno);
+      }
+      toSubmit -= std::min(toSubmit, static_cast<unsigned>(ret));
+
+      unsigned head = *cqHead_;
+      unsigned cqTail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+      for (; head != cqTail; head++) {
+        const io_uring_cqe& cqe = cqes_[head & cqMask_];
+        fn(cqe.user_data, cqe.res);
+        completed++;
+      }
+      __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    }
+    return Status::OK();
+  }
+
+ private:
+  void* mmapRing(size_t size, off_t offset) {
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+    return p == MAP_FAILED ? nullptr : p;
+  }
+
+ private:
+  int fd_{-1};
+
+  void* sqPtr_{nullptr};
+  void* cqPtr_{nullptr};
+  size_t sqSize_{0};
+  size_t cqSize_{0};
+  io_uring_sqe* sqes_{nullptr};
+  size_t sqesSize_{0};
+
+  unsigned* sqHead_{nullptr};
+  unsigned* sqTail_{nullptr};
+  unsigned* sqArray_{nullptr};
+  unsigned sqMask_{0};
+  unsigned sqEntries_{0};
+
+  // sqes retrieved by GetSqe in [sqeHead_, sqeTail_) are not submitted yet.
+  unsigned sqeHead_{0};
+  unsigned sqeTail_{0};
+
+  unsigned* cqHead_{nullptr};
+  unsigned* cqTail_{nullptr};
+  unsigned cqMask_{0};
+  io_uring_cqe* cqes_{nullptr};
+};
+
+constexpr unsigned kRingEntries = 64;
+
+Status pwriteFully(int fd, const char* src, size_t left, uint64_t offset, const Slice& fname) {
+  while (left != 0) {
+    ssize_t done = pwrite(fd, src, left, static_cast<off_t>(offset));
+    if (done < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return IOError(fname, errno);
+    }
+    left -= done;
+    offset += done;
+    src += done;
+  }
+  return Status::OK();
+}
+
+// Writes are submitted as writev's at explicit offsets, which are waited for before
+// returning. A sync is submitted to a separate ring, so that it can be issued
+// concurrently with writes.
+class IoUringWritableFile : public WritableFile {
+ private:
+  struct Write;
+
+ public:
+  IoUringWritableFile(const Slice& fname, int fd, uint64_t file_size, bool sync_on_close,
+                      uint64_t pre_allocated_size)
+      : filename_(fname.ToString()),
+        fd_(fd),
+        sync_on_close_(sync_on_close),
+        filesize_(file_size),
+        pre_allocated_size_(pre_allocated_size),
+        pending_sync_(false) {}
+
+  ~IoUringWritableFile() {
+    if (fd_ >= 0) {
+      WARN_NOT_OK(Close(), "Failed to close " + filename_);
+    }
+  }
+
+  Status Init() {
+    RETURN_NOT_OK(writeRing_.Init(kRingEntries));
+    return syncRing_.Init(1);
+  }
+
+  Status Append(const Slice& data) override {
+    return AppendV(&data, 1);
+  }
+
+  Status AppendV(const Slice* data, size_t cnt) override {
+    return submitWrites(data, cnt, false);
+  }
+
+  Status AppendVAndSync(const Slice* data, size_t cnt) override {
+    return submitWrites(data, cnt, true);
+  }
+
+  Status PreAllocate(uint64_t size) override {
+    uint64_t offset = std::max(filesize_, pre_allocated_size_);
+    int ret;
+    do {
+      ret = fallocate(fd_, 0, static_cast<off_t>(offset), static_cast<off_t>(size));
+    } while (ret != 0 && errno == EINTR);
+    if (ret != 0) {
+      if (errno == EOPNOTSUPP) {
+        return Status::Make(Error::NotSupported, filename_) << ": fallocate is not supported";
+      }
+      return IOError(filename_, errno);
+    }
+    pre_allocated_size_ = offset + size;
+    pending_sync_ = true;
+    return Status::OK();
+  }
+
+  Status Truncate(uint64_t size) override {
+    if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+      return IOError(filename_, errno);
+    }
+    filesize_ = size;
+    pending_sync_ = true;
+    return Status::OK();
+  }
+
+  Status Close() override {
+    Status s;
+    if (filesize_ < pre_allocated_size_ && ftruncate(fd_, filesize_) != 0) {
+      s = IOError(filename_, errno);
+    }
+    if (sync_on_close_) {
+      Status sync_status = Sync();
+      if (!sync_status.IsOK() && s.IsOK()) {
+        s = sync_status;
+      }
+    }
+    if (close(fd_) < 0 && s.IsOK()) {
+      s = IOError(filename_, errno);
+    }
+    fd_ = -1;
+    return s;
+  }
+
+  Status Flush(FlushMode mode) override {
+    unsigned int flags = SYNC_FILE_RANGE_WRITE;
+    if (mode == FLUSH_SYNC) {
+      flags |= SYNC_FILE_RANGE_WAIT_BEFORE;
+      flags |= SYNC_FILE_RANGE_WAIT_AFTER;
+    }
+    if (sync_file_range(fd_, 0, 0, flags) < 0) {
+      return IOError(filename_, errno);
+    }
+    return Status::OK();
+  }
+
+  Status Sync() override {
+    if (!pending_sync_.exchange(false)) {
+      return Status::OK();
+    }
+
+    std::lock_guard<std::mutex> g(syncMu_);
+    io_uring_sqe* sqe = syncRing_.GetSqe();
+    prepFsync(sqe);
+
+    int res = 0;
+    RETURN_NOT_OK(syncRing_.SubmitAndWait(1, [&](uint64_t, int r) { res = r; }));
+    if (res < 0) {
+      return IOError(filename_, -res);
+    }
+    return Status::OK();
+  }
+
+  uint64_t Size() const override {
+    return filesize_;
+  }
+
+  const std::string& filename() const override {
+    return filename_;
+  }
+
+ private:
+  void prepFsync(io_uring_sqe* sqe) {
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->fd = fd_;
+    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+  }
+
+  // Submit the data as writev's of at most IOV_MAX buffers each at once,
+  // followed by an fdatasync linked after them if `sync` is true.
+  Status submitWrites(const Slice* data, size_t cnt, bool sync) {
+    iovecs_.resize(cnt);
+    size_t total = 0;
+    for (size_t i = 0; i < cnt; i++) {
+      iovecs_[i].iov_base = const_cast<char*>(data[i].data());
+      iovecs_[i].iov_len = data[i].size();
+      total += data[i].size();
+    }
+
+    writes_.clear();
+    uint64_t offset = filesize_;
+    for (size_t i = 0; i < cnt;) {
+      Write w{i, std::min(cnt, i + IOV_MAX), offset, 0};
+      for (size_t j = w.begin; j < w.end; j++) {
+        w.len += iovecs_[j].iov_len;
+      }
+      offset += w.len;
+      i = w.end;
+      writes_.push_back(w);
+    }
+
+    // Chains longer than the ring are written without linking, and synced afterwards.
+    bool linkSync = sync && writes_.size() + 1 <= writeRing_.Capacity();
+
+    std::vector<int> results(writes_.size(), 0);
+    int syncResult = 0;
+    for (size_t submitted = 0; submitted < writes_.size();) {
+      size_t n = std::min<size_t>(writes_.size() - submitted, writeRing_.Capacity() - 1);
+      for (size_t i = submitted; i < submitted + n; i++) {
+        io_uring_sqe* sqe = writeRing_.GetSqe();
+        DCHECK(sqe != nullptr);
+        sqe->opcode = IORING_OP_WRITEV;
+        sqe->fd = fd_;
+        sqe->off = writes_[i].offset;
+        sqe->addr = reinterpret_cast<uint64_t>(&iovecs_[writes_[i].begin]);
+        sqe->len = static_cast<uint32_t>(writes_[i].end - writes_[i].begin);
+        sqe->user_data = i;
+        if (linkSync) {
+          sqe->flags |= IOSQE_IO_LINK;
+        }
+      }
+      unsigned wait = static_cast<unsigned>(n);
+      if (linkSync) {
+        io_uring_sqe* sqe = writeRing_.GetSqe();
+        prepFsync(sqe);
+        sqe->user_data = UINT64_MAX;
+        wait++;
+      }
+
+      RETURN_NOT_OK(writeRing_.SubmitAndWait(wait, [&](uint64_t id, int res) {
+        if (id == UINT64_MAX) {
+          syncResult = res;
+        } else {
+          results[id] = res;
+        }
+      }));
+      submitted += n;
+    }
+
+    // complete the short writes synchronously, including the ones cancelled
+    // because of a broken link.
+    bool rewritten = false;
+    for (size_t i = 0; i < writes_.size(); i++) {
+      const Write& w = writes_[i];
+      int res = results[i];
+      if (res < 0 && res != -ECANCELED) {
+        return IOError(filename_, -res);
+      }
+      size_t done = res < 0 ? 0 : static_cast<size_t>(res);
+      if (done == w.len) {
+        continue;
+      }
+      rewritten = true;
+
+      uint64_t off = w.offset;
+      for (size_t j = w.begin; j < w.end; j++) {
+        const iovec& iov = iovecs_[j];
+        size_t skip = std::min(done, iov.iov_len);
+        done -= skip;
+        RETURN_NOT_OK(pwriteFully(fd_, static_cast<const char*>(iov.iov_base) + skip,
+                                  iov.iov_len - skip, off + skip, filename_));
+        off += iov.iov_len;
+      }
+    }
+    filesize_ += total;
+    pending_sync_ = true;
+
+    if (sync) {
+      if (linkSync && !rewritten && syncResult >= 0) {
+        pending_sync_ = false;
+        return Status::OK();
+      }
+      return Sync();
+    }
+    return Status::OK();
+  }
+
+ private:
+  const std::string filename_;
+  int fd_;
+  bool sync_on_close_;
+  uint64_t filesize_;
+  uint64_t pre_allocated_size_;
+  std::atomic<bool> pending_sync_;
+
+  // A writev of iovecs_[begin, end) at `offset`.
+  struct Write {
+    size_t begin, end;
+    uint64_t offset;
+    size_t len;
+  };
+
+  Ring writeRing_;
+  std::vector<iovec> iovecs_;
+  std::vector<Write> writes_;
+
+  Ring syncRing_;
+  std::mutex syncMu_;
+};
+
+class IoUringRandomAccessFile : public RandomAccessFile {
+ public:
+  IoUringRandomAccessFile(const Slice& fname, int fd, uint64_t size)
+      : filename_(fname.ToString()), fd_(fd), size_(size) {}
+
+  ~IoUringRandomAccessFile() {
+    close(fd_);
+  }
+
+  Status Read(uint64_t offset, size_t n, Slice* result, char* scratch) const override {
+    return preadFully(fd_, offset, n, result, scratch, filename_);
+  }
+
+  StatusWith<uint64_t> Size() const override {
+    return size_;
+  }
+
+  Status Advise(AccessPattern pattern, uint64_t offset, uint64_t len) const override {
+    static const int kAdvice[] = {POSIX_FADV_NORMAL, POSIX_FADV_SEQUENTIAL, POSIX_FADV_WILLNEED,
+                                  POSIX_FADV_DONTNEED};
+    // posix_fadvise returns the error rather than setting errno.
+    int err = posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(len),
+                            kAdvice[pattern]);
+    return err == 0 ? Status::OK() : IOError(filename_, err);
+  }
+
+  const std::string& filename() const override {
+    return filename_;
+  }
+
+  int fd() const {
+    return fd_;
+  }
+
+  // Reads until n bytes or EOF.
+  static Status preadFully(int fd, uint64_t offset, size_t n, Slice* result, char* scratch,
+                           const Slice& fname) {
+    size_t done = 0;
+    while (done < n) {
+      ssize_t r = pread(fd, scratch + done, n - done, static_cast<off_t>(offset + done));
+      if (r < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        *result = Slice(scratch, done);
+        return IOError(fname, errno);
+      }
+      if (r == 0) {
+        break;
+      }
+      done += r;
+    }
+    *result = Slice(scratch, done);
+    return Status::OK();
+  }
+
+ private:
+  std::string filename_;
+  int fd_;
+  const uint64_t size_;
+};
+
+StatusWith<int> doOpen(const Slice& fname, Env::CreateMode mode) {
+  int flags = O_RDWR;
+  switch (mode) {
+    case Env::CREATE_IF_NON_EXISTING_TRUNCATE:
+      flags |= O_CREAT | O_TRUNC;
+      break;
+    case Env::CREATE_NON_EXISTING:
+      flags |= O_CREAT | O_EXCL;
+      break;
+    case Env::OPEN_EXISTING:
+      break;
+    default:
+      return Status::Make(Error::NotSupported, fmt::format("Unknown create mode {}", mode));
+  }
+  int fd = open(fname.data(), flags, 0666);
+  if (fd < 0) {
+    return IOError(fname, errno);
+  }
+  return fd;
+}
+
+// Files are read and written through io_uring, the remaining operations are
+// delegated to the default env, so are files opened for direct I/O, which are
+// written via PositionedAppend.
+class IoUringEnv final : public Env {
+ public:
+  IoUringEnv() : base_(Env::Default()) {}
+
+  Status Init() {
+    return readRing_.Init(kRingEntries);
+  }
+
+  StatusWith<WritableFile*> NewWritableFile(const Slice& fname,
+                                            CreateMode mode = CREATE_IF_NON_EXISTING_TRUNCATE,
+                                            bool sync_on_close = false,
+                                            bool use_direct_io = false) override {
+    if (use_direct_io) {
+      return base_->NewWritableFile(fname, mode, sync_on_close, use_direct_io);
+    }
+
+    uint64_t file_size = 0;
+    if (mode == OPEN_EXISTING) {
+      ASSIGN_IF_OK(GetFileSize(fname), file_size);
+    }
+
+    int fd;
+    ASSIGN_IF_OK(doOpen(fname, mode), fd);
+    return newWritableFile(fname, fd, file_size, sync_on_close, 0);
+  }
+
+  StatusWith<WritableFile*> ReuseWritableFile(const Slice& fname, const Slice& oldFname,
+                                              bool use_direct_io = false) override {
+    if (use_direct_io) {
+      return base_->ReuseWritableFile(fname, oldFname, use_direct_io);
+    }
+
+    RETURN_NOT_OK(RenameFile(oldFname, fname));
+
+    uint64_t file_size;
+    ASSIGN_IF_OK(GetFileSize(fname), file_size);
+
+    int fd;
+    ASSIGN_IF_OK(doOpen(fname, OPEN_EXISTING), fd);
+    return newWritableFile(fname, fd, 0, false, file_size);
+  }
+
+  StatusWith<RandomAccessFile*> NewRandomAccessFile(const Slice& fname) override {
+    int fd = open(fname.data(), O_RDONLY);
+    if (fd < 0) {
+      return IOError(fname, errno);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      Status s = IOError(fname, errno);
+      close(fd);
+      return s;
+    }
+    return new IoUringRandomAccessFile(fname, fd, static_cast<uint64_t>(st.st_size));
+  }
+
+  // Keep up to kRingEntries reads in flight. Files not opened by this env are
+  // read synchronously.
+  Status MultiRead(ReadRequest* reqs, size_t n) override {
+    std::lock_guard<std::mutex> g(readMu_);
+
+    std::vector<iovec> iovecs(n);
+    for (size_t i = 0; i < n;) {
+      unsigned inflight = 0;
+      for (; i < n && inflight < readRing_.Capacity(); i++) {
+        ReadRequest& req = reqs[i];
+        auto file = dynamic_cast<IoUringRandomAccessFile*>(req.file);
+        if (!file) {
+          req.status = req.file->Read(req.offset, req.len, &req.result, req.scratch);
+          continue;
+        }
+
+        iovecs[i].iov_base = req.scratch;
+        iovecs[i].iov_len = req.len;
+        io_uring_sqe* sqe = readRing_.GetSqe();
+        DCHECK(sqe != nullptr);
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = file->fd();
+        sqe->off = req.offset;
+        sqe->addr = reinterpret_cast<uint64_t>(&iovecs[i]);
+        sqe->len = 1;
+        sqe->user_data = i;
+        inflight++;
+      }
+
+      RETURN_NOT_OK(readRing_.SubmitAndWait(inflight, [&](uint64_t id, int res) {
+        ReadRequest& req = reqs[id];
+        if (res < 0) {
+          req.result = Slice();
+          req.status = IOError(req.file->filename(), -res);
+          return;
+        }
+
+        size_t done = static_cast<size_t>(res);
+        req.status = Status::OK();
+        req.result = Slice(req.scratch, done);
+        if (done < req.len && done > 0) {
+          // a short read may be followed by more data, read the remaining
+          // bytes synchronously until EOF.
+          Slice rest;
+          auto file = static_cast<IoUringRandomAccessFile*>(req.file);
+          req.status = IoUringRandomAccessFile::preadFully(file->fd(), req.offset + done,
+                                                           req.len - done, &rest,
+                                                           req.scratch + done, file->filename());
+          req.result = Slice(req.scratch, done + rest.size());
+        }
+      }));
+    }
+    return Status::OK();
+  }
+
+  StatusWith<uint64_t> GetFileSize(const Slice& fname) override {
+    return base_->GetFileSize(fname);
+  }
+
+  Status CreateDir(const Slice& dirname) override {
+    return base_->CreateDir(dirname);
+  }
+
+  Status CreateDirIfMissing(const Slice& dirname) override {
+    return base_->CreateDirIfMissing(dirname);
+  }
+
+  Status DeleteRecursively(const Slice& name) override {
+    return base_->DeleteRecursively(name);
+  }
+
+  Status DeleteFile(const Slice& fname) override {
+    return base_->DeleteFile(fname);
+  }
+
+  Status RenameFile(const Slice& src, const Slice& target) override {
+    return base_->RenameFile(src, target);
+  }
+
+  Status SyncDir(const Slice& dirname) override {
+    return base_->SyncDir(dirname);
+  }
+
+  Status GetChildren(const std::string& dir, std::vector<std::string>* result) override {
+    return base_->GetChildren(dir, result);
+  }
+
+ private:
+  StatusWith<WritableFile*> newWritableFile(const Slice& fname, int fd, uint64_t file_size,
+                                            bool sync_on_close, uint64_t pre_allocated_size) {
+    std::unique_ptr<IoUringWritableFile> f(
+        new IoUringWritableFile(fname, fd, file_size, sync_on_close, pre_allocated_size));
+    RETURN_NOT_OK(f->Init());
+    return f.release();
+  }
+
+ private:
+  Env* base_;
+
+  std::mutex readMu_;
+  Ring readRing_;
+};
+
+StatusWith<Env*> newIoUringEnv() {
+  std::unique_ptr<IoUringEnv> env(new IoUringEnv());
+  Status s = env->Init();
+  if (!s.IsOK()) {
+    return Status::Make(Error::NotSupported, "io_uring is unavailable: ") << s.ToString();
+  }
+  return env.release();
+}
+
+}  // namespace
+
+StatusWith<Env*> Env::IoUring() {
+  static StatusWith<Env*> env = newIoUringEnv();
+  return env;
+}
+
+#else
+
+StatusWith<Env*> Env::IoUring() {
+  return Status::Make(Error::NotSupported, "consensus is built without io_uring");
+}
+
+#endif  // CONSENSUS_HAVE_IO_URING
+
+}  // namespace consensus
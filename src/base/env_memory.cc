@@ -0,0 +1,375 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+
+#include "base/env.h"
+
+#include <fmt/format.h>
+
+namespace consensus {
+
+namespace {
+
+struct MemFile {
+  mutable std::mutex mu;
+  std::string data;
+};
+
+typedef std::shared_ptr<MemFile> MemFilePtr;
+
+// Spends the latencies drawn from the distributions of MemoryEnvOptions.
+class LatencyInjector {
+ public:
+  explicit LatencyInjector(const MemoryEnvOptions& options)
+      : options_(options), rng_(options.seed) {}
+
+  void Append() {
+    spend(options_.append_latency);
+  }
+
+  void Sync() {
+    spend(options_.sync_latency);
+  }
+
+ private:
+  void spend(const LatencyDistribution& dist) {
+    if (dist.kind == LatencyDistribution::kNone) {
+      return;
+    }
+    double us = draw(dist);
+    if (us <= 0) {
+      return;
+    }
+
+    // sleeping overshoots by tens of microseconds, the short latencies are spun.
+    auto end = std::chrono::steady_clock::now() +
+               std::chrono::nanoseconds(static_cast<int64_t>(us * 1000));
+    if (us >= kSleepThresholdUs) {
+      std::this_thread::sleep_until(end);
+    }
+    while (std::chrono::steady_clock::now() < end) {
+    }
+  }
+
+  double draw(const LatencyDistribution& dist) {
+    std::lock_guard<std::mutex> g(mu_);
+    switch (dist.kind) {
+      case LatencyDistribution::kFixed:
+        return dist.a;
+      case LatencyDistribution::kUniform:
+        return std::uniform_real_distribution<double>(dist.a, dist.b)(rng_);
+      case LatencyDistribution::kLogNormal:
+        return std::lognormal_distribution<double>(std::log(dist.a), dist.b)(rng_);
+      default:
+        return 0;
+    }
+  }
+
+ private:
+  static constexpr double kSleepThresholdUs = 100;
+
+  const MemoryEnvOptions options_;
+  std::mutex mu_;
+  std::mt19937_64 rng_;
+};
+
+class MemWritableFile : public WritableFile {
+ public:
+  // `latency` can be null if no latency is injected.
+  MemWritableFile(const Slice& fname, MemFilePtr file, LatencyInjector* latency)
+      : filename_(fname.ToString()), file_(std::move(file)), latency_(latency) {}
+
+  Status Append(const Slice& data) override {
+    return AppendV(&data, 1);
+  }
+
+  Status AppendV(const Slice* data, size_t cnt) override {
+    if (latency_) {
+      latency_->Append();
+    }
+    std::lock_guard<std::mutex> g(file_->mu);
+    for (size_t i = 0; i < cnt; i++) {
+      file_->data.append(data[i].data(), data[i].size());
+    }
+    return Status::OK();
+  }
+
+  Status PreAllocate(uint64_t size) override {
+    return Status::OK();
+  }
+
+  Status Truncate(uint64_t size) override {
+    std::lock_guard<std::mutex> g(file_->mu);
+    file_->data.resize(size);
+    return Status::OK();
+  }
+
+  Status Close() override {
+    return Status::OK();
+  }
+
+  Status Flush(FlushMode mode) override {
+    return Status::OK();
+  }
+
+  Status Sync() override {
+    if (latency_) {
+      latency_->Sync();
+    }
+    return Status::OK();
+  }
+
+  uint64_t Size() const override {
+    std::lock_guard<std::mutex> g(file_->mu);
+    return file_->data.size();
+  }
+
+  const std::string& filename() const override {
+    return filename_;
+  }
+
+ private:
+  std::string filename_;
+  MemFilePtr file_;
+  LatencyInjector* latency_;
+};
+
+class MemRandomAccessFile : public RandomAccessFile {
+ public:
+  MemRandomAccessFile(const Slice& fname, MemFilePtr file)
+      : filename_(fname.ToString()), file_(std::move(file)) {}
+
+  Status Read(uint64_t offset, size_t n, Slice* result, char* scratch) const override {
+    std::lock_guard<std::mutex> g(file_->mu);
+    size_t size = file_->data.size();
+    n = offset < size ? std::min<size_t>(n, size - offset) : 0;
+    memcpy(scratch, file_->data.data() + offset, n);
+    *result = Slice(scratch, n);
+    return Status::OK();
+  }
+
+  StatusWith<uint64_t> Size() const override {
+    std::lock_guard<std::mutex> g(file_->mu);
+    return static_cast<uint64_t>(file_->data.size());
+  }
+
+  const std::string& filename() const override {
+    return filename_;
+  }
+
+ private:
+  std::string filename_;
+  MemFilePtr file_;
+};
+
+// The paths are matched as they are, except that the trailing slashes are dropped.
+class MemoryEnv final : public Env {
+ public:
+  MemoryEnv() = default;
+
+  explicit MemoryEnv(const MemoryEnvOptions& options) : latency_(new LatencyInjector(options)) {}
+
+  StatusWith<WritableFile*> NewWritableFile(const Slice& fname,
+                                            CreateMode mode = CREATE_IF_NON_EXISTING_TRUNCATE,
+                                            bool sync_on_close = false,
+                                            bool use_direct_io = false) override {
+    std::string name = normalize(fname);
+    std::lock_guard<std::mutex> g(mu_);
+    auto it = files_.find(name);
+    if (it == files_.end()) {
+      if (mode == OPEN_EXISTING) {
+        return notFound(name);
+      }
+      it = files_.emplace(name, std::make_shared<MemFile>()).first;
+    } else if (mode == CREATE_NON_EXISTING) {
+      return FMT_Status(IOError, "{}: file exists", name);
+    } else if (mode == CREATE_IF_NON_EXISTING_TRUNCATE) {
+      std::lock_guard<std::mutex> fg(it->second->mu);
+      it->second->data.clear();
+    }
+    return new MemWritableFile(name, it->second, latency_.get());
+  }
+
+  // There's no disk space to reuse, the original content is dropped.
+  StatusWith<WritableFile*> ReuseWritableFile(const Slice& fname, const Slice& oldFname,
+                                              bool use_direct_io = false) override {
+    RETURN_NOT_OK(RenameFile(oldFname, fname));
+    return NewWritableFile(fname);
+  }
+
+  StatusWith<RandomAccessFile*> NewRandomAccessFile(const Slice& fname) override {
+    std::string name = normalize(fname);
+    std::lock_guard<std::mutex> g(mu_);
+    auto it = files_.find(name);
+    if (it == files_.end()) {
+      return notFound(name);
+    }
+    return new MemRandomAccessFile(name, it->second);
+  }
+
+  StatusWith<uint64_t> GetFileSize(const Slice& fname) override {
+    std::string name = normalize(fname);
+    std::lock_guard<std::mutex> g(mu_);
+    auto it = files_.find(name);
+    if (it == files_.end()) {
+      return notFound(name);
+    }
+    std::lock_guard<std::mutex> fg(it->second->mu);
+    return static_cast<uint64_t>(it->second->data.size());
+  }
+
+  Status CreateDir(const Slice& dirname) override {
+    std::lock_guard<std::mutex> g(mu_);
+    if (!dirs_.insert(normalize(dirname)).second) {
+      return FMT_Status(IOError, "{}: directory exists", dirname.ToString());
+    }
+    return Status::OK();
+  }
+
+  Status CreateDirIfMissing(const Slice& dirname) override {
+    std::string name = normalize(dirname);
+    std::lock_guard<std::mutex> g(mu_);
+    // the parents are created as well.
+    for (size_t pos = name.find('/', 1); pos != std::string::npos; pos = name.find('/', pos + 1)) {
+      dirs_.insert(name.substr(0, pos));
+    }
+    dirs_.insert(name);
+    return Status::OK();
+  }
+
+  Status DeleteRecursively(const Slice& name) override {
+    std::string path = normalize(name);
+    std::string prefix = path + "/";
+    std::lock_guard<std::mutex> g(mu_);
+    eraseUnder(&files_, path, prefix);
+    eraseUnder(&dirs_, path, prefix);
+    return Status::OK();
+  }
+
+  Status DeleteFile(const Slice& fname) override {
+    std::string name = normalize(fname);
+    std::lock_guard<std::mutex> g(mu_);
+    if (files_.erase(name) == 0) {
+      return notFound(name);
+    }
+    return Status::OK();
+  }
+
+  Status RenameFile(const Slice& src, const Slice& target) override {
+    std::string from = normalize(src);
+    std::lock_guard<std::mutex> g(mu_);
+    auto it = files_.find(from);
+    if (it == files_.end()) {
+      return notFound(from);
+    }
+    MemFilePtr file = it->second;
+    files_.erase(it);
+    files_[normalize(target)] = std::move(file);
+    return Status::OK();
+  }
+
+  // The directories are never lost in memory.
+  Status SyncDir(const Slice& dirname) override {
+    return Status::OK();
+  }
+
+  Status GetChildren(const std::string& dir, std::vector<std::string>* result) override {
+    std::string path = normalize(dir);
+    std::string prefix = path == "/" ? path : path + "/";
+    std::lock_guard<std::mutex> g(mu_);
+    if (path != "/" && dirs_.find(path) == dirs_.end()) {
+      return notFound(path);
+    }
+    result->clear();
+    collectChildren(files_, prefix, result);
+    collectChildren(dirs_, prefix, result);
+    return Status::OK();
+  }
+
+ private:
+  static std::string normalize(const Slice& path) {
+    std::string p = path.ToString();
+    while (p.size() > 1 && p.back() == '/') {
+      p.pop_back();
+    }
+    return p;
+  }
+
+  static Status notFound(const std::string& name) {
+    return FMT_Status(NotFound, "{}: no such file or directory", name);
+  }
+
+  // Erases `path` and everything under it from `c`, whose keys are paths.
+  template <class Container>
+  static void eraseUnder(Container* c, const std::string& path, const std::string& prefix) {
+    c->erase(path);
+    auto it = c->lower_bound(prefix);
+    while (it != c->end() && keyOf(*it).compare(0, prefix.size(), prefix) == 0) {
+      it = c->erase(it);
+    }
+  }
+
+  // Collects the names of the direct children under `prefix` in `c`.
+  template <class Container>
+  static void collectChildren(const Container& c, const std::string& prefix,
+                              std::vector<std::string>* result) {
+    for (auto it = c.lower_bound(prefix);
+         it != c.end() && keyOf(*it).compare(0, prefix.size(), prefix) == 0; ++it) {
+      std::string name = keyOf(*it).substr(prefix.size());
+      if (name.find('/') == std::string::npos) {
+        result->push_back(std::move(name));
+      }
+    }
+  }
+
+  static const std::string& keyOf(const std::string& path) {
+    return path;
+  }
+
+  static const std::string& keyOf(const std::pair<const std::string, MemFilePtr>& file) {
+    return file.first;
+  }
+
+ private:
+  std::mutex mu_;
+  std::map<std::string, MemFilePtr> files_;
+  std::set<std::string> dirs_;
+
+  // null if no latency is injected. The files refer to it, they must not outlive
+  // the environment.
+  std::unique_ptr<LatencyInjector> latency_;
+};
+
+}  // namespace
+
+Env* Env::Memory() {
+  static MemoryEnv* env = new MemoryEnv();
+  return env;
+}
+
+Env* Env::NewMemory(const MemoryEnvOptions& options) {
+  return new MemoryEnv(options);
+}
+
+}  // namespace consensus
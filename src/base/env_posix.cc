@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
 #include <fcntl.h>
 #include <limits.h>
 #include <mutex>
@@ -59,8 +61,18 @@ static Status DoSync(int fd, const Slice& filename) {
   return Status::OK();
 }
 
-static StatusWith<int> DoOpen(const Slice& filename, Env::CreateMode mode) {
+static StatusWith<int> DoOpen(const Slice& filename, Env::CreateMode mode,
+                              bool use_direct_io = false) {
   int flags = O_RDWR;
+#if defined(__linux__)
+  if (use_direct_io) {
+    flags |= O_DIRECT;
+  }
+#else
+  if (use_direct_io) {
+    return Status::Make(Error::NotSupported, "direct I/O is not supported");
+  }
+#endif
   switch (mode) {
     case Env::CREATE_IF_NON_EXISTING_TRUNCATE:
       flags |= O_CREAT | O_TRUNC;
@@ -87,6 +99,21 @@ StatusWith<uint64_t> DoGetFileSize(const Slice& fname) {
   return fsize;
 }
 
+static Status DoAdvise(int fd, const Slice& fname, RandomAccessFile::AccessPattern pattern,
+                       uint64_t offset, uint64_t len) {
+#if defined(__linux__)
+  static const int kAdvice[] = {POSIX_FADV_NORMAL, POSIX_FADV_SEQUENTIAL, POSIX_FADV_WILLNEED,
+                                POSIX_FADV_DONTNEED};
+  // posix_fadvise returns the error rather than setting errno.
+  int err = posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(len),
+                          kAdvice[pattern]);
+  if (err != 0) {
+    return FileIOError(fname, err);
+  }
+#endif
+  return Status::OK();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////
 
@@ -96,12 +123,14 @@ StatusWith<uint64_t> DoGetFileSize(const Slice& fname) {
 // order to further improve Sync() performance.
 class PosixWritableFile : public WritableFile {
  public:
-  PosixWritableFile(const Slice& fname, int fd, uint64_t file_size, bool sync_on_close)
+  PosixWritableFile(const Slice& fname, int fd, uint64_t file_size, bool sync_on_close,
+                    bool use_direct_io, uint64_t pre_allocated_size = 0)
       : filename_(fname.ToString()),
         fd_(fd),
         sync_on_close_(sync_on_close),
+        use_direct_io_(use_direct_io),
         filesize_(file_size),
-        pre_allocated_size_(0),
+        pre_allocated_size_(pre_allocated_size),
         pending_sync_(false) {}
 
   ~PosixWritableFile() {
@@ -125,11 +154,61 @@ class PosixWritableFile : public WritableFile {
       src += done;
     }
     filesize_ += data.size();
+    pending_sync_ = true;
+    return Status::OK();
+  }
+
+  Status AppendV(const Slice* data, size_t cnt) override {
+    size_t total = 0;
+    while (cnt > 0) {
+      // at most IOV_MAX buffers can be written at a time, plus we need to deal with
+      // partial writes.
+      struct iovec iov[IOV_MAX];
+      size_t n = std::min(cnt, static_cast<size_t>(IOV_MAX));
+      size_t bytes = 0;
+      for (size_t i = 0; i < n; i++) {
+        iov[i].iov_base = const_cast<char*>(data[i].data());
+        iov[i].iov_len = data[i].size();
+        bytes += data[i].size();
+      }
+
+      ssize_t done;
+      RETRY_ON_EINTR(done, writev(fd_, iov, static_cast<int>(n)));
+      if (done < 0) {
+        return FileIOError(filename_, errno);
+      }
+      total += done;
+
+      if (PREDICT_FALSE(static_cast<size_t>(done) < bytes)) {
+        // skip over the data that has been written, and fall back to
+        // Append for the remaining of the partially written slice.
+        size_t i = 0;
+        while (static_cast<size_t>(done) >= data[i].size()) {
+          done -= data[i].size();
+          i++;
+        }
+        Slice rest(data[i].data() + done, data[i].size() - done);
+        filesize_ += total;
+        total = 0;
+        RETURN_NOT_OK(Append(rest));
+        n = i + 1;
+      }
+
+      data += n;
+      cnt -= n;
+    }
+    filesize_ += total;
+    pending_sync_ = true;
     return Status::OK();
   }
 
   Status PositionedAppend(const Slice& data, uint64_t offset) override {
     DLOG_ASSERT(offset <= std::numeric_limits<off_t>::max());
+    if (use_direct_io_) {
+      DCHECK_EQ(offset % GetRequiredBufferAlignment(), 0);
+      DCHECK_EQ(data.size() % GetRequiredBufferAlignment(), 0);
+      DCHECK_EQ(reinterpret_cast<uintptr_t>(data.data()) % GetRequiredBufferAlignment(), 0);
+    }
     const char* src = data.data();
     size_t left = data.size();
     while (left != 0) {
@@ -145,9 +224,48 @@ class PosixWritableFile : public WritableFile {
       src += done;
     }
     filesize_ = offset;
+    pending_sync_ = true;
     return Status::OK();
   }
 
+  bool UseDirectIO() const override {
+    return use_direct_io_;
+  }
+
+  Status Truncate(uint64_t size) override {
+    int ret;
+    RETRY_ON_EINTR(ret, ftruncate(fd_, static_cast<off_t>(size)));
+    if (ret != 0) {
+      return FileIOError(filename_, errno);
+    }
+    // the following appends continue from the new end of file.
+    if (lseek(fd_, static_cast<off_t>(size), SEEK_SET) < 0) {
+      return FileIOError(filename_, errno);
+    }
+    filesize_ = size;
+    pending_sync_ = true;
+    return Status::OK();
+  }
+
+  Status PreAllocate(uint64_t size) override {
+#if defined(__linux__)
+    uint64_t offset = std::max(filesize_, pre_allocated_size_);
+    int ret;
+    RETRY_ON_EINTR(ret, fallocate(fd_, 0, static_cast<off_t>(offset), static_cast<off_t>(size)));
+    if (ret != 0) {
+      if (errno == EOPNOTSUPP) {
+        return Status::Make(Error::NotSupported, filename_) << ": fallocate is not supported";
+      }
+      return FileIOError(filename_, errno);
+    }
+    pre_allocated_size_ = offset + size;
+    pending_sync_ = true;
+    return Status::OK();
+#else
+    return Status::Make(Error::NotSupported);
+#endif
+  }
+
   Status Close() override {
     Status s;
 
@@ -201,8 +319,7 @@ class PosixWritableFile : public WritableFile {
   }
 
   Status Sync() override {
-    if (pending_sync_) {
-      pending_sync_ = false;
+    if (pending_sync_.exchange(false)) {
       RETURN_NOT_OK(DoSync(fd_, filename_));
     }
     return Status::OK();
@@ -220,9 +337,10 @@ class PosixWritableFile : public WritableFile {
   const std::string filename_;
   int fd_;
   bool sync_on_close_;
+  bool use_direct_io_;
   uint64_t filesize_;
   uint64_t pre_allocated_size_;
-  bool pending_sync_;
+  std::atomic<bool> pending_sync_;
 };
 
 // pread() based random-access
@@ -230,9 +348,12 @@ class PosixRandomAccessFile : public RandomAccessFile {
  private:
   std::string filename_;
   int fd_;
+  // taken at open, rather than stat-ing the path on every call.
+  uint64_t size_;
 
  public:
-  PosixRandomAccessFile(const Slice& fname, int fd) : filename_(fname.ToString()), fd_(fd) {}
+  PosixRandomAccessFile(const Slice& fname, int fd, uint64_t size)
+      : filename_(fname.ToString()), fd_(fd), size_(size) {}
   virtual ~PosixRandomAccessFile() {
     close(fd_);
   }
@@ -250,7 +371,11 @@ class PosixRandomAccessFile : public RandomAccessFile {
   }
 
   virtual StatusWith<uint64_t> Size() const override {
-    return DoGetFileSize(filename_);
+    return size_;
+  }
+
+  virtual Status Advise(AccessPattern pattern, uint64_t offset, uint64_t len) const override {
+    return DoAdvise(fd_, filename_, pattern, offset, len);
   }
 
   virtual const std::string& filename() const override {
@@ -265,16 +390,32 @@ class PosixEnv final : public Env {
 
   StatusWith<WritableFile*> NewWritableFile(const Slice& fname,
                                             CreateMode mode = CREATE_IF_NON_EXISTING_TRUNCATE,
-                                            bool sync_on_close = false) override {
+                                            bool sync_on_close = false,
+                                            bool use_direct_io = false) override {
     uint64_t file_size = 0;
     if (mode == OPEN_EXISTING) {
       ASSIGN_IF_OK(GetFileSize(fname), file_size);
     }
 
     int fd;
-    ASSIGN_IF_OK(DoOpen(fname, mode), fd);
+    ASSIGN_IF_OK(DoOpen(fname, mode, use_direct_io), fd);
 
-    return new PosixWritableFile(fname, fd, file_size, sync_on_close);
+    return new PosixWritableFile(fname, fd, file_size, sync_on_close, use_direct_io);
+  }
+
+  StatusWith<WritableFile*> ReuseWritableFile(const Slice& fname, const Slice& oldFname,
+                                              bool use_direct_io = false) override {
+    RETURN_NOT_OK(RenameFile(oldFname, fname));
+
+    uint64_t file_size;
+    ASSIGN_IF_OK(GetFileSize(fname), file_size);
+
+    int fd;
+    ASSIGN_IF_OK(DoOpen(fname, OPEN_EXISTING, use_direct_io), fd);
+
+    // treat the original content as pre-allocated space, which will be
+    // truncated if not being overwritten.
+    return new PosixWritableFile(fname, fd, 0, false, use_direct_io, file_size);
   }
 
   StatusWith<RandomAccessFile*> NewRandomAccessFile(const Slice& fname) override {
@@ -282,7 +423,13 @@ class PosixEnv final : public Env {
     if (fd < 0) {
       return FileIOError(fname, errno);
     }
-    return new PosixRandomAccessFile(fname, fd);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      Status s = FileIOError(fname, errno);
+      close(fd);
+      return s;
+    }
+    return new PosixRandomAccessFile(fname, fd, static_cast<uint64_t>(st.st_size));
   }
 
   StatusWith<uint64_t> GetFileSize(const Slice& fname) override {
@@ -317,6 +464,26 @@ class PosixEnv final : public Env {
     return Status::OK();
   }
 
+  Status RenameFile(const Slice& src, const Slice& target) override {
+    boost::system::error_code code;
+    boost::filesystem::rename(src.data(), target.data(), code);
+    RETURN_BOOST_EC(code);
+    return Status::OK();
+  }
+
+  Status SyncDir(const Slice& dirname) override {
+    int fd = open(dirname.data(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+      return FileIOError(dirname, errno);
+    }
+    Status s;
+    if (fsync(fd) < 0) {
+      s = FileIOError(dirname, errno);
+    }
+    close(fd);
+    return s;
+  }
+
   Status GetChildren(const std::string& dir, std::vector<std::string>* result) override {
     boost::system::error_code code;
     bool isDir = boost::filesystem::is_directory(dir, code);
@@ -17,6 +17,8 @@
 #include "base/random.h"
 #include "base/testing.h"
 
+#include <chrono>
+
 using namespace consensus;
 using namespace std;
 
@@ -29,7 +31,7 @@ class TestEnv : public BaseTest {
 
     unique_ptr<WritableFile> wf(OpenFileForWrite(kTestPath));
 
-    std::string slices;
+    vector<Slice> slices;
     LOG(INFO) << fmt::format(
         "appending a vector of slices(number of slices={}, size of slice={} b)", num_slices,
         slice_size);
@@ -38,10 +40,11 @@ class TestEnv : public BaseTest {
     RandomDataSet(num_slices, slice_size, &dataSet);
 
     for (int i = 0; i < num_slices; i++) {
-      slices += dataSet[i];
+      slices.push_back(dataSet[i]);
     }
 
-    ASSERT_OK(wf->Append(slices));
+    ASSERT_OK(wf->AppendV(slices.data(), slices.size()));
+    ASSERT_EQ(wf->Size(), num_slices * slice_size);
     ASSERT_OK(wf->Close());
 
     string testData;
@@ -57,6 +60,7 @@ class TestEnv : public BaseTest {
     Slice s;
     char* scratch;
     ASSERT_OK(env_util::ReadFullyToBuffer(filePath, &s, &scratch));
+    unique_ptr<char[]> g(scratch);
 
     ASSERT_EQ(s.ToString(), testData);
   }
@@ -88,9 +92,141 @@ TEST_F(TestEnv, ReadFully) {
   }
 }
 
+TEST_F(TestEnv, AdviseRandomAccessFile) {
+  TestDirGuard g(CreateTestDirGuard());
+  const string kTestPath = GetTestDir() + "/test_env_advise";
+
+  string testData;
+  WriteTestFile(kTestPath, 64 * 1024, &testData, &rng_);
+
+  RandomAccessFile* rf;
+  ASSIGN_IF_ASSERT_OK(Env::Default()->NewRandomAccessFile(kTestPath), rf);
+  unique_ptr<RandomAccessFile> reader(rf);
+  ASSERT_OK(rf->Advise(RandomAccessFile::SEQUENTIAL));
+  ASSERT_OK(rf->Advise(RandomAccessFile::WILL_NEED, 4096, 8192));
+
+  unique_ptr<char[]> scratch(new char[testData.size()]);
+  Slice result;
+  ASSERT_OK(env_util::ReadFully(rf, 0, testData.size(), &result, scratch.get()));
+  ASSERT_EQ(result.ToString(), testData);
+  ASSERT_OK(rf->Advise(RandomAccessFile::DONT_NEED));
+
+  // the size is taken at open.
+  uint64_t size;
+  ASSIGN_IF_ASSERT_OK(rf->Size(), size);
+  ASSERT_EQ(size, testData.size());
+}
+
 TEST_F(TestEnv, AppendVector) {
   TestDirGuard g(CreateTestDirGuard());
   TestAppendVector(2000, 1024);
+  TestAppendVector(1, 64 * 1024);
+}
+
+// This test verifies that preallocated space is truncated on close.
+TEST_F(TestEnv, PreAllocate) {
+  TestDirGuard g(CreateTestDirGuard());
+  const string kTestPath = GetTestDir() + "/test_env_preallocate";
+
+  unique_ptr<WritableFile> wf(OpenFileForWrite(kTestPath));
+  Status s = wf->PreAllocate(1024 * 1024);
+  if (s.Code() == Error::NotSupported) {
+    LOG(INFO) << "skipping test: " << s;
+    return;
+  }
+  ASSERT_OK(s);
+  ASSERT_EQ(wf->Size(), 0);
+
+  string testData = RandomString(4096, &rng_);
+  ASSERT_OK(wf->Append(testData));
+  ASSERT_EQ(wf->Size(), testData.size());
+  ASSERT_OK(wf->Close());
+
+  ReadAndVerifyTestData(kTestPath, testData);
+}
+
+// This test verifies that a reused file is overwritten from the beginning,
+// and truncated to the size written.
+TEST_F(TestEnv, ReuseWritableFile) {
+  TestDirGuard g(CreateTestDirGuard());
+  const string kOldPath = GetTestDir() + "/test_env_reuse_old";
+  const string kTestPath = GetTestDir() + "/test_env_reuse";
+
+  string oldData;
+  WriteTestFile(kOldPath, 64 * 1024, &oldData, &rng_);
+
+  WritableFile* wf;
+  ASSIGN_IF_ASSERT_OK(Env::Default()->ReuseWritableFile(kTestPath, kOldPath), wf);
+  unique_ptr<WritableFile> f(wf);
+  ASSERT_EQ(f->Size(), 0);
+
+  string testData = RandomString(1024, &rng_);
+  ASSERT_OK(f->Append(testData));
+  ASSERT_OK(f->Close());
+
+  ReadAndVerifyTestData(kTestPath, testData);
+  ASSERT_FALSE(Env::Default()->GetFileSize(kOldPath).IsOK());
+}
+
+// This test verifies that files written and synced via io_uring can be read
+// back, both directly and by MultiRead.
+TEST_F(TestEnv, IoUring) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  StatusWith<Env*> sw = Env::IoUring();
+  if (!sw.IsOK()) {
+    LOG(INFO) << "skipping test: " << sw.GetStatus();
+    return;
+  }
+  Env* env = sw.GetValue();
+
+  const int kFileNum = 8;
+  vector<string> files, dataSet;
+  for (int i = 0; i < kFileNum; i++) {
+    string fname = GetTestDir() + fmt::format("/test_env_io_uring_{}", i);
+
+    WritableFile* wf;
+    ASSIGN_IF_ASSERT_OK(env->NewWritableFile(fname), wf);
+    unique_ptr<WritableFile> f(wf);
+
+    vector<string> data;
+    RandomDataSet(2000, 64, &data);
+    vector<Slice> slices(data.begin(), data.end());
+    ASSERT_OK(f->AppendV(slices.data(), 1000));
+    ASSERT_OK(f->AppendVAndSync(slices.data() + 1000, 1000));
+    ASSERT_EQ(f->Size(), 2000 * 64);
+    ASSERT_OK(f->Close());
+
+    string testData;
+    for (string& d : data) {
+      testData += d;
+    }
+    ReadAndVerifyTestData(fname, testData);
+    files.push_back(fname);
+    dataSet.push_back(testData);
+  }
+
+  vector<unique_ptr<RandomAccessFile>> rfs;
+  vector<unique_ptr<char[]>> scratches;
+  vector<ReadRequest> reqs(kFileNum);
+  for (int i = 0; i < kFileNum; i++) {
+    RandomAccessFile* rf;
+    ASSIGN_IF_ASSERT_OK(env->NewRandomAccessFile(files[i]), rf);
+    rfs.emplace_back(rf);
+    scratches.emplace_back(new char[dataSet[i].size() + 1]);
+
+    // read one more byte than the file size
+    reqs[i].file = rf;
+    reqs[i].offset = 0;
+    reqs[i].len = dataSet[i].size() + 1;
+    reqs[i].scratch = scratches[i].get();
+  }
+
+  ASSERT_OK(env->MultiRead(reqs.data(), reqs.size()));
+  for (int i = 0; i < kFileNum; i++) {
+    ASSERT_OK(reqs[i].status);
+    ASSERT_EQ(reqs[i].result.ToString(), dataSet[i]);
+  }
 }
 
 TEST_F(TestEnv, GetChildren) {
@@ -115,4 +251,82 @@ TEST_F(TestEnv, GetChildren) {
   std::sort(result.begin(), result.end());
 
   ASSERT_EQ(files, result);
-}
\ No newline at end of file
+}
+TEST_F(TestEnv, Memory) {
+  Env* env = Env::Memory();
+  const string kDir = "/consensus-test-env-memory";
+  ASSERT_OK(env->CreateDirIfMissing(kDir + "/sub"));
+
+  WritableFile* wf;
+  ASSIGN_IF_ASSERT_OK(env->NewWritableFile(kDir + "/a"), wf);
+  unique_ptr<WritableFile> writer(wf);
+  vector<string> dataSet;
+  RandomDataSet(4, 100, &dataSet);
+  vector<Slice> slices(dataSet.begin(), dataSet.end());
+  ASSERT_OK(writer->AppendV(slices.data(), slices.size()));
+  ASSERT_OK(writer->Sync());
+  ASSERT_OK(writer->Close());
+  ASSERT_EQ(env->NewWritableFile(kDir + "/a", Env::CREATE_NON_EXISTING).GetStatus().Code(),
+            Error::IOError);
+
+  ASSERT_OK(env->RenameFile(kDir + "/a", kDir + "/b"));
+  ASSERT_EQ(env->GetFileSize(kDir + "/a").GetStatus().Code(), Error::NotFound);
+  uint64_t size;
+  ASSIGN_IF_ASSERT_OK(env->GetFileSize(kDir + "/b"), size);
+  ASSERT_EQ(size, 400);
+
+  RandomAccessFile* rf;
+  ASSIGN_IF_ASSERT_OK(env->NewRandomAccessFile(kDir + "/b"), rf);
+  unique_ptr<RandomAccessFile> reader(rf);
+  char scratch[400];
+  Slice result;
+  ASSERT_OK(env_util::ReadFully(rf, 100, 300, &result, scratch));
+  ASSERT_EQ(result.ToString(), dataSet[1] + dataSet[2] + dataSet[3]);
+  ASSERT_OK(rf->Read(400, 10, &result, scratch));
+  ASSERT_EQ(result.size(), 0);
+
+  vector<string> children;
+  ASSERT_OK(env->GetChildren(kDir + "/", &children));
+  std::sort(children.begin(), children.end());
+  ASSERT_EQ(children, vector<string>({"b", "sub"}));
+
+  ASSERT_OK(env->DeleteRecursively(kDir));
+  ASSERT_EQ(env->GetChildren(kDir, &children).Code(), Error::NotFound);
+  ASSERT_EQ(env->GetFileSize(kDir + "/b").GetStatus().Code(), Error::NotFound);
+}
+
+TEST_F(TestEnv, MemoryLatency) {
+  MemoryEnvOptions options;
+  options.append_latency.kind = LatencyDistribution::kFixed;
+  options.append_latency.a = 200;
+  options.sync_latency.kind = LatencyDistribution::kLogNormal;
+  options.sync_latency.a = 1000;
+  options.sync_latency.b = 0.5;
+  unique_ptr<Env> env(Env::NewMemory(options));
+
+  // the files aren't shared with Env::Memory().
+  ASSERT_OK(env->CreateDirIfMissing("/latency"));
+  ASSERT_EQ(Env::Memory()->GetFileSize("/latency/a").GetStatus().Code(), Error::NotFound);
+
+  WritableFile* wf;
+  ASSIGN_IF_ASSERT_OK(env->NewWritableFile("/latency/a"), wf);
+  unique_ptr<WritableFile> writer(wf);
+  vector<Slice> slices(10, Slice("abc"));
+
+  // the slices of an AppendV cost a single append.
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(writer->AppendV(slices.data(), slices.size()));
+  }
+  auto elapsed = chrono::steady_clock::now() - start;
+  ASSERT_GE(elapsed, chrono::microseconds(10 * 200));
+  ASSERT_LT(elapsed, chrono::microseconds(10 * 10 * 200));
+  ASSERT_EQ(writer->Size(), 10 * 10 * 3);
+
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(writer->Sync());
+  }
+  ASSERT_GE(chrono::steady_clock::now() - start, chrono::microseconds(10 * 100));
+  ASSERT_OK(writer->Close());
+}
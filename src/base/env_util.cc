@@ -16,6 +16,8 @@
 #include "base/env.h"
 #include "base/logging.h"
 
+#include <memory>
+
 #include <fmt/format.h>
 #include <silly/likely.h>
 
@@ -44,13 +46,25 @@ Status ReadFully(RandomAccessFile *file, uint64_t offset, size_t n, Slice *resul
 Status ReadFullyToBuffer(const Slice &fname, Slice *result, char **scratch) {
   RandomAccessFile *raf;
   ASSIGN_IF_OK(Env::Default()->NewRandomAccessFile(fname), raf);
+  std::unique_ptr<RandomAccessFile> file(raf);
 
   size_t n;
-  ASSIGN_IF_OK(raf->Size(), n);
+  ASSIGN_IF_OK(file->Size(), n);
   (*scratch) = new char[n];
 
   return ReadFully(raf, 0, n, result, *scratch);
 }
 
+Status ReplaceFile(Env *env, const Slice &fname, const Slice &data) {
+  std::string tmp = fname.ToString() + ".tmp";
+  WritableFile *wf;
+  ASSIGN_IF_OK(env->NewWritableFile(tmp), wf);
+  std::unique_ptr<WritableFile> f(wf);
+  RETURN_NOT_OK(f->Append(data));
+  RETURN_NOT_OK(f->Sync());
+  RETURN_NOT_OK(f->Close());
+  return env->RenameFile(tmp, fname);
+}
+
 }  // namespace env_util
 }  // namespace consensus
\ No newline at end of file
@@ -0,0 +1,217 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "base/background_worker.h"
+#include "base/executor_pool.h"
+#include "base/logging.h"
+#include "base/metrics.h"
+#include "concurrentqueue/concurrentqueue.h"
+
+namespace consensus {
+
+class ExecutorPool::Strand : public std::enable_shared_from_this<ExecutorPool::Strand> {
+ public:
+  Strand(ExecutorPool::Impl *pool, size_t worker) : pool_(pool), worker_(worker) {}
+
+  // The producer scheduling the first pending task puts the strand onto the pool.
+  void Enqueue(Task task);
+
+  void EnqueueUrgent(Task task);
+
+  // Runs the tasks pending so far, the strand is put back onto the worker if more
+  // tasks come in the meantime.
+  void Run(size_t worker);
+
+ private:
+  ExecutorPool::Impl *pool_;
+
+  // the worker that last ran this strand.
+  std::atomic<size_t> worker_;
+
+  moodycamel::ConcurrentQueue<QueuedTask> tasks_;
+  moodycamel::ConcurrentQueue<QueuedTask> urgent_;
+
+  // tasks pending in both lanes.
+  std::atomic<size_t> pending_{0};
+};
+
+class ExecutorPool::Impl {
+ public:
+  Impl(size_t workers, const ThreadAffinity &affinity)
+      : queues_(std::max<size_t>(workers, 1)), workers_(queues_.size()) {
+    for (size_t i = 0; i < workers_.size(); i++) {
+      FATAL_NOT_OK(workers_[i].StartLoop(std::bind(&Impl::runOnce, this, i), affinity),
+                   "ExecutorPool::Impl::Start");
+    }
+  }
+
+  ~Impl() {
+    mu_.lock();
+    stopping_ = true;
+    mu_.unlock();
+    cv_.notify_all();
+
+    for (auto &w : workers_) {
+      FATAL_NOT_OK(w.Stop(), "ExecutorPool::Impl::Stop");
+    }
+  }
+
+  size_t NextWorker() {
+    return next_.fetch_add(1) % queues_.size();
+  }
+
+  void Schedule(std::shared_ptr<Strand> strand, size_t worker) {
+    {
+      std::lock_guard<std::mutex> g(queues_[worker].mu);
+      queues_[worker].strands.push_back(std::move(strand));
+    }
+
+    // any idle worker may take it, the owner takes it first if it's awake.
+    std::lock_guard<std::mutex> g(mu_);
+    runnable_++;
+    cv_.notify_one();
+  }
+
+ private:
+  void runOnce(size_t worker) {
+    std::shared_ptr<Strand> strand = pop(worker);
+    if (!strand) {
+      strand = steal(worker);
+    }
+    if (!strand) {
+      std::unique_lock<std::mutex> l(mu_);
+      cv_.wait_for(l, std::chrono::milliseconds(10),
+                   [this]() { return stopping_ || runnable_ > 0; });
+      return;
+    }
+
+    mu_.lock();
+    runnable_--;
+    mu_.unlock();
+    strand->Run(worker);
+  }
+
+  // The worker takes the oldest strand of its own.
+  std::shared_ptr<Strand> pop(size_t worker) {
+    std::lock_guard<std::mutex> g(queues_[worker].mu);
+    std::deque<std::shared_ptr<Strand>> &strands = queues_[worker].strands;
+    if (strands.empty()) {
+      return nullptr;
+    }
+    std::shared_ptr<Strand> s = std::move(strands.front());
+    strands.pop_front();
+    return s;
+  }
+
+  // The newest strand of the others is stolen, it's the least likely to be cache-hot.
+  std::shared_ptr<Strand> steal(size_t worker) {
+    for (size_t i = 1; i < queues_.size(); i++) {
+      WorkerQueue &victim = queues_[(worker + i) % queues_.size()];
+      std::unique_lock<std::mutex> l(victim.mu, std::try_to_lock);
+      if (!l.owns_lock() || victim.strands.empty()) {
+        continue;
+      }
+      std::shared_ptr<Strand> s = std::move(victim.strands.back());
+      victim.strands.pop_back();
+      return s;
+    }
+    return nullptr;
+  }
+
+ private:
+  struct WorkerQueue {
+    std::deque<std::shared_ptr<Strand>> strands;
+    std::mutex mu;
+  };
+  std::vector<WorkerQueue> queues_;
+
+  std::vector<BackgroundWorker> workers_;
+  std::atomic<size_t> next_{0};
+
+  // number of strands waiting in the queues, idle workers sleep on it.
+  size_t runnable_{0};
+  bool stopping_{false};
+  std::condition_variable cv_;
+  std::mutex mu_;
+};
+
+void ExecutorPool::Strand::Enqueue(Task task) {
+  tasks_.enqueue(QueuedTask(std::move(task)));
+  if (pending_.fetch_add(1) == 0) {
+    pool_->Schedule(shared_from_this(), worker_.load());
+  }
+}
+
+void ExecutorPool::Strand::EnqueueUrgent(Task task) {
+  urgent_.enqueue(QueuedTask(std::move(task)));
+  if (pending_.fetch_add(1) == 0) {
+    pool_->Schedule(shared_from_this(), worker_.load());
+  }
+}
+
+void ExecutorPool::Strand::Run(size_t worker) {
+  worker_.store(worker);
+
+  // The urgent tasks are taken first. Only the tasks pending so far are run, so
+  // the normal ones won't starve.
+  size_t n = pending_.load();
+  for (size_t i = 0; i < n; i++) {
+    QueuedTask task;
+    // the task is already enqueued to either lane once it's counted in pending_.
+    while (!urgent_.try_dequeue(task) && !tasks_.try_dequeue(task)) {
+    }
+    task.Run();
+  }
+
+  if (pending_.fetch_sub(n) != n) {
+    pool_->Schedule(shared_from_this(), worker_.load());
+  }
+}
+
+// The TaskQueue owns the strand together with the pool, the strand is released
+// once it's done with the pending tasks.
+class ExecutorPool::StrandQueue : public TaskQueue::Impl {
+ public:
+  explicit StrandQueue(std::shared_ptr<Strand> strand) : strand_(std::move(strand)) {}
+
+  void Enqueue(Task task) override {
+    strand_->Enqueue(std::move(task));
+  }
+
+  void EnqueueUrgent(Task task) override {
+    strand_->EnqueueUrgent(std::move(task));
+  }
+
+ private:
+  std::shared_ptr<Strand> strand_;
+};
+
+ExecutorPool::ExecutorPool(size_t workers, const ThreadAffinity &affinity)
+    : impl_(new Impl(workers, affinity)) {}
+
+ExecutorPool::~ExecutorPool() = default;
+
+TaskQueue *ExecutorPool::NewStrand() {
+  std::shared_ptr<Strand> strand(new Strand(impl_.get(), impl_->NextWorker()));
+  return new TaskQueue(new StrandQueue(strand));
+}
+
+}  // namespace consensus
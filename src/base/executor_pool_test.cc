@@ -0,0 +1,87 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <thread>
+
+#include "base/executor_pool.h"
+#include "base/simple_channel.h"
+#include "base/testing.h"
+
+using namespace consensus;
+
+// This test verifies the tasks of a strand are executed sequentially, even though
+// the strands are run by multiple workers.
+TEST(ExecutorPoolTest, StrandsInSequence) {
+  ExecutorPool pool(4);
+
+  const int kStrands = 16;
+  const int kTasksPerStrand = 1000;
+
+  std::vector<std::unique_ptr<TaskQueue>> strands;
+  std::vector<std::vector<int>> executed(kStrands);
+  for (int i = 0; i < kStrands; i++) {
+    strands.emplace_back(pool.NewStrand());
+  }
+
+  std::vector<std::thread> producers;
+  for (int i = 0; i < kStrands; i++) {
+    producers.emplace_back([&, i]() {
+      for (int k = 0; k < kTasksPerStrand; k++) {
+        // appending to a vector is not thread-safe, any concurrent run will corrupt it.
+        strands[i]->Enqueue([&, i, k]() { executed[i].push_back(k); });
+      }
+    });
+  }
+  for (auto &t : producers) {
+    t.join();
+  }
+
+  for (int i = 0; i < kStrands; i++) {
+    Barrier barrier;
+    strands[i]->Enqueue([&]() { barrier.Signal(); });
+    barrier.Wait();
+
+    ASSERT_EQ(executed[i].size(), kTasksPerStrand);
+    for (int k = 0; k < kTasksPerStrand; k++) {
+      ASSERT_EQ(executed[i][k], k);
+    }
+  }
+}
+
+// This test verifies an idle worker steals the strands queued behind a blocked one.
+TEST(ExecutorPoolTest, Steal) {
+  ExecutorPool pool(2);
+
+  std::unique_ptr<TaskQueue> s1(pool.NewStrand());
+  std::unique_ptr<TaskQueue> s2(pool.NewStrand());
+  std::unique_ptr<TaskQueue> s3(pool.NewStrand());
+
+  // s1 and s3 are placed onto the same worker, which is then blocked by s1.
+  Barrier blocked;
+  std::atomic_bool release(false);
+  s1->Enqueue([&]() {
+    blocked.Signal();
+    while (!release.load()) {
+      std::this_thread::yield();
+    }
+  });
+  blocked.Wait();
+
+  Barrier barrier;
+  s3->Enqueue([&]() { barrier.Signal(); });
+  barrier.Wait();
+
+  release.store(true);
+}
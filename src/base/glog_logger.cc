@@ -13,32 +13,44 @@
 // limitations under the License.
 
 #include "consensus/base/glog_logger.h"
+#include "consensus/base/async_logger.h"
 
 #include <glog/logging.h>
 
 namespace consensus {
 
-void GLogLogger::Log(yaraft::LogLevel level, int line, const char *file, const yaraft::Slice &log) {
-  google::LogSeverity severity;
+static google::LogSeverity toSeverity(yaraft::LogLevel level) {
   switch (level) {
     case yaraft::INFO:
-      severity = google::INFO;
-      break;
+      return google::INFO;
     case yaraft::WARNING:
-      severity = google::WARNING;
-      break;
+      return google::WARNING;
     case yaraft::ERROR:
-      severity = google::ERROR;
-      break;
+      return google::ERROR;
     case yaraft::FATAL:
-      severity = google::FATAL;
-      break;
+      return google::FATAL;
     default:
       fprintf(stderr, "unsupported level of log: %d\n", static_cast<int>(level));
       assert(false);
+      return google::ERROR;
   }
+}
+
+void GLogLogger::Log(yaraft::LogLevel level, int line, const char *file, const yaraft::Slice &log) {
+  AsyncLogger *logger = AsyncLogger::Installed();
+  if (logger && level != yaraft::FATAL) {
+    logger->Log(level, line, file, std::string(log.data(), log.size()));
+    return;
+  }
+  if (logger) {
+    logger->Flush();
+  }
+  google::LogMessage(file, line, toSeverity(level)).stream() << log;
+}
 
-  google::LogMessage(file, line, severity).stream() << log;
+void GLogLogger::Write(yaraft::LogLevel level, int line, const char *file,
+                       const std::string &msg) {
+  google::LogMessage(file, line, toSeverity(level)).stream() << msg;
 }
 
 }  // namespace consensus
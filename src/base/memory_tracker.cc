@@ -0,0 +1,79 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/memory_tracker.h"
+
+#include <bvar/bvar.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace consensus {
+
+static const char *const kComponentNames[] = {
+    "memstore", "unpersisted_readies", "unapplied_entries", "pending_sends", "application",
+};
+
+static_assert(sizeof(kComponentNames) / sizeof(kComponentNames[0]) ==
+                  MemoryTracker::kComponentCount,
+              "every component must be named");
+
+static int64_t componentUsage(void *arg) {
+  auto c = static_cast<MemoryTracker::Component>(reinterpret_cast<intptr_t>(arg));
+  return MemoryTracker::Instance().Usage(c);
+}
+
+static int64_t totalUsage(void *) {
+  return MemoryTracker::Instance().TotalUsage();
+}
+
+MemoryTracker::MemoryTracker() {
+  for (auto &u : usage_) {
+    u.store(0, std::memory_order_relaxed);
+  }
+}
+
+int64_t MemoryTracker::TotalUsage() const {
+  int64_t total = 0;
+  for (const auto &u : usage_) {
+    total += u.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+const char *MemoryTracker::ComponentName(Component c) {
+  return kComponentNames[c];
+}
+
+MemoryTracker &MemoryTracker::Instance() {
+  // never destroyed, the background threads may still account at exit.
+  static MemoryTracker *tracker = []() -> MemoryTracker * {
+    auto t = new MemoryTracker;
+
+    // exported once the tracker is constructed, since they read it.
+    static std::vector<std::unique_ptr<bvar::PassiveStatus<int64_t>>> vars;
+    for (int c = 0; c < kComponentCount; c++) {
+      vars.emplace_back(new bvar::PassiveStatus<int64_t>(
+          std::string("consensus_memory_") + kComponentNames[c], &componentUsage,
+          reinterpret_cast<void *>(static_cast<intptr_t>(c))));
+    }
+    vars.emplace_back(
+        new bvar::PassiveStatus<int64_t>("consensus_memory_total", &totalUsage, nullptr));
+    return t;
+  }();
+  return *tracker;
+}
+
+}  // namespace consensus
@@ -0,0 +1,46 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/memory_tracker.h"
+#include "base/testing.h"
+
+using namespace consensus;
+
+TEST(MemoryTrackerTest, SoftLimit) {
+  MemoryTracker &tracker = MemoryTracker::Instance();
+  int64_t base = tracker.TotalUsage();
+  tracker.SetSoftLimit(base + 100);
+  ASSERT_FALSE(tracker.OverSoftLimit());
+
+  tracker.Consume(MemoryTracker::kMemStore, 60);
+  tracker.Consume(MemoryTracker::kPendingSends, 60);
+  ASSERT_EQ(tracker.TotalUsage(), base + 120);
+  ASSERT_TRUE(tracker.OverSoftLimit());
+
+  tracker.Release(MemoryTracker::kPendingSends, 60);
+  ASSERT_FALSE(tracker.OverSoftLimit());
+  tracker.Release(MemoryTracker::kMemStore, 60);
+  ASSERT_EQ(tracker.TotalUsage(), base);
+
+  // no limit.
+  tracker.SetSoftLimit(0);
+  tracker.Consume(MemoryTracker::kApplication, base + 1000);
+  ASSERT_FALSE(tracker.OverSoftLimit());
+  tracker.Release(MemoryTracker::kApplication, base + 1000);
+}
+
+TEST(MemoryTrackerTest, ComponentNames) {
+  ASSERT_STREQ(MemoryTracker::ComponentName(MemoryTracker::kMemStore), "memstore");
+  ASSERT_STREQ(MemoryTracker::ComponentName(MemoryTracker::kApplication), "application");
+}
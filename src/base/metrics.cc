@@ -0,0 +1,51 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/metrics.h"
+
+namespace consensus {
+
+Metrics::Metrics()
+    : walAppendBytes("consensus_wal_append_bytes"),
+      walAppendLatency("consensus_wal_append"),
+      walSyncLatency("consensus_wal_sync"),
+      walSegmentRollovers("consensus_wal_segment_rollovers"),
+      walHardStateWrites("consensus_wal_hard_state_writes"),
+      walHardStateSkips("consensus_wal_hard_state_skips"),
+      walTailRewinds("consensus_wal_tail_rewinds"),
+      walTailRewindBytes("consensus_wal_tail_rewind_bytes"),
+      flushReadyLatency("consensus_flush_ready"),
+      flushBatchDelay("consensus_flush_batch_delay"),
+      commitLatency("consensus_commit"),
+      proposalsInflight("consensus_proposals_inflight"),
+      taskQueueDepth("consensus_task_queue_depth"),
+      taskQueueWait("consensus_task_queue_wait"),
+      stepBatchSize("consensus_step_batch_size"),
+      logDropped("consensus_log_dropped"),
+      logSuppressed("consensus_log_suppressed"),
+      leaderTransfers("consensus_leader_transfers"),
+      leaseReads("consensus_lease_reads"),
+      learnerAppends("consensus_learner_appends"),
+      sharedPayloadBytes("consensus_shared_payload_bytes"),
+      replicationCompressLatency("consensus_replication_compress"),
+      replicationCompressRawBytes("consensus_replication_compress_raw_bytes"),
+      replicationCompressSavedBytes("consensus_replication_compress_saved_bytes") {}
+
+Metrics &Metrics::Instance() {
+  // never destroyed, the background threads may still record at exit.
+  static Metrics *metrics = new Metrics;
+  return *metrics;
+}
+
+}  // namespace consensus
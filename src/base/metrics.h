@@ -0,0 +1,136 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <bvar/bvar.h>
+#include <butil/time.h>
+
+#include "base/task.h"
+
+namespace consensus {
+
+// Metrics are the process-wide statistics of the hot paths. They're exported as bvars
+// prefixed by "consensus_", listed on the /vars page of the brpc builtin services, and
+// summarized by RaftService::Status. bvar shards the updates by thread, so recording
+// is cheap enough to stay on.
+class Metrics {
+ public:
+  static Metrics &Instance();
+
+  // the bytes and latency of every batch appended to the wal.
+  bvar::Adder<int64_t> walAppendBytes;
+  bvar::LatencyRecorder walAppendLatency;
+  bvar::LatencyRecorder walSyncLatency;
+  bvar::Adder<int64_t> walSegmentRollovers;
+
+  // the hard states given without entries, that were written since the term or vote
+  // changed, or skipped since only the commit index did.
+  bvar::Adder<int64_t> walHardStateWrites;
+  bvar::Adder<int64_t> walHardStateSkips;
+
+  // the overwrites of conflicting entries that cut the live segment back, and the
+  // bytes cut off.
+  bvar::Adder<int64_t> walTailRewinds;
+  bvar::Adder<int64_t> walTailRewindBytes;
+
+  // from the flush of a Ready to its persistence.
+  bvar::LatencyRecorder flushReadyLatency;
+
+  // how long the flush rounds waited to merge more Ready-s, when they did.
+  bvar::LatencyRecorder flushBatchDelay;
+
+  // from the proposal of a write to its commit.
+  bvar::LatencyRecorder commitLatency;
+  bvar::Adder<int64_t> proposalsInflight;
+
+  // tasks queued but not yet run, and how long they waited.
+  bvar::Adder<int64_t> taskQueueDepth;
+  bvar::LatencyRecorder taskQueueWait;
+
+  // messages per StepBatch RPC.
+  bvar::IntRecorder stepBatchSize;
+
+  // the log lines dropped by AsyncLogger since its buffer was full, and the ones
+  // suppressed by its rate limit.
+  bvar::Adder<int64_t> logDropped;
+  bvar::Adder<int64_t> logSuppressed;
+
+  // the leaderships handed over by LeaderBalancer.
+  bvar::Adder<int64_t> leaderTransfers;
+
+  // the read indexes served by the leader under its lease, see LeaseTracker.
+  bvar::Adder<int64_t> leaseReads;
+
+  // the messages sent to the learners by the leaders, see LearnerReplicator.
+  bvar::Adder<int64_t> learnerAppends;
+
+  // the bytes of the entries appended to many peers that are shared rather than copied,
+  // see rpc::EntryPayloadCache.
+  bvar::Adder<int64_t> sharedPayloadBytes;
+
+  // the time spent compressing the entry payloads replicated to the remote zones, the
+  // bytes compressed, and the bytes saved, see ReplicatedLogOptions::zone.
+  bvar::LatencyRecorder replicationCompressLatency;
+  bvar::Adder<int64_t> replicationCompressRawBytes;
+  bvar::Adder<int64_t> replicationCompressSavedBytes;
+
+ private:
+  Metrics();
+};
+
+inline int64_t MonotonicMicros() {
+  return butil::cpuwide_time_us();
+}
+
+// Records the microseconds from its construction to its destruction.
+class ScopedLatency {
+ public:
+  explicit ScopedLatency(bvar::LatencyRecorder *recorder)
+      : recorder_(recorder), start_(MonotonicMicros()) {}
+
+  ~ScopedLatency() {
+    *recorder_ << MonotonicMicros() - start_;
+  }
+
+ private:
+  bvar::LatencyRecorder *recorder_;
+  int64_t start_;
+};
+
+// A task stamped with the time it's queued, for Metrics::taskQueueWait. An empty
+// QueuedTask wakes up the consumer without being counted.
+struct QueuedTask {
+  QueuedTask() : enqueuedUs(0) {}
+
+  explicit QueuedTask(Task &&t) : task(std::move(t)), enqueuedUs(MonotonicMicros()) {
+    Metrics::Instance().taskQueueDepth << 1;
+  }
+
+  // Runs the task, if it's not empty.
+  void Run() {
+    if (task) {
+      Metrics &m = Metrics::Instance();
+      m.taskQueueDepth << -1;
+      m.taskQueueWait << MonotonicMicros() - enqueuedUs;
+      task();
+      task = Task();
+    }
+  }
+
+  Task task;
+  int64_t enqueuedUs;
+};
+
+}  // namespace consensus
@@ -12,6 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cstring>
+
 #include "base/env.h"
 
 namespace consensus {
@@ -19,7 +22,7 @@ namespace wal {
 
 class MockWritableFile : public WritableFile {
  public:
-  MockWritableFile() {}
+  explicit MockWritableFile(bool useDirectIO = false) : useDirectIO_(useDirectIO) {}
 
   ~MockWritableFile() {}
 
@@ -28,6 +31,24 @@ class MockWritableFile : public WritableFile {
     return Status::OK();
   }
 
+  Status PositionedAppend(const Slice& data, uint64_t offset) override {
+    if (!useDirectIO_) {
+      return Status::Make(Error::NotSupported);
+    }
+    size_t align = GetRequiredBufferAlignment();
+    if (offset % align != 0 || data.size() % align != 0 ||
+        reinterpret_cast<uintptr_t>(data.data()) % align != 0) {
+      return Status::Make(Error::InvalidArgument, "unaligned direct write");
+    }
+    buf_.resize(offset);
+    buf_.append(data.data(), data.size());
+    return Status::OK();
+  }
+
+  bool UseDirectIO() const override {
+    return useDirectIO_;
+  }
+
   Status Truncate(uint64_t size) override {
     buf_.resize(size);
     return Status::OK();
@@ -64,6 +85,31 @@ class MockWritableFile : public WritableFile {
  private:
   std::string buf_;
   std::string fileName_;
+  const bool useDirectIO_;
+};
+
+class MockRandomAccessFile : public RandomAccessFile {
+ public:
+  explicit MockRandomAccessFile(const std::string& data) : data_(data) {}
+
+  Status Read(uint64_t offset, size_t n, Slice* result, char* scratch) const override {
+    size_t len = offset < data_.size() ? std::min(n, data_.size() - offset) : 0;
+    memcpy(scratch, data_.data() + offset, len);
+    *result = Slice(scratch, len);
+    return Status::OK();
+  }
+
+  StatusWith<uint64_t> Size() const override {
+    return static_cast<uint64_t>(data_.size());
+  }
+
+  const std::string& filename() const override {
+    return fileName_;
+  }
+
+ private:
+  std::string data_;
+  std::string fileName_;
 };
 
 }  // namespace wal
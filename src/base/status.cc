@@ -36,6 +36,8 @@ std::string Error::toString(unsigned int code) {
     CONVERT_ERROR_TO_STRING(RuntimeError);
     CONVERT_ERROR_TO_STRING(InvalidArgument);
     CONVERT_ERROR_TO_STRING(WalWriteToNonLeader);
+    CONVERT_ERROR_TO_STRING(NotFound);
+    CONVERT_ERROR_TO_STRING(Busy);
     default:
       return fmt::format("Unknown error codes: {}", code);
   }
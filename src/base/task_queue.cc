@@ -12,50 +12,104 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
 #include "base/task_queue.h"
 #include "base/background_worker.h"
 #include "base/logging.h"
+#include "base/metrics.h"
 #include "concurrentqueue/blockingconcurrentqueue.h"
 
 namespace consensus {
 
-class TaskQueue::Impl {
-  using Runnable = std::function<void()>;
+// The tasks are consumed by a dedicated background thread, which sleeps until some
+// tasks come, and drains up to kMaxBatch tasks of each lane on each wake-up.
+class TaskQueue::ThreadImpl : public TaskQueue::Impl {
+  static const size_t kMaxBatch = 64;
 
  public:
-  void Enqueue(Runnable task) {
-    queue_.enqueue(task);
+  explicit ThreadImpl(const ThreadAffinity &affinity) : batch_(kMaxBatch), stopping_(false) {
+    Start(affinity);
+  }
+
+  ~ThreadImpl() override {
+    Stop();
+  }
+
+  void Enqueue(Task task) override {
+    queue_.enqueue(QueuedTask(std::move(task)));
   }
 
-  void Start() {
-    FATAL_NOT_OK(worker_.StartLoop([&]() {
-      Runnable task;
-      if (queue_.wait_dequeue_timed(task, std::chrono::milliseconds(50))) {
-        task();
-      }
-    }),
+  void EnqueueUrgent(Task task) override {
+    urgent_.enqueue(QueuedTask(std::move(task)));
+    // an empty task wakes up the worker in case it's waiting for the normal lane.
+    queue_.enqueue(QueuedTask());
+  }
+
+  void Start(const ThreadAffinity &affinity) {
+    FATAL_NOT_OK(worker_.StartLoop(std::bind(&ThreadImpl::runOnce, this), affinity),
                  "TaskQueue::Start");
   }
 
   void Stop() {
+    // wakes up the worker, it won't wait for tasks anymore.
+    stopping_.store(true);
+    queue_.enqueue(QueuedTask());
+
     FATAL_NOT_OK(worker_.Stop(), "TaskQueue::Stop");
   }
 
  private:
-  moodycamel::BlockingConcurrentQueue<Runnable> queue_;
+  void runOnce() {
+    if (stopping_.load()) {
+      // wait for the worker to exit the loop.
+      std::this_thread::yield();
+      return;
+    }
+
+    size_t n = urgent_.try_dequeue_bulk(batch_.begin(), kMaxBatch);
+    runBatch(n);
+
+    // blocks only if there's no urgent task that may be followed by more.
+    if (n > 0) {
+      n = queue_.try_dequeue_bulk(batch_.begin(), kMaxBatch);
+    } else {
+      n = queue_.wait_dequeue_bulk(batch_.begin(), kMaxBatch);
+    }
+    runBatch(n);
+  }
+
+  void runBatch(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      batch_[i].Run();
+    }
+  }
+
+ private:
+  moodycamel::BlockingConcurrentQueue<QueuedTask> queue_;
+  moodycamel::ConcurrentQueue<QueuedTask> urgent_;
+  std::vector<QueuedTask> batch_;
+  std::atomic_bool stopping_;
   BackgroundWorker worker_;
 };
 
-void TaskQueue::Enqueue(std::function<void()> task) {
-  impl_->Enqueue(task);
+void TaskQueue::Enqueue(Task task) {
+  impl_->Enqueue(std::move(task));
 }
 
-TaskQueue::TaskQueue() : impl_(new Impl()) {
-  impl_->Start();
+void TaskQueue::EnqueueUrgent(Task task) {
+  impl_->EnqueueUrgent(std::move(task));
 }
 
-TaskQueue::~TaskQueue() {
-  impl_->Stop();
-}
+TaskQueue::TaskQueue() : impl_(new ThreadImpl(ThreadAffinity())) {}
+
+TaskQueue::TaskQueue(const ThreadAffinity &affinity) : impl_(new ThreadImpl(affinity)) {}
+
+TaskQueue::TaskQueue(Impl *impl) : impl_(impl) {}
+
+TaskQueue::~TaskQueue() = default;
 
 }  // namespace consensus
\ No newline at end of file
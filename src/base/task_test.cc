@@ -0,0 +1,70 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+
+#include "base/task.h"
+#include "base/testing.h"
+
+using namespace consensus;
+
+namespace {
+
+// a move-only callable
+struct Increment {
+  std::unique_ptr<int> delta;
+  int* target;
+
+  void operator()() {
+    *target += *delta;
+  }
+};
+
+// a callable too large to be stored in place
+struct LargeIncrement {
+  char padding[Task::kInlineSize * 2];
+  int* target;
+
+  void operator()() {
+    (*target)++;
+  }
+};
+
+}  // namespace
+
+TEST(TaskTest, Inline) {
+  int x = 0;
+  Task t([&x]() { x++; });
+  t();
+  ASSERT_EQ(x, 1);
+
+  Task t2(Increment{std::unique_ptr<int>(new int(10)), &x});
+  Task t3(std::move(t2));
+  ASSERT_FALSE(static_cast<bool>(t2));
+  t3();
+  ASSERT_EQ(x, 11);
+}
+
+TEST(TaskTest, Heap) {
+  int x = 0;
+  LargeIncrement inc;
+  inc.target = &x;
+
+  Task t(inc);
+  Task t2;
+  t2 = std::move(t);
+  ASSERT_FALSE(static_cast<bool>(t));
+  t2();
+  ASSERT_EQ(x, 1);
+}
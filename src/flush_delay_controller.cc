@@ -0,0 +1,54 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "flush_delay_controller.h"
+
+#include <algorithm>
+
+namespace consensus {
+
+// weight of the latest sample in the moving averages.
+constexpr static double kSampleWeight = 0.125;
+
+static void updateAverage(double* avg, double sample) {
+  *avg = *avg == 0 ? sample : *avg + (sample - *avg) * kSampleWeight;
+}
+
+void FlushDelayController::OnArrival(int64_t nowUs) {
+  if (lastArrival_ >= 0 && nowUs >= lastArrival_) {
+    // simultaneous arrivals count as 1us apart, which keeps the average sampled.
+    updateAverage(&intervalUs_, std::max<int64_t>(nowUs - lastArrival_, 1));
+  }
+  lastArrival_ = nowUs;
+}
+
+void FlushDelayController::OnPersisted(int64_t latencyUs) {
+  updateAverage(&persistUs_, std::max<int64_t>(latencyUs, 1));
+}
+
+uint32_t FlushDelayController::Delay() const {
+  if (maxDelayUs_ == 0 || intervalUs_ == 0 || persistUs_ == 0) {
+    return 0;
+  }
+  double delay = persistUs_ / 2;
+  if (intervalUs_ >= delay) {
+    // under light load, no more Ready is expected while waiting.
+    return 0;
+  }
+  double budget = latencySloUs_ > persistUs_ ? latencySloUs_ - persistUs_ : 0;
+  return static_cast<uint32_t>(std::min({delay, budget, static_cast<double>(maxDelayUs_)}));
+}
+
+}  // namespace consensus
@@ -0,0 +1,63 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace consensus {
+
+// FlushDelayController decides how long a round of the ReadyFlusher waits for more
+// Ready-s to arrive, so that they're committed to the wal together, from the moving
+// averages of the persist latency and the interval between arrivals.
+//
+// Under light load, when the next Ready is not expected within half of the persist
+// latency, the round flushes at once, since waiting merges nothing. Otherwise it waits
+// for half of the persist latency to merge the arrivals expected meanwhile, but never
+// longer than `maxDelayUs`, nor than the latency SLO leaves on top of the persist
+// latency.
+//
+// Not-Thread-Safe
+class FlushDelayController {
+ public:
+  // 0 `maxDelayUs` disables the waiting.
+  FlushDelayController(uint32_t maxDelayUs, uint32_t latencySloUs)
+      : maxDelayUs_(maxDelayUs),
+        latencySloUs_(latencySloUs),
+        lastArrival_(-1),
+        intervalUs_(0),
+        persistUs_(0) {}
+
+  // A Ready arrives at `nowUs`, in microseconds of a monotonic clock.
+  void OnArrival(int64_t nowUs);
+
+  // A Ready was persisted `latencyUs` after its flush started.
+  void OnPersisted(int64_t latencyUs);
+
+  // Microseconds for the round to wait before flushing.
+  uint32_t Delay() const;
+
+ private:
+  const uint32_t maxDelayUs_;
+  const uint32_t latencySloUs_;
+
+  int64_t lastArrival_;
+
+  // moving averages, 0 if not sampled yet.
+  double intervalUs_;
+  double persistUs_;
+};
+
+}  // namespace consensus
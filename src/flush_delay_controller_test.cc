@@ -0,0 +1,74 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "base/testing.h"
+#include "flush_delay_controller.h"
+
+using namespace consensus;
+
+// feeds arrivals `intervalUs` apart, each persisted in `persistUs`.
+static void feed(FlushDelayController* c, int64_t intervalUs, int64_t persistUs) {
+  for (int i = 0; i < 64; i++) {
+    c->OnArrival(i * intervalUs);
+    c->OnPersisted(persistUs);
+  }
+}
+
+TEST(FlushDelayControllerTest, Disabled) {
+  FlushDelayController c(0, 2000);
+  feed(&c, 10, 1000);
+  ASSERT_EQ(c.Delay(), 0);
+
+  // nothing is sampled yet.
+  FlushDelayController d(1000, 2000);
+  ASSERT_EQ(d.Delay(), 0);
+  d.OnArrival(0);
+  d.OnPersisted(1000);
+  ASSERT_EQ(d.Delay(), 0);
+}
+
+TEST(FlushDelayControllerTest, LightLoad) {
+  FlushDelayController c(1000, 2000);
+  feed(&c, 600, 1000);
+  ASSERT_EQ(c.Delay(), 0);
+}
+
+TEST(FlushDelayControllerTest, HeavyLoad) {
+  FlushDelayController c(1000, 2000);
+  feed(&c, 10, 1000);
+  ASSERT_EQ(c.Delay(), 500);
+
+  // the load drops.
+  for (int i = 0; i < 64; i++) {
+    c.OnArrival(640 + i * 1000);
+  }
+  ASSERT_EQ(c.Delay(), 0);
+}
+
+TEST(FlushDelayControllerTest, Capped) {
+  FlushDelayController maxDelay(200, 2000);
+  feed(&maxDelay, 10, 1000);
+  ASSERT_EQ(maxDelay.Delay(), 200);
+
+  // only 300us is left within the SLO.
+  FlushDelayController slo(1000, 2000);
+  feed(&slo, 10, 1700);
+  ASSERT_EQ(slo.Delay(), 300);
+
+  // the SLO is already missed.
+  FlushDelayController missed(1000, 2000);
+  feed(&missed, 10, 3000);
+  ASSERT_EQ(missed.Delay(), 0);
+}
@@ -0,0 +1,176 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "leader_balancer.h"
+#include "base/background_worker.h"
+#include "replicated_log.h"
+
+#include "base/logging.h"
+#include "base/metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+namespace consensus {
+
+LeaderBalancerOptions::LeaderBalancerOptions() : interval_ms(10000), max_transfers_per_round(1) {}
+
+class LeaderBalancer::Impl {
+ public:
+  explicit Impl(const LeaderBalancerOptions& options) : options_(options) {}
+
+  ~Impl() {
+    {
+      std::lock_guard<std::mutex> g(waitMu_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    if (!worker_.Stopped()) {
+      FATAL_NOT_OK(worker_.Stop(), "LeaderBalancer::Stop");
+    }
+  }
+
+  void Add(ReplicatedLog* log) {
+    std::lock_guard<std::mutex> g(mu_);
+    logs_.push_back(log);
+  }
+
+  void Remove(ReplicatedLog* log) {
+    std::lock_guard<std::mutex> g(mu_);
+    logs_.erase(std::remove(logs_.begin(), logs_.end(), log), logs_.end());
+  }
+
+  Status Start() {
+    return worker_.StartLoop(std::bind(&Impl::round, this));
+  }
+
+  // The logs are locked through the round, so that none is removed while it's used.
+  size_t Balance() {
+    std::lock_guard<std::mutex> g(mu_);
+    if (logs_.empty()) {
+      return 0;
+    }
+
+    std::vector<Group> groups(logs_.size());
+    for (size_t i = 0; i < logs_.size(); i++) {
+      groups[i].leader = logs_[i]->GetRaftState().leader;
+      groups[i].peers = logs_[i]->Peers();
+    }
+
+    size_t transfers = 0;
+    uint64_t self = logs_.front()->Id();
+    for (const auto& t : Plan(self, groups, options_.max_transfers_per_round)) {
+      Status s = logs_[t.first]->TransferLeadership(t.second);
+      if (!s.IsOK()) {
+        // the leadership may have changed since the state was read.
+        FMT_LOG(WARNING, "failed to transfer leadership to node {}: {}", t.second,
+                s.ToString());
+        continue;
+      }
+      FMT_LOG(INFO, "transferring leadership from node {} to {}", self, t.second);
+      Metrics::Instance().leaderTransfers << 1;
+      transfers++;
+    }
+    return transfers;
+  }
+
+ private:
+  void round() {
+    {
+      std::unique_lock<std::mutex> l(waitMu_);
+      cv_.wait_for(l, std::chrono::milliseconds(options_.interval_ms),
+                   [this]() { return stopping_; });
+      if (stopping_) {
+        return;
+      }
+    }
+    Balance();
+  }
+
+ private:
+  const LeaderBalancerOptions options_;
+
+  std::mutex mu_;
+  std::vector<ReplicatedLog*> logs_;
+
+  // wakes up the waiting round on destruction.
+  std::mutex waitMu_;
+  std::condition_variable cv_;
+  bool stopping_{false};
+
+  BackgroundWorker worker_;
+};
+
+std::vector<std::pair<size_t, uint64_t>> LeaderBalancer::Plan(uint64_t self,
+                                                              const std::vector<Group>& groups,
+                                                              size_t maxTransfers) {
+  std::map<uint64_t, size_t> leaders;
+  for (const Group& g : groups) {
+    for (uint64_t p : g.peers) {
+      leaders[p];
+    }
+    if (g.leader != 0) {
+      leaders[g.leader]++;
+    }
+  }
+
+  std::vector<std::pair<size_t, uint64_t>> plan;
+  for (size_t i = 0; i < groups.size() && plan.size() < maxTransfers; i++) {
+    const Group& g = groups[i];
+    if (g.leader != self) {
+      continue;
+    }
+
+    // the least loaded peer of the group.
+    uint64_t target = 0;
+    for (uint64_t p : g.peers) {
+      if (p != self && (target == 0 || leaders[p] < leaders[target])) {
+        target = p;
+      }
+    }
+    // moving a leadership to a peer leading one fewer group only swaps the two.
+    if (target == 0 || leaders[target] + 2 > leaders[self]) {
+      continue;
+    }
+    leaders[self]--;
+    leaders[target]++;
+    plan.emplace_back(i, target);
+  }
+  return plan;
+}
+
+LeaderBalancer::LeaderBalancer(const LeaderBalancerOptions& options) : impl_(new Impl(options)) {}
+
+LeaderBalancer::~LeaderBalancer() = default;
+
+void LeaderBalancer::Add(ReplicatedLog* log) {
+  impl_->Add(log);
+}
+
+void LeaderBalancer::Remove(ReplicatedLog* log) {
+  impl_->Remove(log);
+}
+
+Status LeaderBalancer::Start() {
+  return impl_->Start();
+}
+
+size_t LeaderBalancer::Balance() {
+  return impl_->Balance();
+}
+
+}  // namespace consensus
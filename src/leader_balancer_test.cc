@@ -0,0 +1,65 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/testing.h"
+#include "leader_balancer.h"
+
+using namespace consensus;
+
+typedef std::vector<std::pair<size_t, uint64_t>> Transfers;
+
+static std::vector<LeaderBalancer::Group> groupsLedBy(const std::vector<uint64_t>& leaders) {
+  std::vector<LeaderBalancer::Group> groups(leaders.size());
+  for (size_t i = 0; i < leaders.size(); i++) {
+    groups[i].leader = leaders[i];
+    groups[i].peers = {1, 2, 3};
+  }
+  return groups;
+}
+
+TEST(LeaderBalancerTest, Balanced) {
+  // differing by one, moving a leadership would only swap the counts.
+  auto groups = groupsLedBy({1, 1, 2, 3});
+  ASSERT_TRUE(LeaderBalancer::Plan(1, groups, 10).empty());
+
+  // the leaders unknown are not counted.
+  groups = groupsLedBy({1, 1, 0, 0, 2, 3});
+  ASSERT_TRUE(LeaderBalancer::Plan(1, groups, 10).empty());
+}
+
+TEST(LeaderBalancerTest, SpreadToLeastLoaded) {
+  auto groups = groupsLedBy({1, 1, 1, 1, 1, 2});
+  ASSERT_EQ(LeaderBalancer::Plan(1, groups, 10), Transfers({{0, 3}, {1, 2}, {2, 3}}));
+
+  // limited per round.
+  ASSERT_EQ(LeaderBalancer::Plan(1, groups, 1), Transfers({{0, 3}}));
+
+  // the other nodes only give away their own leaderships.
+  ASSERT_TRUE(LeaderBalancer::Plan(2, groups, 10).empty());
+  ASSERT_TRUE(LeaderBalancer::Plan(3, groups, 10).empty());
+}
+
+TEST(LeaderBalancerTest, TargetInGroup) {
+  // node 3 leads nothing, but it's only in the last group.
+  auto groups = groupsLedBy({1, 1, 1, 2, 2});
+  for (size_t i = 0; i < 4; i++) {
+    groups[i].peers = {1, 2, 4};
+  }
+  groups[4].peers = {1, 2, 3};
+  groups.push_back(groups[0]);
+  groups.back().leader = 4;
+
+  // node 1 leads 3, node 2 leads 2, node 4 leads 1.
+  ASSERT_EQ(LeaderBalancer::Plan(1, groups, 10), Transfers({{0, 4}}));
+}
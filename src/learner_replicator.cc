@@ -0,0 +1,171 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "learner_replicator.h"
+
+#include <algorithm>
+
+namespace consensus {
+
+LearnerReplicator::LearnerReplicator(const std::vector<uint64_t>& learners, uint64_t maxBytes,
+                                     std::chrono::milliseconds resendTimeout)
+    : maxBytes_(maxBytes), resendTimeout_(resendTimeout) {
+  for (uint64_t l : learners) {
+    progress_[l] = Progress();
+  }
+}
+
+void LearnerReplicator::Observe(const yaraft::pb::Message& msg) {
+  if (msg.type() != yaraft::pb::MsgAppResp) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> g(mu_);
+  auto it = progress_.find(msg.from());
+  // the responses to the previous leaderships don't count.
+  if (it == progress_.end() || msg.term() != it->second.term) {
+    return;
+  }
+  Progress& p = it->second;
+  p.inflight = false;
+  if (msg.reject()) {
+    // probes backward from the last index of the learner, like raft does.
+    p.next = std::max<uint64_t>(std::min(msg.index(), msg.rejecthint() + 1), p.match + 1);
+    return;
+  }
+  if (msg.index() > p.match) {
+    p.match = msg.index();
+    p.next = std::max(p.next, p.match + 1);
+  }
+  if (p.pendingSnapshot != 0 && p.match >= p.pendingSnapshot) {
+    p.pendingSnapshot = 0;
+  }
+}
+
+void LearnerReplicator::ReportUnreachable(uint64_t id) {
+  std::lock_guard<std::mutex> g(mu_);
+  auto it = progress_.find(id);
+  if (it == progress_.end() || !it->second.inflight) {
+    return;
+  }
+  it->second.inflight = false;
+  it->second.next = it->second.inflightPrev + 1;
+}
+
+void LearnerReplicator::ReportSnapshot(uint64_t id, bool failed) {
+  std::lock_guard<std::mutex> g(mu_);
+  auto it = progress_.find(id);
+  if (it == progress_.end() || it->second.pendingSnapshot == 0) {
+    return;
+  }
+  Progress& p = it->second;
+  if (!failed) {
+    // the log is replicated from the snapshot on.
+    p.match = std::max(p.match, p.pendingSnapshot);
+    p.next = p.match + 1;
+  }
+  p.pendingSnapshot = 0;
+}
+
+bool LearnerReplicator::next(Progress* p, uint64_t commit, yaraft::Storage* storage,
+                             bool snapshots, yaraft::pb::Message* m) {
+  uint64_t last = storage->LastIndex();
+  if (p->next > last && p->commitSent >= commit) {
+    return false;
+  }
+
+  uint64_t prev = p->next - 1;
+  yaraft::StatusWith<uint64_t> term = storage->Term(prev);
+  if (!term.IsOK()) {
+    // the entries are compacted.
+    if (!snapshots) {
+      return false;
+    }
+    auto snap = storage->Snapshot();
+    if (!snap.IsOK() || snap.GetValue().metadata().index() == 0) {
+      return false;
+    }
+    m->set_type(yaraft::pb::MsgSnap);
+    m->mutable_snapshot()->CopyFrom(snap.GetValue());
+    p->pendingSnapshot = m->snapshot().metadata().index();
+    return true;
+  }
+
+  m->set_type(yaraft::pb::MsgApp);
+  m->set_index(prev);
+  m->set_logterm(term.GetValue());
+  m->set_commit(commit);
+  if (p->next <= last) {
+    uint64_t maxSize = maxBytes_;
+    auto sw = storage->Entries(p->next, last + 1, &maxSize);
+    if (!sw.IsOK()) {
+      return false;
+    }
+    for (auto& e : sw.GetValue()) {
+      m->add_entries()->Swap(&e);
+    }
+  }
+
+  // the next entries are sent once these are acknowledged.
+  p->next = prev + m->entries_size() + 1;
+  p->commitSent = commit;
+  p->inflight = true;
+  p->inflightPrev = prev;
+  p->sentAt = Clock::now();
+  return true;
+}
+
+void LearnerReplicator::Replicate(uint64_t id, uint64_t term, uint64_t commit,
+                                  yaraft::Storage* storage, bool snapshots,
+                                  std::vector<yaraft::pb::Message>* msgs) {
+  Clock::time_point now = Clock::now();
+
+  std::lock_guard<std::mutex> g(mu_);
+  for (auto& e : progress_) {
+    Progress& p = e.second;
+    if (p.term != term) {
+      // a new leader probes the learners from the end of its log.
+      p = Progress();
+      p.term = term;
+      p.next = storage->LastIndex() + 1;
+    }
+    if (p.pendingSnapshot != 0) {
+      continue;
+    }
+    if (p.inflight) {
+      if (now - p.sentAt < resendTimeout_) {
+        continue;
+      }
+      p.inflight = false;
+      p.next = p.inflightPrev + 1;
+    }
+
+    yaraft::pb::Message m;
+    if (!next(&p, commit, storage, snapshots, &m)) {
+      continue;
+    }
+    m.set_from(id);
+    m.set_to(e.first);
+    m.set_term(term);
+    msgs->push_back(std::move(m));
+  }
+}
+
+uint64_t LearnerReplicator::Matched(uint64_t id) const {
+  std::lock_guard<std::mutex> g(mu_);
+  auto it = progress_.find(id);
+  return it == progress_.end() ? 0 : it->second.match;
+}
+
+}  // namespace consensus
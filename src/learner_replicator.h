@@ -0,0 +1,99 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <yaraft/pb/raftpb.pb.h>
+#include <yaraft/storage.h>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace consensus {
+
+// LearnerReplicator ships the log of the leader to the learners, which receive and apply
+// the entries like the followers, but neither vote nor count toward the quorum. raft
+// doesn't know of them, so the leader sends them the MsgApp-s raft would send to a
+// follower, and tracks their progress from their MsgAppResp-s, which raft ignores as
+// coming from unknown peers. A learner behind the compacted log is sent the snapshot
+// of the storage instead.
+//
+// One message is inflight to a learner at a time, it's resent if the learner doesn't
+// respond within the resend timeout.
+//
+// Thread-Safe
+class LearnerReplicator {
+ public:
+  // Each MsgApp carries at most `maxBytes` of entries, or one entry if it's larger.
+  LearnerReplicator(const std::vector<uint64_t>& learners, uint64_t maxBytes,
+                    std::chrono::milliseconds resendTimeout);
+
+  bool IsLearner(uint64_t id) const {
+    return progress_.find(id) != progress_.end();
+  }
+
+  // Called with each inbound message, only the responses of the learners count.
+  void Observe(const yaraft::pb::Message& msg);
+
+  // The messages to the learner were dropped, the inflight one is resent.
+  void ReportUnreachable(uint64_t id);
+
+  // The snapshot sent to the learner is installed, or failed to be.
+  void ReportSnapshot(uint64_t id, bool failed);
+
+  // Appends to `msgs` the messages catching the learners up with the log in `storage`,
+  // whose committed index is `commit`, on behalf of the leader `id` in `term`. The
+  // learners are sent the snapshots only if `snapshots` is true.
+  // Called in the raft thread of the leader, where `storage` is read.
+  void Replicate(uint64_t id, uint64_t term, uint64_t commit, yaraft::Storage* storage,
+                 bool snapshots, std::vector<yaraft::pb::Message>* msgs);
+
+  // Index of the last entry the learner has acknowledged in the latest term.
+  uint64_t Matched(uint64_t id) const;
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Progress {
+    // the term of the leadership the rest is tracked in.
+    uint64_t term{0};
+    uint64_t match{0};
+    uint64_t next{0};
+    uint64_t commitSent{0};
+
+    bool inflight{false};
+    // index preceding the entries of the inflight MsgApp.
+    uint64_t inflightPrev{0};
+    Clock::time_point sentAt;
+
+    // index of the snapshot being sent, 0 if there's none.
+    uint64_t pendingSnapshot{0};
+  };
+
+  // Fills the next message to the learner in `m`, returns false if there's nothing to send.
+  bool next(Progress* p, uint64_t commit, yaraft::Storage* storage, bool snapshots,
+            yaraft::pb::Message* m);
+
+ private:
+  const uint64_t maxBytes_;
+  const Clock::duration resendTimeout_;
+
+  // the learners are fixed at construction, only their progress changes.
+  mutable std::mutex mu_;
+  std::map<uint64_t, Progress> progress_;
+};
+
+}  // namespace consensus
@@ -0,0 +1,141 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "base/testing.h"
+#include "learner_replicator.h"
+
+#include <yaraft/memory_storage.h>
+#include <yaraft/pb_utils.h>
+
+#include <thread>
+
+using namespace consensus;
+
+static void append(yaraft::MemoryStorage* storage, uint64_t lo, uint64_t hi) {
+  yaraft::EntryVec vec;
+  for (uint64_t i = lo; i < hi; i++) {
+    vec.push_back(yaraft::PBEntry().Index(i).Term(1).Data(std::string(10, 'a')).v);
+  }
+  storage->Append(vec);
+}
+
+static yaraft::pb::Message appResp(uint64_t index, bool reject, uint64_t hint = 0) {
+  yaraft::pb::Message m;
+  m.set_type(yaraft::pb::MsgAppResp);
+  m.set_from(4);
+  m.set_to(1);
+  m.set_term(1);
+  m.set_index(index);
+  m.set_reject(reject);
+  m.set_rejecthint(hint);
+  return m;
+}
+
+// This test verifies that a learner is probed from the end of the log, then caught up
+// from the index it has.
+TEST(LearnerReplicatorTest, ProbeAndCatchUp) {
+  yaraft::MemoryStorage storage;
+  append(&storage, 1, 11);
+  LearnerReplicator learners({4}, 1024 * 1024, std::chrono::milliseconds(1000));
+  ASSERT_TRUE(learners.IsLearner(4));
+  ASSERT_FALSE(learners.IsLearner(2));
+
+  std::vector<yaraft::pb::Message> msgs;
+  learners.Replicate(1, 1, 10, &storage, false, &msgs);
+  ASSERT_EQ(msgs.size(), 1);
+  ASSERT_EQ(msgs[0].type(), yaraft::pb::MsgApp);
+  ASSERT_EQ(msgs[0].to(), 4);
+  ASSERT_EQ(msgs[0].index(), 10);
+  ASSERT_EQ(msgs[0].entries_size(), 0);
+  ASSERT_EQ(msgs[0].commit(), 10);
+
+  // one message is inflight at a time.
+  msgs.clear();
+  learners.Replicate(1, 1, 10, &storage, false, &msgs);
+  ASSERT_EQ(msgs.size(), 0);
+
+  // the learner has nothing.
+  learners.Observe(appResp(10, true, 0));
+  learners.Replicate(1, 1, 10, &storage, false, &msgs);
+  ASSERT_EQ(msgs.size(), 1);
+  ASSERT_EQ(msgs[0].index(), 0);
+  ASSERT_EQ(msgs[0].entries_size(), 10);
+
+  learners.Observe(appResp(10, false));
+  ASSERT_EQ(learners.Matched(4), 10);
+
+  // up to date
+  msgs.clear();
+  learners.Replicate(1, 1, 10, &storage, false, &msgs);
+  ASSERT_EQ(msgs.size(), 0);
+
+  // only the new commit index is sent.
+  learners.Replicate(1, 1, 11, &storage, false, &msgs);
+  ASSERT_EQ(msgs.size(), 1);
+  ASSERT_EQ(msgs[0].index(), 10);
+  ASSERT_EQ(msgs[0].entries_size(), 0);
+  ASSERT_EQ(msgs[0].commit(), 11);
+  learners.Observe(appResp(10, false));
+
+  msgs.clear();
+  append(&storage, 11, 13);
+  learners.Replicate(1, 1, 11, &storage, false, &msgs);
+  ASSERT_EQ(msgs.size(), 1);
+  ASSERT_EQ(msgs[0].index(), 10);
+  ASSERT_EQ(msgs[0].entries_size(), 2);
+}
+
+// This test verifies that the unacknowledged message is resent, and that a new leader
+// starts over.
+TEST(LearnerReplicatorTest, Resend) {
+  yaraft::MemoryStorage storage;
+  append(&storage, 1, 11);
+  LearnerReplicator learners({4}, 50, std::chrono::milliseconds(50));
+
+  std::vector<yaraft::pb::Message> msgs;
+  learners.Replicate(1, 1, 10, &storage, false, &msgs);
+  learners.Observe(appResp(10, true, 0));
+  msgs.clear();
+  learners.Replicate(1, 1, 10, &storage, false, &msgs);
+  ASSERT_EQ(msgs.size(), 1);
+  ASSERT_EQ(msgs[0].index(), 0);
+  // bounded by the max bytes.
+  ASSERT_GE(msgs[0].entries_size(), 1);
+  ASSERT_LT(msgs[0].entries_size(), 10);
+  int sent = msgs[0].entries_size();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  msgs.clear();
+  learners.Replicate(1, 1, 10, &storage, false, &msgs);
+  ASSERT_EQ(msgs.size(), 1);
+  ASSERT_EQ(msgs[0].index(), 0);
+  ASSERT_EQ(msgs[0].entries_size(), sent);
+
+  learners.ReportUnreachable(4);
+  msgs.clear();
+  learners.Replicate(1, 1, 10, &storage, false, &msgs);
+  ASSERT_EQ(msgs.size(), 1);
+  ASSERT_EQ(msgs[0].index(), 0);
+
+  // the responses to the previous leader are ignored.
+  msgs.clear();
+  learners.Replicate(2, 2, 10, &storage, false, &msgs);
+  ASSERT_EQ(msgs.size(), 1);
+  ASSERT_EQ(msgs[0].from(), 2);
+  ASSERT_EQ(msgs[0].term(), 2);
+  ASSERT_EQ(msgs[0].index(), 10);
+  learners.Observe(appResp(sent, false));
+  ASSERT_EQ(learners.Matched(4), 0);
+}
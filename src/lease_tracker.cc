@@ -0,0 +1,140 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lease_tracker.h"
+
+#include <algorithm>
+
+namespace consensus {
+
+// a peer that leaves this many heartbeats unanswered has lost some of them, its later
+// responses can't be told apart then.
+static const size_t kMaxUnanswered = 256;
+
+LeaseTracker::LeaseTracker(uint64_t id, const std::vector<uint64_t>& peers,
+                           std::chrono::milliseconds lease,
+                           std::chrono::milliseconds electionTimeout)
+    : lease_(lease), electionTimeout_(electionTimeout) {
+  for (uint64_t p : peers) {
+    if (p != id) {
+      peers_[p] = Peer();
+    }
+  }
+}
+
+void LeaseTracker::Sent(const std::vector<yaraft::pb::Message>& msgs) {
+  Clock::time_point now = Clock::now();
+
+  std::lock_guard<std::mutex> g(mu_);
+  for (const auto& msg : msgs) {
+    if (msg.type() != yaraft::pb::MsgHeartbeat) {
+      continue;
+    }
+    auto it = peers_.find(msg.to());
+    if (it == peers_.end() || msg.term() < it->second.term) {
+      continue;
+    }
+    Peer& p = it->second;
+    if (msg.term() > p.term) {
+      p = Peer();
+      p.term = msg.term();
+    }
+    if (p.lost) {
+      continue;
+    }
+    if (p.unanswered.size() >= kMaxUnanswered) {
+      p.lost = true;
+      p.unanswered.clear();
+      continue;
+    }
+    p.unanswered.push_back(now);
+  }
+}
+
+void LeaseTracker::Observe(const yaraft::pb::Message& msg) {
+  Clock::time_point now = Clock::now();
+
+  std::lock_guard<std::mutex> g(mu_);
+  switch (msg.type()) {
+    case yaraft::pb::MsgHeartbeat:
+    case yaraft::pb::MsgApp:
+    case yaraft::pb::MsgSnap:
+      if (msg.term() >= leaderTerm_) {
+        leaderTerm_ = msg.term();
+        heardFromLeader_ = now;
+      }
+      return;
+    case yaraft::pb::MsgHeartbeatResp:
+      break;
+    default:
+      return;
+  }
+
+  // Each response answers a distinct heartbeat of the term, so when the k-th arrives the
+  // peer has received k of them, one of which is sent no earlier than the k-th. It's
+  // true even if some are lost or reordered, they only make the lease shorter.
+  auto it = peers_.find(msg.from());
+  if (it == peers_.end()) {
+    return;
+  }
+  Peer& p = it->second;
+  if (msg.term() != p.term || p.lost || p.unanswered.empty()) {
+    return;
+  }
+  p.acked = p.unanswered.front();
+  p.unanswered.pop_front();
+}
+
+bool LeaseTracker::Valid(uint64_t term) const {
+  Clock::time_point now = Clock::now();
+  Clock::time_point since = now - lease_;
+
+  // the leader itself
+  size_t acked = 1;
+  std::lock_guard<std::mutex> g(mu_);
+  if (now < suspendedUntil_) {
+    return false;
+  }
+  since = std::max(since, suspendedUntil_);
+  for (const auto& e : peers_) {
+    if (e.second.term == term && e.second.acked >= since) {
+      acked++;
+    }
+  }
+  return acked > (peers_.size() + 1) / 2;
+}
+
+bool LeaseTracker::RejectVote(const yaraft::pb::Message& msg, bool leader, uint64_t term) const {
+  if (msg.type() != yaraft::pb::MsgVote) {
+    return false;
+  }
+  if (leader) {
+    return Valid(term);
+  }
+
+  // The leader measures its lease from the send time of a heartbeat, which is before
+  // this follower received it, by the clock of the leader. The follower's election
+  // timeout covers the lease as long as their clocks drift apart by no more than
+  // lease_clock_drift in the meantime.
+  std::lock_guard<std::mutex> g(mu_);
+  return leaderTerm_ > 0 && Clock::now() - heardFromLeader_ < electionTimeout_;
+}
+
+void LeaseTracker::Suspend(std::chrono::milliseconds duration) {
+  Clock::time_point until = Clock::now() + duration;
+  std::lock_guard<std::mutex> g(mu_);
+  suspendedUntil_ = std::max(suspendedUntil_, until);
+}
+
+}  // namespace consensus
@@ -0,0 +1,97 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <yaraft/pb/raftpb.pb.h>
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace consensus {
+
+// LeaseTracker tells whether the leader holds a lease, in which no other node can be
+// elected: a quorum has responded to its heartbeats sent within the lease duration,
+// which is shorter than the election timeout by the clock drift margin.
+//
+// A follower that responded had received a heartbeat sent no earlier than the one the
+// lease is measured from. Raft alone doesn't stop it from voting for a candidate in the
+// meantime, so it rejects the votes until the election timeout since it last heard
+// from the leader, see RejectVote. The leader rejects them while it holds the lease.
+//
+// The lease relies on the clocks of the nodes drifting apart by no more than the
+// margin over an election timeout, and on the followers' election timeouts exceeding
+// the leader's lease by at least the margin.
+//
+// Thread-Safe
+class LeaseTracker {
+ public:
+  // `peers` includes the leader itself.
+  LeaseTracker(uint64_t id, const std::vector<uint64_t>& peers, std::chrono::milliseconds lease,
+               std::chrono::milliseconds electionTimeout);
+
+  // Called with each outbound message of the leader, the heartbeats are timed.
+  void Sent(const std::vector<yaraft::pb::Message>& msgs);
+
+  // Called with each inbound message. The heartbeat responses count toward the lease of
+  // the leader, the messages from the leader defer the votes of a follower.
+  void Observe(const yaraft::pb::Message& msg);
+
+  // Returns true if a quorum has responded in `term` to the heartbeats sent within the
+  // lease, and the lease is not suspended.
+  bool Valid(uint64_t term) const;
+
+  // Whether an inbound vote is to be dropped: the follower heard from the leader within
+  // the election timeout, or the leader holds the lease in `term`.
+  bool RejectVote(const yaraft::pb::Message& msg, bool leader, uint64_t term) const;
+
+  // A leadership transfer tells the target to campaign at once, rather than after an
+  // election timeout, which breaks the lease. The lease is invalid from the start of a
+  // transfer for `duration`, by when raft has either finished or abandoned it, and only
+  // the heartbeats sent after that count again.
+  void Suspend(std::chrono::milliseconds duration);
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  // A peer answers the heartbeats of a term at most once each, the k-th response from it
+  // means it has received one sent no earlier than the k-th heartbeat, see Observe.
+  struct Peer {
+    uint64_t term{0};
+    // the send times of the heartbeats of `term` not matched with a response yet.
+    std::deque<Clock::time_point> unanswered;
+    // set if too many heartbeats went unanswered, the responses don't count then until
+    // the next term.
+    bool lost{false};
+
+    // the send time of the heartbeat matched with the latest response.
+    Clock::time_point acked;
+  };
+
+  const Clock::duration lease_;
+  const Clock::duration electionTimeout_;
+
+  mutable std::mutex mu_;
+  std::map<uint64_t, Peer> peers_;
+  Clock::time_point suspendedUntil_;
+
+  // when a follower last heard from the leader of `leaderTerm_`.
+  uint64_t leaderTerm_{0};
+  Clock::time_point heardFromLeader_;
+};
+
+}  // namespace consensus
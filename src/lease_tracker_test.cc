@@ -0,0 +1,143 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/testing.h"
+#include "lease_tracker.h"
+
+#include <thread>
+
+using namespace consensus;
+
+static yaraft::pb::Message message(yaraft::pb::MessageType type, uint64_t from, uint64_t to,
+                                   uint64_t term) {
+  yaraft::pb::Message m;
+  m.set_type(type);
+  m.set_from(from);
+  m.set_to(to);
+  m.set_term(term);
+  return m;
+}
+
+static yaraft::pb::Message heartbeatResp(uint64_t from, uint64_t term) {
+  return message(yaraft::pb::MsgHeartbeatResp, from, 1, term);
+}
+
+// the heartbeats of node 1 to `peers`.
+static std::vector<yaraft::pb::Message> heartbeats(std::vector<uint64_t> peers, uint64_t term) {
+  std::vector<yaraft::pb::Message> msgs;
+  for (uint64_t p : peers) {
+    msgs.push_back(message(yaraft::pb::MsgHeartbeat, 1, p, term));
+  }
+  return msgs;
+}
+
+TEST(LeaseTrackerTest, Quorum) {
+  LeaseTracker lease(1, {1, 2, 3, 4, 5}, std::chrono::milliseconds(100),
+                     std::chrono::milliseconds(200));
+  ASSERT_FALSE(lease.Valid(2));
+
+  lease.Sent(heartbeats({2, 3, 4, 5}, 2));
+  lease.Observe(heartbeatResp(2, 2));
+  ASSERT_FALSE(lease.Valid(2));
+  lease.Observe(heartbeatResp(3, 2));
+  ASSERT_TRUE(lease.Valid(2));
+
+  // the responses of other terms don't count.
+  ASSERT_FALSE(lease.Valid(3));
+  lease.Observe(heartbeatResp(4, 1));
+  lease.Observe(heartbeatResp(2, 1));
+  ASSERT_TRUE(lease.Valid(2));
+
+  // expired
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  ASSERT_FALSE(lease.Valid(2));
+}
+
+// This test verifies that the lease is measured from when the heartbeats are sent, and
+// that only the responses to them count.
+TEST(LeaseTrackerTest, SendTime) {
+  LeaseTracker lease(1, {1, 2, 3}, std::chrono::milliseconds(100),
+                     std::chrono::milliseconds(200));
+
+  // no heartbeat is answered.
+  lease.Observe(heartbeatResp(2, 2));
+  ASSERT_FALSE(lease.Valid(2));
+
+  lease.Sent(heartbeats({2, 3}, 2));
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  lease.Observe(heartbeatResp(2, 2));
+  ASSERT_TRUE(lease.Valid(2));
+
+  // expired 100ms after the heartbeat is sent, though 60ms after the response.
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  ASSERT_FALSE(lease.Valid(2));
+
+  // each heartbeat is answered once.
+  lease.Observe(heartbeatResp(2, 2));
+  ASSERT_FALSE(lease.Valid(2));
+  lease.Sent(heartbeats({2, 3}, 2));
+  lease.Observe(heartbeatResp(2, 2));
+  ASSERT_TRUE(lease.Valid(2));
+}
+
+TEST(LeaseTrackerTest, Suspend) {
+  LeaseTracker lease(1, {1, 2, 3}, std::chrono::milliseconds(1000),
+                     std::chrono::milliseconds(2000));
+  lease.Sent(heartbeats({2, 3}, 2));
+  lease.Observe(heartbeatResp(2, 2));
+  ASSERT_TRUE(lease.Valid(2));
+
+  // no response counts while a transfer may be in progress.
+  lease.Suspend(std::chrono::milliseconds(100));
+  ASSERT_FALSE(lease.Valid(2));
+  lease.Sent(heartbeats({2, 3}, 2));
+  lease.Observe(heartbeatResp(2, 2));
+  lease.Observe(heartbeatResp(3, 2));
+  ASSERT_FALSE(lease.Valid(2));
+
+  // nor do the ones to the heartbeats sent before its end afterwards.
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  ASSERT_FALSE(lease.Valid(2));
+  lease.Observe(heartbeatResp(3, 2));
+  ASSERT_FALSE(lease.Valid(2));
+  lease.Sent(heartbeats({2, 3}, 2));
+  lease.Observe(heartbeatResp(3, 2));
+  ASSERT_TRUE(lease.Valid(2));
+}
+
+// This test verifies that a follower drops the votes for an election timeout since it
+// last heard from the leader, and the leader drops them while it holds the lease.
+TEST(LeaseTrackerTest, RejectVote) {
+  yaraft::pb::Message vote = message(yaraft::pb::MsgVote, 3, 2, 3);
+
+  LeaseTracker follower(2, {1, 2, 3}, std::chrono::milliseconds(100),
+                        std::chrono::milliseconds(200));
+  ASSERT_FALSE(follower.RejectVote(vote, false, 0));
+  follower.Observe(message(yaraft::pb::MsgHeartbeat, 1, 2, 2));
+  ASSERT_TRUE(follower.RejectVote(vote, false, 2));
+  ASSERT_FALSE(follower.RejectVote(message(yaraft::pb::MsgVoteResp, 3, 2, 3), false, 2));
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  ASSERT_FALSE(follower.RejectVote(vote, false, 2));
+
+  LeaseTracker leader(1, {1, 2, 3}, std::chrono::milliseconds(1000),
+                      std::chrono::milliseconds(2000));
+  ASSERT_FALSE(leader.RejectVote(vote, true, 2));
+  leader.Sent(heartbeats({2, 3}, 2));
+  leader.Observe(heartbeatResp(2, 2));
+  ASSERT_TRUE(leader.RejectVote(vote, true, 2));
+
+  // the target of a transfer is voted for.
+  leader.Suspend(std::chrono::milliseconds(100));
+  ASSERT_FALSE(leader.RejectVote(vote, true, 2));
+}
@@ -0,0 +1,296 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures how the components shared by the raft groups of a process scale with the
+// number of groups. Each of the 3 simulated nodes runs all its groups on one TaskQueue,
+// RaftTimer, ReadyFlusher and SharedWriteAheadLog, the messages are passed through an
+// rpc::MemTransport per group, and the wal is kept in Env::Memory(), so that neither
+// the network nor the disk is measured.
+//
+// Once every group has a leader, the cluster idles for a while, then takes writes from
+// many threads spread over all groups. The counters are:
+// - idle_cpu_pct: the CPU time of the process while idle, in percent of a core.
+// - tick_p50_us, tick_p99_us, tick_max_us: how long a task in the urgent lane, where the
+//   ticks go, waits for the TaskQueue of its node.
+// - idle_elections, write_elections: the term changes in all groups, there should be
+//   none once the leaders are settled.
+// - writes_per_sec: the aggregate commit throughput.
+// Run with --benchmark_format=json for machine-readable results.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "base/logging.h"
+#include "replicated_log.h"
+#include "rpc/mem_transport.h"
+
+#include <benchmark/benchmark.h>
+
+using namespace consensus;
+using Clock = std::chrono::steady_clock;
+
+static const uint64_t kNodes = 3;
+
+// The components shared by all groups on a node.
+struct BenchNode {
+  explicit BenchNode(uint64_t id) : taskQueue(new TaskQueue) {
+    wal::WriteAheadLogOptions options;
+    options.env = Env::Memory();
+    options.log_dir = fmt::format("/consensus-multi-raft-bench/node-{}", id);
+    FATAL_NOT_OK(wal::SharedWriteAheadLog::Open(options, &walEngine),
+                 "SharedWriteAheadLog::Open");
+    dir = options.log_dir;
+  }
+
+  ~BenchNode() {
+    walEngine.reset();
+    WARN_NOT_OK(Env::Memory()->DeleteRecursively(dir), "Env::DeleteRecursively");
+  }
+
+  std::string dir;
+  // shared by the logs of the node.
+  std::shared_ptr<TaskQueue> taskQueue;
+  RaftTimer timer;
+  ReadyFlusher flusher;
+  wal::SharedWriteAheadLogUPtr walEngine;
+};
+
+class MultiRaftCluster {
+ public:
+  explicit MultiRaftCluster(size_t groups) : transports_(groups) {
+    for (uint64_t id = 1; id <= kNodes; id++) {
+      nodes_.emplace_back(new BenchNode(id));
+    }
+
+    std::map<uint64_t, std::string> peers;
+    for (uint64_t id = 1; id <= kNodes; id++) {
+      peers[id] = "mem";
+    }
+
+    for (size_t g = 0; g < groups; g++) {
+      for (uint64_t id = 1; id <= kNodes; id++) {
+        BenchNode* node = nodes_[id - 1].get();
+
+        ReplicatedLogOptions options;
+        options.initial_cluster = peers;
+        options.id = id;
+        options.group_id = g;
+        options.heartbeat_interval = 100;
+        // the leaders are spread over the nodes, as memkv does for its shards.
+        options.election_timeout = g % kNodes == id - 1 ? 1000 : 1500;
+        options.taskQueue = node->taskQueue;
+        options.timer = &node->timer;
+        options.flusher = &node->flusher;
+        options.cluster = transports_[g].NewCluster();
+
+        yaraft::MemStoreUptr memstore;
+        FATAL_NOT_OK(node->walEngine->OpenGroup(g, &options.wal, &memstore),
+                     "SharedWriteAheadLog::OpenGroup");
+        options.memstore = memstore.release();
+
+        StatusWith<ReplicatedLog*> sw = ReplicatedLog::New(options);
+        FATAL_NOT_OK(sw.GetStatus(), "ReplicatedLog::New");
+        logs_.emplace_back(sw.GetValue());
+        transports_[g].Register(id, logs_.back()->RaftTaskExecutorInstance());
+      }
+    }
+  }
+
+  ~MultiRaftCluster() {
+    for (size_t g = 0; g < transports_.size(); g++) {
+      for (uint64_t id = 1; id <= kNodes; id++) {
+        transports_[g].Unregister(id);
+      }
+    }
+    // the logs go ahead of the components they share.
+    logs_.clear();
+    nodes_.clear();
+  }
+
+  // Returns the leaders of the groups that have one.
+  std::vector<ReplicatedLog*> Leaders() const {
+    std::vector<ReplicatedLog*> leaders;
+    for (const auto& log : logs_) {
+      if (log->GetRaftState().leader == log->Id()) {
+        leaders.push_back(log.get());
+      }
+    }
+    return leaders;
+  }
+
+  // The sum of the terms of all groups, as seen by their first node.
+  uint64_t SumOfTerms() const {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < logs_.size(); i += kNodes) {
+      sum += logs_[i]->GetRaftState().term;
+    }
+    return sum;
+  }
+
+  size_t Groups() const {
+    return transports_.size();
+  }
+
+  const std::vector<std::unique_ptr<BenchNode>>& Nodes() const {
+    return nodes_;
+  }
+
+ private:
+  std::vector<rpc::MemTransport> transports_;
+  std::vector<std::unique_ptr<BenchNode>> nodes_;
+  std::vector<std::unique_ptr<ReplicatedLog>> logs_;
+};
+
+static double cpuSeconds() {
+  struct rusage usage;
+  ::getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// Probes the TaskQueue of every node through the urgent lane every 10ms, recording how
+// long each probe waits, until `stop` is set.
+static std::vector<int64_t> probeTicks(const MultiRaftCluster& cluster,
+                                       const std::atomic<bool>& stop) {
+  std::mutex mu;
+  std::vector<int64_t> delays;
+  std::atomic<int> pending(0);
+  while (!stop.load()) {
+    for (const auto& node : cluster.Nodes()) {
+      Clock::time_point queued = Clock::now();
+      pending++;
+      node->taskQueue->EnqueueUrgent([queued, &mu, &delays, &pending]() {
+        int64_t us =
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - queued).count();
+        std::lock_guard<std::mutex> g(mu);
+        delays.push_back(us);
+        pending--;
+      });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  while (pending.load() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return delays;
+}
+
+// Writes to the leaders round-robin, keeping up to `depth` writes inflight, until
+// `stop` is set. Returns the number of committed writes.
+static uint64_t writeLoop(const std::vector<ReplicatedLog*>& leaders, size_t first,
+                          size_t depth, const std::atomic<bool>& stop) {
+  std::mutex mu;
+  std::condition_variable cv;
+  size_t inflight = 0;
+  uint64_t committed = 0;
+  std::string data(256, 'a');
+
+  for (size_t i = first; !stop.load(); i++) {
+    {
+      std::unique_lock<std::mutex> lock(mu);
+      cv.wait(lock, [&]() { return inflight < depth; });
+      inflight++;
+    }
+    leaders[i % leaders.size()]->AsyncWrite(data, [&](const Status& s, uint64_t) {
+      std::lock_guard<std::mutex> g(mu);
+      committed += s.IsOK();
+      inflight--;
+      cv.notify_one();
+    });
+  }
+
+  std::unique_lock<std::mutex> lock(mu);
+  cv.wait(lock, [&]() { return inflight == 0; });
+  return committed;
+}
+
+// Args: groups
+void MultiRaftBench(benchmark::State& state) {
+  const auto kIdlePeriod = std::chrono::seconds(3);
+  const auto kWritePeriod = std::chrono::seconds(3);
+  const int kWriters = 16;
+
+  MultiRaftCluster cluster(state.range(0));
+
+  // wait for the elections, for up to a minute.
+  Clock::time_point deadline = Clock::now() + std::chrono::minutes(1);
+  while (cluster.Leaders().size() < cluster.Groups() && Clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  state.counters["leaderless_groups"] = cluster.Groups() - cluster.Leaders().size();
+
+  while (state.KeepRunning()) {
+    // idle
+    std::atomic<bool> stop(false);
+    uint64_t terms = cluster.SumOfTerms();
+    double cpu = cpuSeconds();
+    std::vector<int64_t> delays;
+    std::thread prober([&]() { delays = probeTicks(cluster, stop); });
+    std::this_thread::sleep_for(kIdlePeriod);
+    state.counters["idle_cpu_pct"] =
+        (cpuSeconds() - cpu) * 100 / std::chrono::duration<double>(kIdlePeriod).count();
+    state.counters["idle_elections"] = cluster.SumOfTerms() - terms;
+    stop = true;
+    prober.join();
+    std::sort(delays.begin(), delays.end());
+    if (!delays.empty()) {
+      state.counters["tick_p50_us"] = delays[delays.size() / 2];
+      state.counters["tick_p99_us"] = delays[delays.size() * 99 / 100];
+      state.counters["tick_max_us"] = delays.back();
+    }
+
+    // writes
+    std::vector<ReplicatedLog*> leaders = cluster.Leaders();
+    if (leaders.empty()) {
+      state.SkipWithError("no leader elected");
+      break;
+    }
+    stop = false;
+    terms = cluster.SumOfTerms();
+    std::atomic<uint64_t> committed(0);
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> writers;
+    for (int w = 0; w < kWriters; w++) {
+      writers.emplace_back([&, w]() { committed += writeLoop(leaders, w, 8, stop); });
+    }
+    std::this_thread::sleep_for(kWritePeriod);
+    stop = true;
+    for (auto& t : writers) {
+      t.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    state.SetIterationTime(elapsed);
+    state.counters["writes_per_sec"] = committed.load() / elapsed;
+    state.counters["write_elections"] = cluster.SumOfTerms() - terms;
+  }
+}
+
+BENCHMARK(MultiRaftBench)
+    ->ArgName("groups")
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Iterations(1)
+    ->UseManualTime()
+    ->Unit(benchmark::kSecond);
+
+BENCHMARK_MAIN();
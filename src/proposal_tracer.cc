@@ -0,0 +1,161 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proposal_tracer.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace consensus {
+
+const char* ProposalTracer::StageName(Stage stage) {
+  switch (stage) {
+    case kSubmitted:
+      return "submitted";
+    case kProposed:
+      return "proposed";
+    case kSent:
+      return "sent";
+    case kPersisted:
+      return "persisted";
+    case kCommitted:
+      return "committed";
+    default:
+      return "unknown";
+  }
+}
+
+ProposalTracer::ProposalTracer(uint32_t sampleEvery, size_t capacity)
+    : sampleEvery_(sampleEvery), capacity_(std::max<size_t>(capacity, 1)) {}
+
+bool ProposalTracer::Sample() {
+  if (sampleEvery_ == 0) {
+    return false;
+  }
+  return proposals_.fetch_add(1, std::memory_order_relaxed) % sampleEvery_ == 0;
+}
+
+void ProposalTracer::Begin(uint64_t firstIndex, uint64_t lastIndex, int64_t submittedUs,
+                           int64_t proposedUs) {
+  Trace t;
+  t.firstIndex = firstIndex;
+  t.lastIndex = lastIndex;
+  t.stampUs[kSubmitted] = submittedUs;
+  t.stampUs[kProposed] = proposedUs;
+
+  std::lock_guard<std::mutex> g(mu_);
+  active_[lastIndex] = t;
+  if (active_.size() > capacity_) {
+    active_.erase(active_.begin());
+  }
+  activeCount_.store(active_.size(), std::memory_order_release);
+}
+
+void ProposalTracer::Stamp(Stage stage, uint64_t firstIndex, uint64_t lastIndex, int64_t nowUs) {
+  if (activeCount_.load(std::memory_order_acquire) == 0 || firstIndex > lastIndex) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> g(mu_);
+  for (auto it = active_.lower_bound(firstIndex);
+       it != active_.end() && it->second.firstIndex <= lastIndex; ++it) {
+    if (it->second.stampUs[stage] == 0) {
+      it->second.stampUs[stage] = nowUs;
+    }
+  }
+}
+
+void ProposalTracer::Commit(uint64_t commitIndex, int64_t nowUs) {
+  if (activeCount_.load(std::memory_order_acquire) == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> g(mu_);
+  auto end = active_.upper_bound(commitIndex);
+  for (auto it = active_.begin(); it != end; ++it) {
+    it->second.stampUs[kCommitted] = nowUs;
+    retired_.push_back(it->second);
+    if (retired_.size() > capacity_) {
+      retired_.pop_front();
+    }
+  }
+  active_.erase(active_.begin(), end);
+  activeCount_.store(active_.size(), std::memory_order_release);
+}
+
+std::string ProposalTracer::Breakdown() const {
+  std::vector<int64_t> latencies[kStageNum];
+  {
+    std::lock_guard<std::mutex> g(mu_);
+    for (const Trace& t : retired_) {
+      int64_t prev = t.stampUs[kSubmitted];
+      for (int s = kProposed; s < kStageNum; s++) {
+        if (t.stampUs[s] != 0) {
+          latencies[s].push_back(t.stampUs[s] - prev);
+          prev = t.stampUs[s];
+        }
+      }
+    }
+  }
+
+  std::string out;
+  out += fmt::format("{:<10} {:>8} {:>10} {:>10} {:>10} {:>10}\n", "stage", "count", "avg(us)",
+                     "p50(us)", "p99(us)", "max(us)");
+  for (int s = kProposed; s < kStageNum; s++) {
+    std::vector<int64_t>& l = latencies[s];
+    if (l.empty()) {
+      out += fmt::format("{:<10} {:>8}\n", StageName(static_cast<Stage>(s)), 0);
+      continue;
+    }
+    std::sort(l.begin(), l.end());
+    int64_t sum = 0;
+    for (int64_t v : l) {
+      sum += v;
+    }
+    out += fmt::format("{:<10} {:>8} {:>10} {:>10} {:>10} {:>10}\n",
+                       StageName(static_cast<Stage>(s)), l.size(),
+                       sum / static_cast<int64_t>(l.size()), l[l.size() / 2],
+                       l[std::min(l.size() - 1, l.size() * 99 / 100)], l.back());
+  }
+  return out;
+}
+
+std::string ProposalTracer::ChromeTraceJson() const {
+  std::string out = "{\"traceEvents\":[";
+  bool first = true;
+
+  std::lock_guard<std::mutex> g(mu_);
+  for (const Trace& t : retired_) {
+    // a span ends at the stage it's named after.
+    int64_t prev = t.stampUs[kSubmitted];
+    for (int s = kProposed; s < kStageNum; s++) {
+      if (t.stampUs[s] == 0) {
+        continue;
+      }
+      out += fmt::format(
+          "{}{{\"name\":\"{}\",\"cat\":\"proposal\",\"ph\":\"X\",\"ts\":{},\"dur\":{},"
+          "\"pid\":1,\"tid\":{},\"args\":{{\"first_index\":{},\"last_index\":{}}}}}",
+          first ? "" : ",", StageName(static_cast<Stage>(s)), prev, t.stampUs[s] - prev,
+          t.lastIndex, t.firstIndex, t.lastIndex);
+      first = false;
+      prev = t.stampUs[s];
+    }
+  }
+  out += "]}";
+  return out;
+}
+
+}  // namespace consensus
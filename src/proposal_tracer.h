@@ -0,0 +1,99 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace consensus {
+
+// ProposalTracer follows a sample of the proposals through the write path, stamping
+// the time each stage is reached, so that a latency spike can be attributed to the
+// queueing, the wal, the replication or the commit notification.
+// A trace covers the range of entries proposed together, it's retired into a bounded
+// history once committed. The traces that never commit, e.g. after a leader change,
+// are evicted when too many are active.
+//
+// Thread-Safe
+class ProposalTracer {
+ public:
+  enum Stage {
+    // the write is submitted to the raft thread.
+    kSubmitted = 0,
+    // the entries are appended to the raft log.
+    kProposed,
+    // the entries are passed to the followers, only on the leader with peers.
+    kSent,
+    // the entries are persisted by the wal.
+    kPersisted,
+    // the entries are committed and the writers notified.
+    kCommitted,
+
+    kStageNum
+  };
+
+  static const char* StageName(Stage stage);
+
+  // One in every `sampleEvery` proposals is traced, at most `capacity` traces are kept
+  // active and retired each.
+  ProposalTracer(uint32_t sampleEvery, size_t capacity = 1024);
+
+  // Returns true if the next proposal should be traced.
+  bool Sample();
+
+  // Starts the trace of the entries [firstIndex, lastIndex].
+  void Begin(uint64_t firstIndex, uint64_t lastIndex, int64_t submittedUs, int64_t proposedUs);
+
+  // Stamps `stage` on the traces overlapping the entries [firstIndex, lastIndex].
+  void Stamp(Stage stage, uint64_t firstIndex, uint64_t lastIndex, int64_t nowUs);
+
+  // Stamps kCommitted on the traces up to `commitIndex` and retires them.
+  void Commit(uint64_t commitIndex, int64_t nowUs);
+
+  // The count, average, p50, p99 and max latency of each stage since the previous
+  // stamped one, over the retired traces, one stage per line.
+  std::string Breakdown() const;
+
+  // The retired traces in the Chrome trace-event format, which can be loaded by
+  // chrome://tracing or Perfetto. Each trace is a row of one span per stage.
+  std::string ChromeTraceJson() const;
+
+ private:
+  struct Trace {
+    uint64_t firstIndex{0};
+    uint64_t lastIndex{0};
+    // 0 if the stage is not reached.
+    int64_t stampUs[kStageNum] = {0};
+  };
+
+ private:
+  const uint32_t sampleEvery_;
+  const size_t capacity_;
+  std::atomic<uint64_t> proposals_{0};
+
+  // saves the lock on the hot path while nothing is traced.
+  std::atomic<size_t> activeCount_{0};
+
+  mutable std::mutex mu_;
+  // keyed by the last index.
+  std::map<uint64_t, Trace> active_;
+  std::deque<Trace> retired_;
+};
+
+}  // namespace consensus
@@ -0,0 +1,84 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/testing.h"
+#include "proposal_tracer.h"
+
+using namespace consensus;
+
+TEST(ProposalTracerTest, Sample) {
+  ProposalTracer off(0);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_FALSE(off.Sample());
+  }
+
+  ProposalTracer tracer(4);
+  int sampled = 0;
+  for (int i = 0; i < 16; i++) {
+    sampled += tracer.Sample();
+  }
+  ASSERT_EQ(sampled, 4);
+}
+
+TEST(ProposalTracerTest, Stages) {
+  ProposalTracer tracer(1);
+
+  // stamps are ignored while nothing is traced.
+  tracer.Stamp(ProposalTracer::kPersisted, 1, 10, 5);
+  tracer.Commit(10, 5);
+  ASSERT_EQ(tracer.ChromeTraceJson(), "{\"traceEvents\":[]}");
+
+  tracer.Begin(1, 2, 100, 110);
+  tracer.Begin(3, 3, 120, 125);
+  tracer.Stamp(ProposalTracer::kSent, 1, 3, 130);
+  tracer.Stamp(ProposalTracer::kPersisted, 2, 3, 150);
+  // the earliest stamp stays.
+  tracer.Stamp(ProposalTracer::kPersisted, 3, 3, 160);
+
+  // only the traces up to the commit index are retired.
+  tracer.Commit(2, 200);
+  std::string json = tracer.ChromeTraceJson();
+  ASSERT_NE(json.find("\"name\":\"proposed\",\"cat\":\"proposal\",\"ph\":\"X\",\"ts\":100,"
+                      "\"dur\":10,\"pid\":1,\"tid\":2"),
+            std::string::npos);
+  ASSERT_NE(json.find("\"name\":\"committed\",\"cat\":\"proposal\",\"ph\":\"X\",\"ts\":150,"
+                      "\"dur\":50"),
+            std::string::npos);
+  ASSERT_EQ(json.find("\"tid\":3"), std::string::npos);
+
+  tracer.Commit(3, 300);
+  json = tracer.ChromeTraceJson();
+  ASSERT_NE(json.find("\"name\":\"persisted\",\"cat\":\"proposal\",\"ph\":\"X\",\"ts\":130,"
+                      "\"dur\":20,\"pid\":1,\"tid\":3"),
+            std::string::npos);
+
+  std::string breakdown = tracer.Breakdown();
+  ASSERT_NE(breakdown.find("committed"), std::string::npos);
+  ASSERT_NE(breakdown.find("sent"), std::string::npos);
+}
+
+TEST(ProposalTracerTest, Capacity) {
+  ProposalTracer tracer(1, 2);
+  for (uint64_t i = 1; i <= 4; i++) {
+    tracer.Begin(i, i, 100 * i, 100 * i + 1);
+  }
+  tracer.Commit(4, 1000);
+
+  // the oldest active traces were evicted.
+  std::string json = tracer.ChromeTraceJson();
+  ASSERT_EQ(json.find("\"tid\":1,"), std::string::npos);
+  ASSERT_EQ(json.find("\"tid\":2,"), std::string::npos);
+  ASSERT_NE(json.find("\"tid\":3,"), std::string::npos);
+  ASSERT_NE(json.find("\"tid\":4,"), std::string::npos);
+}
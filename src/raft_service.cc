@@ -15,12 +15,22 @@
 #include "raft_service.h"
 #include "raft_task_executor.h"
 #include "raft_timer.h"
+#include "replicated_log.h"
+#include "snapshot_receiver.h"
 
 #include "base/logging.h"
-#include "base/simple_channel.h"
-
+#include "base/memory_tracker.h"
+#include "base/metrics.h"
+#include "rpc/entry_attachment.h"
+#include "rpc/heartbeat_coalescer.h"
+#include <brpc/closure_guard.h>
+#include <brpc/controller.h>
+#include <brpc/stream.h>
 #include <yaraft/pb_utils.h>
 
+#include <algorithm>
+#include <map>
+
 namespace consensus {
 
 static pb::StatusCode yaraftErrorCodeToRpcStatusCode(yaraft::Error::ErrorCodes code) {
@@ -35,44 +45,368 @@ static pb::StatusCode yaraftErrorCodeToRpcStatusCode(yaraft::Error::ErrorCodes c
   }
 }
 
+// The messages keeping the leadership alive are stepped ahead of the proposals,
+// otherwise a flood of writes may delay them into spurious elections.
+static bool isUrgent(const yaraft::pb::Message &msg) {
+  switch (msg.type()) {
+    case yaraft::pb::MsgHeartbeat:
+    case yaraft::pb::MsgHeartbeatResp:
+    case yaraft::pb::MsgVote:
+    case yaraft::pb::MsgVoteResp:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Steps the messages in one task of the executor, `done` is run after that.
+// `response` can be null if no one is waiting for the codes.
+static void submitBatch(RaftTaskExecutor *executor, pb::StepBatchRequest *req,
+                        pb::StepBatchResponse *response, google::protobuf::Closure *done) {
+  // A batch mixing the normal messages goes through the normal lane, so that it's not
+  // stepped ahead of the batches sent before it.
+  bool urgent = req->messages_size() > 0;
+  bool heartbeats = true;
+  // the dropped messages are answered with OK without being stepped.
+  std::vector<bool> dropped(req->messages_size(), false);
+  for (int i = 0; i < req->messages_size(); i++) {
+    const auto &msg = req->messages(i);
+    dropped[i] = !executor->ObserveInbound(msg);
+    urgent = urgent && isUrgent(msg);
+    heartbeats = heartbeats && rpc::HeartbeatCoalescer::IsHeartbeat(msg);
+  }
+  // the heartbeats don't wake up a quiesced node.
+  if (!heartbeats) {
+    executor->MarkActive();
+  }
+
+  RaftTaskExecutor::RaftTask task = [req, response, done, dropped](yaraft::RawNode *node) {
+    brpc::ClosureGuard doneGuard(done);
+    for (int i = 0; i < req->messages_size(); i++) {
+      if (dropped[i]) {
+        if (response) {
+          response->add_codes(pb::OK);
+        }
+        continue;
+      }
+      auto s = node->Step(*req->mutable_messages(i));
+      if (!response) {
+        continue;
+      }
+      if (UNLIKELY(!s.IsOK())) {
+        response->add_codes(yaraftErrorCodeToRpcStatusCode(s.Code()));
+      } else {
+        response->add_codes(pb::OK);
+      }
+    }
+  };
+  if (urgent) {
+    executor->SubmitUrgent(std::move(task));
+  } else {
+    executor->Submit(std::move(task));
+  }
+}
+
+// Steps `msg` in a task of the executor, `done` is run after that.
+static void submitStep(RaftTaskExecutor *executor, yaraft::pb::Message *msg,
+                       pb::StepResponse *response, google::protobuf::Closure *done) {
+  if (!executor->ObserveInbound(*msg)) {
+    brpc::ClosureGuard doneGuard(done);
+    return;
+  }
+
+  // The response is sent from the executor, the brpc worker returns right away.
+  RaftTaskExecutor::RaftTask task = [msg, response, done](yaraft::RawNode *node) {
+    brpc::ClosureGuard doneGuard(done);
+    auto s = node->Step(*msg);
+    if (UNLIKELY(!s.IsOK())) {
+      response->set_code(yaraftErrorCodeToRpcStatusCode(s.Code()));
+    }
+  };
+  if (!rpc::HeartbeatCoalescer::IsHeartbeat(*msg)) {
+    executor->MarkActive();
+  }
+  if (isUrgent(*msg)) {
+    executor->SubmitUrgent(std::move(task));
+  } else {
+    executor->Submit(std::move(task));
+  }
+}
+
+static void deleteRequest(pb::StepBatchRequest *req) {
+  delete req;
+}
+
+static void groupNotServed(google::protobuf::RpcController *controller, uint64_t groupId,
+                           google::protobuf::Closure *done) {
+  brpc::ClosureGuard doneGuard(done);
+  auto cntl = static_cast<brpc::Controller *>(controller);
+  if (cntl) {
+    cntl->SetFailed(brpc::EREQUEST, "group %lu is not served here", groupId);
+  }
+}
+
+// Each record of the replication stream is a StepBatchRequest, see rpc::EncodeStepBatch.
+// The records are stepped in the order they arrive, in the groups they name.
+class RaftServiceImpl::StreamHandler : public brpc::StreamInputHandler {
+ public:
+  explicit StreamHandler(RaftServiceImpl *service) : service_(service) {}
+
+  int on_received_messages(brpc::StreamId id, butil::IOBuf *const messages[],
+                           size_t size) override {
+    for (size_t i = 0; i < size; i++) {
+      auto req = new pb::StepBatchRequest;
+      consensus::Status s = rpc::DecodeStepBatch(messages[i], req);
+      if (UNLIKELY(!s.IsOK())) {
+        LOG(ERROR) << "closing stream " << id << ": " << s.ToString();
+        delete req;
+        brpc::StreamClose(id);
+        return 0;
+      }
+      google::protobuf::Closure *done = brpc::NewCallback(&deleteRequest, req);
+      if (UNLIKELY(!service_->routeBatch(req, nullptr, done))) {
+        // the group is gone, its peer opens a new stream once it's back.
+        LOG(ERROR) << "closing stream " << id << ": group " << req->group_id()
+                   << " is not served here";
+        done->Run();
+        brpc::StreamClose(id);
+        return 0;
+      }
+    }
+    return 0;
+  }
+
+  void on_idle_timeout(brpc::StreamId id) override {}
+
+  void on_closed(brpc::StreamId id) override {}
+
+ private:
+  RaftServiceImpl *service_;
+};
+
+RaftServiceImpl::RaftServiceImpl(RaftTaskExecutor *executor, rpc::HeartbeatCoalescer *coalescer,
+                                 SnapshotReceiver *receiver)
+    : single_(new Group{nullptr, executor, receiver}),
+      coalescer_(coalescer),
+      streamHandler_(new StreamHandler(this)) {}
+
+RaftServiceImpl::RaftServiceImpl(ReplicatedLog *log, rpc::HeartbeatCoalescer *coalescer)
+    : RaftServiceImpl(log->RaftTaskExecutorInstance(), coalescer,
+                      log->SnapshotReceiverInstance()) {
+  single_->log = log;
+}
+
+RaftServiceImpl::RaftServiceImpl() : streamHandler_(new StreamHandler(this)) {}
+
+RaftServiceImpl::~RaftServiceImpl() = default;
+
+void RaftServiceImpl::AddGroup(ReplicatedLog *log) {
+  boost::unique_lock<boost::shared_mutex> lock(mu_);
+  groups_[log->GroupId()] =
+      Group{log, log->RaftTaskExecutorInstance(), log->SnapshotReceiverInstance()};
+}
+
+void RaftServiceImpl::RemoveGroup(uint64_t groupId) {
+  boost::unique_lock<boost::shared_mutex> lock(mu_);
+  groups_.erase(groupId);
+}
+
+bool RaftServiceImpl::route(uint64_t groupId, const std::function<void(const Group &)> &f) {
+  if (single_) {
+    f(*single_);
+    return true;
+  }
+  boost::shared_lock<boost::shared_mutex> lock(mu_);
+  auto it = groups_.find(groupId);
+  if (it == groups_.end()) {
+    return false;
+  }
+  f(it->second);
+  return true;
+}
+
+bool RaftServiceImpl::routeBatch(pb::StepBatchRequest *req, pb::StepBatchResponse *response,
+                                 google::protobuf::Closure *done) {
+  return route(req->group_id(), [req, response, done](const Group &g) {
+    submitBatch(g.executor, req, response, done);
+  });
+}
+
 void RaftServiceImpl::Step(google::protobuf::RpcController *controller,
                            const pb::StepRequest *request, pb::StepResponse *response,
                            google::protobuf::Closure *done) {
   yaraft::pb::Message *msg = const_cast<pb::StepRequest *>(request)->mutable_message();
 
   response->set_code(pb::OK);
+  bool served = route(request->group_id(), [msg, response, done](const Group &g) {
+    submitStep(g.executor, msg, response, done);
+  });
+  if (UNLIKELY(!served)) {
+    groupNotServed(controller, request->group_id(), done);
+  }
+}
 
-  Barrier barrier;
-  executor_->Submit(std::bind(
-      [&](yaraft::RawNode *node) {
-        auto s = node->Step(*msg);
-        if (UNLIKELY(!s.IsOK())) {
-          response->set_code(yaraftErrorCodeToRpcStatusCode(s.Code()));
-        }
-        barrier.Signal();
-      },
-      std::placeholders::_1));
-  barrier.Wait();
+void RaftServiceImpl::StepBatch(google::protobuf::RpcController *controller,
+                                const pb::StepBatchRequest *request,
+                                pb::StepBatchResponse *response,
+                                google::protobuf::Closure *done) {
+  auto req = const_cast<pb::StepBatchRequest *>(request);
+
+  auto cntl = static_cast<brpc::Controller *>(controller);
+  if (cntl) {
+    consensus::Status s = rpc::MoveEntriesFromAttachment(&cntl->request_attachment(), req);
+    if (UNLIKELY(!s.IsOK())) {
+      brpc::ClosureGuard doneGuard(done);
+      cntl->SetFailed(brpc::EREQUEST, "%s", s.ToString().c_str());
+      return;
+    }
+  }
+
+  StreamHandler *handler = streamHandler_.get();
+  bool served = route(req->group_id(), [cntl, handler, req, response, done](const Group &g) {
+    if (cntl && cntl->has_remote_stream()) {
+      // following batches from this peer come through the stream.
+      brpc::StreamId stream;
+      brpc::StreamOptions options;
+      options.handler = handler;
+      if (brpc::StreamAccept(&stream, *cntl, &options) != 0) {
+        cntl->SetFailed("failed to accept stream");
+      }
+    }
+    submitBatch(g.executor, req, response, done);
+  });
+  if (UNLIKELY(!served)) {
+    groupNotServed(controller, req->group_id(), done);
+  }
+}
+
+void RaftServiceImpl::HeartbeatBatch(google::protobuf::RpcController *controller,
+                                     const pb::HeartbeatBatchRequest *request,
+                                     pb::HeartbeatBatchResponse *response,
+                                     google::protobuf::Closure *done) {
+  brpc::ClosureGuard doneGuard(done);
+  auto req = const_cast<pb::HeartbeatBatchRequest *>(request);
+  if (coalescer_) {
+    coalescer_->Deliver(req);
+    return;
+  }
+
+  if (single_) {
+    // this node hosts only one group.
+    auto batch = new pb::StepBatchRequest;
+    batch->mutable_messages()->Swap(req->mutable_messages());
+    submitBatch(single_->executor, batch, nullptr, brpc::NewCallback(&deleteRequest, batch));
+    return;
+  }
+
+  std::map<uint64_t, pb::StepBatchRequest *> batches;
+  int n = std::min(req->group_ids_size(), req->messages_size());
+  for (int i = 0; i < n; i++) {
+    pb::StepBatchRequest *&batch = batches[req->group_ids(i)];
+    if (!batch) {
+      batch = new pb::StepBatchRequest;
+      batch->set_group_id(req->group_ids(i));
+    }
+    batch->add_messages()->Swap(req->mutable_messages(i));
+  }
+  // the heartbeats of the groups not served here are dropped, like the lost ones.
+  for (const auto &e : batches) {
+    google::protobuf::Closure *batchDone = brpc::NewCallback(&deleteRequest, e.second);
+    if (!routeBatch(e.second, nullptr, batchDone)) {
+      batchDone->Run();
+    }
+  }
+}
+
+void RaftServiceImpl::InstallSnapshot(google::protobuf::RpcController *controller,
+                                      const pb::InstallSnapshotRequest *request,
+                                      pb::InstallSnapshotResponse *response,
+                                      google::protobuf::Closure *done) {
+  auto cntl = static_cast<brpc::Controller *>(controller);
+  bool served = route(request->group_id(), [cntl, request, done](const Group &g) {
+    if (!g.receiver) {
+      brpc::ClosureGuard doneGuard(done);
+      cntl->SetFailed(brpc::EREQUEST, "snapshot is not supported");
+      return;
+    }
+
+    // the chunk is written before Receive returns.
+    std::string chunk = cntl->request_attachment().to_string();
+    g.receiver->Receive(*request, chunk, [cntl, done](const consensus::Status &s) {
+      brpc::ClosureGuard doneGuard(done);
+      if (UNLIKELY(!s.IsOK())) {
+        cntl->SetFailed(brpc::EINTERNAL, "%s", s.ToString().c_str());
+      }
+    });
+  });
+  if (UNLIKELY(!served)) {
+    groupNotServed(controller, request->group_id(), done);
+  }
+}
+
+void RaftServiceImpl::ReadIndex(google::protobuf::RpcController *controller,
+                                const pb::ReadIndexRequest *request,
+                                pb::ReadIndexResponse *response,
+                                google::protobuf::Closure *done) {
+  auto cntl = static_cast<brpc::Controller *>(controller);
+  bool served = route(request->group_id(), [cntl, request, response, done](const Group &g) {
+    ReplicatedLog *log = g.log;
+    if (!log || request->group_id() != log->GroupId()) {
+      brpc::ClosureGuard doneGuard(done);
+      cntl->SetFailed(brpc::EREQUEST, "group %lu is not served here", request->group_id());
+      return;
+    }
+    // the request is not forwarded again, in case the nodes disagree on the leader.
+    if (log->GetRaftState().leader != log->Id()) {
+      brpc::ClosureGuard doneGuard(done);
+      cntl->SetFailed(brpc::EREQUEST, "not leader");
+      return;
+    }
 
-  done->Run();
+    log->AsyncReadIndex([cntl, response, done](const consensus::Status &s, uint64_t index) {
+      brpc::ClosureGuard doneGuard(done);
+      if (UNLIKELY(!s.IsOK())) {
+        cntl->SetFailed(brpc::EINTERNAL, "%s", s.ToString().c_str());
+        return;
+      }
+      response->set_index(index);
+    });
+  });
+  if (UNLIKELY(!served)) {
+    groupNotServed(controller, request->group_id(), done);
+  }
 }
 
 void RaftServiceImpl::Status(::google::protobuf::RpcController *controller,
                              const pb::StatusRequest *request, pb::StatusResponse *response,
                              ::google::protobuf::Closure *done) {
-  Barrier barrier;
-  executor_->Submit(std::bind(
-      [&](yaraft::RawNode *node) {
-        response->set_leader(node->LeaderHint());
-        response->set_raftindex(node->LastIndex());
-        response->set_raftterm(node->CurrentTerm());
-
-        barrier.Signal();
-      },
-      std::placeholders::_1));
-  barrier.Wait();
-
-  done->Run();
+  bool served = route(request->group_id(), [response](const Group &g) {
+    RaftState state = g.executor->State();
+    response->set_leader(state.leader);
+    response->set_raftindex(state.lastIndex);
+    response->set_raftterm(state.term);
+  });
+  if (UNLIKELY(!served)) {
+    groupNotServed(controller, request->group_id(), done);
+    return;
+  }
+
+  brpc::ClosureGuard doneGuard(done);
+
+  Metrics &metrics = Metrics::Instance();
+  response->set_walappendbytes(static_cast<uint64_t>(metrics.walAppendBytes.get_value()));
+  response->set_walsynclatencyus(static_cast<uint64_t>(metrics.walSyncLatency.latency()));
+  response->set_commitlatencyus(static_cast<uint64_t>(metrics.commitLatency.latency()));
+  response->set_proposalsinflight(static_cast<uint64_t>(metrics.proposalsInflight.get_value()));
+
+  MemoryTracker &tracker = MemoryTracker::Instance();
+  for (int c = 0; c < MemoryTracker::kComponentCount; c++) {
+    auto component = static_cast<MemoryTracker::Component>(c);
+    pb::MemoryUsage *usage = response->add_memory();
+    usage->set_component(MemoryTracker::ComponentName(component));
+    usage->set_bytes(static_cast<uint64_t>(tracker.Usage(component)));
+  }
+  response->set_memorysoftlimit(static_cast<uint64_t>(tracker.SoftLimit()));
 }
 
 }  // namespace consensus
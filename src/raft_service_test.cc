@@ -14,6 +14,20 @@
 
 #include "raft_service.h"
 #include "raft_task_executor_test.h"
+#include "replicated_log.h"
+
+#include "base/metrics.h"
+#include "base/simple_channel.h"
+#include "rpc/entry_attachment.h"
+#include "rpc/heartbeat_coalescer.h"
+#include "rpc/mem_transport.h"
+#include "rpc/raft_client.h"
+#include "snapshot_receiver.h"
+
+#include <brpc/controller.h>
+
+#include <condition_variable>
+#include <thread>
 
 using namespace consensus;
 
@@ -32,15 +46,564 @@ TEST_F(RaftServiceTest, Step) {
   auto msg = new yaraft::pb::Message;
   msg->set_type(yaraft::pb::MsgHup);
   request.set_allocated_message(msg);
-  auto done = google::protobuf::NewCallback([]() {});
-  service.Step(nullptr, &request, &response, done);
+  {
+    Barrier barrier;
+    auto done = google::protobuf::NewCallback([&]() { barrier.Signal(); });
+    service.Step(nullptr, &request, &response, done);
+    barrier.Wait();
+  }
   ASSERT_EQ(response.code(), pb::StepLocalMsg);
 
   msg = new yaraft::pb::Message;
   msg->set_from(111);
   msg->set_type(yaraft::pb::MsgHeartbeatResp);
   request.set_allocated_message(msg);
-  done = google::protobuf::NewCallback([]() {});
-  service.Step(nullptr, &request, &response, done);
+  {
+    Barrier barrier;
+    auto done = google::protobuf::NewCallback([&]() { barrier.Signal(); });
+    service.Step(nullptr, &request, &response, done);
+    barrier.Wait();
+  }
   ASSERT_EQ(response.code(), pb::StepPeerNotFound);
-}
\ No newline at end of file
+}
+TEST_F(RaftServiceTest, StepBatch) {
+  yaraft::RawNode node(conf_);
+  RaftTaskExecutor executor(&node, taskQueue_);
+  RaftServiceImpl service(&executor);
+
+  pb::StepBatchResponse response;
+  pb::StepBatchRequest request;
+
+  request.add_messages()->set_type(yaraft::pb::MsgHup);
+  auto msg = request.add_messages();
+  msg->set_from(111);
+  msg->set_type(yaraft::pb::MsgHeartbeatResp);
+
+  Barrier barrier;
+  auto done = google::protobuf::NewCallback([&]() { barrier.Signal(); });
+  service.StepBatch(nullptr, &request, &response, done);
+  barrier.Wait();
+
+  ASSERT_EQ(response.codes_size(), 2);
+  ASSERT_EQ(response.codes(0), pb::StepLocalMsg);
+  ASSERT_EQ(response.codes(1), pb::StepPeerNotFound);
+}
+
+TEST(EntryAttachmentTest, RoundTrip) {
+  pb::StepBatchRequest request;
+  for (int i = 0; i < 3; i++) {
+    auto msg = request.add_messages();
+    msg->set_type(yaraft::pb::MsgApp);
+    for (int k = 0; k < i + 1; k++) {
+      auto e = msg->add_entries();
+      e->set_index(k + 1);
+      e->set_data(std::string(k * 1000, 'a' + i));
+    }
+  }
+  pb::StepBatchRequest expected = request;
+
+  butil::IOBuf attachment;
+  rpc::MoveEntriesToAttachment(&request, &attachment);
+  ASSERT_EQ(request.messages(2).entries(2).data().size(), 0);
+
+  ASSERT_OK(rpc::MoveEntriesFromAttachment(&attachment, &request));
+  ASSERT_EQ(request.SerializeAsString(), expected.SerializeAsString());
+
+  // an attachment not matching the entries
+  rpc::MoveEntriesToAttachment(&request, &attachment);
+  attachment.pop_back(1);
+  ASSERT_FALSE(rpc::MoveEntriesFromAttachment(&attachment, &request).IsOK());
+}
+
+// The entries appended to many peers are copied once, their attachments share the blocks.
+TEST(EntryAttachmentTest, SharedPayloads) {
+  pb::StepBatchRequest request;
+  auto msg = request.add_messages();
+  msg->set_type(yaraft::pb::MsgApp);
+  auto e = msg->add_entries();
+  e->set_index(1);
+  e->set_term(1);
+  e->set_data(std::string(4096, 'a'));
+  msg->add_entries()->set_index(2);
+  pb::StepBatchRequest expected = request;
+
+  rpc::EntryPayloadCache cache;
+  pb::StepBatchRequest r1 = request, r2 = request;
+  butil::IOBuf a1, a2;
+  rpc::MoveEntriesToAttachment(&r1, &a1, &cache);
+  rpc::MoveEntriesToAttachment(&r2, &a2, &cache);
+  ASSERT_EQ(a1.to_string(), a2.to_string());
+  ASSERT_EQ(a1.backing_block(1).data(), a2.backing_block(1).data());
+
+  ASSERT_OK(rpc::MoveEntriesFromAttachment(&a2, &r2));
+  ASSERT_EQ(r2.SerializeAsString(), expected.SerializeAsString());
+
+  // an entry of another term at the same index is not mistaken for the cached one.
+  pb::StepBatchRequest r3 = expected;
+  r3.mutable_messages(0)->mutable_entries(0)->set_term(2);
+  r3.mutable_messages(0)->mutable_entries(0)->set_data("b");
+  pb::StepBatchRequest expected3 = r3;
+  butil::IOBuf a3;
+  rpc::MoveEntriesToAttachment(&r3, &a3, &cache);
+  ASSERT_OK(rpc::MoveEntriesFromAttachment(&a3, &r3));
+  ASSERT_EQ(r3.SerializeAsString(), expected3.SerializeAsString());
+}
+
+TEST(EntryAttachmentTest, StepBatchRecord) {
+  pb::StepBatchRequest request;
+  auto msg = request.add_messages();
+  msg->set_type(yaraft::pb::MsgApp);
+  msg->set_to(2);
+  msg->add_entries()->set_data(std::string(4096, 'a'));
+  request.add_messages()->set_type(yaraft::pb::MsgHeartbeat);
+  pb::StepBatchRequest expected = request;
+
+  butil::IOBuf record;
+  rpc::EncodeStepBatch(&request, &record);
+
+  pb::StepBatchRequest decoded;
+  ASSERT_OK(rpc::DecodeStepBatch(&record, &decoded));
+  ASSERT_EQ(decoded.SerializeAsString(), expected.SerializeAsString());
+}
+
+TEST(EntryAttachmentTest, CompressedPayloads) {
+  pb::StepBatchRequest request;
+  auto msg = request.add_messages();
+  msg->set_type(yaraft::pb::MsgApp);
+  msg->add_entries()->set_data(std::string(4096, 'a'));
+  msg->add_entries()->set_data("b");
+  pb::StepBatchRequest expected = request;
+
+  // below the threshold the payloads are left as they are.
+  pb::StepBatchRequest r1 = request;
+  butil::IOBuf a1;
+  rpc::MoveEntriesToAttachment(&r1, &a1);
+  rpc::CompressPayloads(wal::kZlibCompression, 1 << 20, &r1, &a1);
+  ASSERT_FALSE(r1.has_payloadcompression());
+
+  pb::StepBatchRequest r2 = request;
+  butil::IOBuf a2;
+  rpc::MoveEntriesToAttachment(&r2, &a2);
+  size_t rawLength = a2.size();
+  rpc::CompressPayloads(wal::kZlibCompression, 1024, &r2, &a2);
+  ASSERT_TRUE(r2.has_payloadcompression());
+  ASSERT_EQ(r2.payloadlength(), rawLength);
+  ASSERT_LT(a2.size(), rawLength);
+  ASSERT_OK(rpc::MoveEntriesFromAttachment(&a2, &r2));
+  ASSERT_EQ(r2.SerializeAsString(), expected.SerializeAsString());
+
+  pb::StepBatchRequest r3 = request;
+  butil::IOBuf record;
+  rpc::EncodeStepBatch(&r3, &record, nullptr, wal::kZlibCompression, 1024);
+  pb::StepBatchRequest decoded;
+  ASSERT_OK(rpc::DecodeStepBatch(&record, &decoded));
+  ASSERT_EQ(decoded.SerializeAsString(), expected.SerializeAsString());
+}
+
+TEST_F(RaftServiceTest, HeartbeatBatch) {
+  yaraft::RawNode node(conf_);
+  RaftTaskExecutor executor(&node, taskQueue_);
+  rpc::HeartbeatCoalescer coalescer;
+  RaftServiceImpl service(&executor, &coalescer);
+
+  std::vector<yaraft::pb::Message> received;
+  coalescer.RegisterGroup(7, [&](std::vector<yaraft::pb::Message> &msgs) {
+    received.insert(received.end(), msgs.begin(), msgs.end());
+  });
+
+  pb::HeartbeatBatchRequest request;
+  pb::HeartbeatBatchResponse response;
+  for (uint64_t group : {7, 8, 7}) {
+    request.add_group_ids(group);
+    auto msg = request.add_messages();
+    msg->set_type(yaraft::pb::MsgHeartbeat);
+    msg->set_commit(group);
+  }
+
+  // messages of the unknown group 8 are dropped.
+  service.HeartbeatBatch(nullptr, &request, &response, google::protobuf::NewCallback([]() {}));
+  ASSERT_EQ(received.size(), 2);
+  for (const auto &m : received) {
+    ASSERT_EQ(m.commit(), 7);
+  }
+}
+
+class StringSnapshotWriter : public SnapshotWriter {
+ public:
+  explicit StringSnapshotWriter(std::string *installed) : installed_(installed) {}
+
+  consensus::Status Write(const Slice &chunk) override {
+    buf_.append(chunk.data(), chunk.size());
+    return consensus::Status::OK();
+  }
+
+  consensus::Status Finish() override {
+    *installed_ = buf_;
+    return consensus::Status::OK();
+  }
+
+  void Abort() override {}
+
+ private:
+  std::string buf_;
+  std::string *installed_;
+};
+
+class StringSnapshotter : public Snapshotter {
+ public:
+  consensus::Status OpenSnapshot(uint64_t index, std::unique_ptr<SnapshotReader> *reader) override {
+    return consensus::Status::Make(Error::NotSupported);
+  }
+
+  consensus::Status BeginInstall(uint64_t index, uint64_t term,
+                                 std::unique_ptr<SnapshotWriter> *writer) override {
+    writer->reset(new StringSnapshotWriter(&installed));
+    return consensus::Status::OK();
+  }
+
+  std::string installed;
+};
+
+TEST_F(RaftServiceTest, InstallSnapshot) {
+  yaraft::RawNode node(conf_);
+  RaftTaskExecutor executor(&node, taskQueue_);
+  StringSnapshotter snapshotter;
+  SnapshotReceiver receiver(&executor, &snapshotter, nullptr);
+  RaftServiceImpl service(&executor, nullptr, &receiver);
+
+  auto install = [&](uint64_t offset, const std::string &chunk, bool done) {
+    pb::InstallSnapshotRequest request;
+    pb::InstallSnapshotResponse response;
+    auto msg = request.mutable_message();
+    msg->set_type(yaraft::pb::MsgSnap);
+    msg->set_from(2);
+    msg->set_to(1);
+    msg->set_term(2);
+    msg->mutable_snapshot()->mutable_metadata()->set_index(100);
+    msg->mutable_snapshot()->mutable_metadata()->set_term(2);
+    request.set_offset(offset);
+    request.set_done(done);
+
+    brpc::Controller cntl;
+    cntl.request_attachment().append(chunk);
+    Barrier barrier;
+    service.InstallSnapshot(&cntl, &request, &response,
+                            google::protobuf::NewCallback([&]() { barrier.Signal(); }));
+    barrier.Wait();
+    return !cntl.Failed();
+  };
+
+  ASSERT_TRUE(install(0, "abc", false));
+  // a chunk out of order
+  ASSERT_FALSE(install(6, "ghi", true));
+  ASSERT_TRUE(install(3, "def", false));
+  ASSERT_TRUE(install(6, "ghi", true));
+  ASSERT_EQ(snapshotter.installed, "abcdefghi");
+
+  // the log is restored from the snapshot.
+  Barrier barrier;
+  uint64_t lastIndex = 0;
+  executor.Submit([&](yaraft::RawNode *n) {
+    lastIndex = n->LastIndex();
+    barrier.Signal();
+  });
+  barrier.Wait();
+  ASSERT_EQ(lastIndex, 100);
+}
+
+static const uint64_t kReadIndexGroup = 5;
+
+// The Cluster of one node on a MemTransport, which forwards the ReadIndex-es to the
+// RaftServiceImpl of the leader, in place of the RPCs.
+class ServiceCluster : public rpc::Cluster {
+ public:
+  ServiceCluster(rpc::MemTransport *transport,
+                 std::map<uint64_t, std::unique_ptr<RaftServiceImpl>> *services)
+      : mem_(transport), services_(services) {}
+
+  consensus::Status Pass(std::vector<yaraft::pb::Message> &mails) override {
+    return mem_.Pass(mails);
+  }
+
+  void AsyncReadIndex(uint64_t leaderId, rpc::ReadIndexCallback done) override {
+    forwarded++;
+    auto cntl = new brpc::Controller;
+    auto request = new pb::ReadIndexRequest;
+    auto response = new pb::ReadIndexResponse;
+    request->set_group_id(kReadIndexGroup);
+    (*services_)[leaderId]->ReadIndex(
+        cntl, request, response,
+        brpc::NewCallback(&rpc::readIndexDone, request, response, cntl, std::move(done)));
+  }
+
+  std::atomic<int> forwarded{0};
+
+ private:
+  rpc::MemCluster mem_;
+  std::map<uint64_t, std::unique_ptr<RaftServiceImpl>> *services_;
+};
+
+// Blocks the apply thread while it's closed, so that the reads waiting for the
+// entries to be applied can be observed.
+class GateStateMachine : public StateMachine {
+ public:
+  consensus::Status Apply(const std::vector<yaraft::pb::Entry> &entries) override {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this]() { return open_; });
+    return consensus::Status::OK();
+  }
+
+  void Close() {
+    std::lock_guard<std::mutex> g(mu_);
+    open_ = false;
+  }
+
+  void Open() {
+    std::lock_guard<std::mutex> g(mu_);
+    open_ = true;
+    cv_.notify_all();
+  }
+
+ private:
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool open_{true};
+};
+
+// A group of three nodes on a MemTransport, each served by a RaftServiceImpl.
+class ReadIndexTest : public BaseTest {
+ public:
+  void SetUp() override {
+    dir_.reset(CreateTestDirGuard());
+
+    std::map<uint64_t, std::string> peers;
+    for (uint64_t id = 1; id <= 3; id++) {
+      peers[id] = "mem";
+    }
+    for (uint64_t id = 1; id <= 3; id++) {
+      wal::WriteAheadLogOptions walOptions;
+      walOptions.log_dir = fmt::format("{}/node-{}", GetTestDir(), id);
+      wal::WriteAheadLogUPtr wal;
+      yaraft::MemStoreUptr memstore;
+      ASSERT_OK(wal::WriteAheadLog::Default(walOptions, &wal, &memstore));
+
+      clusters_[id] = new ServiceCluster(&transport_, &services_);
+      ReplicatedLogOptions options;
+      options.initial_cluster = peers;
+      options.id = id;
+      options.group_id = kReadIndexGroup;
+      options.heartbeat_interval = 50;
+      options.election_timeout = 500;
+      options.wal = wal.get();
+      options.memstore = memstore.release();
+      options.cluster = clusters_[id];
+      options.state_machine = &stateMachines_[id - 1];
+      options.lease_read = leaseRead_;
+      options.lease_clock_drift = 200;
+
+      ReplicatedLog *log;
+      ASSIGN_IF_ASSERT_OK(ReplicatedLog::New(options), log);
+      wals_.push_back(std::move(wal));
+      logs_[id].reset(log);
+      services_[id].reset(new RaftServiceImpl(log));
+      transport_.Register(id, log->RaftTaskExecutorInstance());
+    }
+  }
+
+  void TearDown() override {
+    for (auto &sm : stateMachines_) {
+      sm.Open();
+    }
+    services_.clear();
+    for (const auto &e : logs_) {
+      transport_.Unregister(e.first);
+    }
+    logs_.clear();
+    wals_.clear();
+  }
+
+  // Waits until all the nodes see the same leader, returns its id.
+  uint64_t WaitLeader() {
+    while (true) {
+      uint64_t leader = logs_[1]->GetRaftState().leader;
+      bool agreed = leader != 0;
+      for (const auto &e : logs_) {
+        agreed = agreed && e.second->GetRaftState().leader == leader;
+      }
+      if (agreed) {
+        return leader;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  // Calls RaftService::ReadIndex of node `id` for group `groupId`.
+  bool CallReadIndex(uint64_t id, uint64_t groupId, uint64_t *index) {
+    pb::ReadIndexRequest request;
+    pb::ReadIndexResponse response;
+    request.set_group_id(groupId);
+
+    brpc::Controller cntl;
+    Barrier barrier;
+    services_[id]->ReadIndex(&cntl, &request, &response,
+                             google::protobuf::NewCallback([&]() { barrier.Signal(); }));
+    barrier.Wait();
+    *index = response.index();
+    return !cntl.Failed();
+  }
+
+ protected:
+  TestDirGuard dir_;
+  rpc::MemTransport transport_;
+  GateStateMachine stateMachines_[3];
+  std::vector<wal::WriteAheadLogUPtr> wals_;
+  std::map<uint64_t, std::unique_ptr<ReplicatedLog>> logs_;
+  std::map<uint64_t, std::unique_ptr<RaftServiceImpl>> services_;
+
+  // owned by the logs.
+  std::map<uint64_t, ServiceCluster *> clusters_;
+
+  // set by the fixtures reading under the lease before SetUp.
+  bool leaseRead_{false};
+};
+
+// This test verifies that only the leader of the requested group serves the
+// ReadIndex, and that a follower replies with an error instead of forwarding it.
+TEST_F(ReadIndexTest, NotLeader) {
+  uint64_t leader = WaitLeader();
+  uint64_t follower = leader % 3 + 1;
+
+  uint64_t index = 0;
+  ASSERT_FALSE(CallReadIndex(follower, kReadIndexGroup, &index));
+  ASSERT_FALSE(CallReadIndex(leader, kReadIndexGroup + 1, &index));
+  ASSERT_EQ(clusters_[follower]->forwarded.load(), 0);
+
+  ASSERT_TRUE(CallReadIndex(leader, kReadIndexGroup, &index));
+  ASSERT_EQ(index, logs_[leader]->GetRaftState().commitIndex);
+}
+
+// This test verifies that a RaftServiceImpl serving many groups routes the calls by
+// their group ids, and stops serving a group once it's removed.
+TEST_F(ReadIndexTest, RouteByGroup) {
+  uint64_t leader = WaitLeader();
+  RaftServiceImpl service;
+  service.AddGroup(logs_[leader].get());
+
+  auto callStatus = [&](uint64_t groupId, pb::StatusResponse *response) -> bool {
+    pb::StatusRequest request;
+    request.set_group_id(groupId);
+    brpc::Controller cntl;
+    Barrier barrier;
+    service.Status(&cntl, &request, response,
+                   google::protobuf::NewCallback([&]() { barrier.Signal(); }));
+    barrier.Wait();
+    return !cntl.Failed();
+  };
+  auto callReadIndex = [&](uint64_t groupId, uint64_t *index) -> bool {
+    pb::ReadIndexRequest request;
+    pb::ReadIndexResponse response;
+    request.set_group_id(groupId);
+    brpc::Controller cntl;
+    Barrier barrier;
+    service.ReadIndex(&cntl, &request, &response,
+                      google::protobuf::NewCallback([&]() { barrier.Signal(); }));
+    barrier.Wait();
+    *index = response.index();
+    return !cntl.Failed();
+  };
+
+  pb::StatusResponse status;
+  ASSERT_TRUE(callStatus(kReadIndexGroup, &status));
+  ASSERT_EQ(status.leader(), leader);
+  ASSERT_FALSE(callStatus(kReadIndexGroup + 1, &status));
+
+  uint64_t index = 0;
+  ASSERT_TRUE(callReadIndex(kReadIndexGroup, &index));
+  ASSERT_EQ(index, logs_[leader]->GetRaftState().commitIndex);
+  ASSERT_FALSE(callReadIndex(kReadIndexGroup + 1, &index));
+
+  service.RemoveGroup(kReadIndexGroup);
+  ASSERT_FALSE(callStatus(kReadIndexGroup, &status));
+  ASSERT_FALSE(callReadIndex(kReadIndexGroup, &index));
+}
+
+// This test verifies that a follower fetches the read index from the leader.
+TEST_F(ReadIndexTest, ForwardToLeader) {
+  uint64_t leader = WaitLeader();
+  uint64_t follower = leader % 3 + 1;
+  ASSERT_OK(logs_[leader]->Write("abc"));
+  uint64_t committed = logs_[leader]->GetRaftState().commitIndex;
+
+  uint64_t index = 0;
+  ASSERT_OK(logs_[follower]->ReadIndex(&index));
+  ASSERT_EQ(index, committed);
+  ASSERT_EQ(clusters_[follower]->forwarded.load(), 1);
+  ASSERT_GE(logs_[follower]->AppliedIndex(), index);
+}
+
+// This test verifies that a read on a follower waits until the follower has applied
+// up to the read index returned by the leader.
+TEST_F(ReadIndexTest, FollowerWaitsToApply) {
+  uint64_t leader = WaitLeader();
+  uint64_t follower = leader % 3 + 1;
+  stateMachines_[follower - 1].Close();
+  ASSERT_OK(logs_[leader]->Write("abc"));
+  uint64_t committed = logs_[leader]->GetRaftState().commitIndex;
+
+  std::atomic<bool> done(false);
+  consensus::Status status;
+  uint64_t index = 0;
+  Barrier barrier;
+  logs_[follower]->AsyncReadIndex([&](const consensus::Status &s, uint64_t i) {
+    status = s;
+    index = i;
+    done = true;
+    barrier.Signal();
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_FALSE(done.load());
+  EXPECT_LT(logs_[follower]->AppliedIndex(), committed);
+
+  stateMachines_[follower - 1].Open();
+  barrier.Wait();
+  ASSERT_OK(status);
+  ASSERT_EQ(index, committed);
+  ASSERT_GE(logs_[follower]->AppliedIndex(), committed);
+}
+
+class LeaseReadTest : public ReadIndexTest {
+ public:
+  LeaseReadTest() {
+    leaseRead_ = true;
+  }
+};
+
+// This test verifies that the leader doesn't serve reads under its lease while a
+// leadership transfer is in progress, which may get another node elected at once.
+TEST_F(LeaseReadTest, ReadIndexDuringTransfer) {
+  uint64_t leader = WaitLeader();
+  ASSERT_OK(logs_[leader]->Write("abc"));
+  uint64_t committed = logs_[leader]->GetRaftState().commitIndex;
+  // a round of heartbeats is answered.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  bvar::Adder<int64_t> &leaseReads = Metrics::Instance().leaseReads;
+  int64_t before = leaseReads.get_value();
+  uint64_t index = 0;
+  ASSERT_OK(logs_[leader]->ReadIndex(&index));
+  ASSERT_EQ(index, committed);
+  ASSERT_EQ(leaseReads.get_value(), before + 1);
+
+  // raft ignores the transfer to the leader itself, but the lease is suspended
+  // before the transfer is stepped all the same.
+  ASSERT_OK(logs_[leader]->TransferLeadership(leader));
+  ASSERT_OK(logs_[leader]->ReadIndex(&index));
+  ASSERT_EQ(index, committed);
+  ASSERT_EQ(leaseReads.get_value(), before + 1);
+
+  // the transfer is over after an election timeout.
+  std::this_thread::sleep_for(std::chrono::milliseconds(500 + 100));
+  ASSERT_OK(logs_[leader]->ReadIndex(&index));
+  ASSERT_EQ(leaseReads.get_value(), before + 2);
+}
@@ -16,17 +16,163 @@
 
 #include "raft_task_executor.h"
 
+#include <map>
+
+#include <boost/thread/latch.hpp>
+
 namespace consensus {
 
 yaraft::Ready *RaftTaskExecutor::GetReady() {
   yaraft::Ready *rd;
   Barrier barrier;
-  Submit([&](yaraft::RawNode *node) {
-    rd = node->GetReady();
+  // not via Submit, retrieving the Ready shouldn't trigger a notification.
+  queue_->Enqueue([&]() {
+    rd = node_->GetReady();
     barrier.Signal();
   });
   barrier.Wait();
   return rd;
 }
 
+void RaftTaskExecutor::SubmitEach(const std::vector<RaftTaskExecutor *> &executors,
+                                  std::vector<RaftTask> tasks, bool urgent) {
+  std::map<TaskQueue *, std::vector<size_t>> queues;
+  for (size_t i = 0; i < executors.size(); i++) {
+    queues[executors[i]->queue_.get()].push_back(i);
+  }
+
+  auto shared = std::make_shared<std::pair<std::vector<RaftTaskExecutor *>, std::vector<RaftTask>>>(
+      executors, std::move(tasks));
+  for (const auto &q : queues) {
+    std::vector<size_t> indexes = q.second;
+    Task task([shared, indexes]() {
+      for (size_t i : indexes) {
+        RaftTaskExecutor *e = shared->first[i];
+        shared->second[i](e->node_);
+        e->publishState();
+        if (e->node_->HasReady()) {
+          e->NotifyReady();
+        }
+      }
+    });
+    if (urgent) {
+      q.first->EnqueueUrgent(std::move(task));
+    } else {
+      q.first->Enqueue(std::move(task));
+    }
+  }
+}
+
+void RaftTaskExecutor::ObserveInbound(std::vector<yaraft::pb::Message> *msgs) {
+  size_t kept = 0;
+  for (auto &m : *msgs) {
+    if (ObserveInbound(m)) {
+      (*msgs)[kept++].Swap(&m);
+    }
+  }
+  msgs->resize(kept);
+}
+
+void RaftTaskExecutor::MarkActive() {
+  if (quiesceTimeout_ == 0) {
+    return;
+  }
+  active_.store(true);
+
+  // still in the timer, it's not yet dropped.
+  int s = kQuiescing;
+  if (state_.compare_exchange_strong(s, kActive)) {
+    return;
+  }
+  s = kQuiesced;
+  if (state_.compare_exchange_strong(s, kActive)) {
+    waker_();
+  }
+}
+
+void RaftTaskExecutor::OnTicked(uint64_t ticks) {
+  if (quiesceTimeout_ == 0) {
+    return;
+  }
+
+  uint64_t term = node_->CurrentTerm();
+  uint64_t index = node_->LastIndex();
+  uint64_t leader = node_->LeaderHint();
+  bool active = active_.exchange(false);
+  if (active || leader == 0 || term != lastTerm_ || index != lastIndex_ || leader != lastLeader_) {
+    lastTerm_ = term;
+    lastIndex_ = index;
+    lastLeader_ = leader;
+    idleTicks_ = 0;
+    return;
+  }
+
+  idleTicks_ += ticks;
+  if (idleTicks_ >= quiesceTimeout_) {
+    int s = kActive;
+    state_.compare_exchange_strong(s, kQuiescing);
+  }
+}
+
+void RaftTaskExecutor::publishState() {
+  uint64_t leader = node_->LeaderHint();
+  uint64_t term = node_->CurrentTerm();
+  uint64_t index = node_->LastIndex();
+  if (leader == leader_.load(std::memory_order_relaxed) &&
+      term == term_.load(std::memory_order_relaxed) &&
+      index == publishedLastIndex_.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  uint64_t seq = stateSeq_.load(std::memory_order_relaxed);
+  stateSeq_.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  leader_.store(leader, std::memory_order_relaxed);
+  term_.store(term, std::memory_order_relaxed);
+  publishedLastIndex_.store(index, std::memory_order_relaxed);
+  stateSeq_.store(seq + 2, std::memory_order_release);
+}
+
+RaftState RaftTaskExecutor::State() const {
+  RaftState state;
+  while (true) {
+    uint64_t seq = stateSeq_.load(std::memory_order_acquire);
+    if (seq & 1) {
+      continue;
+    }
+    state.leader = leader_.load(std::memory_order_relaxed);
+    state.term = term_.load(std::memory_order_relaxed);
+    state.lastIndex = publishedLastIndex_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (stateSeq_.load(std::memory_order_relaxed) == seq) {
+      break;
+    }
+  }
+  state.commitIndex = commitIndex_.load(std::memory_order_acquire);
+  return state;
+}
+
+std::vector<yaraft::Ready *> RaftTaskExecutor::GetReadys(
+    const std::vector<RaftTaskExecutor *> &executors) {
+  std::vector<yaraft::Ready *> readys(executors.size(), nullptr);
+
+  std::map<TaskQueue *, std::vector<size_t>> queues;
+  for (size_t i = 0; i < executors.size(); i++) {
+    queues[executors[i]->queue_.get()].push_back(i);
+  }
+
+  boost::latch harvested(queues.size());
+  for (const auto &q : queues) {
+    const std::vector<size_t> &indexes = q.second;
+    q.first->Enqueue([&executors, &readys, &indexes, &harvested]() {
+      for (size_t i : indexes) {
+        readys[i] = executors[i]->node_->GetReady();
+      }
+      harvested.count_down();
+    });
+  }
+  harvested.wait();
+  return readys;
+}
+
 }  // namespace consensus
\ No newline at end of file
@@ -15,9 +15,14 @@
 #pragma once
 
 #include "base/task_queue.h"
+#include "raft_state.h"
 
 #include <yaraft/raw_node.h>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 namespace consensus {
 
 // RaftTaskExecutor provides a task model for callers to submitting tasks to
@@ -27,19 +32,174 @@ namespace consensus {
 //
 class RaftTaskExecutor {
  public:
-  RaftTaskExecutor(yaraft::RawNode* node, TaskQueue* taskQueue) : node_(node), queue_(taskQueue) {}
+  RaftTaskExecutor(yaraft::RawNode* node, TaskQueue* taskQueue)
+      : node_(node), queue_(taskQueue), notified_(false), active_(false), state_(kActive) {}
+
+  // The executors sharing a TaskQueue should share its ownership as well.
+  RaftTaskExecutor(yaraft::RawNode* node, std::shared_ptr<TaskQueue> taskQueue)
+      : node_(node),
+        queue_(std::move(taskQueue)),
+        notified_(false),
+        active_(false),
+        state_(kActive) {}
 
   typedef std::function<void(yaraft::RawNode* node)> RaftTask;
 
+  // After each task, the notifier is called in the raft thread if the RawNode has a
+  // Ready, unless the previous notification is not yet consumed.
   void Submit(RaftTask task) {
-    queue_->Enqueue(std::bind(task, node_));
+    queue_->Enqueue(SubmittedTask{this, std::move(task)});
   }
 
+  // Same as Submit, except that the task goes through the urgent lane of the TaskQueue,
+  // ahead of the normal tasks. It's for the tasks keeping the leadership alive, e.g ticks,
+  // heartbeats and votes, which shouldn't wait behind a flood of proposals.
+  void SubmitUrgent(RaftTask task) {
+    queue_->EnqueueUrgent(SubmittedTask{this, std::move(task)});
+  }
+
+  // Submits the i-th task to the i-th executor without waiting for them. The tasks of the
+  // executors sharing a TaskQueue are enqueued as one.
+  static void SubmitEach(const std::vector<RaftTaskExecutor*>& executors,
+                         std::vector<RaftTask> tasks, bool urgent = false);
+
   yaraft::Ready* GetReady();
 
+  // Retrieves the Ready-s of the executors in one task per TaskQueue, rather than one
+  // per executor. The i-th Ready belongs to the i-th executor, nullptr if it has none.
+  static std::vector<yaraft::Ready*> GetReadys(const std::vector<RaftTaskExecutor*>& executors);
+
+  // The notifier must be set before any task is submitted.
+  void SetReadyNotifier(std::function<void()> notifier) {
+    notifier_ = std::move(notifier);
+  }
+
+  // Notifies that the RawNode may have a Ready, regardless of whether it actually has.
+  void NotifyReady() {
+    if (notifier_ && !notified_.exchange(true)) {
+      notifier_();
+    }
+  }
+
+  // The observer sees every inbound message before it's submitted to be stepped, in the
+  // thread receiving it, the message is dropped if it returns false. It must be set
+  // before any message arrives.
+  void SetInboundObserver(std::function<bool(const yaraft::pb::Message&)> observer) {
+    inboundObserver_ = std::move(observer);
+  }
+
+  // Returns false if the message is to be dropped rather than stepped.
+  bool ObserveInbound(const yaraft::pb::Message& msg) {
+    return !inboundObserver_ || inboundObserver_(msg);
+  }
+
+  // Observes the messages in order, the dropped ones are removed.
+  void ObserveInbound(std::vector<yaraft::pb::Message>* msgs);
+
+  // Returns the state published after the latest task.
+  // Thread-safe, lock-free
+  RaftState State() const;
+
+  // Called by the flusher once the committed index is persisted.
+  void PublishCommit(uint64_t commitIndex) {
+    commitIndex_.store(commitIndex, std::memory_order_release);
+  }
+
+  // Clears the notification, so that the subsequent tasks producing a Ready will
+  // notify again. It must be called before GetReady.
+  void ConsumeReadyNotification() {
+    notified_.store(false);
+  }
+
+  // -- quiescence --
+  //
+  // A node that has seen nothing but ticks and heartbeats for `timeoutTicks` quiesces:
+  // it's dropped from the RaftTimer, so that an idle group costs nothing. The next
+  // activity wakes it up, and `waker` is called to register it to the timer again.
+  //
+  // The followers quiesce no later than their leader, whose last activity is to receive
+  // their responses, so that they won't campaign when the heartbeats stop. A node never
+  // quiesces without a known leader.
+  // It must be enabled before the executor is registered to the timer.
+  void EnableQuiescence(uint64_t timeoutTicks, std::function<void()> waker) {
+    quiesceTimeout_ = timeoutTicks;
+    waker_ = std::move(waker);
+  }
+
+  // Called on the proposals and the inbound messages other than heartbeats.
+  // Thread-safe
+  void MarkActive();
+
+  // Called by the RaftTimer in the raft thread, after the node is ticked.
+  void OnTicked(uint64_t ticks);
+
+  // Called by the RaftTimer when the executor is due. Returns true if the node is
+  // quiescing, the timer should drop it then.
+  bool DropIfQuiescing() {
+    int s = kQuiescing;
+    return state_.compare_exchange_strong(s, kQuiesced);
+  }
+
+  bool Quiesced() const {
+    return state_.load() == kQuiesced;
+  }
+
  private:
+  // The task is moved into the queue rather than copied, small enough to be stored
+  // in place by Task.
+  struct SubmittedTask {
+    RaftTaskExecutor* executor;
+    RaftTask task;
+
+    void operator()() {
+      task(executor->node_);
+      executor->publishState();
+      if (executor->node_->HasReady()) {
+        executor->NotifyReady();
+      }
+    }
+  };
+
+  // Publishes the state of the node if it has changed, in the raft thread.
+  void publishState();
+
   yaraft::RawNode* node_;
   std::shared_ptr<TaskQueue> queue_;
+
+  std::function<void()> notifier_;
+  std::atomic_bool notified_;
+
+  std::function<bool(const yaraft::pb::Message&)> inboundObserver_;
+
+  enum QuiescenceState {
+    kActive,
+    // the node is going to be dropped from the timer.
+    kQuiescing,
+    // the node is not ticked.
+    kQuiesced,
+  };
+
+  // 0 means the quiescence is disabled.
+  uint64_t quiesceTimeout_{0};
+  std::function<void()> waker_;
+
+  // whether there's been some activity since the last ticking.
+  std::atomic_bool active_;
+  std::atomic_int state_;
+
+  // only accessed in the raft thread.
+  uint64_t idleTicks_{0};
+  uint64_t lastTerm_{0};
+  uint64_t lastIndex_{0};
+  uint64_t lastLeader_{0};
+
+  // The published state is guarded by a sequence lock, whose only writer is the raft
+  // thread. The sequence is odd while the fields are being written.
+  std::atomic<uint64_t> stateSeq_{0};
+  std::atomic<uint64_t> leader_{0};
+  std::atomic<uint64_t> term_{0};
+  std::atomic<uint64_t> publishedLastIndex_{0};
+  std::atomic<uint64_t> commitIndex_{0};
 };
 
 }  // namespace consensus
\ No newline at end of file
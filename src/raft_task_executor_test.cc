@@ -51,4 +51,85 @@ TEST_F(RaftTaskExecutorTest, TasksInSequence) {
 
   ASSERT_EQ(s.length(), 300);
   ASSERT_EQ(s, std::string(300, 'a'));
-}
\ No newline at end of file
+}
+// This test verifies the notifier is called once a task produces a Ready, and not called
+// again until the notification is consumed.
+TEST_F(RaftTaskExecutorTest, ReadyNotification) {
+  yaraft::RawNode node(conf_);
+  RaftTaskExecutor executor(&node, taskQueue_);
+
+  std::atomic_int notified(0);
+  executor.SetReadyNotifier([&]() { notified++; });
+
+  // the node campaigns after the election timeout.
+  Barrier barrier;
+  executor.Submit([&](yaraft::RawNode *n) {
+    for (int i = 0; i < conf_->electionTick * 2; i++) {
+      n->Tick();
+    }
+  });
+  executor.Submit([&](yaraft::RawNode *n) { barrier.Signal(); });
+  barrier.Wait();
+  ASSERT_EQ(notified.load(), 1);
+
+  executor.ConsumeReadyNotification();
+  std::unique_ptr<yaraft::Ready> rd(executor.GetReady());
+  ASSERT_TRUE(rd != nullptr);
+  ASSERT_EQ(notified.load(), 1);
+
+  // GetReady itself doesn't notify.
+  executor.NotifyReady();
+  ASSERT_EQ(notified.load(), 2);
+}
+
+// This test verifies the Ready-s of the executors sharing a TaskQueue are all harvested.
+TEST_F(RaftTaskExecutorTest, GetReadys) {
+  yaraft::RawNode n1(conf_);
+  yaraft::RawNode n2(conf_);
+  std::shared_ptr<TaskQueue> queue(taskQueue_);
+  RaftTaskExecutor e1(&n1, queue);
+  RaftTaskExecutor e2(&n2, queue);
+
+  Barrier barrier;
+  e1.Submit([&](yaraft::RawNode *n) {
+    for (int i = 0; i < conf_->electionTick * 2; i++) {
+      n->Tick();
+    }
+  });
+  e2.Submit([&](yaraft::RawNode *n) { barrier.Signal(); });
+  barrier.Wait();
+
+  std::vector<yaraft::Ready *> readys = RaftTaskExecutor::GetReadys({&e1, &e2});
+  ASSERT_EQ(readys.size(), 2);
+  ASSERT_TRUE(readys[0] != nullptr);
+  ASSERT_TRUE(readys[1] == nullptr);
+  delete readys[0];
+}
+
+// This test verifies the state of the node is published once a task changes it.
+TEST_F(RaftTaskExecutorTest, PublishState) {
+  conf_->peers = {1};
+  yaraft::RawNode node(conf_);
+  RaftTaskExecutor executor(&node, taskQueue_);
+  ASSERT_EQ(executor.State().term, 0);
+
+  // the single node becomes the leader after the election timeout.
+  Barrier barrier;
+  uint64_t term = 0;
+  executor.Submit([&](yaraft::RawNode *n) {
+    for (int i = 0; i < conf_->electionTick * 2; i++) {
+      n->Tick();
+    }
+    term = n->CurrentTerm();
+  });
+  executor.Submit([&](yaraft::RawNode *n) { barrier.Signal(); });
+  barrier.Wait();
+
+  RaftState state = executor.State();
+  ASSERT_EQ(state.term, term);
+  ASSERT_EQ(state.leader, 1);
+  ASSERT_EQ(state.lastIndex, node.LastIndex());
+
+  executor.PublishCommit(1);
+  ASSERT_EQ(executor.State().commitIndex, 1);
+}
@@ -12,81 +12,155 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <future>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "raft_task_executor.h"
 #include "raft_timer.h"
 
 #include "base/background_worker.h"
 #include "base/logging.h"
-#include "base/simple_channel.h"
-
-#include <boost/asio/deadline_timer.hpp>
-#include <boost/asio/strand.hpp>
 
 namespace consensus {
 
-// Timeout granularity of timer in milli-seconds.
-static uint32_t kTimerGranularity = 100;
+// Time span of a slot of the timing wheel in milli-seconds.
+static constexpr uint32_t kWheelResolution = 10;
+
+// Number of slots in the timing wheel, the intervals longer than one turn of
+// the wheel take multiple rounds.
+static constexpr size_t kWheelSlots = 512;
 
 class RaftTimer::Impl {
+  using Clock = std::chrono::steady_clock;
+
  public:
-  Impl() : timer_(io_service_) {
-    FMT_LOG(INFO, "Set up raft timer with timeout granularity: {}ms", kTimerGranularity);
+  Impl() : wheel_(kWheelSlots), cursor_(0) {
+    FMT_LOG(INFO, "Set up raft timer with wheel resolution: {}ms", kWheelResolution);
   }
 
   void Stop() {
     FATAL_NOT_OK(worker_.Stop(), "RaftTimer::Stop");
+  }
 
-    io_service_.stop();
+  void Start(const ThreadAffinity& affinity) {
+    next_ = Clock::now();
+    FATAL_NOT_OK(worker_.StartLoop(std::bind(&Impl::turn, this), affinity), "RaftTimer::Start");
   }
 
-  void Start() {
-    io_service_.run();
-
-    worker_.StartLoop([&]() {
-      timer_.expires_from_now(boost::posix_time::milliseconds(kTimerGranularity));
-      timer_.wait();
-
-      std::lock_guard<std::mutex> g(mu_);
-      for (auto& executor : executors_) {
-        Barrier channel;
-        executor->Submit([&](yaraft::RawNode* node) {
-          for (uint32_t i = 0; i < kTimerGranularity; i++) {
-            node->Tick();
-          }
-          channel.Signal();
-        });
-        channel.Wait();
-      }
-    });
+  void Register(RaftTaskExecutor* executor, uint32_t intervalMs) {
+    std::lock_guard<std::mutex> g(mu_);
+    schedule(Timer{executor, std::max(intervalMs, kWheelResolution), 0, Clock::now()});
   }
 
-  void Register(RaftTaskExecutor* executor) {
+  void Unregister(RaftTaskExecutor* executor) {
     std::lock_guard<std::mutex> g(mu_);
-    executors_.push_back(executor);
+    for (std::vector<Timer>& slot : wheel_) {
+      slot.erase(std::remove_if(slot.begin(), slot.end(),
+                                [executor](const Timer& t) { return t.executor == executor; }),
+                 slot.end());
+    }
   }
 
  private:
-  std::vector<RaftTaskExecutor*> executors_;
+  struct Timer {
+    RaftTaskExecutor* executor;
+    uint32_t intervalMs;
+
+    // turns of the wheel left before it's due.
+    size_t rounds;
+
+    // time of the last ticking, the ticks lagging behind are carried over.
+    Clock::time_point lastTicked;
+  };
+
+  // Must be called with mu_ held.
+  void schedule(Timer t) {
+    size_t steps = (t.intervalMs + kWheelResolution - 1) / kWheelResolution;
+    t.rounds = (steps - 1) / kWheelSlots;
+    wheel_[(cursor_ + steps) % kWheelSlots].push_back(t);
+  }
+
+  // Moves the wheel by one slot. The deadlines are absolute, so that a slow turn
+  // doesn't delay the following ones.
+  void turn() {
+    next_ += std::chrono::milliseconds(kWheelResolution);
+    std::this_thread::sleep_until(next_);
+
+    // the ticks are submitted with mu_ held, so that Unregister won't return in between.
+    std::lock_guard<std::mutex> g(mu_);
+    cursor_ = (cursor_ + 1) % kWheelSlots;
+
+    std::vector<Timer> slot;
+    slot.swap(wheel_[cursor_]);
+
+    std::vector<RaftTaskExecutor*> executors;
+    std::vector<RaftTaskExecutor::RaftTask> tasks;
+    Clock::time_point now = Clock::now();
+    for (Timer& t : slot) {
+      if (t.rounds > 0) {
+        t.rounds--;
+        wheel_[cursor_].push_back(t);
+        continue;
+      }
+
+      // an idle node is not ticked until it's woken up.
+      if (t.executor->DropIfQuiescing()) {
+        continue;
+      }
+
+      auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - t.lastTicked);
+      uint64_t ticks = static_cast<uint64_t>(elapsed.count());
+      t.lastTicked += std::chrono::milliseconds(ticks);
+
+      RaftTaskExecutor* executor = t.executor;
+      executors.push_back(executor);
+      tasks.push_back([executor, ticks](yaraft::RawNode* node) {
+        for (uint64_t i = 0; i < ticks; i++) {
+          node->Tick();
+        }
+        executor->OnTicked(ticks);
+      });
+      schedule(t);
+    }
+
+    if (!executors.empty()) {
+      // the ticks drive the elections, they go through the urgent lane.
+      RaftTaskExecutor::SubmitEach(executors, std::move(tasks), true);
+    }
+  }
+
+ private:
+  std::vector<std::vector<Timer>> wheel_;
+  size_t cursor_;
   std::mutex mu_;
 
-  boost::asio::io_service io_service_;
-  boost::asio::deadline_timer timer_;
+  // deadline of the next turn, only accessed by the worker.
+  Clock::time_point next_;
 
   BackgroundWorker worker_;
 };
 
 RaftTimer::RaftTimer() : impl_(new Impl) {
-  impl_->Start();
+  impl_->Start(ThreadAffinity());
+}
+
+RaftTimer::RaftTimer(const ThreadAffinity& affinity) : impl_(new Impl) {
+  impl_->Start(affinity);
 }
 
 RaftTimer::~RaftTimer() {
   impl_->Stop();
 }
 
-void RaftTimer::Register(RaftTaskExecutor* executor) {
-  impl_->Register(executor);
+void RaftTimer::Register(RaftTaskExecutor* executor, uint32_t intervalMs) {
+  impl_->Register(executor, intervalMs);
+}
+
+void RaftTimer::Unregister(RaftTaskExecutor* executor) {
+  impl_->Unregister(executor);
 }
 
 }  // namespace consensus
@@ -46,4 +46,75 @@ TEST_F(RaftTimerTest, Timeout) {
 
   ASSERT_GE(currentTerm, 1);
   ASSERT_GE(lastIndex, 1);
-}
\ No newline at end of file
+}
+// This test verifies that the executors sharing a TaskQueue are all ticked, each at its own rate.
+TEST_F(RaftTimerTest, SharedQueue) {
+  conf_->peers = {1};
+  conf_->electionTick = 200;
+  yaraft::RawNode n1(conf_);
+  yaraft::RawNode n2(conf_);
+  std::shared_ptr<TaskQueue> queue(taskQueue_);
+  RaftTaskExecutor e1(&n1, queue);
+  RaftTaskExecutor e2(&n2, queue);
+  RaftTimer timer;
+  timer.Register(&e1);
+  timer.Register(&e2, 50);
+
+  sleep(2);
+
+  for (RaftTaskExecutor *e : {&e1, &e2}) {
+    uint64_t currentTerm = 0;
+    Barrier barrier;
+    e->Submit([&](yaraft::RawNode *n) {
+      currentTerm = n->CurrentTerm();
+      barrier.Signal();
+    });
+    barrier.Wait();
+
+    ASSERT_GE(currentTerm, 1);
+  }
+}
+
+// This test verifies that an idle node is dropped from the timer, until it's woken up.
+TEST_F(RaftTimerTest, Quiescence) {
+  conf_->peers = {1};
+  conf_->electionTick = 200;
+  yaraft::RawNode node(conf_);
+  RaftTaskExecutor executor(&node, taskQueue_);
+  RaftTimer timer;
+  executor.EnableQuiescence(300, [&]() { timer.Register(&executor); });
+  timer.Register(&executor);
+
+  // elected, then idle
+  sleep(2);
+  ASSERT_TRUE(executor.Quiesced());
+
+  executor.MarkActive();
+  ASSERT_FALSE(executor.Quiesced());
+
+  sleep(2);
+  ASSERT_TRUE(executor.Quiesced());
+}
+
+// This test verifies that an unregistered executor is no longer ticked.
+TEST_F(RaftTimerTest, Unregister) {
+  conf_->peers = {1};
+  conf_->electionTick = 200;
+  yaraft::RawNode node(conf_);
+  RaftTaskExecutor executor(&node, taskQueue_);
+  RaftTimer timer;
+  timer.Register(&executor);
+  timer.Unregister(&executor);
+
+  sleep(2);
+
+  uint64_t currentTerm = 0;
+  Barrier barrier;
+  executor.Submit([&](yaraft::RawNode *n) {
+    currentTerm = n->CurrentTerm();
+    barrier.Signal();
+  });
+  barrier.Wait();
+
+  ASSERT_EQ(currentTerm, 0);
+}
@@ -13,62 +13,205 @@
 // limitations under the License.
 
 #include "base/background_worker.h"
+#include "base/memory_tracker.h"
+#include "base/metrics.h"
+#include "base/task_queue.h"
 
+#include "flush_delay_controller.h"
 #include "raft_task_executor.h"
 #include "ready_flusher.h"
 #include "replicated_log_impl.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <set>
+
 #include <boost/thread/latch.hpp>
 
 namespace consensus {
 
 class ReadyFlusher::Impl {
  public:
-  Impl() = default;
+  explicit Impl(const ReadyFlusherOptions &options)
+      : affinity_(options.affinity), delay_(options.max_batch_delay_us, options.latency_slo_us) {
+    for (size_t i = 0; i < std::max<size_t>(options.workers, 1); i++) {
+      workers_.emplace_back(new TaskQueue(affinity_));
+    }
+  }
 
+  // Each log is pinned to a worker in turn, so that its Ready-s are flushed in order.
   void Register(ReplicatedLogImpl *log) {
-    std::lock_guard<std::mutex> g(mu_);
-    logs_.push_back(log);
+    mu_.lock();
+    size_t worker = registered_++ % workers_.size();
+    logs_.insert(log);
+    mu_.unlock();
+
+    log->executor_->SetReadyNotifier(std::bind(&Impl::onReady, this, log, worker));
+
+    // the log may already have a Ready before it's registered.
+    log->executor_->NotifyReady();
+  }
+
+  void Unregister(ReplicatedLogImpl *log) {
+    // no round is in the middle of harvesting the log.
+    std::lock_guard<std::mutex> round(roundMu_);
+    {
+      std::unique_lock<std::mutex> l(mu_);
+      logs_.erase(log);
+      ready_.erase(std::remove_if(ready_.begin(), ready_.end(),
+                                  [log](const std::pair<ReplicatedLogImpl *, size_t> &r) {
+                                    return r.first == log;
+                                  }),
+                   ready_.end());
+      flushedCv_.wait(l, [this, log]() { return flushing_.find(log) == flushing_.end(); });
+    }
+    // waits for onPersisted to be done with the log.
+    std::lock_guard<std::mutex> tail(tailMu_);
   }
 
   void Start() {
-    FATAL_NOT_OK(worker_.StartLoop(std::bind(&Impl::flushRound, this)),
+    FATAL_NOT_OK(worker_.StartLoop(std::bind(&Impl::flushRound, this), affinity_),
                  "ReadyFlusher::Impl::Start");
   }
 
   void Stop() {
+    mu_.lock();
+    stopping_ = true;
+    mu_.unlock();
+    readyCv_.notify_one();
+
     FATAL_NOT_OK(worker_.Stop(), "ReadyFlusher::Impl::Stop");
   }
 
  private:
-  void flushRound() {
+  // Called in the raft thread when the log has a Ready.
+  void onReady(ReplicatedLogImpl *rl, size_t worker) {
     mu_.lock();
-    std::vector<ReplicatedLogImpl *> logs = logs_;
+    if (logs_.find(rl) == logs_.end()) {
+      mu_.unlock();
+      return;
+    }
+    ready_.emplace_back(rl, worker);
+    delay_.OnArrival(MonotonicMicros());
     mu_.unlock();
+    readyCv_.notify_one();
+  }
+
+  // Sleeps until some logs are notified to have Ready-s, only these logs are polled.
+  void flushRound() {
+    std::vector<std::pair<ReplicatedLogImpl *, size_t>> logs;
+    {
+      std::unique_lock<std::mutex> l(mu_);
+      readyCv_.wait(l, [this]() { return stopping_ || !ready_.empty(); });
 
-    if (logs.empty()) {
+      // waits for more Ready-s to be flushed in this round, see FlushDelayController.
+      uint32_t delay = delay_.Delay();
+      if (delay > 0 && !stopping_) {
+        Metrics::Instance().flushBatchDelay << delay;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(delay);
+        readyCv_.wait_until(l, deadline, [this]() { return stopping_; });
+      }
+      logs.swap(ready_);
+    }
+
+    // Unregister waits for the round to be done.
+    std::lock_guard<std::mutex> round(roundMu_);
+
+    struct Flush {
+      ReplicatedLogImpl *rl;
+      yaraft::Ready *rd;
+      size_t worker;
+      int64_t bytes;
+    };
+    std::vector<std::pair<ReplicatedLogImpl *, size_t>> candidates;
+    std::vector<RaftTaskExecutor *> executors;
+    for (const auto &l : logs) {
+      ReplicatedLogImpl *rl = l.first;
+      rl->executor_->ConsumeReadyNotification();
+
+      // The next Ready can only be retrieved after the previous one advanced,
+      // the log will be notified again then.
+      if (isFlushing(rl)) {
+        continue;
+      }
+      candidates.push_back(l);
+      executors.push_back(rl->executor_.get());
+    }
+
+    // the logs sharing a TaskQueue are harvested together.
+    std::vector<yaraft::Ready *> rds = RaftTaskExecutor::GetReadys(executors);
+    std::vector<Flush> readys;
+    for (size_t i = 0; i < candidates.size(); i++) {
+      if (rds[i]) {
+        setFlushing(candidates[i].first, true);
+        int64_t bytes = readyBytes(rds[i]);
+        MemoryTracker::Instance().Consume(MemoryTracker::kUnpersistedReadies, bytes);
+        readys.push_back(Flush{candidates[i].first, rds[i], candidates[i].second, bytes});
+      }
+    }
+    if (readys.empty()) {
       return;
     }
 
-    for (auto rl : logs) {
-      yaraft::Ready *rd = rl->executor_->GetReady();
-      if (rd) {
-        std::async(std::bind(&Impl::flushReady, this, rl, rd));
+    // The Ready-s of the logs sharing a wal engine are committed together with a
+    // single sync, once all of them are written.
+    std::set<wal::SharedWriteAheadLog *> engines;
+    for (const auto &r : readys) {
+      wal::SharedWriteAheadLog *engine = r.rl->wal_->Engine();
+      if (engine && engines.insert(engine).second) {
+        engine->Hold();
       }
     }
+
+    // The Ready-s of different logs are written in parallel by the workers.
+    boost::latch written(readys.size());
+    for (const auto &r : readys) {
+      workers_[r.worker]->Enqueue([this, r, &written]() {
+        flushReady(r.rl, r.rd, r.bytes);
+        written.count_down();
+      });
+    }
+    written.wait();
+
+    for (auto engine : engines) {
+      engine->Release();
+    }
   }
 
-  void flushReady(ReplicatedLogImpl *rl, yaraft::Ready *rd) {
+  bool isFlushing(ReplicatedLogImpl *rl) {
+    std::lock_guard<std::mutex> g(mu_);
+    return flushing_.find(rl) != flushing_.end();
+  }
+
+  void setFlushing(ReplicatedLogImpl *rl, bool flushing) {
+    std::lock_guard<std::mutex> g(mu_);
+    if (flushing) {
+      flushing_.insert(rl);
+    } else {
+      flushing_.erase(rl);
+      flushedCv_.notify_all();
+    }
+  }
+
+  // The Ready will be advanced once it's persisted, which is not waited for if the wal
+  // syncs asynchronously. Other logs can be flushed in the meantime.
+  void flushReady(ReplicatedLogImpl *rl, yaraft::Ready *rd, int64_t bytes) {
+    int64_t start = MonotonicMicros();
     yaraft::pb::HardState *hs = nullptr;
-    std::unique_ptr<yaraft::Ready> g(rd);
 
     // the leader can write to its disk in parallel with replicating to the followers and them
     // writing to their disks.
     // For more details, check raft thesis 10.2.1
     if (rd->currentLeader == rl->Id()) {
       if (!rd->messages.empty()) {
+        // the lease is measured from when the heartbeats are sent.
+        if (rl->lease_) {
+          rl->lease_->Sent(rd->messages);
+        }
         rl->cluster_->Pass(rd->messages);
         rd->messages.clear();
+        stamp(rl, ProposalTracer::kSent, rd);
       }
     }
 
@@ -76,20 +219,78 @@ class ReadyFlusher::Impl {
       hs = rd->hardState.get();
     }
 
-    if (!rd->entries.empty()) {
-      FATAL_NOT_OK(rl->wal_->Write(rd->entries, hs), "Wal::Write");
-    } else {
-      FATAL_NOT_OK(rl->wal_->Write(hs), "Wal::Write");
+    FATAL_NOT_OK(rl->wal_->AsyncWrite(rd->entries, hs,
+                                      std::bind(&Impl::onPersisted, this, rl, rd, start,
+                                                bytes, std::placeholders::_1)),
+                 "Wal::AsyncWrite");
+  }
+
+  // the bytes of the entries held by the Ready, see MemoryTracker::kUnpersistedReadies.
+  static int64_t readyBytes(const yaraft::Ready *rd) {
+    int64_t bytes = 0;
+    for (const auto &e : rd->entries) {
+      bytes += e.ByteSize();
+    }
+    for (const auto &e : rd->committedEntries) {
+      bytes += e.ByteSize();
     }
+    return bytes;
+  }
+
+  // Stamps the traced proposals among the entries of the Ready.
+  static void stamp(ReplicatedLogImpl *rl, ProposalTracer::Stage stage, yaraft::Ready *rd) {
+    if (rl->tracer_ && !rd->entries.empty()) {
+      rl->tracer_->Stamp(stage, rd->entries.front().index(), rd->entries.back().index(),
+                         MonotonicMicros());
+    }
+  }
+
+  void onPersisted(ReplicatedLogImpl *rl, yaraft::Ready *rd, int64_t start, int64_t bytes,
+                   const Status &s) {
+    FATAL_NOT_OK(s, "Wal::AsyncWrite");
+    MemoryTracker::Instance().Release(MemoryTracker::kUnpersistedReadies, bytes);
+    int64_t latency = MonotonicMicros() - start;
+    Metrics::Instance().flushReadyLatency << latency;
+    mu_.lock();
+    delay_.OnPersisted(latency);
+    mu_.unlock();
+    std::unique_ptr<yaraft::Ready> g(rd);
+    stamp(rl, ProposalTracer::kPersisted, rd);
 
     // committedIndex has changed
     if (rd->hardState && rd->hardState->has_commit()) {
-      rl->walCommitObserver_->Notify(rd->hardState->commit());
+      rl->executor_->PublishCommit(rd->hardState->commit());
+      if (rl->tracer_) {
+        rl->tracer_->Commit(rd->hardState->commit(), MonotonicMicros());
+      }
+    }
+    // the proposals of an earlier term are failed once the term moves on, even if the
+    // commit hasn't.
+    if (rd->hardState) {
+      rl->walCommitObserver_->Notify(rd->hardState->commit(), rd->hardState->term());
     }
 
     // states have already been persisted.
     rd->Advance(rl->memstore_);
 
+    // applied in the apply thread, while the next Ready is flushed.
+    if (rl->applier_) {
+      rl->applier_->Submit(std::move(rd->committedEntries));
+    }
+
+    // evict in the raft thread, where the memstore is read.
+    if (rl->storage_) {
+      rl->executor_->Submit([rl](yaraft::RawNode *) {
+        WARN_NOT_OK(rl->storage_->MaybeEvict(), "BoundedMemoryStorage::MaybeEvict");
+      });
+    }
+
+    // the learners are caught up with the entries and the commit index of the Ready.
+    if (rl->learners_ && rd->currentLeader == rl->Id()) {
+      rl->executor_->Submit(
+          std::bind(&ReplicatedLogImpl::replicateToLearners, rl, std::placeholders::_1));
+    }
+
     // followers should respond only after state persisted
     if (rd->currentLeader != rl->Id()) {
       if (!rd->messages.empty()) {
@@ -97,20 +298,64 @@ class ReadyFlusher::Impl {
         rd->messages.clear();
       }
     }
+
+    // held until the log is notified, so that it's not unregistered in between.
+    std::lock_guard<std::mutex> tail(tailMu_);
+    setFlushing(rl, false);
+
+    // there may be a new Ready produced before the advance, e.g the committed entries.
+    rl->executor_->NotifyReady();
   }
 
  private:
-  std::vector<ReplicatedLogImpl *> logs_;
+  const ThreadAffinity affinity_;
+
+  size_t registered_{0};
+  // the registered logs, the Ready-s of the others are ignored.
+  std::set<ReplicatedLogImpl *> logs_;
+
+  // logs notified to have Ready-s, with the workers they're pinned to
+  std::vector<std::pair<ReplicatedLogImpl *, size_t>> ready_;
+  std::condition_variable readyCv_;
+  bool stopping_{false};
+
+  // logs whose Ready is being persisted
+  std::set<ReplicatedLogImpl *> flushing_;
+  std::condition_variable flushedCv_;
+  FlushDelayController delay_;
   std::mutex mu_;
 
+  // held by a round from harvesting the Ready-s to writing them, and by onPersisted
+  // from clearing the flushing state of a log to notifying it, see Unregister.
+  std::mutex roundMu_;
+  std::mutex tailMu_;
+
   BackgroundWorker worker_;
+
+  // the workers flushing the Ready-s, each runs in a background thread.
+  std::vector<std::unique_ptr<TaskQueue>> workers_;
 };
 
 void ReadyFlusher::Register(ReplicatedLogImpl *log) {
   impl_->Register(log);
 }
 
-ReadyFlusher::ReadyFlusher() : impl_(new Impl) {
+void ReadyFlusher::Unregister(ReplicatedLogImpl *log) {
+  impl_->Unregister(log);
+}
+
+ReadyFlusherOptions::ReadyFlusherOptions()
+    : workers(4), max_batch_delay_us(0), latency_slo_us(2000) {}
+
+static ReadyFlusherOptions withWorkers(size_t workers) {
+  ReadyFlusherOptions options;
+  options.workers = workers;
+  return options;
+}
+
+ReadyFlusher::ReadyFlusher(size_t workers) : ReadyFlusher(withWorkers(workers)) {}
+
+ReadyFlusher::ReadyFlusher(const ReadyFlusherOptions &options) : impl_(new Impl(options)) {
   impl_->Start();
 }
 
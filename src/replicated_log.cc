@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>
 #include <thread>
 
 #include "raft_service.h"
@@ -22,6 +23,10 @@
 namespace consensus {
 
 Status ReplicatedLog::Write(const Slice &log) {
+  if (impl_->batcher_) {
+    return impl_->batcher_->Write(log);
+  }
+
   Status s;
   SimpleChannel<Status> chan = impl_->AsyncWrite(log);
   chan >>= s;
@@ -36,34 +41,217 @@ RaftTaskExecutor *ReplicatedLog::RaftTaskExecutorInstance() const {
   return impl_->executor_.get();
 }
 
-ReplicatedLog::~ReplicatedLog() {}
+RaftState ReplicatedLog::GetRaftState() const {
+  return impl_->executor_->State();
+}
+
+uint64_t ReplicatedLog::AppliedIndex() const {
+  return impl_->applier_ ? impl_->applier_->AppliedIndex() : 0;
+}
+
+SnapshotReceiver *ReplicatedLog::SnapshotReceiverInstance() const {
+  return impl_->snapshotReceiver_.get();
+}
+
+std::string ReplicatedLog::DumpProposalTraces(bool chromeTrace) const {
+  if (!impl_->tracer_) {
+    return std::string();
+  }
+  return chromeTrace ? impl_->tracer_->ChromeTraceJson() : impl_->tracer_->Breakdown();
+}
+
+ReplicatedLog::~ReplicatedLog() {
+  if (impl_->handoffTimeoutMs_ > 0) {
+    WARN_NOT_OK(HandOffLeadership(impl_->handoffTimeoutMs_), "ReplicatedLog::HandOffLeadership");
+  }
+}
 
 SimpleChannel<Status> ReplicatedLog::AsyncWrite(const Slice &log) {
   return impl_->AsyncWrite(log);
 }
 
+SimpleChannel<Status> ReplicatedLog::AsyncWriteBatch(const std::vector<Slice> &logs) {
+  return impl_->AsyncWriteBatch(logs);
+}
+
+void ReplicatedLog::AsyncWrite(const Slice &log, WriteCallback callback) {
+  impl_->AsyncWriteBatch(std::vector<Slice>{log}, std::move(callback));
+}
+
+void ReplicatedLog::AsyncWriteBatch(const std::vector<Slice> &logs, WriteCallback callback) {
+  impl_->AsyncWriteBatch(logs, std::move(callback));
+}
+
+Status ReplicatedLog::WriteOwned(std::string &&log) {
+  Status status;
+  Barrier barrier;
+  impl_->AsyncWrite(std::move(log), [&](const Status &s, uint64_t) {
+    status = s;
+    barrier.Signal();
+  });
+  barrier.Wait();
+  return status;
+}
+
+void ReplicatedLog::AsyncWriteOwned(std::string &&log, WriteCallback callback) {
+  impl_->AsyncWrite(std::move(log), std::move(callback));
+}
+
+void ReplicatedLog::AsyncWrite(Buffer &&log, WriteCallback callback) {
+  std::string entry;
+  log.MoveTo(&entry);
+  impl_->AsyncWrite(std::move(entry), std::move(callback));
+}
+
+Status ReplicatedLog::ReadIndex(uint64_t *index) {
+  Status status;
+  Barrier barrier;
+  impl_->AsyncReadIndex([&](const Status &s, uint64_t i) {
+    status = s;
+    *index = i;
+    barrier.Signal();
+  });
+  barrier.Wait();
+  return status;
+}
+
+void ReplicatedLog::AsyncReadIndex(WriteCallback callback) {
+  impl_->AsyncReadIndex(std::move(callback));
+}
+
+Status ReplicatedLog::TransferLeadership(uint64_t target) {
+  Status status;
+  Barrier barrier;
+  impl_->AsyncTransferLeadership(target, [&](const Status &s) {
+    status = s;
+    barrier.Signal();
+  });
+  barrier.Wait();
+  return status;
+}
+
+Status ReplicatedLog::Compact(uint64_t index) {
+  Status status;
+  Barrier barrier;
+  impl_->AsyncCompact(index, [&](const Status &s) {
+    status = s;
+    barrier.Signal();
+  });
+  barrier.Wait();
+  return status;
+}
+
+void ReplicatedLog::AsyncCompact(uint64_t index, std::function<void(const Status &)> done) {
+  impl_->AsyncCompact(index, std::move(done));
+}
+
+const std::vector<uint64_t> &ReplicatedLog::Peers() const {
+  return impl_->peers_;
+}
+
+Status ReplicatedLog::HandOffLeadership(uint32_t timeoutMs) {
+  uint64_t id = Id();
+  if (GetRaftState().leader != id) {
+    return Status::OK();
+  }
+  uint64_t successor = impl_->MostUpToDateFollower();
+  if (successor == 0) {
+    return Status::OK();
+  }
+  // the lease is suspended by the transfer, the reads are confirmed by a quorum until
+  // the successor is elected or the transfer is abandoned.
+  RETURN_NOT_OK(TransferLeadership(successor));
+
+  // the old leader steps down once the successor campaigns, then learns of it from
+  // its first heartbeat.
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (true) {
+    uint64_t leader = GetRaftState().leader;
+    if (leader != 0 && leader != id) {
+      FMT_LOG(INFO, "handed the leadership of node {} over to {}", id, leader);
+      return Status::OK();
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return FMT_Status(IllegalState, "leadership is not handed over to node {} in {}ms",
+                        successor, timeoutMs);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+bool ReplicatedLog::IsLearner() const {
+  return impl_->learner_;
+}
+
 uint64_t ReplicatedLog::Id() const {
   return impl_->Id();
 }
 
+uint64_t ReplicatedLog::GroupId() const {
+  return impl_->groupId_;
+}
+
 Status ReplicatedLogOptions::Validate() const {
 #define ConfigNotNull(var) \
   if ((var) == nullptr)    \
     return FMT_Status(BadConfig, "ReplicatedLogOptions::" #var " should not be null");
   ConfigNotNull(wal);
 
+  if (lease_read && lease_clock_drift >= election_timeout) {
+    return FMT_Status(BadConfig,
+                      "ReplicatedLogOptions::lease_clock_drift should be less than election_timeout");
+  }
+
+  if (snapshotter && snapshot_chunk_size == 0) {
+    return FMT_Status(BadConfig, "ReplicatedLogOptions::snapshot_chunk_size should not be 0");
+  }
+
+  for (const auto &e : learners) {
+    if (initial_cluster.find(e.first) != initial_cluster.end()) {
+      return FMT_Status(BadConfig, "node {} is both a voter and a learner", e.first);
+    }
+  }
+  if (!learners.empty() && learner_max_bytes == 0) {
+    return FMT_Status(BadConfig, "ReplicatedLogOptions::learner_max_bytes should not be 0");
+  }
+
   // memstore is allowed to be null, when no log exists.
 
   return Status::OK();
 }
 
 ReplicatedLogOptions::ReplicatedLogOptions()
-    : heartbeat_interval(100),
+    : learner_max_bytes(1024 * 1024),
+      group_id(0),
+      heartbeat_coalescer(nullptr),
+      cluster(nullptr),
+      heartbeat_interval(100),
       election_timeout(10 * 1000),
+      quiesce_timeout(0),
       taskQueue(nullptr),
+      executor_pool(nullptr),
       flusher(nullptr),
+      completion_executor(nullptr),
       timer(nullptr),
       wal(nullptr),
-      memstore(nullptr) {}
+      memstore(nullptr),
+      memstore_max_entries(0),
+      memstore_max_bytes(0),
+      write_batch_delay_us(0),
+      write_batch_max_bytes(0),
+      max_inflight_proposals(0),
+      max_inflight_proposal_bytes(0),
+      admission_timeout_ms(0),
+      lease_read(false),
+      lease_clock_drift(500),
+      state_machine(nullptr),
+      applied_index(0),
+      snapshotter(nullptr),
+      snapshot_chunk_size(1024 * 1024),
+      snapshot_bytes_per_sec(0),
+      replication_compression(wal::WriteAheadLogOptions::NO_COMPRESSION),
+      replication_compress_min_bytes(4096),
+      trace_sample_every(0),
+      shutdown_handoff_timeout_ms(0) {}
 
 }  // namespace consensus
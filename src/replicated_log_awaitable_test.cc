@@ -0,0 +1,102 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Built as C++20, see src/CMakeLists.txt.
+
+#include "base/simple_channel.h"
+#include "base/testing.h"
+#include "replicated_log.h"
+#include "replicated_log_awaitable.h"
+
+#include <exception>
+#include <vector>
+
+using namespace consensus;
+
+// A coroutine that runs as soon as it's called, and frees itself once it's done.
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() {
+      return Detached();
+    }
+
+    std::suspend_never initial_suspend() noexcept {
+      return {};
+    }
+
+    std::suspend_never final_suspend() noexcept {
+      return {};
+    }
+
+    void return_void() {}
+
+    void unhandled_exception() {
+      std::terminate();
+    }
+  };
+};
+
+static Detached writeTwice(ReplicatedLog* log, TaskQueue* queue,
+                           std::vector<StatusWith<uint64_t>>* results, Barrier* done) {
+  results->push_back(co_await AsyncWrite(log, "abc"));
+  results->push_back(co_await AsyncWrite(log, "def", TaskQueueResume{queue}));
+  done->Signal();
+}
+
+class ReplicatedLogAwaitableTest : public BaseTest {
+ public:
+  void SetUp() override {
+    options.initial_cluster[1] = "127.0.0.1:12321";
+    options.id = 1;
+    options.heartbeat_interval = 100;
+    options.election_timeout = 1000;
+
+    yaraft::MemStoreUptr memstore;
+    options.wal = wal::TEST_CreateWalStore(GetTestDir(), &memstore).release();
+    options.memstore = memstore.release();
+  }
+
+  void TearDown() override {
+    delete replicatedLog;
+    delete options.wal;
+  }
+
+ protected:
+  ReplicatedLog* replicatedLog{nullptr};
+  ReplicatedLogOptions options;
+};
+
+// This test verifies that the coroutine is resumed with the index of each write once
+// it's committed, inline and in a TaskQueue.
+TEST_F(ReplicatedLogAwaitableTest, CoAwaitWrite) {
+  TestDirGuard g(CreateTestDirGuard());
+  ASSIGN_IF_ASSERT_OK(ReplicatedLog::New(options), replicatedLog);
+
+  while (replicatedLog->GetInfo().currentTerm != 1) {
+    sleep(1);
+  }
+
+  TaskQueue queue;
+  std::vector<StatusWith<uint64_t>> results;
+  Barrier done;
+  writeTwice(replicatedLog, &queue, &results, &done);
+  done.Wait();
+
+  ASSERT_EQ(results.size(), 2);
+  ASSERT_OK(results[0].GetStatus());
+  ASSERT_OK(results[1].GetStatus());
+  // the first entry is the empty one of the leader.
+  ASSERT_EQ(results[0].GetValue(), 2);
+  ASSERT_EQ(results[1].GetValue(), 3);
+}
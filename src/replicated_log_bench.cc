@@ -0,0 +1,208 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the commit throughput and latency of a cluster of ReplicatedLog-s in one
+// process, which pass the messages through an rpc::MemTransport, and optionally keep
+// their wal in Env::Memory(), so that the flusher, batching and executor are measured
+// without the network and the disk.
+// Run with --benchmark_format=json for machine-readable results.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "base/logging.h"
+#include "base/testing.h"
+#include "replicated_log.h"
+#include "rpc/mem_transport.h"
+
+#include <benchmark/benchmark.h>
+
+using namespace consensus;
+
+static const char* kBenchDir = "/tmp/consensus-replicated-log-bench";
+
+// A cluster of `n` nodes, all in this process.
+class BenchCluster {
+ public:
+  BenchCluster(uint64_t n, bool memEnv) : dir_(kBenchDir) {
+    std::map<uint64_t, std::string> peers;
+    for (uint64_t id = 1; id <= n; id++) {
+      peers[id] = "mem";
+    }
+
+    for (uint64_t id = 1; id <= n; id++) {
+      wal::WriteAheadLogOptions walOptions;
+      walOptions.env = memEnv ? Env::Memory() : Env::Default();
+      walOptions.log_dir = fmt::format("{}/node-{}", dir_.GetTestDir(), id);
+      walOptions.group_commit = true;
+
+      wal::WriteAheadLogUPtr wal;
+      yaraft::MemStoreUptr memstore;
+      FATAL_NOT_OK(wal::WriteAheadLog::Default(walOptions, &wal, &memstore),
+                   "WriteAheadLog::Default");
+
+      ReplicatedLogOptions options;
+      options.initial_cluster = peers;
+      options.id = id;
+      options.heartbeat_interval = 50;
+      options.election_timeout = 500;
+      options.wal = wal.get();
+      options.memstore = memstore.release();
+      options.cluster = transport_.NewCluster();
+
+      StatusWith<ReplicatedLog*> sw = ReplicatedLog::New(options);
+      FATAL_NOT_OK(sw.GetStatus(), "ReplicatedLog::New");
+      ReplicatedLog* log = sw.GetValue();
+      wals_.push_back(std::move(wal));
+      logs_.emplace_back(log);
+      transport_.Register(id, log->RaftTaskExecutorInstance());
+      if (memEnv) {
+        memDirs_.push_back(walOptions.log_dir);
+      }
+    }
+  }
+
+  ~BenchCluster() {
+    for (size_t i = 0; i < logs_.size(); i++) {
+      transport_.Unregister(i + 1);
+    }
+    logs_.clear();
+    wals_.clear();
+    for (const auto& d : memDirs_) {
+      FATAL_NOT_OK(Env::Memory()->DeleteRecursively(d), "Env::DeleteRecursively");
+    }
+  }
+
+  // Waits until a leader is elected.
+  ReplicatedLog* Leader() {
+    while (true) {
+      for (auto& log : logs_) {
+        if (log->GetRaftState().leader == log->Id()) {
+          return log.get();
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+ private:
+  TestDirectoryHelper dir_;
+  rpc::MemTransport transport_;
+  std::vector<wal::WriteAheadLogUPtr> wals_;
+  std::vector<std::unique_ptr<ReplicatedLog>> logs_;
+  std::vector<std::string> memDirs_;
+};
+
+// A writer keeping up to `depth` writes inflight, which records the latency of each.
+class Writer {
+ public:
+  Writer(ReplicatedLog* log, size_t depth) : log_(log), depth_(depth) {}
+
+  void Run(int writes, const Slice& data) {
+    for (int i = 0; i < writes; i++) {
+      {
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_.wait(lock, [this]() { return inflight_ < depth_; });
+        inflight_++;
+      }
+      auto start = std::chrono::steady_clock::now();
+      log_->AsyncWrite(data, [this, start](const Status& s, uint64_t) {
+        FATAL_NOT_OK(s, "ReplicatedLog::AsyncWrite");
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::lock_guard<std::mutex> g(mu_);
+        latencies_.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        inflight_--;
+        cv_.notify_one();
+      });
+    }
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this]() { return inflight_ == 0; });
+  }
+
+  const std::vector<int64_t>& Latencies() const {
+    return latencies_;
+  }
+
+ private:
+  ReplicatedLog* log_;
+  const size_t depth_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  size_t inflight_{0};
+  std::vector<int64_t> latencies_;
+};
+
+// Args: nodes, writers, inflight writes per writer, in-memory env
+void ReplicatedLogBench(benchmark::State& state) {
+  const int kWritesPerWriter = 256;
+  int writers = state.range(1);
+  std::string data(256, 'a');
+
+  BenchCluster cluster(state.range(0), state.range(3) != 0);
+  ReplicatedLog* leader = cluster.Leader();
+
+  std::vector<std::unique_ptr<Writer>> ws;
+  for (int i = 0; i < writers; i++) {
+    ws.emplace_back(new Writer(leader, state.range(2)));
+  }
+  while (state.KeepRunning()) {
+    std::vector<std::thread> threads;
+    for (auto& w : ws) {
+      Writer* writer = w.get();
+      threads.emplace_back([writer, &data]() { writer->Run(kWritesPerWriter, data); });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+  }
+
+  std::vector<int64_t> latencies;
+  for (const auto& w : ws) {
+    latencies.insert(latencies.end(), w->Latencies().begin(), w->Latencies().end());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    size_t i = std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * p));
+    return latencies[i] / 1000.0;
+  };
+  state.SetItemsProcessed(state.iterations() * writers * kWritesPerWriter);
+  state.SetBytesProcessed(state.iterations() * writers * kWritesPerWriter * data.size());
+  state.counters["p50_us"] = percentile(0.5);
+  state.counters["p99_us"] = percentile(0.99);
+  state.counters["p999_us"] = percentile(0.999);
+}
+
+static void clusterArgs(benchmark::internal::Benchmark* b) {
+  for (int memEnv : {1, 0}) {
+    for (int nodes : {3, 5}) {
+      for (int writers : {1, 4, 16, 64}) {
+        b->Args({nodes, writers, 8, memEnv});
+      }
+    }
+  }
+}
+
+BENCHMARK(ReplicatedLogBench)
+    ->ArgNames({"nodes", "writers", "depth", "mem_env"})
+    ->Apply(clusterArgs)
+    ->Iterations(20)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -16,20 +16,148 @@
 
 #include "base/env.h"
 #include "base/logging.h"
+#include "base/memory_tracker.h"
+#include "base/metrics.h"
 #include "rpc/peer.h"
+#include "wal/bounded_memory_storage.h"
 #include "wal/wal.h"
 
+#include "applier.h"
+#include "learner_replicator.h"
+#include "lease_tracker.h"
+#include "proposal_tracer.h"
 #include "raft_service.h"
 #include "raft_task_executor.h"
 #include "raft_timer.h"
 #include "ready_flusher.h"
 #include "replicated_log.h"
+#include "snapshot_receiver.h"
 #include "wal_commit_observer.h"
 
 #include <yaraft/conf.h>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+
 namespace consensus {
 
+class ReplicatedLogImpl;
+
+// WriteBatcher gathers the concurrent ReplicatedLog::Write-s into batches, each of which
+// is proposed with one AsyncWriteBatch.
+// The front writer leads the batch, it waits for followers until the delay expires or the
+// batch is full, then proposes the batch and waits for its commit on behalf of them.
+//
+// Thread-Safe
+class WriteBatcher {
+ public:
+  WriteBatcher(ReplicatedLogImpl *log, uint32_t delayUs, size_t maxBytes)
+      : log_(log), delay_(delayUs), maxBytes_(maxBytes) {}
+
+  Status Write(const Slice &log);
+
+ private:
+  struct Writer {
+    explicit Writer(const Slice &l) : log(l) {}
+
+    const Slice &log;
+
+    Status status;
+    bool done{false};
+    std::condition_variable cv;
+  };
+
+  ReplicatedLogImpl *log_;
+  const std::chrono::microseconds delay_;
+  const size_t maxBytes_;
+
+  // pending writers, the front one is leading the batch.
+  std::deque<Writer *> writers_;
+  // bytes of the writers queued up behind the leader, including itself.
+  size_t pendingBytes_{0};
+  std::mutex mu_;
+};
+
+// ReadIndexBatcher confirms the leadership for the concurrent reads in one round, in
+// which an empty entry is replicated to a quorum. The read index is the index of the
+// entry, its commit proves that no other leader has committed anything beyond it.
+// The reads arriving during a round wait for the next one, which starts as soon as the
+// current one completes.
+//
+// Thread-Safe
+class ReadIndexBatcher {
+ public:
+  explicit ReadIndexBatcher(ReplicatedLogImpl *log) : log_(log) {}
+
+  void AsyncReadIndex(WriteCallback callback);
+
+ private:
+  // Starts a round for the pending reads, mu_ must be held.
+  void startRound(std::unique_lock<std::mutex> &lock);
+
+ private:
+  ReplicatedLogImpl *log_;
+
+  std::mutex mu_;
+  bool inflight_{false};
+  std::vector<WriteCallback> pending_;
+};
+
+// ProposalLimiter bounds the proposals that are written but not yet committed, so that
+// an overloaded log pushes back on the writers, rather than piling them up in the
+// task queue and the memstore until the latency explodes. The process exceeding the
+// soft limit of the MemoryTracker counts as the limits being reached.
+//
+// Thread-Safe
+class ProposalLimiter {
+ public:
+  ProposalLimiter(size_t maxCount, size_t maxBytes, uint32_t timeoutMs)
+      : maxCount_(maxCount), maxBytes_(maxBytes), timeout_(timeoutMs) {}
+
+  // Admits `count` entries of `bytes`, waiting up to the timeout for room.
+  // A proposal exceeding the limits alone is admitted when nothing is inflight.
+  Status Acquire(size_t count, size_t bytes) {
+    std::unique_lock<std::mutex> lock(mu_);
+    const MemoryTracker &tracker = MemoryTracker::Instance();
+    auto admitted = [&]() {
+      return count_ == 0 || ((maxCount_ == 0 || count_ + count <= maxCount_) &&
+                             (maxBytes_ == 0 || bytes_ + bytes <= maxBytes_) &&
+                             !tracker.OverSoftLimit());
+    };
+    if (!cv_.wait_for(lock, timeout_, admitted)) {
+      return FMT_Status(Busy, "too many inflight proposals [count: {}, bytes: {}]", count_,
+                        bytes_);
+    }
+    count_ += count;
+    bytes_ += bytes;
+    return Status::OK();
+  }
+
+  void Release(size_t count, size_t bytes) {
+    {
+      std::lock_guard<std::mutex> g(mu_);
+      count_ -= count;
+      bytes_ -= bytes;
+    }
+    cv_.notify_all();
+  }
+
+ private:
+  const size_t maxCount_;
+  const size_t maxBytes_;
+  const std::chrono::milliseconds timeout_;
+
+  size_t count_{0};
+  size_t bytes_{0};
+  std::mutex mu_;
+  std::condition_variable cv_;
+};
+
 class ReplicatedLogImpl {
   friend class ReplicatedLog;
 
@@ -55,76 +183,543 @@ class ReplicatedLogImpl {
       options.memstore = new yaraft::MemoryStorage;
     }
     conf->storage = options.memstore;
+    // the entries left in the wal by a lazy recovery are read back on demand.
+    uint64_t compactIndex = 0, compactTerm = 0;
+    bool lazy = options.wal && options.wal->LazilyRecovered(&compactIndex, &compactTerm);
+    if (lazy || options.memstore_max_entries > 0 || options.memstore_max_bytes > 0) {
+      impl->storage_.reset(new wal::BoundedMemoryStorage(options.memstore, options.wal,
+                                                          options.memstore_max_entries,
+                                                          options.memstore_max_bytes));
+      if (lazy) {
+        impl->storage_->SetLogStart(compactIndex, compactTerm);
+      }
+      conf->storage = impl->storage_.get();
+    }
     for (const auto &e : options.initial_cluster) {
       conf->peers.push_back(e.first);
     }
+    impl->peers_ = conf->peers;
+    // raft knows of no other learner, the learner itself follows the leader like a
+    // follower, but it's never ticked, so it never campaigns.
+    impl->learner_ = options.learners.find(options.id) != options.learners.end();
+    if (impl->learner_) {
+      conf->peers.push_back(options.id);
+    }
     impl->node_.reset(new yaraft::RawNode(conf));
 
     // -- RaftTaskExecutor --
-    TaskQueue *taskQueue = options.taskQueue;
+    std::shared_ptr<TaskQueue> taskQueue = options.taskQueue;
     if (!taskQueue) {
-      taskQueue = new TaskQueue;
+      taskQueue.reset(options.executor_pool ? options.executor_pool->NewStrand() : new TaskQueue);
     }
     impl->executor_.reset(new RaftTaskExecutor(impl->node_.get(), taskQueue));
 
     // -- RaftTimer --
-    impl->timer_.reset(options.timer);
-    if (!impl->timer_) {
+    // the timer and the flusher given by the options are shared, not owned.
+    if (options.timer) {
+      impl->timer_.reset(options.timer, [](RaftTimer *) {});
+    } else {
       impl->timer_.reset(new RaftTimer);
     }
-    impl->timer_->Register(impl->executor_.get());
 
     // -- ReadyFlusher --
     impl->wal_ = options.wal;
     impl->walCommitObserver_.reset(new WalCommitObserver);
+    impl->completionExecutor_ = options.completion_executor;
     impl->memstore_ = options.memstore;
-    impl->cluster_.reset(rpc::Cluster::Default(options.initial_cluster));
-    impl->flusher_.reset(options.flusher);
-    if (!impl->flusher_) {
+    if (options.cluster) {
+      impl->cluster_.reset(options.cluster);
+    } else {
+      std::map<uint64_t, std::string> members = options.initial_cluster;
+      members.insert(options.learners.begin(), options.learners.end());
+      impl->cluster_.reset(
+          rpc::Cluster::Default(members, options.group_id, options.heartbeat_coalescer));
+    }
+    impl->cluster_->SetUnreachableReporter(
+        std::bind(&ReplicatedLogImpl::reportUnreachable, impl, std::placeholders::_1));
+    if (options.replication_compression != wal::WriteAheadLogOptions::NO_COMPRESSION) {
+      std::set<uint64_t> remote;
+      for (const auto &e : options.peer_zones) {
+        if (e.second != options.zone) {
+          remote.insert(e.first);
+        }
+      }
+      impl->cluster_->EnableCompression(remote, options.replication_compression,
+                                        options.replication_compress_min_bytes);
+    }
+    if (options.snapshotter) {
+      impl->cluster_->EnableSnapshots(
+          options.snapshotter, options.snapshot_chunk_size, options.snapshot_bytes_per_sec,
+          std::bind(&ReplicatedLogImpl::reportSnapshot, impl, std::placeholders::_1,
+                    std::placeholders::_2));
+      impl->snapshotReceiver_.reset(
+          new SnapshotReceiver(impl->executor_.get(), options.snapshotter, options.wal));
+    }
+    if (options.max_inflight_proposals > 0 || options.max_inflight_proposal_bytes > 0) {
+      impl->limiter_.reset(new ProposalLimiter(options.max_inflight_proposals,
+                                               options.max_inflight_proposal_bytes,
+                                               options.admission_timeout_ms));
+    }
+
+    if (options.trace_sample_every > 0) {
+      impl->tracer_.reset(new ProposalTracer(options.trace_sample_every));
+    }
+
+    if (options.state_machine) {
+      impl->applier_.reset(
+          new Applier(options.state_machine, options.applied_index, options.apply_affinity));
+    }
+    if (options.flusher) {
+      impl->flusher_.reset(options.flusher, [](ReadyFlusher *) {});
+    } else {
       impl->flusher_.reset(new ReadyFlusher);
     }
     impl->flusher_->Register(impl);
 
+    if (options.write_batch_delay_us > 0) {
+      impl->batcher_.reset(new WriteBatcher(impl, options.write_batch_delay_us,
+                                            options.write_batch_max_bytes));
+    }
+
+    impl->readIndexBatcher_.reset(new ReadIndexBatcher(impl));
+    if (options.lease_read) {
+      std::chrono::milliseconds lease(options.election_timeout - options.lease_clock_drift);
+      impl->lease_.reset(new LeaseTracker(options.id, impl->peers_, lease,
+                                          std::chrono::milliseconds(options.election_timeout)));
+      impl->electionTimeoutMs_ = options.election_timeout;
+    }
+    if (!impl->learner_ && !options.learners.empty()) {
+      std::vector<uint64_t> learners;
+      for (const auto &e : options.learners) {
+        learners.push_back(e.first);
+      }
+      // the learners are probed again if they don't respond in a few heartbeats.
+      impl->learners_.reset(
+          new LearnerReplicator(learners, options.learner_max_bytes,
+                                std::chrono::milliseconds(options.heartbeat_interval * 3)));
+      impl->learnerSnapshots_ = options.snapshotter != nullptr;
+    }
+    for (uint64_t p : impl->peers_) {
+      if (p != options.id) {
+        impl->matched_[p].reset(new std::atomic<uint64_t>(0));
+      }
+    }
+    impl->executor_->SetInboundObserver(
+        std::bind(&ReplicatedLogImpl::observeInbound, impl, std::placeholders::_1));
+    impl->handoffTimeoutMs_ = options.shutdown_handoff_timeout_ms;
+
+    impl->groupId_ = options.group_id;
+    impl->coalescer_ = options.heartbeat_coalescer;
+    if (impl->coalescer_) {
+      RaftTaskExecutor *executor = impl->executor_.get();
+      impl->coalescer_->RegisterGroup(
+          options.group_id, [executor](std::vector<yaraft::pb::Message> &msgs) {
+            auto stepped = std::make_shared<std::vector<yaraft::pb::Message>>();
+            stepped->swap(msgs);
+            executor->ObserveInbound(stepped.get());
+            executor->SubmitUrgent([stepped](yaraft::RawNode *node) {
+              for (auto &m : *stepped) {
+                node->Step(m);
+              }
+            });
+          });
+    }
+
+    if (options.quiesce_timeout > 0 && !impl->learner_) {
+      std::shared_ptr<RaftTimer> timer = impl->timer_;
+      RaftTaskExecutor *executor = impl->executor_.get();
+      impl->executor_->EnableQuiescence(options.quiesce_timeout,
+                                        [timer, executor]() { timer->Register(executor); });
+    }
+
+    // ticking starts after the flusher is notified of the Ready-s.
+    if (!impl->learner_) {
+      impl->timer_->Register(impl->executor_.get());
+    }
+
     auto rl = new ReplicatedLog;
     rl->impl_.reset(impl);
     return rl;
   }
 
-  ~ReplicatedLogImpl() = default;
+  ~ReplicatedLogImpl() {
+    if (coalescer_) {
+      coalescer_->UnregisterGroup(groupId_);
+    }
+
+    // the timer and the flusher may be shared, they go on with the other logs.
+    timer_->Unregister(executor_.get());
+    flusher_->Unregister(this);
+
+    // the tasks queued before, e.g the ticks, are run ahead of the executor's destruction.
+    Barrier drained;
+    executor_->Submit([&drained](yaraft::RawNode *) { drained.Signal(); });
+    drained.Wait();
+  }
 
   SimpleChannel<Status> AsyncWrite(const Slice &log) {
+    return AsyncWriteBatch(std::vector<Slice>{log});
+  }
+
+  SimpleChannel<Status> AsyncWriteBatch(const std::vector<Slice> &logs) {
     SimpleChannel<Status> channel;
+    std::function<void(const Status &)> send = channel.Sender();
+    AsyncWriteBatch(logs, [send](const Status &s, uint64_t) { send(s); });
+    return channel;
+  }
 
-    executor_->Submit([&](yaraft::RawNode *node) {
+  // The slices are proposed in one task, and their commit is observed as one range.
+  void AsyncWriteBatch(const std::vector<Slice> &logs, WriteCallback callback) {
+    size_t bytes = 0;
+    for (const Slice &log : logs) {
+      bytes += log.size();
+    }
+    submitProposal(logs.size(), bytes, std::move(callback),
+                   [logs](yaraft::RawNode *node) -> yaraft::Status {
+                     for (const Slice &log : logs) {
+                       yaraft::Status s = node->Propose(log);
+                       if (UNLIKELY(!s.IsOK())) {
+                         return s;
+                       }
+                     }
+                     return yaraft::Status::OK();
+                   });
+  }
+
+  // The buffer is moved into the data of the proposed entry, rather than copied by
+  // RawNode::Propose.
+  void AsyncWrite(std::string &&log, WriteCallback callback) {
+    std::shared_ptr<std::string> entry(new std::string(std::move(log)));
+    uint64_t id = Id();
+    submitProposal(1, entry->size(), std::move(callback),
+                   [entry, id](yaraft::RawNode *node) -> yaraft::Status {
+                     yaraft::pb::Message m;
+                     m.set_type(yaraft::pb::MsgProp);
+                     m.set_from(id);
+                     m.add_entries()->mutable_data()->swap(*entry);
+                     return node->Step(m);
+                   });
+  }
+
+  // Admits `count` entries of `bytes` in total, and proposes them in the raft thread by
+  // `propose`, which returns the first error.
+  template <class Proposer>
+  void submitProposal(size_t count, size_t bytes, WriteCallback callback, Proposer propose) {
+    WriteCallback done = afterApplied(onCompletion(std::move(callback)));
+    if (count == 0) {
+      done(Status::OK(), 0);
+      return;
+    }
+
+    if (!limiter_ && MemoryTracker::Instance().OverSoftLimit()) {
+      done(FMT_Status(Busy, "memory usage {} exceeds the soft limit {}",
+                      MemoryTracker::Instance().TotalUsage(),
+                      MemoryTracker::Instance().SoftLimit()),
+           0);
+      return;
+    }
+    if (limiter_) {
+      Status s = limiter_->Acquire(count, bytes);
+      if (!s.IsOK()) {
+        done(s, 0);
+        return;
+      }
+
+      // the room is released once the proposal is committed or failed.
+      ProposalLimiter *limiter = limiter_.get();
+      WriteCallback admitted = std::move(done);
+      done = [limiter, count, bytes, admitted](const Status &st, uint64_t index) {
+        limiter->Release(count, bytes);
+        admitted(st, index);
+      };
+    }
+
+    Metrics &metrics = Metrics::Instance();
+    metrics.proposalsInflight << static_cast<int64_t>(count);
+    WriteCallback proposed = std::move(done);
+    done = [&metrics, count, proposed](const Status &st, uint64_t index) {
+      metrics.proposalsInflight << -static_cast<int64_t>(count);
+      proposed(st, index);
+    };
+
+    int64_t start = MonotonicMicros();
+    bool traced = tracer_ && tracer_->Sample();
+    executor_->MarkActive();
+    executor_->Submit([this, propose, done, start, traced](yaraft::RawNode *node) {
       uint64_t id = Id();
       if (!node->IsLeader()) {
-        channel <<=
-            FMT_Status(WalWriteToNonLeader, "writing to a non-leader node, [id: {}, leader: {}]",
-                       id, node->LeaderHint());
+        done(FMT_Status(WalWriteToNonLeader, "writing to a non-leader node, [id: {}, leader: {}]",
+                        id, node->LeaderHint()),
+             0);
         return;
       }
 
-      yaraft::Status s = node->Propose(log);
+      // once committed, the leader has committed an entry of its term.
+      uint64_t term = node->CurrentTerm();
+      std::atomic<uint64_t> *committedTerm = &committedTerm_;
+      WriteCallback committed = [committedTerm, term, done, start](const Status &s,
+                                                                  uint64_t index) {
+        if (s.IsOK()) {
+          Metrics::Instance().commitLatency << MonotonicMicros() - start;
+          if (committedTerm->load() < term) {
+            committedTerm->store(term);
+          }
+        }
+        done(s, index);
+      };
+
+      // the entries are consecutive since no other task interleaves.
+      uint64_t firstIndex = node->LastIndex() + 1;
+      yaraft::Status s = propose(node);
       if (UNLIKELY(!s.IsOK())) {
-        channel <<= Status::Make(Error::YARaftError, s.ToString());
+        done(Status::Make(Error::YARaftError, s.ToString()), 0);
         return;
       }
 
-      // listening for the committedIndex to forward to the newly-appended log.
-      uint64_t newIndex = node->LastIndex();
-      walCommitObserver_->Register(std::make_pair(newIndex, newIndex), &channel);
+      // listening for the committedIndex to forward to the newly-appended logs.
+      uint64_t lastIndex = node->LastIndex();
+      if (traced) {
+        tracer_->Begin(firstIndex, lastIndex, start, MonotonicMicros());
+      }
+      walCommitObserver_->Register(std::make_pair(firstIndex, lastIndex), term, committed);
     });
-
-    return channel;
   }
 
   uint64_t Id() const {
     return node_->Id();
   }
 
+  // Serves the read index locally while the leader holds the lease, otherwise confirms
+  // the leadership with a quorum.
+  void AsyncReadIndex(WriteCallback callback) {
+    RaftState state = executor_->State();
+    if (state.leader != 0 && state.leader != Id()) {
+      forwardReadIndex(state.leader, std::move(callback));
+      return;
+    }
+    if (lease_) {
+      // the commit index may lag behind the entries committed in previous terms,
+      // until one of this term is committed.
+      if (state.leader == Id() && committedTerm_.load() == state.term &&
+          lease_->Valid(state.term)) {
+        Metrics::Instance().leaseReads << 1;
+        uint64_t index = state.commitIndex;
+        if (!applier_) {
+          callback(Status::OK(), index);
+          return;
+        }
+        applier_->WaitApplied(index, std::bind(callback, Status::OK(), index));
+        return;
+      }
+    }
+    readIndexBatcher_->AsyncReadIndex(std::move(callback));
+  }
+
  private:
   friend class ReadyFlusher;
 
+  // A follower asks the leader for the read index, and serves the read once it has
+  // applied up to there, which offloads the reads from the leader.
+  void forwardReadIndex(uint64_t leader, WriteCallback callback) {
+    Applier *applier = applier_.get();
+    cluster_->AsyncReadIndex(leader, [applier, callback](const Status &s, uint64_t index) {
+      if (!s.IsOK() || !applier) {
+        callback(s, index);
+        return;
+      }
+      applier->WaitApplied(index, std::bind(callback, Status::OK(), index));
+    });
+  }
+
+  // The follower with the highest acknowledged index, 0 if there's no follower.
+  uint64_t MostUpToDateFollower() const {
+    uint64_t id = 0, index = 0;
+    for (const auto &e : matched_) {
+      uint64_t i = e.second->load(std::memory_order_relaxed);
+      if (id == 0 || i > index) {
+        id = e.first;
+        index = i;
+      }
+    }
+    return id;
+  }
+
+  // Steps a MsgTransferLeader on behalf of `target`, the leader hands the leadership
+  // over once the target has caught up. The lease reads are off from now on until the
+  // transfer is over, see LeaseTracker::Suspend.
+  void AsyncTransferLeadership(uint64_t target, std::function<void(const Status &)> done) {
+    if (std::find(peers_.begin(), peers_.end(), target) == peers_.end()) {
+      done(FMT_Status(InvalidArgument, "node {} is not in the group", target));
+      return;
+    }
+    uint64_t id = Id();
+    LeaseTracker *lease = lease_.get();
+    std::chrono::milliseconds transferTimeout(electionTimeoutMs_);
+    executor_->MarkActive();
+    executor_->Submit([id, target, done, lease, transferTimeout](yaraft::RawNode *node) {
+      if (!node->IsLeader()) {
+        done(FMT_Status(WalWriteToNonLeader,
+                        "transferring leadership from a non-leader node, [id: {}, leader: {}]",
+                        id, node->LeaderHint()));
+        return;
+      }
+      if (lease) {
+        lease->Suspend(transferTimeout);
+      }
+      yaraft::pb::Message m;
+      m.set_type(yaraft::pb::MsgTransferLeader);
+      m.set_from(target);
+      m.set_to(id);
+      yaraft::Status s = node->Step(m);
+      done(s.IsOK() ? Status::OK() : Status::Make(Error::YARaftError, s.ToString()));
+    });
+  }
+
+  // Drops the log up to `index` in the raft thread, where the memstore is read. The
+  // entries beyond the applied, or committed, index are never dropped.
+  void AsyncCompact(uint64_t index, std::function<void(const Status &)> done) {
+    if (applier_) {
+      index = std::min(index, applier_->AppliedIndex());
+    }
+    if (!wal_) {
+      done(Status::OK());
+      return;
+    }
+    RaftTaskExecutor *executor = executor_.get();
+    yaraft::MemoryStorage *memstore = memstore_;
+    wal::BoundedMemoryStorage *storage = storage_.get();
+    wal::WriteAheadLog *wal = wal_;
+    executor_->MarkActive();
+    executor_->Submit([=](yaraft::RawNode *node) {
+      uint64_t compactIndex = std::min(index, executor->State().commitIndex);
+      wal::WriteAheadLog::CompactionHint hint;
+      hint.compactIndex = compactIndex;
+      Status s;
+      if (storage) {
+        s = storage->Compact(compactIndex);
+      } else {
+        hint.memstore = memstore;
+      }
+      if (s.IsOK()) {
+        s = wal->GC(&hint);
+      }
+      done(s);
+    });
+  }
+
+  // Returns false if the message is dropped, see LeaseTracker::RejectVote.
+  bool observeInbound(const yaraft::pb::Message &m) {
+    if (lease_) {
+      RaftState state = executor_->State();
+      if (lease_->RejectVote(m, state.leader == Id(), state.term)) {
+        return false;
+      }
+      // a follower may ask the leader to transfer the leadership as well.
+      if (m.type() == yaraft::pb::MsgTransferLeader) {
+        lease_->Suspend(std::chrono::milliseconds(electionTimeoutMs_));
+      }
+      lease_->Observe(m);
+    }
+    if (learners_) {
+      learners_->Observe(m);
+    }
+    if (m.type() != yaraft::pb::MsgAppResp || m.reject()) {
+      return true;
+    }
+    auto it = matched_.find(m.from());
+    if (it == matched_.end()) {
+      return true;
+    }
+    std::atomic<uint64_t> &matched = *it->second;
+    uint64_t cur = matched.load(std::memory_order_relaxed);
+    while (cur < m.index() && !matched.compare_exchange_weak(cur, m.index())) {
+    }
+    return true;
+  }
+
+  // Steps a MsgUnreachable so that the leader stops pipelining appends to the peer, and
+  // probes it until it responds.
+  void reportUnreachable(uint64_t peerId) {
+    if (learners_ && learners_->IsLearner(peerId)) {
+      learners_->ReportUnreachable(peerId);
+      return;
+    }
+    uint64_t id = Id();
+    executor_->MarkActive();
+    executor_->Submit([id, peerId](yaraft::RawNode *node) {
+      yaraft::pb::Message m;
+      m.set_type(yaraft::pb::MsgUnreachable);
+      m.set_from(peerId);
+      m.set_to(id);
+      node->Step(m);
+    });
+  }
+
+  // Steps a MsgSnapStatus so that the leader resumes replicating to the peer, or
+  // retries the snapshot if it failed.
+  void reportSnapshot(uint64_t peerId, bool failed) {
+    if (learners_ && learners_->IsLearner(peerId)) {
+      learners_->ReportSnapshot(peerId, failed);
+      return;
+    }
+    uint64_t id = Id();
+    executor_->MarkActive();
+    executor_->Submit([id, peerId, failed](yaraft::RawNode *node) {
+      yaraft::pb::Message m;
+      m.set_type(yaraft::pb::MsgSnapStatus);
+      m.set_from(peerId);
+      m.set_to(id);
+      m.set_reject(failed);
+      node->Step(m);
+    });
+  }
+
+  // Sends the learners the entries and the commit index they're missing, in the raft
+  // thread of the leader, where the log is read.
+  void replicateToLearners(yaraft::RawNode *node) {
+    if (!node->IsLeader()) {
+      return;
+    }
+    yaraft::Storage *storage = memstore_;
+    if (storage_) {
+      storage = storage_.get();
+    }
+    std::vector<yaraft::pb::Message> msgs;
+    learners_->Replicate(Id(), node->CurrentTerm(), executor_->State().commitIndex, storage,
+                         learnerSnapshots_, &msgs);
+    if (!msgs.empty()) {
+      Metrics::Instance().learnerAppends << static_cast<int64_t>(msgs.size());
+      cluster_->Pass(msgs);
+    }
+  }
+
+  // With a state machine, the writes complete once they're applied rather than committed,
+  // so that they can be read from it right away.
+  WriteCallback afterApplied(WriteCallback callback) {
+    if (!applier_) {
+      return callback;
+    }
+    Applier *applier = applier_.get();
+    return [applier, callback](const Status &s, uint64_t index) {
+      if (!s.IsOK()) {
+        callback(s, index);
+        return;
+      }
+      applier->WaitApplied(index, std::bind(callback, s, index));
+    };
+  }
+
+  // Wraps the callback to be run in the completion executor, if there is one.
+  WriteCallback onCompletion(WriteCallback callback) {
+    if (!completionExecutor_) {
+      return callback;
+    }
+    TaskQueue *executor = completionExecutor_;
+    return [executor, callback](const Status &s, uint64_t index) {
+      executor->Enqueue(std::bind(callback, s, index));
+    };
+  }
+
   std::unique_ptr<yaraft::RawNode> node_;
 
   std::unique_ptr<RaftTaskExecutor> executor_;
@@ -139,7 +734,145 @@ class ReplicatedLogImpl {
 
   yaraft::MemoryStorage *memstore_;
 
+  // wraps memstore_ if it's bounded or lazily recovered, null otherwise.
+  std::unique_ptr<wal::BoundedMemoryStorage> storage_;
+
   wal::WriteAheadLog *wal_;
+
+  TaskQueue *completionExecutor_;
+
+  // ids of the voters in the group, including this one unless it's a learner.
+  std::vector<uint64_t> peers_;
+
+  // whether this node is a learner, see ReplicatedLogOptions::learners.
+  bool learner_{false};
+
+  // null if this node is a learner, or there's no learner.
+  std::unique_ptr<LearnerReplicator> learners_;
+  // whether the learners behind the compacted log are sent the snapshots.
+  bool learnerSnapshots_{false};
+
+  // the highest index each follower has acknowledged appending, seen from the inbound
+  // MsgAppResp-s. The map is built at construction, only the indexes change.
+  std::map<uint64_t, std::unique_ptr<std::atomic<uint64_t>>> matched_;
+
+  // see ReplicatedLogOptions::shutdown_handoff_timeout_ms.
+  uint32_t handoffTimeoutMs_{0};
+
+  uint64_t groupId_{0};
+  rpc::HeartbeatCoalescer *coalescer_{nullptr};
+
+  // null if the automatic batching is disabled.
+  std::unique_ptr<WriteBatcher> batcher_;
+
+  std::unique_ptr<ReadIndexBatcher> readIndexBatcher_;
+
+  // null if the lease read is disabled.
+  std::unique_ptr<LeaseTracker> lease_;
+  // how long a leadership transfer may take before raft abandons it.
+  uint32_t electionTimeoutMs_{0};
+  // the latest term in which an entry proposed by this node is committed.
+  std::atomic<uint64_t> committedTerm_{0};
+
+  // null if the inflight proposals are unlimited.
+  std::unique_ptr<ProposalLimiter> limiter_;
+
+  // null if there's no state machine.
+  std::unique_ptr<Applier> applier_;
+
+  // null if the proposals are not traced.
+  std::unique_ptr<ProposalTracer> tracer_;
+
+  // null if there's no snapshotter.
+  std::unique_ptr<SnapshotReceiver> snapshotReceiver_;
 };
 
+inline Status WriteBatcher::Write(const Slice &log) {
+  Writer w(log);
+
+  std::unique_lock<std::mutex> lock(mu_);
+  writers_.push_back(&w);
+  pendingBytes_ += log.size();
+  if (&w != writers_.front() && pendingBytes_ >= maxBytes_ && maxBytes_ > 0) {
+    // the batch is full, wake up its leader.
+    writers_.front()->cv.notify_one();
+  }
+  while (!w.done && &w != writers_.front()) {
+    w.cv.wait(lock);
+  }
+  if (w.done) {
+    // committed by the leader
+    return w.status;
+  }
+
+  // the leader waits for more writers to join the batch.
+  auto deadline = std::chrono::steady_clock::now() + delay_;
+  while (maxBytes_ == 0 || pendingBytes_ < maxBytes_) {
+    if (w.cv.wait_until(lock, deadline) == std::cv_status::timeout) {
+      break;
+    }
+  }
+
+  // New writers will be queued up for the next batch.
+  std::vector<Writer *> batch(writers_.begin(), writers_.end());
+  lock.unlock();
+
+  std::vector<Slice> logs;
+  logs.reserve(batch.size());
+  for (Writer *x : batch) {
+    logs.push_back(x->log);
+  }
+  Status s;
+  SimpleChannel<Status> chan = log_->AsyncWriteBatch(logs);
+  chan >>= s;
+
+  lock.lock();
+  for (Writer *x : batch) {
+    DCHECK(x == writers_.front());
+    writers_.pop_front();
+    pendingBytes_ -= x->log.size();
+    x->status = s;
+    x->done = true;
+    if (x != &w) {
+      x->cv.notify_one();
+    }
+  }
+
+  // wake up the leader of the next batch
+  if (!writers_.empty()) {
+    writers_.front()->cv.notify_one();
+  }
+  return w.status;
+}
+
+inline void ReadIndexBatcher::AsyncReadIndex(WriteCallback callback) {
+  std::unique_lock<std::mutex> lock(mu_);
+  pending_.push_back(std::move(callback));
+  if (!inflight_) {
+    inflight_ = true;
+    startRound(lock);
+  }
+}
+
+inline void ReadIndexBatcher::startRound(std::unique_lock<std::mutex> &lock) {
+  auto reads = std::make_shared<std::vector<WriteCallback>>();
+  reads->swap(pending_);
+  lock.unlock();
+
+  // with a state machine, it completes once the entry is applied.
+  log_->AsyncWriteBatch(std::vector<Slice>{Slice()}, [this, reads](const Status &s,
+                                                                   uint64_t index) {
+    for (auto &read : *reads) {
+      read(s, index);
+    }
+
+    std::unique_lock<std::mutex> l(mu_);
+    if (pending_.empty()) {
+      inflight_ = false;
+      return;
+    }
+    startRound(l);
+  });
+}
+
 }  // namespace consensus
\ No newline at end of file
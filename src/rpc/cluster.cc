@@ -17,12 +17,13 @@
 namespace consensus {
 namespace rpc {
 
-Cluster *Cluster::Default(const std::map<uint64_t, std::string> &initialCluster) {
+Cluster *Cluster::Default(const std::map<uint64_t, std::string> &initialCluster,
+                          uint64_t groupId, HeartbeatCoalescer *coalescer) {
   std::map<uint64_t, Peer *> peerMap;
   for (const auto &e : initialCluster) {
-    peerMap[e.first] = new Peer(e.second);
+    peerMap[e.first] = new Peer(e.second, groupId);
   }
-  auto p = new PeerManager(std::move(peerMap));
+  auto p = new PeerManager(std::move(peerMap), groupId, coalescer);
   return p;
 }
 
@@ -0,0 +1,172 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rpc/entry_attachment.h"
+#include "base/coding.h"
+#include "base/logging.h"
+#include "base/metrics.h"
+#include "wal/compression.h"
+
+#include <vector>
+
+namespace consensus {
+namespace rpc {
+
+void EntryPayloadCache::Move(yaraft::pb::Entry* e, butil::IOBuf* attachment) {
+  Payload& p = payloads_[e->index()];
+  if (!p.data.empty() && p.term == e->term()) {
+    Metrics::Instance().sharedPayloadBytes << static_cast<int64_t>(p.data.size());
+    attachment->append(p.data);
+    e->clear_data();
+    return;
+  }
+  p.term = e->term();
+  p.data.clear();
+  p.data.append(e->data());
+  attachment->append(p.data);
+  e->clear_data();
+}
+
+void MoveEntriesToAttachment(pb::StepBatchRequest* request, butil::IOBuf* attachment,
+                             EntryPayloadCache* cache) {
+  char header[4];
+  for (auto& msg : *request->mutable_messages()) {
+    for (auto& e : *msg.mutable_entries()) {
+      EncodeFixed32(header, static_cast<uint32_t>(e.data().size()));
+      attachment->append(header, sizeof(header));
+      if (cache && !e.data().empty()) {
+        cache->Move(&e, attachment);
+        continue;
+      }
+      attachment->append(e.data());
+      e.clear_data();
+    }
+  }
+}
+
+void CompressPayloads(wal::CompressionType type, size_t minBytes, pb::StepBatchRequest* request,
+                      butil::IOBuf* attachment) {
+  if (type == wal::kNoCompression || attachment->empty() || attachment->size() < minBytes) {
+    return;
+  }
+  Metrics& metrics = Metrics::Instance();
+  ScopedLatency latency(&metrics.replicationCompressLatency);
+
+  // the blocks are compressed where they are, without being gathered.
+  std::vector<Slice> blocks;
+  for (size_t i = 0; i < attachment->backing_block_num(); i++) {
+    butil::StringPiece block = attachment->backing_block(i);
+    blocks.emplace_back(block.data(), block.size());
+  }
+  std::string compressed;
+  Status s = wal::Compress(type, blocks.data(), blocks.size(), &compressed);
+  if (!s.IsOK()) {
+    FMT_LOG(WARNING, "failed to compress the payloads: {}", s.ToString());
+    return;
+  }
+  size_t rawLength = attachment->size();
+  metrics.replicationCompressRawBytes << static_cast<int64_t>(rawLength);
+  if (compressed.size() >= rawLength) {
+    return;
+  }
+  metrics.replicationCompressSavedBytes << static_cast<int64_t>(rawLength - compressed.size());
+
+  request->set_payloadcompression(static_cast<uint32_t>(type));
+  request->set_payloadlength(static_cast<uint32_t>(rawLength));
+  attachment->clear();
+  attachment->append(compressed);
+}
+
+static Status uncompressPayloads(butil::IOBuf* attachment, pb::StepBatchRequest* request) {
+  auto type = static_cast<wal::CompressionType>(request->payloadcompression());
+  std::string compressed = attachment->to_string();
+  std::string raw;
+  RETURN_NOT_OK(wal::Uncompress(type, compressed, request->payloadlength(), &raw));
+  if (raw.size() != request->payloadlength()) {
+    return FMT_Status(Corruption, "uncompressed payloads are {} bytes, expected {}", raw.size(),
+                      request->payloadlength());
+  }
+  attachment->clear();
+  attachment->append(raw);
+  request->clear_payloadcompression();
+  request->clear_payloadlength();
+  return Status::OK();
+}
+
+Status MoveEntriesFromAttachment(butil::IOBuf* attachment, pb::StepBatchRequest* request) {
+  if (request->has_payloadcompression()) {
+    RETURN_NOT_OK(uncompressPayloads(attachment, request));
+  }
+
+  char header[4];
+  for (auto& msg : *request->mutable_messages()) {
+    for (auto& e : *msg.mutable_entries()) {
+      if (attachment->cutn(header, sizeof(header)) != sizeof(header)) {
+        return FMT_Status(Corruption, "attachment is truncated at entry [index: {}]", e.index());
+      }
+      size_t len = DecodeFixed32(header);
+      if (attachment->length() < len) {
+        return FMT_Status(Corruption, "attachment is truncated at entry [index: {}, len: {}]",
+                          e.index(), len);
+      }
+      attachment->cutn(e.mutable_data(), len);
+    }
+  }
+  if (!attachment->empty()) {
+    return FMT_Status(Corruption, "{} bytes left in attachment", attachment->length());
+  }
+  return Status::OK();
+}
+
+void EncodeStepBatch(pb::StepBatchRequest* request, butil::IOBuf* record,
+                     EntryPayloadCache* cache, wal::CompressionType compression,
+                     size_t compressMinBytes) {
+  butil::IOBuf attachment;
+  MoveEntriesToAttachment(request, &attachment, cache);
+  CompressPayloads(compression, compressMinBytes, request, &attachment);
+
+  char header[4];
+  std::string body = request->SerializeAsString();
+  EncodeFixed32(header, static_cast<uint32_t>(body.size()));
+  record->append(header, sizeof(header));
+  record->append(body);
+  record->append(attachment);
+
+  // the payloads are gone with the record, `request` may still be sent without them.
+  request->clear_payloadcompression();
+  request->clear_payloadlength();
+}
+
+Status DecodeStepBatch(butil::IOBuf* record, pb::StepBatchRequest* request) {
+  char header[4];
+  if (record->cutn(header, sizeof(header)) != sizeof(header)) {
+    return FMT_Status(Corruption, "record is too short: {} bytes", record->length());
+  }
+  size_t len = DecodeFixed32(header);
+  if (record->length() < len) {
+    return FMT_Status(Corruption, "record is truncated [body len: {}, remaining: {}]", len,
+                      record->length());
+  }
+
+  butil::IOBuf body;
+  record->cutn(&body, len);
+  butil::IOBufAsZeroCopyInputStream input(body);
+  if (!request->ParseFromZeroCopyStream(&input)) {
+    return Status::Make(Error::Corruption, "failed to parse StepBatchRequest");
+  }
+  return MoveEntriesFromAttachment(record, request);
+}
+
+}  // namespace rpc
+}  // namespace consensus
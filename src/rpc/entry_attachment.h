@@ -0,0 +1,82 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "base/status.h"
+#include "pb/raft_server.pb.h"
+#include "wal/format.h"
+
+#include <butil/iobuf.h>
+
+#include <unordered_map>
+
+namespace consensus {
+namespace rpc {
+
+// The entry payloads of a StepBatchRequest are carried in the brpc attachment rather than
+// the protobuf body, so they skip the protobuf encoding on the sender and the parsing on
+// the receiver.
+//
+// The attachment is the data of every entry, in the order of the messages, each prefixed
+// by its fixed32 length. An entry with no data is a zero length.
+
+// EntryPayloadCache shares the data of the entries appended to many peers by one Ready:
+// the data of an entry is copied into an IOBuf once, and the attachments of all the peers
+// reference its blocks rather than copying it again.
+//
+// NOT Thread-Safe
+class EntryPayloadCache {
+ public:
+  // Appends the data of `e` to `attachment`, and clears it.
+  void Move(yaraft::pb::Entry* e, butil::IOBuf* attachment);
+
+ private:
+  struct Payload {
+    uint64_t term;
+    butil::IOBuf data;
+  };
+  // by the indexes of the entries.
+  std::unordered_map<uint64_t, Payload> payloads_;
+};
+
+// Moves the data of every entry in `request` to the end of `attachment`. The data are
+// shared through `cache` if it's not null.
+void MoveEntriesToAttachment(pb::StepBatchRequest* request, butil::IOBuf* attachment,
+                             EntryPayloadCache* cache = nullptr);
+
+// Restores the data moved by MoveEntriesToAttachment, `attachment` is consumed. The
+// payloads compressed by CompressPayloads are uncompressed first.
+// Returns Corruption if the attachment doesn't match the entries of `request`.
+Status MoveEntriesFromAttachment(butil::IOBuf* attachment, pb::StepBatchRequest* request);
+
+// The payloads of at least `minBytes` in `attachment`, as made by
+// MoveEntriesToAttachment, are compressed with `type` in place, and `request` is marked
+// to have them uncompressed by MoveEntriesFromAttachment. They're left as they are if
+// they don't get smaller.
+void CompressPayloads(wal::CompressionType type, size_t minBytes, pb::StepBatchRequest* request,
+                      butil::IOBuf* attachment);
+
+// Encodes `request` into one record of the replication stream: the fixed32 length of the
+// protobuf body, the body, then the entry payloads in the format above.
+void EncodeStepBatch(pb::StepBatchRequest* request, butil::IOBuf* record,
+                     EntryPayloadCache* cache = nullptr,
+                     wal::CompressionType compression = wal::kNoCompression,
+                     size_t compressMinBytes = 0);
+
+// Decodes a record made by EncodeStepBatch, `record` is consumed.
+Status DecodeStepBatch(butil::IOBuf* record, pb::StepBatchRequest* request);
+
+}  // namespace rpc
+}  // namespace consensus
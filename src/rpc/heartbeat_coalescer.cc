@@ -0,0 +1,158 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rpc/heartbeat_coalescer.h"
+#include "base/background_worker.h"
+#include "base/logging.h"
+#include "pb/raft_server.pb.h"
+
+#include <brpc/channel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace consensus {
+namespace rpc {
+
+static void heartbeatBatchDone(pb::HeartbeatBatchResponse* response, brpc::Controller* cntl) {
+  if (cntl->Failed()) {
+    FMT_SLOG(WARNING, "heartbeat batch failed: %s", cntl->ErrorText().c_str());
+  }
+  delete response;
+  delete cntl;
+}
+
+class HeartbeatCoalescer::Impl {
+ public:
+  explicit Impl(uint32_t intervalMs) : interval_(intervalMs) {
+    FATAL_NOT_OK(worker_.StartLoop(std::bind(&Impl::tick, this)), "HeartbeatCoalescer::Start");
+  }
+
+  ~Impl() {
+    FATAL_NOT_OK(worker_.Stop(), "HeartbeatCoalescer::Stop");
+  }
+
+  void Add(const std::string& url, uint64_t groupId, yaraft::pb::Message* msg) {
+    std::lock_guard<std::mutex> g(mu_);
+    pb::HeartbeatBatchRequest& batch = pending_[url];
+    batch.add_group_ids(groupId);
+    batch.add_messages()->Swap(msg);
+  }
+
+  void RegisterGroup(uint64_t groupId, GroupInbox inbox) {
+    std::lock_guard<std::mutex> g(mu_);
+    groups_[groupId] = std::move(inbox);
+  }
+
+  void UnregisterGroup(uint64_t groupId) {
+    std::lock_guard<std::mutex> g(mu_);
+    groups_.erase(groupId);
+  }
+
+  void Deliver(pb::HeartbeatBatchRequest* request) {
+    std::map<uint64_t, std::vector<yaraft::pb::Message>> msgs;
+    int n = std::min(request->group_ids_size(), request->messages_size());
+    for (int i = 0; i < n; i++) {
+      std::vector<yaraft::pb::Message>& v = msgs[request->group_ids(i)];
+      v.emplace_back();
+      v.back().Swap(request->mutable_messages(i));
+    }
+
+    for (auto& e : msgs) {
+      GroupInbox inbox;
+      {
+        std::lock_guard<std::mutex> g(mu_);
+        auto it = groups_.find(e.first);
+        if (it == groups_.end()) {
+          continue;
+        }
+        inbox = it->second;
+      }
+      inbox(e.second);
+    }
+  }
+
+ private:
+  void tick() {
+    std::this_thread::sleep_for(interval_);
+
+    std::map<std::string, pb::HeartbeatBatchRequest> batches;
+    {
+      std::lock_guard<std::mutex> g(mu_);
+      batches.swap(pending_);
+    }
+
+    for (auto& b : batches) {
+      auto cntl = new brpc::Controller;
+      cntl->set_timeout_ms(3000);
+      auto response = new pb::HeartbeatBatchResponse;
+
+      pb::RaftService_Stub stub(channel(b.first));
+      stub.HeartbeatBatch(cntl, &b.second, response,
+                          brpc::NewCallback(&heartbeatBatchDone, response, cntl));
+    }
+  }
+
+  // Only the ticking thread uses the channels.
+  brpc::Channel* channel(const std::string& url) {
+    std::unique_ptr<brpc::Channel>& c = channels_[url];
+    if (!c) {
+      brpc::ChannelOptions options;
+      options.max_retry = 0;
+      options.connect_timeout_ms = 2000;
+      c.reset(new brpc::Channel);
+      c->Init(url.c_str(), &options);
+    }
+    return c.get();
+  }
+
+ private:
+  const std::chrono::milliseconds interval_;
+
+  // url -> messages to be sent on the next tick
+  std::map<std::string, pb::HeartbeatBatchRequest> pending_;
+  std::unordered_map<uint64_t, GroupInbox> groups_;
+  std::mutex mu_;
+
+  std::map<std::string, std::unique_ptr<brpc::Channel>> channels_;
+
+  BackgroundWorker worker_;
+};
+
+HeartbeatCoalescer::HeartbeatCoalescer(uint32_t intervalMs) : impl_(new Impl(intervalMs)) {}
+
+HeartbeatCoalescer::~HeartbeatCoalescer() = default;
+
+void HeartbeatCoalescer::Add(const std::string& url, uint64_t groupId, yaraft::pb::Message* msg) {
+  impl_->Add(url, groupId, msg);
+}
+
+void HeartbeatCoalescer::RegisterGroup(uint64_t groupId, GroupInbox inbox) {
+  impl_->RegisterGroup(groupId, std::move(inbox));
+}
+
+void HeartbeatCoalescer::UnregisterGroup(uint64_t groupId) {
+  impl_->UnregisterGroup(groupId);
+}
+
+void HeartbeatCoalescer::Deliver(pb::HeartbeatBatchRequest* request) {
+  impl_->Deliver(request);
+}
+
+}  // namespace rpc
+}  // namespace consensus
@@ -0,0 +1,129 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "raft_task_executor.h"
+#include "rpc/cluster.h"
+#include "rpc/heartbeat_coalescer.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace consensus {
+namespace rpc {
+
+// MemTransport passes the messages among the logs of one process, in place of the
+// RPCs, so that the tests and benchmarks can exclude the network. The messages to a
+// node are stepped in one task of its executor, as a StepBatch would be.
+//
+// Thread-Safe
+class MemTransport {
+ public:
+  // Returns a Cluster on this transport, for ReplicatedLogOptions::cluster.
+  Cluster* NewCluster();
+
+  // The messages to node `id` are stepped by `executor` from now on, until the node is
+  // unregistered, which must happen before the executor is destroyed.
+  void Register(uint64_t id, RaftTaskExecutor* executor) {
+    std::lock_guard<std::mutex> g(mu_);
+    executors_[id] = executor;
+  }
+
+  void Unregister(uint64_t id) {
+    std::lock_guard<std::mutex> g(mu_);
+    executors_.erase(id);
+  }
+
+  // The messages are moved out of `mails`. Returns the nodes that are not registered,
+  // whose messages are dropped.
+  std::vector<uint64_t> Deliver(std::vector<yaraft::pb::Message>& mails) {
+    typedef std::vector<yaraft::pb::Message> Batch;
+    std::map<uint64_t, std::shared_ptr<Batch>> batches;
+    for (auto& m : mails) {
+      std::shared_ptr<Batch>& batch = batches[m.to()];
+      if (!batch) {
+        batch = std::make_shared<Batch>();
+      }
+      batch->push_back(yaraft::pb::Message());
+      batch->back().Swap(&m);
+    }
+
+    std::vector<uint64_t> unreachable;
+    std::lock_guard<std::mutex> g(mu_);
+    for (auto& e : batches) {
+      auto it = executors_.find(e.first);
+      if (it == executors_.end()) {
+        unreachable.push_back(e.first);
+        continue;
+      }
+      step(it->second, std::move(e.second));
+    }
+    return unreachable;
+  }
+
+ private:
+  static void step(RaftTaskExecutor* executor,
+                   std::shared_ptr<std::vector<yaraft::pb::Message>> batch) {
+    executor->ObserveInbound(batch.get());
+    bool heartbeats = true;
+    for (const auto& m : *batch) {
+      heartbeats = heartbeats && HeartbeatCoalescer::IsHeartbeat(m);
+    }
+    // the heartbeats don't wake up a quiesced node.
+    if (!heartbeats) {
+      executor->MarkActive();
+    }
+    executor->Submit([batch](yaraft::RawNode* node) {
+      for (auto& m : *batch) {
+        node->Step(m);
+      }
+    });
+  }
+
+ private:
+  std::mutex mu_;
+  std::map<uint64_t, RaftTaskExecutor*> executors_;
+};
+
+// The Cluster of one node on a MemTransport.
+class MemCluster : public Cluster {
+ public:
+  explicit MemCluster(MemTransport* transport) : transport_(transport) {}
+
+  Status Pass(std::vector<yaraft::pb::Message>& mails) override {
+    for (uint64_t id : transport_->Deliver(mails)) {
+      if (reporter_) {
+        reporter_(id);
+      }
+    }
+    return Status::OK();
+  }
+
+  void SetUnreachableReporter(UnreachableReporter reporter) override {
+    reporter_ = std::move(reporter);
+  }
+
+ private:
+  MemTransport* transport_;
+  UnreachableReporter reporter_;
+};
+
+inline Cluster* MemTransport::NewCluster() {
+  return new MemCluster(this);
+}
+
+}  // namespace rpc
+}  // namespace consensus
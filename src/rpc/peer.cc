@@ -14,29 +14,101 @@
 
 #include "rpc/peer.h"
 #include "base/logging.h"
+#include "base/metrics.h"
 #include "base/stl_container_utils.h"
+#include "rpc/entry_attachment.h"
+#include "rpc/heartbeat_coalescer.h"
 #include "rpc/raft_client.h"
+#include "rpc/snapshot_sender.h"
+
+#include <map>
 
 namespace consensus {
 namespace rpc {
 
-Peer::Peer(const std::string& url) : client_(new AsyncRaftClient(url)) {}
+Peer::Peer(const std::string& url, uint64_t groupId)
+    : url_(url), client_(new AsyncRaftClient(url, groupId)) {}
+
+void Peer::AsyncSend(pb::StepBatchRequest* request, EntryPayloadCache* cache) {
+  client_->StepBatch(request, cache);
+}
+
+void Peer::SetFailureCallback(std::function<void()> onFailure) {
+  client_->SetFailureCallback(std::move(onFailure));
+}
+
+void Peer::SetCompression(wal::CompressionType type, size_t minBytes) {
+  client_->SetCompression(type, minBytes);
+}
 
-void Peer::AsyncSend(yaraft::pb::Message* msg) {
-  client_->Step(msg);
+void Peer::AsyncReadIndex(uint64_t groupId, ReadIndexCallback done) {
+  client_->ReadIndex(groupId, std::move(done));
 }
 
 Status PeerManager::Pass(std::vector<yaraft::pb::Message>& mails) {
-  for (const auto& m : mails) {
+  std::map<uint64_t, pb::StepBatchRequest> batches;
+  for (auto& m : mails) {
     CHECK(m.to() != 0);
     CHECK(peerMap_.find(m.to()) != peerMap_.end());
 
-    auto newMsg = new yaraft::pb::Message(std::move(m));
-    peerMap_[m.to()]->AsyncSend(newMsg);
+    if (coalescer_ && HeartbeatCoalescer::IsHeartbeat(m)) {
+      coalescer_->Add(peerMap_[m.to()]->Url(), groupId_, &m);
+      continue;
+    }
+    if (snapshotSender_ && m.type() == yaraft::pb::MsgSnap) {
+      uint64_t peerId = m.to();
+      SnapshotReporter reporter = snapshotReporter_;
+      snapshotSender_->Send(peerMap_[peerId]->Url(), &m,
+                            [reporter, peerId](bool failed) { reporter(peerId, failed); });
+      continue;
+    }
+    batches[m.to()].add_messages()->Swap(&m);
+  }
+
+  Metrics& metrics = Metrics::Instance();
+  EntryPayloadCache cache;
+  for (auto& b : batches) {
+    metrics.stepBatchSize << b.second.messages_size();
+    peerMap_[b.first]->AsyncSend(&b.second, batches.size() > 1 ? &cache : nullptr);
   }
   return Status::OK();
 }
 
+void PeerManager::SetUnreachableReporter(UnreachableReporter reporter) {
+  for (auto& e : peerMap_) {
+    e.second->SetFailureCallback(std::bind(reporter, e.first));
+  }
+}
+
+void PeerManager::EnableSnapshots(Snapshotter* snapshotter, size_t chunkSize,
+                                  uint64_t bytesPerSec, SnapshotReporter reporter) {
+  snapshotSender_.reset(new SnapshotSender(snapshotter, chunkSize, bytesPerSec, groupId_));
+  snapshotReporter_ = std::move(reporter);
+}
+
+void PeerManager::EnableCompression(const std::set<uint64_t>& peers,
+                                    wal::WriteAheadLogOptions::CompressionType type,
+                                    size_t minBytes) {
+  wal::CompressionType t = type == wal::WriteAheadLogOptions::ZLIB_COMPRESSION
+                               ? wal::kZlibCompression
+                               : wal::kNoCompression;
+  for (uint64_t id : peers) {
+    auto it = peerMap_.find(id);
+    if (it != peerMap_.end()) {
+      it->second->SetCompression(t, minBytes);
+    }
+  }
+}
+
+void PeerManager::AsyncReadIndex(uint64_t leaderId, ReadIndexCallback done) {
+  auto it = peerMap_.find(leaderId);
+  if (it == peerMap_.end()) {
+    done(FMT_Status(NotFound, "unknown leader: {}", leaderId), 0);
+    return;
+  }
+  it->second->AsyncReadIndex(groupId_, std::move(done));
+}
+
 PeerManager::~PeerManager() {
   STLDeleteContainerPairSecondPointers(peerMap_.begin(), peerMap_.end());
 }
@@ -17,6 +17,7 @@
 #include "base/status.h"
 #include "pb/raft_server.pb.h"
 #include "rpc/cluster.h"
+#include "wal/format.h"
 
 #include <yaraft/ready.h>
 
@@ -24,26 +25,66 @@ namespace consensus {
 namespace rpc {
 
 class AsyncRaftClient;
+class EntryPayloadCache;
+class SnapshotSender;
+
 class Peer {
  public:
-  explicit Peer(const std::string& url);
+  // The messages sent are of the raft group `groupId`.
+  explicit Peer(const std::string& url, uint64_t groupId = 0);
+
+  // see AsyncRaftClient::StepBatch.
+  void AsyncSend(pb::StepBatchRequest* request, EntryPayloadCache* cache = nullptr);
+
+  const std::string& Url() const {
+    return url_;
+  }
 
-  void AsyncSend(yaraft::pb::Message* msg);
+  void SetFailureCallback(std::function<void()> onFailure);
+
+  // see AsyncRaftClient::SetCompression.
+  void SetCompression(wal::CompressionType type, size_t minBytes);
+
+  void AsyncReadIndex(uint64_t groupId, ReadIndexCallback done);
 
  private:
+  std::string url_;
   std::unique_ptr<AsyncRaftClient> client_;
 };
 
 class PeerManager : public Cluster {
  public:
-  explicit PeerManager(std::map<uint64_t, Peer*>&& peerMap) : peerMap_(peerMap) {}
+  PeerManager(std::map<uint64_t, Peer*>&& peerMap, uint64_t groupId = 0,
+              HeartbeatCoalescer* coalescer = nullptr)
+      : peerMap_(peerMap), groupId_(groupId), coalescer_(coalescer) {}
 
   ~PeerManager() override;
 
+  // The mails are moved out, those to the same peer are sent in one request.
+  // The heartbeats go through the coalescer if there is one. The entries appended to
+  // many peers are copied out of the messages once, see EntryPayloadCache.
   Status Pass(std::vector<yaraft::pb::Message>& mails) override;
 
+  void SetUnreachableReporter(UnreachableReporter reporter) override;
+
+  void EnableSnapshots(Snapshotter* snapshotter, size_t chunkSize, uint64_t bytesPerSec,
+                       SnapshotReporter reporter) override;
+
+  void AsyncReadIndex(uint64_t leaderId, ReadIndexCallback done) override;
+
+  void EnableCompression(const std::set<uint64_t>& peers,
+                         wal::WriteAheadLogOptions::CompressionType type,
+                         size_t minBytes) override;
+
  private:
   std::map<uint64_t, Peer*> peerMap_;
+
+  // null if the snapshots are sent inline with the MsgSnap-s.
+  std::unique_ptr<SnapshotSender> snapshotSender_;
+  SnapshotReporter snapshotReporter_;
+
+  uint64_t groupId_;
+  HeartbeatCoalescer* coalescer_;
 };
 
 }  // namespace rpc
@@ -15,50 +15,242 @@
 #pragma once
 
 #include "base/logging.h"
+#include "base/memory_tracker.h"
 #include "pb/raft_server.pb.h"
+#include "rpc/cluster.h"
+#include "rpc/entry_attachment.h"
 
 #include <brpc/channel.h>
+#include <brpc/stream.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
 
 namespace consensus {
 namespace rpc {
 
-static void doneCallBack(pb::StepResponse* response, brpc::Controller* cntl) {
+// InflightWindow bounds the unary requests that are sent but not yet responded.
+// It's shared with the callbacks of the requests, which may outlive the client.
+struct InflightWindow {
+  std::atomic<int64_t> messages{0};
+  std::atomic<int64_t> bytes{0};
+
+  // called when the messages to the peer are dropped or failed to deliver.
+  std::function<void()> onFailure;
+};
+
+static void stepBatchDone(std::shared_ptr<InflightWindow> window, int64_t messages, int64_t bytes,
+                          pb::StepBatchResponse* response, brpc::Controller* cntl) {
+  window->messages -= messages;
+  window->bytes -= bytes;
+  MemoryTracker::Instance().Release(MemoryTracker::kPendingSends, bytes);
   if (cntl->Failed()) {
     FMT_SLOG(ERROR, "request failed: %s", cntl->ErrorText().c_str());
-  } else {
-    delete response;
+    if (window->onFailure) {
+      window->onFailure();
+    }
   }
+  delete response;
   delete cntl;
 }
 
+static void readIndexDone(pb::ReadIndexRequest* request, pb::ReadIndexResponse* response,
+                          brpc::Controller* cntl, ReadIndexCallback done) {
+  std::unique_ptr<pb::ReadIndexRequest> g1(request);
+  std::unique_ptr<pb::ReadIndexResponse> g2(response);
+  std::unique_ptr<brpc::Controller> g3(cntl);
+  if (cntl->Failed()) {
+    done(FMT_Status(RpcError, "ReadIndex: {}", cntl->ErrorText()), 0);
+    return;
+  }
+  done(Status::OK(), response->index());
+}
+
+// AsyncRaftClient sends the messages to a peer over a long-lived brpc stream, so that
+// they arrive in order without the per-call overhead. The stream is opened by an empty
+// StepBatch call, and the unary StepBatch is used while it's unavailable.
+//
+// Both ways are bounded: the stream by its buffer size, the unary requests by the inflight
+// window. When the peer falls behind, the appends are dropped and raft will retransmit
+// them, the other messages are small and still sent.
+//
+// The requests and the stream records name the raft group `groupId` they're sent for,
+// so that a RaftService serving many groups at one url routes them, see
+// RaftServiceImpl::AddGroup.
+//
+// NOT Thread-Safe
 class AsyncRaftClient {
  public:
-  explicit AsyncRaftClient(const std::string& url) {
+  explicit AsyncRaftClient(const std::string& url, uint64_t groupId = 0)
+      : groupId_(groupId), window_(new InflightWindow) {
     brpc::ChannelOptions options;
     options.max_retry = 0;  // no retry
     options.connect_timeout_ms = 2000;
     channel_.Init(url.c_str(), &options);
   }
 
-  // Asynchronously sending request to specified url.
-  void Step(yaraft::pb::Message* msg) {
+  ~AsyncRaftClient() {
+    if (stream_ != brpc::INVALID_STREAM_ID) {
+      brpc::StreamClose(stream_);
+    }
+  }
+
+  // `onFailure` is called, possibly in a brpc thread, whenever the messages are dropped or
+  // failed to deliver. It must be set before any StepBatch.
+  void SetFailureCallback(std::function<void()> onFailure) {
+    window_->onFailure = std::move(onFailure);
+  }
+
+  // The entry payloads of at least `minBytes` in a request are compressed with `type`.
+  // It must be set before any StepBatch.
+  void SetCompression(wal::CompressionType type, size_t minBytes) {
+    compression_ = type;
+    compressMinBytes_ = minBytes;
+  }
+
+  // Asynchronously sending the messages to specified url, in one request.
+  // The entry payloads are moved out of `request`, shared through `cache` with the
+  // requests to the other peers if it's not null.
+  void StepBatch(pb::StepBatchRequest* request, EntryPayloadCache* cache = nullptr) {
+    request->set_group_id(groupId_);
+    if (stream_ == brpc::INVALID_STREAM_ID) {
+      openStream();
+    }
+    if (stream_ != brpc::INVALID_STREAM_ID) {
+      butil::IOBuf record;
+      EncodeStepBatch(request, &record, cache, compression_, compressMinBytes_);
+      int err = brpc::StreamWrite(stream_, record);
+      if (err == 0) {
+        return;
+      }
+      if (err == EAGAIN) {
+        FMT_SLOG(WARNING, "stream %lu is full, dropping the appends", stream_);
+      } else {
+        FMT_SLOG(WARNING, "stream %lu is broken: %s, dropping the appends", stream_,
+                 berror(err));
+        brpc::StreamClose(stream_);
+        stream_ = brpc::INVALID_STREAM_ID;
+      }
+      // the payloads are gone with the record, the rest is sent in the unary way.
+      dropAppends(request);
+    }
+
+    if (window_->messages.load() >= kMaxInflightMessages ||
+        window_->bytes.load() >= kMaxInflightBytes) {
+      dropAppends(request);
+    }
+    if (request->messages_size() == 0) {
+      return;
+    }
+
     // -- prepare parameters --
 
     auto cntl = new brpc::Controller;
     cntl->set_timeout_ms(3000);
+    MoveEntriesToAttachment(request, &cntl->request_attachment(), cache);
+    CompressPayloads(compression_, compressMinBytes_, request, &cntl->request_attachment());
 
-    pb::StepRequest request;
-    request.set_allocated_message(msg);
-    auto response = new pb::StepResponse;
+    auto response = new pb::StepBatchResponse;
+
+    int64_t messages = request->messages_size();
+    int64_t bytes = request->ByteSize() + cntl->request_attachment().size();
+    window_->messages += messages;
+    window_->bytes += bytes;
+    MemoryTracker::Instance().Consume(MemoryTracker::kPendingSends, bytes);
 
     // -- request --
 
     pb::RaftService_Stub stub(&channel_);
-    stub.Step(cntl, &request, response, brpc::NewCallback(&doneCallBack, response, cntl));
+    stub.StepBatch(cntl, request, response,
+                   brpc::NewCallback(&stepBatchDone, window_, messages, bytes, response, cntl));
+  }
+
+  // Fetches the read index of group `groupId` from the peer, `done` is called in a brpc
+  // thread. Unlike the others, it's thread-safe.
+  void ReadIndex(uint64_t groupId, ReadIndexCallback done) {
+    auto cntl = new brpc::Controller;
+    cntl->set_timeout_ms(kReadIndexTimeoutMs);
+    auto request = new pb::ReadIndexRequest;
+    auto response = new pb::ReadIndexResponse;
+    request->set_group_id(groupId);
+
+    pb::RaftService_Stub stub(&channel_);
+    stub.ReadIndex(cntl, request, response,
+                   brpc::NewCallback(&readIndexDone, request, response, cntl, std::move(done)));
   }
 
  private:
+  void openStream() {
+    auto now = std::chrono::steady_clock::now();
+    if (now < nextOpenTime_) {
+      return;
+    }
+    nextOpenTime_ = now + std::chrono::milliseconds(kStreamRetryIntervalMs);
+
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(kStreamOpenTimeoutMs);
+    brpc::StreamOptions options;
+    options.max_buf_size = kStreamMaxBufSize;
+    if (brpc::StreamCreate(&stream_, cntl, &options) != 0) {
+      LOG(ERROR) << "failed to create stream";
+      stream_ = brpc::INVALID_STREAM_ID;
+      return;
+    }
+
+    pb::StepBatchRequest request;
+    request.set_group_id(groupId_);
+    pb::StepBatchResponse response;
+    pb::RaftService_Stub stub(&channel_);
+    stub.StepBatch(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+      FMT_SLOG(ERROR, "failed to open stream: %s", cntl.ErrorText().c_str());
+      brpc::StreamClose(stream_);
+      stream_ = brpc::INVALID_STREAM_ID;
+    }
+  }
+
+  // Removes the MsgApp-s from `request`, and reports the failure if there's any.
+  void dropAppends(pb::StepBatchRequest* request) {
+    auto msgs = request->mutable_messages();
+    int n = 0;
+    for (int i = 0; i < msgs->size(); i++) {
+      if (msgs->Get(i).type() != yaraft::pb::MsgApp) {
+        msgs->SwapElements(i, n++);
+      }
+    }
+    if (n == msgs->size()) {
+      return;
+    }
+    while (msgs->size() > n) {
+      msgs->RemoveLast();
+    }
+    if (window_->onFailure) {
+      window_->onFailure();
+    }
+  }
+
+ private:
+  static const int kStreamOpenTimeoutMs = 500;
+  static const int kReadIndexTimeoutMs = 3000;
+  static const int kStreamRetryIntervalMs = 1000;
+  // unconsumed bytes allowed in the stream before the writes are rejected.
+  static const size_t kStreamMaxBufSize = 8 * 1024 * 1024;
+
+  static const int64_t kMaxInflightMessages = 1024;
+  static const int64_t kMaxInflightBytes = 8 * 1024 * 1024;
+
   brpc::Channel channel_;
+  const uint64_t groupId_;
+
+  brpc::StreamId stream_{brpc::INVALID_STREAM_ID};
+  std::chrono::steady_clock::time_point nextOpenTime_;
+
+  std::shared_ptr<InflightWindow> window_;
+
+  wal::CompressionType compression_{wal::kNoCompression};
+  size_t compressMinBytes_{0};
 };
 
 }  // namespace rpc
@@ -0,0 +1,98 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rpc/snapshot_sender.h"
+#include "base/logging.h"
+#include "pb/raft_server.pb.h"
+
+#include <brpc/channel.h>
+#include <brpc/controller.h>
+
+#include <chrono>
+#include <thread>
+
+namespace consensus {
+namespace rpc {
+
+SnapshotSender::SnapshotSender(Snapshotter* snapshotter, size_t chunkSize, uint64_t bytesPerSec,
+                               uint64_t groupId)
+    : snapshotter_(snapshotter),
+      chunkSize_(chunkSize),
+      bytesPerSec_(bytesPerSec),
+      groupId_(groupId) {}
+
+void SnapshotSender::Send(const std::string& url, yaraft::pb::Message* msg, Callback done) {
+  auto m = std::make_shared<yaraft::pb::Message>();
+  m->Swap(msg);
+  // the data is streamed in chunks instead.
+  m->mutable_snapshot()->clear_data();
+
+  queue_.Enqueue([this, url, m, done]() {
+    Status s = transfer(url, *m);
+    if (!s.IsOK()) {
+      FMT_LOG(ERROR, "failed to send snapshot [index: {}] to {}: {}",
+              m->snapshot().metadata().index(), url, s.ToString());
+    }
+    done(!s.IsOK());
+  });
+}
+
+Status SnapshotSender::transfer(const std::string& url, const yaraft::pb::Message& msg) {
+  brpc::Channel channel;
+  brpc::ChannelOptions options;
+  options.max_retry = 0;
+  options.connect_timeout_ms = 2000;
+  options.timeout_ms = 10 * 1000;
+  if (channel.Init(url.c_str(), &options) != 0) {
+    return FMT_Status(RpcError, "failed to init channel to {}", url);
+  }
+  pb::RaftService_Stub stub(&channel);
+
+  std::unique_ptr<SnapshotReader> reader;
+  RETURN_NOT_OK(snapshotter_->OpenSnapshot(msg.snapshot().metadata().index(), &reader));
+
+  auto start = std::chrono::steady_clock::now();
+  uint64_t offset = 0;
+  bool eof = false;
+  while (!eof) {
+    std::string chunk;
+    RETURN_NOT_OK(reader->Read(chunkSize_, &chunk, &eof));
+
+    pb::InstallSnapshotRequest request;
+    pb::InstallSnapshotResponse response;
+    request.mutable_message()->CopyFrom(msg);
+    request.set_group_id(groupId_);
+    request.set_offset(offset);
+    request.set_done(eof);
+
+    brpc::Controller cntl;
+    cntl.request_attachment().append(chunk);
+    stub.InstallSnapshot(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+      return FMT_Status(RpcError, "InstallSnapshot [offset: {}]: {}", offset,
+                        cntl.ErrorText());
+    }
+    offset += chunk.size();
+
+    // sleeps until the sent bytes are within the rate.
+    if (bytesPerSec_ > 0) {
+      auto expected = start + std::chrono::microseconds(offset * 1000000 / bytesPerSec_);
+      std::this_thread::sleep_until(expected);
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace rpc
+}  // namespace consensus
@@ -0,0 +1,60 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "base/status.h"
+#include "base/task_queue.h"
+#include "snapshot.h"
+
+#include <yaraft/pb/raftpb.pb.h>
+
+#include <functional>
+
+namespace consensus {
+namespace rpc {
+
+// SnapshotSender ships the snapshots of the application to the followers. Each MsgSnap
+// is sent as a series of InstallSnapshot calls, each carrying a chunk in its attachment,
+// the last one is marked done. The transfers run one at a time in a background thread,
+// at no more than `bytesPerSec` if it's not 0, so that they won't starve the replication.
+//
+// Thread-Safe
+class SnapshotSender {
+ public:
+  // Called with whether the transfer failed, in the background thread.
+  typedef std::function<void(bool failed)> Callback;
+
+  // The snapshots are of the raft group `groupId`.
+  SnapshotSender(Snapshotter* snapshotter, size_t chunkSize, uint64_t bytesPerSec,
+                 uint64_t groupId = 0);
+
+  // `msg` is the MsgSnap from raft, its snapshot data is replaced by the one read
+  // from the snapshotter.
+  void Send(const std::string& url, yaraft::pb::Message* msg, Callback done);
+
+ private:
+  Status transfer(const std::string& url, const yaraft::pb::Message& msg);
+
+ private:
+  Snapshotter* snapshotter_;
+  const size_t chunkSize_;
+  const uint64_t bytesPerSec_;
+  const uint64_t groupId_;
+
+  TaskQueue queue_;
+};
+
+}  // namespace rpc
+}  // namespace consensus
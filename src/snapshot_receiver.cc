@@ -0,0 +1,102 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot_receiver.h"
+#include "raft_task_executor.h"
+
+#include "base/logging.h"
+
+namespace consensus {
+
+SnapshotReceiver::SnapshotReceiver(RaftTaskExecutor* executor, Snapshotter* snapshotter,
+                                   wal::WriteAheadLog* wal)
+    : executor_(executor), snapshotter_(snapshotter), wal_(wal) {}
+
+SnapshotReceiver::~SnapshotReceiver() {
+  if (writer_) {
+    writer_->Abort();
+  }
+}
+
+Status SnapshotReceiver::write(const pb::InstallSnapshotRequest& request, const Slice& chunk) {
+  const yaraft::pb::SnapshotMetadata& meta = request.message().snapshot().metadata();
+
+  if (request.offset() == 0) {
+    if (writer_) {
+      FMT_LOG(WARNING, "restarting snapshot install [index: {}], previous: [index: {}]",
+              meta.index(), index_);
+      writer_->Abort();
+      writer_.reset();
+    }
+    RETURN_NOT_OK(snapshotter_->BeginInstall(meta.index(), meta.term(), &writer_));
+    index_ = meta.index();
+    nextOffset_ = 0;
+  }
+
+  if (!writer_ || meta.index() != index_ || request.offset() != nextOffset_) {
+    return FMT_Status(IllegalState,
+                      "unexpected snapshot chunk [index: {}, offset: {}], "
+                      "expected: [index: {}, offset: {}]",
+                      meta.index(), request.offset(), index_, nextOffset_);
+  }
+
+  Status s = writer_->Write(chunk);
+  if (!s.IsOK()) {
+    writer_->Abort();
+    writer_.reset();
+    return s;
+  }
+  nextOffset_ += chunk.size();
+  return Status::OK();
+}
+
+void SnapshotReceiver::Receive(const pb::InstallSnapshotRequest& request, const Slice& chunk,
+                               std::function<void(const Status&)> done) {
+  std::unique_lock<std::mutex> lock(mu_);
+  Status s = write(request, chunk);
+  if (!s.IsOK() || !request.done()) {
+    lock.unlock();
+    done(s);
+    return;
+  }
+
+  std::unique_ptr<SnapshotWriter> writer(std::move(writer_));
+  lock.unlock();
+  s = writer->Finish();
+  if (!s.IsOK()) {
+    writer->Abort();
+    done(s);
+    return;
+  }
+
+  // the application state is replaced, the log has to follow.
+  auto msg = std::make_shared<yaraft::pb::Message>(request.message());
+  wal::WriteAheadLog* wal = wal_;
+  executor_->MarkActive();
+  executor_->Submit([msg, wal, done](yaraft::RawNode* node) {
+    uint64_t index = msg->snapshot().metadata().index();
+    node->Step(*msg);
+
+    // the snapshot is ignored if the log is already beyond it.
+    Status s;
+    if (wal && node->LastIndex() == index) {
+      wal::WriteAheadLog::CompactionHint hint;
+      hint.compactIndex = index;
+      s = wal->GC(&hint);
+    }
+    done(s);
+  });
+}
+
+}  // namespace consensus
@@ -0,0 +1,66 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "base/status.h"
+#include "pb/raft_server.pb.h"
+#include "snapshot.h"
+#include "wal/wal.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace consensus {
+
+class RaftTaskExecutor;
+
+// SnapshotReceiver installs the snapshot of the leader chunk by chunk, see
+// rpc::SnapshotSender. Once all the chunks are written, the application state is
+// replaced, the MsgSnap is stepped so that raft restores its log from the snapshot,
+// and the wal drops the entries it covers.
+//
+// Thread-Safe
+class SnapshotReceiver {
+ public:
+  // `wal` can be null if there's no log to reset.
+  SnapshotReceiver(RaftTaskExecutor* executor, Snapshotter* snapshotter,
+                   wal::WriteAheadLog* wal);
+
+  // Aborts the unfinished install, if there's one.
+  ~SnapshotReceiver();
+
+  // The chunks must arrive in order, a chunk at offset 0 restarts the install.
+  // `done` is called once the chunk is written, or after the MsgSnap is stepped for
+  // the last chunk, possibly in the raft thread.
+  void Receive(const pb::InstallSnapshotRequest& request, const Slice& chunk,
+               std::function<void(const Status&)> done);
+
+ private:
+  Status write(const pb::InstallSnapshotRequest& request, const Slice& chunk);
+
+ private:
+  RaftTaskExecutor* executor_;
+  Snapshotter* snapshotter_;
+  wal::WriteAheadLog* wal_;
+
+  std::mutex mu_;
+  // null if no install is in progress.
+  std::unique_ptr<SnapshotWriter> writer_;
+  uint64_t index_{0};
+  uint64_t nextOffset_{0};
+};
+
+}  // namespace consensus
@@ -0,0 +1,140 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "wal/block_cache.h"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace consensus {
+namespace wal {
+
+class BlockCache::Impl {
+ public:
+  explicit Impl(size_t capacity) {
+    for (auto& s : shards_) {
+      s.capacity = (capacity + kNumShards - 1) / kNumShards;
+    }
+  }
+
+  Block Lookup(uint64_t segmentId, uint64_t offset) {
+    Key key{segmentId, offset};
+    Shard& s = shardOf(key);
+
+    std::lock_guard<std::mutex> g(s.mu);
+    auto it = s.table.find(key);
+    if (it == s.table.end()) {
+      return nullptr;
+    }
+    // move to the most recently used end
+    s.lru.splice(s.lru.end(), s.lru, it->second);
+    return it->second->block;
+  }
+
+  void Insert(uint64_t segmentId, uint64_t offset, Block block, size_t charge) {
+    Key key{segmentId, offset};
+    Shard& s = shardOf(key);
+
+    std::lock_guard<std::mutex> g(s.mu);
+    auto it = s.table.find(key);
+    if (it != s.table.end()) {
+      s.usage -= it->second->charge;
+      s.lru.erase(it->second);
+      s.table.erase(it);
+    }
+
+    s.lru.push_back(Entry{key, std::move(block), charge});
+    s.table[key] = std::prev(s.lru.end());
+    s.usage += charge;
+
+    // the block just inserted is evicted as well if it alone exceeds the capacity.
+    while (s.usage > s.capacity && !s.lru.empty()) {
+      Entry& victim = s.lru.front();
+      s.usage -= victim.charge;
+      s.table.erase(victim.key);
+      s.lru.pop_front();
+    }
+  }
+
+  size_t Usage() const {
+    size_t usage = 0;
+    for (auto& s : shards_) {
+      std::lock_guard<std::mutex> g(s.mu);
+      usage += s.usage;
+    }
+    return usage;
+  }
+
+ private:
+  struct Key {
+    uint64_t segmentId;
+    uint64_t offset;
+
+    bool operator==(const Key& rhs) const {
+      return segmentId == rhs.segmentId && offset == rhs.offset;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& k) const {
+      // mix the bits so that blocks of the same segment are spread over shards.
+      uint64_t h = k.segmentId * 0x9E3779B97F4A7C15ULL ^ k.offset;
+      h ^= h >> 33;
+      h *= 0xFF51AFD7ED558CCDULL;
+      h ^= h >> 33;
+      return static_cast<size_t>(h);
+    }
+  };
+
+  struct Entry {
+    Key key;
+    Block block;
+    size_t charge;
+  };
+
+  struct Shard {
+    mutable std::mutex mu;
+    std::list<Entry> lru;  // from the least recently used
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> table;
+    size_t usage = 0;
+    size_t capacity = 0;
+  };
+
+  Shard& shardOf(const Key& key) {
+    return shards_[KeyHash()(key) % kNumShards];
+  }
+
+ private:
+  static constexpr size_t kNumShards = 16;
+  Shard shards_[kNumShards];
+};
+
+BlockCache::BlockCache(size_t capacity) : impl_(new Impl(capacity)) {}
+
+BlockCache::~BlockCache() = default;
+
+BlockCache::Block BlockCache::Lookup(uint64_t segmentId, uint64_t offset) {
+  return impl_->Lookup(segmentId, offset);
+}
+
+void BlockCache::Insert(uint64_t segmentId, uint64_t offset, Block block, size_t charge) {
+  impl_->Insert(segmentId, offset, std::move(block), charge);
+}
+
+size_t BlockCache::Usage() const {
+  return impl_->Usage();
+}
+
+}  // namespace wal
+}  // namespace consensus
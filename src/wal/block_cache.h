@@ -0,0 +1,53 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <memory>
+
+#include <yaraft/memory_storage.h>
+
+namespace consensus {
+namespace wal {
+
+// BlockCache holds the blocks of entries decoded from sealed segments, with the
+// least recently used ones evicted once the charges exceed the capacity.
+// The cache is split into shards by key, each of which is guarded by its own
+// lock and takes an equal part of the capacity, so that concurrent readers
+// rarely contend.
+//
+// Thread-Safe
+class BlockCache {
+ public:
+  using Block = std::shared_ptr<const yaraft::EntryVec>;
+
+  explicit BlockCache(size_t capacity);
+
+  ~BlockCache();
+
+  // Returns null if the block is not cached.
+  Block Lookup(uint64_t segmentId, uint64_t offset);
+
+  // The block replaces the one cached with the same key.
+  void Insert(uint64_t segmentId, uint64_t offset, Block block, size_t charge);
+
+  // total charges of the cached blocks.
+  size_t Usage() const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace wal
+}  // namespace consensus
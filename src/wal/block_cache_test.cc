@@ -0,0 +1,110 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <thread>
+
+#include "base/testing.h"
+#include "wal/block_cache.h"
+
+#include <yaraft/pb_utils.h>
+
+namespace consensus {
+namespace wal {
+
+class BlockCacheTest : public BaseTest {
+ public:
+  static BlockCache::Block MakeBlock(uint64_t index) {
+    yaraft::EntryVec vec{yaraft::PBEntry().Index(index).Term(1).v};
+    return std::make_shared<const yaraft::EntryVec>(std::move(vec));
+  }
+};
+
+TEST_F(BlockCacheTest, LookupAndInsert) {
+  BlockCache cache(1024 * 1024);
+  ASSERT_EQ(cache.Lookup(1, 0), nullptr);
+
+  cache.Insert(1, 0, MakeBlock(1), 100);
+  cache.Insert(1, 4096, MakeBlock(2), 100);
+  cache.Insert(2, 0, MakeBlock(3), 100);
+  ASSERT_EQ(cache.Usage(), 300);
+
+  ASSERT_EQ(cache.Lookup(1, 0)->front().index(), 1);
+  ASSERT_EQ(cache.Lookup(1, 4096)->front().index(), 2);
+  ASSERT_EQ(cache.Lookup(2, 0)->front().index(), 3);
+  ASSERT_EQ(cache.Lookup(2, 4096), nullptr);
+
+  // replace the cached one
+  cache.Insert(1, 0, MakeBlock(4), 50);
+  ASSERT_EQ(cache.Lookup(1, 0)->front().index(), 4);
+  ASSERT_EQ(cache.Usage(), 250);
+}
+
+// This test verifies that the least recently used blocks are evicted once the
+// capacity is exceeded.
+TEST_F(BlockCacheTest, Evict) {
+  // each of the 16 shards holds 10 bytes.
+  BlockCache cache(160);
+
+  for (uint64_t i = 0; i < 1000; i++) {
+    cache.Insert(1, i, MakeBlock(i), 5);
+  }
+  ASSERT_LE(cache.Usage(), 160);
+
+  size_t cached = 0;
+  for (uint64_t i = 0; i < 1000; i++) {
+    if (cache.Lookup(1, i)) {
+      cached++;
+    }
+  }
+  ASSERT_EQ(cached * 5, cache.Usage());
+
+  // a block larger than the capacity is not cached.
+  cache.Insert(2, 0, MakeBlock(0), 1000);
+  ASSERT_EQ(cache.Lookup(2, 0), nullptr);
+
+  // blocks in use are not freed by eviction.
+  BlockCache::Block b = MakeBlock(7);
+  BlockCache small(16);
+  small.Insert(1, 0, b, 1);
+  for (uint64_t i = 1; i < 100; i++) {
+    small.Insert(1, i, MakeBlock(i), 1);
+  }
+  ASSERT_EQ(b->front().index(), 7);
+  ASSERT_EQ(b.use_count(), 1);
+}
+
+TEST_F(BlockCacheTest, Concurrent) {
+  BlockCache cache(64 * 1024);
+
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < 8; t++) {
+    threads.emplace_back([&cache, t]() {
+      for (uint64_t i = 0; i < 10000; i++) {
+        uint64_t offset = i % 512;
+        BlockCache::Block b = cache.Lookup(t % 2, offset);
+        if (b) {
+          ASSERT_EQ(b->front().index(), offset);
+        } else {
+          cache.Insert(t % 2, offset, MakeBlock(offset), 100);
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_LE(cache.Usage(), 64 * 1024);
+}
+
+}  // namespace wal
+}  // namespace consensus
@@ -0,0 +1,255 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "wal/bounded_memory_storage.h"
+#include "base/logging.h"
+#include "base/memory_tracker.h"
+
+#include <limits>
+
+namespace consensus {
+namespace wal {
+
+BoundedMemoryStorage::BoundedMemoryStorage(yaraft::MemoryStorage* memstore, WriteAheadLog* wal,
+                                           size_t maxEntries, size_t maxBytes)
+    : memstore_(memstore),
+      wal_(wal),
+      maxEntries_(maxEntries),
+      maxBytes_(maxBytes),
+      compactIndex_(memstore->FirstIndex() - 1),
+      compactTerm_(memstore->Term(compactIndex_).GetValue()),
+      evictIndex_(compactIndex_),
+      bytes_(0),
+      readableIndex_(compactIndex_),
+      accounted_(0) {
+  syncWithMemStore();
+}
+
+BoundedMemoryStorage::~BoundedMemoryStorage() {
+  MemoryTracker::Instance().Release(MemoryTracker::kMemStore, static_cast<int64_t>(accounted_));
+}
+
+yaraft::StatusWith<yaraft::EntryVec> BoundedMemoryStorage::Entries(uint64_t lo, uint64_t hi,
+                                                                   uint64_t* maxSize) {
+  if (lo <= compactIndex_) {
+    return yaraft::Status::Make(yaraft::Error::LogCompacted);
+  }
+  if (hi > LastIndex() + 1) {
+    return yaraft::Status::Make(yaraft::Error::OutOfBound);
+  }
+  if (lo > evictIndex_) {
+    return memstore_->Entries(lo, hi, maxSize);
+  }
+
+  uint64_t maxBytes = maxSize ? *maxSize : std::numeric_limits<uint64_t>::max();
+  uint64_t end = std::min(hi, evictIndex_ + 1);
+  yaraft::EntryVec entries;
+  Status s = wal_->ReadEntries(lo, end, maxBytes, &entries);
+  if (s.Code() == Error::LogCompacted) {
+    return yaraft::Status::Make(yaraft::Error::LogCompacted);
+  }
+  // the evicted entries must have been persisted.
+  FATAL_NOT_OK(s, fmt::format("WriteAheadLog::ReadEntries [{}, {})", lo, end));
+  if (entries.back().index() + 1 < end || end == hi) {
+    return entries;
+  }
+
+  // the rest are in the memstore.
+  uint64_t bytes = 0;
+  for (const auto& e : entries) {
+    bytes += e.ByteSize();
+  }
+  if (bytes >= maxBytes) {
+    return entries;
+  }
+  uint64_t remain = maxBytes - bytes;
+  auto sw = memstore_->Entries(end, hi, maxSize ? &remain : nullptr);
+  if (sw.IsOK()) {
+    auto& rest = sw.GetValue();
+    std::move(rest.begin(), rest.end(), std::back_inserter(entries));
+  }
+  return entries;
+}
+
+yaraft::StatusWith<uint64_t> BoundedMemoryStorage::Term(uint64_t i) const {
+  if (i < compactIndex_) {
+    return yaraft::Status::Make(yaraft::Error::LogCompacted);
+  }
+  if (i == compactIndex_) {
+    return compactTerm_;
+  }
+  if (i >= evictIndex_) {
+    return memstore_->Term(i);
+  }
+
+  yaraft::EntryVec entries;
+  Status s = wal_->ReadEntries(i, i + 1, 0, &entries);
+  if (s.Code() == Error::LogCompacted) {
+    return yaraft::Status::Make(yaraft::Error::LogCompacted);
+  }
+  FATAL_NOT_OK(s, fmt::format("WriteAheadLog::ReadEntries [{}, {})", i, i + 1));
+  return entries[0].term();
+}
+
+void BoundedMemoryStorage::SetLogStart(uint64_t compactIndex, uint64_t compactTerm) {
+  LOG_ASSERT(compactIndex <= evictIndex_);
+  compactIndex_ = compactIndex;
+  compactTerm_ = compactTerm;
+}
+
+Status BoundedMemoryStorage::MaybeEvict() {
+  syncWithMemStore();
+
+  size_t n = sizes_.size();
+  bool overEntries = maxEntries_ > 0 && n > maxEntries_;
+  bool overBytes = maxBytes_ > 0 && bytes_ > maxBytes_;
+  // the process is short of memory, every entry that can be is evicted.
+  bool overMemory = n > 0 && MemoryTracker::Instance().OverSoftLimit();
+  if (!overEntries && !overBytes && !overMemory) {
+    return Status::OK();
+  }
+
+  // uncommitted entries may be overwritten, they must stay in the memstore.
+  uint64_t limit = std::min<uint64_t>(memstore_->InitialState().GetValue().commit(),
+                                      evictIndex_ + n);
+  limit = readableUpTo(evictIndex_, limit);
+  if (limit <= evictIndex_) {
+    return Status::OK();
+  }
+
+  if (overMemory) {
+    evict(limit);
+    return Status::OK();
+  }
+
+  // evict the fewest entries that satisfy both limits.
+  size_t k = overEntries ? n - maxEntries_ : 0;
+  if (overBytes) {
+    size_t remain = bytes_;
+    size_t i = 0;
+    for (; i < k; i++) {
+      remain -= sizes_[i].second;
+    }
+    for (; remain > maxBytes_ && i < limit - evictIndex_; i++) {
+      remain -= sizes_[i].second;
+    }
+    k = i;
+  }
+  evict(std::min(evictIndex_ + k, limit));
+  return Status::OK();
+}
+
+Status BoundedMemoryStorage::Compact(uint64_t compactIndex) {
+  syncWithMemStore();
+  if (compactIndex <= compactIndex_) {
+    return Status::OK();
+  }
+  if (compactIndex > LastIndex()) {
+    return FMT_Status(OutOfBound, "compact index {} is out of bound [last index: {}]",
+                      compactIndex, LastIndex());
+  }
+
+  auto term = Term(compactIndex);
+  if (!term.IsOK()) {
+    return Status::Make(Error::YARaftError, term.ToString());
+  }
+  if (compactIndex > evictIndex_) {
+    evict(compactIndex);
+  }
+  compactIndex_ = compactIndex;
+  compactTerm_ = term.GetValue();
+  return Status::OK();
+}
+
+void BoundedMemoryStorage::syncWithMemStore() {
+  const yaraft::EntryVec& vec = memstore_->TEST_Entries();
+  uint64_t offset = vec[0].index();
+  if (offset != evictIndex_) {
+    // compacted or replaced by snapshot outside.
+    compactIndex_ = offset;
+    compactTerm_ = vec[0].term();
+    evictIndex_ = offset;
+    readableIndex_ = offset;
+    sizes_.clear();
+    bytes_ = 0;
+  }
+
+  // The entries overwritten since the last call are dropped. An entry with the
+  // same index and term as before implies that all the previous ones are unchanged.
+  while (!sizes_.empty()) {
+    size_t i = sizes_.size();
+    if (i < vec.size() && vec[i].term() == sizes_.back().first) {
+      break;
+    }
+    bytes_ -= sizes_.back().second;
+    sizes_.pop_back();
+  }
+  for (size_t i = sizes_.size() + 1; i < vec.size(); i++) {
+    size_t size = vec[i].ByteSize();
+    sizes_.emplace_back(vec[i].term(), size);
+    bytes_ += size;
+  }
+  account();
+}
+
+void BoundedMemoryStorage::account() {
+  if (bytes_ != accounted_) {
+    MemoryTracker::Instance().Consume(MemoryTracker::kMemStore,
+                                      static_cast<int64_t>(bytes_) -
+                                          static_cast<int64_t>(accounted_));
+    accounted_ = bytes_;
+  }
+}
+
+uint64_t BoundedMemoryStorage::readableUpTo(uint64_t evictIndex, uint64_t target) {
+  if (target <= readableIndex_) {
+    return target;
+  }
+
+  auto readable = [this](uint64_t i) {
+    yaraft::EntryVec entries;
+    return wal_->ReadEntries(i, i + 1, 0, &entries).IsOK();
+  };
+  if (readable(target)) {
+    readableIndex_ = target;
+    return target;
+  }
+
+  // the readable ones are a prefix of the log.
+  uint64_t lo = std::max(evictIndex, readableIndex_), hi = target - 1;
+  while (lo < hi) {
+    uint64_t mid = lo + (hi - lo + 1) / 2;
+    if (readable(mid)) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  readableIndex_ = std::max(readableIndex_, lo);
+  return lo;
+}
+
+void BoundedMemoryStorage::evict(uint64_t index) {
+  auto s = memstore_->Compact(index);
+  LOG_ASSERT(s.IsOK()) << s.ToString();
+
+  for (uint64_t i = evictIndex_; i < index; i++) {
+    bytes_ -= sizes_.front().second;
+    sizes_.pop_front();
+  }
+  evictIndex_ = index;
+  account();
+}
+
+}  // namespace wal
+}  // namespace consensus
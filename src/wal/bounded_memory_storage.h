@@ -0,0 +1,131 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <deque>
+
+#include "base/status.h"
+#include "wal/wal.h"
+
+#include <yaraft/memory_storage.h>
+
+namespace consensus {
+namespace wal {
+
+// BoundedMemoryStorage serves raft with the log in `memstore`, where only the
+// latest entries are retained, bounded by maxEntries and maxBytes. The older
+// entries that are both committed and readable from the wal are evicted from
+// the memstore, and read back by WriteAheadLog::ReadEntries on demand.
+//
+// Entries are still appended into the memstore, e.g by Ready::Advance. The
+// eviction is done by MaybeEvict after that.
+//
+// The bytes in the memstore are accounted to MemoryTracker::kMemStore. Once the
+// process exceeds the soft limit, MaybeEvict evicts every entry it can.
+//
+// Not-Thread-Safe
+class BoundedMemoryStorage : public yaraft::Storage {
+ public:
+  // A limit of 0 means unlimited.
+  BoundedMemoryStorage(yaraft::MemoryStorage* memstore, WriteAheadLog* wal, size_t maxEntries,
+                       size_t maxBytes);
+
+  ~BoundedMemoryStorage();
+
+  yaraft::StatusWith<yaraft::pb::HardState> InitialState() const override {
+    return memstore_->InitialState();
+  }
+
+  yaraft::StatusWith<yaraft::EntryVec> Entries(uint64_t lo, uint64_t hi,
+                                               uint64_t* maxSize) override;
+
+  yaraft::StatusWith<uint64_t> Term(uint64_t i) const override;
+
+  uint64_t LastIndex() const override {
+    return memstore_->LastIndex();
+  }
+
+  // Evicted entries are not counted as compacted.
+  uint64_t FirstIndex() const override {
+    return compactIndex_ + 1;
+  }
+
+  yaraft::StatusWith<yaraft::pb::Snapshot> Snapshot() const override {
+    return memstore_->Snapshot();
+  }
+
+  // The log starts after `compactIndex` rather than the first entry of the memstore,
+  // the entries in between are read from the wal, e.g the ones left by a lazy recovery,
+  // see WriteAheadLog::LazilyRecovered.
+  // Requires: called before any entry is read, `compactIndex` precedes the memstore.
+  void SetLogStart(uint64_t compactIndex, uint64_t compactTerm);
+
+  // Evict the oldest entries from the memstore until the limits are satisfied,
+  // or the remaining ones are not committed or not readable from the wal yet.
+  Status MaybeEvict();
+
+  // Discard the entries up to compactIndex, which are no longer readable.
+  Status Compact(uint64_t compactIndex);
+
+  yaraft::MemoryStorage* MemStore() const {
+    return memstore_;
+  }
+
+  // the number of bytes of the entries in the memstore.
+  size_t MemStoreBytes() const {
+    return bytes_;
+  }
+
+ private:
+  // Account the entries appended into the memstore since the last call.
+  void syncWithMemStore();
+
+  // Returns the largest index in (evictIndex, target] readable from the wal, or
+  // evictIndex if none is.
+  uint64_t readableUpTo(uint64_t evictIndex, uint64_t target);
+
+  // Drop the entries up to `index` from the memstore.
+  void evict(uint64_t index);
+
+  // Report the change of bytes_ to the MemoryTracker.
+  void account();
+
+ private:
+  yaraft::MemoryStorage* memstore_;
+  WriteAheadLog* wal_;
+
+  const size_t maxEntries_;
+  const size_t maxBytes_;
+
+  // the entry before the first one of the log.
+  uint64_t compactIndex_;
+  uint64_t compactTerm_;
+
+  // the entry before the first one in memstore, entries in (compactIndex_, evictIndex_]
+  // are read from the wal.
+  uint64_t evictIndex_;
+
+  // (term, size) of entries in the memstore, starting at evictIndex_ + 1.
+  std::deque<std::pair<uint64_t, size_t>> sizes_;
+  size_t bytes_;
+
+  // the largest index known to be readable from the wal.
+  uint64_t readableIndex_;
+
+  // bytes_ as last reported to the MemoryTracker.
+  size_t accounted_;
+};
+
+}  // namespace wal
+}  // namespace consensus
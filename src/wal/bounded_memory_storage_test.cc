@@ -0,0 +1,153 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "base/testing.h"
+#include "wal/bounded_memory_storage.h"
+#include "wal/log_manager.h"
+
+namespace consensus {
+namespace wal {
+
+using yaraft::EntryVec;
+using yaraft::PBEntry;
+
+class BoundedMemoryStorageTest : public BaseTest {
+ public:
+  void SetUp() override {
+    options_.log_dir = GetTestDir();
+    options_.log_segment_size = 1024;
+
+    yaraft::MemStoreUptr memstore;
+    ASSERT_OK(LogManager::Recover(options_, &memstore, &wal_));
+    memstore_.reset(new yaraft::MemoryStorage);
+  }
+
+  // Write entries in [lo, hi) into both the wal and the memstore.
+  void Append(uint64_t lo, uint64_t hi, uint64_t term) {
+    EntryVec vec;
+    for (uint64_t i = lo; i < hi; i++) {
+      vec.push_back(PBEntry().Index(i).Term(term).Data(std::string(10, 'a')).v);
+      expected_.resize(i - 1);
+      expected_.push_back(vec.back());
+    }
+    ASSERT_OK(wal_->Write(vec, nullptr));
+    memstore_->Append(vec);
+  }
+
+  void Commit(uint64_t index) {
+    yaraft::pb::HardState hs;
+    hs.set_commit(index);
+    memstore_->SetHardState(hs);
+  }
+
+  void CheckEntries(BoundedMemoryStorage& storage) {
+    ASSERT_EQ(storage.FirstIndex(), 1);
+    ASSERT_EQ(storage.LastIndex(), expected_.size());
+
+    auto sw = storage.Entries(1, expected_.size() + 1, nullptr);
+    ASSERT_TRUE(sw.IsOK());
+    const EntryVec& actual = sw.GetValue();
+    ASSERT_EQ(actual.size(), expected_.size());
+    for (size_t i = 0; i < actual.size(); i++) {
+      ASSERT_EQ(actual[i].DebugString(), expected_[i].DebugString());
+
+      auto term = storage.Term(i + 1);
+      ASSERT_TRUE(term.IsOK());
+      ASSERT_EQ(term.GetValue(), expected_[i].term());
+    }
+  }
+
+ protected:
+  TestDirGuard guard_{CreateTestDirGuard()};
+  WriteAheadLogOptions options_;
+  LogManagerUPtr wal_;
+  yaraft::MemStoreUptr memstore_;
+  EntryVec expected_;
+};
+
+// This test verifies that only the committed entries in sealed segments are evicted.
+TEST_F(BoundedMemoryStorageTest, EvictByEntries) {
+  BoundedMemoryStorage storage(memstore_.get(), wal_.get(), 100, 0);
+
+  Append(1, 1001, 1);
+  ASSERT_OK(storage.MaybeEvict());
+  ASSERT_EQ(memstore_->FirstIndex(), 1);  // not committed
+
+  Commit(800);
+  ASSERT_OK(storage.MaybeEvict());
+  ASSERT_GT(memstore_->FirstIndex(), 1);
+  ASSERT_LE(memstore_->FirstIndex(), 801);
+  CheckEntries(storage);
+
+  // the rest are readable once the current segment is sealed.
+  Commit(1000);
+  ASSERT_OK(wal_->Close());
+  ASSERT_OK(storage.MaybeEvict());
+  ASSERT_EQ(memstore_->FirstIndex(), 901);
+  CheckEntries(storage);
+}
+
+TEST_F(BoundedMemoryStorageTest, EvictByBytes) {
+  BoundedMemoryStorage storage(memstore_.get(), wal_.get(), 0, 1000);
+
+  Append(1, 1001, 1);
+  Commit(1000);
+  ASSERT_OK(wal_->Close());
+  ASSERT_OK(storage.MaybeEvict());
+  ASSERT_LE(storage.MemStoreBytes(), 1000);
+  ASSERT_GT(storage.MemStoreBytes(), 900);
+  ASSERT_GT(memstore_->FirstIndex(), 900);
+  CheckEntries(storage);
+}
+
+// This test verifies that the entries overwritten in memstore are no longer accounted.
+TEST_F(BoundedMemoryStorageTest, Overwrite) {
+  BoundedMemoryStorage storage(memstore_.get(), wal_.get(), 100, 0);
+
+  Append(1, 501, 1);
+  Commit(300);
+  ASSERT_OK(storage.MaybeEvict());
+  size_t bytes = storage.MemStoreBytes();
+
+  // entries from 400 on are overwritten
+  Append(400, 401, 2);
+  ASSERT_OK(storage.MaybeEvict());
+  ASSERT_LT(storage.MemStoreBytes(), bytes);
+  CheckEntries(storage);
+
+  ASSERT_OK(storage.Compact(200));
+  ASSERT_EQ(storage.FirstIndex(), 201);
+  ASSERT_EQ(storage.Entries(10, 20, nullptr).Code(), yaraft::Error::LogCompacted);
+}
+
+// This test verifies that the entries left in the wal by a lazy recovery are read
+// back on demand.
+TEST_F(BoundedMemoryStorageTest, LazyRecovery) {
+  Append(1, 1001, 1);
+  ASSERT_OK(wal_->Close());
+
+  wal_.reset();
+  memstore_.reset();
+  options_.lazy_recovery_entries = 100;
+  ASSERT_OK(LogManager::Recover(options_, &memstore_, &wal_));
+  ASSERT_GT(memstore_->FirstIndex(), 1);
+
+  uint64_t compactIndex, compactTerm;
+  ASSERT_TRUE(wal_->LazilyRecovered(&compactIndex, &compactTerm));
+  BoundedMemoryStorage storage(memstore_.get(), wal_.get(), 0, 0);
+  storage.SetLogStart(compactIndex, compactTerm);
+  CheckEntries(storage);
+}
+
+}  // namespace wal
+}  // namespace consensus
@@ -0,0 +1,102 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "wal/compression.h"
+
+#include <cstring>
+
+#include <zlib.h>
+
+namespace consensus {
+namespace wal {
+
+// Batches are compressed in raw deflate format, since each of them is protected
+// by the batch checksum already.
+static constexpr int kZlibWindowBits = -15;
+
+static Status zlibCompress(const Slice *data, size_t cnt, std::string *dst) {
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  int ret = deflateInit2(&strm, Z_BEST_SPEED, Z_DEFLATED, kZlibWindowBits, 8, Z_DEFAULT_STRATEGY);
+  if (ret != Z_OK) {
+    return FMT_Status(RuntimeError, "deflateInit2: {}", ret);
+  }
+
+  size_t rawLength = 0;
+  for (size_t i = 0; i < cnt; i++) {
+    rawLength += data[i].size();
+  }
+  size_t begin = dst->size();
+  dst->resize(begin + deflateBound(&strm, rawLength));
+  strm.next_out = reinterpret_cast<Bytef *>(&(*dst)[begin]);
+  strm.avail_out = static_cast<uInt>(dst->size() - begin);
+
+  // the output buffer is large enough to hold the whole result.
+  for (size_t i = 0; i < cnt && ret == Z_OK; i++) {
+    strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data[i].data()));
+    strm.avail_in = static_cast<uInt>(data[i].size());
+    ret = deflate(&strm, i + 1 == cnt ? Z_FINISH : Z_NO_FLUSH);
+  }
+  if (cnt == 0) {
+    ret = deflate(&strm, Z_FINISH);
+  }
+  dst->resize(dst->size() - strm.avail_out);
+  deflateEnd(&strm);
+  if (ret != Z_STREAM_END) {
+    return FMT_Status(RuntimeError, "deflate: {}", ret);
+  }
+  return Status::OK();
+}
+
+static Status zlibUncompress(const Slice &input, size_t rawLength, std::string *dst) {
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  int ret = inflateInit2(&strm, kZlibWindowBits);
+  if (ret != Z_OK) {
+    return FMT_Status(RuntimeError, "inflateInit2: {}", ret);
+  }
+
+  dst->resize(rawLength);
+  strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+  strm.avail_in = static_cast<uInt>(input.size());
+  strm.next_out = reinterpret_cast<Bytef *>(&(*dst)[0]);
+  strm.avail_out = static_cast<uInt>(rawLength);
+  ret = inflate(&strm, Z_FINISH);
+  inflateEnd(&strm);
+  if (ret != Z_STREAM_END || strm.avail_out != 0) {
+    return FMT_Status(Corruption, "bad compressed batch, inflate: {}", ret);
+  }
+  return Status::OK();
+}
+
+Status Compress(CompressionType type, const Slice *data, size_t cnt, std::string *dst) {
+  switch (type) {
+    case kZlibCompression:
+      return zlibCompress(data, cnt, dst);
+    default:
+      return FMT_Status(NotSupported, "unknown compression type: {}", static_cast<int>(type));
+  }
+}
+
+Status Uncompress(CompressionType type, const Slice &input, size_t rawLength,
+                  std::string *dst) {
+  switch (type) {
+    case kZlibCompression:
+      return zlibUncompress(input, rawLength, dst);
+    default:
+      return FMT_Status(Corruption, "unknown compression type: {}", static_cast<int>(type));
+  }
+}
+
+}  // namespace wal
+}  // namespace consensus
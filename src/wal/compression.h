@@ -0,0 +1,32 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <string>
+
+#include "base/status.h"
+#include "wal/format.h"
+
+namespace consensus {
+namespace wal {
+
+// Compress the concatenation of data[0, cnt) and append it to `dst`.
+extern Status Compress(CompressionType type, const Slice *data, size_t cnt, std::string *dst);
+
+// Uncompress `input` that's `rawLength` bytes before compression into `dst`.
+extern Status Uncompress(CompressionType type, const Slice &input, size_t rawLength,
+                         std::string *dst);
+
+}  // namespace wal
+}  // namespace consensus
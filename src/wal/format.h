@@ -25,23 +25,95 @@ namespace wal {
 //  LogHeader := Crc32 Length
 //  Record := Type VarString
 //
-//  Crc32     -> 4 bytes, checksum of fields followed in the log block
+//  Crc32     -> 4 bytes, checksum of fields followed in the log block, computed
+//               by the algorithm specified in the segment header
 //  Type      -> 1 byte, RecordType
 //  VarString -> varint32 + bytes, encoded log entry or encoded hard state
 //
+//  The hard state is encoded in a fixed layout, rather than by protobuf:
+//
+//  HardStateRecord := Type(kFixedHardStateType) VarString(Term Vote Commit)
+//
+//  Term, Vote, Commit -> fixed64 each, 24 bytes in total
+//
+//  The segments written before may carry the hard states of Type(kHardStateType)
+//  encoded by protobuf, which are still read. See RecordCodec for the codecs.
+//
 //  Each segment composes of a series of log entries:
 //
-//  Segment := SegmentHeader LogBlock* SegmentFooter
-//  SegmentHeader := Magic
-//  SegmentFooter :=
+//  Segment := SegmentHeader LogBlock* [SegmentFooter]
+//  SegmentHeader := Magic ChecksumType
+//  SegmentFooter := FooterBatch FooterOffset FooterMagic
+//  FooterBatch := LogHeader Type(kFooterType) VarString(FooterBody)
+//  FooterBody := FirstIndex LastIndex NumEntries NumIndex IndexEntry* SegmentChecksum
+//  IndexEntry := IndexDelta OffsetDelta
+//
+//  Magic           -> kLogSegmentHeaderMagic
+//  ChecksumType    -> 1 byte, ChecksumType
+//  FooterOffset    -> 8 bytes, offset of FooterBatch in the segment
+//  FooterMagic     -> kSegmentFooterMagic
+//  FirstIndex, LastIndex, NumEntries, NumIndex, IndexDelta, OffsetDelta
+//                  -> varint64, index entries are delta-encoded against the previous one
+//  SegmentChecksum -> 4 bytes, crc32c of the segment before FooterBatch
+//
+//  The footer is written only when the segment is finished, a segment without a
+//  footer is read by scanning all batches.
+//
+//  Segments of the legacy format start with kLegacyLogSegmentHeaderMagic, which
+//  is not followed by ChecksumType, and are checksummed by crc32.
+//
+//  A batch may be compressed, in which case it contains a single record:
+//
+//  CompressedBatch := LogHeader Type(kCompressedType) VarString(CompressedBody)
+//  CompressedBody := CompressionType RawLength CompressedData
+//
+//  CompressionType -> 1 byte, CompressionType
+//  RawLength       -> varint32, length of the records before compression
+//  CompressedData  -> Record+ compressed
+//
+//  Segments of SharedWriteAheadLog interleave the records of many groups, where
+//  each batch starts with a group record, and the records following a group
+//  record belong to that group:
+//
+//  GroupRecord := Type(kGroupType) VarString(GroupId)
+//
+//  GroupId -> varint64
+//
+//  A follower overwriting the conflicting entries already in the segment starts the
+//  batch with a truncate record, after which the entries from TruncateIndex on that
+//  precede the record are discarded:
+//
+//  TruncateRecord := Type(kTruncateType) VarString(TruncateIndex)
+//
+//  TruncateIndex -> varint64
+//
+//  Readers unaware of the record skip it, the entries following it overwrite the
+//  conflicting ones by index anyway.
 //
 
 constexpr static size_t kLogBatchHeaderSize = 4 + 4;
 constexpr static size_t kRecordHeaderSize = 1;
+constexpr static size_t kChecksumTypeSize = 1;
+constexpr static size_t kSegmentFooterTrailerSize = 8 + 8;
 
 enum RecordType {
   kHardStateType = 1,
   kLogEntryType = 2,
+  kFooterType = 3,
+  kCompressedType = 4,
+  kGroupType = 5,
+  kTruncateType = 6,
+  kFixedHardStateType = 7,
+};
+
+enum CompressionType {
+  kNoCompression = 0,
+  kZlibCompression = 1,
+};
+
+enum ChecksumType {
+  kCRC32 = 1,
+  kCRC32C = 2,
 };
 
 }  // namespace wal
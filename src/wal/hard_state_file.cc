@@ -0,0 +1,102 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wal/hard_state_file.h"
+#include "base/coding.h"
+#include "base/crc32c.h"
+#include "base/env_util.h"
+#include "wal/segment_meta.h"
+
+#include <memory>
+
+#include <fmt/format.h>
+
+namespace consensus {
+namespace wal {
+
+constexpr static size_t kHardStateSlotSize = 8 * 4 + 4;
+
+std::string HardStateFile::slotName(uint64_t seq) const {
+  return fmt::format("{}/{}.{}", dir_, kHardStateFileName.ToString(), seq % 2);
+}
+
+Status HardStateFile::readSlot(int slot, uint64_t* seq, yaraft::pb::HardState* hs) {
+  std::string fname = slotName(slot);
+  auto size = env_->GetFileSize(fname);
+  if (!size.IsOK() || size.GetValue() != kHardStateSlotSize) {
+    return Status::Make(Error::NotFound);
+  }
+
+  RandomAccessFile* rf;
+  ASSIGN_IF_OK(env_->NewRandomAccessFile(fname), rf);
+  std::unique_ptr<RandomAccessFile> f(rf);
+
+  char buf[kHardStateSlotSize];
+  Slice s;
+  RETURN_NOT_OK(env_util::ReadFully(rf, 0, kHardStateSlotSize, &s, buf));
+  if (crc32c::Value(buf, kHardStateSlotSize - 4) != DecodeFixed32(buf + kHardStateSlotSize - 4)) {
+    return Status::Make(Error::NotFound);
+  }
+  *seq = DecodeFixed64(buf);
+  hs->set_term(DecodeFixed64(buf + 8));
+  hs->set_vote(DecodeFixed64(buf + 16));
+  hs->set_commit(DecodeFixed64(buf + 24));
+  return Status::OK();
+}
+
+Status HardStateFile::Load(yaraft::pb::HardState* hs) {
+  bool found = false;
+  for (int slot = 0; slot < 2; slot++) {
+    uint64_t seq;
+    yaraft::pb::HardState slotHs;
+    Status s = readSlot(slot, &seq, &slotHs);
+    if (s.Code() == Error::NotFound) {
+      continue;
+    }
+    RETURN_NOT_OK(s);
+    slotSynced_[slot] = true;
+    if (!found || seq > seq_) {
+      seq_ = seq;
+      *hs = slotHs;
+      found = true;
+    }
+  }
+  return found ? Status::OK() : Status::Make(Error::NotFound);
+}
+
+Status HardStateFile::Save(const yaraft::pb::HardState& hs) {
+  std::string buf;
+  PutFixed64(&buf, seq_ + 1);
+  PutFixed64(&buf, hs.term());
+  PutFixed64(&buf, hs.vote());
+  PutFixed64(&buf, hs.commit());
+  PutFixed32(&buf, crc32c::Value(buf.data(), buf.size()));
+
+  WritableFile* wf;
+  ASSIGN_IF_OK(env_->NewWritableFile(slotName(seq_ + 1)), wf);
+  std::unique_ptr<WritableFile> f(wf);
+  RETURN_NOT_OK(f->Append(buf));
+  RETURN_NOT_OK(f->Sync());
+  RETURN_NOT_OK(f->Close());
+  int slot = (seq_ + 1) % 2;
+  if (!slotSynced_[slot]) {
+    RETURN_NOT_OK(env_->SyncDir(dir_));
+    slotSynced_[slot] = true;
+  }
+  seq_++;
+  return Status::OK();
+}
+
+}  // namespace wal
+}  // namespace consensus
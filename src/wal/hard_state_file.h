@@ -0,0 +1,65 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "base/env.h"
+#include "base/status.h"
+
+#include <string>
+
+#include <yaraft/pb/raftpb.pb.h>
+
+namespace consensus {
+namespace wal {
+
+// HardStateFile keeps the latest HardState of a log in two fixed-size slots, the files
+// HARDSTATE.0 and HARDSTATE.1 in the log directory, which are overwritten in turn.
+// A slot is: Fixed64 sequence, Fixed64 term, Fixed64 vote, Fixed64 commit, Fixed32
+// crc32c of them. A crash while a slot is written leaves it with a bad checksum, the
+// other slot still has the previous hard state then.
+//
+// Not Thread-Safe
+class HardStateFile {
+ public:
+  HardStateFile(Env* env, const std::string& dir)
+      : env_(env), dir_(dir), seq_(0), slotSynced_{false, false} {}
+
+  // Reads the slots, `*hs` is set to the newest intact one.
+  // Returns NotFound if neither slot is intact.
+  Status Load(yaraft::pb::HardState* hs);
+
+  // Overwrites the older slot with `hs`, and syncs it. The log directory is synced as
+  // well the first time a slot file is created.
+  Status Save(const yaraft::pb::HardState& hs);
+
+ private:
+  std::string slotName(uint64_t seq) const;
+
+  // Returns NotFound if the slot is missing or torn.
+  Status readSlot(int slot, uint64_t* seq, yaraft::pb::HardState* hs);
+
+ private:
+  Env* env_;
+  const std::string dir_;
+
+  // sequence of the last slot written.
+  uint64_t seq_;
+
+  // whether the slot file is known to be durable in the directory.
+  bool slotSynced_[2];
+};
+
+}  // namespace wal
+}  // namespace consensus
@@ -0,0 +1,95 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/testing.h"
+#include "wal/hard_state_file.h"
+
+namespace consensus {
+namespace wal {
+
+static yaraft::pb::HardState makeHardState(uint64_t term, uint64_t vote, uint64_t commit) {
+  yaraft::pb::HardState hs;
+  hs.set_term(term);
+  hs.set_vote(vote);
+  hs.set_commit(commit);
+  return hs;
+}
+
+// This test verifies that the hard state saved last is loaded, and the previous one
+// is loaded if the last slot is torn.
+TEST(HardStateFileTest, SaveAndLoad) {
+  Env* env = Env::Memory();
+  const std::string kDir = "/consensus-test-hard-state-file";
+  ASSERT_OK(env->CreateDirIfMissing(kDir));
+
+  yaraft::pb::HardState hs;
+  HardStateFile file(env, kDir);
+  ASSERT_EQ(file.Load(&hs).Code(), Error::NotFound);
+
+  for (uint64_t term = 1; term <= 3; term++) {
+    ASSERT_OK(file.Save(makeHardState(term, 1, term * 10)));
+  }
+
+  HardStateFile reopened(env, kDir);
+  ASSERT_OK(reopened.Load(&hs));
+  ASSERT_EQ(hs.term(), 3);
+  ASSERT_EQ(hs.vote(), 1);
+  ASSERT_EQ(hs.commit(), 30);
+
+  // the third save went to slot 1, after slots 1 and 0.
+  WritableFile* wf;
+  ASSIGN_IF_ASSERT_OK(env->NewWritableFile(kDir + "/HARDSTATE.1"), wf);
+  std::unique_ptr<WritableFile> f(wf);
+  ASSERT_OK(f->Append(std::string(36, 'x')));
+  ASSERT_OK(f->Close());
+
+  HardStateFile torn(env, kDir);
+  ASSERT_OK(torn.Load(&hs));
+  ASSERT_EQ(hs.term(), 2);
+
+  // the torn slot is overwritten by the next save.
+  ASSERT_OK(torn.Save(makeHardState(4, 2, 40)));
+  HardStateFile last(env, kDir);
+  ASSERT_OK(last.Load(&hs));
+  ASSERT_EQ(hs.term(), 4);
+  ASSERT_EQ(hs.vote(), 2);
+
+  ASSERT_OK(env->DeleteRecursively(kDir));
+}
+
+class HardStateFileDiskTest : public BaseTest {};
+
+// This test verifies that the slots are created and synced in a real directory, and that
+// syncing a missing directory fails.
+TEST_F(HardStateFileDiskTest, SaveOnDisk) {
+  std::unique_ptr<TestDirectoryHelper> guard(CreateTestDirGuard());
+
+  HardStateFile file(Env::Default(), GetTestDir());
+  ASSERT_OK(file.Save(makeHardState(1, 1, 10)));
+  ASSERT_OK(file.Save(makeHardState(2, 1, 20)));
+  ASSERT_OK(file.Save(makeHardState(3, 2, 30)));
+
+  yaraft::pb::HardState hs;
+  HardStateFile reopened(Env::Default(), GetTestDir());
+  ASSERT_OK(reopened.Load(&hs));
+  ASSERT_EQ(hs.term(), 3);
+  ASSERT_EQ(hs.vote(), 2);
+
+  HardStateFile missing(Env::Default(), GetTestDir() + "/missing");
+  ASSERT_FALSE(missing.Save(makeHardState(1, 1, 10)).IsOK());
+  ASSERT_FALSE(Env::Default()->SyncDir(GetTestDir() + "/missing").IsOK());
+}
+
+}  // namespace wal
+}  // namespace consensus
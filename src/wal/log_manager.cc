@@ -13,10 +13,22 @@
 // limitations under the License.
 
 #include "wal/log_manager.h"
+#include "base/coding.h"
+#include "base/crc32c.h"
+#include "base/env.h"
+#include "base/env_util.h"
 #include "base/logging.h"
+#include "base/metrics.h"
+#include "wal/block_cache.h"
 #include "wal/log_writer.h"
 #include "wal/readable_log_segment.h"
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iterator>
+#include <limits>
+
 namespace consensus {
 namespace wal {
 
@@ -30,41 +42,226 @@ static void parseWalName(const std::string& fname, uint64_t* segId, uint64_t* se
   sscanf(fname.c_str(), "%zu-%zu.wal", segId, segStart);
 }
 
+static bool isPooledSegment(const std::string& fname) {
+  size_t len = fname.length();
+  return len > 5 && fname.substr(len - 5, 5) == ".pool";
+}
+
+// The compaction meta is: Fixed64 index, Fixed64 term, Fixed32 crc32c of them.
+constexpr static size_t kCompactionMetaSize = 8 + 8 + 4;
+
+// Replace the file in log_dir with `data` atomically.
+static Status replaceFile(const WriteAheadLogOptions& options, const Slice& name,
+                          const Slice& data) {
+  return env_util::ReplaceFile(options.env, options.log_dir + "/" + name.ToString(), data);
+}
+
+static Status writeCompactionMeta(const WriteAheadLogOptions& options, uint64_t index,
+                                  uint64_t term) {
+  std::string buf;
+  PutFixed64(&buf, index);
+  PutFixed64(&buf, term);
+  PutFixed32(&buf, crc32c::Value(buf.data(), buf.size()));
+  return replaceFile(options, kCompactionMetaFileName, buf);
+}
+
+// Returns NotFound if no segment has been compacted.
+static Status readCompactionMeta(const WriteAheadLogOptions& options, uint64_t* index,
+                                 uint64_t* term) {
+  std::string fname = options.log_dir + "/" + kCompactionMetaFileName.ToString();
+  if (!options.env->GetFileSize(fname).IsOK()) {
+    return Status::Make(Error::NotFound);
+  }
+
+  RandomAccessFile* rf;
+  ASSIGN_IF_OK(options.env->NewRandomAccessFile(fname), rf);
+  std::unique_ptr<RandomAccessFile> f(rf);
+
+  char buf[kCompactionMetaSize];
+  Slice s;
+  RETURN_NOT_OK(env_util::ReadFully(rf, 0, kCompactionMetaSize, &s, buf));
+  if (crc32c::Value(buf, 16) != DecodeFixed32(buf + 16)) {
+    return FMT_Status(Corruption, "bad checksum of {}", fname);
+  }
+  *index = DecodeFixed64(buf);
+  *term = DecodeFixed64(buf + 8);
+  return Status::OK();
+}
+
+// Returns NotFound if the manifest has not been written.
+static Status readManifest(const WriteAheadLogOptions& options, LogManifest* manifest) {
+  std::string fname = options.log_dir + "/" + kManifestFileName.ToString();
+  if (!options.env->GetFileSize(fname).IsOK()) {
+    return Status::Make(Error::NotFound);
+  }
+
+  RandomAccessFile* rf;
+  ASSIGN_IF_OK(options.env->NewRandomAccessFile(fname), rf);
+  std::unique_ptr<RandomAccessFile> f(rf);
+
+  uint64_t fsize;
+  ASSIGN_IF_OK(f->Size(), fsize);
+  std::unique_ptr<char[]> buf(new char[fsize]);
+  Slice data;
+  RETURN_NOT_OK(env_util::ReadFully(rf, 0, fsize, &data, buf.get()));
+  RETURN_NOT_OK_APPEND(manifest->DecodeFrom(data, options.log_dir),
+                       fmt::format(" [manifest: {}]", fname));
+  return Status::OK();
+}
+
+// Cuts the torn batch off the segment, so that it won't be mistaken for corruption once
+// the segment is followed by newer ones.
+static Status truncateTornTail(Env* env, const SegmentContent& content) {
+  const std::string& fname = content.meta.fileName;
+  FMT_LOG(WARNING, "truncating segment {} to {} bytes, after its last complete batch", fname,
+          content.validSize);
+  WritableFile* wf;
+  ASSIGN_IF_OK(env->NewWritableFile(fname, Env::OPEN_EXISTING), wf);
+  std::unique_ptr<WritableFile> f(wf);
+  RETURN_NOT_OK(f->Truncate(content.validSize));
+  RETURN_NOT_OK(f->Sync());
+  return f->Close();
+}
+
+// Append the decoded segment to the entries recovered from the previous segments,
+// the overlapped entries are overwritten.
+static Status spliceIntoMemStore(SegmentContent* content, yaraft::MemoryStorage* memstore) {
+  yaraft::EntryVec& entries = content->entries;
+  if (!entries.empty()) {
+    const yaraft::pb::Entry& first = entries.front();
+    const yaraft::pb::Entry& last = memstore->TEST_Entries().back();
+    if (UNLIKELY(first.index() > last.index() + 1)) {
+      return FMT_Status(Corruption, "segment {} starts at {}, but the log ends at {}",
+                        content->meta.fileName, first.index(), last.index());
+    }
+    if (UNLIKELY(first.term() < last.term())) {
+      return FMT_Status(Corruption,
+                        "segment {} starts with [index:{}, term:{}], which has lower term than "
+                        "last entry [index:{}, term:{}]",
+                        content->meta.fileName, first.index(), first.term(), last.index(),
+                        last.term());
+    }
+    memstore->Append(std::move(entries));
+  }
+  if (content->meta.hasHardState) {
+    memstore->SetHardState(std::move(content->hs));
+  }
+  return Status::OK();
+}
+
+// A segment whose entries are all compacted is left behind if the log crashed, or
+// failed to delete it, after the compaction point was persisted, see deleteSegments.
+static bool compactedAway(const SegmentMetaData& meta, uint64_t compactIndex) {
+  return meta.numEntries > 0 && meta.lastIndex <= compactIndex;
+}
+
+// Drop the entries up to the compaction point, which the memstore starts after.
+static void dropCompactedEntries(SegmentContent* content, uint64_t compactIndex) {
+  yaraft::EntryVec& entries = content->entries;
+  auto it = std::find_if(
+      entries.begin(), entries.end(),
+      [compactIndex](const yaraft::pb::Entry& e) { return e.index() > compactIndex; });
+  entries.erase(entries.begin(), it);
+}
+
+// The compacted segments are deleted once the manifest no longer refers to them.
+static void deleteCompactedSegments(Env* env, const std::vector<std::string>& fnames) {
+  for (const auto& f : fnames) {
+    FMT_LOG(INFO, "deleting compacted segment {} left behind", f);
+    WARN_NOT_OK(env->DeleteFile(f), "LogManager::Recover");
+  }
+}
+
+// Append the entries into memstore in runs, each of which has increasing indexes and
+// non-decreasing terms, so that the conflicting entries in memstore are truncated
+// only once for a run, at the point found by binary search.
+// The entries are moved into memstore if `Iter` is a move iterator.
 // Returns: Error::YARaftError / OK
-Status AppendToMemStore(yaraft::pb::Entry& e, yaraft::MemoryStorage* memstore) {
+template <typename Iter>
+static Status appendRunsToMemStore(Iter first, Iter last, yaraft::MemoryStorage* memstore) {
   auto& vec = memstore->TEST_Entries();
+  Iter begin = first;
+  while (begin != last) {
+    Iter end = std::next(begin);
+    while (end != last && end->index() > std::prev(end)->index() &&
+           end->term() >= std::prev(end)->term()) {
+      end++;
+    }
 
-  if (!vec.empty()) {
-    if (e.term() < vec.rbegin()->term()) {
+    if (begin->term() < vec.back().term()) {
       return FMT_Status(
           YARaftError,
           "new entry [index:{}, term:{}] has lower term than last entry [index:{}, term:{}]",
-          e.index(), e.term(), vec.rbegin()->index(), vec.rbegin()->term());
+          begin->index(), begin->term(), vec.back().index(), vec.back().term());
     }
 
-    int del = vec.size() - 1;
-    while (del >= 0) {
-      if (vec[del].index() < e.index()) {
-        break;
-      }
-      del--;
-    }
+    // the first entry of memstore is the dummy one at the compacted index, the entries
+    // no later than which are skipped.
+    uint64_t compacted = vec.front().index();
+    begin = std::find_if(begin, end,
+                         [&](const yaraft::pb::Entry& e) { return e.index() > compacted; });
+    if (begin != end) {
+      auto it = std::lower_bound(
+          std::next(vec.begin()), vec.end(), begin->index(),
+          [](const yaraft::pb::Entry& x, uint64_t idx) { return x.index() < idx; });
+      vec.erase(it, vec.end());
 
-    size_t sz = vec.size();
-    for (int i = del + 1; i < sz; i++) {
-      vec.pop_back();
+      vec.reserve(vec.size() + std::distance(begin, end));
+      vec.insert(vec.end(), begin, end);
     }
+    begin = end;
   }
-
-  memstore->Append(e);
   return Status::OK();
 }
 
+Status AppendToMemStore(const yaraft::EntryVec& vec, yaraft::MemoryStorage* memstore) {
+  return appendRunsToMemStore(vec.begin(), vec.end(), memstore);
+}
+
+Status AppendToMemStore(yaraft::EntryVec&& vec, yaraft::MemoryStorage* memstore) {
+  return appendRunsToMemStore(std::make_move_iterator(vec.begin()),
+                              std::make_move_iterator(vec.end()), memstore);
+}
+
+Status AppendToMemStore(const yaraft::pb::Entry& e, yaraft::MemoryStorage* memstore) {
+  return AppendToMemStore(yaraft::EntryVec{e}, memstore);
+}
+
 //////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
 
 LogManager::LogManager(const WriteAheadLogOptions& options)
-    : lastIndex_(0), options_(options), empty_(false) {}
+    : lastIndex_(0),
+      nextSegId_(1),
+      options_(options),
+      empty_(false),
+      lazilyRecovered_(false),
+      lazyCompactIndex_(0),
+      lazyCompactTerm_(0),
+      poolSeq_(0),
+      nextCacheId_(0),
+      hasHardState_(false),
+      hardStateFile_(options.env, options.log_dir),
+      unsyncedBytes_(0),
+      unflushedBytes_(0),
+      lastSync_(std::chrono::steady_clock::now()),
+      stopping_(false),
+      pendingRollovers_(0) {
+  logDirs_.push_back(options_.log_dir);
+  logDirs_.insert(logDirs_.end(), options_.extra_log_dirs.begin(), options_.extra_log_dirs.end());
+  if (options_.block_cache_size > 0) {
+    blockCache_.reset(new BlockCache(options_.block_cache_size));
+  }
+  if (options_.background_rollover) {
+    rolloverQueue_.reset(new TaskQueue);
+  }
+  if (poolCapacity() > 0) {
+    poolQueue_.reset(new TaskQueue);
+  }
+  if (options_.background_sync) {
+    syncThread_ = std::thread(&LogManager::syncLoop, this);
+  }
+}
 
 LogManager::~LogManager() {
   Close();
@@ -72,50 +269,530 @@ LogManager::~LogManager() {
 
 Status LogManager::Recover(const WriteAheadLogOptions& options, yaraft::MemStoreUptr* memstore,
                            LogManagerUPtr* pLogManager) {
-  RETURN_NOT_OK_APPEND(Env::Default()->CreateDirIfMissing(options.log_dir),
+  RETURN_NOT_OK_APPEND(options.env->CreateDirIfMissing(options.log_dir),
                        fmt::format(" [log_dir: \"{}\"]", options.log_dir));
+  for (const auto& dir : options.extra_log_dirs) {
+    RETURN_NOT_OK_APPEND(options.env->CreateDirIfMissing(dir),
+                         fmt::format(" [extra_log_dir: \"{}\"]", dir));
+  }
 
-  std::vector<std::string> files;
-  RETURN_NOT_OK_APPEND(Env::Default()->GetChildren(options.log_dir, &files),
-                       fmt::format(" [log_dir: \"{}\"]", options.log_dir));
+  LogManagerUPtr& m = *pLogManager;
+  m.reset(new LogManager(options));
 
-  // finds all files with suffix ".wal"
-  std::map<uint64_t, uint64_t> wals;  // ordered by segId
-  for (const auto& f : files) {
-    if (isWal(f)) {
-      uint64_t segId, segStart;
-      parseWalName(f, &segId, &segStart);
-      wals[segId] = segStart;
+  // the log directory is scanned only if the manifest is not available.
+  std::vector<SegmentMetaData> segments;
+  LogManifest manifest;
+  Status s = readManifest(options, &manifest);
+  bool fromManifest = s.IsOK();
+  if (fromManifest) {
+    RETURN_NOT_OK(m->recoverFromManifest(manifest, &segments));
+  } else {
+    if (s.Code() != Error::NotFound) {
+      FMT_LOG(WARNING, "unable to read manifest: {}, scanning the log directory instead",
+              s.ToString());
     }
+    RETURN_NOT_OK(m->recoverFromLogDir(&segments));
   }
+  RETURN_NOT_OK(m->fillSegmentPool());
 
-  LogManagerUPtr& m = *pLogManager;
-  m.reset(new LogManager(options));
-  if (wals.empty()) {
+  uint64_t compactIndex = 0, compactTerm = 0;
+  s = readCompactionMeta(options, &compactIndex, &compactTerm);
+  bool compacted = s.IsOK();
+  if (!compacted && s.Code() != Error::NotFound) {
+    return s;
+  }
+
+  yaraft::pb::HardState savedHs;
+  s = m->hardStateFile_.Load(&savedHs);
+  bool hasSavedHs = s.IsOK();
+  if (!hasSavedHs && s.Code() != Error::NotFound) {
+    return s;
+  }
+
+  if (segments.empty() && !compacted && !hasSavedHs) {
     return Status::OK();
   }
-  m->empty_ = false;
+
+  // the segments are only trusted to be left unread if they're listed in the manifest.
+  uint64_t startIndex = 0, startTerm = 0;
+  size_t lazy = 0;
+  if (fromManifest && options.lazy_recovery_entries > 0) {
+    lazy = m->leaveLazySegments(&segments, compactIndex, &startIndex, &startTerm);
+  }
 
   LOG_ASSERT(*memstore == nullptr);
   memstore->reset(new yaraft::MemoryStorage);
+  if (lazy > 0) {
+    // the memstore starts after the entries left in the sealed segments.
+    yaraft::pb::Snapshot snap;
+    snap.mutable_metadata()->set_index(startIndex);
+    snap.mutable_metadata()->set_term(startTerm);
+    (*memstore)->ApplySnapshot(snap);
+    m->lastIndex_ = startIndex;
+    m->lazilyRecovered_ = true;
+    m->lazyCompactIndex_ = compactIndex;
+    m->lazyCompactTerm_ = compactTerm;
+    FMT_LOG(INFO, "leaving {} segments with the entries up to index: {} in the log", lazy,
+            startIndex);
+  } else if (compacted) {
+    // the log starts after the compacted entries.
+    yaraft::pb::Snapshot snap;
+    snap.mutable_metadata()->set_index(compactIndex);
+    snap.mutable_metadata()->set_term(compactTerm);
+    (*memstore)->ApplySnapshot(snap);
+    m->lastIndex_ = compactIndex;
+    FMT_LOG(INFO, "log is compacted up to index: {}, term: {}", compactIndex, compactTerm);
+  }
+  if (m->hasHardState_) {
+    // overwritten by the hard states in the segments, if there're any.
+    (*memstore)->SetHardState(m->hardState_);
+  }
+  if (segments.empty()) {
+    if (hasSavedHs) {
+      m->mergeHardState(savedHs, memstore->get());
+    }
+    return m->writeManifest();
+  }
+  m->empty_ = false;
 
-  FMT_LOG(INFO, "recovering from {} wals, starts from {}-{}, ends at {}-{}", wals.size(),
-          wals.begin()->first, wals.begin()->second, wals.rbegin()->first, wals.rbegin()->second);
+  FMT_LOG(INFO, "recovering from {} wals, starts from {}, ends at {}", segments.size(),
+          segments.front().fileName, segments.back().fileName);
+
+  // Segments are read and decoded concurrently by the recovery threads, and
+  // spliced into the memstore in order as soon as each one is decoded.
+  size_t n = segments.size();
+  std::vector<SegmentContent> contents(n);
+  std::vector<Status> statuses(n);
+  std::vector<bool> decoded(n, false);
+  std::mutex mu;
+  std::condition_variable cv;
+  std::atomic<size_t> next(0);
+  std::atomic<bool> failed(false);
+  s = Status::OK();
+
+  // The segments after the last sealed one may still have their preallocated space,
+  // since a rolled-over segment is sealed in background. Whether the segments found
+  // by scanning the log directory are sealed is only known from their footers.
+  size_t unsealedFrom = n;
+  while (unsealedFrom > 0 && !segments[unsealedFrom - 1].sealed) {
+    unsealedFrom--;
+  }
+
+  auto decode = [&]() {
+    size_t i;
+    while (!failed && (i = next++) < n) {
+      // the sealed segments are trusted if they are not modified since sealed. Only the
+      // newest segment may end in a batch torn by a crash, which is dropped.
+      const SegmentMetaData& seg = segments[i];
+      SegmentContent c;
+      Status st = ReadSegment(options.env, seg.fileName, &c, options.verify_checksum,
+                              seg.sealed ? &seg.checksum : nullptr, i == n - 1 && !seg.sealed,
+                              i >= unsealedFrom);
+      if (st.IsOK() && c.torn) {
+        st = truncateTornTail(options.env, c);
+      }
+      if (!st.IsOK()) {
+        failed = true;
+      }
+
+      std::lock_guard<std::mutex> g(mu);
+      contents[i] = std::move(c);
+      statuses[i] = st;
+      decoded[i] = true;
+      cv.notify_all();
+    }
+  };
+  std::vector<std::thread> threads;
+  size_t threadsNum = std::min(std::max<size_t>(options.recovery_threads, 1), n);
+  for (size_t i = 0; i < threadsNum; i++) {
+    threads.emplace_back(decode);
+  }
+
+  bool reload = false;
+  std::vector<std::string> compactedSegs;
+  for (size_t i = 0; i < n && s.IsOK(); i++) {
+    SegmentContent c;
+    {
+      std::unique_lock<std::mutex> lock(mu);
+      cv.wait(lock, [&]() { return decoded[i]; });
+      s = statuses[i];
+      c = std::move(contents[i]);
+    }
+    if (s.IsOK() && lazy > 0 && c.meta.numEntries > 0 && c.meta.firstIndex <= startIndex) {
+      // an unsealed segment overwrites the entries left, which are stale then.
+      reload = true;
+      break;
+    }
+    if (s.IsOK() && c.meta.hasHardState) {
+      m->hasHardState_ = true;
+      m->hardState_ = c.hs;
+    }
+    if (s.IsOK() && compacted && compactedAway(c.meta, compactIndex)) {
+      compactedSegs.push_back(c.meta.fileName);
+      continue;
+    }
+    if (s.IsOK()) {
+      if (compacted) {
+        dropCompactedEntries(&c, compactIndex);
+      }
+      s = spliceIntoMemStore(&c, memstore->get());
+    }
+    if (s.IsOK()) {
+      m->files_.push_back(std::move(c.meta));
+    }
+  }
+  failed = true;
+  for (auto& t : threads) {
+    t.join();
+  }
+  RETURN_NOT_OK(s);
+
+  if (reload) {
+    FMT_LOG(WARNING, "entry {} left in the log is overwritten, loading the whole log",
+            startIndex);
+    WriteAheadLogOptions full = options;
+    full.lazy_recovery_entries = 0;
+    memstore->reset();
+    return Recover(full, memstore, pLogManager);
+  }
+
+  if (hasSavedHs) {
+    m->mergeHardState(savedHs, memstore->get());
+  }
+  m->lastIndex_ = (*memstore)->LastIndex();
+  RETURN_NOT_OK(m->writeManifest());
+  deleteCompactedSegments(options.env, compactedSegs);
+  return Status::OK();
+}
+
+void LogManager::mergeHardState(const yaraft::pb::HardState& saved,
+                                yaraft::MemoryStorage* memstore) {
+  // The term and vote are taken from the newer one. The vote is cast only once in a
+  // term, so of the same term, the one with a vote is newer.
+  yaraft::pb::HardState hs = hardState_;
+  if (!hasHardState_ || saved.term() > hs.term() || (saved.term() == hs.term() && hs.vote() == 0)) {
+    hs.set_term(saved.term());
+    hs.set_vote(saved.vote());
+  }
+  // the commit index saved may be ahead of the log, which was not synced.
+  uint64_t commit = std::max(hs.commit(), saved.commit());
+  hs.set_commit(std::min(commit, memstore->LastIndex()));
+
+  hardState_ = hs;
+  hasHardState_ = true;
+  memstore->SetHardState(hs);
+}
+
+Status LogManager::recoverFromManifest(const LogManifest& manifest,
+                                       std::vector<SegmentMetaData>* segments) {
+  // The manifest names the files relative to log_dir, a striped log finds them in
+  // any of its directories.
+  std::map<std::string, std::string> paths;
+  if (logDirs_.size() > 1) {
+    RETURN_NOT_OK(listLogDirs(&paths));
+  }
+  auto locate = [&](const std::string& fname) -> std::string {
+    auto it = paths.find(fname.substr(fname.rfind('/') + 1));
+    return it == paths.end() ? fname : it->second;
+  };
+
+  *segments = manifest.segments;
+  for (auto& seg : *segments) {
+    seg.fileName = locate(seg.fileName);
+  }
+  nextSegId_ = manifest.nextSegId;
+  hasHardState_ = manifest.hasHardState;
+  hardState_ = manifest.hardState;
+
+  // The pooled segments created after the manifest was written are found by
+  // probing the sequences following the ones recorded.
+  poolSeq_ = manifest.nextPoolSeq;
+  for (const auto& fname : manifest.pool) {
+    RETURN_NOT_OK(recoverPooledSegment(locate(fname)));
+  }
+  while (true) {
+    std::string fname = locate(stripeDir(poolSeq_) + "/" + PooledSegmentFileName(poolSeq_));
+    if (!options_.env->GetFileSize(fname).IsOK()) {
+      break;
+    }
+    poolSeq_++;
+    RETURN_NOT_OK(recoverPooledSegment(fname));
+  }
+  return Status::OK();
+}
+
+size_t LogManager::leaveLazySegments(std::vector<SegmentMetaData>* segments,
+                                     uint64_t compactIndex, uint64_t* startIndex,
+                                     uint64_t* startTerm) {
+  std::vector<SegmentMetaData>& segs = *segments;
+
+  // Counting back from the newest segment, the first one loaded is the sealed one
+  // where the tail holds enough entries, and none of the following sealed segments
+  // overwrites the entries before it.
+  uint64_t count = 0;
+  uint64_t minFirst = std::numeric_limits<uint64_t>::max();
+  size_t k = segs.size();
+  for (; k > 0; k--) {
+    const SegmentMetaData& seg = segs[k - 1];
+    if (!seg.sealed || seg.numEntries == 0) {
+      continue;
+    }
+    count += seg.numEntries;
+    if (count >= options_.lazy_recovery_entries && seg.firstIndex <= minFirst) {
+      break;
+    }
+    minFirst = std::min(minFirst, seg.firstIndex);
+  }
+  if (k <= 1) {
+    return 0;
+  }
+
+  // the segments left must be sealed to be read by ReadEntries.
+  size_t n = k - 1;
+  uint64_t start = segs[n].firstIndex - 1;
+  if (start <= compactIndex) {
+    return 0;
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (!segs[i].sealed) {
+      return 0;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> g(filesMu_);
+    files_.assign(segs.begin(), segs.begin() + n);
+  }
+  PBEntryVec entries;
+  Status s = ReadEntries(start, start + 1, 0, &entries);
+  if (!s.IsOK()) {
+    FMT_LOG(WARNING, "unable to read entry {} from the sealed segments: {}, loading the whole log",
+            start, s.ToString());
+    std::lock_guard<std::mutex> g(filesMu_);
+    files_.clear();
+    return 0;
+  }
+  *startIndex = start;
+  *startTerm = entries[0].term();
+  segs.erase(segs.begin(), segs.begin() + n);
+  return n;
+}
+
+Status LogManager::listLogDirs(std::map<std::string, std::string>* paths) {
+  for (const auto& dir : logDirs_) {
+    std::vector<std::string> files;
+    RETURN_NOT_OK_APPEND(options_.env->GetChildren(dir, &files),
+                         fmt::format(" [log_dir: \"{}\"]", dir));
+    for (const auto& f : files) {
+      (*paths)[f] = dir + "/" + f;
+    }
+  }
+  return Status::OK();
+}
+
+Status LogManager::recoverFromLogDir(std::vector<SegmentMetaData>* segments) {
+  std::map<std::string, std::string> paths;
+  RETURN_NOT_OK(listLogDirs(&paths));
+
+  // finds all files with suffix ".wal", in all of the striped directories.
+  std::map<uint64_t, std::string> wals;  // ordered by segId
+  for (const auto& p : paths) {
+    const std::string& f = p.first;
+    if (isWal(f)) {
+      uint64_t segId, segStart;
+      parseWalName(f, &segId, &segStart);
+      wals[segId] = p.second;
+    } else if (isPooledSegment(f)) {
+      uint64_t seq = std::stoull(f);
+      poolSeq_ = std::max(poolSeq_, seq + 1);
+      RETURN_NOT_OK(recoverPooledSegment(p.second));
+    }
+  }
 
   for (auto it = wals.begin(); it != wals.end(); it++) {
-    std::string fname = options.log_dir + "/" + SegmentFileName(it->first, it->second);
-    SegmentMetaData meta;
-    RETURN_NOT_OK(
-        ReadSegmentIntoMemoryStorage(fname, memstore->get(), &meta, options.verify_checksum));
-    m->files_.push_back(std::move(meta));
+    SegmentMetaData seg;
+    seg.fileName = it->second;
+    segments->push_back(std::move(seg));
+  }
+  if (!wals.empty()) {
+    nextSegId_ = wals.rbegin()->first + 1;
   }
   return Status::OK();
 }
 
+Status LogManager::recoverPooledSegment(const std::string& fname) {
+  // segments that were not completely created are discarded.
+  auto size = options_.env->GetFileSize(fname);
+  if (!size.IsOK()) {
+    // taken by a new segment after the manifest was written.
+    return Status::OK();
+  }
+  if (size.GetValue() == options_.log_segment_size &&
+      segmentPool_.size() < poolCapacity()) {
+    segmentPool_.push_back(fname);
+    return Status::OK();
+  }
+  return options_.env->DeleteFile(fname);
+}
+
+struct LogManager::Writer {
+  Writer(const PBEntryVec& e, const yaraft::pb::HardState* h) : entries(e), hs(h), done(false) {}
+
+  const PBEntryVec& entries;
+  const yaraft::pb::HardState* hs;
+
+  Status status;
+  bool done;
+  std::condition_variable cv;
+};
+
 Status LogManager::Write(const PBEntryVec& entries, const yaraft::pb::HardState* hs) {
-  if (entries.empty()) {
+  if (options_.background_sync) {
+    std::promise<Status> synced;
+    RETURN_NOT_OK(AsyncWrite(entries, hs, [&synced](const Status& s) { synced.set_value(s); }));
+    return synced.get_future().get();
+  }
+  if (options_.group_commit) {
+    return groupCommit(entries, hs);
+  }
+  RETURN_NOT_OK(appendBatch(entries, hs));
+  return syncByPolicy();
+}
+
+Status LogManager::AsyncWrite(const PBEntryVec& entries, const yaraft::pb::HardState* hs,
+                              WriteCallback callback) {
+  if (!options_.background_sync) {
+    return WriteAheadLog::AsyncWrite(entries, hs, std::move(callback));
+  }
+
+  std::lock_guard<std::mutex> g(mu_);
+  RETURN_NOT_OK(appendBatch(entries, hs));
+  pendingCallbacks_.push_back(std::move(callback));
+  syncCv_.notify_one();
+  return Status::OK();
+}
+
+void LogManager::syncLoop() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    syncCv_.wait(lock, [this]() { return stopping_ || !pendingCallbacks_.empty(); });
+    if (stopping_ && pendingCallbacks_.empty()) {
+      break;
+    }
+
+    std::vector<WriteCallback> callbacks;
+    callbacks.swap(pendingCallbacks_);
+    std::vector<std::unique_ptr<LogWriter>> retired;
+    retired.swap(retiredWriters_);
+
+    // The current writer stays alive until this round ends, since it could only be
+    // moved to retiredWriters_, which is taken by the sync thread in the next round.
+    LogWriter* current = current_.get();
+    lock.unlock();
+
+    Status s = finishRetiredWriters(&retired);
+    if (s.IsOK()) {
+      s = waitForRollover();
+    }
+    if (s.IsOK() && current) {
+      s = current->Sync();
+    }
+    for (auto& cb : callbacks) {
+      cb(s);
+    }
+
+    lock.lock();
+  }
+
+  WARN_NOT_OK(finishRetiredWriters(&retiredWriters_), "LogManager::finishRetiredWriters");
+  retiredWriters_.clear();
+}
+
+Status LogManager::finishRetiredWriters(std::vector<std::unique_ptr<LogWriter>>* retired) {
+  if (retired->empty()) {
     return Status::OK();
   }
+  for (auto& w : *retired) {
+    SegmentMetaData meta;
+    RETURN_NOT_OK(w->Finish(&meta));
+
+    // the segment may have been removed by GC.
+    std::lock_guard<std::mutex> g(filesMu_);
+    for (auto& f : files_) {
+      if (f.fileName == meta.fileName) {
+        f = meta;
+        break;
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> g(manifestMu_);
+  return persistManifest();
+}
+
+void LogManager::stopSyncThread() {
+  if (!syncThread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> g(mu_);
+    stopping_ = true;
+    syncCv_.notify_one();
+  }
+  syncThread_.join();
+}
+
+Status LogManager::groupCommit(const PBEntryVec& entries, const yaraft::pb::HardState* hs) {
+  Writer w(entries, hs);
+
+  std::unique_lock<std::mutex> lock(mu_);
+  writers_.push_back(&w);
+  while (!w.done && &w != writers_.front()) {
+    w.cv.wait(lock);
+  }
+  if (w.done) {
+    // committed by another writer
+    return w.status;
+  }
+
+  // The front writer leads this round, it commits all the writes queued up so far
+  // with at most one sync. New writers will be blocked until this round completes.
+  std::vector<Writer*> group(writers_.begin(), writers_.end());
+  lock.unlock();
+
+  Status s;
+  for (Writer* x : group) {
+    s = appendBatch(x->entries, x->hs);
+    if (!s.IsOK()) {
+      break;
+    }
+  }
+  if (s.IsOK()) {
+    s = syncByPolicy();
+  }
+
+  lock.lock();
+  for (Writer* x : group) {
+    DCHECK(x == writers_.front());
+    writers_.pop_front();
+    x->status = s;
+    x->done = true;
+    if (x != &w) {
+      x->cv.notify_one();
+    }
+  }
+
+  // wake up the leader of the next round
+  if (!writers_.empty()) {
+    writers_.front()->cv.notify_one();
+  }
+  return w.status;
+}
+
+Status LogManager::appendBatch(const PBEntryVec& entries, const yaraft::pb::HardState* hs) {
+  if (entries.empty()) {
+    return hs ? writeHardState(*hs) : Status::OK();
+  }
 
   uint64_t beginIdx = entries.begin()->index();
   if (empty_) {
@@ -126,6 +803,19 @@ Status LogManager::Write(const PBEntryVec& entries, const yaraft::pb::HardState*
   return doWrite(entries.begin(), entries.end(), hs);
 }
 
+Status LogManager::writeHardState(const yaraft::pb::HardState& hs) {
+  Metrics& metrics = Metrics::Instance();
+  if (hasHardState_ && hs.term() == hardState_.term() && hs.vote() == hardState_.vote()) {
+    metrics.walHardStateSkips << 1;
+  } else {
+    RETURN_NOT_OK(hardStateFile_.Save(hs));
+    metrics.walHardStateWrites << 1;
+  }
+  hardState_ = hs;
+  hasHardState_ = true;
+  return Status::OK();
+}
+
 // Required: begin != end
 Status LogManager::doWrite(ConstPBEntriesIterator begin, ConstPBEntriesIterator end,
                            const yaraft::pb::HardState* hs) {
@@ -136,16 +826,41 @@ Status LogManager::doWrite(ConstPBEntriesIterator begin, ConstPBEntriesIterator
       LogWriter* w;
       ASSIGN_IF_OK(LogWriter::New(this), w);
       current_.reset(w);
+      refillSegmentPool();
+
+      if (rolloverQueue_) {
+        // the new segment is recorded before the data written into it is synced.
+        SegmentMetaData tail = current_->Meta();
+        uint64_t nextSegId = nextSegId_;
+        bool hasHardState = hasHardState_;
+        yaraft::pb::HardState hardState = hardState_;
+        submitRollover([this, tail, nextSegId, hasHardState, hardState]() {
+          return writeManifest(&tail, nextSegId, hasHardState, hardState);
+        });
+      } else {
+        // the new segment is recorded before anything is written into it.
+        RETURN_NOT_OK(writeManifest());
+      }
     }
 
+    // the segment may shrink if its tail is rewritten, see rewrite_tail_on_conflict.
+    uint64_t writtenBefore = current_->BytesWritten();
     ASSIGN_IF_OK(current_->Append(segStart, end, hs), it);
+    unsyncedBytes_ += current_->BytesWritten() - writtenBefore;
+    unflushedBytes_ += current_->BytesWritten() - writtenBefore;
     if (it == end) {
       // write complete
+      if (hs) {
+        hardState_ = *hs;
+        hasHardState_ = true;
+      }
       break;
     }
 
     // hard state must have been written after a batch write completes.
     if (hs) {
+      hardState_ = *hs;
+      hasHardState_ = true;
       hs = nullptr;
     }
 
@@ -158,28 +873,403 @@ Status LogManager::doWrite(ConstPBEntriesIterator begin, ConstPBEntriesIterator
   return Status::OK();
 }
 
+Status LogManager::ReadEntries(uint64_t lo, uint64_t hi, uint64_t maxBytes,
+                               PBEntryVec* entries) {
+  entries->clear();
+
+  std::vector<SegmentMetaData> segments;
+  {
+    std::lock_guard<std::mutex> g(filesMu_);
+    for (const auto& f : files_) {
+      if (f.numEntries > 0) {
+        segments.push_back(f);
+      }
+    }
+  }
+  if (!segments.empty() && lo < segments.front().firstIndex) {
+    return FMT_Status(LogCompacted, "entry {} has been compacted", lo);
+  }
+
+  uint64_t bytes = 0;
+  uint64_t next = lo;
+  while (next < hi && !segments.empty()) {
+    // the entry is in the last segment starting before it, the entries in the
+    // previous segments are overwritten.
+    size_t i = segments.size();
+    while (segments[i - 1].firstIndex > next) {
+      i--;
+    }
+    const SegmentMetaData& seg = segments[i - 1];
+    uint64_t end = std::min(hi, seg.lastIndex + 1);
+    for (size_t j = i; j < segments.size(); j++) {
+      end = std::min(end, segments[j].firstIndex);
+    }
+    if (next >= end || !seg.sealed) {
+      break;
+    }
+
+    std::shared_ptr<SealedSegmentReader> reader;
+    RETURN_NOT_OK(getReader(seg, &reader));
+    RETURN_NOT_OK(reader->Read(next, end, maxBytes, blockCache_.get(), entries, &bytes));
+    if (entries->empty() || entries->back().index() + 1 < end) {
+      // limited by maxBytes
+      break;
+    }
+    next = end;
+  }
+
+  if (entries->empty()) {
+    return FMT_Status(NotFound, "entry {} is not in the sealed segments", lo);
+  }
+  return Status::OK();
+}
+
+Status LogManager::getReader(const SegmentMetaData& meta,
+                             std::shared_ptr<SealedSegmentReader>* reader) {
+  std::lock_guard<std::mutex> g(readersMu_);
+  auto it = readers_.find(meta.fileName);
+  if (it != readers_.end()) {
+    readersLru_.splice(readersLru_.end(), readersLru_, it->second);
+    *reader = it->second->reader;
+    return Status::OK();
+  }
+
+  // the blocks cached under the id of a closed reader are left to be evicted.
+  SealedSegmentReader* r;
+  ASSIGN_IF_OK(SealedSegmentReader::Open(options_.env, meta, nextCacheId_++), r);
+  reader->reset(r);
+  readersLru_.push_back(CachedReader{meta.fileName, *reader});
+  readers_[meta.fileName] = std::prev(readersLru_.end());
+
+  // the readers in use keep their files open until they are released.
+  while (readersLru_.size() > std::max<size_t>(options_.max_open_segments, 1)) {
+    CachedReader& victim = readersLru_.front();
+    readers_.erase(victim.fileName);
+    readersLru_.pop_front();
+  }
+  return Status::OK();
+}
+
 Status LogManager::Sync() {
+  // the data in the segments being sealed is synced along with the current one.
+  RETURN_NOT_OK(waitForRollover());
   if (current_) {
-    return current_->Sync();
+    RETURN_NOT_OK(current_->Sync());
+  }
+  unsyncedBytes_ = 0;
+  unflushedBytes_ = 0;
+  lastSync_ = std::chrono::steady_clock::now();
+  return Status::OK();
+}
+
+Status LogManager::syncByPolicy() {
+  bool needSync = false;
+  switch (options_.sync_policy) {
+    case WriteAheadLogOptions::SYNC_EVERY_WRITE:
+      needSync = true;
+      break;
+    case WriteAheadLogOptions::SYNC_INTERVAL:
+      needSync = std::chrono::steady_clock::now() - lastSync_ >=
+                 std::chrono::milliseconds(options_.sync_interval_ms);
+      break;
+    case WriteAheadLogOptions::SYNC_BYTES:
+      needSync = unsyncedBytes_ >= options_.sync_bytes;
+      break;
+    case WriteAheadLogOptions::SYNC_NONE:
+      break;
+  }
+  if (needSync) {
+    return Sync();
+  }
+
+  // write back in advance to smooth out the next sync.
+  if (current_ && options_.bytes_per_flush > 0 && unflushedBytes_ >= options_.bytes_per_flush) {
+    unflushedBytes_ = 0;
+    return current_->Flush();
   }
   return Status::OK();
 }
 
 Status LogManager::Close() {
+  waitForGC();
+  stopSyncThread();
+  bool written = bool(current_);
   if (current_) {
     finishCurrentWriter();
   }
+  WARN_NOT_OK(waitForRollover(), "LogManager::waitForRollover");
+  waitForPool();
+  if (written) {
+    WARN_NOT_OK(writeManifest(), "LogManager::writeManifest");
+  }
+  return Status::OK();
+}
+
+Status CompactMemStore(const WriteAheadLog::CompactionHint& hint) {
+  yaraft::MemoryStorage* memstore = hint.memstore;
+  if (memstore) {
+    uint64_t compactIndex = std::min(hint.compactIndex, memstore->LastIndex());
+    if (compactIndex >= memstore->FirstIndex()) {
+      auto s = memstore->Compact(compactIndex);
+      if (!s.IsOK()) {
+        return Status::Make(Error::YARaftError, s.ToString());
+      }
+    }
+  }
   return Status::OK();
 }
 
 Status LogManager::GC(WriteAheadLog::CompactionHint* hint) {
+  RETURN_NOT_OK(CompactMemStore(*hint));
+
+  std::vector<SegmentMetaData> compacted;
+  {
+    std::lock_guard<std::mutex> g(filesMu_);
+
+    // the latest hard state must be kept, it's either in the current segment,
+    // or in the last sealed segment that has one.
+    size_t limit = files_.size();
+    for (size_t i = files_.size(); i > 0; i--) {
+      if (files_[i - 1].hasHardState) {
+        limit = i - 1;
+        break;
+      }
+    }
+
+    size_t n = 0;
+    while (n < limit && files_[n].lastIndex <= hint->compactIndex) {
+      n++;
+    }
+    if (n == 0) {
+      return Status::OK();
+    }
+    compacted.assign(files_.begin(), files_.begin() + n);
+    files_.erase(files_.begin(), files_.begin() + n);
+  }
+
+  // segments with no entries carry no log position.
+  uint64_t lastIndex = 0, lastTerm = 0;
+  for (const auto& f : compacted) {
+    if (f.numEntries > 0) {
+      lastIndex = f.lastIndex;
+      lastTerm = f.lastTerm;
+    }
+  }
+
+  if (!gcQueue_) {
+    gcQueue_.reset(new TaskQueue);
+  }
+  gcQueue_->Enqueue(
+      [this, compacted, lastIndex, lastTerm]() { deleteSegments(compacted, lastIndex, lastTerm); });
+  return Status::OK();
+}
+
+void LogManager::deleteSegments(const std::vector<SegmentMetaData>& segments, uint64_t lastIndex,
+                                uint64_t lastTerm) {
+  // the compaction point is persisted before the segments are deleted, otherwise
+  // the recovery couldn't tell where the log starts.
+  if (lastIndex > 0) {
+    Status s = writeCompactionMeta(options_, lastIndex, lastTerm);
+    if (!s.IsOK()) {
+      FMT_LOG(ERROR, "failed to persist compaction point {}: {}", lastIndex, s.ToString());
+      return;
+    }
+  }
+  {
+    // the segments must not be referenced by the manifest once deleted.
+    std::lock_guard<std::mutex> g(manifestMu_);
+    Status s = persistManifest();
+    if (!s.IsOK()) {
+      FMT_LOG(ERROR, "failed to persist manifest: {}", s.ToString());
+      return;
+    }
+  }
+  {
+    // the readers in use keep the files open until they are released.
+    std::lock_guard<std::mutex> g(readersMu_);
+    for (const auto& f : segments) {
+      auto it = readers_.find(f.fileName);
+      if (it != readers_.end()) {
+        readersLru_.erase(it->second);
+        readers_.erase(it);
+      }
+    }
+  }
+  for (const auto& f : segments) {
+    FMT_LOG(INFO, "deleting compacted segment {}", f.fileName);
+    WARN_NOT_OK(options_.env->DeleteFile(f.fileName), "LogManager::GC");
+  }
+}
+
+void LogManager::waitForGC() {
+  if (!gcQueue_) {
+    return;
+  }
+  std::promise<void> done;
+  gcQueue_->Enqueue([&done]() { done.set_value(); });
+  done.get_future().wait();
+}
+
+Status LogManager::writeManifest() {
+  std::unique_ptr<SegmentMetaData> tail(current_ ? new SegmentMetaData(current_->Meta()) : nullptr);
+  return writeManifest(tail.get(), nextSegId_, hasHardState_, hardState_);
+}
+
+Status LogManager::writeManifest(const SegmentMetaData* tail, uint64_t nextSegId,
+                                 bool hasHardState, const yaraft::pb::HardState& hs) {
+  std::lock_guard<std::mutex> g(manifestMu_);
+  manifest_.nextSegId = nextSegId;
+  {
+    std::lock_guard<std::mutex> pg(poolMu_);
+    manifest_.pool.assign(segmentPool_.begin(), segmentPool_.end());
+    manifest_.nextPoolSeq = poolSeq_;
+  }
+  manifest_.hasHardState = hasHardState;
+  manifest_.hardState = hs;
+  manifestTail_.reset(tail ? new SegmentMetaData(*tail) : nullptr);
+  return persistManifest();
+}
+
+Status LogManager::persistManifest() {
+  {
+    std::lock_guard<std::mutex> g(filesMu_);
+    manifest_.segments = files_;
+  }
+  // the tail may have been finished into files_ before the write path records the next one.
+  if (manifestTail_ && (manifest_.segments.empty() ||
+                        manifest_.segments.back().fileName != manifestTail_->fileName)) {
+    manifest_.segments.push_back(*manifestTail_);
+  }
+
+  std::string buf;
+  manifest_.EncodeTo(&buf);
+  return replaceFile(options_, kManifestFileName, buf);
+}
+
+Status LogManager::fillSegmentPool() {
+  std::string zeros;
+  while (true) {
+    std::string fname;
+    {
+      std::lock_guard<std::mutex> g(poolMu_);
+      if (segmentPool_.size() >= poolCapacity()) {
+        break;
+      }
+      uint64_t seq = poolSeq_++;
+      fname = stripeDir(seq) + "/" + PooledSegmentFileName(seq);
+    }
+
+    WritableFile* wf;
+    ASSIGN_IF_OK(options_.env->NewWritableFile(fname, Env::CREATE_NON_EXISTING), wf);
+    std::unique_ptr<WritableFile> f(wf);
+
+    // The spare segment of background rollover is only created, whose space is
+    // allocated once it's taken, since the unused allocation is released on close.
+    if (options_.log_segment_pool_size > 0) {
+      // the blocks must be actually written, otherwise writing into the unwritten
+      // extents of a fallocated file still changes the metadata.
+      zeros.resize(std::min<size_t>(options_.log_segment_size, 1024 * 1024), '\0');
+      for (size_t left = options_.log_segment_size; left > 0;) {
+        size_t n = std::min(left, zeros.size());
+        RETURN_NOT_OK(f->Append(Slice(zeros.data(), n)));
+        left -= n;
+      }
+      RETURN_NOT_OK(f->Sync());
+    }
+    RETURN_NOT_OK(f->Close());
+
+    std::lock_guard<std::mutex> g(poolMu_);
+    segmentPool_.push_back(std::move(fname));
+  }
   return Status::OK();
 }
 
+void LogManager::refillSegmentPool() {
+  // Zero-filling a segment takes far longer than a write, it's never done inline. A
+  // rollover that finds the pool empty creates its segment as if there were no pool.
+  if (poolQueue_) {
+    poolQueue_->Enqueue(
+        [this]() { WARN_NOT_OK(fillSegmentPool(), "LogManager::fillSegmentPool"); });
+  }
+}
+
+size_t LogManager::poolCapacity() const {
+  return std::max<size_t>(options_.log_segment_pool_size, options_.background_rollover ? 1 : 0);
+}
+
+void LogManager::submitRollover(std::function<Status()> task) {
+  {
+    std::lock_guard<std::mutex> g(rolloverMu_);
+    pendingRollovers_++;
+  }
+  rolloverQueue_->Enqueue([this, task]() {
+    Status s = task();
+    std::lock_guard<std::mutex> g(rolloverMu_);
+    if (!s.IsOK()) {
+      FMT_LOG(ERROR, "background rollover failed: {}", s.ToString());
+      if (rolloverError_.IsOK()) {
+        rolloverError_ = s;
+      }
+    }
+    pendingRollovers_--;
+    rolloverCv_.notify_all();
+  });
+}
+
+Status LogManager::waitForRollover() {
+  if (!rolloverQueue_) {
+    return Status::OK();
+  }
+  std::unique_lock<std::mutex> lock(rolloverMu_);
+  rolloverCv_.wait(lock, [this]() { return pendingRollovers_ == 0; });
+  return rolloverError_;
+}
+
+void LogManager::waitForPool() {
+  if (!poolQueue_) {
+    return;
+  }
+  std::promise<void> done;
+  poolQueue_->Enqueue([&done]() { done.set_value(); });
+  done.get_future().wait();
+}
+
 void LogManager::finishCurrentWriter() {
+  if (syncThread_.joinable()) {
+    // let the sync thread finish it, without blocking the write.
+    {
+      std::lock_guard<std::mutex> g(filesMu_);
+      files_.push_back(current_->Meta());
+    }
+    retiredWriters_.push_back(std::move(current_));
+    return;
+  }
+
+  if (rolloverQueue_) {
+    // sealed in background, while the write goes on with the next segment.
+    {
+      std::lock_guard<std::mutex> g(filesMu_);
+      files_.push_back(current_->Meta());
+    }
+    LogWriter* w = current_.release();
+    submitRollover([this, w]() {
+      std::vector<std::unique_ptr<LogWriter>> retired;
+      retired.emplace_back(w);
+      return finishRetiredWriters(&retired);
+    });
+    return;
+  }
+
   SegmentMetaData meta;
   FATAL_NOT_OK(current_->Finish(&meta), "LogWriter::Finish");
-  files_.push_back(meta);
+  {
+    std::lock_guard<std::mutex> g(filesMu_);
+    files_.push_back(meta);
+  }
+
+  // the finished segment has been synced.
+  unsyncedBytes_ = 0;
+  unflushedBytes_ = 0;
   delete current_.release();
 }
 
@@ -14,7 +14,17 @@
 
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+
 #include "base/status.h"
+#include "base/task_queue.h"
+#include "wal/hard_state_file.h"
 #include "wal/segment_meta.h"
 #include "wal/wal.h"
 
@@ -26,19 +36,25 @@ class WritableFile;
 
 namespace wal {
 
+class BlockCache;
 class LogWriter;
+class SealedSegmentReader;
 
 class LogManager;
 using LogManagerUPtr = std::unique_ptr<LogManager>;
 
-// Not-Thread-Safe
+// Not-Thread-Safe, except that Write can be called concurrently when
+// options.group_commit is enabled, and Write / AsyncWrite can be called
+// concurrently when options.background_sync is enabled.
 class LogManager : public WriteAheadLog {
  public:
   explicit LogManager(const WriteAheadLogOptions& options);
 
   // Recover from existing wal files.
-  // The options.log_dir will be created when it's not existed.
-  // All of the uncompacted log entries will be read into `memstore`.
+  // The options.log_dir and options.extra_log_dirs will be created when they're not
+  // existed.
+  // All of the uncompacted log entries will be read into `memstore`, unless
+  // options.lazy_recovery_entries leaves the older ones in the sealed segments.
   //
   // ASSERT: *memstore == null
   static Status Recover(const WriteAheadLogOptions& options, yaraft::MemStoreUptr* memstore,
@@ -47,11 +63,30 @@ class LogManager : public WriteAheadLog {
   ~LogManager() override;
 
   // Required: no holes between logs and msg.entries.
+  // The write is synced according to options.sync_policy.
   Status Write(const PBEntryVec& vec, const yaraft::pb::HardState* hs) override;
 
-  // naive implementation: delete all committed segments.
+  // With options.background_sync, the callback is invoked from the sync thread.
+  Status AsyncWrite(const PBEntryVec& vec, const yaraft::pb::HardState* hs,
+                    WriteCallback callback) override;
+
+  // The memstore in hint is compacted synchronously, while the sealed segments whose
+  // entries are all compacted are deleted in background. Segments are deleted in
+  // order, and the one containing the latest hard state is always retained.
+  // It's safe to call GC concurrently with Write.
   Status GC(WriteAheadLog::CompactionHint* hint) override;
 
+  // Entries are read from the sealed segments, through the block cache. The ones
+  // in the segment being written are not readable, which are still in the memstore.
+  // It's safe to call ReadEntries concurrently with Write and GC.
+  Status ReadEntries(uint64_t lo, uint64_t hi, uint64_t maxBytes, PBEntryVec* entries) override;
+
+  bool LazilyRecovered(uint64_t* compactIndex, uint64_t* compactTerm) const override {
+    *compactIndex = lazyCompactIndex_;
+    *compactTerm = lazyCompactTerm_;
+    return lazilyRecovered_;
+  }
+
   Status Sync() override;
 
   Status Close() override;
@@ -62,11 +97,99 @@ class LogManager : public WriteAheadLog {
   }
 
  private:
+  struct Writer;
+
+  // Queues up the write and waits until a group containing it is committed.
+  Status groupCommit(const PBEntryVec& vec, const yaraft::pb::HardState* hs);
+
+  Status appendBatch(const PBEntryVec& vec, const yaraft::pb::HardState* hs);
+
   Status doWrite(ConstPBEntriesIterator begin, ConstPBEntriesIterator end,
                  const yaraft::pb::HardState* hs);
 
+  // Persists the hard state given without entries in hardStateFile_, if its term or
+  // vote has changed. The commit index alone is left to the next batch or manifest,
+  // since it can be recomputed after a restart.
+  Status writeHardState(const yaraft::pb::HardState& hs);
+
+  // Merges the hard state of hardStateFile_ into the one recovered from the segments
+  // and the manifest, and sets it to `memstore`.
+  void mergeHardState(const yaraft::pb::HardState& saved, yaraft::MemoryStorage* memstore);
+
   void finishCurrentWriter();
 
+  // Create zero-filled segments until the pool is full. With background rollover,
+  // a spare segment is created even if options_.log_segment_pool_size is 0.
+  Status fillSegmentPool();
+
+  // Refill the pool in poolQueue_, after a segment is taken.
+  void refillSegmentPool();
+
+  size_t poolCapacity() const;
+
+  // Run `task` in rolloverQueue_, the failure is reported by the next waitForRollover.
+  void submitRollover(std::function<Status()> task);
+
+  // Wait until the segments rolled over in background are sealed, and the manifest
+  // records the current segment.
+  Status waitForRollover();
+
+  void waitForPool();
+
+  // Sync the current segment if it's required by options_.sync_policy.
+  Status syncByPolicy();
+
+  // The loop of the background sync thread.
+  void syncLoop();
+
+  void stopSyncThread();
+
+  // Runs in the gc thread. The last entry of `segments` is at lastIndex and lastTerm.
+  void deleteSegments(const std::vector<SegmentMetaData>& segments, uint64_t lastIndex,
+                      uint64_t lastTerm);
+
+  // Wait until the segments scheduled for deletion are deleted.
+  void waitForGC();
+
+  // Finish the segments rolled over in background, and mark them sealed in files_.
+  Status finishRetiredWriters(std::vector<std::unique_ptr<LogWriter>>* retired);
+
+  // Record the files owned by the write path into the manifest, and persist it.
+  Status writeManifest();
+
+  // `tail` is the current segment if it's not null.
+  Status writeManifest(const SegmentMetaData* tail, uint64_t nextSegId, bool hasHardState,
+                       const yaraft::pb::HardState& hs);
+
+  // Persist the manifest with the segments in files_, followed by the current one.
+  // Requires: manifestMu_ is held.
+  Status persistManifest();
+
+  Status recoverFromManifest(const LogManifest& manifest, std::vector<SegmentMetaData>* segments);
+
+  Status recoverFromLogDir(std::vector<SegmentMetaData>* segments);
+
+  // Returns the number of the oldest segments left out of the memstore by a lazy
+  // recovery, which are moved from `segments` into files_, or 0 if the whole log
+  // has to be loaded. The memstore starts after the entry at `*startIndex` and
+  // `*startTerm`, which is read from the segments left.
+  size_t leaveLazySegments(std::vector<SegmentMetaData>* segments, uint64_t compactIndex,
+                           uint64_t* startIndex, uint64_t* startTerm);
+
+  // Add the pooled segment into segmentPool_ if it's completely created.
+  Status recoverPooledSegment(const std::string& fname);
+
+  // Paths of the files in all of logDirs_, indexed by file name.
+  Status listLogDirs(std::map<std::string, std::string>* paths);
+
+  // The directory of the segment, or the pooled segment, numbered `seq`.
+  const std::string& stripeDir(uint64_t seq) const {
+    return logDirs_[seq % logDirs_.size()];
+  }
+
+  // Returns the reader of the sealed segment, which is opened on first use.
+  Status getReader(const SegmentMetaData& meta, std::shared_ptr<SealedSegmentReader>* reader);
+
  private:
   friend class LogManagerTest;
   friend class LogWriter;
@@ -76,24 +199,101 @@ class LogManager : public WriteAheadLog {
 
   // metadata of the immutable segments
   // new segment will be appended when the current writer finishes
+  // files_ is modified under filesMu_, since GC may run concurrently with Write.
   std::vector<SegmentMetaData> files_;
+  std::mutex filesMu_;
+  uint64_t nextSegId_;
+
+  // deletes the compacted segments, created on the first GC.
+  std::unique_ptr<TaskQueue> gcQueue_;
 
   uint64_t lastIndex_;
   bool empty_;
 
+  // whether the recovery left the entries after lazyCompactIndex_ in the sealed
+  // segments, see options_.lazy_recovery_entries.
+  bool lazilyRecovered_;
+  uint64_t lazyCompactIndex_;
+  uint64_t lazyCompactTerm_;
+
   const WriteAheadLogOptions options_;
+
+  // options_.log_dir followed by options_.extra_log_dirs, see stripeDir.
+  std::vector<std::string> logDirs_;
+
+  // paths of the pooled segments, which will be taken in order at rollover.
+  // They're protected by poolMu_, since the pool may be refilled in background.
+  std::deque<std::string> segmentPool_;
+  uint64_t poolSeq_;
+  std::mutex poolMu_;
+
+  // readers of the sealed segments, indexed by file name. At most
+  // options_.max_open_segments of them are kept open, the least recently used one
+  // is closed first.
+  struct CachedReader {
+    std::string fileName;
+    std::shared_ptr<SealedSegmentReader> reader;
+  };
+  std::list<CachedReader> readersLru_;  // from the least recently used
+  std::map<std::string, std::list<CachedReader>::iterator> readers_;
+  uint64_t nextCacheId_;
+  std::mutex readersMu_;
+  std::unique_ptr<BlockCache> blockCache_;
+
+  // the last hard state written, whose commit index may not be persisted yet.
+  yaraft::pb::HardState hardState_;
+  bool hasHardState_;
+  HardStateFile hardStateFile_;
+
+  // The manifest is written by the write path, the sync thread and the gc thread.
+  // The files owned by the write path are recorded in manifest_ by writeManifest,
+  // which is also reused by others, the segments are taken from files_ on persist.
+  LogManifest manifest_;
+  std::unique_ptr<SegmentMetaData> manifestTail_;
+  std::mutex manifestMu_;
+
+  // bytes written into the current segment since the last sync / flush.
+  size_t unsyncedBytes_;
+  size_t unflushedBytes_;
+  std::chrono::steady_clock::time_point lastSync_;
+
+  // pending writers of group commit, the front one is committing the group.
+  std::deque<Writer*> writers_;
+  std::mutex mu_;
+
+  // states of background sync, protected by mu_.
+  // Segments rolled over are finished by the sync thread, the callbacks are
+  // invoked after the retired segments and the current segment are synced.
+  std::thread syncThread_;
+  std::condition_variable syncCv_;
+  std::vector<WriteCallback> pendingCallbacks_;
+  std::vector<std::unique_ptr<LogWriter>> retiredWriters_;
+  bool stopping_;
+
+  // states of background rollover.
+  // The full segments are sealed, and the manifest is persisted in rolloverQueue_,
+  // which is waited for on sync. The pool, if any, is refilled in poolQueue_ either
+  // way.
+  std::unique_ptr<TaskQueue> rolloverQueue_;
+  std::unique_ptr<TaskQueue> poolQueue_;
+  size_t pendingRollovers_;
+  Status rolloverError_;
+  std::mutex rolloverMu_;
+  std::condition_variable rolloverCv_;
 };
 
-Status AppendToMemStore(yaraft::pb::Entry& e, yaraft::MemoryStorage* memstore);
+// Append the entries into memstore, overwriting the conflicting entries in it.
+// Returns: Error::YARaftError / OK
+Status AppendToMemStore(const yaraft::EntryVec& vec, yaraft::MemoryStorage* memstore);
 
-inline Status AppendToMemStore(yaraft::EntryVec& vec, yaraft::MemoryStorage* memstore) {
-  for (auto& e : vec) {
-    auto s = AppendToMemStore(e, memstore);
-    if (!s.IsOK())
-      return s;
-  }
-  return Status::OK();
-}
+// The entries are moved into memstore.
+Status AppendToMemStore(yaraft::EntryVec&& vec, yaraft::MemoryStorage* memstore);
+
+Status AppendToMemStore(const yaraft::pb::Entry& e, yaraft::MemoryStorage* memstore);
+
+// Compact the entries up to hint.compactIndex from hint.memstore, if it's given.
+// Returns: Error::YARaftError / OK
+Status CompactMemStore(const WriteAheadLog::CompactionHint& hint);
 
 }  // namespace wal
 }  // namespace consensus
\ No newline at end of file
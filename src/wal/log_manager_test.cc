@@ -12,6 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <map>
+#include <thread>
+
+#include "base/coding.h"
+#include "base/env.h"
+#include "base/env_util.h"
+#include "base/logging.h"
 #include "base/testing.h"
 #include "wal/log_manager.h"
 #include "wal/readable_log_segment.h"
@@ -35,7 +45,55 @@ inline bool operator==(EntryVec v1, EntryVec v2) {
   return true;
 }
 
-class LogManagerTest : public BaseTest {};
+class LogManagerTest : public BaseTest {
+ public:
+  static size_t TotalEntries(const LogManager& m) {
+    size_t total = 0;
+    for (const auto& f : m.files_) {
+      total += f.numEntries;
+    }
+    return total;
+  }
+
+  static size_t SegmentPoolSize(const LogManager& m) {
+    return m.segmentPool_.size();
+  }
+
+  static size_t UnsyncedBytes(const LogManager& m) {
+    return m.unsyncedBytes_;
+  }
+
+  static size_t OpenReaders(LogManager& m) {
+    std::lock_guard<std::mutex> g(m.readersMu_);
+    return m.readers_.size();
+  }
+
+  // The group-committed writes waiting in the queue, including the ones being committed.
+  static size_t QueuedWriters(LogManager& m) {
+    std::lock_guard<std::mutex> g(m.mu_);
+    return m.writers_.size();
+  }
+
+  static std::string LastSegment(const LogManager& m) {
+    return m.files_.back().fileName;
+  }
+
+  static std::string ReadFile(const std::string& fname) {
+    std::unique_ptr<RandomAccessFile> f(Env::Default()->NewRandomAccessFile(fname).GetValue());
+    uint64_t size = f->Size().GetValue();
+    std::string data(size, '\0');
+    Slice s;
+    FATAL_NOT_OK(env_util::ReadFully(f.get(), 0, size, &s, &data[0]), "ReadFully");
+    return s.ToString();
+  }
+
+  static void RewriteFile(const std::string& fname, const std::string& data) {
+    WritableFile* wf = Env::Default()->NewWritableFile(fname).GetValue();
+    std::unique_ptr<WritableFile> f(wf);
+    FATAL_NOT_OK(f->Append(data), "Append");
+    FATAL_NOT_OK(f->Close(), "Close");
+  }
+};
 
 TEST_F(LogManagerTest, AppendToOneSegment) {
   using namespace yaraft;
@@ -117,6 +175,48 @@ TEST_F(LogManagerTest, AppendToMemStore) {
   }
 }
 
+// This test verifies that a batch of entries truncates memstore at the first
+// conflicting one, and that the compacted entries are skipped.
+TEST_F(LogManagerTest, AppendBatchToMemStore) {
+  using E = PBEntry;
+
+  MemoryStorage memstore;
+  EntryVec vec;
+  for (uint64_t i = 1; i <= 1000; i++) {
+    vec.push_back(E().Index(i).Term(1).v);
+  }
+  ASSERT_OK(AppendToMemStore(vec, &memstore));
+  ASSERT_EQ(vec.size(), 1000);
+  ASSERT_EQ(memstore.LastIndex(), 1000);
+
+  // overwrite [500, 600] and then [550, 560]
+  vec.clear();
+  for (uint64_t i = 500; i <= 600; i++) {
+    vec.push_back(E().Index(i).Term(2).v);
+  }
+  for (uint64_t i = 550; i <= 560; i++) {
+    vec.push_back(E().Index(i).Term(3).v);
+  }
+  ASSERT_OK(AppendToMemStore(std::move(vec), &memstore));
+  ASSERT_EQ(memstore.LastIndex(), 560);
+  ASSERT_EQ(memstore.Term(499).GetValue(), 1);
+  ASSERT_EQ(memstore.Term(549).GetValue(), 2);
+  ASSERT_EQ(memstore.Term(550).GetValue(), 3);
+
+  ASSERT_EQ(AppendToMemStore(E().Index(561).Term(2).v, &memstore).Code(), Error::YARaftError);
+
+  ASSERT_OK(memstore.Compact(100));
+  vec.clear();
+  for (uint64_t i = 90; i <= 110; i++) {
+    vec.push_back(E().Index(i).Term(4).v);
+  }
+  ASSERT_OK(AppendToMemStore(std::move(vec), &memstore));
+  ASSERT_EQ(memstore.FirstIndex(), 101);
+  ASSERT_EQ(memstore.LastIndex(), 110);
+  ASSERT_EQ(memstore.Term(100).GetValue(), 1);
+  ASSERT_EQ(memstore.Term(101).GetValue(), 4);
+}
+
 // This test verifies that no logs will be loaded when LogManager recovers from empty directory.
 TEST_F(LogManagerTest, RecoverFromEmtpyDirectory) {
   TestDirGuard g(CreateTestDirGuard());
@@ -168,5 +268,893 @@ TEST_F(LogManagerTest, Recover) {
   }
 }
 
+// This test verifies that segments recovered concurrently are spliced in order,
+// so that the entries overwritten by the later segments are dropped.
+TEST_F(LogManagerTest, RecoverOverwrittenEntries) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 1024;
+
+  EntryVec expected;
+  {
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+
+    // entries in [400, 500] of term 1 are overwritten by the ones of term 2.
+    for (uint64_t term = 1; term <= 2; term++) {
+      uint64_t begin = term == 1 ? 1 : 400, end = term == 1 ? 500 : 600;
+      for (uint64_t i = begin; i <= end; i += 10) {
+        EntryVec batch;
+        for (uint64_t j = i; j < i + 10 && j <= end; j++) {
+          batch.push_back(PBEntry().Index(j).Term(term).v);
+        }
+        ASSERT_OK(m->Write(batch, nullptr));
+      }
+    }
+    ASSERT_OK(m->Close());
+    ASSERT_GT(m->SegmentNum(), 4);
+  }
+  for (uint64_t i = 1; i <= 600; i++) {
+    expected.push_back(PBEntry().Index(i).Term(i < 400 ? 1 : 2).v);
+  }
+
+  for (size_t threads : {1, 4, 16}) {
+    options.recovery_threads = threads;
+
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+
+    EntryVec actual(memstore->TEST_Entries().begin() + 1, memstore->TEST_Entries().end());
+    ASSERT_TRUE(expected == actual);
+  }
+}
+
+// This test verifies that the recovery opens the segments listed in the manifest,
+// rather than the files found in the log directory.
+TEST_F(LogManagerTest, RecoverFromManifest) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 1024;
+
+  yaraft::pb::HardState hs;
+  hs.set_term(1);
+  hs.set_commit(500);
+
+  EntryVec expected;
+  size_t segNum;
+  {
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+    for (uint64_t i = 1; i <= 500; i += 10) {
+      EntryVec batch;
+      for (uint64_t j = i; j < i + 10; j++) {
+        batch.push_back(PBEntry().Index(j).Term(1).v);
+      }
+      ASSERT_OK(m->Write(batch, i == 1 ? &hs : nullptr));
+      expected.insert(expected.end(), batch.begin(), batch.end());
+    }
+    ASSERT_OK(m->Close());
+    segNum = m->SegmentNum();
+    ASSERT_GT(segNum, 1);
+  }
+
+  // a file that's not a segment, which fails the directory scan.
+  WritableFile* wf;
+  ASSIGN_IF_ASSERT_OK(Env::Default()->NewWritableFile(GetTestDir() + "/" + SegmentFileName(1000, 1)),
+                      wf);
+  std::unique_ptr<WritableFile> f(wf);
+  ASSERT_OK(f->Append("garbage"));
+  ASSERT_OK(f->Close());
+
+  yaraft::MemStoreUptr memstore;
+  LogManagerUPtr m;
+  ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+  ASSERT_EQ(m->SegmentNum(), segNum);
+  ASSERT_EQ(memstore->InitialState().GetValue().commit(), 500);
+
+  EntryVec actual(memstore->TEST_Entries().begin() + 1, memstore->TEST_Entries().end());
+  ASSERT_TRUE(expected == actual);
+
+  // the log continues from the segments listed.
+  ASSERT_OK(m->Write(EntryVec{PBEntry().Index(501).Term(1).v}, nullptr));
+  ASSERT_OK(m->Close());
+  m.reset();
+  memstore.reset();
+
+  ASSERT_OK(Env::Default()->DeleteFile(GetTestDir() + "/" + kManifestFileName.ToString()));
+  ASSERT_FALSE(LogManager::Recover(options, &memstore, &m).IsOK());
+}
+
+// This test verifies that a lazy recovery loads only the tail of the log into the
+// memstore, while the older entries are left readable from the sealed segments.
+TEST_F(LogManagerTest, LazyRecovery) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 1024;
+
+  yaraft::pb::HardState hs;
+  hs.set_term(1000);
+  hs.set_vote(2);
+  hs.set_commit(1000);
+
+  EntryVec expected;
+  for (uint64_t i = 1; i <= 1000; i++) {
+    expected.push_back(PBEntry().Index(i).Term(i).v);
+  }
+  {
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+    ASSERT_OK(m->Write(expected, &hs));
+    ASSERT_OK(m->Close());
+  }
+
+  options.lazy_recovery_entries = 100;
+  {
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+
+    uint64_t compactIndex, compactTerm;
+    ASSERT_TRUE(m->LazilyRecovered(&compactIndex, &compactTerm));
+    ASSERT_EQ(compactIndex, 0);
+    ASSERT_EQ(compactTerm, 0);
+
+    // the tail holds enough entries, but not the whole log.
+    uint64_t first = memstore->FirstIndex();
+    ASSERT_GT(first, 1);
+    ASSERT_LE(first, 901);
+    ASSERT_EQ(memstore->LastIndex(), 1000);
+    ASSERT_EQ(memstore->Term(first - 1).GetValue(), first - 1);
+    ASSERT_EQ(memstore->InitialState().GetValue().DebugString(), hs.DebugString());
+
+    EntryVec actual;
+    ASSERT_OK(m->ReadEntries(1, first, std::numeric_limits<uint64_t>::max(), &actual));
+    actual.insert(actual.end(), memstore->TEST_Entries().begin() + 1,
+                  memstore->TEST_Entries().end());
+    ASSERT_TRUE(expected == actual);
+
+    // the log continues from the tail.
+    expected.push_back(PBEntry().Index(1001).Term(1000).v);
+    ASSERT_OK(m->Write(EntryVec{expected.back()}, nullptr));
+    ASSERT_OK(m->Close());
+  }
+
+  // without the manifest, the whole log is loaded.
+  ASSERT_OK(Env::Default()->DeleteFile(GetTestDir() + "/" + kManifestFileName.ToString()));
+  yaraft::MemStoreUptr memstore;
+  LogManagerUPtr m;
+  ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+  uint64_t compactIndex, compactTerm;
+  ASSERT_FALSE(m->LazilyRecovered(&compactIndex, &compactTerm));
+  EntryVec actual(memstore->TEST_Entries().begin() + 1, memstore->TEST_Entries().end());
+  ASSERT_TRUE(expected == actual);
+}
+
+// This test verifies that ReadEntries reads the entries in sealed segments, including
+// the ones overwritten by the later segments.
+TEST_F(LogManagerTest, ReadEntries) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 64 * 1024;
+  options.block_cache_size = 64 * 1024;
+  options.max_open_segments = 2;
+
+  yaraft::MemStoreUptr memstore;
+  LogManagerUPtr m;
+  ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+
+  // entries in [1500, 2000] of term 1 are overwritten by the ones of term 2.
+  for (uint64_t term = 1; term <= 2; term++) {
+    uint64_t begin = term == 1 ? 1 : 1500, end = term == 1 ? 2000 : 2500;
+    for (uint64_t i = begin; i <= end; i += 10) {
+      EntryVec batch;
+      for (uint64_t j = i; j < i + 10 && j <= end; j++) {
+        batch.push_back(PBEntry().Index(j).Term(term).Data(std::string(100, 'a')).v);
+      }
+      ASSERT_OK(m->Write(batch, nullptr));
+    }
+  }
+  ASSERT_GT(m->SegmentNum(), 3);
+
+  // the entries in the segment being written are not readable.
+  PBEntryVec actual;
+  ASSERT_EQ(m->ReadEntries(2500, 2501, UINT64_MAX, &actual).Code(), Error::NotFound);
+  ASSERT_OK(m->Close());
+
+  EntryVec expected;
+  for (uint64_t i = 1; i <= 2500; i++) {
+    expected.push_back(PBEntry().Index(i).Term(i < 1500 ? 1 : 2).Data(std::string(100, 'a')).v);
+  }
+
+  // read twice, the second one is served by the block cache.
+  for (int round = 0; round < 2; round++) {
+    ASSERT_OK(m->ReadEntries(1, 2501, UINT64_MAX, &actual));
+    ASSERT_TRUE(expected == actual);
+  }
+
+  // read in pieces limited by size
+  for (uint64_t maxBytes : {0, 1000, 10000}) {
+    EntryVec all;
+    for (uint64_t lo = 1; lo <= 2500; lo += actual.size()) {
+      ASSERT_OK(m->ReadEntries(lo, 2501, maxBytes, &actual));
+      ASSERT_FALSE(actual.empty());
+      all.insert(all.end(), actual.begin(), actual.end());
+    }
+    ASSERT_TRUE(expected == all);
+  }
+  // the readers of the least recently read segments are closed.
+  ASSERT_EQ(OpenReaders(*m), 2);
+
+  ASSERT_OK(m->ReadEntries(1400, 1600, UINT64_MAX, &actual));
+  ASSERT_TRUE(EntryVec(expected.begin() + 1399, expected.begin() + 1599) == actual);
+  ASSERT_EQ(m->ReadEntries(2501, 2600, UINT64_MAX, &actual).Code(), Error::NotFound);
+
+  // entries in the compacted segments are not readable.
+  WriteAheadLog::CompactionHint hint;
+  hint.compactIndex = 1000;
+  ASSERT_OK(m->GC(&hint));
+  ASSERT_OK(m->Close());
+  ASSERT_EQ(m->ReadEntries(1, 2, UINT64_MAX, &actual).Code(), Error::LogCompacted);
+  ASSERT_OK(m->ReadEntries(1001, 1002, UINT64_MAX, &actual));
+  ASSERT_EQ(actual.size(), 1);
+}
+
+// This test verifies that concurrent writes are all persisted when group commit is enabled.
+TEST_F(LogManagerTest, GroupCommit) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 1024;
+  options.group_commit = true;
+
+  const int kWrites = 200;
+  const int kBatchSize = 5;
+
+  EntryVec expected;
+  for (uint64_t i = 1; i <= kWrites * kBatchSize; i++) {
+    expected.push_back(PBEntry().Index(i).Term(1).v);
+  }
+
+  {
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+
+    // Each write is issued from its own thread once the previous ones are queued or done,
+    // so that the indexes increase in the order of the queue, while the writes queued
+    // behind a leader are committed together.
+    std::atomic<int> finished(0);
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (int k = 0; k < kWrites; k++) {
+      threads.emplace_back([&, k]() {
+        EntryVec vec(expected.begin() + k * kBatchSize, expected.begin() + (k + 1) * kBatchSize);
+        if (!m->Write(vec, nullptr).IsOK()) {
+          failures++;
+        }
+        finished++;
+      });
+
+      // a finished write has left the queue before it's counted.
+      while (true) {
+        int done = finished.load();
+        if (done + QueuedWriters(*m) == static_cast<size_t>(k + 1)) {
+          break;
+        }
+        std::this_thread::yield();
+      }
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    ASSERT_EQ(failures.load(), 0);
+    ASSERT_OK(m->Close());
+    ASSERT_EQ(TotalEntries(*m), expected.size());
+  }
+
+  yaraft::MemStoreUptr memstore;
+  LogManagerUPtr m;
+  ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+  EntryVec actual(memstore->TEST_Entries().begin() + 1, memstore->TEST_Entries().end());
+  ASSERT_TRUE(expected == actual);
+}
+
+// This test verifies that segments are taken from the pool at rollover, and the pool
+// is refilled afterwards.
+TEST_F(LogManagerTest, SegmentPool) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 1024;
+  options.log_segment_pool_size = 2;
+
+  EntryVec expected;
+  for (uint64_t i = 1; i <= 1000; i++) {
+    expected.push_back(PBEntry().Index(i).Term(i).v);
+  }
+
+  size_t segNum;
+  {
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+    ASSERT_EQ(SegmentPoolSize(*m), 2);
+
+    ASSERT_OK(m->Write(expected, nullptr));
+    ASSERT_OK(m->Close());
+    ASSERT_EQ(SegmentPoolSize(*m), 2);
+    segNum = m->SegmentNum();
+    ASSERT_GT(segNum, 1);
+  }
+
+  std::vector<std::string> files;
+  ASSERT_OK(Env::Default()->GetChildren(GetTestDir(), &files));
+  ASSERT_EQ(files.size(), segNum + 2 + 1);  // including the manifest
+
+  yaraft::MemStoreUptr memstore;
+  LogManagerUPtr m;
+  ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+  ASSERT_EQ(SegmentPoolSize(*m), 2);
+  ASSERT_EQ(segNum, m->SegmentNum());
+
+  EntryVec actual(memstore->TEST_Entries().begin() + 1, memstore->TEST_Entries().end());
+  ASSERT_TRUE(expected == actual);
+}
+
+// This test verifies that the segments, including the pooled ones, are striped
+// across the log directories, and are recovered either from the manifest or by
+// scanning all of the directories.
+TEST_F(LogManagerTest, StripedLogDirs) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir() + "/dir-0";
+  options.extra_log_dirs = {GetTestDir() + "/dir-1", GetTestDir() + "/dir-2"};
+  options.log_segment_size = 1024;
+  options.log_segment_pool_size = 2;
+
+  EntryVec expected;
+  for (uint64_t i = 1; i <= 1000; i++) {
+    expected.push_back(PBEntry().Index(i).Term(i).v);
+  }
+
+  size_t segNum;
+  {
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+    ASSERT_OK(m->Write(expected, nullptr));
+    ASSERT_OK(m->Close());
+    segNum = m->SegmentNum();
+    ASSERT_GT(segNum, 6);
+  }
+
+  std::vector<std::string> dirs{options.log_dir};
+  dirs.insert(dirs.end(), options.extra_log_dirs.begin(), options.extra_log_dirs.end());
+  size_t wals = 0;
+  for (const auto& dir : dirs) {
+    std::vector<std::string> files;
+    ASSERT_OK(Env::Default()->GetChildren(dir, &files));
+    size_t n = std::count_if(files.begin(), files.end(), [](const std::string& f) {
+      return f.size() > 4 && f.substr(f.size() - 4) == ".wal";
+    });
+    ASSERT_GT(n, 0) << dir;
+    wals += n;
+  }
+  ASSERT_EQ(wals, segNum);
+
+  for (int pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      ASSERT_OK(Env::Default()->DeleteFile(options.log_dir + "/" + kManifestFileName.ToString()));
+    }
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+    ASSERT_EQ(SegmentPoolSize(*m), 2);
+    ASSERT_EQ(segNum, m->SegmentNum());
+
+    EntryVec actual(memstore->TEST_Entries().begin() + 1, memstore->TEST_Entries().end());
+    ASSERT_TRUE(expected == actual);
+    ASSERT_OK(m->Close());
+  }
+}
+
+// This test verifies that the log written through the io_uring env, including
+// the pooled segments, can be recovered.
+TEST_F(LogManagerTest, IoUringEnv) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  StatusWith<Env*> sw = Env::IoUring();
+  if (!sw.IsOK()) {
+    LOG(INFO) << "skipping test: " << sw.GetStatus();
+    return;
+  }
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 1024;
+  options.log_segment_pool_size = 2;
+  options.env = sw.GetValue();
+
+  EntryVec expected;
+  for (uint64_t i = 1; i <= 1000; i++) {
+    expected.push_back(PBEntry().Index(i).Term(i).v);
+  }
+
+  size_t segNum;
+  {
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+    for (uint64_t i = 0; i < expected.size(); i += 10) {
+      EntryVec batch(expected.begin() + i, expected.begin() + i + 10);
+      ASSERT_OK(m->Write(batch, nullptr));
+    }
+    ASSERT_OK(m->Close());
+    segNum = m->SegmentNum();
+    ASSERT_GT(segNum, 4);
+  }
+
+  yaraft::MemStoreUptr memstore;
+  LogManagerUPtr m;
+  ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+  ASSERT_EQ(segNum, m->SegmentNum());
+
+  EntryVec actual(memstore->TEST_Entries().begin() + 1, memstore->TEST_Entries().end());
+  ASSERT_TRUE(expected == actual);
+}
+
+// This test verifies that GC deletes the sealed segments whose entries are all
+// compacted, and the log can be recovered from the remaining segments.
+TEST_F(LogManagerTest, GC) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 1024;
+
+  EntryVec expected;
+  for (uint64_t i = 1; i <= 1000; i++) {
+    expected.push_back(PBEntry().Index(i).Term(i).v);
+  }
+  yaraft::pb::HardState hs;
+  hs.set_term(1000);
+  hs.set_commit(1000);
+
+  const uint64_t kCompactIndex = 500;
+  size_t segNum;
+  {
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+    for (uint64_t i = 0; i < expected.size(); i += 10) {
+      EntryVec batch(expected.begin() + i, expected.begin() + i + 10);
+      ASSERT_OK(m->Write(batch, &hs));
+    }
+    size_t before = m->SegmentNum();
+
+    MemoryStorage memStore;
+    ASSERT_OK(AppendToMemStore(expected, &memStore));
+
+    WriteAheadLog::CompactionHint hint;
+    hint.compactIndex = kCompactIndex;
+    hint.memstore = &memStore;
+    ASSERT_OK(m->GC(&hint));
+    ASSERT_EQ(memStore.FirstIndex(), kCompactIndex + 1);
+    ASSERT_EQ(memStore.LastIndex(), expected.size());
+
+    ASSERT_OK(m->Close());
+    segNum = m->SegmentNum();
+    ASSERT_LT(segNum, before);
+  }
+
+  std::vector<std::string> files;
+  ASSERT_OK(Env::Default()->GetChildren(GetTestDir(), &files));
+  ASSERT_EQ(std::count_if(files.begin(), files.end(),
+                          [](const std::string& f) { return f.find(".wal") != std::string::npos; }),
+            segNum);
+
+  yaraft::MemStoreUptr memstore;
+  LogManagerUPtr m;
+  ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+  ASSERT_EQ(segNum, m->SegmentNum());
+  ASSERT_GT(memstore->FirstIndex(), 1);
+  ASSERT_LE(memstore->FirstIndex(), kCompactIndex + 1);
+  ASSERT_EQ(memstore->LastIndex(), expected.size());
+
+  EntryVec actual(memstore->TEST_Entries().begin() + 1, memstore->TEST_Entries().end());
+  ASSERT_TRUE(EntryVec(expected.begin() + memstore->FirstIndex() - 1, expected.end()) == actual);
+  ASSERT_EQ(memstore->InitialState().GetValue().commit(), 1000);
+
+  // the log continues after the recovered entries.
+  ASSERT_OK(m->Write(EntryVec{PBEntry().Index(1001).Term(1000).v}, nullptr));
+  ASSERT_OK(m->Close());
+}
+
+// This test verifies that GC retains the segment with the latest hard state.
+TEST_F(LogManagerTest, GCRetainsHardState) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 1024;
+
+  yaraft::pb::HardState hs;
+  hs.set_term(1);
+  hs.set_commit(10);
+
+  yaraft::MemStoreUptr memstore;
+  LogManagerUPtr m;
+  ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+  for (uint64_t i = 1; i <= 1000; i += 10) {
+    EntryVec batch;
+    for (uint64_t j = i; j < i + 10; j++) {
+      batch.push_back(PBEntry().Index(j).Term(1).v);
+    }
+    ASSERT_OK(m->Write(batch, i == 1 ? &hs : nullptr));
+  }
+  size_t segNum = m->SegmentNum();
+
+  WriteAheadLog::CompactionHint hint;
+  hint.compactIndex = 1000;
+  ASSERT_OK(m->GC(&hint));
+  ASSERT_OK(m->Close());
+  ASSERT_EQ(m->SegmentNum(), segNum);
+}
+
+// This test verifies that the compacted segments left behind, by a crash between
+// persisting the compaction point and deleting them, are skipped and deleted by the
+// recovery, whether they are still in the manifest or found by scanning the directory.
+TEST_F(LogManagerTest, RecoverAfterInterruptedGC) {
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 1024;
+
+  EntryVec expected;
+  for (uint64_t i = 1; i <= 1000; i++) {
+    expected.push_back(PBEntry().Index(i).Term(i).v);
+  }
+  const std::string kManifest = GetTestDir() + "/" + kManifestFileName.ToString();
+
+  // whether the manifest still lists the compacted segments.
+  for (bool listed : {true, false}) {
+    TestDirGuard g(CreateTestDirGuard());
+
+    {
+      yaraft::MemStoreUptr memstore;
+      LogManagerUPtr m;
+      ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+      for (uint64_t i = 0; i < expected.size(); i += 10) {
+        ASSERT_OK(m->Write(EntryVec(expected.begin() + i, expected.begin() + i + 10), nullptr));
+      }
+      ASSERT_OK(m->Close());
+    }
+    std::vector<std::string> before;
+    ASSERT_OK(Env::Default()->GetChildren(GetTestDir(), &before));
+    std::map<std::string, std::string> saved;
+    for (const auto& f : before) {
+      saved[f] = ReadFile(GetTestDir() + "/" + f);
+    }
+
+    {
+      yaraft::MemStoreUptr memstore;
+      LogManagerUPtr m;
+      ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+      WriteAheadLog::CompactionHint hint;
+      hint.compactIndex = 500;
+      hint.memstore = memstore.get();
+      ASSERT_OK(m->GC(&hint));
+      ASSERT_OK(m->Close());
+    }
+
+    // bring the deleted segments back, as if the crash happened before deleting them.
+    std::vector<std::string> after;
+    ASSERT_OK(Env::Default()->GetChildren(GetTestDir(), &after));
+    std::vector<std::string> restored;
+    for (const auto& e : saved) {
+      if (e.first.find(".wal") != std::string::npos &&
+          std::find(after.begin(), after.end(), e.first) == after.end()) {
+        RewriteFile(GetTestDir() + "/" + e.first, e.second);
+        restored.push_back(e.first);
+      }
+    }
+    ASSERT_FALSE(restored.empty());
+    if (listed) {
+      RewriteFile(kManifest, saved[kManifestFileName.ToString()]);
+    } else {
+      ASSERT_OK(Env::Default()->DeleteFile(kManifest));
+    }
+
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+    ASSERT_LE(memstore->FirstIndex(), 501);
+    ASSERT_EQ(memstore->LastIndex(), expected.size());
+    EntryVec actual(memstore->TEST_Entries().begin() + 1, memstore->TEST_Entries().end());
+    ASSERT_TRUE(EntryVec(expected.begin() + memstore->FirstIndex() - 1, expected.end()) == actual);
+    ASSERT_EQ(TotalEntries(*m), actual.size());
+    ASSERT_OK(m->Close());
+
+    for (const auto& f : restored) {
+      ASSERT_FALSE(Env::Default()->GetFileSize(GetTestDir() + "/" + f).IsOK());
+    }
+  }
+}
+
+// This test verifies that a hard state written without entries is recovered, and that
+// the ones changing only the commit index aren't written.
+TEST_F(LogManagerTest, HardStateWithoutEntries) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+
+  auto makeHardState = [](uint64_t term, uint64_t vote, uint64_t commit) {
+    yaraft::pb::HardState hs;
+    hs.set_term(term);
+    hs.set_vote(vote);
+    hs.set_commit(commit);
+    return hs;
+  };
+
+  {
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+
+    // a vote cast before any entry is received.
+    yaraft::pb::HardState hs = makeHardState(1, 2, 0);
+    ASSERT_OK(m->Write(PBEntryVec(), &hs));
+  }
+  {
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+    ASSERT_TRUE(memstore != nullptr);
+    yaraft::pb::HardState hs = memstore->InitialState().GetValue();
+    ASSERT_EQ(hs.term(), 1);
+    ASSERT_EQ(hs.vote(), 2);
+
+    EntryVec batch;
+    for (uint64_t i = 1; i <= 10; i++) {
+      batch.push_back(PBEntry().Index(i).Term(1).v);
+    }
+    ASSERT_OK(m->Write(batch, nullptr));
+
+    hs = makeHardState(2, 3, 5);
+    ASSERT_OK(m->Write(PBEntryVec(), &hs));
+    std::string saved = ReadFile(GetTestDir() + "/HARDSTATE.0");
+
+    // only the commit index changes.
+    hs = makeHardState(2, 3, 8);
+    ASSERT_OK(m->Write(PBEntryVec(), &hs));
+    ASSERT_EQ(ReadFile(GetTestDir() + "/HARDSTATE.0"), saved);
+    ASSERT_OK(m->Close());
+  }
+
+  yaraft::MemStoreUptr memstore;
+  LogManagerUPtr m;
+  ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+  yaraft::pb::HardState hs = memstore->InitialState().GetValue();
+  ASSERT_EQ(hs.term(), 2);
+  ASSERT_EQ(hs.vote(), 3);
+  ASSERT_GE(hs.commit(), 5);
+  ASSERT_LE(hs.commit(), 8);
+  ASSERT_EQ(memstore->LastIndex(), 10);
+}
+
+// This test verifies that writes are synced according to the sync policy.
+TEST_F(LogManagerTest, SyncPolicy) {
+  struct TestData {
+    WriteAheadLogOptions::SyncPolicy policy;
+    size_t syncBytes;
+  } tests[] = {
+      {WriteAheadLogOptions::SYNC_EVERY_WRITE, 0},
+      {WriteAheadLogOptions::SYNC_BYTES, 4096},
+      {WriteAheadLogOptions::SYNC_NONE, 0},
+  };
+
+  for (auto t : tests) {
+    TestDirGuard g(CreateTestDirGuard());
+
+    WriteAheadLogOptions options;
+    options.log_dir = GetTestDir();
+    options.sync_policy = t.policy;
+    options.sync_bytes = t.syncBytes;
+
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+
+    size_t written = 0;
+    for (uint64_t i = 1; i <= 100; i++) {
+      EntryVec vec{PBEntry().Index(i).Term(1).Data(std::string(100, 'a')).v};
+      ASSERT_OK(m->Write(vec, nullptr));
+      written += vec[0].ByteSize();
+
+      switch (t.policy) {
+        case WriteAheadLogOptions::SYNC_EVERY_WRITE:
+          ASSERT_EQ(UnsyncedBytes(*m), 0);
+          break;
+        case WriteAheadLogOptions::SYNC_BYTES:
+          ASSERT_LT(UnsyncedBytes(*m), t.syncBytes);
+          break;
+        default:
+          ASSERT_GT(UnsyncedBytes(*m), written);
+      }
+    }
+
+    ASSERT_OK(m->Sync());
+    ASSERT_EQ(UnsyncedBytes(*m), 0);
+  }
+}
+
+// This test verifies that in background sync, callbacks are invoked in order once data
+// is synced, including the data in the segments rolled over.
+TEST_F(LogManagerTest, BackgroundSync) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 1024;
+  options.background_sync = true;
+
+  yaraft::MemStoreUptr memstore;
+  LogManagerUPtr m;
+  ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+
+  const int kWrites = 500;
+  std::atomic<int> synced(0);
+  std::atomic<bool> outOfOrder(false);
+  for (int i = 0; i < kWrites; i++) {
+    EntryVec vec{PBEntry().Index(i + 1).Term(1).v};
+    ASSERT_OK(m->AsyncWrite(vec, nullptr, [&, i](const Status& s) {
+      if (!s.IsOK() || synced.fetch_add(1) != i) {
+        outOfOrder = true;
+      }
+    }));
+  }
+
+  // a synchronous write waits for all previous writes.
+  EntryVec vec{PBEntry().Index(kWrites + 1).Term(1).v};
+  ASSERT_OK(m->Write(vec, nullptr));
+  ASSERT_EQ(synced.load(), kWrites);
+  ASSERT_FALSE(outOfOrder.load());
+
+  ASSERT_OK(m->Close());
+  ASSERT_GT(m->SegmentNum(), 1);
+  ASSERT_EQ(TotalEntries(*m), kWrites + 1);
+}
+
+// This test verifies that with background rollover, the segments are sealed and
+// recorded in the manifest once synced, and the log can be recovered.
+TEST_F(LogManagerTest, BackgroundRollover) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 1024;
+  options.background_rollover = true;
+
+  EntryVec expected;
+  {
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+    ASSERT_EQ(SegmentPoolSize(*m), 1);
+
+    for (uint64_t i = 1; i <= 500; i += 10) {
+      EntryVec batch;
+      for (uint64_t j = i; j < i + 10; j++) {
+        batch.push_back(PBEntry().Index(j).Term(1).v);
+      }
+      ASSERT_OK(m->Write(batch, nullptr));
+      expected.insert(expected.end(), batch.begin(), batch.end());
+    }
+    ASSERT_GT(m->SegmentNum(), 1);
+
+    // every segment rolled over has been sealed when Write returns.
+    EntryVec entries;
+    ASSERT_OK(m->ReadEntries(1, 501, std::numeric_limits<uint64_t>::max(), &entries));
+    ASSERT_EQ(entries.front().index(), 1);
+    ASSERT_OK(m->Close());
+    ASSERT_EQ(TotalEntries(*m), expected.size());
+  }
+
+  yaraft::MemStoreUptr memstore;
+  LogManagerUPtr m;
+  ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+  EntryVec actual(memstore->TEST_Entries().begin() + 1, memstore->TEST_Entries().end());
+  ASSERT_TRUE(actual == expected);
+  ASSERT_OK(m->Close());
+}
+
+// This test verifies that a batch torn by a crash at the end of the newest segment is
+// truncated by recovery, while a corrupted batch before the end is still an error.
+TEST_F(LogManagerTest, RecoverTornTail) {
+  std::string batchHeader;
+  PutFixed32(&batchHeader, 0xdeadbeef);
+  PutFixed32(&batchHeader, 64);
+  std::string tornTails[] = {
+      // the header is cut short.
+      batchHeader.substr(0, 6),
+      // the data is cut short.
+      batchHeader + std::string(16, 'x'),
+      // the data is partly written into the preallocated space.
+      batchHeader + std::string(16, 'x') + std::string(1024, '\0'),
+  };
+
+  for (const std::string& tail : tornTails) {
+    TestDirGuard g(CreateTestDirGuard());
+
+    WriteAheadLogOptions options;
+    options.log_dir = GetTestDir();
+    options.log_segment_size = 1024;
+    options.verify_checksum = true;
+
+    EntryVec expected;
+    std::string lastSegment;
+    {
+      yaraft::MemStoreUptr memstore;
+      LogManagerUPtr m;
+      ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+      for (uint64_t i = 1; i <= 200; i += 10) {
+        EntryVec batch;
+        for (uint64_t j = i; j < i + 10; j++) {
+          batch.push_back(PBEntry().Index(j).Term(1).v);
+        }
+        ASSERT_OK(m->Write(batch, nullptr));
+        expected.insert(expected.end(), batch.begin(), batch.end());
+      }
+      ASSERT_OK(m->Close());
+      lastSegment = LastSegment(*m);
+    }
+
+    // the crash leaves the newest segment unsealed, and ending in a torn batch.
+    RandomAccessFile* rf;
+    ASSIGN_IF_ASSERT_OK(Env::Default()->NewRandomAccessFile(lastSegment), rf);
+    std::unique_ptr<RandomAccessFile> f(rf);
+    SegmentFooter footer;
+    ASSERT_OK(ReadSegmentFooter(rf, &footer));
+    f.reset();
+    std::string intact = ReadFile(lastSegment).substr(0, footer.offset);
+    RewriteFile(lastSegment, intact + tail);
+    ASSERT_OK(Env::Default()->DeleteFile(GetTestDir() + "/" + kManifestFileName.ToString()));
+
+    {
+      yaraft::MemStoreUptr memstore;
+      LogManagerUPtr m;
+      ASSERT_OK(LogManager::Recover(options, &memstore, &m));
+      EntryVec actual(memstore->TEST_Entries().begin() + 1, memstore->TEST_Entries().end());
+      ASSERT_TRUE(actual == expected);
+      ASSERT_OK(m->Close());
+    }
+    ASSERT_EQ(ReadFile(lastSegment), intact);
+
+    // a bad checksum before the end is corruption.
+    std::string corrupted = intact;
+    corrupted[kLogSegmentHeaderMagic.size() + kChecksumTypeSize + kLogBatchHeaderSize + 2] ^= 1;
+    RewriteFile(lastSegment, corrupted + tail);
+    ASSERT_OK(Env::Default()->DeleteFile(GetTestDir() + "/" + kManifestFileName.ToString()));
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    ASSERT_EQ(LogManager::Recover(options, &memstore, &m).Code(), Error::Corruption);
+  }
+}
+
 }  // namespace wal
-}  // namespace consensus
\ No newline at end of file
+}  // namespace consensus
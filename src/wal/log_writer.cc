@@ -14,89 +14,407 @@
 
 #include "wal/log_writer.h"
 #include "base/coding.h"
+#include "base/crc32c.h"
+#include "wal/compression.h"
+#include "wal/record_codec.h"
 
-#include <boost/crc.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 
 namespace consensus {
 namespace wal {
 
+// Entries whose payload is smaller than this are serialized into the batch buffer,
+// for which copying is cheaper than writing another iovec.
+constexpr static size_t kMinZeroCopyDataSize = 512;
+
+// A batch is added to the footer index if it starts at least this many bytes
+// after the previously indexed one.
+constexpr static size_t kFooterIndexInterval = 4096;
+
+// At most this many of the recent batches can be cut back to, which covers the
+// uncommitted tail of the log a follower may have to overwrite.
+constexpr static size_t kMaxCheckpoints = 1024;
+
+static bool isZeroCopy(const yaraft::pb::Entry &e) {
+  return e.has_data() && e.data().size() >= kMinZeroCopyDataSize;
+}
+
 StatusWith<ConstPBEntriesIterator> LogWriter::Append(ConstPBEntriesIterator begin,
                                                      ConstPBEntriesIterator end,
                                                      const yaraft::pb::HardState *hs) {
+  Metrics &metrics = Metrics::Instance();
+  ScopedLatency latency(&metrics.walAppendLatency);
+
   if (empty_) {
-    RETURN_NOT_OK(file_->Append(kLogSegmentHeaderMagic));
+    static const char checksumType = static_cast<char>(kCRC32C);
+    Slice header[] = {kLogSegmentHeaderMagic, Slice(&checksumType, kChecksumTypeSize)};
+    RETURN_NOT_OK(write(header, 2));
     empty_ = false;
   }
 
-  ssize_t remains = logSegmentSize_ - file_->Size();
+  // the entries from truncateIdx on, which are already in the segment, are
+  // overwritten by this batch.
+  uint64_t truncateIdx = 0;
+  if (begin != end && meta_.numEntries > 0 && begin->index() <= meta_.lastIndex) {
+    if (rewriteTail_) {
+      RETURN_NOT_OK(rewindTo(begin->index()));
+    }
+    if (meta_.numEntries > 0 && begin->index() <= meta_.lastIndex) {
+      truncateIdx = begin->index();
+    }
+  }
+  if (rewriteHs_ && !hs) {
+    hs = &lastHs_;
+  }
+
+  ssize_t remains = logSegmentSize_ - Size();
   size_t totalSize = kLogBatchHeaderSize;
 
   if (hs) {
-    totalSize += kRecordHeaderSize + hs->ByteSize();
+    totalSize += RecordSize<kFixedHardStateType>(*hs);
   }
 
+  // bytes of payload that are written directly from the entries.
+  size_t zeroCopySize = 0;
+
   bool writeEntries = false;
   auto newBegin = begin;
   if (totalSize < remains && begin != end) {
     writeEntries = true;
+    if (truncateIdx > 0) {
+      totalSize += RecordSize<kTruncateType>(truncateIdx);
+    }
     for (; newBegin != end; newBegin++) {
       if (totalSize < remains) {
-        totalSize += kRecordHeaderSize + VarintLength(newBegin->ByteSize()) + newBegin->ByteSize();
+        size_t entrySize = newBegin->ByteSize();
+        totalSize += kRecordHeaderSize + VarintLength(entrySize) + entrySize;
+        if (isZeroCopy(*newBegin)) {
+          zeroCopySize += newBegin->data().size();
+        }
       } else {
         break;
       }
     }
   }
 
-  std::string scratch(totalSize, '\0');
+  // The scratch holds everything but the large payloads, which are gathered
+  // together with the scratch pieces in one AppendV. Both buffers keep their
+  // capacity across batches, so that appends in steady state don't allocate.
+  std::string &scratch = scratch_;
+  scratch.resize(totalSize - zeroCopySize);
   size_t offset = kLogBatchHeaderSize;
 
   if (hs) {
     saveHardState(*hs, &scratch[offset], &offset);
   }
 
+  std::vector<Slice> &slices = slices_;
+  slices.clear();
+  if (writeEntries && truncateIdx > 0) {
+    saveTruncate(truncateIdx, &scratch[offset], &offset);
+  }
   if (writeEntries) {
-    saveEntries(begin, newBegin, &scratch[offset], &offset);
+    saveEntries(begin, newBegin, &scratch, &offset, &slices);
+  } else {
+    slices.emplace_back(scratch.data(), offset);
   }
+  DCHECK_EQ(offset, scratch.size());
 
   size_t dataLen = totalSize - kLogBatchHeaderSize;
+  char *header = &scratch[0];
+  if (compression_ != kNoCompression && dataLen >= minCompressSize_) {
+    bool compressed;
+    RETURN_NOT_OK(compressBatch(&slices, &dataLen, &compressed));
+    if (compressed) {
+      header = &compressedHeader_[0];
+    }
+  }
 
   // len field
-  EncodeFixed32(&scratch[4], static_cast<uint32_t>(dataLen));
+  EncodeFixed32(header + 4, static_cast<uint32_t>(dataLen));
 
-  // crc field
-  boost::crc_32_type crc;
-  crc.process_bytes(&scratch[kLogBatchHeaderSize], dataLen);
-  EncodeFixed32(&scratch[0], static_cast<uint32_t>(crc.checksum()));
+  // crc field, computed incrementally over the pieces to be written.
+  uint32_t crc = crc32c::Value(slices[0].data() + kLogBatchHeaderSize,
+                               slices[0].size() - kLogBatchHeaderSize);
+  for (size_t i = 1; i < slices.size(); i++) {
+    crc = crc32c::Extend(crc, slices[i].data(), slices[i].size());
+  }
+  EncodeFixed32(header, crc);
+
+  uint64_t batchOffset = Size();
+  if (rewriteTail_ && begin != newBegin) {
+    while (!checkpoints_.empty() && checkpoints_.back().index >= begin->index()) {
+      checkpoints_.pop_back();
+    }
+    uint64_t hsTerm = meta_.hasHardState ? lastHs_.term() : 0;
+    uint64_t hsVote = meta_.hasHardState ? lastHs_.vote() : 0;
+    checkpoints_.push_back(Checkpoint{begin->index(), batchOffset, segmentCrc_,
+                                      meta_.numEntries, meta_.firstIndex, meta_.lastIndex,
+                                      meta_.lastTerm, meta_.hasHardState, hsTerm, hsVote});
+    if (checkpoints_.size() > kMaxCheckpoints) {
+      checkpoints_.pop_front();
+    }
+  }
 
-  RETURN_NOT_OK(file_->Append(scratch));
+  RETURN_NOT_OK(write(slices.data(), slices.size()));
+  metrics.walAppendBytes << static_cast<int64_t>(Size() - batchOffset);
 
+  if (begin != newBegin) {
+    indexBatch(begin->index(), batchOffset);
+    if (meta_.numEntries == 0 || begin->index() < meta_.firstIndex) {
+      meta_.firstIndex = begin->index();
+    }
+    meta_.lastIndex = std::prev(newBegin)->index();
+    meta_.lastTerm = std::prev(newBegin)->term();
+  }
+  if (hs) {
+    meta_.hasHardState = true;
+    if (rewriteTail_) {
+      if (hs != &lastHs_) {
+        lastHs_ = *hs;
+      }
+      lastHsOffset_ = batchOffset;
+      rewriteHs_ = false;
+    }
+  }
   meta_.numEntries += std::distance(begin, newBegin);
   return newBegin;
 }
 
+Status LogWriter::rewindTo(uint64_t idx) {
+  auto it = std::lower_bound(checkpoints_.begin(), checkpoints_.end(), idx,
+                             [](const Checkpoint &c, uint64_t i) { return c.index < i; });
+  if (it == checkpoints_.end()) {
+    return Status::OK();
+  }
+
+  // The cut is not synced before the overwriting batch is written at its place, a
+  // crash in between loses the hard states cut off, which is only safe if they
+  // changed nothing but the commit index.
+  bool cutHs = meta_.hasHardState && lastHsOffset_ >= it->offset;
+  if (cutHs &&
+      (!it->hasHardState || it->hsTerm != lastHs_.term() || it->hsVote != lastHs_.vote())) {
+    return Status::OK();
+  }
+
+  uint64_t size = Size();
+  RETURN_NOT_OK(file_->Truncate(it->offset));
+  Metrics &metrics = Metrics::Instance();
+  metrics.walTailRewinds << 1;
+  metrics.walTailRewindBytes << static_cast<int64_t>(size - it->offset);
+
+  while (!index_.empty() && index_.back().offset >= it->offset) {
+    index_.pop_back();
+  }
+  segmentCrc_ = it->segmentCrc;
+  meta_.numEntries = it->numEntries;
+  meta_.firstIndex = it->firstIndex;
+  meta_.lastIndex = it->lastIndex;
+  meta_.lastTerm = it->lastTerm;
+  rewriteHs_ = rewriteHs_ || cutHs;
+  checkpoints_.erase(it, checkpoints_.end());
+  return Status::OK();
+}
+
+Status LogWriter::compressBatch(std::vector<Slice> *slices, size_t *dataLen, bool *compressed) {
+  // the records to be compressed, without the batch header.
+  std::vector<Slice> &records = records_;
+  records.assign(slices->begin(), slices->end());
+  records[0] = Slice(records[0].data() + kLogBatchHeaderSize,
+                     records[0].size() - kLogBatchHeaderSize);
+
+  std::string &body = compressedBody_;
+  body.clear();
+  body.push_back(static_cast<char>(compression_));
+  PutVarint32(&body, static_cast<uint32_t>(*dataLen));
+  RETURN_NOT_OK(Compress(compression_, records.data(), records.size(), &body));
+
+  std::string &header = compressedHeader_;
+  header.assign(kLogBatchHeaderSize, '\0');
+  header.push_back(static_cast<char>(kCompressedType));
+  PutVarint32(&header, static_cast<uint32_t>(body.size()));
+
+  // written as is if it's not compressible.
+  size_t len = header.size() - kLogBatchHeaderSize + body.size();
+  *compressed = len < *dataLen;
+  if (*compressed) {
+    slices->clear();
+    slices->emplace_back(header);
+    slices->emplace_back(body);
+    *dataLen = len;
+  }
+  return Status::OK();
+}
+
+void LogWriter::indexBatch(uint64_t idx, uint64_t offset) {
+  // the conflicting entries are overwritten, so are their index entries.
+  bool truncated = false;
+  while (!index_.empty() && index_.back().index >= idx) {
+    index_.pop_back();
+    truncated = true;
+  }
+  if (truncated || index_.empty() || offset - index_.back().offset >= kFooterIndexInterval) {
+    index_.push_back(SegmentIndexEntry{idx, offset});
+  }
+}
+
+Status LogWriter::writeFooter() {
+  SegmentFooter footer;
+  footer.firstIndex = meta_.firstIndex;
+  footer.lastIndex = meta_.lastIndex;
+  footer.numEntries = meta_.numEntries;
+  footer.index.swap(index_);
+  footer.checksum = segmentCrc_;
+  meta_.sealed = true;
+  meta_.checksum = segmentCrc_;
+
+  std::string body;
+  footer.EncodeTo(&body);
+
+  std::string &buf = scratch_;
+  buf.resize(kLogBatchHeaderSize);
+  buf.push_back(static_cast<char>(kFooterType));
+  PutLengthPrefixedSlice(&buf, body);
+  size_t dataLen = buf.size() - kLogBatchHeaderSize;
+  EncodeFixed32(&buf[4], static_cast<uint32_t>(dataLen));
+  EncodeFixed32(&buf[0], crc32c::Value(buf.data() + kLogBatchHeaderSize, dataLen));
+
+  PutFixed64(&buf, Size());
+  buf.append(kSegmentFooterMagic.data(), kSegmentFooterMagic.size());
+
+  Slice s(buf);
+  return write(&s, 1);
+}
+
+Status LogWriter::write(const Slice *data, size_t cnt) {
+  for (size_t i = 0; i < cnt; i++) {
+    segmentCrc_ = crc32c::Extend(segmentCrc_, data[i].data(), data[i].size());
+    bytesWritten_ += data[i].size();
+  }
+  if (file_->UseDirectIO()) {
+    return directWrite(data, cnt);
+  }
+  if (syncOnWrite_) {
+    return file_->AppendVAndSync(data, cnt);
+  }
+  return file_->AppendV(data, cnt);
+}
+
+Status LogWriter::directWrite(const Slice *data, size_t cnt) {
+  const size_t align = file_->GetRequiredBufferAlignment();
+  const uint64_t blockStart = directOffset_ / align * align;
+  const size_t tail = directOffset_ - blockStart;
+
+  size_t total = tail;
+  for (size_t i = 0; i < cnt; i++) {
+    total += data[i].size();
+  }
+  const size_t alignedSize = (total + align - 1) / align * align;
+
+  if (alignedBufCap_ < alignedSize) {
+    void *p;
+    size_t cap = std::max(alignedSize, alignedBufCap_ * 2);
+    if (posix_memalign(&p, align, cap) != 0) {
+      return FMT_Status(RuntimeError, "failed to allocate aligned buffer of {} bytes", cap);
+    }
+    if (tail > 0) {
+      memcpy(p, alignedBuf_.get(), tail);
+    }
+    alignedBuf_.reset(static_cast<char *>(p));
+    alignedBufCap_ = cap;
+  }
+
+  char *buf = alignedBuf_.get();
+  char *dst = buf + tail;
+  for (size_t i = 0; i < cnt; i++) {
+    memcpy(dst, data[i].data(), data[i].size());
+    dst += data[i].size();
+  }
+  memset(dst, 0, alignedSize - total);
+
+  RETURN_NOT_OK(file_->PositionedAppend(Slice(buf, alignedSize), blockStart));
+  directOffset_ = blockStart + total;
+
+  // keep the last partial block for the next write.
+  size_t newTail = total % align;
+  if (newTail > 0 && alignedSize > align) {
+    memcpy(buf, buf + alignedSize - align, newTail);
+  }
+  return Status::OK();
+}
+
 void LogWriter::saveHardState(const yaraft::pb::HardState &hs, char *dest, size_t *offset) {
-  char *p = dest;
-  p[0] = static_cast<char>(kHardStateType);
+  (*offset) += EncodeRecord<kFixedHardStateType>(hs, dest) - dest;
+}
+
+void LogWriter::saveTruncate(uint64_t idx, char *dest, size_t *offset) {
+  (*offset) += EncodeRecord<kTruncateType>(idx, dest) - dest;
+}
 
-  p = EncodeVarint32(p + 1, hs.ByteSize());
-  hs.SerializeToArray(p, hs.ByteSize());
+// Encodes the fields of `e` that precede `data` in the wire format, followed by the tag
+// and length of `data`. Appending the payload of `data` right after it forms exactly the
+// serialized entry, since protobuf serializes known fields in the order of field number.
+static uint8_t *encodeEntryPrefix(const yaraft::pb::Entry &e, uint8_t *p) {
+  using google::protobuf::io::CodedOutputStream;
+  using google::protobuf::internal::WireFormatLite;
 
-  (*offset) += p - dest + hs.ByteSize();
+  if (e.has_type()) {
+    p = CodedOutputStream::WriteTagToArray(
+        WireFormatLite::MakeTag(yaraft::pb::Entry::kTypeFieldNumber, WireFormatLite::WIRETYPE_VARINT),
+        p);
+    p = CodedOutputStream::WriteVarint32SignExtendedToArray(e.type(), p);
+  }
+  if (e.has_term()) {
+    p = CodedOutputStream::WriteTagToArray(
+        WireFormatLite::MakeTag(yaraft::pb::Entry::kTermFieldNumber, WireFormatLite::WIRETYPE_VARINT),
+        p);
+    p = CodedOutputStream::WriteVarint64ToArray(e.term(), p);
+  }
+  if (e.has_index()) {
+    p = CodedOutputStream::WriteTagToArray(
+        WireFormatLite::MakeTag(yaraft::pb::Entry::kIndexFieldNumber,
+                                WireFormatLite::WIRETYPE_VARINT),
+        p);
+    p = CodedOutputStream::WriteVarint64ToArray(e.index(), p);
+  }
+  p = CodedOutputStream::WriteTagToArray(
+      WireFormatLite::MakeTag(yaraft::pb::Entry::kDataFieldNumber,
+                              WireFormatLite::WIRETYPE_LENGTH_DELIMITED),
+      p);
+  return CodedOutputStream::WriteVarint32ToArray(static_cast<uint32_t>(e.data().size()), p);
 }
 
-void LogWriter::saveEntries(ConstPBEntriesIterator begin, ConstPBEntriesIterator end, char *dest,
-                            size_t *offset) {
-  char *p = dest;
+void LogWriter::saveEntries(ConstPBEntriesIterator begin, ConstPBEntriesIterator end,
+                            std::string *scratch, size_t *offset, std::vector<Slice> *slices) {
+  char *base = &(*scratch)[0];
+  char *p = base + *offset;
+  char *pieceStart = base;
   char type = static_cast<char>(kLogEntryType);
 
   for (auto it = begin; it != end; it++) {
     p[0] = type;
-    p = EncodeVarint32(p + 1, it->ByteSize());
-    it->SerializeToArray(p, it->ByteSize());
-    p += it->ByteSize();
+    p = EncodeVarint32(p + 1, it->GetCachedSize());
+
+    if (isZeroCopy(*it)) {
+      char *prefixStart = p;
+      p = reinterpret_cast<char *>(encodeEntryPrefix(*it, reinterpret_cast<uint8_t *>(p)));
+      DCHECK_EQ(p - prefixStart + it->data().size(), it->GetCachedSize());
+
+      slices->emplace_back(pieceStart, p - pieceStart);
+      slices->emplace_back(it->data());
+      pieceStart = p;
+    } else {
+      p = RecordCodec<kLogEntryType>::EncodeBody(*it, p);
+    }
   }
-  (*offset) += p - dest;
+
+  slices->emplace_back(pieceStart, p - pieceStart);
+  (*offset) = p - base;
 }
 
 }  // namespace wal
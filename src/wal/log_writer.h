@@ -16,10 +16,13 @@
 
 #include "base/env.h"
 #include "base/logging.h"
+#include "base/metrics.h"
 #include "wal/format.h"
 #include "wal/log_manager.h"
 #include "wal/segment_meta.h"
 
+#include <deque>
+
 #include <fmt/format.h>
 #include <silly/likely.h>
 
@@ -30,34 +33,125 @@ class LogWriter {
  public:
   // Create a log writer for the new log segment.
   static StatusWith<LogWriter *> New(LogManager *manager) {
-    uint64_t newSegId = manager->files_.size() + 1;
+    Metrics::Instance().walSegmentRollovers << 1;
+    uint64_t newSegId = manager->nextSegId_++;
     uint64_t newSegStart = manager->lastIndex_ + 1;
-    std::string fname = manager->options_.log_dir + "/" + SegmentFileName(newSegId, newSegStart);
-    FMT_LOG(INFO, "creating new segment segId: {}, firstId: {}", newSegId, newSegStart);
+    std::string name = SegmentFileName(newSegId, newSegStart);
+    std::string fname = manager->stripeDir(newSegId) + "/" + name;
+
+    const WriteAheadLogOptions &options = manager->options_;
+    bool directIO = options.use_direct_io;
+    WritableFile *wf = nullptr;
+    {
+      // the pool may be refilled in background.
+      std::lock_guard<std::mutex> g(manager->poolMu_);
+      if (!manager->segmentPool_.empty()) {
+        // the pooled segment is renamed, which stays in its directory.
+        const std::string &pooled = manager->segmentPool_.front();
+        fname = pooled.substr(0, pooled.rfind('/') + 1) + name;
+        ASSIGN_IF_OK(options.env->ReuseWritableFile(fname, pooled, directIO), wf);
+        manager->segmentPool_.pop_front();
+      }
+    }
+    FMT_LOG(INFO, "creating new segment {}, segId: {}, firstId: {}", fname, newSegId,
+            newSegStart);
+    if (wf && options.log_segment_pool_size == 0) {
+      // the spare segment created for background rollover has no space allocated.
+      Status s = wf->PreAllocate(options.log_segment_size);
+      if (UNLIKELY(!s.IsOK() && s.Code() != Error::NotSupported)) {
+        delete wf;
+        return s;
+      }
+    } else if (!wf) {
+      // A segment not recorded in the manifest has no data, it's left behind if the
+      // log crashed before the manifest was written, and can be safely overwritten.
+      ASSIGN_IF_OK(options.env->NewWritableFile(fname, Env::CREATE_IF_NON_EXISTING_TRUNCATE, false,
+                                                directIO),
+                   wf);
 
-    WritableFile *wf;
-    ASSIGN_IF_OK(Env::Default()->NewWritableFile(fname, Env::CREATE_NON_EXISTING), wf);
+      // allocate the space of the entire segment at once, rather than extending the
+      // file on every append.
+      Status s = wf->PreAllocate(options.log_segment_size);
+      if (UNLIKELY(!s.IsOK() && s.Code() != Error::NotSupported)) {
+        delete wf;
+        return s;
+      }
+    }
 
-    return new LogWriter(wf, fname, manager->options_.log_segment_size);
+    // a write that is always followed by a sync can be submitted together with it.
+    bool syncOnWrite = options.sync_policy == WriteAheadLogOptions::SYNC_EVERY_WRITE &&
+                       !options.group_commit && !options.background_sync;
+    CompressionType compression = options.compression == WriteAheadLogOptions::ZLIB_COMPRESSION
+                                      ? kZlibCompression
+                                      : kNoCompression;
+    return new LogWriter(wf, fname, options.log_segment_size, syncOnWrite, compression,
+                         options.compression_min_batch_size,
+                         options.rewrite_tail_on_conflict && !directIO);
   }
 
-  LogWriter(WritableFile *wf, const std::string &fname, size_t logSegmentSize)
-      : file_(wf), empty_(true), logSegmentSize_(logSegmentSize) {
+  // Batches of at least `minCompressSize` bytes are compressed with `compression`.
+  // See WriteAheadLogOptions::rewrite_tail_on_conflict for `rewriteTail`.
+  LogWriter(WritableFile *wf, const std::string &fname, size_t logSegmentSize,
+            bool syncOnWrite = false, CompressionType compression = kNoCompression,
+            size_t minCompressSize = 0, bool rewriteTail = false)
+      : file_(wf),
+        logSegmentSize_(logSegmentSize),
+        empty_(true),
+        syncOnWrite_(syncOnWrite),
+        compression_(compression),
+        minCompressSize_(minCompressSize),
+        segmentCrc_(0),
+        bytesWritten_(0),
+        rewriteTail_(rewriteTail),
+        lastHsOffset_(0),
+        rewriteHs_(false),
+        alignedBufCap_(0),
+        directOffset_(0) {
     meta_.fileName = fname;
   }
 
   // Append log entries in range [begin, end) & hard state into the underlying segment.
   // If the current write is beyond the configured segment size, it returns a
   // iterator points at the next entry to be appended.
+  // Entries conflicting with the ones already in the segment are preceded by a
+  // truncate record, unless the segment can be cut back before the conflicting ones.
   StatusWith<ConstPBEntriesIterator> Append(ConstPBEntriesIterator begin,
                                             ConstPBEntriesIterator end,
                                             const yaraft::pb::HardState *hs = nullptr);
 
   Status Sync() {
+    ScopedLatency latency(&Metrics::Instance().walSyncLatency);
     return file_->Sync();
   }
 
+  // Start writing back the dirty pages without waiting for completion.
+  Status Flush() {
+    return file_->Flush(WritableFile::FLUSH_ASYNC);
+  }
+
+  // Size of data written into the segment.
+  uint64_t Size() const {
+    return file_->UseDirectIO() ? directOffset_ : file_->Size();
+  }
+
+  // Total bytes ever written into the segment, including those cut off by overwrites.
+  uint64_t BytesWritten() const {
+    return bytesWritten_;
+  }
+
+  const SegmentMetaData &Meta() const {
+    return meta_;
+  }
+
+  // Write the footer, then seal the segment.
   Status Finish(SegmentMetaData *meta) {
+    if (!empty_) {
+      RETURN_NOT_OK(writeFooter());
+    }
+    if (file_->UseDirectIO()) {
+      // trim the padding of the last block.
+      RETURN_NOT_OK(file_->Truncate(directOffset_));
+    }
     RETURN_NOT_OK(file_->Sync());
     RETURN_NOT_OK(file_->Close());
 
@@ -66,10 +160,34 @@ class LogWriter {
   }
 
  private:
+  Status write(const Slice *data, size_t cnt);
+
+  // Writes through PositionedAppend from the aligned buffer, which starts with the
+  // last partial block written. The partial block is rewritten together with the
+  // new data, and the last block is padded with zeros.
+  Status directWrite(const Slice *data, size_t cnt);
+
+  Status writeFooter();
+
+  // Replace the batch in `slices` with the compressed one, if it's smaller.
+  Status compressBatch(std::vector<Slice> *slices, size_t *dataLen, bool *compressed);
+
+  // Add the batch at `offset` starting with entry `idx` to the footer index.
+  void indexBatch(uint64_t idx, uint64_t offset);
+
+  // Cut the segment back to the earliest recent batch whose entries are all
+  // overwritten by the ones from `idx` on, if there's one that is safe to cut.
+  Status rewindTo(uint64_t idx);
+
+  void saveTruncate(uint64_t idx, char *dest, size_t *offset);
+
   void saveHardState(const yaraft::pb::HardState &hs, char *dest, size_t *offset);
 
-  void saveEntries(ConstPBEntriesIterator begin, ConstPBEntriesIterator end, char *dest,
-                   size_t *offset);
+  // Serialize entries into `scratch` starting at `offset`, except that large payloads are
+  // referenced by `slices` rather than copied. `slices` covers the scratch from its
+  // beginning, including the batch header and the hard state.
+  void saveEntries(ConstPBEntriesIterator begin, ConstPBEntriesIterator end,
+                   std::string *scratch, size_t *offset, std::vector<Slice> *slices);
 
  private:
   friend class LogWriterTest;
@@ -81,6 +199,62 @@ class LogWriter {
   const size_t logSegmentSize_;
 
   bool empty_;
+
+  // whether every write is synced via AppendVAndSync.
+  const bool syncOnWrite_;
+
+  const CompressionType compression_;
+  const size_t minCompressSize_;
+
+  // states for the footer
+  std::vector<SegmentIndexEntry> index_;
+  uint32_t segmentCrc_;
+
+  uint64_t bytesWritten_;
+
+  // states for rewriting the tail in place, kept only if rewriteTail_.
+  // A checkpoint is where the segment can be cut back to: the start of a batch, whose
+  // first entry is `index`, and the states of the segment before it. The batches
+  // from the checkpoint on hold no entries before `index`, since checkpoints of the
+  // overwritten batches are dropped.
+  struct Checkpoint {
+    uint64_t index;
+    uint64_t offset;
+    uint32_t segmentCrc;
+    uint64_t numEntries;
+    uint64_t firstIndex;
+    uint64_t lastIndex;
+    uint64_t lastTerm;
+    bool hasHardState;
+    uint64_t hsTerm;
+    uint64_t hsVote;
+  };
+  const bool rewriteTail_;
+  std::deque<Checkpoint> checkpoints_;
+  // the last hard state written, at lastHsOffset_, valid if meta_.hasHardState.
+  yaraft::pb::HardState lastHs_;
+  uint64_t lastHsOffset_;
+  // set if lastHs_ is cut off, so it's written again with the next batch.
+  bool rewriteHs_;
+
+  // reusable buffers for encoding batches.
+  std::string scratch_;
+  std::vector<Slice> slices_;
+
+  // reusable buffers for compressing batches.
+  std::vector<Slice> records_;
+  std::string compressedHeader_;
+  std::string compressedBody_;
+
+  // states for direct I/O
+  struct FreeDeleter {
+    void operator()(char *p) {
+      free(p);
+    }
+  };
+  std::unique_ptr<char, FreeDeleter> alignedBuf_;
+  size_t alignedBufCap_;
+  uint64_t directOffset_;
 };
 
 }  // namespace wal
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "base/coding.h"
+#include "base/crc32c.h"
 #include "base/mock_env.h"
 #include "base/random.h"
 #include "base/testing.h"
@@ -20,6 +21,8 @@
 #include "wal/log_writer.h"
 #include "wal/readable_log_segment.h"
 
+#include <boost/crc.hpp>
+
 namespace consensus {
 namespace wal {
 
@@ -27,14 +30,18 @@ using namespace yaraft;
 
 class LogWriterTest : public BaseTest {
  public:
-  LogWriterTest() = default;
+  LogWriterTest() : rng_(SeedRandom()) {}
 
   // Initialize the max-segment-size to make it holds exactly `entriesInSegment` number of entries.
-  void InitLogSegment(size_t entriesInSegment) {
+  // If `dataSize` is non-zero, every other entry carries a payload of `dataSize` bytes.
+  void InitLogSegment(size_t entriesInSegment, size_t dataSize = 0) {
     entries.clear();
-    logSegmentSize = kLogSegmentHeaderMagic.size() + kLogBatchHeaderSize;
+    logSegmentSize = kLogSegmentHeaderMagic.size() + kChecksumTypeSize + kLogBatchHeaderSize;
     for (uint64_t i = 1; i <= entriesInSegment; i++) {
       entries.push_back(PBEntry().Index(i).Term(i).v);
+      if (dataSize > 0) {
+        entries.back().set_data(RandomString(i % 2 ? dataSize : 16, &rng_));
+      }
       logSegmentSize +=
           kRecordHeaderSize + VarintLength(entries.back().ByteSize()) + entries.back().ByteSize();
     }
@@ -59,9 +66,8 @@ class LogWriterTest : public BaseTest {
     ASSERT_EQ(metaData.numEntries, entriesInSegment);
   }
 
-  void TestEncodeAndDecode(size_t entriesInSegment) {
-    InitLogSegment(entriesInSegment);
-    bool verifyChecksum = true;
+  void TestEncodeAndDecode(size_t entriesInSegment, size_t dataSize = 0) {
+    InitLogSegment(entriesInSegment, dataSize);
 
     auto wf = new MockWritableFile;
     LogWriter writer(wf, "test-seg", logSegmentSize);
@@ -69,6 +75,62 @@ class LogWriterTest : public BaseTest {
 
     std::string fileData = wf->Data();
     ASSERT_EQ(fileData.size(), logSegmentSize);
+    DecodeAndVerify(fileData);
+  }
+
+  // Entries are written in several batches through direct I/O.
+  void TestDirectIOEncodeAndDecode(size_t entriesInSegment, size_t batchSize, size_t dataSize) {
+    InitLogSegment(entriesInSegment, dataSize);
+
+    // the segment is large enough to hold all batches.
+    auto wf = new MockWritableFile(true);
+    LogWriter writer(wf, "test-seg", 1024 * 1024 * 1024);
+    for (size_t i = 0; i < entries.size(); i += batchSize) {
+      auto end = entries.begin() + std::min(i + batchSize, entries.size());
+      ASSERT_OK(writer.Append(entries.begin() + i, end));
+      ASSERT_EQ(wf->Data().size() % wf->GetRequiredBufferAlignment(), 0);
+    }
+
+    ASSERT_EQ(writer.Size(),
+              logSegmentSize + (entries.size() + batchSize - 1) / batchSize * kLogBatchHeaderSize -
+                  kLogBatchHeaderSize);
+
+    SegmentMetaData metaData;
+    ASSERT_OK(writer.Finish(&metaData));
+    ASSERT_EQ(metaData.numEntries, entries.size());
+
+    DecodeAndVerify(wf->Data());
+  }
+
+  // Entries are written in batches of `batchSize`, and streamed from file in decoding.
+  void TestStreamingDecode(size_t entriesInSegment, size_t batchSize, size_t dataSize) {
+    InitLogSegment(entriesInSegment, dataSize);
+
+    auto wf = new MockWritableFile;
+    LogWriter writer(wf, "test-seg", 1024 * 1024 * 1024);
+    for (size_t i = 0; i < entries.size(); i += batchSize) {
+      auto end = entries.begin() + std::min(i + batchSize, entries.size());
+      ASSERT_OK(writer.Append(entries.begin() + i, end));
+    }
+    SegmentMetaData metaData;
+    ASSERT_OK(writer.Finish(&metaData));
+
+    MockRandomAccessFile rf(wf->Data());
+    SegmentContent content;
+    ReadableLogSegment seg(&rf, wf->Data().size(), &content, true);
+    ASSERT_OK(seg.ReadHeader());
+    while (!seg.Eof()) {
+      ASSERT_OK(seg.ReadRecord());
+    }
+
+    ASSERT_EQ(content.entries.size(), entries.size());
+    for (int i = 0; i < entries.size(); i++) {
+      ASSERT_EQ(content.entries[i].DebugString(), entries[i].DebugString());
+    }
+  }
+
+  void DecodeAndVerify(const std::string& fileData) {
+    bool verifyChecksum = true;
 
     SegmentMetaData meta;
     yaraft::MemoryStorage memStore;
@@ -87,9 +149,240 @@ class LogWriterTest : public BaseTest {
     }
   }
 
+  // Entries are written in batches of `batchSize`, each batch overwrites the
+  // last `overlap` entries of the previous one.
+  void TestFooter(size_t entriesInSegment, size_t batchSize, size_t overlap) {
+    InitLogSegment(entriesInSegment, 256);
+
+    auto wf = new MockWritableFile;
+    LogWriter writer(wf, "test-seg", 1024 * 1024 * 1024);
+
+    // offsets of the batches, and the first index of each
+    std::vector<std::pair<uint64_t, uint64_t>> batches;
+    EntryVec written;
+    for (size_t i = 0; i < entries.size();) {
+      auto end = entries.begin() + std::min(i + batchSize, entries.size());
+      // the first batch follows the segment header
+      uint64_t offset =
+          std::max<uint64_t>(writer.Size(), kLogSegmentHeaderMagic.size() + kChecksumTypeSize);
+      ASSERT_OK(writer.Append(entries.begin() + i, end));
+      batches.emplace_back(entries[i].index(), offset);
+      written.insert(written.end(), entries.begin() + i, end);
+
+      size_t next = end - entries.begin();
+      i = (next == entries.size() || next - i <= overlap) ? next : next - overlap;
+    }
+    SegmentMetaData metaData;
+    ASSERT_OK(writer.Finish(&metaData));
+    ASSERT_EQ(metaData.numEntries, written.size());
+    ASSERT_EQ(metaData.firstIndex, 1);
+    ASSERT_EQ(metaData.lastIndex, entries.size());
+
+    std::string fileData = wf->Data();
+    DecodeAndVerify(fileData);
+
+    SegmentFooter footer;
+    MockRandomAccessFile rf(fileData);
+    ASSERT_OK(ReadSegmentFooter(&rf, &footer));
+    ASSERT_EQ(footer.firstIndex, 1);
+    ASSERT_EQ(footer.lastIndex, entries.size());
+    ASSERT_EQ(footer.numEntries, written.size());
+    uint64_t footerOffset = DecodeFixed64(&fileData[fileData.size() - kSegmentFooterTrailerSize]);
+    ASSERT_EQ(footer.checksum, crc32c::Value(fileData.data(), footerOffset));
+
+    // every entry can be found by reading forward from the batch it seeks to.
+    for (const auto& e : entries) {
+      uint64_t offset = footer.Seek(e.index());
+      ASSERT_NE(offset, 0);
+      auto it = std::find_if(batches.begin(), batches.end(),
+                             [&](const std::pair<uint64_t, uint64_t>& b) {
+                               return b.second == offset;
+                             });
+      ASSERT_TRUE(it != batches.end());
+      ASSERT_LE(it->first, e.index());
+    }
+    ASSERT_EQ(footer.Seek(entries.size() + 1), 0);
+  }
+
+  // Entries [1, 10] of term 1 are written in batches of two, each with a hard state
+  // committing the previous batch, then the entries from `conflict` on are overwritten
+  // by three entries of term 2. If `termChanged`, the hard states from the batch
+  // holding `conflict` on are of term 2. `numEntries` is the number of entry records
+  // left in the segment, which tells where the segment is cut back to, if it is.
+  void TestOverwrite(uint64_t conflict, bool rewriteTail, bool termChanged, size_t numEntries) {
+    auto wf = new MockWritableFile;
+    LogWriter writer(wf, "test-seg", 1024 * 1024, false, kNoCompression, 0, rewriteTail);
+
+    pb::HardState hs;
+    for (uint64_t i = 1; i <= 10; i += 2) {
+      EntryVec batch{PBEntry().Index(i).Term(1).v, PBEntry().Index(i + 1).Term(1).v};
+      hs.set_term(termChanged && i + 1 >= conflict ? 2 : 1);
+      hs.set_vote(1);
+      hs.set_commit(i - 1);
+      ASSERT_OK(writer.Append(batch.begin(), batch.end(), &hs));
+    }
+
+    entries.clear();
+    for (uint64_t i = 1; i < conflict; i++) {
+      entries.push_back(PBEntry().Index(i).Term(1).v);
+    }
+    EntryVec overwrite;
+    for (uint64_t i = conflict; i < conflict + 3; i++) {
+      overwrite.push_back(PBEntry().Index(i).Term(2).v);
+    }
+    entries.insert(entries.end(), overwrite.begin(), overwrite.end());
+    ASSERT_OK(writer.Append(overwrite.begin(), overwrite.end()));
+
+    SegmentMetaData metaData;
+    ASSERT_OK(writer.Finish(&metaData));
+    ASSERT_EQ(metaData.numEntries, numEntries);
+    ASSERT_EQ(metaData.lastIndex, conflict + 2);
+    ASSERT_TRUE(metaData.hasHardState);
+
+    // the footer and checksums still match after the segment is cut.
+    std::string fileData = wf->Data();
+    DecodeAndVerify(fileData);
+
+    SegmentContent content;
+    ReadableLogSegment seg(fileData, &content, true);
+    ASSERT_OK(seg.ReadHeader());
+    while (!seg.Eof()) {
+      ASSERT_OK(seg.ReadRecord());
+    }
+    ASSERT_TRUE(content.meta.sealed);
+    ASSERT_EQ(content.meta.numEntries, numEntries);
+    ASSERT_EQ(content.entries.size(), entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+      ASSERT_EQ(content.entries[i].DebugString(), entries[i].DebugString());
+    }
+    // the last hard state survives the cut.
+    ASSERT_EQ(content.hs.DebugString(), hs.DebugString());
+  }
+
+  void TestNoFooter() {
+    InitLogSegment(100);
+
+    auto wf = new MockWritableFile;
+    LogWriter writer(wf, "test-seg", logSegmentSize);
+    ASSERT_OK(writer.Append(entries.begin(), entries.end()));
+
+    SegmentFooter footer;
+    MockRandomAccessFile rf(wf->Data());
+    ASSERT_EQ(ReadSegmentFooter(&rf, &footer).Code(), Error::NotFound);
+  }
+
+  void TestDecodeZeroFilledTail(size_t padding) {
+    InitLogSegment(100);
+
+    auto wf = new MockWritableFile;
+    LogWriter writer(wf, "test-seg", logSegmentSize);
+    ASSERT_OK(writer.Append(entries.begin(), entries.end()));
+
+    std::string fileData = wf->Data() + std::string(padding, '\0');
+
+    SegmentMetaData meta;
+    yaraft::MemoryStorage memStore;
+    ReadableLogSegment seg(fileData, &memStore, &meta, true);
+    seg.AllowUnwrittenTail();
+    ASSERT_OK(seg.ReadHeader());
+    while (!seg.Eof()) {
+      ASSERT_OK(seg.ReadRecord());
+    }
+    ASSERT_EQ(meta.numEntries, entries.size());
+
+    // zeros are corruption in a segment that's not written any more.
+    ASSERT_EQ(DecodeAll(fileData, false).Code(), Error::Corruption);
+
+    // and in the middle of a segment.
+    std::string batch = wf->Data().substr(kLogSegmentHeaderMagic.size() + kChecksumTypeSize);
+    ASSERT_EQ(DecodeAll(fileData + batch, true).Code(), Error::Corruption);
+  }
+
+  static Status DecodeAll(const std::string& fileData, bool allowUnwrittenTail) {
+    SegmentMetaData meta;
+    yaraft::MemoryStorage memStore;
+    ReadableLogSegment seg(fileData, &memStore, &meta, true);
+    if (allowUnwrittenTail) {
+      seg.AllowUnwrittenTail();
+    }
+    RETURN_NOT_OK(seg.ReadHeader());
+    while (!seg.Eof()) {
+      RETURN_NOT_OK(seg.ReadRecord());
+    }
+    return Status::OK();
+  }
+
+  void TestDecodeLegacySegment(size_t entriesInSegment) {
+    InitLogSegment(entriesInSegment);
+
+    auto wf = new MockWritableFile;
+    LogWriter writer(wf, "test-seg", logSegmentSize);
+    ASSERT_OK(writer.Append(entries.begin(), entries.end()));
+
+    // rewrite the segment in legacy format
+    std::string batch = wf->Data().substr(kLogSegmentHeaderMagic.size() + kChecksumTypeSize);
+    boost::crc_32_type crc;
+    crc.process_bytes(&batch[kLogBatchHeaderSize], batch.size() - kLogBatchHeaderSize);
+    EncodeFixed32(&batch[0], static_cast<uint32_t>(crc.checksum()));
+
+    DecodeAndVerify(kLegacyLogSegmentHeaderMagic.ToString() + batch);
+  }
+
+  // Entries are written in batches of `batchSize` with compression, in which only
+  // the batches of at least `minCompressSize` bytes are compressed.
+  void TestCompressedEncodeAndDecode(size_t entriesInSegment, size_t batchSize,
+                                     size_t minCompressSize, bool compressible) {
+    InitLogSegment(entriesInSegment, compressible ? 0 : 512);
+    if (compressible) {
+      for (auto& e : entries) {
+        e.set_data(std::string(512, static_cast<char>('a' + e.index() % 26)));
+      }
+    }
+
+    auto plain = new MockWritableFile;
+    LogWriter plainWriter(plain, "test-seg", 1024 * 1024 * 1024);
+    auto wf = new MockWritableFile;
+    LogWriter writer(wf, "test-seg", 1024 * 1024 * 1024, false, kZlibCompression,
+                     minCompressSize);
+    for (size_t i = 0; i < entries.size(); i += batchSize) {
+      auto end = entries.begin() + std::min(i + batchSize, entries.size());
+      ASSERT_OK(plainWriter.Append(entries.begin() + i, end));
+      ASSERT_OK(writer.Append(entries.begin() + i, end));
+    }
+    SegmentMetaData metaData;
+    ASSERT_OK(writer.Finish(&metaData));
+    ASSERT_EQ(metaData.numEntries, entries.size());
+    ASSERT_OK(plainWriter.Finish(&metaData));
+
+    if (!compressible) {
+      // a batch is never larger than it's written as is.
+      ASSERT_LE(wf->Data().size(), plain->Data().size());
+    } else if (batchSize * 512 >= minCompressSize) {
+      ASSERT_LT(wf->Data().size(), plain->Data().size() / 4);
+    } else {
+      ASSERT_EQ(wf->Data(), plain->Data());
+    }
+
+    DecodeAndVerify(wf->Data());
+
+    MockRandomAccessFile rf(wf->Data());
+    SegmentContent content;
+    ReadableLogSegment seg(&rf, wf->Data().size(), &content, true);
+    ASSERT_OK(seg.ReadHeader());
+    while (!seg.Eof()) {
+      ASSERT_OK(seg.ReadRecord());
+    }
+    ASSERT_TRUE(content.meta.sealed);
+    ASSERT_EQ(content.entries.size(), entries.size());
+    for (int i = 0; i < entries.size(); i++) {
+      ASSERT_EQ(content.entries[i].DebugString(), entries[i].DebugString());
+    }
+  }
+
  private:
   EntryVec entries;
   size_t logSegmentSize;
+  Random rng_;
 };
 
 // LogWriterTest.AppendEntries ensures that LogWriter::AppendEntries stops writing
@@ -113,5 +406,80 @@ TEST_F(LogWriterTest, EncodeAndDecode) {
   TestEncodeAndDecode(10000);
 }
 
+// This test verifies that data written through direct I/O can be decoded correctly.
+TEST_F(LogWriterTest, DirectIOEncodeAndDecode) {
+  TestDirectIOEncodeAndDecode(100, 1, 0);
+  TestDirectIOEncodeAndDecode(1000, 7, 0);
+  TestDirectIOEncodeAndDecode(200, 10, 1024);
+  TestDirectIOEncodeAndDecode(100, 100, 10 * 1024);
+}
+
+// This test verifies that segments of the legacy format, which are checksummed by
+// crc32 and have no checksum type in header, can still be decoded.
+TEST_F(LogWriterTest, DecodeLegacySegment) {
+  TestDecodeLegacySegment(10);
+  TestDecodeLegacySegment(1000);
+}
+
+// This test verifies that LogWriter::Finish writes a footer, whose index
+// locates the batch of every entry, even if entries are overwritten.
+TEST_F(LogWriterTest, Footer) {
+  TestFooter(10, 1, 0);
+  TestFooter(1000, 10, 0);
+  TestFooter(1000, 20, 5);
+  TestFooter(100, 100, 0);
+}
+
+// This test verifies that the conflicting entries overwritten by a follower are
+// discarded on decoding, either by the truncate record, or by cutting the segment
+// back, which is never done past a hard state that changed the term.
+TEST_F(LogWriterTest, Overwrite) {
+  TestOverwrite(7, false, false, 13);
+  TestOverwrite(7, true, false, 9);
+  TestOverwrite(8, true, false, 11);
+  TestOverwrite(7, true, true, 13);
+  TestOverwrite(8, true, true, 11);
+}
+
+// This test verifies that a segment without footer, which is not finished,
+// is reported as NotFound.
+TEST_F(LogWriterTest, NoFooter) {
+  TestNoFooter();
+}
+
+// This test verifies that the zero-filled tail of a preallocated segment, which is
+// left behind by a crash, is ignored in decoding only if the segment may be unwritten
+// there, and nothing but zeros follows.
+TEST_F(LogWriterTest, DecodeZeroFilledTail) {
+  TestDecodeZeroFilledTail(3);
+  TestDecodeZeroFilledTail(8);
+  TestDecodeZeroFilledTail(4096);
+}
+
+// This test verifies that a segment can be decoded while being streamed from file,
+// including the batches that are larger than the read buffer.
+TEST_F(LogWriterTest, StreamingDecode) {
+  TestStreamingDecode(1000, 10, 0);
+  TestStreamingDecode(2000, 10, 4 * 1024);
+  TestStreamingDecode(1000, 500, 8 * 1024);
+}
+
+// This test verifies that entries with large payload, which are written without
+// being copied into the batch, can be decoded correctly.
+TEST_F(LogWriterTest, EncodeAndDecodeLargeEntries) {
+  TestEncodeAndDecode(10, 10 * 1024);
+  TestEncodeAndDecode(200, 1024);
+  TestEncodeAndDecode(2000, 4 * 1024);
+}
+
+// This test verifies that compressed batches are decoded transparently, along
+// with the batches written as is, which are either small or incompressible.
+TEST_F(LogWriterTest, CompressedEncodeAndDecode) {
+  TestCompressedEncodeAndDecode(1000, 10, 0, true);
+  TestCompressedEncodeAndDecode(1000, 100, 4096, true);
+  TestCompressedEncodeAndDecode(1000, 5, 4096, true);
+  TestCompressedEncodeAndDecode(500, 50, 0, false);
+}
+
 }  // namespace wal
 }  // namespace consensus
\ No newline at end of file
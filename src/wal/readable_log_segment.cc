@@ -14,29 +14,95 @@
 
 #include "wal/readable_log_segment.h"
 #include "base/coding.h"
+#include "base/crc32c.h"
 #include "base/env_util.h"
 #include "base/logging.h"
+#include "wal/compression.h"
 #include "wal/format.h"
+#include "wal/record_codec.h"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
 #include <boost/crc.hpp>
 
 namespace consensus {
 namespace wal {
 
+// The whole segment is about to be read in order: enlarge the readahead and start
+// reading it in background, so the disk stays busy while the batches are decoded.
+static void adviseScan(RandomAccessFile *file) {
+  WARN_NOT_OK(file->Advise(RandomAccessFile::SEQUENTIAL), "RandomAccessFile::Advise");
+  WARN_NOT_OK(file->Advise(RandomAccessFile::WILL_NEED), "RandomAccessFile::Advise");
+}
+
+// The entries decoded are kept in memory from now on, the pages of the segment
+// needn't stay in the page cache.
+static void adviseConsumed(RandomAccessFile *file) {
+  WARN_NOT_OK(file->Advise(RandomAccessFile::DONT_NEED), "RandomAccessFile::Advise");
+}
+
 Status ReadSegmentIntoMemoryStorage(const Slice &fname, yaraft::MemoryStorage *memStore,
                                     SegmentMetaData *metaData, bool verifyChecksum) {
   LOG_ASSERT(memStore != nullptr);
 
-  char *buf;
-  Slice s;
-  RETURN_NOT_OK(env_util::ReadFullyToBuffer(fname, &s, &buf));
+  RandomAccessFile *rf;
+  ASSIGN_IF_OK(Env::Default()->NewRandomAccessFile(fname), rf);
+  std::unique_ptr<RandomAccessFile> file(rf);
 
-  ReadableLogSegment seg(s, memStore, metaData, verifyChecksum);
+  uint64_t fsize;
+  ASSIGN_IF_OK(file->Size(), fsize);
+  adviseScan(rf);
+
+  ReadableLogSegment seg(rf, fsize, memStore, metaData, verifyChecksum);
   RETURN_NOT_OK_APPEND(seg.ReadHeader(), fmt::format(" [segment: {}] ", fname.ToString()));
   while (!seg.Eof()) {
     RETURN_NOT_OK_APPEND(seg.ReadRecord(), fmt::format(" [segment: {}] ", fname.ToString()));
   }
 
+  adviseConsumed(rf);
+  return Status::OK();
+}
+
+Status ReadSegment(Env *env, const Slice &fname, SegmentContent *content, bool verifyChecksum,
+                   const uint32_t *sealedChecksum, bool tolerateTornTail,
+                   bool allowUnwrittenTail) {
+  RandomAccessFile *rf;
+  ASSIGN_IF_OK(env->NewRandomAccessFile(fname), rf);
+  std::unique_ptr<RandomAccessFile> file(rf);
+
+  uint64_t fsize;
+  ASSIGN_IF_OK(file->Size(), fsize);
+
+  if ((verifyChecksum && sealedChecksum) || allowUnwrittenTail) {
+    SegmentFooter footer;
+    bool hasFooter = ReadSegmentFooter(rf, &footer).IsOK();
+    if (hasFooter && verifyChecksum && sealedChecksum && footer.checksum == *sealedChecksum) {
+      verifyChecksum = false;
+    }
+    // a sealed segment has been written up to its footer.
+    if (hasFooter) {
+      allowUnwrittenTail = false;
+    }
+  }
+
+  adviseScan(rf);
+  ReadableLogSegment seg(rf, fsize, content, verifyChecksum);
+  if (tolerateTornTail) {
+    seg.TolerateTornTail();
+  }
+  if (allowUnwrittenTail) {
+    seg.AllowUnwrittenTail();
+  }
+  RETURN_NOT_OK_APPEND(seg.ReadHeader(), fmt::format(" [segment: {}] ", fname.ToString()));
+  while (!seg.Eof()) {
+    RETURN_NOT_OK_APPEND(seg.ReadRecord(), fmt::format(" [segment: {}] ", fname.ToString()));
+  }
+  adviseConsumed(rf);
+
+  content->meta.fileName = fname.ToString();
+  content->torn = seg.Torn();
+  content->validSize = seg.ValidSize();
   return Status::OK();
 }
 
@@ -44,32 +110,118 @@ Status ReadableLogSegment::ReadHeader() {
   // check magic
   RETURN_NOT_OK_APPEND(checkRemain(kLogSegmentHeaderMagic.size()), "[bad magic length]");
   Slice magic(buf_, kLogSegmentHeaderMagic.size());
+  if (kLegacyLogSegmentHeaderMagic.Compare(magic) == 0) {
+    checksumType_ = kCRC32;
+    advance(kLegacyLogSegmentHeaderMagic.size());
+    validSize_ = consumed_;
+    return Status::OK();
+  }
   if (UNLIKELY(kLogSegmentHeaderMagic.Compare(magic) != 0)) {
     return FMT_Status(Corruption, "bad header magic: {}", magic.ToString());
   }
   advance(kLogSegmentHeaderMagic.size());
 
+  RETURN_NOT_OK_APPEND(checkRemain(kChecksumTypeSize), "[bad checksum type length]");
+  auto type = static_cast<ChecksumType>(buf_[0]);
+  if (UNLIKELY(type != kCRC32 && type != kCRC32C)) {
+    return FMT_Status(Corruption, "unknown checksum type: {}", static_cast<int>(type));
+  }
+  checksumType_ = type;
+  advance(kChecksumTypeSize);
+  validSize_ = consumed_;
+
   return Status::OK();
 }
 
 Status ReadableLogSegment::ReadRecord() {
+  RETURN_NOT_OK(ensure(kLogBatchHeaderSize));
+  if (remain_ < kLogBatchHeaderSize && isZeroFilled(buf_, remain_)) {
+    return skipUnwrittenTail();
+  }
+  if (tolerateTornTail_ && remain_ < kLogBatchHeaderSize) {
+    return dropTornTail("bad batch header");
+  }
   RETURN_NOT_OK_APPEND(checkRemain(kLogBatchHeaderSize), " [bad batch header] ");
 
   uint32_t crc = DecodeFixed32(buf_);
   uint32_t len = DecodeFixed32(buf_ + 4);
+  if (len == 0) {
+    // A batch contains at least one record, so we have reached the preallocated space
+    // that's not written yet, which is left behind if the segment was not closed properly.
+    return skipUnwrittenTail();
+  }
+  uint32_t crcBeforeBatch = segmentCrc_;
   advance(kLogBatchHeaderSize);
 
+  if (tolerateTornTail_ && len > remain_ + fileRemain_) {
+    return dropTornTail(fmt::format("batch of {} bytes beyond the end of segment", len));
+  }
   RETURN_NOT_OK_APPEND(checkRemain(len), " [bad batch length] ");
 
-  if (verifyChecksum_) {
-    boost::crc_32_type crc32;
-    crc32.process_bytes(buf_, len);
-    if (crc32.checksum() != crc) {
-      return FMT_Status(Corruption, "bad checksum");
+  if ((verifyChecksum_ || (tolerateTornTail_ && isLastBatch(len))) && checksum(buf_, len) != crc) {
+    if (tolerateTornTail_ && restZeroFilled(len)) {
+      return dropTornTail("bad checksum");
+    }
+    return FMT_Status(Corruption, "bad checksum");
+  }
+
+  bool sealed = false;
+  RETURN_NOT_OK(decodeRecords(Slice(buf_, len), crcBeforeBatch, false, &sealed));
+  flushToMemStore();
+  if (sealed) {
+    skipAll();
+    return Status::OK();
+  }
+  advance(len);
+  validSize_ = consumed_;
+
+  return Status::OK();
+}
+
+Status ReadableLogSegment::dropTornTail(const std::string &reason) {
+  FMT_LOG(WARNING, "dropping the torn batch at offset {} of segment {}: {}", validSize_,
+          file_ ? file_->filename() : "<memory>", reason);
+  torn_ = true;
+  skipAll();
+  return Status::OK();
+}
+
+Status ReadableLogSegment::skipUnwrittenTail() {
+  if (!allowUnwrittenTail_) {
+    return FMT_Status(Corruption, "zero-filled batch header at offset {}", consumed_);
+  }
+  uint64_t offset = consumed_;
+  if (!restZeroFilled(0)) {
+    return FMT_Status(Corruption, "data follows the zero-filled space at offset {}", offset);
+  }
+  skipAll();
+  return Status::OK();
+}
+
+bool ReadableLogSegment::isLastBatch(size_t len) {
+  if (!ensure(len + kLogBatchHeaderSize).IsOK()) {
+    return true;
+  }
+  // a zero length is where the unwritten space begins, see ReadRecord.
+  return remain_ < len + kLogBatchHeaderSize || DecodeFixed32(buf_ + len + 4) == 0;
+}
+
+bool ReadableLogSegment::restZeroFilled(size_t from) {
+  if (!isZeroFilled(buf_ + from, remain_ - from)) {
+    return false;
+  }
+  remain_ = 0;
+  while (fileRemain_ > 0) {
+    if (!ensure(kReadChunkSize).IsOK() || !isZeroFilled(buf_, remain_)) {
+      return false;
     }
+    remain_ = 0;
   }
+  return true;
+}
 
-  Slice record(buf_, len);
+Status ReadableLogSegment::decodeRecords(Slice record, uint32_t crcBeforeBatch, bool compressed,
+                                         bool *sealed) {
   while (record.Len() > 0) {
     auto type = static_cast<RecordType>(record[0]);
     record.Skip(kRecordHeaderSize);
@@ -79,27 +231,248 @@ Status ReadableLogSegment::ReadRecord() {
       return Status::Make(Error::Corruption, "bad record");
     }
 
-    if (type == kLogEntryType) {
-      yaraft::pb::Entry e;
-      e.ParseFromArray(data.RawData(), data.Len());
-      memStore_->Append(e);
-      metaData_->numEntries++;
-    } else if (type == kHardStateType) {
-      yaraft::pb::HardState hs;
-      hs.ParseFromArray(data.RawData(), data.Len());
-      memStore_->SetHardState(hs);
+    switch (type) {
+      case kLogEntryType: {
+        yaraft::pb::Entry e;
+        if (UNLIKELY(!RecordCodec<kLogEntryType>::Decode(data, &e))) {
+          return Status::Make(Error::Corruption, "bad log entry record");
+        }
+        if (metaData_->numEntries == 0 || e.index() < metaData_->firstIndex) {
+          metaData_->firstIndex = e.index();
+        }
+        metaData_->lastIndex = e.index();
+        metaData_->lastTerm = e.term();
+        metaData_->numEntries++;
+        if (memStore_) {
+          if (!pending_.empty() && e.index() != pending_.back().index() + 1) {
+            flushToMemStore();
+          }
+          // Swap hands the parsed payload over without copying, whether or not the
+          // protobuf in use has move constructors.
+          pending_.emplace_back();
+          pending_.back().Swap(&e);
+        } else {
+          RETURN_NOT_OK(appendToContent(std::move(e)));
+        }
+        break;
+      }
+      case kFixedHardStateType:
+      case kHardStateType: {
+        yaraft::pb::HardState hs;
+        bool ok = type == kFixedHardStateType
+                      ? RecordCodec<kFixedHardStateType>::Decode(data, &hs)
+                      : RecordCodec<kHardStateType>::Decode(data, &hs);
+        if (UNLIKELY(!ok)) {
+          return Status::Make(Error::Corruption, "bad hard state record");
+        }
+        metaData_->hasHardState = true;
+        if (memStore_) {
+          memStore_->SetHardState(hs);
+        } else {
+          content_->hs = std::move(hs);
+        }
+        break;
+      }
+      case kTruncateType: {
+        uint64_t idx;
+        if (UNLIKELY(!RecordCodec<kTruncateType>::Decode(data, &idx))) {
+          return Status::Make(Error::Corruption, "bad truncate record");
+        }
+        truncateFrom(idx);
+        break;
+      }
+      case kCompressedType:
+        if (UNLIKELY(compressed)) {
+          return Status::Make(Error::Corruption, "nested compressed records");
+        }
+        RETURN_NOT_OK(decodeCompressed(data));
+        break;
+      case kFooterType:
+        if (UNLIKELY(compressed)) {
+          return Status::Make(Error::Corruption, "compressed segment footer");
+        }
+        // the footer is the last batch, followed only by the trailer.
+        RETURN_NOT_OK(readFooter(data, crcBeforeBatch));
+        *sealed = true;
+        return Status::OK();
+      default:
+        // the records unknown to this reader are skipped, see format.h.
+        break;
     }
   }
-  advance(len);
+  return Status::OK();
+}
 
+Status ReadableLogSegment::decodeCompressed(Slice data) {
+  if (UNLIKELY(data.Len() < 1)) {
+    return Status::Make(Error::Corruption, "bad compressed record");
+  }
+  auto type = static_cast<CompressionType>(data[0]);
+  data.Skip(1);
+
+  uint32_t rawLength;
+  if (UNLIKELY(!GetVarint32(&data, &rawLength))) {
+    return Status::Make(Error::Corruption, "bad length of compressed record");
+  }
+
+  // the decompressed data stays valid until the next compressed record.
+  uncompressed_.clear();
+  RETURN_NOT_OK(Uncompress(type, data, rawLength, &uncompressed_));
+  bool sealed = false;
+  return decodeRecords(Slice(uncompressed_), 0, true, &sealed);
+}
+
+Status ReadableLogSegment::readFooter(const Slice &data, uint32_t crc) {
+  SegmentFooter footer;
+  RETURN_NOT_OK(footer.DecodeFrom(data));
+  if (footer.numEntries != metaData_->numEntries) {
+    return FMT_Status(Corruption, "segment footer has {} entries, but {} are read",
+                      footer.numEntries, metaData_->numEntries);
+  }
+  if (verifyChecksum_ && crc != footer.checksum) {
+    return FMT_Status(Corruption, "bad segment checksum");
+  }
+  metaData_->sealed = true;
+  metaData_->checksum = footer.checksum;
   return Status::OK();
 }
 
+Status ReadSegmentFooter(RandomAccessFile *file, SegmentFooter *footer) {
+  uint64_t fsize;
+  ASSIGN_IF_OK(file->Size(), fsize);
+  if (fsize < kSegmentFooterTrailerSize) {
+    return FMT_Status(NotFound, "no footer in segment {}", file->filename());
+  }
+
+  char trailer[kSegmentFooterTrailerSize];
+  Slice s;
+  RETURN_NOT_OK(env_util::ReadFully(file, fsize - kSegmentFooterTrailerSize,
+                                    kSegmentFooterTrailerSize, &s, trailer));
+  if (kSegmentFooterMagic.Compare(Slice(trailer + 8, kSegmentFooterMagic.size())) != 0) {
+    return FMT_Status(NotFound, "no footer in segment {}", file->filename());
+  }
+
+  uint64_t offset = DecodeFixed64(trailer);
+  if (offset + kLogBatchHeaderSize + kSegmentFooterTrailerSize > fsize) {
+    return FMT_Status(Corruption, "bad footer offset {} in segment {}", offset, file->filename());
+  }
+  size_t n = fsize - kSegmentFooterTrailerSize - offset;
+  std::unique_ptr<char[]> buf(new char[n]);
+  RETURN_NOT_OK(env_util::ReadFully(file, offset, n, &s, buf.get()));
+
+  uint32_t crc = DecodeFixed32(s.data());
+  uint32_t len = DecodeFixed32(s.data() + 4);
+  Slice record(s.data() + kLogBatchHeaderSize, n - kLogBatchHeaderSize);
+  if (len != record.size() || crc32c::Value(record.data(), record.size()) != crc) {
+    return FMT_Status(Corruption, "bad footer checksum in segment {}", file->filename());
+  }
+
+  Slice data;
+  if (static_cast<RecordType>(record[0]) != kFooterType) {
+    return FMT_Status(Corruption, "bad footer record in segment {}", file->filename());
+  }
+  record.Skip(kRecordHeaderSize);
+  if (UNLIKELY(!GetLengthPrefixedSlice(&record, &data))) {
+    return FMT_Status(Corruption, "bad footer record in segment {}", file->filename());
+  }
+  footer->offset = offset;
+  return footer->DecodeFrom(data);
+}
+
+Status ReadableLogSegment::appendToContent(yaraft::pb::Entry &&e) {
+  yaraft::EntryVec &vec = content_->entries;
+  if (!vec.empty()) {
+    if (UNLIKELY(e.term() < vec.back().term())) {
+      return FMT_Status(
+          Corruption,
+          "entry [index:{}, term:{}] has lower term than the previous one [index:{}, term:{}]",
+          e.index(), e.term(), vec.back().index(), vec.back().term());
+    }
+    if (e.index() <= vec.back().index()) {
+      // entries are ordered by index, since any conflict has been resolved.
+      auto it = std::lower_bound(
+          vec.begin(), vec.end(), e.index(),
+          [](const yaraft::pb::Entry &x, uint64_t idx) { return x.index() < idx; });
+      vec.erase(it, vec.end());
+    }
+  }
+  vec.emplace_back();
+  vec.back().Swap(&e);
+  return Status::OK();
+}
+
+void ReadableLogSegment::truncateFrom(uint64_t idx) {
+  auto byIndex = [](const yaraft::pb::Entry &x, uint64_t i) { return x.index() < i; };
+  if (memStore_) {
+    flushToMemStore();
+    // the first entry of memstore is the dummy one at the compacted index.
+    yaraft::EntryVec &vec = memStore_->TEST_Entries();
+    vec.erase(std::lower_bound(std::next(vec.begin()), vec.end(), idx, byIndex), vec.end());
+  } else {
+    yaraft::EntryVec &vec = content_->entries;
+    vec.erase(std::lower_bound(vec.begin(), vec.end(), idx, byIndex), vec.end());
+  }
+}
+
+void ReadableLogSegment::flushToMemStore() {
+  if (!pending_.empty()) {
+    // the conflicting entries in memstore are truncated once for the run.
+    memStore_->Append(std::move(pending_));
+    pending_.clear();
+  }
+}
+
+uint32_t ReadableLogSegment::checksum(const char *data, size_t len) const {
+  if (checksumType_ == kCRC32C) {
+    return crc32c::Value(data, len);
+  }
+  boost::crc_32_type crc32;
+  crc32.process_bytes(data, len);
+  return static_cast<uint32_t>(crc32.checksum());
+}
+
+bool ReadableLogSegment::isZeroFilled(const char *p, size_t n) {
+  return std::all_of(p, p + n, [](char c) { return c == 0; });
+}
+
 bool ReadableLogSegment::Eof() {
-  return remain_ == 0;
+  return remain_ == 0 && fileRemain_ == 0;
+}
+
+Status ReadableLogSegment::ensure(size_t need) {
+  if (remain_ >= need || fileRemain_ == 0) {
+    return Status::OK();
+  }
+
+  // move the unconsumed data to the front of the chunk, which is enlarged if
+  // it can't hold `need` bytes.
+  size_t cap = std::max(need, kReadChunkSize);
+  if (chunkCap_ < cap) {
+    std::unique_ptr<char[]> chunk(new char[cap]);
+    memcpy(chunk.get(), buf_, remain_);
+    chunk_.swap(chunk);
+    chunkCap_ = cap;
+  } else {
+    memmove(chunk_.get(), buf_, remain_);
+  }
+  buf_ = chunk_.get();
+
+  size_t n = static_cast<size_t>(std::min<uint64_t>(chunkCap_ - remain_, fileRemain_));
+  Slice s;
+  RETURN_NOT_OK(env_util::ReadFully(file_, fileOffset_, n, &s, chunk_.get() + remain_));
+  fileOffset_ += n;
+  fileRemain_ -= n;
+  remain_ += n;
+  return Status::OK();
+}
+
+void ReadableLogSegment::skipAll() {
+  remain_ = 0;
+  fileRemain_ = 0;
 }
 
 Status ReadableLogSegment::checkRemain(size_t need) {
+  RETURN_NOT_OK(ensure(need));
   if (UNLIKELY(remain_ < need)) {
     return FMT_Status(Corruption, "segment is too small to contain {} number of bytes", need);
   }
@@ -107,9 +480,132 @@ Status ReadableLogSegment::checkRemain(size_t need) {
 }
 
 void ReadableLogSegment::advance(size_t size) {
+  if (verifyChecksum_) {
+    segmentCrc_ = crc32c::Extend(segmentCrc_, buf_, size);
+  }
   remain_ -= size;
   buf_ += size;
+  consumed_ += size;
+}
+
+StatusWith<SealedSegmentReader *> SealedSegmentReader::Open(Env *env, const SegmentMetaData &meta,
+                                                            uint64_t cacheId) {
+  RandomAccessFile *rf;
+  ASSIGN_IF_OK(env->NewRandomAccessFile(meta.fileName), rf);
+  std::unique_ptr<RandomAccessFile> file(rf);
+
+  SegmentFooter footer;
+  RETURN_NOT_OK_APPEND(ReadSegmentFooter(rf, &footer),
+                       fmt::format(" [segment: {}] ", meta.fileName));
+  if (footer.index.empty()) {
+    return FMT_Status(Corruption, "no index in the footer of segment {}", meta.fileName);
+  }
+
+  // the checksum type is determined by the segment header.
+  char buf[kLogSegmentHeaderMagic.size() + kChecksumTypeSize];
+  Slice s;
+  RETURN_NOT_OK(env_util::ReadFully(rf, 0, sizeof(buf), &s, buf));
+  SegmentContent content;
+  ReadableLogSegment seg(s, &content, false);
+  RETURN_NOT_OK_APPEND(seg.ReadHeader(), fmt::format(" [segment: {}] ", meta.fileName));
+
+  return new SealedSegmentReader(file.release(), std::move(footer), seg.GetChecksumType(),
+                                 cacheId);
+}
+
+Status SealedSegmentReader::Read(uint64_t lo, uint64_t hi, uint64_t maxBytes, BlockCache *cache,
+                                 yaraft::EntryVec *entries, uint64_t *bytes) {
+  const auto &index = footer_.index;
+  auto it = std::upper_bound(index.begin(), index.end(), lo,
+                             [](uint64_t i, const SegmentIndexEntry &e) { return i < e.index; });
+  if (it == index.begin()) {
+    return FMT_Status(OutOfBound, "entry {} is not in segment {}", lo, file_->filename());
+  }
+  size_t first = std::distance(index.begin(), it) - 1;
+  readAhead(first, hi, maxBytes, cache);
+
+  for (size_t i = first; i < index.size() && lo < hi; i++) {
+    BlockCache::Block block;
+    RETURN_NOT_OK(readBlock(i, cache, &block));
+
+    for (const auto &e : *block) {
+      if (e.index() < lo) {
+        continue;
+      }
+      if (e.index() >= hi) {
+        break;
+      }
+      uint64_t size = e.ByteSize();
+      if (!entries->empty() && *bytes + size > maxBytes) {
+        return Status::OK();
+      }
+      entries->push_back(e);
+      *bytes += size;
+      lo = e.index() + 1;
+    }
+  }
+  return Status::OK();
+}
+
+void SealedSegmentReader::readAhead(size_t first, uint64_t hi, uint64_t maxBytes,
+                                    BlockCache *cache) {
+  const auto &index = footer_.index;
+  auto it = std::upper_bound(index.begin(), index.end(), hi - 1,
+                             [](uint64_t i, const SegmentIndexEntry &e) { return i < e.index; });
+  size_t last = std::distance(index.begin(), it) - 1;
+  if (last <= first || (cache && cache->Lookup(cacheId_, index[first].offset))) {
+    return;
+  }
+
+  // the following blocks are read into the page cache while the former are decoded.
+  uint64_t begin = index[first].offset;
+  uint64_t end = last + 1 < index.size() ? index[last + 1].offset : footer_.offset;
+  WARN_NOT_OK(file_->Advise(RandomAccessFile::WILL_NEED, begin, std::min(end - begin, maxBytes)),
+              "RandomAccessFile::Advise");
+}
+
+Status SealedSegmentReader::readBlock(size_t i, BlockCache *cache, BlockCache::Block *block) {
+  const auto &index = footer_.index;
+  uint64_t offset = index[i].offset;
+  if (cache) {
+    *block = cache->Lookup(cacheId_, offset);
+    if (*block) {
+      return Status::OK();
+    }
+  }
+
+  uint64_t end = i + 1 < index.size() ? index[i + 1].offset : footer_.offset;
+  std::unique_ptr<char[]> buf(new char[end - offset]);
+  Slice s;
+  RETURN_NOT_OK(env_util::ReadFully(file_.get(), offset, end - offset, &s, buf.get()));
+
+  SegmentContent content;
+  ReadableLogSegment seg(s, &content, true);
+  seg.SkipHeader(checksumType_);
+  while (!seg.Eof()) {
+    RETURN_NOT_OK_APPEND(seg.ReadRecord(), fmt::format(" [segment: {}, offset: {}] ",
+                                                       file_->filename(), offset));
+  }
+
+  // the entries from the next indexed one on are overwritten by the next block.
+  yaraft::EntryVec &entries = content.entries;
+  if (i + 1 < index.size()) {
+    auto it = std::lower_bound(
+        entries.begin(), entries.end(), index[i + 1].index,
+        [](const yaraft::pb::Entry &x, uint64_t idx) { return x.index() < idx; });
+    entries.erase(it, entries.end());
+  }
+
+  size_t charge = 0;
+  for (const auto &e : entries) {
+    charge += e.ByteSize();
+  }
+  *block = std::make_shared<const yaraft::EntryVec>(std::move(entries));
+  if (cache) {
+    cache->Insert(cacheId_, offset, *block, charge);
+  }
+  return Status::OK();
 }
 
 }  // namespace wal
-}  // namespace consensus
\ No newline at end of file
+}  // namespace consensus
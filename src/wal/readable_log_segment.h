@@ -14,9 +14,14 @@
 
 #pragma once
 
+#include "base/env.h"
 #include "base/status.h"
+#include "wal/block_cache.h"
+#include "wal/format.h"
 #include "wal/segment_meta.h"
 
+#include <memory>
+
 #include <yaraft/memory_storage.h>
 
 namespace consensus {
@@ -25,36 +30,252 @@ namespace wal {
 extern Status ReadSegmentIntoMemoryStorage(const Slice &fname, yaraft::MemoryStorage *memstore,
                                            SegmentMetaData *metaData, bool verifyChecksum);
 
-// ReadableLogSegment reads the data of a segment into memory all at once.
-// It's sufficient because it's only used in wal recovery.
+// The decoded content of a segment, in which the overwritten entries are dropped.
+struct SegmentContent {
+  yaraft::EntryVec entries;
+
+  // valid if meta.hasHardState
+  yaraft::pb::HardState hs;
+
+  SegmentMetaData meta;
+
+  // set if the segment ends in a batch that was torn by a crash, which is dropped,
+  // the segment is intact up to `validSize` bytes then.
+  bool torn{false};
+  uint64_t validSize{0};
+};
+
+// Read and decode the segment through `env`, independent of any memstore, so that
+// segments can be decoded concurrently.
+// If `sealedChecksum` is given, and it matches the one in the footer of the segment,
+// the segment is known to be intact and is decoded without verifying checksums.
+// If `tolerateTornTail`, an incomplete last batch is dropped rather than reported as
+// Corruption, see ReadableLogSegment::TolerateTornTail.
+// If `allowUnwrittenTail`, the segment may end in zero-filled space unless it has a
+// footer, see ReadableLogSegment::AllowUnwrittenTail.
+extern Status ReadSegment(Env *env, const Slice &fname, SegmentContent *content,
+                          bool verifyChecksum, const uint32_t *sealedChecksum = nullptr,
+                          bool tolerateTornTail = false, bool allowUnwrittenTail = false);
+
+// Read the footer of a finished segment, without reading its records.
+// Returns NotFound if the segment has no footer.
+extern Status ReadSegmentFooter(RandomAccessFile *file, SegmentFooter *footer);
+
+// ReadableLogSegment decodes a segment either from the data in memory, or from a
+// file, which is streamed through a bounded buffer of kReadChunkSize bytes, unless
+// a single batch is larger than that. The buffer is reused across the chunks, so
+// the memory used by recovery doesn't grow with the size of segments.
 class ReadableLogSegment {
  public:
+  static constexpr size_t kReadChunkSize = 1024 * 1024;
+
   ReadableLogSegment(const Slice &scratch, yaraft::MemoryStorage *memStore,
                      SegmentMetaData *metaData, bool verifyChecksum)
-      : remain_(scratch.size()),
-        buf_(scratch.data()),
-        metaData_(metaData),
-        memStore_(memStore),
-        verifyChecksum_(verifyChecksum) {}
+      : ReadableLogSegment(scratch, nullptr, 0, memStore, nullptr, metaData, verifyChecksum) {}
+
+  ReadableLogSegment(const Slice &scratch, SegmentContent *content, bool verifyChecksum)
+      : ReadableLogSegment(scratch, nullptr, 0, nullptr, content, &content->meta,
+                           verifyChecksum) {}
+
+  // Read `fileSize` bytes from `file`.
+  ReadableLogSegment(RandomAccessFile *file, uint64_t fileSize, yaraft::MemoryStorage *memStore,
+                     SegmentMetaData *metaData, bool verifyChecksum)
+      : ReadableLogSegment(Slice(), file, fileSize, memStore, nullptr, metaData, verifyChecksum) {
+  }
+
+  ReadableLogSegment(RandomAccessFile *file, uint64_t fileSize, SegmentContent *content,
+                     bool verifyChecksum)
+      : ReadableLogSegment(Slice(), file, fileSize, nullptr, content, &content->meta,
+                           verifyChecksum) {}
 
   Status ReadHeader();
 
+  // The data starts at a batch in the middle of a segment, whose header has
+  // been read with `type`.
+  void SkipHeader(ChecksumType type) {
+    checksumType_ = type;
+  }
+
+  ChecksumType GetChecksumType() const {
+    return checksumType_;
+  }
+
+  // A crash in the middle of an append leaves the segment ending in a partial batch:
+  // its header or data is cut short by the end of file, or its checksum mismatches
+  // and only the unwritten space follows it. Such a batch is dropped, and the reading
+  // ends, rather than failing with Corruption. A bad batch followed by any data is
+  // still corrupted. The checksum of the last batch is verified even if the others'
+  // are not. It implies AllowUnwrittenTail.
+  void TolerateTornTail() {
+    tolerateTornTail_ = true;
+    allowUnwrittenTail_ = true;
+  }
+
+  // A preallocated segment that's not sealed ends in the zero-filled space not written
+  // yet. The reading ends at a zero batch header if the rest of the segment is zero
+  // filled too. Otherwise, or if this is not allowed, it's Corruption.
+  void AllowUnwrittenTail() {
+    allowUnwrittenTail_ = true;
+  }
+
+  // Whether the last batch was torn and dropped.
+  bool Torn() const {
+    return torn_;
+  }
+
+  // The size of the segment up to the end of the last complete batch.
+  uint64_t ValidSize() const {
+    return validSize_;
+  }
+
   Status ReadRecord();
 
   bool Eof();
 
  private:
+  ReadableLogSegment(const Slice &scratch, RandomAccessFile *file, uint64_t fileSize,
+                     yaraft::MemoryStorage *memStore, SegmentContent *content,
+                     SegmentMetaData *metaData, bool verifyChecksum)
+      : buf_(scratch.data()),
+        remain_(scratch.size()),
+        file_(file),
+        fileOffset_(0),
+        fileRemain_(fileSize),
+        chunkCap_(0),
+        memStore_(memStore),
+        content_(content),
+        metaData_(metaData),
+        verifyChecksum_(verifyChecksum),
+        checksumType_(kCRC32C),
+        segmentCrc_(0),
+        consumed_(0),
+        validSize_(0),
+        tolerateTornTail_(false),
+        allowUnwrittenTail_(false),
+        torn_(false) {}
+
+  // Read more data from file until at least `need` bytes are buffered, or the
+  // file is exhausted.
+  Status ensure(size_t need);
+
   Status checkRemain(size_t need);
 
+  // Skip the rest of the segment.
+  void skipAll();
+
   void advance(size_t size);
 
+  uint32_t checksum(const char *data, size_t len) const;
+
+  static bool isZeroFilled(const char *p, size_t n);
+
+  // Whether the batch of `len` bytes at the front of the buffer is followed by
+  // nothing but the unwritten space.
+  bool isLastBatch(size_t len);
+
+  // Whether the segment after the first `from` bytes buffered is zero filled. The rest
+  // of the segment is consumed, the reading ends.
+  bool restZeroFilled(size_t from);
+
+  // Ends the reading at the torn batch.
+  Status dropTornTail(const std::string &reason);
+
+  // Ends the reading at the zero-filled space, see AllowUnwrittenTail.
+  Status skipUnwrittenTail();
+
+  // Decode the records of a batch, `sealed` is set if the footer is read.
+  // Records in a compressed batch can't be compressed again, nor be the footer.
+  Status decodeRecords(Slice record, uint32_t crcBeforeBatch, bool compressed, bool *sealed);
+
+  Status decodeCompressed(Slice data);
+
+  // `crc` is the checksum of the segment before the footer.
+  Status readFooter(const Slice &data, uint32_t crc);
+
+  // Append the run of consecutive entries decoded into memStore_.
+  void flushToMemStore();
+
+  // Drop the entries decoded from `idx` on, see kTruncateType.
+  void truncateFrom(uint64_t idx);
+
+  // Append to content_, the entries from e.index() on are overwritten.
+  Status appendToContent(yaraft::pb::Entry &&e);
+
  private:
+  // the data buffered but not consumed yet.
   const char *buf_;
   size_t remain_;
+
+  // states for reading from file
+  RandomAccessFile *file_;
+  uint64_t fileOffset_;
+  uint64_t fileRemain_;
+  std::unique_ptr<char[]> chunk_;
+  size_t chunkCap_;
+
+  // entries are decoded into either of them.
   yaraft::MemoryStorage *memStore_;
+  SegmentContent *content_;
   SegmentMetaData *metaData_;
 
   const bool verifyChecksum_;
+
+  // determined by the segment header
+  ChecksumType checksumType_;
+
+  // crc32c of the consumed data, if verifyChecksum_.
+  uint32_t segmentCrc_;
+
+  // bytes consumed from the start of the segment.
+  uint64_t consumed_;
+  uint64_t validSize_;
+
+  bool tolerateTornTail_;
+  bool allowUnwrittenTail_;
+  bool torn_;
+
+  // the entries decoded but not appended into memStore_ yet, whose indexes are consecutive.
+  yaraft::EntryVec pending_;
+
+  // the records of the last compressed batch.
+  std::string uncompressed_;
+};
+
+// SealedSegmentReader reads entries of a sealed segment by random access. The
+// segment is split into blocks by its footer index, where block i starts at
+// index[i].offset and holds the entries in [index[i].index, index[i+1].index).
+// Blocks are decoded on demand and cached in the BlockCache given.
+//
+// Thread-Safe
+class SealedSegmentReader {
+ public:
+  // `cacheId` identifies the segment in block cache, which must be unique.
+  static StatusWith<SealedSegmentReader *> Open(Env *env, const SegmentMetaData &meta,
+                                                uint64_t cacheId);
+
+  // Append the entries in [lo, hi) into `entries`, until their total size exceeds
+  // `maxBytes`, where `*bytes` is the size of the entries already read. At least
+  // one entry is read if `entries` is empty.
+  // Required: [lo, hi) is in the range of this segment.
+  Status Read(uint64_t lo, uint64_t hi, uint64_t maxBytes, BlockCache *cache,
+              yaraft::EntryVec *entries, uint64_t *bytes);
+
+ private:
+  SealedSegmentReader(RandomAccessFile *file, SegmentFooter &&footer, ChecksumType type,
+                      uint64_t cacheId)
+      : file_(file), footer_(std::move(footer)), checksumType_(type), cacheId_(cacheId) {}
+
+  // Advise the OS to read ahead the blocks from `first` on, covering the entries
+  // before `hi`, if the read spans multiple blocks that are not cached.
+  void readAhead(size_t first, uint64_t hi, uint64_t maxBytes, BlockCache *cache);
+
+  Status readBlock(size_t i, BlockCache *cache, BlockCache::Block *block);
+
+ private:
+  std::unique_ptr<RandomAccessFile> file_;
+  const SegmentFooter footer_;
+  const ChecksumType checksumType_;
+  const uint64_t cacheId_;
 };
 
 }  // namespace wal
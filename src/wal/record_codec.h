@@ -0,0 +1,160 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "base/coding.h"
+#include "base/slice.h"
+#include "wal/format.h"
+
+#include <string>
+
+#include <yaraft/pb/raftpb.pb.h>
+
+namespace consensus {
+namespace wal {
+
+// RecordCodec<Type> encodes and decodes the body of the records of `Type`, the VarString
+// following the type byte, see format.h. The codec of each type is resolved at compile
+// time, so it's inlined where the records are written and where the readers switch on
+// the type byte, rather than going through the reflection of protobuf.
+//
+// Each codec defines:
+//
+//   Value                              the decoded record
+//   size_t BodySize(const Value &)     size of the body, which may be cached in Value
+//   size_t CachedBodySize(const Value &)
+//                                      same as above, after BodySize is called
+//   char *EncodeBody(const Value &, char *dst)
+//                                      encodes CachedBodySize bytes, returns the end
+//   bool Decode(Slice body, Value *)   returns false if the body is malformed
+//
+template <RecordType Type>
+struct RecordCodec;
+
+// Term Vote Commit, each in fixed64.
+template <>
+struct RecordCodec<kFixedHardStateType> {
+  typedef yaraft::pb::HardState Value;
+
+  constexpr static size_t kBodySize = 8 * 3;
+
+  static size_t BodySize(const Value &) {
+    return kBodySize;
+  }
+
+  static size_t CachedBodySize(const Value &) {
+    return kBodySize;
+  }
+
+  static char *EncodeBody(const Value &hs, char *dst) {
+    EncodeFixed64(dst, hs.term());
+    EncodeFixed64(dst + 8, hs.vote());
+    EncodeFixed64(dst + 16, hs.commit());
+    return dst + kBodySize;
+  }
+
+  static bool Decode(Slice body, Value *hs) {
+    if (body.Len() != kBodySize) {
+      return false;
+    }
+    const char *p = body.RawData();
+    hs->set_term(DecodeFixed64(p));
+    hs->set_vote(DecodeFixed64(p + 8));
+    hs->set_commit(DecodeFixed64(p + 16));
+    return true;
+  }
+};
+
+// The hard states encoded by protobuf, written before kFixedHardStateType. They're
+// only decoded.
+template <>
+struct RecordCodec<kHardStateType> {
+  typedef yaraft::pb::HardState Value;
+
+  static bool Decode(Slice body, Value *hs) {
+    return hs->ParseFromArray(body.RawData(), static_cast<int>(body.Len()));
+  }
+};
+
+template <>
+struct RecordCodec<kLogEntryType> {
+  typedef yaraft::pb::Entry Value;
+
+  static size_t BodySize(const Value &e) {
+    return e.ByteSize();
+  }
+
+  static size_t CachedBodySize(const Value &e) {
+    return e.GetCachedSize();
+  }
+
+  static char *EncodeBody(const Value &e, char *dst) {
+    return reinterpret_cast<char *>(
+        e.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t *>(dst)));
+  }
+
+  static bool Decode(Slice body, Value *e) {
+    return e->ParseFromArray(body.RawData(), static_cast<int>(body.Len()));
+  }
+};
+
+// TruncateIndex in varint64.
+template <>
+struct RecordCodec<kTruncateType> {
+  typedef uint64_t Value;
+
+  static size_t BodySize(const Value &idx) {
+    return VarintLength(idx);
+  }
+
+  static size_t CachedBodySize(const Value &idx) {
+    return VarintLength(idx);
+  }
+
+  static char *EncodeBody(const Value &idx, char *dst) {
+    return EncodeVarint64(dst, idx);
+  }
+
+  static bool Decode(Slice body, Value *idx) {
+    return GetVarint64(&body, idx);
+  }
+};
+
+// Size of the record of `v`, including the type byte and the length of the body.
+template <RecordType Type>
+inline size_t RecordSize(const typename RecordCodec<Type>::Value &v) {
+  size_t body = RecordCodec<Type>::BodySize(v);
+  return kRecordHeaderSize + VarintLength(body) + body;
+}
+
+// Encodes the record of `v` into `dst`, which has room for RecordSize<Type>(v) bytes.
+// RecordSize must have been called on `v`. Returns the end of the record.
+template <RecordType Type>
+inline char *EncodeRecord(const typename RecordCodec<Type>::Value &v, char *dst) {
+  dst[0] = static_cast<char>(Type);
+  dst = EncodeVarint32(dst + 1, static_cast<uint32_t>(RecordCodec<Type>::CachedBodySize(v)));
+  return RecordCodec<Type>::EncodeBody(v, dst);
+}
+
+template <RecordType Type>
+inline void PutRecord(const typename RecordCodec<Type>::Value &v, std::string *dst) {
+  size_t offset = dst->size();
+  dst->resize(offset + RecordSize<Type>(v));
+  EncodeRecord<Type>(v, &(*dst)[offset]);
+}
+
+}  // namespace wal
+}  // namespace consensus
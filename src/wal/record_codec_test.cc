@@ -0,0 +1,90 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "base/testing.h"
+#include "wal/record_codec.h"
+
+namespace consensus {
+namespace wal {
+
+// Decodes the single record in `buf` of the expected type.
+template <RecordType Type>
+static bool decodeRecord(const std::string& buf, typename RecordCodec<Type>::Value* v) {
+  Slice input(buf);
+  if (input.Len() < kRecordHeaderSize || input[0] != static_cast<char>(Type)) {
+    return false;
+  }
+  input.Skip(kRecordHeaderSize);
+  Slice body;
+  return GetLengthPrefixedSlice(&input, &body) && input.Len() == 0 &&
+         RecordCodec<Type>::Decode(body, v);
+}
+
+TEST(RecordCodecTest, FixedHardState) {
+  yaraft::pb::HardState hs;
+  hs.set_term(1ULL << 40);
+  hs.set_vote(3);
+  hs.set_commit(123456789);
+
+  std::string buf;
+  PutRecord<kFixedHardStateType>(hs, &buf);
+  ASSERT_EQ(buf.size(), kRecordHeaderSize + 1 + 24);
+  ASSERT_EQ(RecordSize<kFixedHardStateType>(hs), buf.size());
+
+  yaraft::pb::HardState decoded;
+  ASSERT_TRUE(decodeRecord<kFixedHardStateType>(buf, &decoded));
+  ASSERT_EQ(decoded.DebugString(), hs.DebugString());
+
+  // the body has a fixed size.
+  ASSERT_FALSE(RecordCodec<kFixedHardStateType>::Decode(Slice(buf.data() + 2, 23), &decoded));
+}
+
+// This test verifies that the hard states encoded by protobuf are still decoded.
+TEST(RecordCodecTest, ProtobufHardState) {
+  yaraft::pb::HardState hs;
+  hs.set_term(2);
+  hs.set_vote(1);
+  hs.set_commit(10);
+
+  std::string buf(1, static_cast<char>(kHardStateType));
+  PutVarint32(&buf, static_cast<uint32_t>(hs.ByteSize()));
+  hs.AppendToString(&buf);
+
+  yaraft::pb::HardState decoded;
+  ASSERT_TRUE(decodeRecord<kHardStateType>(buf, &decoded));
+  ASSERT_EQ(decoded.DebugString(), hs.DebugString());
+}
+
+TEST(RecordCodecTest, EntryAndTruncate) {
+  yaraft::pb::Entry e;
+  e.set_term(3);
+  e.set_index(300);
+  e.set_data("payload");
+
+  std::string buf;
+  PutRecord<kLogEntryType>(e, &buf);
+  yaraft::pb::Entry decodedEntry;
+  ASSERT_TRUE(decodeRecord<kLogEntryType>(buf, &decodedEntry));
+  ASSERT_EQ(decodedEntry.DebugString(), e.DebugString());
+
+  buf.clear();
+  PutRecord<kTruncateType>(uint64_t(1) << 50, &buf);
+  uint64_t idx = 0;
+  ASSERT_TRUE(decodeRecord<kTruncateType>(buf, &idx));
+  ASSERT_EQ(idx, uint64_t(1) << 50);
+}
+
+}  // namespace wal
+}  // namespace consensus
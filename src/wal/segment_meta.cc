@@ -13,9 +13,13 @@
 // limitations under the License.
 
 #include "wal/segment_meta.h"
+#include "base/coding.h"
+#include "base/crc32c.h"
 #include "base/logging.h"
 #include "wal/readable_log_segment.h"
 
+#include <algorithm>
+
 namespace consensus {
 namespace wal {
 
@@ -23,5 +27,188 @@ std::string SegmentFileName(uint64_t segmentId, uint64_t firstIdx) {
   return fmt::format("{}-{}.wal", segmentId, firstIdx);
 }
 
+std::string PooledSegmentFileName(uint64_t seq) {
+  return fmt::format("{}.pool", seq);
+}
+
+void SegmentFooter::EncodeTo(std::string *dst) const {
+  PutVarint64(dst, firstIndex);
+  PutVarint64(dst, lastIndex);
+  PutVarint64(dst, numEntries);
+  PutVarint64(dst, index.size());
+
+  SegmentIndexEntry prev{0, 0};
+  for (const auto &e : index) {
+    PutVarint64(dst, e.index - prev.index);
+    PutVarint64(dst, e.offset - prev.offset);
+    prev = e;
+  }
+  PutFixed32(dst, checksum);
+}
+
+Status SegmentFooter::DecodeFrom(Slice input) {
+  uint64_t indexSize;
+  if (!GetVarint64(&input, &firstIndex) || !GetVarint64(&input, &lastIndex) ||
+      !GetVarint64(&input, &numEntries) || !GetVarint64(&input, &indexSize)) {
+    return Status::Make(Error::Corruption, "bad segment footer");
+  }
+
+  // every delta takes at least one byte.
+  if (indexSize > input.size() / 2) {
+    return Status::Make(Error::Corruption, "bad segment footer index");
+  }
+  std::vector<uint64_t> deltas(indexSize * 2);
+  const char *p = GetVarint64Bulk(input.data(), input.data() + input.size(), deltas.data(),
+                                  deltas.size());
+  if (p == NULL) {
+    return Status::Make(Error::Corruption, "bad segment footer index");
+  }
+  input = Slice(p, input.data() + input.size() - p);
+
+  index.clear();
+  index.reserve(indexSize);
+  SegmentIndexEntry prev{0, 0};
+  for (uint64_t i = 0; i < indexSize; i++) {
+    prev.index += deltas[2 * i];
+    prev.offset += deltas[2 * i + 1];
+    index.push_back(prev);
+  }
+
+  if (input.size() != 4) {
+    return Status::Make(Error::Corruption, "bad segment footer checksum");
+  }
+  checksum = DecodeFixed32(input.data());
+  return Status::OK();
+}
+
+uint64_t SegmentFooter::Seek(uint64_t idx) const {
+  if (numEntries == 0 || idx < firstIndex || idx > lastIndex || index.empty()) {
+    return 0;
+  }
+  auto it = std::upper_bound(
+      index.begin(), index.end(), idx,
+      [](uint64_t i, const SegmentIndexEntry &e) { return i < e.index; });
+  if (it == index.begin()) {
+    return index.front().offset;
+  }
+  return std::prev(it)->offset;
+}
+
+//  Format of the manifest:
+//
+//  Manifest := NextSegId NumSegments Segment* NextPoolSeq NumPool VarString(Pool)*
+//              HasHardState [VarString(HardState)] Crc32c
+//  Segment := VarString(Name) NumEntries FirstIndex LastIndex LastTerm Flags Checksum
+//
+//  Integers are varint64, except that Flags is 1 byte and Checksum and Crc32c are
+//  4 bytes. Crc32c covers all the fields before it.
+
+static constexpr char kHasHardStateFlag = 0x1;
+static constexpr char kSealedFlag = 0x2;
+
+static Slice baseName(const std::string &path) {
+  size_t pos = path.rfind('/');
+  if (pos == std::string::npos) {
+    return path;
+  }
+  return Slice(path.data() + pos + 1, path.size() - pos - 1);
+}
+
+void LogManifest::EncodeTo(std::string *dst) const {
+  size_t begin = dst->size();
+
+  PutVarint64(dst, nextSegId);
+  PutVarint64(dst, segments.size());
+  for (const auto &seg : segments) {
+    PutLengthPrefixedSlice(dst, baseName(seg.fileName));
+    PutVarint64(dst, seg.numEntries);
+    PutVarint64(dst, seg.firstIndex);
+    PutVarint64(dst, seg.lastIndex);
+    PutVarint64(dst, seg.lastTerm);
+    char flags = 0;
+    if (seg.hasHardState) {
+      flags |= kHasHardStateFlag;
+    }
+    if (seg.sealed) {
+      flags |= kSealedFlag;
+    }
+    dst->push_back(flags);
+    PutFixed32(dst, seg.checksum);
+  }
+
+  PutVarint64(dst, nextPoolSeq);
+  PutVarint64(dst, pool.size());
+  for (const auto &p : pool) {
+    PutLengthPrefixedSlice(dst, baseName(p));
+  }
+
+  dst->push_back(static_cast<char>(hasHardState));
+  if (hasHardState) {
+    PutLengthPrefixedSlice(dst, hardState.SerializeAsString());
+  }
+
+  PutFixed32(dst, crc32c::Value(dst->data() + begin, dst->size() - begin));
+}
+
+Status LogManifest::DecodeFrom(Slice input, const std::string &logDir) {
+  if (input.size() < 4) {
+    return Status::Make(Error::Corruption, "bad manifest length");
+  }
+  uint32_t crc = DecodeFixed32(input.data() + input.size() - 4);
+  input = Slice(input.data(), input.size() - 4);
+  if (crc32c::Value(input.data(), input.size()) != crc) {
+    return Status::Make(Error::Corruption, "bad manifest checksum");
+  }
+
+  uint64_t numSegments;
+  if (!GetVarint64(&input, &nextSegId) || !GetVarint64(&input, &numSegments)) {
+    return Status::Make(Error::Corruption, "bad manifest");
+  }
+  segments.clear();
+  for (uint64_t i = 0; i < numSegments; i++) {
+    SegmentMetaData seg;
+    Slice name;
+    uint64_t numEntries;
+    if (!GetLengthPrefixedSlice(&input, &name) || !GetVarint64(&input, &numEntries) ||
+        !GetVarint64(&input, &seg.firstIndex) || !GetVarint64(&input, &seg.lastIndex) ||
+        !GetVarint64(&input, &seg.lastTerm) || input.size() < 5) {
+      return Status::Make(Error::Corruption, "bad manifest segment");
+    }
+    seg.fileName = logDir + "/" + name.ToString();
+    seg.numEntries = numEntries;
+    seg.hasHardState = (input[0] & kHasHardStateFlag) != 0;
+    seg.sealed = (input[0] & kSealedFlag) != 0;
+    seg.checksum = DecodeFixed32(input.data() + 1);
+    input.Skip(5);
+    segments.push_back(std::move(seg));
+  }
+
+  uint64_t poolSize;
+  if (!GetVarint64(&input, &nextPoolSeq) || !GetVarint64(&input, &poolSize)) {
+    return Status::Make(Error::Corruption, "bad manifest pool");
+  }
+  pool.clear();
+  for (uint64_t i = 0; i < poolSize; i++) {
+    Slice name;
+    if (!GetLengthPrefixedSlice(&input, &name)) {
+      return Status::Make(Error::Corruption, "bad manifest pool");
+    }
+    pool.push_back(logDir + "/" + name.ToString());
+  }
+
+  if (input.size() < 1) {
+    return Status::Make(Error::Corruption, "bad manifest hard state");
+  }
+  hasHardState = input[0] != 0;
+  input.Skip(1);
+  if (hasHardState) {
+    Slice hs;
+    if (!GetLengthPrefixedSlice(&input, &hs) || !hardState.ParseFromArray(hs.data(), hs.size())) {
+      return Status::Make(Error::Corruption, "bad manifest hard state");
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace wal
 }  // namespace consensus
\ No newline at end of file
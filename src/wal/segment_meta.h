@@ -14,22 +14,129 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "base/status.h"
 
+#include <yaraft/pb/raftpb.pb.h>
+
 namespace consensus {
 namespace wal {
 
 using silly::operator""_sl;
-static constexpr Slice kLogSegmentHeaderMagic = "yaraft_log"_sl;
+static constexpr Slice kLogSegmentHeaderMagic = "yaraft_seg"_sl;
+static constexpr Slice kLegacyLogSegmentHeaderMagic = "yaraft_log"_sl;
+static constexpr Slice kSegmentFooterMagic = "yrftfoot"_sl;
 
 struct SegmentMetaData {
   std::string fileName;
   size_t numEntries;
 
-  SegmentMetaData() : numEntries(0){};
+  // range of the entries written into the segment, valid if numEntries > 0.
+  uint64_t firstIndex;
+  uint64_t lastIndex;
+  uint64_t lastTerm;
+
+  // whether a hard state is written into the segment.
+  bool hasHardState;
+
+  // whether the segment is finished with a footer, whose checksum of the segment
+  // content is `checksum`.
+  bool sealed;
+  uint32_t checksum;
+
+  SegmentMetaData()
+      : numEntries(0),
+        firstIndex(0),
+        lastIndex(0),
+        lastTerm(0),
+        hasHardState(false),
+        sealed(false),
+        checksum(0){};
+};
+
+// The batch at `offset` is the first one containing entry `index`.
+struct SegmentIndexEntry {
+  uint64_t index;
+  uint64_t offset;
+};
+
+// SegmentFooter summarizes a finished segment, so that it can be navigated
+// without parsing every record.
+struct SegmentFooter {
+  uint64_t firstIndex;
+  uint64_t lastIndex;
+
+  // number of entries written, including the ones overwritten by the later
+  // entries of the same segment.
+  uint64_t numEntries;
+
+  // Sparse index, ordered by index. Entries after the offset of an index entry
+  // overwrite the ones before it.
+  std::vector<SegmentIndexEntry> index;
+
+  // crc32c of the segment content before the footer.
+  uint32_t checksum;
+
+  // offset of the footer in the segment, which is not encoded but filled by
+  // ReadSegmentFooter.
+  uint64_t offset;
+
+  SegmentFooter() : firstIndex(0), lastIndex(0), numEntries(0), checksum(0), offset(0) {}
+
+  void EncodeTo(std::string *dst) const;
+
+  Status DecodeFrom(Slice input);
+
+  // Returns the offset of the batch from which the entry `idx` can be found by
+  // reading forward, or 0 if `idx` is not in this segment.
+  uint64_t Seek(uint64_t idx) const;
 };
 
 std::string SegmentFileName(uint64_t segmentId, uint64_t firstIdx);
 
+// Name of the segment file in pool, which has no data written yet.
+std::string PooledSegmentFileName(uint64_t seq);
+
+// The file records the index and term of the last entry compacted by GC,
+// where the log in the remaining segments starts after.
+static constexpr Slice kCompactionMetaFileName = "COMPACTED"_sl;
+
+// The file records the index and term of the last entry compacted for each group
+// of SharedWriteAheadLog, where the group's log in the remaining segments starts after.
+static constexpr Slice kGroupCompactionMetaFileName = "GROUPS_COMPACTED"_sl;
+
+// The hard state given without entries is kept in the slots HARDSTATE.0 and
+// HARDSTATE.1, see HardStateFile.
+static constexpr Slice kHardStateFileName = "HARDSTATE"_sl;
+
+// The manifest lists the files of the log, so that the recovery can open the
+// segments directly, rather than listing the log directory and parsing the file
+// names. It's replaced atomically whenever the segments or the pool change.
+static constexpr Slice kManifestFileName = "MANIFEST"_sl;
+
+struct LogManifest {
+  // Ordered by segment id. The segments not sealed are the ones being written,
+  // or the ones left behind when the log was not closed properly.
+  std::vector<SegmentMetaData> segments;
+  uint64_t nextSegId;
+
+  // paths of the pooled segments, and the sequence of the next one to be created.
+  std::vector<std::string> pool;
+  uint64_t nextPoolSeq;
+
+  // the last hard state persisted when the manifest is written.
+  bool hasHardState;
+  yaraft::pb::HardState hardState;
+
+  LogManifest() : nextSegId(1), nextPoolSeq(0), hasHardState(false) {}
+
+  // Paths are encoded relative to the log directory.
+  void EncodeTo(std::string *dst) const;
+
+  Status DecodeFrom(Slice input, const std::string &logDir);
+};
+
 }  // namespace wal
 }  // namespace consensus
\ No newline at end of file
@@ -0,0 +1,653 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "wal/shared_wal.h"
+#include "base/coding.h"
+#include "base/crc32c.h"
+#include "base/env.h"
+#include "base/env_util.h"
+#include "base/logging.h"
+#include "base/metrics.h"
+#include "wal/format.h"
+#include "wal/log_manager.h"
+#include "wal/record_codec.h"
+#include "wal/segment_meta.h"
+
+#include <algorithm>
+#include <future>
+
+namespace consensus {
+namespace wal {
+
+static const size_t kSegmentHeaderSize = kLogSegmentHeaderMagic.size() + kChecksumTypeSize;
+
+static bool isSharedSegment(const std::string& fname) {
+  size_t len = fname.length();
+  return len > 5 && fname.substr(len - 5, 5) == ".mwal";
+}
+
+static void encodeGroup(uint64_t groupId, const PBEntryVec& entries,
+                        const yaraft::pb::HardState* hs, std::string* dst) {
+  std::string id;
+  PutVarint64(&id, groupId);
+  dst->push_back(static_cast<char>(kGroupType));
+  PutLengthPrefixedSlice(dst, id);
+
+  for (const auto& e : entries) {
+    PutRecord<kLogEntryType>(e, dst);
+  }
+  if (hs) {
+    PutRecord<kFixedHardStateType>(*hs, dst);
+  }
+}
+
+Status SharedWriteAheadLog::Open(const WriteAheadLogOptions& options,
+                                 SharedWriteAheadLogUPtr* engine) {
+  if (!options.extra_log_dirs.empty()) {
+    return StripedSharedLog::Recover(options, engine);
+  }
+  SharedLogManagerUPtr m;
+  RETURN_NOT_OK(SharedLogManager::Recover(options, &m));
+  engine->reset(m.release());
+  return Status::OK();
+}
+
+SharedLogManager::SharedLogManager(const WriteAheadLogOptions& options)
+    : options_(options), holds_(0), stopping_(false), fileSize_(0), nextSeq_(1) {}
+
+SharedLogManager::~SharedLogManager() {
+  WARN_NOT_OK(Close(), "SharedLogManager::Close");
+}
+
+Status SharedLogManager::Recover(const WriteAheadLogOptions& options,
+                                 SharedLogManagerUPtr* engine) {
+  RETURN_NOT_OK_APPEND(options.env->CreateDirIfMissing(options.log_dir),
+                       fmt::format(" [log_dir: \"{}\"]", options.log_dir));
+
+  SharedLogManagerUPtr m(new SharedLogManager(options));
+  RETURN_NOT_OK(m->readCompactionMeta());
+
+  std::vector<std::string> files;
+  RETURN_NOT_OK_APPEND(options.env->GetChildren(options.log_dir, &files),
+                       fmt::format(" [log_dir: \"{}\"]", options.log_dir));
+  std::map<uint64_t, std::string> segments;  // ordered by seq
+  for (const auto& f : files) {
+    if (isSharedSegment(f)) {
+      segments[std::stoull(f)] = options.log_dir + "/" + f;
+    }
+  }
+  for (auto it = segments.begin(); it != segments.end(); it++) {
+    RETURN_NOT_OK(m->recoverSegment(it->second, std::next(it) == segments.end()));
+  }
+  if (!segments.empty()) {
+    m->nextSeq_ = segments.rbegin()->first + 1;
+    FMT_LOG(INFO, "recovered {} groups from {} shared segments", m->groups_.size(),
+            segments.size());
+  }
+
+  // the segments recovered are never written again.
+  RETURN_NOT_OK(m->newSegment());
+  m->commitThread_ = std::thread(&SharedLogManager::commitLoop, m.get());
+  *engine = std::move(m);
+  return Status::OK();
+}
+
+Status SharedLogManager::recoverSegment(const std::string& fname, bool last) {
+  RandomAccessFile* rf;
+  ASSIGN_IF_OK(options_.env->NewRandomAccessFile(fname), rf);
+  std::unique_ptr<RandomAccessFile> f(rf);
+
+  uint64_t fsize;
+  ASSIGN_IF_OK(f->Size(), fsize);
+  std::unique_ptr<char[]> buf(new char[fsize]);
+  Slice data;
+  RETURN_NOT_OK(env_util::ReadFully(rf, 0, fsize, &data, buf.get()));
+
+  if (fsize < kSegmentHeaderSize && last) {
+    // the segment was not completely created.
+    return options_.env->DeleteFile(fname);
+  }
+  if (UNLIKELY(fsize < kSegmentHeaderSize ||
+               kLogSegmentHeaderMagic.Compare(Slice(data.data(), kLogSegmentHeaderMagic.size())) !=
+                   0 ||
+               data[kLogSegmentHeaderMagic.size()] != static_cast<char>(kCRC32C))) {
+    return FMT_Status(Corruption, "bad header of segment {}", fname);
+  }
+
+  SegmentInfo seg;
+  seg.fileName = fname;
+  uint64_t offset = kSegmentHeaderSize;
+  while (offset < fsize) {
+    const char* p = data.data() + offset;
+    size_t remain = fsize - offset;
+    uint32_t len = remain < kLogBatchHeaderSize ? 0 : DecodeFixed32(p + 4);
+    if (remain < kLogBatchHeaderSize || kLogBatchHeaderSize + len > remain ||
+        ((options_.verify_checksum || last) &&
+         crc32c::Value(p + kLogBatchHeaderSize, len) != DecodeFixed32(p))) {
+      if (!last) {
+        return FMT_Status(Corruption, "bad batch at offset {} of segment {}", offset, fname);
+      }
+
+      // the batch was not completely written, hence never committed.
+      FMT_LOG(WARNING, "truncating the torn tail of segment {} at offset {}", fname, offset);
+      WritableFile* wf;
+      ASSIGN_IF_OK(options_.env->NewWritableFile(fname, Env::OPEN_EXISTING), wf);
+      std::unique_ptr<WritableFile> tail(wf);
+      RETURN_NOT_OK(tail->Truncate(offset));
+      RETURN_NOT_OK(tail->Sync());
+      RETURN_NOT_OK(tail->Close());
+      break;
+    }
+
+    Slice records(p + kLogBatchHeaderSize, len);
+    bool hasGroup = false;
+    uint64_t groupId = 0;
+    yaraft::EntryVec entries;
+    auto flush = [&]() -> Status {
+      if (!entries.empty()) {
+        seg.groups[groupId] = std::make_pair(entries.back().index(), entries.back().term());
+        RETURN_NOT_OK(AppendToMemStore(std::move(entries), recoveredMemStore(groupId)));
+        entries.clear();
+      }
+      return Status::OK();
+    };
+    while (records.Len() > 0) {
+      auto type = static_cast<RecordType>(records[0]);
+      records.Skip(kRecordHeaderSize);
+
+      Slice record;
+      if (UNLIKELY(!GetLengthPrefixedSlice(&records, &record))) {
+        return FMT_Status(Corruption, "bad record at offset {} of segment {}", offset, fname);
+      }
+      if (type == kGroupType) {
+        RETURN_NOT_OK(flush());
+        if (UNLIKELY(!GetVarint64(&record, &groupId))) {
+          return FMT_Status(Corruption, "bad group id at offset {} of segment {}", offset, fname);
+        }
+        hasGroup = true;
+        continue;
+      }
+      if (UNLIKELY(!hasGroup)) {
+        return FMT_Status(Corruption, "batch at offset {} of segment {} has no group", offset,
+                          fname);
+      }
+
+      bool ok;
+      switch (type) {
+        case kLogEntryType:
+          entries.emplace_back();
+          ok = RecordCodec<kLogEntryType>::Decode(record, &entries.back());
+          break;
+        case kFixedHardStateType:
+        case kHardStateType: {
+          GroupState& st = groups_[groupId];
+          st.hasHardState = true;
+          ok = type == kFixedHardStateType
+                   ? RecordCodec<kFixedHardStateType>::Decode(record, &st.hs)
+                   : RecordCodec<kHardStateType>::Decode(record, &st.hs);
+          break;
+        }
+        default:
+          return FMT_Status(Corruption, "unknown record type {} at offset {} of segment {}",
+                            static_cast<int>(type), offset, fname);
+      }
+      if (UNLIKELY(!ok)) {
+        return FMT_Status(Corruption, "bad record of type {} at offset {} of segment {}",
+                          static_cast<int>(type), offset, fname);
+      }
+    }
+    RETURN_NOT_OK(flush());
+    offset += kLogBatchHeaderSize + len;
+  }
+
+  segments_.push_back(std::move(seg));
+  return Status::OK();
+}
+
+yaraft::MemoryStorage* SharedLogManager::recoveredMemStore(uint64_t groupId) {
+  GroupState& st = groups_[groupId];
+  if (!st.memstore) {
+    st.memstore.reset(new yaraft::MemoryStorage);
+    auto it = compacted_.find(groupId);
+    if (it != compacted_.end()) {
+      // the log starts after the compacted entries.
+      yaraft::pb::Snapshot snap;
+      snap.mutable_metadata()->set_index(it->second.first);
+      snap.mutable_metadata()->set_term(it->second.second);
+      st.memstore->ApplySnapshot(snap);
+    }
+  }
+  return st.memstore.get();
+}
+
+Status SharedLogManager::OpenGroup(uint64_t groupId, WriteAheadLog** wal,
+                                   yaraft::MemStoreUptr* memstore) {
+  std::lock_guard<std::mutex> g(mu_);
+  GroupState& st = groups_[groupId];
+  memstore->reset();
+  if (!st.log) {
+    yaraft::MemoryStorage* ms = recoveredMemStore(groupId);
+    if (st.hasHardState) {
+      ms->SetHardState(st.hs);
+    }
+    memstore->reset(st.memstore.release());
+    st.log.reset(new GroupLog(this, groupId));
+  }
+  *wal = st.log.get();
+  return Status::OK();
+}
+
+void SharedLogManager::Hold() {
+  std::lock_guard<std::mutex> g(mu_);
+  holds_++;
+}
+
+void SharedLogManager::Release() {
+  {
+    std::lock_guard<std::mutex> g(mu_);
+    LOG_ASSERT(holds_ > 0);
+    holds_--;
+  }
+  cv_.notify_one();
+}
+
+Status SharedLogManager::Close() {
+  {
+    std::lock_guard<std::mutex> g(mu_);
+    stopping_ = true;
+  }
+  cv_.notify_one();
+  if (!commitThread_.joinable()) {
+    return Status::OK();
+  }
+  commitThread_.join();
+
+  // the pending writes have been committed by the commit thread before it exits.
+  if (file_) {
+    RETURN_NOT_OK(file_->Sync());
+    RETURN_NOT_OK(file_->Close());
+    file_.reset();
+  }
+  return Status::OK();
+}
+
+std::vector<uint64_t> SharedLogManager::recoveredGroups() {
+  std::lock_guard<std::mutex> g(mu_);
+  std::vector<uint64_t> ids;
+  for (const auto& e : groups_) {
+    ids.push_back(e.first);
+  }
+  return ids;
+}
+
+Status SharedLogManager::asyncWrite(uint64_t groupId, const PBEntryVec& vec,
+                                    const yaraft::pb::HardState* hs,
+                                    WriteAheadLog::WriteCallback callback) {
+  if (vec.empty() && hs && skipHardState(groupId, *hs)) {
+    if (callback) {
+      callback(Status::OK());
+    }
+    return Status::OK();
+  }
+
+  GroupWrite w;
+  w.groupId = groupId;
+  w.entries = vec;
+  w.hasHardState = hs != nullptr;
+  if (hs) {
+    w.hs = *hs;
+  }
+  w.callback = std::move(callback);
+  {
+    std::lock_guard<std::mutex> g(mu_);
+    if (UNLIKELY(stopping_)) {
+      return FMT_Status(IllegalState, "writing to group {} of a closed log", groupId);
+    }
+    pending_.push_back(std::move(w));
+  }
+  cv_.notify_one();
+  return Status::OK();
+}
+
+bool SharedLogManager::skipHardState(uint64_t groupId, const yaraft::pb::HardState& hs) {
+  std::lock_guard<std::mutex> g(mu_);
+  auto it = groups_.find(groupId);
+  if (it == groups_.end() || !it->second.hasHardState) {
+    return false;
+  }
+  yaraft::pb::HardState& last = it->second.hs;
+  if (hs.term() != last.term() || hs.vote() != last.vote()) {
+    return false;
+  }
+  // the commit index is carried by the next write of the group, or the next segment.
+  last.set_commit(std::max(last.commit(), hs.commit()));
+  Metrics::Instance().walHardStateSkips << 1;
+  return true;
+}
+
+Status SharedLogManager::write(uint64_t groupId, const PBEntryVec& vec,
+                               const yaraft::pb::HardState* hs) {
+  std::promise<Status> done;
+  std::future<Status> f = done.get_future();
+  RETURN_NOT_OK(asyncWrite(groupId, vec, hs, [&done](const Status& s) { done.set_value(s); }));
+  return f.get();
+}
+
+void SharedLogManager::commitLoop() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    cv_.wait(lock, [this]() { return stopping_ || (!pending_.empty() && holds_ == 0); });
+    if (pending_.empty()) {
+      // stopping
+      return;
+    }
+
+    std::vector<GroupWrite> writes;
+    writes.swap(pending_);
+    lock.unlock();
+
+    Status s = error_;
+    if (s.IsOK()) {
+      s = commit(&writes);
+    }
+    if (!s.IsOK()) {
+      // the log can't be written any more once a commit failed.
+      FMT_LOG(ERROR, "failed to commit {} writes: {}", writes.size(), s.ToString());
+      error_ = s;
+    }
+    for (auto& w : writes) {
+      if (w.callback) {
+        w.callback(s);
+      }
+    }
+
+    lock.lock();
+  }
+}
+
+Status SharedLogManager::commit(std::vector<GroupWrite>* writes) {
+  // the writes of all groups are committed as one batch.
+  std::string& batch = scratch_;
+  batch.assign(kLogBatchHeaderSize, '\0');
+  for (const auto& w : *writes) {
+    if (!w.entries.empty() || w.hasHardState) {
+      encodeGroup(w.groupId, w.entries, w.hasHardState ? &w.hs : nullptr, &batch);
+    }
+  }
+
+  if (batch.size() > kLogBatchHeaderSize) {
+    if (fileSize_ > kSegmentHeaderSize && fileSize_ + batch.size() > options_.log_segment_size) {
+      RETURN_NOT_OK(rollover());
+    }
+    RETURN_NOT_OK(writeBatch(&batch));
+  }
+  if (options_.sync_policy != WriteAheadLogOptions::SYNC_NONE) {
+    ScopedLatency latency(&Metrics::Instance().walSyncLatency);
+    RETURN_NOT_OK(file_->Sync());
+  }
+
+  std::lock_guard<std::mutex> g(mu_);
+  SegmentInfo& seg = segments_.back();
+  for (auto& w : *writes) {
+    if (!w.entries.empty()) {
+      const yaraft::pb::Entry& e = w.entries.back();
+      seg.groups[w.groupId] = std::make_pair(e.index(), e.term());
+    }
+    if (w.hasHardState) {
+      // the commit index skipped by a later hard state isn't set back.
+      GroupState& st = groups_[w.groupId];
+      uint64_t commit = st.hasHardState ? std::max(st.hs.commit(), w.hs.commit()) : w.hs.commit();
+      st.hasHardState = true;
+      st.hs = std::move(w.hs);
+      st.hs.set_commit(commit);
+    }
+  }
+  return Status::OK();
+}
+
+Status SharedLogManager::writeBatch(std::string* batch) {
+  size_t len = batch->size() - kLogBatchHeaderSize;
+  EncodeFixed32(&(*batch)[4], static_cast<uint32_t>(len));
+  EncodeFixed32(&(*batch)[0], crc32c::Value(batch->data() + kLogBatchHeaderSize, len));
+  Metrics& metrics = Metrics::Instance();
+  {
+    ScopedLatency latency(&metrics.walAppendLatency);
+    RETURN_NOT_OK(file_->Append(*batch));
+  }
+  metrics.walAppendBytes << static_cast<int64_t>(batch->size());
+  fileSize_ += batch->size();
+  return Status::OK();
+}
+
+Status SharedLogManager::rollover() {
+  Metrics::Instance().walSegmentRollovers << 1;
+  RETURN_NOT_OK(file_->Sync());
+  RETURN_NOT_OK(file_->Close());
+  file_.reset();
+  return newSegment();
+}
+
+Status SharedLogManager::newSegment() {
+  std::string fname = fmt::format("{}/{}.mwal", options_.log_dir, nextSeq_++);
+  FMT_LOG(INFO, "creating new shared segment: {}", fname);
+
+  WritableFile* wf;
+  ASSIGN_IF_OK(options_.env->NewWritableFile(fname), wf);
+  file_.reset(wf);
+
+  std::string header = kLogSegmentHeaderMagic.ToString();
+  header.push_back(static_cast<char>(kCRC32C));
+  RETURN_NOT_OK(file_->Append(header));
+  fileSize_ = header.size();
+
+  // The latest hard states are written at the beginning of every segment, so that
+  // the previous segments can be deleted regardless of the hard states in them.
+  std::string batch(kLogBatchHeaderSize, '\0');
+  {
+    std::lock_guard<std::mutex> g(mu_);
+    for (const auto& e : groups_) {
+      if (e.second.hasHardState) {
+        encodeGroup(e.first, PBEntryVec(), &e.second.hs, &batch);
+      }
+    }
+    SegmentInfo seg;
+    seg.fileName = fname;
+    segments_.push_back(std::move(seg));
+  }
+  if (batch.size() > kLogBatchHeaderSize) {
+    RETURN_NOT_OK(writeBatch(&batch));
+  }
+  return file_->Sync();
+}
+
+Status SharedLogManager::gc(uint64_t groupId, WriteAheadLog::CompactionHint* hint) {
+  RETURN_NOT_OK(CompactMemStore(*hint));
+
+  std::lock_guard<std::mutex> gcGuard(gcMu_);
+  std::vector<std::string> obsolete;
+  std::map<uint64_t, std::pair<uint64_t, uint64_t>> points;
+  {
+    std::lock_guard<std::mutex> g(mu_);
+    GroupState& st = groups_[groupId];
+    st.compactIndex = std::max(st.compactIndex, hint->compactIndex);
+
+    // Segments are deleted in order, once every group in it has compacted the
+    // entries it holds. The segment being written is always retained.
+    size_t n = 0;
+    for (; n + 1 < segments_.size(); n++) {
+      const SegmentInfo& seg = segments_[n];
+      bool compacted = true;
+      for (const auto& e : seg.groups) {
+        if (e.second.first > groups_[e.first].compactIndex) {
+          compacted = false;
+          break;
+        }
+      }
+      if (!compacted) {
+        break;
+      }
+      for (const auto& e : seg.groups) {
+        auto& point = compacted_[e.first];
+        if (e.second.first > point.first) {
+          point = e.second;
+        }
+      }
+      obsolete.push_back(seg.fileName);
+    }
+    if (n == 0) {
+      return Status::OK();
+    }
+    segments_.erase(segments_.begin(), segments_.begin() + n);
+    points = compacted_;
+  }
+
+  // the compaction points are persisted before the segments are deleted, otherwise
+  // the recovery couldn't tell where the log of each group starts.
+  RETURN_NOT_OK(writeCompactionMeta(points));
+  for (const auto& f : obsolete) {
+    FMT_LOG(INFO, "deleting compacted shared segment: {}", f);
+    WARN_NOT_OK(options_.env->DeleteFile(f), fmt::format("delete segment {}", f));
+  }
+  return Status::OK();
+}
+
+Status SharedLogManager::writeCompactionMeta(
+    const std::map<uint64_t, std::pair<uint64_t, uint64_t>>& points) {
+  std::string buf;
+  PutVarint64(&buf, points.size());
+  for (const auto& e : points) {
+    PutVarint64(&buf, e.first);
+    PutFixed64(&buf, e.second.first);
+    PutFixed64(&buf, e.second.second);
+  }
+  PutFixed32(&buf, crc32c::Value(buf.data(), buf.size()));
+  return env_util::ReplaceFile(options_.env,
+                               options_.log_dir + "/" + kGroupCompactionMetaFileName.ToString(),
+                               buf);
+}
+
+Status SharedLogManager::readCompactionMeta() {
+  std::string fname = options_.log_dir + "/" + kGroupCompactionMetaFileName.ToString();
+  if (!options_.env->GetFileSize(fname).IsOK()) {
+    // no segment has been compacted.
+    return Status::OK();
+  }
+
+  RandomAccessFile* rf;
+  ASSIGN_IF_OK(options_.env->NewRandomAccessFile(fname), rf);
+  std::unique_ptr<RandomAccessFile> f(rf);
+
+  uint64_t fsize;
+  ASSIGN_IF_OK(f->Size(), fsize);
+  std::unique_ptr<char[]> buf(new char[fsize]);
+  Slice data;
+  RETURN_NOT_OK(env_util::ReadFully(rf, 0, fsize, &data, buf.get()));
+  if (UNLIKELY(fsize < 4 ||
+               crc32c::Value(data.data(), fsize - 4) != DecodeFixed32(data.data() + fsize - 4))) {
+    return FMT_Status(Corruption, "bad checksum of {}", fname);
+  }
+
+  Slice input(data.data(), fsize - 4);
+  uint64_t n;
+  if (UNLIKELY(!GetVarint64(&input, &n))) {
+    return FMT_Status(Corruption, "bad group number in {}", fname);
+  }
+  for (uint64_t i = 0; i < n; i++) {
+    uint64_t groupId;
+    if (UNLIKELY(!GetVarint64(&input, &groupId) || input.Len() < 16)) {
+      return FMT_Status(Corruption, "bad compaction point in {}", fname);
+    }
+    compacted_[groupId] = std::make_pair(DecodeFixed64(input.data()), DecodeFixed64(input.data() + 8));
+    input.Skip(16);
+  }
+  return Status::OK();
+}
+
+Status StripedSharedLog::Recover(const WriteAheadLogOptions& options,
+                                 SharedWriteAheadLogUPtr* engine) {
+  std::vector<std::string> dirs{options.log_dir};
+  dirs.insert(dirs.end(), options.extra_log_dirs.begin(), options.extra_log_dirs.end());
+
+  std::vector<SharedLogManagerUPtr> streams(dirs.size());
+  std::vector<std::future<Status>> results;
+  for (size_t i = 0; i < dirs.size(); i++) {
+    WriteAheadLogOptions opts = options;
+    opts.log_dir = dirs[i];
+    opts.extra_log_dirs.clear();
+    SharedLogManagerUPtr* stream = &streams[i];
+    results.push_back(std::async(std::launch::async, [opts, stream]() {
+      return SharedLogManager::Recover(opts, stream);
+    }));
+  }
+  Status s;
+  for (auto& r : results) {
+    Status st = r.get();
+    if (s.IsOK()) {
+      s = st;
+    }
+  }
+  RETURN_NOT_OK(s);
+
+  for (size_t i = 0; i < streams.size(); i++) {
+    for (uint64_t groupId : streams[i]->recoveredGroups()) {
+      if (groupId % streams.size() != i) {
+        return FMT_Status(InvalidArgument,
+                          "group {} is recovered from {}, but placed in {}, the log "
+                          "directories must not be changed",
+                          groupId, dirs[i], dirs[groupId % streams.size()]);
+      }
+    }
+  }
+  FMT_LOG(INFO, "shared log is striped across {} directories", dirs.size());
+
+  std::unique_ptr<StripedSharedLog> striped(new StripedSharedLog);
+  striped->streams_ = std::move(streams);
+  engine->reset(striped.release());
+  return Status::OK();
+}
+
+StripedSharedLog::~StripedSharedLog() {
+  WARN_NOT_OK(Close(), "StripedSharedLog::Close");
+}
+
+Status StripedSharedLog::OpenGroup(uint64_t groupId, WriteAheadLog** wal,
+                                   yaraft::MemStoreUptr* memstore) {
+  return streams_[groupId % streams_.size()]->OpenGroup(groupId, wal, memstore);
+}
+
+void StripedSharedLog::Hold() {
+  for (auto& stream : streams_) {
+    stream->Hold();
+  }
+}
+
+void StripedSharedLog::Release() {
+  for (auto& stream : streams_) {
+    stream->Release();
+  }
+}
+
+Status StripedSharedLog::Close() {
+  // the streams are closed regardless of the errors of the others.
+  Status s;
+  for (auto& stream : streams_) {
+    Status st = stream->Close();
+    if (s.IsOK()) {
+      s = st;
+    }
+  }
+  return s;
+}
+
+}  // namespace wal
+}  // namespace consensus
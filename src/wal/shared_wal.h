@@ -0,0 +1,237 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "base/status.h"
+#include "wal/wal.h"
+
+#include <yaraft/memory_storage.h>
+
+namespace consensus {
+
+class WritableFile;
+
+namespace wal {
+
+class GroupLog;
+
+class SharedLogManager;
+using SharedLogManagerUPtr = std::unique_ptr<SharedLogManager>;
+
+// SharedLogManager writes the records of all groups through a single commit thread.
+// Writes queued while the thread is committing are committed together in the next
+// round, each round is written as one batch followed by one sync.
+//
+// Segments are named "<seq>.mwal", and are never reopened for writing after the
+// engine is closed. Every segment starts with the latest hard states of all groups,
+// so that a segment is only needed for the entries it holds.
+//
+// Thread-Safe
+class SharedLogManager : public SharedWriteAheadLog {
+ public:
+  explicit SharedLogManager(const WriteAheadLogOptions& options);
+
+  // Recover the logs of all groups from options.log_dir, which is created when
+  // it's not existed.
+  static Status Recover(const WriteAheadLogOptions& options, SharedLogManagerUPtr* engine);
+
+  ~SharedLogManager() override;
+
+  Status OpenGroup(uint64_t groupId, WriteAheadLog** wal, yaraft::MemStoreUptr* memstore) override;
+
+  void Hold() override;
+
+  void Release() override;
+
+  Status Close() override;
+
+ private:
+  friend class GroupLog;
+  friend class SharedLogManagerTest;
+  friend class StripedSharedLog;
+
+  // `callback` is invoked from the commit thread.
+  Status asyncWrite(uint64_t groupId, const PBEntryVec& vec, const yaraft::pb::HardState* hs,
+                    WriteAheadLog::WriteCallback callback);
+
+  // Wait until the write is committed.
+  Status write(uint64_t groupId, const PBEntryVec& vec, const yaraft::pb::HardState* hs);
+
+  Status gc(uint64_t groupId, WriteAheadLog::CompactionHint* hint);
+
+  void commitLoop();
+
+  struct GroupWrite;
+  Status commit(std::vector<GroupWrite>* writes);
+
+  Status writeBatch(std::string* batch);
+
+  // Seal the current segment and start writing the next one.
+  Status rollover();
+
+  Status newSegment();
+
+  Status recoverSegment(const std::string& fname, bool last);
+
+  // Requires: mu_ held
+  yaraft::MemoryStorage* recoveredMemStore(uint64_t groupId);
+
+  // A hard state without entries is skipped if it changes no more than the commit
+  // index of the one written last for the group, which is updated in place.
+  bool skipHardState(uint64_t groupId, const yaraft::pb::HardState& hs);
+
+  Status writeCompactionMeta(const std::map<uint64_t, std::pair<uint64_t, uint64_t>>& points);
+
+  Status readCompactionMeta();
+
+  // Ids of the groups recovered, whether or not they're opened.
+  std::vector<uint64_t> recoveredGroups();
+
+ private:
+  const WriteAheadLogOptions options_;
+
+  struct GroupWrite {
+    uint64_t groupId;
+    PBEntryVec entries;
+    bool hasHardState;
+    yaraft::pb::HardState hs;
+    WriteAheadLog::WriteCallback callback;
+  };
+
+  struct GroupState {
+    std::unique_ptr<GroupLog> log;
+
+    // recovered, until the group is opened.
+    yaraft::MemStoreUptr memstore;
+
+    // the latest hard state written.
+    bool hasHardState;
+    yaraft::pb::HardState hs;
+
+    // the latest compaction requested by GC.
+    uint64_t compactIndex;
+
+    GroupState() : hasHardState(false), compactIndex(0) {}
+  };
+
+  struct SegmentInfo {
+    std::string fileName;
+
+    // groupId -> (index, term) of the last entry written into this segment.
+    std::map<uint64_t, std::pair<uint64_t, uint64_t>> groups;
+  };
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::vector<GroupWrite> pending_;
+  size_t holds_;
+  bool stopping_;
+  std::thread commitThread_;
+
+  // protected by mu_
+  std::map<uint64_t, GroupState> groups_;
+  std::vector<SegmentInfo> segments_;
+
+  // groupId -> (index, term) of the last entry compacted by deleting segments,
+  // which is persisted before the segments are deleted.
+  std::map<uint64_t, std::pair<uint64_t, uint64_t>> compacted_;
+
+  // serializes GC
+  std::mutex gcMu_;
+
+  // accessed only by the commit thread once started.
+  std::unique_ptr<WritableFile> file_;
+  uint64_t fileSize_;
+  uint64_t nextSeq_;
+  std::string scratch_;
+  Status error_;
+};
+
+// GroupLog is the log of a group in SharedLogManager.
+class GroupLog : public WriteAheadLog {
+ public:
+  GroupLog(SharedLogManager* engine, uint64_t groupId) : engine_(engine), groupId_(groupId) {}
+
+  Status Write(const PBEntryVec& vec, const yaraft::pb::HardState* hs) override {
+    return engine_->write(groupId_, vec, hs);
+  }
+
+  Status AsyncWrite(const PBEntryVec& vec, const yaraft::pb::HardState* hs,
+                    WriteCallback callback) override {
+    return engine_->asyncWrite(groupId_, vec, hs, std::move(callback));
+  }
+
+  // Commits the pending writes of all groups.
+  Status Sync() override {
+    return engine_->write(groupId_, PBEntryVec(), nullptr);
+  }
+
+  // The files are closed along with the engine.
+  Status Close() override {
+    return Status::OK();
+  }
+
+  // The memstore in hint is compacted synchronously, and the segments whose entries
+  // are all compacted by their groups are deleted.
+  Status GC(CompactionHint* hint) override {
+    return engine_->gc(groupId_, hint);
+  }
+
+  SharedWriteAheadLog* Engine() override {
+    return engine_;
+  }
+
+ private:
+  SharedLogManager* const engine_;
+  const uint64_t groupId_;
+};
+
+// StripedSharedLog stripes the groups across a SharedLogManager in each of the log
+// directories, see WriteAheadLogOptions::extra_log_dirs. The streams commit and sync
+// independently, each group stays in the stream it's placed in, so the engine of
+// its log is that stream.
+//
+// Thread-Safe
+class StripedSharedLog : public SharedWriteAheadLog {
+ public:
+  // The streams are recovered concurrently.
+  static Status Recover(const WriteAheadLogOptions& options, SharedWriteAheadLogUPtr* engine);
+
+  ~StripedSharedLog() override;
+
+  Status OpenGroup(uint64_t groupId, WriteAheadLog** wal, yaraft::MemStoreUptr* memstore) override;
+
+  void Hold() override;
+
+  void Release() override;
+
+  Status Close() override;
+
+ private:
+  StripedSharedLog() = default;
+
+ private:
+  // one for each of log_dir and extra_log_dirs, in order.
+  std::vector<SharedLogManagerUPtr> streams_;
+};
+
+}  // namespace wal
+}  // namespace consensus
@@ -0,0 +1,273 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+#include "base/env.h"
+#include "base/testing.h"
+#include "wal/shared_wal.h"
+
+namespace consensus {
+namespace wal {
+
+using yaraft::EntryVec;
+using yaraft::PBEntry;
+
+class SharedLogManagerTest : public BaseTest {
+ public:
+  static size_t SegmentNum(SharedWriteAheadLog* engine) {
+    auto m = dynamic_cast<SharedLogManager*>(engine);
+    std::lock_guard<std::mutex> g(m->mu_);
+    return m->segments_.size();
+  }
+
+  // Write entries [1, n] of `groups` interleaved, in batches of 10, where each
+  // group has its own terms.
+  static void WriteGroups(SharedWriteAheadLog* engine, size_t groups, uint64_t n) {
+    std::vector<WriteAheadLog*> wals(groups);
+    for (size_t g = 0; g < groups; g++) {
+      yaraft::MemStoreUptr memstore;
+      ASSERT_OK(engine->OpenGroup(g, &wals[g], &memstore));
+    }
+    for (uint64_t i = 1; i <= n; i += 10) {
+      for (size_t g = 0; g < groups; g++) {
+        EntryVec batch;
+        for (uint64_t j = i; j < i + 10 && j <= n; j++) {
+          batch.push_back(PBEntry().Index(j).Term(g + 1).v);
+        }
+        yaraft::pb::HardState hs;
+        hs.set_term(g + 1);
+        hs.set_commit(batch.back().index());
+        ASSERT_OK(wals[g]->Write(batch, &hs));
+      }
+    }
+  }
+
+  static void VerifyGroup(yaraft::MemoryStorage* memstore, uint64_t group, uint64_t first,
+                          uint64_t last) {
+    ASSERT_EQ(memstore->FirstIndex(), first);
+    ASSERT_EQ(memstore->LastIndex(), last);
+    for (uint64_t i = first; i <= last; i++) {
+      ASSERT_EQ(memstore->Term(i).GetValue(), group + 1);
+    }
+    auto hs = memstore->InitialState().GetValue();
+    ASSERT_EQ(hs.term(), group + 1);
+    ASSERT_EQ(hs.commit(), last);
+  }
+};
+
+// This test verifies that the interleaved logs of groups are recovered separately.
+TEST_F(SharedLogManagerTest, WriteAndRecover) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 4 * 1024;
+
+  const size_t kGroups = 5;
+  {
+    SharedWriteAheadLogUPtr engine;
+    ASSERT_OK(SharedWriteAheadLog::Open(options, &engine));
+    WriteGroups(engine.get(), kGroups, 300);
+    ASSERT_GT(SegmentNum(engine.get()), 1);
+    ASSERT_OK(engine->Close());
+  }
+
+  SharedWriteAheadLogUPtr engine;
+  ASSERT_OK(SharedWriteAheadLog::Open(options, &engine));
+  for (size_t i = 0; i < kGroups; i++) {
+    WriteAheadLog* wal;
+    yaraft::MemStoreUptr memstore;
+    ASSERT_OK(engine->OpenGroup(i, &wal, &memstore));
+    ASSERT_TRUE(wal->Engine() == engine.get());
+    VerifyGroup(memstore.get(), i, 1, 300);
+  }
+
+  // a new group starts with an empty log.
+  WriteAheadLog* wal;
+  yaraft::MemStoreUptr memstore;
+  ASSERT_OK(engine->OpenGroup(kGroups, &wal, &memstore));
+  ASSERT_EQ(memstore->LastIndex(), 0);
+}
+
+// This test verifies that the groups are striped across the log directories, each
+// of which is a stream of its own, and that the directories can't be changed.
+TEST_F(SharedLogManagerTest, StripedLogDirs) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir() + "/dir-0";
+  options.extra_log_dirs = {GetTestDir() + "/dir-1"};
+  options.log_segment_size = 4 * 1024;
+
+  const size_t kGroups = 5;
+  {
+    SharedWriteAheadLogUPtr engine;
+    ASSERT_OK(SharedWriteAheadLog::Open(options, &engine));
+    WriteGroups(engine.get(), kGroups, 300);
+
+    // the groups of a stream share its engine.
+    WriteAheadLog *wal0, *wal1, *wal2;
+    yaraft::MemStoreUptr memstore;
+    ASSERT_OK(engine->OpenGroup(0, &wal0, &memstore));
+    ASSERT_OK(engine->OpenGroup(1, &wal1, &memstore));
+    ASSERT_OK(engine->OpenGroup(2, &wal2, &memstore));
+    ASSERT_TRUE(wal0->Engine() == wal2->Engine());
+    ASSERT_TRUE(wal0->Engine() != wal1->Engine());
+    ASSERT_GT(SegmentNum(wal0->Engine()), 1);
+    ASSERT_GT(SegmentNum(wal1->Engine()), 1);
+    ASSERT_OK(engine->Close());
+  }
+
+  {
+    SharedWriteAheadLogUPtr engine;
+    ASSERT_OK(SharedWriteAheadLog::Open(options, &engine));
+    for (size_t i = 0; i < kGroups; i++) {
+      WriteAheadLog* wal;
+      yaraft::MemStoreUptr memstore;
+      ASSERT_OK(engine->OpenGroup(i, &wal, &memstore));
+      VerifyGroup(memstore.get(), i, 1, 300);
+    }
+    ASSERT_OK(engine->Close());
+  }
+
+  options.extra_log_dirs.push_back(GetTestDir() + "/dir-2");
+  SharedWriteAheadLogUPtr engine;
+  ASSERT_EQ(SharedWriteAheadLog::Open(options, &engine).Code(), Error::InvalidArgument);
+}
+
+// This test verifies that a segment is deleted only if all groups in it have been
+// compacted, and that each group recovers from its own compaction point.
+TEST_F(SharedLogManagerTest, GC) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+  options.log_segment_size = 4 * 1024;
+
+  {
+    SharedWriteAheadLogUPtr engine;
+    ASSERT_OK(SharedWriteAheadLog::Open(options, &engine));
+    WriteGroups(engine.get(), 2, 500);
+    size_t before = SegmentNum(engine.get());
+
+    WriteAheadLog* wal0;
+    WriteAheadLog* wal1;
+    yaraft::MemStoreUptr memstore;
+    ASSERT_OK(engine->OpenGroup(0, &wal0, &memstore));
+    ASSERT_OK(engine->OpenGroup(1, &wal1, &memstore));
+
+    // group 1 still needs all of its entries.
+    WriteAheadLog::CompactionHint hint;
+    hint.compactIndex = 450;
+    ASSERT_OK(wal0->GC(&hint));
+    ASSERT_EQ(SegmentNum(engine.get()), before);
+
+    hint.compactIndex = 300;
+    ASSERT_OK(wal1->GC(&hint));
+    ASSERT_LT(SegmentNum(engine.get()), before);
+    ASSERT_OK(engine->Close());
+  }
+
+  SharedWriteAheadLogUPtr engine;
+  ASSERT_OK(SharedWriteAheadLog::Open(options, &engine));
+  for (uint64_t i = 0; i < 2; i++) {
+    WriteAheadLog* wal;
+    yaraft::MemStoreUptr memstore;
+    ASSERT_OK(engine->OpenGroup(i, &wal, &memstore));
+
+    // the log starts right after the compaction point of the group, which is at
+    // or before the compactIndex requested.
+    uint64_t first = memstore->FirstIndex();
+    ASSERT_GT(first, 1);
+    ASSERT_LE(first, 311);
+    VerifyGroup(memstore.get(), i, first, 500);
+    ASSERT_EQ(memstore->Term(first - 1).GetValue(), i + 1);
+  }
+}
+
+// This test verifies that the writes issued during a hold are committed together
+// once released.
+TEST_F(SharedLogManagerTest, HoldAndRelease) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+
+  SharedWriteAheadLogUPtr engine;
+  ASSERT_OK(SharedWriteAheadLog::Open(options, &engine));
+
+  const size_t kGroups = 10;
+  std::atomic<size_t> committed(0);
+  engine->Hold();
+  for (size_t i = 0; i < kGroups; i++) {
+    WriteAheadLog* wal;
+    yaraft::MemStoreUptr memstore;
+    ASSERT_OK(engine->OpenGroup(i, &wal, &memstore));
+    ASSERT_OK(wal->AsyncWrite({PBEntry().Index(1).Term(1).v}, nullptr, [&](const Status& s) {
+      ASSERT_OK(s);
+      committed++;
+    }));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_EQ(committed, 0);
+
+  engine->Release();
+  while (committed < kGroups) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_OK(engine->Close());
+}
+
+// This test verifies that the batch partially written at the tail of the last
+// segment is discarded on recovery.
+TEST_F(SharedLogManagerTest, TornTail) {
+  TestDirGuard g(CreateTestDirGuard());
+
+  WriteAheadLogOptions options;
+  options.log_dir = GetTestDir();
+
+  std::string fname = GetTestDir() + "/1.mwal";
+  {
+    SharedWriteAheadLogUPtr engine;
+    ASSERT_OK(SharedWriteAheadLog::Open(options, &engine));
+    WriteGroups(engine.get(), 2, 100);
+    ASSERT_OK(engine->Close());
+  }
+
+  // append half of a batch
+  uint64_t size;
+  ASSIGN_IF_ASSERT_OK(Env::Default()->GetFileSize(fname), size);
+  {
+    std::ofstream out(fname, std::ios::binary | std::ios::app);
+    out << std::string(100, 'x');
+  }
+
+  SharedWriteAheadLogUPtr engine;
+  ASSERT_OK(SharedWriteAheadLog::Open(options, &engine));
+  uint64_t newSize;
+  ASSIGN_IF_ASSERT_OK(Env::Default()->GetFileSize(fname), newSize);
+  ASSERT_EQ(newSize, size);
+  for (uint64_t i = 0; i < 2; i++) {
+    WriteAheadLog* wal;
+    yaraft::MemStoreUptr memstore;
+    ASSERT_OK(engine->OpenGroup(i, &wal, &memstore));
+    VerifyGroup(memstore.get(), i, 1, 100);
+  }
+}
+
+}  // namespace wal
+}  // namespace consensus
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "wal/wal.h"
+#include "base/env.h"
 #include "base/logging.h"
 #include "wal/log_manager.h"
 
@@ -30,7 +31,25 @@ Status WriteAheadLog::Default(const WriteAheadLogOptions& options, WriteAheadLog
 }
 
 WriteAheadLogOptions::WriteAheadLogOptions()
-    : verify_checksum(true), log_segment_size(64 * 1024 * 1024) {}
+    : log_segment_size(64 * 1024 * 1024),
+      verify_checksum(true),
+      group_commit(false),
+      sync_policy(SYNC_EVERY_WRITE),
+      sync_interval_ms(10),
+      sync_bytes(1024 * 1024),
+      bytes_per_flush(1024 * 1024),
+      background_sync(false),
+      log_segment_pool_size(0),
+      background_rollover(false),
+      use_direct_io(false),
+      compression(NO_COMPRESSION),
+      compression_min_batch_size(4096),
+      rewrite_tail_on_conflict(false),
+      recovery_threads(4),
+      lazy_recovery_entries(0),
+      block_cache_size(8 * 1024 * 1024),
+      max_open_segments(64),
+      env(Env::Default()) {}
 
 WriteAheadLogUPtr TEST_CreateWalStore(const std::string& testDir, yaraft::MemStoreUptr* pMemstore) {
   WriteAheadLogOptions options;
@@ -12,9 +12,23 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+// Run with --benchmark_format=json, or --benchmark_out=<file> --benchmark_out_format=json,
+// to get machine-readable results. The latency percentiles of each benchmark are reported
+// as the counters p50_us, p99_us and p999_us.
+
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <thread>
 
+#include "base/env.h"
 #include "base/logging.h"
+#include "base/metrics.h"
 #include "base/testing.h"
 #include "wal/wal.h"
 
@@ -25,6 +39,23 @@ using yaraft::EntryVec;
 using namespace consensus;
 using namespace consensus::wal;
 
+// Number of heap allocations made by this process, used for measuring
+// the allocations per batch write.
+static std::atomic<uint64_t> allocCount(0);
+
+void* operator new(size_t size) {
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+  void* p = malloc(size);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
 void WalBench(benchmark::State& state) {
   TestDirectoryHelper dirHelper("/tmp/consensus-wal-bench");
   WriteAheadLogUPtr wal(TEST_CreateWalStore(dirHelper.GetTestDir()));
@@ -43,11 +74,14 @@ void WalBench(benchmark::State& state) {
   }
 
   // start benchmark
+  uint64_t allocsBefore = allocCount.load();
   while (state.KeepRunning()) {
     FATAL_NOT_OK(wal->Write(entries), "WriteAheadLog::Write");
   }
+  uint64_t allocs = allocCount.load() - allocsBefore;
 
   state.SetBytesProcessed(state.iterations() * totalBytes);
+  state.counters["allocs_per_batch"] = static_cast<double>(allocs) / state.iterations();
 }
 
 BENCHMARK(WalBench)
@@ -63,4 +97,409 @@ BENCHMARK(WalBench)
     ->Args({10000, 1000})
     ->Unit(benchmark::kMillisecond);
 
+// The distributions of the sizes of the entries.
+enum ValueSizes {
+  // every entry is 128 bytes.
+  kSmallValues,
+
+  // every entry is 4KB.
+  kMediumValues,
+
+  // log-normal around 512 bytes, with a long tail up to 64KB, as in a typical kv workload.
+  kMixedValues,
+};
+
+static std::vector<size_t> valueSizes(ValueSizes dist, size_t n) {
+  std::vector<size_t> sizes(n);
+  std::mt19937 rng(301);
+  std::lognormal_distribution<double> lognormal(std::log(512.0), 1.2);
+  for (size_t& size : sizes) {
+    switch (dist) {
+      case kSmallValues:
+        size = 128;
+        break;
+      case kMediumValues:
+        size = 4096;
+        break;
+      case kMixedValues:
+        size = std::min<size_t>(std::max<size_t>(lognormal(rng), 16), 64 * 1024);
+        break;
+    }
+  }
+  return sizes;
+}
+
+// The latencies of the writes in a benchmark, in nanoseconds.
+class LatencySamples {
+ public:
+  void Add(std::chrono::steady_clock::duration d) {
+    samples_.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+  }
+
+  void Append(const LatencySamples& other) {
+    samples_.insert(samples_.end(), other.samples_.begin(), other.samples_.end());
+  }
+
+  // Reports p50_us, p99_us and p999_us prefixed by `prefix`, and the max.
+  void Report(benchmark::State& state, const std::string& prefix = "") {
+    if (samples_.empty()) {
+      return;
+    }
+    std::sort(samples_.begin(), samples_.end());
+    state.counters[prefix + "p50_us"] = percentile(0.5);
+    state.counters[prefix + "p99_us"] = percentile(0.99);
+    state.counters[prefix + "p999_us"] = percentile(0.999);
+    state.counters[prefix + "max_us"] = samples_.back() / 1000.0;
+  }
+
+ private:
+  double percentile(double p) const {
+    size_t i = std::min(samples_.size() - 1, static_cast<size_t>(samples_.size() * p));
+    return samples_[i] / 1000.0;
+  }
+
+ private:
+  std::vector<int64_t> samples_;
+};
+
+// A wal written with increasing indexes in a scratch directory, whose entries are
+// compacted periodically, so that the disk usage stays bounded however long it runs.
+class BenchLog {
+ public:
+  explicit BenchLog(WriteAheadLogOptions options) : dir_("/tmp/consensus-wal-bench") {
+    options.log_dir = dir_.GetTestDir();
+    FATAL_NOT_OK(WriteAheadLog::Default(options, &wal_, &memstore_), "WriteAheadLog::Default");
+  }
+
+  ~BenchLog() {
+    FATAL_NOT_OK(wal_->Close(), "WriteAheadLog::Close");
+  }
+
+  WriteAheadLog* Wal() const {
+    return wal_.get();
+  }
+
+  // Allocates `n` consecutive indexes, returns the first one.
+  uint64_t NextIndexes(uint64_t n) {
+    return nextIndex_.fetch_add(n);
+  }
+
+  // Drops the segments written so far. Must not be called concurrently with writes.
+  void Compact() {
+    WriteAheadLog::CompactionHint hint;
+    hint.compactIndex = nextIndex_.load() - 1;
+    FATAL_NOT_OK(wal_->GC(&hint), "WriteAheadLog::GC");
+  }
+
+ private:
+  TestDirectoryHelper dir_;
+  WriteAheadLogUPtr wal_;
+  yaraft::MemStoreUptr memstore_;
+  std::atomic<uint64_t> nextIndex_{1};
+};
+
+// compact the wal every so many writes.
+static const int kCompactInterval = 1024;
+
+static PBEntryVec makeBatch(uint64_t index, size_t count, const std::vector<size_t>& sizes,
+                            const std::string& data) {
+  PBEntryVec batch;
+  batch.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    size_t size = sizes[(index + i) % sizes.size()];
+    batch.push_back(yaraft::PBEntry().Index(index + i).Term(1).Data(data.substr(0, size)).v);
+  }
+  return batch;
+}
+
+// The durability policies, in the order of the benchmark argument.
+enum Durability {
+  kSyncEveryWrite,
+  kSyncInterval,
+  kSyncBytes,
+  kSyncNone,
+  kBackgroundSync,
+};
+
+static WriteAheadLogOptions durabilityOptions(int durability) {
+  WriteAheadLogOptions options;
+  switch (durability) {
+    case kSyncEveryWrite:
+      options.sync_policy = WriteAheadLogOptions::SYNC_EVERY_WRITE;
+      break;
+    case kSyncInterval:
+      options.sync_policy = WriteAheadLogOptions::SYNC_INTERVAL;
+      break;
+    case kSyncBytes:
+      options.sync_policy = WriteAheadLogOptions::SYNC_BYTES;
+      break;
+    case kSyncNone:
+      options.sync_policy = WriteAheadLogOptions::SYNC_NONE;
+      break;
+    case kBackgroundSync:
+      options.background_sync = true;
+      break;
+  }
+  return options;
+}
+
+// A single writer appending batches of 8 entries with the given durability.
+// Args: durability, value sizes
+void WalDurabilityBench(benchmark::State& state) {
+  BenchLog log(durabilityOptions(state.range(0)));
+  std::vector<size_t> sizes = valueSizes(static_cast<ValueSizes>(state.range(1)), 4096);
+  std::string data(*std::max_element(sizes.begin(), sizes.end()), 'a');
+  const size_t kBatchSize = 8;
+
+  LatencySamples latency;
+  int64_t bytes = 0;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    PBEntryVec batch = makeBatch(log.NextIndexes(kBatchSize), kBatchSize, sizes, data);
+    for (const auto& e : batch) {
+      bytes += e.data().size();
+    }
+    if (state.iterations() % kCompactInterval == 0) {
+      log.Compact();
+    }
+    state.ResumeTiming();
+
+    auto start = std::chrono::steady_clock::now();
+    FATAL_NOT_OK(log.Wal()->Write(batch), "WriteAheadLog::Write");
+    latency.Add(std::chrono::steady_clock::now() - start);
+  }
+
+  state.SetBytesProcessed(bytes);
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  latency.Report(state);
+}
+
+static void durabilityArgs(benchmark::internal::Benchmark* b) {
+  for (int durability = kSyncEveryWrite; durability <= kBackgroundSync; durability++) {
+    for (int values = kSmallValues; values <= kMixedValues; values++) {
+      b->Args({durability, values});
+    }
+  }
+}
+
+BENCHMARK(WalDurabilityBench)
+    ->ArgNames({"durability", "values"})
+    ->Apply(durabilityArgs)
+    ->Unit(benchmark::kMicrosecond);
+
+// Writers of one entry each, committed in groups that share a sync.
+// Args: writers, durability (kSyncEveryWrite with group commit, or kBackgroundSync)
+void WalGroupCommitBench(benchmark::State& state) {
+  int writers = state.range(0);
+  WriteAheadLogOptions options = durabilityOptions(state.range(1));
+  options.group_commit = !options.background_sync;
+  BenchLog log(options);
+
+  std::vector<size_t> sizes = valueSizes(kMixedValues, 4096);
+  std::string data(*std::max_element(sizes.begin(), sizes.end()), 'a');
+  const int kWritesPerWriter = 64;
+
+  // The concurrent writes may be queued in a different order than their indexes are
+  // allocated in, which the wal doesn't check, it costs the same to write.
+  std::vector<LatencySamples> latencies(writers);
+  while (state.KeepRunning()) {
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; w++) {
+      threads.emplace_back([&, w]() {
+        for (int i = 0; i < kWritesPerWriter; i++) {
+          PBEntryVec batch = makeBatch(log.NextIndexes(1), 1, sizes, data);
+          auto start = std::chrono::steady_clock::now();
+          FATAL_NOT_OK(log.Wal()->Write(batch), "WriteAheadLog::Write");
+          latencies[w].Add(std::chrono::steady_clock::now() - start);
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+
+    state.PauseTiming();
+    log.Compact();
+    state.ResumeTiming();
+  }
+
+  LatencySamples latency;
+  for (const auto& l : latencies) {
+    latency.Append(l);
+  }
+  state.SetItemsProcessed(state.iterations() * writers * kWritesPerWriter);
+  latency.Report(state);
+}
+
+static void groupCommitArgs(benchmark::internal::Benchmark* b) {
+  for (int durability : {kSyncEveryWrite, kBackgroundSync}) {
+    for (int writers = 1; writers <= 64; writers *= 2) {
+      b->Args({writers, durability});
+    }
+  }
+}
+
+BENCHMARK(WalGroupCommitBench)
+    ->ArgNames({"writers", "durability"})
+    ->Apply(groupCommitArgs)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+// Group commit on a simulated disk in memory, whose syncs take 1ms at the median with
+// a tail of the given weight, to see how the tail of the device shows in the writes,
+// apart from the CPU costs.
+// Args: writers, sync tail (0: none, 1: moderate, 2: heavy)
+void WalSlowDiskBench(benchmark::State& state) {
+  int writers = state.range(0);
+  MemoryEnvOptions envOptions;
+  envOptions.append_latency.kind = LatencyDistribution::kFixed;
+  envOptions.append_latency.a = 5;
+  envOptions.sync_latency.kind = LatencyDistribution::kLogNormal;
+  envOptions.sync_latency.a = 1000;
+  envOptions.sync_latency.b = std::vector<double>{0, 0.5, 1.5}[state.range(1)];
+  std::unique_ptr<Env> env(Env::NewMemory(envOptions));
+
+  WriteAheadLogOptions options = durabilityOptions(kSyncEveryWrite);
+  options.group_commit = true;
+  options.env = env.get();
+  std::unique_ptr<BenchLog> log(new BenchLog(options));
+
+  const int kWritesPerWriter = 16;
+  std::string data(256, 'a');
+  std::vector<size_t> sizes(1, data.size());
+  std::vector<LatencySamples> latencies(writers);
+  while (state.KeepRunning()) {
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; w++) {
+      threads.emplace_back([&, w]() {
+        for (int i = 0; i < kWritesPerWriter; i++) {
+          PBEntryVec batch = makeBatch(log->NextIndexes(1), 1, sizes, data);
+          auto start = std::chrono::steady_clock::now();
+          FATAL_NOT_OK(log->Wal()->Write(batch), "WriteAheadLog::Write");
+          latencies[w].Add(std::chrono::steady_clock::now() - start);
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+
+    state.PauseTiming();
+    log->Compact();
+    state.ResumeTiming();
+  }
+  // the log is closed before the environment its files belong to.
+  log.reset();
+
+  LatencySamples latency;
+  for (const auto& l : latencies) {
+    latency.Append(l);
+  }
+  state.SetItemsProcessed(state.iterations() * writers * kWritesPerWriter);
+  latency.Report(state);
+}
+
+static void slowDiskArgs(benchmark::internal::Benchmark* b) {
+  for (int tail = 0; tail <= 2; tail++) {
+    for (int writers : {1, 8, 32}) {
+      b->Args({writers, tail});
+    }
+  }
+}
+
+BENCHMARK(WalSlowDiskBench)
+    ->ArgNames({"writers", "tail"})
+    ->Apply(slowDiskArgs)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+// Writes of the hard state only, as a follower persists a vote or a candidate its term,
+// or as the commit index advances, which is not written until the term or vote changes.
+// Args: durability, term changes
+void WalHardStateBench(benchmark::State& state) {
+  BenchLog log(durabilityOptions(state.range(0)));
+  bool termChanges = state.range(1) != 0;
+
+  yaraft::pb::HardState hs;
+  hs.set_term(1);
+  hs.set_vote(1);
+  hs.set_commit(0);
+
+  LatencySamples latency;
+  while (state.KeepRunning()) {
+    if (termChanges) {
+      hs.set_term(hs.term() + 1);
+    } else {
+      hs.set_commit(hs.commit() + 1);
+    }
+    auto start = std::chrono::steady_clock::now();
+    FATAL_NOT_OK(log.Wal()->Write(&hs), "WriteAheadLog::Write");
+    latency.Add(std::chrono::steady_clock::now() - start);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  latency.Report(state);
+}
+
+static void hardStateArgs(benchmark::internal::Benchmark* b) {
+  for (int durability = kSyncEveryWrite; durability <= kBackgroundSync; durability++) {
+    for (int termChanges = 0; termChanges <= 1; termChanges++) {
+      b->Args({durability, termChanges});
+    }
+  }
+}
+
+BENCHMARK(WalHardStateBench)
+    ->ArgNames({"durability", "term_changes"})
+    ->Apply(hardStateArgs)
+    ->Unit(benchmark::kMicrosecond);
+
+// Writes of 64KB into 4MB segments, so that one in every 64 writes rolls over. The
+// latencies of the writes that roll over are reported apart, prefixed by "rollover_".
+// Args: background rollover, segment pool size
+void WalRolloverBench(benchmark::State& state) {
+  WriteAheadLogOptions options;
+  options.sync_policy = WriteAheadLogOptions::SYNC_NONE;
+  options.log_segment_size = 4 * 1024 * 1024;
+  options.background_rollover = state.range(0) != 0;
+  options.log_segment_pool_size = state.range(1);
+  BenchLog log(options);
+
+  std::vector<size_t> sizes(1, 64 * 1024);
+  std::string data(sizes[0], 'a');
+  bvar::Adder<int64_t>& rollovers = Metrics::Instance().walSegmentRollovers;
+
+  LatencySamples latency, rolloverLatency;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    PBEntryVec batch = makeBatch(log.NextIndexes(1), 1, sizes, data);
+    if (state.iterations() % kCompactInterval == 0) {
+      log.Compact();
+    }
+    int64_t rolledBefore = rollovers.get_value();
+    state.ResumeTiming();
+
+    auto start = std::chrono::steady_clock::now();
+    FATAL_NOT_OK(log.Wal()->Write(batch), "WriteAheadLog::Write");
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (rollovers.get_value() != rolledBefore) {
+      rolloverLatency.Add(elapsed);
+    } else {
+      latency.Add(elapsed);
+    }
+  }
+
+  state.SetBytesProcessed(state.iterations() * data.size());
+  latency.Report(state);
+  rolloverLatency.Report(state, "rollover_");
+}
+
+BENCHMARK(WalRolloverBench)
+    ->ArgNames({"background", "pool"})
+    ->Args({0, 0})
+    ->Args({0, 2})
+    ->Args({1, 0})
+    ->Args({1, 2})
+    ->Unit(benchmark::kMicrosecond);
+
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,173 @@
+// Copyright 2017 Wu Tao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the startup of a log after a crash, i.e LogManager::Recover over a wal
+// directory generated with the given size, segment size and entry size. The segments
+// are evicted from the page cache before every recovery, so that the disk reads are
+// measured as well. Peak RSS is reported as the counter peak_rss_mb.
+// Run with --benchmark_format=json for machine-readable results.
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+#include "base/logging.h"
+#include "base/testing.h"
+#include "wal/log_manager.h"
+
+#include <benchmark/benchmark.h>
+
+using namespace consensus;
+using namespace consensus::wal;
+
+static const char* kBenchDir = "/tmp/consensus-wal-recovery-bench";
+
+// Writes `totalBytes` of entries of `entrySize` bytes, in batches of 64.
+static void generateWal(const WriteAheadLogOptions& options, size_t totalBytes,
+                        size_t entrySize) {
+  yaraft::MemStoreUptr memstore;
+  LogManagerUPtr m;
+  FATAL_NOT_OK(LogManager::Recover(options, &memstore, &m), "LogManager::Recover");
+
+  std::string data(entrySize, 'a');
+  const size_t kBatchSize = 64;
+  uint64_t index = 1;
+  for (size_t written = 0; written < totalBytes; written += kBatchSize * entrySize) {
+    PBEntryVec batch;
+    for (size_t i = 0; i < kBatchSize; i++) {
+      batch.push_back(yaraft::PBEntry().Index(index++).Term(1).Data(data).v);
+    }
+    FATAL_NOT_OK(m->Write(batch, nullptr), "LogManager::Write");
+  }
+
+  yaraft::pb::HardState hs;
+  hs.set_term(1);
+  hs.set_vote(1);
+  hs.set_commit(index - 1);
+  FATAL_NOT_OK(m->Write(PBEntryVec(), &hs), "LogManager::Write");
+  FATAL_NOT_OK(m->Close(), "LogManager::Close");
+}
+
+// Evicts the files in `dir` from the page cache, as after a reboot.
+static void dropPageCache(const std::string& dir) {
+  std::vector<std::string> files;
+  FATAL_NOT_OK(Env::Default()->GetChildren(dir, &files), "Env::GetChildren");
+  for (const std::string& f : files) {
+    int fd = ::open((dir + "/" + f).c_str(), O_RDONLY);
+    if (fd < 0) {
+      continue;
+    }
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+  }
+}
+
+// Resets the peak RSS of this process, returns false if it's not supported.
+static bool resetPeakRSS() {
+  std::ofstream clearRefs("/proc/self/clear_refs");
+  clearRefs << "5";
+  return clearRefs.good();
+}
+
+// Peak RSS in KB since the last reset, or since the process started.
+static long peakRSS() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return std::strtol(line.c_str() + 6, nullptr, 10);
+    }
+  }
+  struct rusage usage;
+  ::getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Args: total size in MB, segment size in MB, entry size in bytes, verify checksum
+void WalRecoveryBench(benchmark::State& state) {
+  size_t totalBytes = state.range(0) << 20;
+  size_t entrySize = state.range(2);
+
+  TestDirectoryHelper dirHelper(kBenchDir);
+  WriteAheadLogOptions options;
+  options.log_dir = dirHelper.GetTestDir();
+  options.log_segment_size = state.range(1) << 20;
+  options.sync_policy = WriteAheadLogOptions::SYNC_NONE;
+  options.verify_checksum = state.range(3) != 0;
+  generateWal(options, totalBytes, entrySize);
+
+  std::vector<std::string> children;
+  FATAL_NOT_OK(Env::Default()->GetChildren(options.log_dir, &children), "Env::GetChildren");
+  size_t files = std::count_if(children.begin(), children.end(),
+                               [](const std::string& f) { return f[0] != '.'; });
+
+  bool rssReset = true;
+  long peak = 0;
+  size_t entries = 0;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    dropPageCache(options.log_dir);
+    rssReset = resetPeakRSS() && rssReset;
+    state.ResumeTiming();
+
+    yaraft::MemStoreUptr memstore;
+    LogManagerUPtr m;
+    FATAL_NOT_OK(LogManager::Recover(options, &memstore, &m), "LogManager::Recover");
+
+    state.PauseTiming();
+    peak = std::max(peak, peakRSS());
+    entries = memstore->LastIndex();
+    FATAL_NOT_OK(m->Close(), "LogManager::Close");
+    m.reset();
+    memstore.reset();
+    state.ResumeTiming();
+  }
+
+  state.SetBytesProcessed(state.iterations() * totalBytes);
+  state.SetItemsProcessed(state.iterations() * entries);
+  state.counters["files"] = files;
+  // without the reset, it's the peak of the whole process, including the generation.
+  state.counters["peak_rss_mb"] = peak / 1024.0;
+  state.counters["peak_rss_reset"] = rssReset;
+}
+
+static void recoveryArgs(benchmark::internal::Benchmark* b) {
+  for (int verify : {1, 0}) {
+    // the size of the log, with 64MB segments.
+    for (int totalMB : {64, 256, 1024}) {
+      b->Args({totalMB, 64, 1024, verify});
+    }
+    // the segment count for the same size.
+    for (int segmentMB : {4, 16}) {
+      b->Args({256, segmentMB, 1024, verify});
+    }
+    // the entry size for the same size.
+    for (int entrySize : {128, 16 * 1024}) {
+      b->Args({256, 64, entrySize, verify});
+    }
+  }
+}
+
+BENCHMARK(WalRecoveryBench)
+    ->ArgNames({"total_mb", "segment_mb", "entry_size", "verify"})
+    ->Apply(recoveryArgs)
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
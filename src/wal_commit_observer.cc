@@ -12,10 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <map>
-#include <set>
+#include <algorithm>
+#include <deque>
 
 #include "base/logging.h"
+#include "concurrentqueue/concurrentqueue.h"
 
 #include "wal_commit_observer.h"
 
@@ -23,45 +24,71 @@ namespace consensus {
 
 class WalCommitObserver::Impl {
  public:
-  void Register(std::pair<uint64_t, uint64_t> range, SimpleChannel<Status> *channel) {
-    std::lock_guard<std::mutex> g(mu_);
-
-    WalWritesMap::const_iterator it = writes_.find(range);
-    if (it != writes_.end()) {
-      FMT_LOG(ERROR,
-              "WalCommitObserver::Register: duplicate calls for a range of entries in [{}, {}]",
-              range.first, range.second);
-    } else {
-      writes_[range] = channel;
-    }
+  // Proposals arrive in increasing index order from the single executor thread, they are
+  // handed off to the flusher without taking a lock.
+  void Register(std::pair<uint64_t, uint64_t> range, uint64_t term, WriteCallback callback) {
+    registered_.enqueue(Waiter{range, term, std::move(callback)});
   }
 
-  void Notify(uint64_t commitIndex) {
-    std::lock_guard<std::mutex> g(mu_);
-
-    auto it = writes_.begin();
-    for (; it != writes_.end(); it++) {
-      if (commitIndex >= it->first.second) {
-        (*it->second) <<= Status::OK();
+  // Only the committed prefix of the waiters is visited, unless the term has changed.
+  void Notify(uint64_t commitIndex, uint64_t term) {
+    Waiter w;
+    while (registered_.try_dequeue(w)) {
+      // The entries of the trailing waiters have been overwritten after a leader change,
+      // they will never be committed.
+      while (!waiters_.empty() && w.range.first <= waiters_.back().range.second) {
+        waiters_.back().callback(
+            FMT_Status(IllegalState, "entries in [{}, {}] are overwritten by a new leader",
+                       waiters_.back().range.first, waiters_.back().range.second),
+            0);
+        waiters_.pop_back();
       }
-      writes_.erase(it);
+      waiters_.push_back(std::move(w));
+    }
+
+    // The waiters are in the order of their terms, as well as their indexes.
+    term_ = std::max(term_, term);
+    while (!waiters_.empty() && waiters_.front().term < term_) {
+      waiters_.front().callback(
+          FMT_Status(IllegalState,
+                     "entries in [{}, {}] of term {} may be overwritten by a new leader in term {}",
+                     waiters_.front().range.first, waiters_.front().range.second,
+                     waiters_.front().term, term_),
+          0);
+      waiters_.pop_front();
+    }
+
+    while (!waiters_.empty() && waiters_.front().range.second <= commitIndex) {
+      waiters_.front().callback(Status::OK(), waiters_.front().range.second);
+      waiters_.pop_front();
     }
   }
 
  private:
-  typedef std::map<std::pair<uint64_t, uint64_t>, SimpleChannel<Status> *> WalWritesMap;
-  WalWritesMap writes_;
+  struct Waiter {
+    std::pair<uint64_t, uint64_t> range;
+    // in which the entries are proposed.
+    uint64_t term;
+    WriteCallback callback;
+  };
+
+  // single-producer handoff from the executor thread.
+  moodycamel::ConcurrentQueue<Waiter> registered_;
+
+  // waiters sorted by the end index, only accessed by the flusher.
+  std::deque<Waiter> waiters_;
 
-  std::mutex mu_;
+  // the latest term persisted, only accessed by the flusher.
+  uint64_t term_{0};
 };
 
-void WalCommitObserver::Register(std::pair<uint64_t, uint64_t> range,
-                                 SimpleChannel<Status> *channel) {
-  impl_->Register(range, channel);
+void WalCommitObserver::Register(std::pair<uint64_t, uint64_t> range, uint64_t term,
+                                 WriteCallback callback) {
+  impl_->Register(range, term, std::move(callback));
 }
 
-void WalCommitObserver::Notify(uint64_t commitIndex) {
-  impl_->Notify(commitIndex);
+void WalCommitObserver::Notify(uint64_t commitIndex, uint64_t term) {
+  impl_->Notify(commitIndex, term);
 }
 
 WalCommitObserver::~WalCommitObserver() = default;
@@ -14,8 +14,8 @@
 
 #pragma once
 
-#include "base/simple_channel.h"
 #include "base/status.h"
+#include "replicated_log.h"
 
 #include <silly/disallow_copying.h>
 
@@ -26,6 +26,11 @@ namespace consensus {
 // will be informed, and all the registered listeners with ranges
 // covering the new committedIndex will be notified.
 //
+// A listener is registered with the term its entries are proposed in. The index
+// committed in that term is known to hold its entries, since no other leader
+// could have overwritten them. Once the term moves on, whether they survive the
+// new leader is unknown, the listeners of the earlier terms fail then.
+//
 // Thread-Safe
 class WalCommitObserver {
   __DISALLOW_COPYING__(WalCommitObserver);
@@ -33,11 +38,12 @@ class WalCommitObserver {
  public:
   WalCommitObserver();
 
-  // ONLY the wal write thread is allowed to call this function.
-  void Register(std::pair<uint64_t, uint64_t> range, SimpleChannel<Status> *channel);
+  // ONLY the raft executor thread is allowed to call this function.
+  void Register(std::pair<uint64_t, uint64_t> range, uint64_t term, WriteCallback callback);
 
+  // `term` is the persisted term of the node, 0 if it's unchanged.
   // ONLY the flusher thread is allowed to call this function.
-  void Notify(uint64_t commitIndex);
+  void Notify(uint64_t commitIndex, uint64_t term);
 
   ~WalCommitObserver();
 